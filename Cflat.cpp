@@ -28,23 +28,219 @@
 //
 ///////////////////////////////////////////////////////////////////////////////
 
+// The ucontext routines, which coroutines switch with, are only exposed by the XSI interface
+// on Apple platforms
+#if defined (__APPLE__) && !defined (_XOPEN_SOURCE)
+# define _XOPEN_SOURCE 600
+#endif
+
 #include "Cflat.h"
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 
+#if defined (_WIN32)
+# if !defined (NOMINMAX)
+#  define NOMINMAX
+# endif
+# if !defined (WIN32_LEAN_AND_MEAN)
+#  define WIN32_LEAN_AND_MEAN
+# endif
+# include <windows.h>
+#endif
+
+// Coroutines and resumable calls run on dedicated threads where the native stack cannot be
+// switched, or when 'CflatCoroutineThreads' gets defined
+#if !defined (CflatCoroutineThreads)
+# if defined (_WIN32)
+#  define CflatCoroutineFibers
+# elif (defined (__linux__) && !defined (__ANDROID__)) || defined (__APPLE__)
+#  include <ucontext.h>
+#  define CflatCoroutineUContext
+# else
+#  define CflatCoroutineThreads
+# endif
+#endif
+
+// Blocks are read past the ends of the scanned strings, which sanitizers report as errors
+#if defined (__SANITIZE_ADDRESS__) || defined (__SANITIZE_THREAD__)
+# define CflatDisableSIMD
+#elif defined (__has_feature)
+# if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer)
+#  define CflatDisableSIMD
+# endif
+#endif
+
+#if !defined (CflatDisableSIMD)
+# if defined (__AVX2__)
+#  include <immintrin.h>
+#  define CflatSIMDAVX2
+# elif defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define CflatSIMDSSE2
+# endif
+#endif
+#if defined (_MSC_VER)
+# include <intrin.h>
+#endif
+
+// Load stats of the program being parsed by the current thread, if any, in which the syntax
+// tree nodes get counted as they are created
+static thread_local Cflat::ProgramLoadStats* gLoadingProgramStats = nullptr;
+
+// Whether the current thread is processing queued calls, on which waiting for a future would
+// never return
+static thread_local bool gProcessingQueuedCalls = false;
+
 #include "Internal/CflatGlobalFunctions.inl"
 #include "Internal/CflatExpressions.inl"
 #include "Internal/CflatStatements.inl"
 #include "Internal/CflatErrorMessages.inl"
 
+#if defined (CflatDisableExecutionCounters)
+# define CflatCountExecution(pContext, pCounter)
+#else
+# define CflatCountExecution(pContext, pCounter)  (pContext).mCounters.pCounter++
+#endif
+
 
 //
 //  Memory
 //
 using namespace Cflat;
 
+// Prepended to every block, so that it gets released through the allocator it was obtained from
+// and accounted in its stats, which the allocator must outlive
+struct AllocationHeader
+{
+   const Memory::Allocator* mAllocator;
+   uint64_t mSize : 56;
+   uint64_t mCategory : 8;
+};
+
+// Keeps the addresses returned by 'Memory::allocate' aligned as the ones returned by 'malloc'
+static const size_t kAllocationHeaderSize = 16u;
+static_assert(sizeof(AllocationHeader) <= kAllocationHeaderSize, "Allocation header too big");
+
+static thread_local const Memory::Allocator* gCurrentAllocator = nullptr;
+static thread_local Memory::Category gCurrentCategory = Memory::Category::General;
+
+// Reason of the allocations made on the current thread, reported by the allocation tracking
+static thread_local Environment::AllocationReason gAllocationReason =
+   Environment::AllocationReason::Other;
+
+struct AllocationReasonScope
+{
+   Environment::AllocationReason mPreviousReason;
+
+   AllocationReasonScope(Environment::AllocationReason pReason)
+      : mPreviousReason(gAllocationReason)
+   {
+      gAllocationReason = pReason;
+   }
+   ~AllocationReasonScope()
+   {
+      gAllocationReason = mPreviousReason;
+   }
+};
+
+static void* defaultAllocatorMalloc(void*, size_t pSize)
+{
+   return Memory::malloc()(pSize);
+}
+static void defaultAllocatorFree(void*, void* pPtr)
+{
+   Memory::free()(pPtr);
+}
+
 Memory::mallocFunction Memory::smmalloc = ::malloc;
 Memory::freeFunction Memory::smfree = ::free;
 
+Memory::Allocator Memory::smDefaultAllocator(defaultAllocatorMalloc, defaultAllocatorFree, nullptr);
+
+Memory::Usage::Usage()
+   : mBytes(0u)
+   , mAllocations(0u)
+{
+}
+
+Memory::Stats::Stats()
+   : mPeakBytes(0u)
+{
+}
+
+Memory::AtomicUsage::AtomicUsage()
+   : mBytes(0u)
+   , mAllocations(0u)
+{
+}
+
+Memory::Usage Memory::AtomicUsage::load() const
+{
+   Usage usage;
+   usage.mBytes = mBytes.load(std::memory_order_relaxed);
+   usage.mAllocations = mAllocations.load(std::memory_order_relaxed);
+   return usage;
+}
+
+Memory::StatsCounters::StatsCounters()
+   : mPeakBytes(0u)
+{
+}
+
+void Memory::StatsCounters::getStats(Stats* pOutStats) const
+{
+   for(size_t i = 0u; i < (size_t)Category::Count; i++)
+   {
+      pOutStats->mCategories[i] = mCategories[i].load();
+   }
+
+   pOutStats->mTotal = mTotal.load();
+   pOutStats->mPeakBytes = mPeakBytes.load(std::memory_order_relaxed);
+   pOutStats->mAccumulated = mAccumulated.load();
+}
+
+Memory::Allocator::Allocator()
+   : mMalloc(defaultAllocatorMalloc)
+   , mFree(defaultAllocatorFree)
+   , mUserData(nullptr)
+   , mStats(nullptr)
+   , mHook(nullptr)
+   , mHookData(nullptr)
+{
+}
+
+Memory::Allocator::Allocator(mallocFunction pMalloc, freeFunction pFree, void* pUserData,
+   StatsCounters* pStats)
+   : mMalloc(pMalloc)
+   , mFree(pFree)
+   , mUserData(pUserData)
+   , mStats(pStats)
+   , mHook(nullptr)
+   , mHookData(nullptr)
+{
+}
+
+Memory::AllocatorScope::AllocatorScope(const Allocator* pAllocator)
+   : mPreviousAllocator(setCurrentAllocator(pAllocator))
+{
+}
+
+Memory::AllocatorScope::~AllocatorScope()
+{
+   setCurrentAllocator(mPreviousAllocator);
+}
+
+Memory::CategoryScope::CategoryScope(Category pCategory)
+   : mPreviousCategory(setCurrentCategory(pCategory))
+{
+}
+
+Memory::CategoryScope::~CategoryScope()
+{
+   setCurrentCategory(mPreviousCategory);
+}
+
 void Memory::setFunctions(Memory::mallocFunction pmalloc, Memory::freeFunction pfree)
 {
    smmalloc = pmalloc;
@@ -66,11 +262,120 @@ Memory::freeFunction Memory::free()
    return smfree;
 }
 
+const Memory::Allocator* Memory::getDefaultAllocator()
+{
+   return &smDefaultAllocator;
+}
+
+const Memory::Allocator* Memory::getCurrentAllocator()
+{
+   return gCurrentAllocator ? gCurrentAllocator : &smDefaultAllocator;
+}
+
+const Memory::Allocator* Memory::setCurrentAllocator(const Allocator* pAllocator)
+{
+   const Allocator* previousAllocator = gCurrentAllocator;
+   gCurrentAllocator = pAllocator;
+   return previousAllocator;
+}
+
+Memory::Category Memory::getCurrentCategory()
+{
+   return gCurrentCategory;
+}
+
+Memory::Category Memory::setCurrentCategory(Category pCategory)
+{
+   const Category previousCategory = gCurrentCategory;
+   gCurrentCategory = pCategory;
+   return previousCategory;
+}
+
+void* Memory::allocate(size_t pSize)
+{
+   const Allocator* allocator = getCurrentAllocator();
+   char* block = (char*)allocator->mMalloc(allocator->mUserData, pSize + kAllocationHeaderSize);
+
+   if(!block)
+   {
+      return nullptr;
+   }
+
+   // the header travels with the block, so that it can be released through the allocator
+   // it was obtained from, no matter which one is the current allocator at that point
+   AllocationHeader* header = reinterpret_cast<AllocationHeader*>(block);
+   header->mAllocator = allocator;
+   header->mSize = pSize;
+   header->mCategory = (uint64_t)gCurrentCategory;
+
+   StatsCounters* stats = allocator->mStats;
+
+   if(stats)
+   {
+      // the counters are shared by all the threads allocating through the allocator
+      AtomicUsage& categoryUsage = stats->mCategories[(size_t)gCurrentCategory];
+      categoryUsage.mBytes.fetch_add(pSize, std::memory_order_relaxed);
+      categoryUsage.mAllocations.fetch_add(1u, std::memory_order_relaxed);
+
+      AtomicUsage& totalUsage = stats->mTotal;
+      const size_t totalBytes = totalUsage.mBytes.fetch_add(pSize, std::memory_order_relaxed) + pSize;
+      totalUsage.mAllocations.fetch_add(1u, std::memory_order_relaxed);
+
+      size_t peakBytes = stats->mPeakBytes.load(std::memory_order_relaxed);
+
+      while(totalBytes > peakBytes &&
+         !stats->mPeakBytes.compare_exchange_weak(peakBytes, totalBytes, std::memory_order_relaxed))
+      {
+      }
+
+      stats->mAccumulated.mBytes.fetch_add(pSize, std::memory_order_relaxed);
+      stats->mAccumulated.mAllocations.fetch_add(1u, std::memory_order_relaxed);
+   }
+
+   if(allocator->mHook)
+   {
+      allocator->mHook(allocator->mHookData, pSize);
+   }
+
+   return block + kAllocationHeaderSize;
+}
+
+void Memory::deallocate(void* pPtr)
+{
+   if(!pPtr)
+   {
+      return;
+   }
+
+   char* block = (char*)pPtr - kAllocationHeaderSize;
+   const AllocationHeader* header = reinterpret_cast<const AllocationHeader*>(block);
+   const Allocator* allocator = header->mAllocator;
+   StatsCounters* stats = allocator->mStats;
+
+   if(stats)
+   {
+      const size_t size = (size_t)header->mSize;
+
+      AtomicUsage& categoryUsage = stats->mCategories[(size_t)header->mCategory];
+      categoryUsage.mBytes.fetch_sub(size, std::memory_order_relaxed);
+      categoryUsage.mAllocations.fetch_sub(1u, std::memory_order_relaxed);
+
+      AtomicUsage& totalUsage = stats->mTotal;
+      totalUsage.mBytes.fetch_sub(size, std::memory_order_relaxed);
+      totalUsage.mAllocations.fetch_sub(1u, std::memory_order_relaxed);
+   }
+
+   allocator->mFree(allocator->mUserData, block);
+}
+
 
 //
 //  Identifier
 //
-Identifier::NamesRegistry* Identifier::smNames = nullptr;
+std::atomic<Identifier::NamesRegistry*> Identifier::smNames(nullptr);
+
+// Identifiers can be created from any thread
+static std::mutex gNamesRegistryMutex;
 
 Identifier::Identifier()
    : mName(getNamesRegistry()->mMemory)
@@ -81,29 +386,47 @@ Identifier::Identifier()
 
 Identifier::Identifier(const char* pName)
 {
+   // the names registry is shared by all environments
+   Memory::AllocatorScope allocatorScope(Memory::getDefaultAllocator());
+
    mHash = pName[0] != '\0' ? hash(pName) : 0u;
-   mName = getNamesRegistry()->registerString(mHash, pName);
+
+   NamesRegistry* namesRegistry = getNamesRegistry();
+   std::lock_guard<std::mutex> lock(gNamesRegistryMutex);
+   mName = namesRegistry->registerString(mHash, pName);
    mNameLength = (uint32_t)strlen(mName);
 }
 
 Identifier::NamesRegistry* Identifier::getNamesRegistry()
 {
-   if(!smNames)
+   NamesRegistry* namesRegistry = smNames.load(std::memory_order_acquire);
+
+   if(!namesRegistry)
    {
-      smNames = (NamesRegistry*)CflatMalloc(sizeof(NamesRegistry));
-      CflatInvokeCtor(NamesRegistry, smNames);
+      std::lock_guard<std::mutex> lock(gNamesRegistryMutex);
+      namesRegistry = smNames.load(std::memory_order_relaxed);
+
+      if(!namesRegistry)
+      {
+         Memory::AllocatorScope allocatorScope(Memory::getDefaultAllocator());
+         namesRegistry = (NamesRegistry*)CflatMalloc(sizeof(NamesRegistry));
+         CflatInvokeCtor(NamesRegistry, namesRegistry);
+         smNames.store(namesRegistry, std::memory_order_release);
+      }
    }
 
-   return smNames;
+   return namesRegistry;
 }
 
 void Identifier::releaseNamesRegistry()
 {
-   if(smNames)
+   std::lock_guard<std::mutex> lock(gNamesRegistryMutex);
+   NamesRegistry* namesRegistry = smNames.exchange(nullptr, std::memory_order_acq_rel);
+
+   if(namesRegistry)
    {
-      CflatInvokeDtor(NamesRegistry, smNames);
-      CflatFree(smNames);
-      smNames = nullptr;
+      CflatInvokeDtor(NamesRegistry, namesRegistry);
+      CflatFree(namesRegistry);
    }
 }
 
@@ -435,6 +758,7 @@ void Value::initOnHeap(const TypeUsage& pTypeUsage)
 
    if(allocationRequired)
    {
+      AllocationReasonScope reasonScope(Environment::AllocationReason::HeapValue);
       mValueBuffer = (char*)CflatMalloc(pTypeUsage.getSize());
    }
 }
@@ -487,11 +811,17 @@ Value& Value::operator=(const Value& pOther)
          break;
       case ValueBufferType::Stack:
          CflatAssert(mTypeUsage.compatibleWith(pOther.mTypeUsage));
-         memcpy(mValueBuffer, pOther.mValueBuffer, mTypeUsage.getSize());
+         if(pOther.mValueBuffer)
+         {
+            memcpy(mValueBuffer, pOther.mValueBuffer, mTypeUsage.getSize());
+         }
          break;
       case ValueBufferType::Heap:
          initOnHeap(pOther.mTypeUsage);
-         memcpy(mValueBuffer, pOther.mValueBuffer, mTypeUsage.getSize());
+         if(pOther.mValueBuffer)
+         {
+            memcpy(mValueBuffer, pOther.mValueBuffer, mTypeUsage.getSize());
+         }
          break;
       }
    }
@@ -647,6 +977,16 @@ void TypesHolder::getAllTypes(CflatSTLVector(Type*)* pOutTypes) const
    }
 }
 
+void TypesHolder::getAllTypeAliases(CflatSTLVector(const TypeAlias*)* pOutTypeAliases) const
+{
+   pOutTypeAliases->reserve(pOutTypeAliases->size() + mTypeAliases.size());
+
+   for(TypeAliasesRegistry::const_iterator it = mTypeAliases.begin(); it != mTypeAliases.end(); it++)
+   {
+      pOutTypeAliases->push_back(&it->second);
+   }
+}
+
 
 //
 //  FunctionsHolder
@@ -744,6 +1084,8 @@ size_t FunctionsHolder::getFunctionsCount() const
 
 Function* FunctionsHolder::registerFunction(const Identifier& pIdentifier)
 {
+   Memory::CategoryScope categoryScope(Memory::Category::Function);
+
    Function* function = (Function*)CflatMalloc(sizeof(Function));
    CflatInvokeCtor(Function, function)(pIdentifier);
    FunctionsRegistry::iterator it = mFunctions.find(pIdentifier.mHash);
@@ -902,13 +1244,49 @@ bool FunctionsHolder::deregisterFunctions(const Identifier& pIdentifier)
 //
 //  InstancesHolder
 //
-InstancesHolder::InstancesHolder()
+InstancesHolder::InstancesHolder(EnvironmentStack* pStack)
+   : mInstancesCount(0u)
+   , mStack(pStack)
 {
 }
 
 InstancesHolder::~InstancesHolder()
 {
    releaseInstances(0u, true);
+
+   for(size_t i = 0u; i < mInstanceChunks.size(); i++)
+   {
+      CflatFree(mInstanceChunks[i]);
+   }
+}
+
+Instance* InstancesHolder::getInstance(uint32_t pIndex) const
+{
+   return mInstanceChunks[pIndex / kInstancesChunkSize] + (pIndex % kInstancesChunkSize);
+}
+
+void InstancesHolder::initOnStack(Instance* pInstance)
+{
+   CflatAssert(mStack);
+   CflatAssert(!mScopeMarks.empty());
+
+   pInstance->mValue.initOnStack(pInstance->mTypeUsage, mStack);
+
+   ScopeMark& scopeMark = mScopeMarks.back();
+
+   if(!scopeMark.mStackPointer)
+   {
+      scopeMark.mStackPointer = pInstance->mValue.mValueBuffer - pInstance->mValue.mStackPadding;
+   }
+}
+
+void InstancesHolder::swapInstances(InstancesHolder* pOther)
+{
+   mInstanceChunks.swap(pOther->mInstanceChunks);
+
+   const uint32_t instancesCount = mInstancesCount;
+   mInstancesCount = pOther->mInstancesCount;
+   pOther->mInstancesCount = instancesCount;
 }
 
 Instance* InstancesHolder::setVariable(const TypeUsage& pTypeUsage, const Identifier& pIdentifier,
@@ -932,21 +1310,53 @@ Value* InstancesHolder::getVariable(const Identifier& pIdentifier) const
    return instance ? &instance->mValue : nullptr;
 }
 
-Instance* InstancesHolder::registerInstance(const TypeUsage& pTypeUsage, const Identifier& pIdentifier)
+Instance* InstancesHolder::registerInstance(const TypeUsage& pTypeUsage, const Identifier& pIdentifier,
+   uint32_t pScopeLevel, bool pOwnsValue)
 {
-   mInstances.emplace_back(pTypeUsage, pIdentifier);
-   return &mInstances.back();
+   if(mScopeMarks.empty() || mScopeMarks.back().mScopeLevel != pScopeLevel)
+   {
+      ScopeMark scopeMark;
+      scopeMark.mScopeLevel = pScopeLevel;
+      scopeMark.mFirstInstanceIndex = mInstancesCount;
+      scopeMark.mFirstDestructibleInstanceIndex = (uint32_t)mDestructibleInstances.size();
+      scopeMark.mStackPointer = nullptr;
+      mScopeMarks.push_back(scopeMark);
+   }
+
+   if(pOwnsValue &&
+      pTypeUsage.mType &&
+      pTypeUsage.mType->mCategory == TypeCategory::StructOrClass &&
+      !pTypeUsage.isPointer() &&
+      !pTypeUsage.isReference() &&
+      static_cast<Struct*>(pTypeUsage.mType)->getDestructor())
+   {
+      mDestructibleInstances.push_back(mInstancesCount);
+   }
+
+   if(mInstancesCount == (uint32_t)mInstanceChunks.size() * kInstancesChunkSize)
+   {
+      Instance* instanceChunk = (Instance*)CflatMalloc(sizeof(Instance) * kInstancesChunkSize);
+      mInstanceChunks.push_back(instanceChunk);
+   }
+
+   Instance* instance = getInstance(mInstancesCount++);
+   CflatInvokeCtor(Instance, instance)(pTypeUsage, pIdentifier);
+   instance->mScopeLevel = pScopeLevel;
+
+   return instance;
 }
 
 Instance* InstancesHolder::retrieveInstance(const Identifier& pIdentifier) const
 {
    Instance* instance = nullptr;
 
-   for(int i = (int)mInstances.size() - 1; i >= 0; i--)
+   for(uint32_t i = mInstancesCount; i > 0u; i--)
    {
-      if(mInstances[i].mIdentifier == pIdentifier)
+      Instance* candidate = getInstance(i - 1u);
+
+      if(candidate->mIdentifier == pIdentifier)
       {
-         instance = const_cast<Instance*>(&mInstances[i]);
+         instance = candidate;
          break;
       }
    }
@@ -958,11 +1368,13 @@ Instance* InstancesHolder::retrieveInstance(const Identifier& pIdentifier, uint3
 {
    Instance* instance = nullptr;
 
-   for(int i = (int)mInstances.size() - 1; i >= 0; i--)
+   for(uint32_t i = mInstancesCount; i > 0u; i--)
    {
-      if(mInstances[i].mIdentifier == pIdentifier && mInstances[i].mScopeLevel == pScopeLevel)
+      Instance* candidate = getInstance(i - 1u);
+
+      if(candidate->mIdentifier == pIdentifier && candidate->mScopeLevel == pScopeLevel)
       {
-         instance = const_cast<Instance*>(&mInstances[i]);
+         instance = candidate;
          break;
       }
    }
@@ -972,47 +1384,80 @@ Instance* InstancesHolder::retrieveInstance(const Identifier& pIdentifier, uint3
 
 void InstancesHolder::releaseInstances(uint32_t pScopeLevel, bool pExecuteDestructors)
 {
-   while(!mInstances.empty() && mInstances.back().mScopeLevel >= pScopeLevel)
+   if(mScopeMarks.empty() || mScopeMarks.back().mScopeLevel < pScopeLevel)
+   {
+      return;
+   }
+
+   uint32_t firstInstanceIndex = 0u;
+   uint32_t firstDestructibleInstanceIndex = 0u;
+   char* stackPointer = nullptr;
+
+   while(!mScopeMarks.empty() && mScopeMarks.back().mScopeLevel >= pScopeLevel)
    {
-      if(pExecuteDestructors)
+      const ScopeMark& scopeMark = mScopeMarks.back();
+      firstInstanceIndex = scopeMark.mFirstInstanceIndex;
+      firstDestructibleInstanceIndex = scopeMark.mFirstDestructibleInstanceIndex;
+
+      if(scopeMark.mStackPointer)
       {
-         Instance& instance = mInstances.back();
-         Type* instanceType = instance.mTypeUsage.mType;
+         stackPointer = scopeMark.mStackPointer;
+      }
 
-         if(instanceType->mCategory == TypeCategory::StructOrClass &&
-            !instance.mTypeUsage.isPointer() &&
-            !instance.mTypeUsage.isReference())
-         {  
-            Struct* structOrClassType = static_cast<Struct*>(instanceType);
-            Method* dtor = structOrClassType->getDestructor();
+      mScopeMarks.pop_back();
+   }
 
-            if(dtor)
-            {
-               TypeUsage thisPtrTypeUsage;
-               thisPtrTypeUsage.mType = instanceType;
-               thisPtrTypeUsage.mPointerLevel = 1u;
+   if(pExecuteDestructors)
+   {
+      for(size_t i = mDestructibleInstances.size(); i > firstDestructibleInstanceIndex; i--)
+      {
+         Instance& instance = *getInstance(mDestructibleInstances[i - 1u]);
+         Type* instanceType = instance.mTypeUsage.mType;
+         Method* dtor = static_cast<Struct*>(instanceType)->getDestructor();
 
-               Value thisPtrValue;
-               thisPtrValue.initExternal(thisPtrTypeUsage);
-               thisPtrValue.set(&instance.mValue.mValueBuffer);
+         TypeUsage thisPtrTypeUsage;
+         thisPtrTypeUsage.mType = instanceType;
+         thisPtrTypeUsage.mPointerLevel = 1u;
 
-               CflatArgsVector(Value) args;
-               dtor->execute(thisPtrValue, args, nullptr);
-            }
-         }
+         Value thisPtrValue;
+         thisPtrValue.initExternal(thisPtrTypeUsage);
+         thisPtrValue.set(&instance.mValue.mValueBuffer);
+
+         CflatArgsVector(Value) args;
+         dtor->execute(thisPtrValue, args, nullptr);
       }
+   }
+
+   mDestructibleInstances.resize(firstDestructibleInstanceIndex);
 
-      mInstances.pop_back();
+   if(mStack)
+   {
+      // the values of the instances are either external or on the stack, above the ones from
+      // the outer scopes, so the whole run is released by truncating the stack in one step
+      if(stackPointer)
+      {
+         CflatAssert(stackPointer <= mStack->mPointer);
+         mStack->mPointer = stackPointer;
+      }
+   }
+   else
+   {
+      for(uint32_t i = mInstancesCount; i > firstInstanceIndex; i--)
+      {
+         CflatInvokeDtor(Instance, getInstance(i - 1u));
+      }
    }
+
+   mInstancesCount = firstInstanceIndex;
 }
 
 void InstancesHolder::getAllInstances(CflatSTLVector(Instance*)* pOutInstances) const
 {
-   pOutInstances->reserve(pOutInstances->size() + mInstances.size());
+   pOutInstances->reserve(pOutInstances->size() + mInstancesCount);
 
-   for(size_t i = 0u; i < mInstances.size(); i++)
+   for(uint32_t i = 0u; i < mInstancesCount; i++)
    {
-      pOutInstances->push_back(const_cast<Instance*>(&mInstances[i]));
+      pOutInstances->push_back(getInstance(i));
    }
 }
 
@@ -1050,11 +1495,14 @@ EnumClass::EnumClass(Namespace* pNamespace, const Identifier& pIdentifier)
 //
 //  Struct
 //
+std::atomic<uint32_t> Struct::smConstructionPlansGeneration(1u);
+
 Struct::Struct(Namespace* pNamespace, const Identifier& pIdentifier)
    : Type(pNamespace, pIdentifier)
    , mCachedMethodIndexDefaultConstructor(kInvalidCachedMethodIndex)
    , mCachedMethodIndexCopyConstructor(kInvalidCachedMethodIndex)
    , mCachedMethodIndexDestructor(kInvalidCachedMethodIndex)
+   , mConstructionPlanGeneration(0u)
 {
    mCategory = TypeCategory::StructOrClass;
 }
@@ -1177,9 +1625,13 @@ Field* Struct::requestField(const Identifier& pIdentifier)
 
    if(!member)
    {
+      Memory::CategoryScope categoryScope(Memory::Category::Type);
+
       member = (Member*)CflatMalloc(sizeof(Field));
       CflatInvokeCtor(Field, member)(pIdentifier);
       mMembers.push_back(member);
+
+      invalidateConstructionPlans();
    }
 
    return member && member->mMemberType == MemberType::Field
@@ -1193,9 +1645,13 @@ BitField* Struct::requestBitField(const Identifier& pIdentifier)
 
    if(!member)
    {
+      Memory::CategoryScope categoryScope(Memory::Category::Type);
+
       member = (Member*)CflatMalloc(sizeof(BitField));
       CflatInvokeCtor(BitField, member)(pIdentifier);
       mMembers.push_back(member);
+
+      invalidateConstructionPlans();
    }
 
    return member && member->mMemberType == MemberType::BitField
@@ -1272,6 +1728,79 @@ Method* Struct::getDefaultConstructor() const
    return nullptr;
 }
 
+const CflatSTLVector(Struct::ConstructionStep)& Struct::getConstructionPlan()
+{
+   const uint32_t plansGeneration = smConstructionPlansGeneration.load(std::memory_order_acquire);
+
+   if(mConstructionPlanGeneration.load(std::memory_order_acquire) != plansGeneration)
+   {
+      // the plan might be requested from several parallel workers at the same time
+      static std::mutex constructionPlanMutex;
+      std::lock_guard<std::mutex> lock(constructionPlanMutex);
+
+      if(mConstructionPlanGeneration.load(std::memory_order_relaxed) != plansGeneration)
+      {
+         mConstructionPlan.clear();
+         appendConstructionSteps(0u, &mConstructionPlan);
+         mConstructionPlanGeneration.store(plansGeneration, std::memory_order_release);
+      }
+   }
+
+   return mConstructionPlan;
+}
+
+void Struct::invalidateConstructionPlans()
+{
+   smConstructionPlansGeneration.fetch_add(1u, std::memory_order_acq_rel);
+}
+
+void Struct::appendConstructionSteps(size_t pOffset, CflatSTLVector(ConstructionStep)* pOutSteps)
+{
+   if(getDefaultConstructor())
+   {
+      ConstructionStep step;
+      step.mType = this;
+      step.mOffset = pOffset;
+      pOutSteps->push_back(step);
+      return;
+   }
+
+   for(size_t i = 0u; i < mBaseTypes.size(); i++)
+   {
+      if(mBaseTypes[i].mType->mCategory == TypeCategory::StructOrClass)
+      {
+         Struct* baseType = static_cast<Struct*>(mBaseTypes[i].mType);
+         baseType->appendConstructionSteps(pOffset + mBaseTypes[i].mOffset, pOutSteps);
+      }
+   }
+
+   for(size_t i = 0u; i < mMembers.size(); i++)
+   {
+      Member* member = mMembers[i];
+
+      const bool isMemberStructOrClassInstance =
+         member->mMemberType == MemberType::Field &&
+         member->mTypeUsage.mType &&
+         member->mTypeUsage.mType->mCategory == TypeCategory::StructOrClass &&
+         !member->mTypeUsage.isPointer() &&
+         !member->mTypeUsage.isReference();
+
+      if(!isMemberStructOrClassInstance)
+      {
+         continue;
+      }
+
+      Struct* memberType = static_cast<Struct*>(member->mTypeUsage.mType);
+      const size_t memberOffset = pOffset + static_cast<Field*>(member)->mOffset;
+      const size_t elementsCount = member->mTypeUsage.isArray() ? member->mTypeUsage.mArraySize : 1u;
+
+      for(size_t j = 0u; j < elementsCount; j++)
+      {
+         memberType->appendConstructionSteps(memberOffset + j * memberType->mSize, pOutSteps);
+      }
+   }
+}
+
 Method* Struct::getCopyConstructor() const
 {
    if(mCachedMethodIndexCopyConstructor != kInvalidCachedMethodIndex)
@@ -1484,6 +2013,9 @@ void TypeHelper::registerCustomPerfectMatch(Type* pTypeA, Type* pTypeB)
 {
    CflatAssert(pTypeA && pTypeB);
 
+   // the custom perfect matches registry is shared by all environments
+   Memory::AllocatorScope allocatorScope(Memory::getDefaultAllocator());
+
    CustomPerfectMatchesRegistry::iterator it =
       smCustomPerfectMatchesRegistry.find(pTypeA->mIdentifier.mHash);
 
@@ -1762,233 +2294,440 @@ const char* kCflatKeywords[] =
 };
 const size_t kCflatKeywordsCount = sizeof(kCflatKeywords) / sizeof(const char*);
 
-void Tokenizer::tokenize(const char* pCode, CflatSTLVector(Token)& pTokens)
+//
+//  Scanning helpers for the tokenizer. Spans of characters are scanned in blocks when SIMD
+//  is available; blocks are aligned, so that reading them never crosses a page boundary,
+//  and the null terminator always ends a span
+//
+enum CharacterClass : uint8_t
 {
-   char* cursor = const_cast<char*>(pCode);
-   uint16_t currentLine = 1u;
+   kCharacterClassWhitespace = 1 << 0,
+   kCharacterClassIdentifier = 1 << 1,
+   kCharacterClassIdentifierBeginning = 1 << 2,
+   kCharacterClassNumber = 1 << 3,
+   kCharacterClassHexDigit = 1 << 4
+};
 
-   pTokens.clear();
+struct CharacterClassTable
+{
+   uint8_t mClasses[256];
 
-   while(*cursor != '\0')
+   CharacterClassTable()
    {
-      while(*cursor == ' ' || *cursor == '\t' || *cursor == '\n')
-      {
-         if(*cursor == '\n')
-         {
-            currentLine++;
-         }
+      memset(mClasses, 0, sizeof(mClasses));
 
-         cursor++;
-      }
+      mClasses[(uint8_t)' '] = kCharacterClassWhitespace;
+      mClasses[(uint8_t)'\t'] = kCharacterClassWhitespace;
+      mClasses[(uint8_t)'\n'] = kCharacterClassWhitespace;
+      mClasses[(uint8_t)'\r'] = kCharacterClassWhitespace;
 
-      if(*cursor == '\0')
+      for(int c = 'a'; c <= 'z'; c++)
       {
-         break;
+         mClasses[c] |= kCharacterClassIdentifier | kCharacterClassIdentifierBeginning;
+         mClasses[c - 'a' + 'A'] |= kCharacterClassIdentifier | kCharacterClassIdentifierBeginning;
       }
 
-      Token token;
-      token.mStart = cursor;
-      token.mLength = 1u;
-      token.mLine = currentLine;
+      mClasses[(uint8_t)'_'] |= kCharacterClassIdentifier | kCharacterClassIdentifierBeginning;
 
-      // string
-      if(*cursor == '"' || (*cursor == 'L' && *(cursor + 1) == '"'))
+      for(int c = '0'; c <= '9'; c++)
       {
-         const bool wide = *cursor == 'L';
+         mClasses[c] |= kCharacterClassIdentifier | kCharacterClassNumber | kCharacterClassHexDigit;
+      }
 
-         if(wide)
-         {
-            cursor++;
-         }
+      for(int c = 'a'; c <= 'f'; c++)
+      {
+         mClasses[c] |= kCharacterClassHexDigit;
+         mClasses[c - 'a' + 'A'] |= kCharacterClassHexDigit;
+      }
 
-         do
-         {
-            cursor++;
+      mClasses[(uint8_t)'.'] |= kCharacterClassNumber;
+      mClasses[(uint8_t)'f'] |= kCharacterClassNumber;
+      mClasses[(uint8_t)'u'] |= kCharacterClassNumber;
+      mClasses[(uint8_t)'e'] |= kCharacterClassNumber;
+      mClasses[(uint8_t)'-'] |= kCharacterClassNumber;
+   }
+};
+static const CharacterClassTable kCharacterClassTable;
 
-            if(*cursor == '\n')
-            {
-               break;
-            }
-         }
-         while(!(*cursor == '"' && *(cursor - 1) != '\\'));
+static inline bool hasCharacterClass(char pCharacter, uint8_t pClass)
+{
+   return (kCharacterClassTable.mClasses[(uint8_t)pCharacter] & pClass) != 0u;
+}
 
-         cursor++;
-         token.mLength = cursor - token.mStart;
-         token.mType = wide ? TokenType::WideString : TokenType::String;
-         pTokens.push_back(token);
-         continue;
-      }
+#if defined (CflatSIMDAVX2) || defined (CflatSIMDSSE2)
+static inline uint32_t countTrailingZeros(uint32_t pMask)
+{
+# if defined (_MSC_VER)
+   unsigned long index;
+   _BitScanForward(&index, pMask);
+   return (uint32_t)index;
+# else
+   return (uint32_t)__builtin_ctz(pMask);
+# endif
+}
+#endif
 
-      // character
-      if(*cursor == '\'' || (*cursor == 'L' && *(cursor + 1) == '\''))
-      {
-         const bool wide = *cursor == 'L';
+#if defined (CflatSIMDAVX2)
+typedef __m256i SIMDBlock;
+static const size_t kSIMDBlockSize = 32u;
+static const uint32_t kSIMDBlockMask = 0xffffffffu;
 
-         if(wide)
-         {
-            cursor++;
-         }
+static inline SIMDBlock loadBlock(const char* pBlock) { return _mm256_load_si256((const __m256i*)pBlock); }
+static inline SIMDBlock splat(char pCharacter) { return _mm256_set1_epi8(pCharacter); }
+static inline SIMDBlock equal(SIMDBlock pA, SIMDBlock pB) { return _mm256_cmpeq_epi8(pA, pB); }
+static inline SIMDBlock greater(SIMDBlock pA, SIMDBlock pB) { return _mm256_cmpgt_epi8(pA, pB); }
+static inline SIMDBlock bitOr(SIMDBlock pA, SIMDBlock pB) { return _mm256_or_si256(pA, pB); }
+static inline SIMDBlock bitAnd(SIMDBlock pA, SIMDBlock pB) { return _mm256_and_si256(pA, pB); }
+static inline uint32_t moveMask(SIMDBlock pBlock) { return (uint32_t)_mm256_movemask_epi8(pBlock); }
+#elif defined (CflatSIMDSSE2)
+typedef __m128i SIMDBlock;
+static const size_t kSIMDBlockSize = 16u;
+static const uint32_t kSIMDBlockMask = 0xffffu;
 
-         do
-         {
-            cursor++;
+static inline SIMDBlock loadBlock(const char* pBlock) { return _mm_load_si128((const __m128i*)pBlock); }
+static inline SIMDBlock splat(char pCharacter) { return _mm_set1_epi8(pCharacter); }
+static inline SIMDBlock equal(SIMDBlock pA, SIMDBlock pB) { return _mm_cmpeq_epi8(pA, pB); }
+static inline SIMDBlock greater(SIMDBlock pA, SIMDBlock pB) { return _mm_cmpgt_epi8(pA, pB); }
+static inline SIMDBlock bitOr(SIMDBlock pA, SIMDBlock pB) { return _mm_or_si128(pA, pB); }
+static inline SIMDBlock bitAnd(SIMDBlock pA, SIMDBlock pB) { return _mm_and_si128(pA, pB); }
+static inline uint32_t moveMask(SIMDBlock pBlock) { return (uint32_t)_mm_movemask_epi8(pBlock); }
+#endif
 
-            if(*cursor == '\n')
-            {
-               break;
-            }
-         }
-         while(!(*cursor == '\'' && *(cursor - 1) != '\\'));
+#if defined (CflatSIMDAVX2) || defined (CflatSIMDSSE2)
+static inline SIMDBlock inRange(SIMDBlock pBlock, char pFirst, char pLast)
+{
+   // bytes are compared as signed values, so that non-ASCII characters never match
+   return bitAnd(greater(pBlock, splat(pFirst - 1)), greater(splat(pLast + 1), pBlock));
+}
 
-         cursor++;
-         token.mLength = cursor - token.mStart;
-         token.mType = wide ? TokenType::WideCharacter : TokenType::Character;
-         pTokens.push_back(token);
-         continue;
+// Returns the first character, starting at the given one, for which the block predicate
+// (which returns a bit mask of the characters to skip) does not hold
+template<typename BlockPredicate>
+static inline const char* skipCharacters(const char* pCursor, BlockPredicate pPredicate)
+{
+   const size_t misalignment = (size_t)((uintptr_t)pCursor & (kSIMDBlockSize - 1u));
+   const char* block = pCursor - misalignment;
+   uint32_t stopMask = ~pPredicate(loadBlock(block)) & ((kSIMDBlockMask << misalignment) & kSIMDBlockMask);
+
+   while(stopMask == 0u)
+   {
+      block += kSIMDBlockSize;
+      stopMask = ~pPredicate(loadBlock(block)) & kSIMDBlockMask;
+   }
+
+   return block + countTrailingZeros(stopMask);
+}
+
+static inline uint32_t whitespaceMask(SIMDBlock pBlock)
+{
+   return moveMask(bitOr(bitOr(equal(pBlock, splat(' ')), equal(pBlock, splat('\t'))),
+      bitOr(equal(pBlock, splat('\n')), equal(pBlock, splat('\r')))));
+}
+static inline uint32_t identifierMask(SIMDBlock pBlock)
+{
+   const SIMDBlock lowerCase = bitOr(pBlock, splat(0x20));
+   return moveMask(bitOr(bitOr(inRange(lowerCase, 'a', 'z'), inRange(pBlock, '0', '9')),
+      equal(pBlock, splat('_'))));
+}
+static inline uint32_t numberMask(SIMDBlock pBlock)
+{
+   const SIMDBlock symbols = bitOr(bitOr(equal(pBlock, splat('.')), equal(pBlock, splat('f'))),
+      bitOr(bitOr(equal(pBlock, splat('u')), equal(pBlock, splat('e'))), equal(pBlock, splat('-'))));
+   return moveMask(bitOr(inRange(pBlock, '0', '9'), symbols));
+}
+#endif
+
+const char* Tokenizer::skipWhitespace(const char* pCursor, uint16_t* pLine)
+{
+#if defined (CflatSIMDAVX2) || defined (CflatSIMDSSE2)
+   const char* end = skipCharacters(pCursor, whitespaceMask);
+#else
+   const char* end = pCursor;
+
+   while(hasCharacterClass(*end, kCharacterClassWhitespace))
+   {
+      end++;
+   }
+#endif
+
+   for(const char* cursor = pCursor; cursor < end; cursor++)
+   {
+      if(*cursor == '\n')
+      {
+         (*pLine)++;
       }
+   }
+
+   return end;
+}
+
+static const char* skipIdentifier(const char* pCursor)
+{
+#if defined (CflatSIMDAVX2) || defined (CflatSIMDSSE2)
+   return skipCharacters(pCursor, identifierMask);
+#else
+   while(hasCharacterClass(*pCursor, kCharacterClassIdentifier))
+   {
+      pCursor++;
+   }
+
+   return pCursor;
+#endif
+}
+
+static const char* skipNumber(const char* pCursor)
+{
+#if defined (CflatSIMDAVX2) || defined (CflatSIMDSSE2)
+   return skipCharacters(pCursor, numberMask);
+#else
+   while(hasCharacterClass(*pCursor, kCharacterClassNumber))
+   {
+      pCursor++;
+   }
+
+   return pCursor;
+#endif
+}
+
+// Returns the next quote, line break or null terminator
+static const char* findStringDelimiter(const char* pCursor, char pQuote)
+{
+#if defined (CflatSIMDAVX2) || defined (CflatSIMDSSE2)
+   const SIMDBlock quote = splat(pQuote);
+   return skipCharacters(pCursor, [quote](SIMDBlock pBlock)
+   {
+      return ~moveMask(bitOr(bitOr(equal(pBlock, quote), equal(pBlock, splat('\n'))),
+         equal(pBlock, splat('\0'))));
+   });
+#else
+   while(*pCursor != pQuote && *pCursor != '\n' && *pCursor != '\0')
+   {
+      pCursor++;
+   }
+
+   return pCursor;
+#endif
+}
+
+//
+//  Keywords are recognized through a hash table, once the identifier span is known
+//
+struct KeywordsTable
+{
+   static const size_t kSlotsCount = 128u;
+   int8_t mSlots[kSlotsCount];
+   uint8_t mLengths[kCflatKeywordsCount];
 
-      // numeric value
-      if(isdigit(*cursor) || (*cursor == '.' && isdigit(*(cursor + 1))))
+   KeywordsTable()
+   {
+      memset(mSlots, -1, sizeof(mSlots));
+
+      for(size_t i = 0u; i < kCflatKeywordsCount; i++)
       {
-         if(*cursor == '0' && *(cursor + 1) == 'x')
-         {
-            cursor++;
+         mLengths[i] = (uint8_t)strlen(kCflatKeywords[i]);
+         size_t slot = hash(kCflatKeywords[i], mLengths[i]) & (kSlotsCount - 1u);
 
-            do
-            {
-               cursor++;
-            }
-            while(isxdigit(*cursor));
-         }
-         else
+         while(mSlots[slot] >= 0)
          {
-            do
-            {
-               cursor++;
-            }
-            while(isdigit(*cursor) || *cursor == '.' || *cursor == 'f' || *cursor == 'u'
-               || *cursor == 'e' || *cursor == '-');
+            slot = (slot + 1u) & (kSlotsCount - 1u);
          }
 
-         token.mLength = cursor - token.mStart;
-         token.mType = TokenType::Number;
-         pTokens.push_back(token);
-         continue;
+         mSlots[slot] = (int8_t)i;
       }
+   }
 
-      // punctuation (2 characters)
-      const size_t tokensCount = pTokens.size();
+   bool isKeyword(const char* pString, size_t pLength) const
+   {
+      size_t slot = hash(pString, pLength) & (kSlotsCount - 1u);
 
-      for(size_t i = 0u; i < kCflatPunctuationCount; i++)
+      while(mSlots[slot] >= 0)
       {
-         if(strncmp(token.mStart, kCflatPunctuation[i], 2u) == 0)
+         const size_t keywordIndex = (size_t)mSlots[slot];
+
+         if(mLengths[keywordIndex] == pLength &&
+            memcmp(kCflatKeywords[keywordIndex], pString, pLength) == 0)
          {
-            cursor += 2u;
-            token.mLength = cursor - token.mStart;
-            token.mType = TokenType::Punctuation;
-            pTokens.push_back(token);
-            break;
+            return true;
          }
-      }
 
-      if(pTokens.size() > tokensCount)
-      {
-         continue;
+         slot = (slot + 1u) & (kSlotsCount - 1u);
       }
 
-      // operator (2 characters)
-      for(size_t i = 0u; i < kCflatOperatorsCount; i++)
+      return false;
+   }
+};
+static const KeywordsTable kKeywordsTable;
+
+void Tokenizer::tokenize(const char* pCode, CflatSTLVector(Token)& pTokens)
+{
+   const char* cursor = pCode;
+   uint16_t currentLine = 1u;
+
+   pTokens.clear();
+
+   while(*cursor != '\0')
+   {
+      cursor = skipWhitespace(cursor, &currentLine);
+
+      if(*cursor == '\0')
       {
-         if(strncmp(token.mStart, kCflatOperators[i], 2u) == 0)
-         {
-            cursor += 2u;
-            token.mLength = cursor - token.mStart;
-            token.mType = TokenType::Operator;
-            pTokens.push_back(token);
-            break;
-         }
+         break;
       }
 
-      if(pTokens.size() > tokensCount)
+      Token token;
+      token.mLine = currentLine;
+      cursor = scanToken(cursor, &token);
+      pTokens.push_back(token);
+   }
+}
+
+const char* Tokenizer::scanToken(const char* pCursor, Token* pToken)
+{
+   char* cursor = const_cast<char*>(pCursor);
+
+   Token& token = *pToken;
+   token.mStart = cursor;
+   token.mLength = 1u;
+
+   // string
+   if(*cursor == '"' || (*cursor == 'L' && *(cursor + 1) == '"'))
+   {
+      const bool wide = *cursor == 'L';
+
+      if(wide)
       {
-         continue;
+         cursor++;
       }
 
-      // punctuation (1 character)
-      for(size_t i = 0u; i < kCflatPunctuationCount; i++)
+      do
       {
-         if(token.mStart[0] == kCflatPunctuation[i][0] && kCflatPunctuation[i][1] == '\0')
-         {
-            cursor++;
-            token.mType = TokenType::Punctuation;
-            pTokens.push_back(token);
-            break;
-         }
+         cursor = const_cast<char*>(findStringDelimiter(cursor + 1, '"'));
       }
+      while(*cursor == '"' && *(cursor - 1) == '\\');
 
-      if(pTokens.size() > tokensCount)
+      if(*cursor != '\0')
       {
-         continue;
+         cursor++;
       }
 
-      // operator (1 character)
-      if(token.mStart[0] == kCflatConditionalOperator[0])
+      token.mLength = cursor - token.mStart;
+      token.mType = wide ? TokenType::WideString : TokenType::String;
+      return cursor;
+   }
+
+   // character
+   if(*cursor == '\'' || (*cursor == 'L' && *(cursor + 1) == '\''))
+   {
+      const bool wide = *cursor == 'L';
+
+      if(wide)
       {
          cursor++;
-         token.mType = TokenType::Operator;
-         pTokens.push_back(token);
       }
-      else
+
+      do
       {
-         for(size_t i = 0u; i < kCflatOperatorsCount; i++)
-         {
-            if(token.mStart[0] == kCflatOperators[i][0])
-            {
-               cursor++;
-               token.mType = TokenType::Operator;
-               pTokens.push_back(token);
-               break;
-            }
-         }
+         cursor = const_cast<char*>(findStringDelimiter(cursor + 1, '\''));
       }
+      while(*cursor == '\'' && *(cursor - 1) == '\\');
 
-      if(pTokens.size() > tokensCount)
+      if(*cursor != '\0')
       {
-         continue;
+         cursor++;
       }
 
-      // keywords
-      for(size_t i = 0u; i < kCflatKeywordsCount; i++)
+      token.mLength = cursor - token.mStart;
+      token.mType = wide ? TokenType::WideCharacter : TokenType::Character;
+      return cursor;
+   }
+
+   // numeric value
+   if(isdigit(*cursor) || (*cursor == '.' && isdigit(*(cursor + 1))))
+   {
+      if(*cursor == '0' && *(cursor + 1) == 'x')
       {
-         const size_t keywordLength = strlen(kCflatKeywords[i]);
+         cursor++;
 
-         if(strncmp(token.mStart, kCflatKeywords[i], keywordLength) == 0 &&
-            !isValidIdentifierCharacter(token.mStart[keywordLength]))
+         do
          {
-            cursor += keywordLength;
-            token.mLength = cursor - token.mStart;
-            token.mType = TokenType::Keyword;
-            pTokens.push_back(token);
-            break;
+            cursor++;
          }
+         while(hasCharacterClass(*cursor, kCharacterClassHexDigit));
       }
+      else
+      {
+         cursor = const_cast<char*>(skipNumber(cursor + 1));
+      }
+
+      token.mLength = cursor - token.mStart;
+      token.mType = TokenType::Number;
+      return cursor;
+   }
+
+   // keyword or identifier
+   if(hasCharacterClass(*cursor, kCharacterClassIdentifierBeginning))
+   {
+      cursor = const_cast<char*>(skipIdentifier(cursor + 1));
+      token.mLength = cursor - token.mStart;
+      token.mType = kKeywordsTable.isKeyword(token.mStart, token.mLength)
+         ? TokenType::Keyword
+         : TokenType::Identifier;
+      return cursor;
+   }
 
-      if(pTokens.size() > tokensCount)
+   // punctuation (2 characters)
+   for(size_t i = 0u; i < kCflatPunctuationCount; i++)
+   {
+      if(kCflatPunctuation[i][1] != '\0' && strncmp(token.mStart, kCflatPunctuation[i], 2u) == 0)
       {
-         continue;
+         token.mLength = 2u;
+         token.mType = TokenType::Punctuation;
+         return cursor + 2u;
       }
+   }
 
-      // identifier
-      do
+   // operator (2 characters)
+   for(size_t i = 0u; i < kCflatOperatorsCount; i++)
+   {
+      if(kCflatOperators[i][1] != '\0' && strncmp(token.mStart, kCflatOperators[i], 2u) == 0)
       {
-         cursor++;
+         token.mLength = 2u;
+         token.mType = TokenType::Operator;
+         return cursor + 2u;
       }
-      while(isValidIdentifierCharacter(*cursor));
+   }
 
-      token.mLength = cursor - token.mStart;
-      token.mType = TokenType::Identifier;
-      pTokens.push_back(token);
+   // punctuation (1 character)
+   for(size_t i = 0u; i < kCflatPunctuationCount; i++)
+   {
+      if(token.mStart[0] == kCflatPunctuation[i][0] && kCflatPunctuation[i][1] == '\0')
+      {
+         token.mType = TokenType::Punctuation;
+         return cursor + 1u;
+      }
+   }
+
+   // operator (1 character)
+   if(token.mStart[0] == kCflatConditionalOperator[0])
+   {
+      token.mType = TokenType::Operator;
+      return cursor + 1u;
+   }
+
+   for(size_t i = 0u; i < kCflatOperatorsCount; i++)
+   {
+      if(token.mStart[0] == kCflatOperators[i][0])
+      {
+         token.mType = TokenType::Operator;
+         return cursor + 1u;
+      }
    }
+
+   // any other character
+   cursor = const_cast<char*>(skipIdentifier(cursor + 1));
+   token.mLength = cursor - token.mStart;
+   token.mType = TokenType::Identifier;
+   return cursor;
 }
 
 bool Tokenizer::isValidIdentifierCharacter(char pCharacter)
@@ -2003,63 +2742,427 @@ bool Tokenizer::isValidIdentifierBeginningCharacter(char pCharacter)
 
 
 //
-//  Program
+//  TokensIndex
 //
-Program::~Program()
+static const char kCflatBracketOpeningChars[] = { '(', '{', '[', '<' };
+static const char kCflatBracketClosureChars[] = { ')', '}', ']', '>' };
+static const char kCflatSeparatorChars[] = { ';', ':', '=', ',' };
+
+TokensIndex::TokensIndex()
+   : mTokensCount(0u)
 {
-   for(size_t i = 0u; i < mStatements.size(); i++)
-   {
-      CflatInvokeDtor(Statement, mStatements[i]);
-      CflatFree(mStatements[i]);
-   }
 }
 
-
-//
-//  Namespace
-//
-Namespace::Namespace(const Identifier& pIdentifier, Namespace* pParent, Environment* pEnvironment)
-   : mIdentifier(pIdentifier)
-   , mFullIdentifier(pIdentifier)
-   , mParent(pParent)
-   , mEnvironment(pEnvironment)
+size_t TokensIndex::getBracketKind(char pOpeningChar, char pClosureChar)
 {
-   if(pParent && pParent->getParent())
+   for(size_t i = 0u; i < kBracketKindsCount; i++)
    {
-      char buffer[kDefaultLocalStringBufferSize];
-      snprintf(buffer, sizeof(buffer), "%s::%s", mParent->mFullIdentifier.mName, mIdentifier.mName);
-      mFullIdentifier = Identifier(buffer);
+      if(kCflatBracketOpeningChars[i] == pOpeningChar && kCflatBracketClosureChars[i] == pClosureChar)
+      {
+         return i;
+      }
    }
+
+   return kBracketKindsCount;
 }
 
-Namespace::~Namespace()
+size_t TokensIndex::getSeparatorKind(char pSeparationChar)
 {
-   mInstancesHolder.releaseInstances(0u, true);
-
-   for(NamespacesRegistry::iterator it = mNamespaces.begin(); it != mNamespaces.end(); it++)
+   for(size_t i = 0u; i < kSeparatorKindsCount; i++)
    {
-      Namespace* ns = it->second;
-      CflatInvokeDtor(Namespace, ns);
-      CflatFree(ns);
+      if(kCflatSeparatorChars[i] == pSeparationChar)
+      {
+         return i;
+      }
    }
-}
 
-const Identifier& Namespace::getIdentifier() const
-{
-   return mIdentifier;
+   return kSeparatorKindsCount;
 }
 
-const Identifier& Namespace::getFullIdentifier() const
+void TokensIndex::build(const CflatSTLVector(Token)& pTokens)
 {
-   return mFullIdentifier;
-}
+   mTokensCount = pTokens.size();
+   mScopeLevels.resize(mTokensCount);
 
-Namespace* Namespace::getParent() const
-{
-   return mParent;
-}
+   for(size_t i = 0u; i < kBracketKindsCount; i++)
+   {
+      mBrackets[i].clear();
+      mUnmatchedClosures[i].clear();
+   }
 
-Namespace* Namespace::getChild(Hash pNameHash) const
+   for(size_t i = 0u; i < kSeparatorKindsCount; i++)
+   {
+      mSeparators[i].clear();
+      mScopedSeparators[i].clear();
+   }
+
+   // entries of the brackets left open, for each kind
+   CflatSTLVector(uint32_t) openBrackets[kBracketKindsCount];
+   // parentheses and braces, as counted by 'Environment::findSeparationTokenIndex'
+   uint32_t scopeLevel = 0u;
+
+   for(size_t i = 0u; i < mTokensCount; i++)
+   {
+      const Token& token = pTokens[i];
+      mScopeLevels[i] = scopeLevel;
+
+      if(token.mLength != 1u)
+      {
+         continue;
+      }
+
+      const char character = token.mStart[0];
+      const size_t separatorKind = getSeparatorKind(character);
+
+      if(separatorKind < kSeparatorKindsCount)
+      {
+         mSeparators[separatorKind].push_back((uint32_t)i);
+
+         SeparatorEntry separatorEntry;
+         separatorEntry.mScopeLevel = scopeLevel;
+         separatorEntry.mTokenIndex = (uint32_t)i;
+         mScopedSeparators[separatorKind].push_back(separatorEntry);
+         continue;
+      }
+
+      for(size_t kind = 0u; kind < kBracketKindsCount; kind++)
+      {
+         if(character == kCflatBracketOpeningChars[kind])
+         {
+            const uint32_t entryIndex = (uint32_t)mBrackets[kind].size();
+
+            BracketEntry bracketEntry;
+            bracketEntry.mTokenIndex = (uint32_t)i;
+            bracketEntry.mMatchTokenIndex = kInvalidIndex;
+            bracketEntry.mEnclosingEntryIndex = entryIndex;
+            mBrackets[kind].push_back(bracketEntry);
+
+            openBrackets[kind].push_back(entryIndex);
+            break;
+         }
+
+         if(character == kCflatBracketClosureChars[kind])
+         {
+            BracketEntry bracketEntry;
+            bracketEntry.mTokenIndex = (uint32_t)i;
+            bracketEntry.mMatchTokenIndex = kInvalidIndex;
+            bracketEntry.mEnclosingEntryIndex = kInvalidIndex;
+
+            if(openBrackets[kind].empty())
+            {
+               mUnmatchedClosures[kind].push_back((uint32_t)i);
+            }
+            else
+            {
+               BracketEntry& openingEntry = mBrackets[kind][openBrackets[kind].back()];
+               openingEntry.mMatchTokenIndex = (uint32_t)i;
+               bracketEntry.mMatchTokenIndex = openingEntry.mTokenIndex;
+               openBrackets[kind].pop_back();
+
+               if(!openBrackets[kind].empty())
+               {
+                  bracketEntry.mEnclosingEntryIndex = openBrackets[kind].back();
+               }
+            }
+
+            mBrackets[kind].push_back(bracketEntry);
+            break;
+         }
+      }
+
+      if(character == '(' || character == '{')
+      {
+         scopeLevel++;
+      }
+      else if(character == ')' || character == '}')
+      {
+         scopeLevel--;
+      }
+   }
+
+   for(size_t i = 0u; i < kSeparatorKindsCount; i++)
+   {
+      std::sort(mScopedSeparators[i].begin(), mScopedSeparators[i].end(),
+         [](const SeparatorEntry& pA, const SeparatorEntry& pB)
+         {
+            return pA.mScopeLevel != pB.mScopeLevel
+               ? pA.mScopeLevel < pB.mScopeLevel
+               : pA.mTokenIndex < pB.mTokenIndex;
+         });
+   }
+}
+
+bool TokensIndex::isBuilt(const CflatSTLVector(Token)& pTokens) const
+{
+   return mTokensCount > 0u && mTokensCount == pTokens.size();
+}
+
+uint32_t TokensIndex::getEnclosingEntryIndex(size_t pBracketKind, size_t pTokenIndex) const
+{
+   const CflatSTLVector(BracketEntry)& brackets = mBrackets[pBracketKind];
+
+   // last bracket at or before the given token
+   CflatSTLVector(BracketEntry)::const_iterator it =
+      std::upper_bound(brackets.begin(), brackets.end(), (uint32_t)pTokenIndex,
+         [](uint32_t pTokenIndex, const BracketEntry& pEntry)
+         {
+            return pTokenIndex < pEntry.mTokenIndex;
+         });
+
+   if(it == brackets.begin())
+   {
+      return kInvalidIndex;
+   }
+
+   return (it - 1)->mEnclosingEntryIndex;
+}
+
+bool TokensIndex::findClosure(size_t pTokenIndex, char pOpeningChar, char pClosureChar,
+   size_t pTokenIndexLimit, size_t* pOutClosureIndex) const
+{
+   uint32_t closureTokenIndex = kInvalidIndex;
+
+   if(pOpeningChar == '\0')
+   {
+      const size_t separatorKind = getSeparatorKind(pClosureChar);
+
+      if(separatorKind == kSeparatorKindsCount)
+      {
+         return false;
+      }
+
+      const CflatSTLVector(uint32_t)& separators = mSeparators[separatorKind];
+      CflatSTLVector(uint32_t)::const_iterator it =
+         std::upper_bound(separators.begin(), separators.end(), (uint32_t)pTokenIndex);
+
+      if(it != separators.end())
+      {
+         closureTokenIndex = *it;
+      }
+   }
+   else
+   {
+      const size_t bracketKind = getBracketKind(pOpeningChar, pClosureChar);
+
+      if(bracketKind == kBracketKindsCount)
+      {
+         return false;
+      }
+
+      const uint32_t enclosingEntryIndex = getEnclosingEntryIndex(bracketKind, pTokenIndex);
+
+      if(enclosingEntryIndex != kInvalidIndex)
+      {
+         closureTokenIndex = mBrackets[bracketKind][enclosingEntryIndex].mMatchTokenIndex;
+      }
+      else
+      {
+         // no bracket left open: the first closure without a match is the one found
+         const CflatSTLVector(uint32_t)& unmatchedClosures = mUnmatchedClosures[bracketKind];
+         CflatSTLVector(uint32_t)::const_iterator it =
+            std::upper_bound(unmatchedClosures.begin(), unmatchedClosures.end(), (uint32_t)pTokenIndex);
+
+         if(it != unmatchedClosures.end())
+         {
+            closureTokenIndex = *it;
+         }
+      }
+   }
+
+   *pOutClosureIndex = closureTokenIndex != kInvalidIndex && closureTokenIndex <= pTokenIndexLimit
+      ? (size_t)closureTokenIndex
+      : 0u;
+
+   return true;
+}
+
+bool TokensIndex::findOpening(size_t pTokenIndex, char pOpeningChar, char pClosureChar,
+   size_t pClosureIndex, size_t* pOutOpeningIndex) const
+{
+   const size_t bracketKind = getBracketKind(pOpeningChar, pClosureChar);
+
+   if(bracketKind == kBracketKindsCount)
+   {
+      return false;
+   }
+
+   *pOutOpeningIndex = pClosureIndex;
+
+   if(pClosureIndex > 0u)
+   {
+      const uint32_t enclosingEntryIndex = getEnclosingEntryIndex(bracketKind, pClosureIndex - 1u);
+
+      if(enclosingEntryIndex != kInvalidIndex)
+      {
+         const size_t openingTokenIndex = mBrackets[bracketKind][enclosingEntryIndex].mTokenIndex;
+
+         if(openingTokenIndex >= pTokenIndex)
+         {
+            *pOutOpeningIndex = openingTokenIndex;
+         }
+      }
+   }
+
+   return true;
+}
+
+bool TokensIndex::findSeparation(size_t pTokenIndex, char pSeparationChar, size_t pClosureIndex,
+   size_t* pOutSeparationIndex) const
+{
+   const size_t separatorKind = getSeparatorKind(pSeparationChar);
+
+   if(separatorKind == kSeparatorKindsCount)
+   {
+      return false;
+   }
+
+   SeparatorEntry firstCandidate;
+   firstCandidate.mScopeLevel = mScopeLevels[pTokenIndex];
+   firstCandidate.mTokenIndex = (uint32_t)pTokenIndex + 1u;
+
+   const CflatSTLVector(SeparatorEntry)& separators = mScopedSeparators[separatorKind];
+   CflatSTLVector(SeparatorEntry)::const_iterator it =
+      std::lower_bound(separators.begin(), separators.end(), firstCandidate,
+         [](const SeparatorEntry& pA, const SeparatorEntry& pB)
+         {
+            return pA.mScopeLevel != pB.mScopeLevel
+               ? pA.mScopeLevel < pB.mScopeLevel
+               : pA.mTokenIndex < pB.mTokenIndex;
+         });
+
+   *pOutSeparationIndex = it != separators.end() &&
+      it->mScopeLevel == firstCandidate.mScopeLevel &&
+      it->mTokenIndex < pClosureIndex
+      ? (size_t)it->mTokenIndex
+      : 0u;
+
+   return true;
+}
+
+
+//
+//  LineCounter
+//
+LineCounter::LineCounter()
+   : mExecutionsCount(0u)
+   , mTime(0u)
+{
+}
+
+
+//
+//  ProgramLoadStats
+//
+ProgramLoadStats::ProgramLoadStats()
+   : mPreprocessTime(0u)
+   , mParseTime(0u)
+   , mExecuteTime(0u)
+   , mTokensCount(0u)
+   , mStatementsCount(0u)
+   , mExpressionsCount(0u)
+   , mFunctionsCount(0u)
+   , mTypesCount(0u)
+{
+}
+
+uint64_t ProgramLoadStats::getTotalTime() const
+{
+   return mPreprocessTime + mParseTime + mExecuteTime;
+}
+
+void ProgramLoadStats::add(const ProgramLoadStats& pOther)
+{
+   mPreprocessTime += pOther.mPreprocessTime;
+   mParseTime += pOther.mParseTime;
+   mExecuteTime += pOther.mExecuteTime;
+   mTokensCount += pOther.mTokensCount;
+   mStatementsCount += pOther.mStatementsCount;
+   mExpressionsCount += pOther.mExpressionsCount;
+   mFunctionsCount += pOther.mFunctionsCount;
+   mTypesCount += pOther.mTypesCount;
+   mAllocated.mBytes += pOther.mAllocated.mBytes;
+   mAllocated.mAllocations += pOther.mAllocated.mAllocations;
+}
+
+
+//
+//  Program
+//
+Program::Program()
+   : mLoadedFromCache(false)
+   , mOutlineFingerprint(0u)
+   , mDeferredFunctionBodiesCount(0u)
+   , mLocalNamespaceGlobalIndex(0u)
+   , mLineCounters(nullptr)
+   , mLineCountersCount(0u)
+{
+}
+
+Program::~Program()
+{
+   for(size_t i = 0u; i < mStatements.size(); i++)
+   {
+      CflatInvokeDtor(Statement, mStatements[i]);
+      CflatFree(mStatements[i]);
+   }
+
+   if(mLineCounters)
+   {
+      for(uint32_t i = 0u; i < mLineCountersCount; i++)
+      {
+         CflatInvokeDtor(LineCounter, &mLineCounters[i]);
+      }
+
+      CflatFree(mLineCounters);
+   }
+}
+
+
+//
+//  Namespace
+//
+Namespace::Namespace(const Identifier& pIdentifier, Namespace* pParent, Environment* pEnvironment)
+   : mIdentifier(pIdentifier)
+   , mFullIdentifier(pIdentifier)
+   , mParent(pParent)
+   , mEnvironment(pEnvironment)
+{
+   if(pParent && pParent->getParent())
+   {
+      char buffer[kDefaultLocalStringBufferSize];
+      snprintf(buffer, sizeof(buffer), "%s::%s", mParent->mFullIdentifier.mName, mIdentifier.mName);
+      mFullIdentifier = Identifier(buffer);
+   }
+}
+
+Namespace::~Namespace()
+{
+   mInstancesHolder.releaseInstances(0u, true);
+
+   for(NamespacesRegistry::iterator it = mNamespaces.begin(); it != mNamespaces.end(); it++)
+   {
+      Namespace* ns = it->second;
+      CflatInvokeDtor(Namespace, ns);
+      CflatFree(ns);
+   }
+}
+
+const Identifier& Namespace::getIdentifier() const
+{
+   return mIdentifier;
+}
+
+const Identifier& Namespace::getFullIdentifier() const
+{
+   return mFullIdentifier;
+}
+
+Namespace* Namespace::getParent() const
+{
+   return mParent;
+}
+
+Namespace* Namespace::getChild(Hash pNameHash) const
 {
    NamespacesRegistry::const_iterator it = mNamespaces.find(pNameHash);
    return it != mNamespaces.end() ? it->second : nullptr;
@@ -2637,6 +3740,20 @@ void Namespace::getAllTypes(CflatSTLVector(Type*)* pOutTypes, bool pRecursively)
    }
 }
 
+void Namespace::getAllTypeAliases(CflatSTLVector(const TypeAlias*)* pOutTypeAliases,
+   bool pRecursively) const
+{
+   mTypesHolder.getAllTypeAliases(pOutTypeAliases);
+
+   if(pRecursively)
+   {
+      for(NamespacesRegistry::const_iterator it = mNamespaces.begin(); it != mNamespaces.end(); it++)
+      {
+         it->second->getAllTypeAliases(pOutTypeAliases, true);
+      }
+   }
+}
+
 void Namespace::getAllInstances(CflatSTLVector(Instance*)* pOutInstances, bool pRecursively) const
 {
    mInstancesHolder.getAllInstances(pOutInstances);
@@ -2665,113 +3782,29 @@ void Namespace::getAllFunctions(CflatSTLVector(Function*)* pOutFunctions, bool p
 
 
 //
-//  Context
+//  Macro
 //
-Context::Context(ContextType pType, Namespace* pGlobalNamespace)
-   : mType(pType)
-   , mProgram(nullptr)
-   , mBlockLevel(0u)
-   , mScopeLevel(0u)
+Macro::Macro()
+   : mParametersCount(0u)
+   , mExpansionCached(false)
 {
-   mNamespaceStack.push_back(pGlobalNamespace);
 }
 
 
 //
-//  ParsingContext
+//  MacrosHolder
 //
-ParsingContext::ParsingContext(Namespace* pGlobalNamespace)
-   : Context(ContextType::Parsing, pGlobalNamespace)
-   , mTokenIndex(0u)
-   , mCurrentFunction(nullptr)
-   , mLocalNamespaceGlobalIndex(0u)
+MacrosHolder::MacrosHolder()
 {
+   memset(mNameFilter, 0, sizeof(mNameFilter));
 }
 
-
-//
-//  CallStackEntry
-//
-CallStackEntry::CallStackEntry(const Program* pProgram, const Function* pFunction)
-   : mProgram(pProgram)
-   , mFunction(pFunction)
-   , mLine(0u)
+void MacrosHolder::defineMacro(const char* pDefinition, const char* pBody)
 {
-}
+   Macro macro;
 
-
-//
-//  ExecutionContext
-//
-ExecutionContext::ExecutionContext(Namespace* pGlobalNamespace)
-   : Context(ContextType::Execution, pGlobalNamespace)
-   , mJumpStatement(JumpStatement::None)
-{
-}
-
-
-//
-//  Environment
-//
-Environment::Environment()
-   : mSettings(0u)
-   , mExecutionContext(&mGlobalNamespace)
-   , mGlobalNamespace("", nullptr, this)
-   , mExecutionHook(nullptr)
-{
-   static_assert(kPreprocessorErrorStringsCount == (size_t)Environment::PreprocessorError::Count,
-      "Missing preprocessor error strings");
-   static_assert(kCompileErrorStringsCount == (size_t)Environment::CompileError::Count,
-      "Missing compile error strings");
-   static_assert(kRuntimeErrorStringsCount == (size_t)Environment::RuntimeError::Count,
-      "Missing runtime error strings");
-
-   registerBuiltInTypes();
-
-   mTypeAuto = registerType<BuiltInType>("auto");
-   mTypeVoid = registerType<BuiltInType>("void");
-   mTypeInt32 = getType("int");
-   mTypeUInt32 = getType("uint32_t");
-   mTypeFloat = getType("float");
-   mTypeDouble = getType("double");
-
-   mTypeUsageVoid = getTypeUsage("void");
-   mTypeUsageSizeT = getTypeUsage("size_t");
-   mTypeUsageBool = getTypeUsage("bool");
-   mTypeUsageCString = getTypeUsage("const char*");
-   mTypeUsageWideString = getTypeUsage("const wchar_t*");
-   mTypeUsageCharacter = getTypeUsage("const char");
-   mTypeUsageWideCharacter = getTypeUsage("const wchar_t");
-   mTypeUsageVoidPtr = getTypeUsage("void*");
-}
-
-Environment::~Environment()
-{
-   mGlobalNamespace.releaseInstances(0, true);
-
-   for(ProgramsRegistry::iterator it = mPrograms.begin(); it != mPrograms.end(); it++)
-   {
-      CflatInvokeDtor(Program, it->second);
-      CflatFree(it->second);
-   }
-}
-
-void Environment::addSetting(Settings pSetting)
-{
-   CflatSetFlag(mSettings, pSetting);
-}
-
-void Environment::removeSetting(Settings pSetting)
-{
-   CflatResetFlag(mSettings, pSetting);
-}
-
-void Environment::defineMacro(const char* pDefinition, const char* pBody)
-{
-   Macro macro;
-
-   // process definition
-   const size_t definitionLength = strlen(pDefinition);
+   // process definition
+   const size_t definitionLength = strlen(pDefinition);
 
    CflatSTLVector(CflatSTLString) parameters;
    int8_t currentParameterIndex = -1;
@@ -2863,6827 +3896,13613 @@ void Environment::defineMacro(const char* pDefinition, const char* pBody)
       }
    }
 
-   // register macro in the environment
-   bool newEntryRequired = true;
-
-   for(size_t i = 0u; i < mMacros.size(); i++)
-   {
-      if(mMacros[i].mName == macro.mName)
-      {
-         mMacros[i].mBody = macro.mBody;
-         mMacros[i].mParametersCount = macro.mParametersCount;
-         newEntryRequired = false;
-         break;
-      }
-   }
-
-   if(newEntryRequired)
-   {
-      mMacros.push_back(macro);
-   }
-}
-
-void Environment::registerBuiltInTypes()
-{
-   CflatRegisterBuiltInType(this, int);
-   CflatRegisterBuiltInType(this, uint32_t);
-   CflatRegisterBuiltInType(this, size_t);
-   CflatRegisterBuiltInType(this, char);
-   CflatRegisterBuiltInType(this, bool);
-   CflatRegisterBuiltInType(this, uint8_t);
-   CflatRegisterBuiltInType(this, short);
-   CflatRegisterBuiltInType(this, wchar_t);
-   CflatRegisterBuiltInType(this, uint16_t);
-   CflatRegisterBuiltInType(this, int64_t);
-   CflatRegisterBuiltInType(this, uint64_t);
-   CflatRegisterBuiltInType(this, float);
-   CflatRegisterBuiltInType(this, double);
-
-   CflatRegisterBuiltInTypedef(this, int32_t, int);
-   CflatRegisterBuiltInTypedef(this, int8_t, char);
-   CflatRegisterBuiltInTypedef(this, int16_t, short);
+   registerMacro(macro);
 }
 
-TypeUsage Environment::parseTypeUsage(ParsingContext& pContext, size_t pTokenLastIndex) const
+void MacrosHolder::registerMacro(const Macro& pMacro)
 {
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t& tokenIndex = pContext.mTokenIndex;
-   size_t cachedTokenIndex = tokenIndex;
-
-   TypeUsage typeUsage;
-   char baseTypeName[kDefaultLocalStringBufferSize];
-
-   if(tokens[tokenIndex].mType == TokenType::Keyword &&
-      strncmp(tokens[tokenIndex].mStart, "const", 5u) == 0)
-   {
-      CflatSetFlag(typeUsage.mFlags, TypeUsageFlags::Const);
-      tokenIndex++;
-   }
+   const Hash nameHash = hash(pMacro.mName.c_str(), pMacro.mName.length());
+   MacrosRegistry::const_iterator it = mMacrosRegistry.find(nameHash);
 
-   pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
+   Macro* macro = nullptr;
 
-   while(tokenIndex < (tokens.size() - 1u) &&
-      tokens[tokenIndex + 1u].mLength == 2u &&
-      strncmp(tokens[tokenIndex + 1u].mStart, "::", 2u) == 0)
+   if(it != mMacrosRegistry.end() && mMacros[it->second].mName == pMacro.mName)
    {
-      tokenIndex += 2u;
-      pContext.mStringBuffer.append("::");
-      pContext.mStringBuffer.append(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
+      macro = &mMacros[it->second];
+      macro->mBody = pMacro.mBody;
+      macro->mParametersCount = pMacro.mParametersCount;
    }
-
-   strcpy(baseTypeName, pContext.mStringBuffer.c_str());
-   const Identifier baseTypeIdentifier(baseTypeName);
-   CflatArgsVector(TypeUsage) templateTypes;
-   bool anyInvalidTemplateType = false;
-
-   if(tokenIndex < (tokens.size() - 1u) && tokens[tokenIndex + 1u].mStart[0] == '<')
+   else
    {
-      tokenIndex += 2u;
-      const size_t closureTokenIndex = findClosureTokenIndex(pContext, '<', '>');
-
-      if((pTokenLastIndex == 0u || closureTokenIndex <= pTokenLastIndex) &&
-         isTemplate(pContext, tokenIndex - 1u, closureTokenIndex))
-      {
-         while(tokenIndex < closureTokenIndex)
-         {
-            const TypeUsage templateTypeUsage = parseTypeUsage(pContext, closureTokenIndex - 1u);
-
-            if(!templateTypeUsage.mType)
-            {
-               anyInvalidTemplateType = true;
-               break;
-            }
-
-            templateTypes.push_back(templateTypeUsage);
-            tokenIndex++;
-         }
+      mMacrosRegistry[nameHash] = mMacros.size();
+      mMacros.push_back(pMacro);
+      macro = &mMacros.back();
 
-         tokenIndex = closureTokenIndex;
-      }
+      const size_t nameLength = std::min(pMacro.mName.length(), (size_t)63u);
+      mNameFilter[(uint8_t)pMacro.mName.c_str()[0] % kNameFilterSize] |= 1ull << nameLength;
    }
 
-   if(!anyInvalidTemplateType)
-   {   
-      for(size_t i = 0u; i < pContext.mTypeAliases.size(); i++)
-      {
-         if(pContext.mTypeAliases[i].mIdentifier == baseTypeIdentifier)
-         {
-            typeUsage = pContext.mTypeAliases[i].mTypeUsage;
-            break;
-         }
-      }
-
-      if(!typeUsage.mType)
-      {
-         for(int i = (int)pContext.mLocalNamespaceStack.size() - 1; i >= 0; i--)
-         {
-            Namespace* ns = pContext.mLocalNamespaceStack[i].mNamespace;
-            typeUsage.mType = ns->getType(baseTypeIdentifier, templateTypes);
+   cacheExpansion(macro);
+}
 
-            if(typeUsage.mType)
-            {
-               break;
-            }
-         }
-      }
+void MacrosHolder::cacheExpansion(Macro* pMacro)
+{
+   pMacro->mExpansionCached = false;
+   pMacro->mExpansion.clear();
+   pMacro->mExpansionTokens.clear();
 
-      if(!typeUsage.mType)
-      {
-         for(int i = (int)pContext.mNamespaceStack.size() - 1; i >= 0; i--)
-         {
-            Namespace* ns = pContext.mNamespaceStack[i];
-            const TypeAlias* typeAlias = ns->getTypeAlias(baseTypeIdentifier);
+   if(pMacro->mParametersCount > 0u)
+      return;
 
-            if(typeAlias)
-            {
-               typeUsage = typeAlias->mTypeUsage;
-               break;
-            }
-         }
+   for(size_t i = 0u; i < pMacro->mBody.size(); i++)
+   {
+      // argument references make the expansion fail, which the preprocessor reports
+      if(pMacro->mBody[i][0] == '$')
+         return;
 
-         if(!typeUsage.mType)
-         {
-            typeUsage.mType = findType(pContext, baseTypeIdentifier, templateTypes);
-         }
-      }
+      pMacro->mExpansion.append(pMacro->mBody[i]);
    }
 
-   if(typeUsage.mType)
-   {
-      while(tokenIndex < (tokens.size() - 1u) && *tokens[tokenIndex + 1u].mStart == '*')
-      {
-         typeUsage.mPointerLevel++;
-         tokenIndex++;
-      }
+   const char* expansion = pMacro->mExpansion.c_str();
+   const char* cursor = expansion;
+   uint16_t lineOffset = 0u;
 
-      if(typeUsage.mPointerLevel > 0u && typeUsage.isConst())
-      {
-         CflatResetFlag(typeUsage.mFlags, TypeUsageFlags::Const);
-         CflatSetFlag(typeUsage.mFlags, TypeUsageFlags::ConstPointer);
-      }
+   while(*cursor != '\0')
+   {
+      cursor = Tokenizer::skipWhitespace(cursor, &lineOffset);
 
-      if(tokenIndex < (tokens.size() - 1u) && *tokens[tokenIndex + 1u].mStart == '&')
+      if(*cursor == '\0')
       {
-         CflatSetFlag(typeUsage.mFlags, TypeUsageFlags::Reference);
-         tokenIndex++;
+         break;
       }
 
-      tokenIndex++;
+      Token token;
+      cursor = Tokenizer::scanToken(cursor, &token);
 
-      if(tokenIndex < tokens.size() &&
-         typeUsage.mPointerLevel > 0u &&
-         tokens[tokenIndex].mType == TokenType::Keyword &&
-         strncmp(tokens[tokenIndex].mStart, "const", 5u) == 0)
-      {
-         CflatSetFlag(typeUsage.mFlags, TypeUsageFlags::Const);
-         tokenIndex++;
-      }
-   }
-   else
-   {
-      tokenIndex = cachedTokenIndex;
+      MacroToken macroToken;
+      macroToken.mType = token.mType;
+      macroToken.mLineOffset = lineOffset;
+      macroToken.mOffset = (uint32_t)(token.mStart - expansion);
+      macroToken.mLength = (uint32_t)token.mLength;
+      pMacro->mExpansionTokens.push_back(macroToken);
    }
 
-   return typeUsage;
+   pMacro->mExpansionCached = true;
 }
 
-void Environment::throwPreprocessorError(ParsingContext& pContext, PreprocessorError pError,
-   size_t pCursor, const char* pArg)
+const Macro* MacrosHolder::getMacro(const char* pName, size_t pNameLength) const
 {
-   char errorMsg[kDefaultLocalStringBufferSize];
-   snprintf(errorMsg, sizeof(errorMsg), kPreprocessorErrorStrings[(int)pError], pArg);
+   const size_t nameLength = std::min(pNameLength, (size_t)63u);
 
-   const char* code = pContext.mProgram->mCode.c_str();
-   uint16_t line = 1u;
+   if((mNameFilter[(uint8_t)pName[0] % kNameFilterSize] & (1ull << nameLength)) == 0u)
+   {
+      return nullptr;
+   }
 
-   for(size_t i = 0u; i < pCursor; i++)
+   MacrosRegistry::const_iterator it = mMacrosRegistry.find(hash(pName, pNameLength));
+
+   if(it != mMacrosRegistry.end())
    {
-      if(code[i] == '\n')
+      const Macro& macro = mMacros[it->second];
+
+      if(macro.mName.length() == pNameLength && strncmp(macro.mName.c_str(), pName, pNameLength) == 0)
       {
-         line++;
+         return &macro;
       }
    }
 
-   char lineAsString[kSmallLocalStringBufferSize];
-   snprintf(lineAsString, sizeof(lineAsString), "%d", line);
-
-   mErrorMessage.assign("[Preprocessor Error] '");
-   mErrorMessage.append(pContext.mProgram->mIdentifier.mName);
-   mErrorMessage.append("' -- Line ");
-   mErrorMessage.append(lineAsString);
-   mErrorMessage.append(": ");
-   mErrorMessage.append(errorMsg);
+   return nullptr;
 }
 
-void Environment::throwCompileError(ParsingContext& pContext, CompileError pError,
-   const char* pArg1, const char* pArg2)
+const CflatSTLVector(Macro)& MacrosHolder::getMacros() const
 {
-   if(!mErrorMessage.empty())
-      return;
-
-   const Token& token = pContext.mTokenIndex < pContext.mTokens.size()
-      ? pContext.mTokens[pContext.mTokenIndex]
-      : pContext.mTokens[pContext.mTokens.size() - 1u];
+   return mMacros;
+}
 
-   char errorMsg[kDefaultLocalStringBufferSize];
-   snprintf(errorMsg, sizeof(errorMsg), kCompileErrorStrings[(int)pError], pArg1, pArg2);
 
-   char lineAsString[kSmallLocalStringBufferSize];
-   snprintf(lineAsString, sizeof(lineAsString), "%d", token.mLine);
-
-   mErrorMessage.assign("[Compile Error] '");
-   mErrorMessage.append(pContext.mProgram->mIdentifier.mName);
-   mErrorMessage.append("' -- Line ");
-   mErrorMessage.append(lineAsString);
-   mErrorMessage.append(": ");
-   mErrorMessage.append(errorMsg);
+//
+//  Context
+//
+Context::Context(ContextType pType, Namespace* pGlobalNamespace)
+   : mType(pType)
+   , mProgram(nullptr)
+   , mBlockLevel(0u)
+   , mScopeLevel(0u)
+   , mLocalInstancesHolder(&mStack)
+{
+   mNamespaceStack.push_back(pGlobalNamespace);
 }
 
-void Environment::throwCompileErrorUnexpectedSymbol(ParsingContext& pContext)
+
+//
+//  ParsingContext
+//
+ParsingContext::ParsingContext(Namespace* pGlobalNamespace)
+   : Context(ContextType::Parsing, pGlobalNamespace)
+   , mTokenIndex(0u)
+   , mMacrosGeneration(0u)
+   , mCachedProgramOffset(0u)
+   , mCachedBindingsFingerprint(0u)
+   , mMacrosFingerprint(0u)
+   , mIncrementalReload(false)
+   , mSharedAccess(false)
+   , mWriteAccessRequired(false)
+   , mParsed(false)
+   , mWriteAccessGeneration(0u)
+   , mCurrentFunction(nullptr)
+   , mLocalNamespaceGlobalIndex(0u)
 {
-   const Token& token = pContext.mTokens[pContext.mTokenIndex];
-   pContext.mStringBuffer.assign(token.mStart, token.mLength);
-   throwCompileError(pContext, CompileError::UnexpectedSymbol, pContext.mStringBuffer.c_str());
 }
 
-void Environment::preprocess(ParsingContext& pContext, const char* pCode)
-{
-   CflatSTLString& preprocessedCode = pContext.mPreprocessedCode;
 
-   const size_t codeLength = strlen(pCode);
-   preprocessedCode.clear();
+//
+//  Program cache
+//
+static const uint32_t kProgramCacheSignature = 0x434c4643u; // "CFLC"
+static const uint32_t kProgramCacheVersion = 3u;
+static const uint32_t kProgramCacheNullIndex = UINT32_MAX;
+static const uint8_t kProgramCacheNullNode = UINT8_MAX;
 
-   size_t cursor = 0u;
+static const Hash kFingerprintBasis = 2166136261u;
+static const Hash kFingerprintPrime = 16777619u;
 
-   while(cursor < codeLength)
-   {
-      // string literal
-      if(pCode[cursor] == '"')
-      {
-         do
-         {
-            preprocessedCode.push_back(pCode[cursor]);
-            cursor++;
-         }
-         while(pCode[cursor] != '"' && pCode[cursor] != '\0');
-      }
-      // line comment
-      else if(strncmp(pCode + cursor, "//", 2u) == 0)
-      {
-         while(pCode[cursor] != '\n' && pCode[cursor] != '\0')
-         {
-            cursor++;
-         }
-      }
-      // block comment
-      else if(strncmp(pCode + cursor, "/*", 2u) == 0)
-      {
-         while(strncmp(pCode + cursor, "*/", 2u) != 0)
-         {
-            cursor++;
+// 64-bit FNV-1a, so that a modified code is not taken for the cached one
+static const uint64_t kCodeFingerprintBasis = 14695981039346656037ull;
+static const uint64_t kCodeFingerprintPrime = 1099511628211ull;
 
-            if(pCode[cursor] == '\n')
-            {
-               preprocessedCode.push_back('\n');
-            }
-         }
+static void addToCodeFingerprint(uint64_t* pFingerprint, const void* pData, size_t pSize)
+{
+   const uint8_t* data = static_cast<const uint8_t*>(pData);
 
-         cursor += 2u;
-         continue;
-      }
-      // preprocessor directive
-      else if(pCode[cursor] == '#')
-      {
-         cursor++;
+   for(size_t i = 0u; i < pSize; i++)
+   {
+      *pFingerprint ^= data[i];
+      *pFingerprint *= kCodeFingerprintPrime;
+   }
+}
 
-         while(pCode[cursor] == ' ' || pCode[cursor] == '\t')
-         {
-            cursor++;
-         }
+static uint64_t getCodeFingerprint(const char* pCode, size_t pLength)
+{
+   uint64_t fingerprint = kCodeFingerprintBasis;
+   addToCodeFingerprint(&fingerprint, pCode, pLength);
 
-         // #include (valid, but ignored)
-         if(strncmp(pCode + cursor, "include", 7u) == 0)
-         {
-            cursor += 7u;
-         }
-         // #ifdef (valid, but ignored)
-         else if(strncmp(pCode + cursor, "ifdef", 5u) == 0)
-         {
-            cursor += 5u;
-         }
-         // #if (valid, but ignored)
-         else if(strncmp(pCode + cursor, "if", 2u) == 0)
-         {
-            cursor += 2u;
-         }
-         // #pragma (valid, but ignored)
-         else if(strncmp(pCode + cursor, "pragma", 6u) == 0)
-         {
-            cursor += 6u;
-         }
-         // #define
-         else if(strncmp(pCode + cursor, "define", 6u) == 0)
-         {
-            cursor += 6u;
+   return fingerprint;
+}
 
-            if(pCode[cursor] != ' ' && pCode[cursor] != '\t')
-            {
-               throwPreprocessorError(pContext, PreprocessorError::InvalidPreprocessorDirective,
-                  cursor);
-               return;
-            }
+static void writeCacheData(CflatSTLVector(char)& pBuffer, const void* pData, size_t pSize)
+{
+   const char* data = static_cast<const char*>(pData);
+   pBuffer.insert(pBuffer.end(), data, data + pSize);
+}
 
-            while(pCode[cursor] == ' ' || pCode[cursor] == '\t')
-            {
-               cursor++;
-            }
+template<typename T>
+static void writeCacheValue(CflatSTLVector(char)& pBuffer, T pValue)
+{
+   writeCacheData(pBuffer, &pValue, sizeof(T));
+}
 
-            if(pCode[cursor] == '\n' || pCode[cursor] == '\0')
-            {
-               throwPreprocessorError(pContext, PreprocessorError::InvalidPreprocessorDirective,
-                  cursor);
-               return;
-            }
+static void writeCacheString(CflatSTLVector(char)& pBuffer, const char* pString, size_t pLength)
+{
+   writeCacheValue(pBuffer, (uint32_t)pLength);
+   writeCacheData(pBuffer, pString, pLength);
+}
 
-            char macroDefinition[kDefaultLocalStringBufferSize];
-            size_t macroCursor = 0u;
+static void readCacheData(ProgramCacheReader& pReader, void* pData, size_t pSize)
+{
+   if(pReader.mFailed || (size_t)(pReader.mEnd - pReader.mCursor) < pSize)
+   {
+      pReader.mFailed = true;
+      memset(pData, 0, pSize);
+      return;
+   }
 
-            while(pCode[cursor] != ' ' &&
-               pCode[cursor] != '\t' &&
-               pCode[cursor] != '\n' &&
-               pCode[cursor] != '\0')
-            {
-               if(pCode[cursor] == '(')
-               {
-                  while(pCode[cursor] != ')')
-                  {
-                     macroDefinition[macroCursor++] = pCode[cursor++];
-                  }
-               }
-               macroDefinition[macroCursor++] = pCode[cursor++];
-            }
+   memcpy(pData, pReader.mCursor, pSize);
+   pReader.mCursor += pSize;
+}
 
-            macroDefinition[macroCursor] = '\0';
+template<typename T>
+static T readCacheValue(ProgramCacheReader& pReader)
+{
+   T value;
+   readCacheData(pReader, &value, sizeof(T));
+   return value;
+}
 
-            while(pCode[cursor] == ' ' || pCode[cursor] == '\t')
-            {
-               cursor++;
-            }
+static const char* readCacheString(ProgramCacheReader& pReader, uint32_t* pOutLength)
+{
+   *pOutLength = readCacheValue<uint32_t>(pReader);
 
-            char macroBody[kDefaultLocalStringBufferSize];
-            macroCursor = 0u;
+   if(pReader.mFailed || (size_t)(pReader.mEnd - pReader.mCursor) < *pOutLength)
+   {
+      pReader.mFailed = true;
+      *pOutLength = 0u;
+      return "";
+   }
 
-            while(pCode[cursor] != '\n' && pCode[cursor] != '\0')
-            {
-               macroBody[macroCursor++] = pCode[cursor++];
-            }
+   const char* string = pReader.mCursor;
+   pReader.mCursor += *pOutLength;
 
-            macroBody[macroCursor] = '\0';
+   return string;
+}
 
-            defineMacro(macroDefinition, macroBody);
-         }
-         else
-         {
-            throwPreprocessorError(pContext, PreprocessorError::InvalidPreprocessorDirective,
-               cursor);
-            return;
-         }
+static void addToFingerprint(Hash* pFingerprint, uint32_t pValue)
+{
+   *pFingerprint = (*pFingerprint ^ pValue) * kFingerprintPrime;
+}
 
-         while(pCode[cursor] != '\n' && pCode[cursor] != '\0')
-         {
-            cursor++;
-         }
-      }
+static void addToFingerprint(Hash* pFingerprint, const TypeUsage& pTypeUsage)
+{
+   if(pTypeUsage.mType)
+   {
+      addToFingerprint(pFingerprint, pTypeUsage.mType->mNamespace->getFullIdentifier().mHash);
+      addToFingerprint(pFingerprint, pTypeUsage.mType->getHash());
+   }
 
-      // perform macro replacement
-      if(Tokenizer::isValidIdentifierBeginningCharacter(pCode[cursor]))
-      {
-         for(size_t i = 0u; i < mMacros.size(); i++)
-         {
-            Macro& macro = mMacros[i];
+   addToFingerprint(pFingerprint,
+      ((uint32_t)pTypeUsage.mArraySize << 16u) |
+      ((uint32_t)pTypeUsage.mPointerLevel << 8u) |
+      (uint32_t)pTypeUsage.mFlags);
+}
 
-            if(strncmp(pCode + cursor, macro.mName.c_str(), macro.mName.length()) == 0 &&
-               !Tokenizer::isValidIdentifierCharacter(pCode[cursor + macro.mName.length()]))
-            {
-               cursor += macro.mName.length();
+static void addToFingerprint(Hash* pFingerprint, const CflatSTLVector(TypeUsage)& pTypeUsages)
+{
+   addToFingerprint(pFingerprint, (uint32_t)pTypeUsages.size());
 
-               if(macro.mParametersCount > 0u)
-               {
-                  while(pCode[cursor] == ' ' || pCode[cursor] == '\n')
-                  {
-                     cursor++;
-                  }
-               }
+   for(size_t i = 0u; i < pTypeUsages.size(); i++)
+   {
+      addToFingerprint(pFingerprint, pTypeUsages[i]);
+   }
+}
 
-               // parse arguments
-               CflatSTLVector(CflatSTLString) arguments;
+static void addToFingerprint(Hash* pFingerprint, const Function* pFunction)
+{
+   addToFingerprint(pFingerprint, pFunction->mIdentifier.mHash);
+   addToFingerprint(pFingerprint, pFunction->mReturnTypeUsage);
+   addToFingerprint(pFingerprint, (uint32_t)pFunction->mFlags);
+   addToFingerprint(pFingerprint, pFunction->mParameters);
+   addToFingerprint(pFingerprint, pFunction->mTemplateTypes);
+}
 
-               if(pCode[cursor] == '(')
-               {
-                  int parenthesisLevel = 1;
+static void addToFingerprint(Hash* pFingerprint, const InstancesHolder& pInstancesHolder,
+   CflatSTLVector(Instance*)& pInstancesBuffer)
+{
+   pInstancesBuffer.clear();
+   pInstancesHolder.getAllInstances(&pInstancesBuffer);
+   addToFingerprint(pFingerprint, (uint32_t)pInstancesBuffer.size());
 
-                  arguments.emplace_back();
-                  cursor++;
+   for(size_t i = 0u; i < pInstancesBuffer.size(); i++)
+   {
+      addToFingerprint(pFingerprint, pInstancesBuffer[i]->mIdentifier.mHash);
+      addToFingerprint(pFingerprint, pInstancesBuffer[i]->mTypeUsage);
+   }
+}
 
-                  while(parenthesisLevel > 0 && pCode[cursor] != '\0')
-                  {
-                     if (pCode[cursor] == '(')
-                     {
-                        parenthesisLevel++;
-                     }
-                     else if (pCode[cursor] == ')')
-                     {
-                        parenthesisLevel--;
-                        if (parenthesisLevel == 0)
-                        {
-                           break;
-                        }
-                     }
+static void addToFingerprint(Hash* pFingerprint, const CflatSTLVector(const TypeAlias*)& pTypeAliases)
+{
+   addToFingerprint(pFingerprint, (uint32_t)pTypeAliases.size());
 
-                     if (pCode[cursor] == '"')
-                     {
-                        do
-                        {
-                           arguments.back().push_back(pCode[cursor]);
-                           cursor++;
-                        }
-                        while(!(pCode[cursor] == '"' && pCode[cursor + 1] != '\\'));
+   for(size_t i = 0u; i < pTypeAliases.size(); i++)
+   {
+      addToFingerprint(pFingerprint, pTypeAliases[i]->mIdentifier.mHash);
+      addToFingerprint(pFingerprint, pTypeAliases[i]->mTypeUsage);
+   }
+}
 
-                        arguments.back().push_back(pCode[cursor]);
-                        cursor++;
-                     }
-                     else if(pCode[cursor] == ',')
-                     {
-                        arguments.emplace_back();
-                        cursor++;
+static void addToFingerprint(Hash* pFingerprint, const CflatSTLVector(Function*)& pFunctions)
+{
+   addToFingerprint(pFingerprint, (uint32_t)pFunctions.size());
 
-                        while(pCode[cursor] == ' ' || pCode[cursor] == '\n')
-                        {
-                           cursor++;
-                        }
-                     }
-                     else
-                     {
-                        arguments.back().push_back(pCode[cursor]);
-                        cursor++;
-                     }
-                  }
-               }
+   for(size_t i = 0u; i < pFunctions.size(); i++)
+   {
+      addToFingerprint(pFingerprint, pFunctions[i]);
+   }
+}
 
-               // append the replaced strings
-               for(size_t j = 0u; j < macro.mBody.size(); j++)
-               {
-                  const CflatSTLString& bodyChunk = macro.mBody[j];
+static void addToFingerprint(Hash* pFingerprint, Type* pType)
+{
+   addToFingerprint(pFingerprint, pType->mNamespace->getFullIdentifier().mHash);
+   addToFingerprint(pFingerprint, pType->getHash());
+   addToFingerprint(pFingerprint, pType->mParent ? pType->mParent->getHash() : 0u);
+   addToFingerprint(pFingerprint, (uint32_t)pType->mSize);
+   addToFingerprint(pFingerprint, ((uint32_t)pType->mCategory << 8u) | pType->mAlignment);
 
-                  if(bodyChunk[0] == '$')
-                  {
-                     const size_t parameterIndex = (size_t)(bodyChunk[1] - '1');
+   CflatSTLVector(Instance*) instances;
 
-                     if(parameterIndex >= arguments.size())
-                     {
-                        throwPreprocessorError(pContext, PreprocessorError::InvalidMacroArgumentCount,
-                           cursor, macro.mName.c_str());
-                        return;
-                     }
+   if(pType->mCategory == TypeCategory::Enum)
+   {
+      addToFingerprint(pFingerprint, static_cast<Enum*>(pType)->mInstancesHolder, instances);
+   }
+   else if(pType->mCategory == TypeCategory::EnumClass)
+   {
+      addToFingerprint(pFingerprint, static_cast<EnumClass*>(pType)->mInstancesHolder, instances);
+   }
+   else if(pType->mCategory == TypeCategory::StructOrClass)
+   {
+      Struct* type = static_cast<Struct*>(pType);
+      addToFingerprint(pFingerprint, type->mTemplateTypes);
 
-                     const MacroArgumentType argumentType = (MacroArgumentType)(bodyChunk[2] - '0');
+      addToFingerprint(pFingerprint, (uint32_t)type->mBaseTypes.size());
 
-                     if(argumentType == MacroArgumentType::Stringize)
-                     {
-                        preprocessedCode.push_back('\"');
-                        preprocessedCode.append(arguments[parameterIndex]);
-                        preprocessedCode.push_back('\"');
-                     }
-                     else
-                     {
-                        preprocessedCode.append(arguments[parameterIndex]);
-                     }
-                  }
-                  else
-                  {
-                     preprocessedCode.append(bodyChunk);
-                  }
-               }
+      for(size_t i = 0u; i < type->mBaseTypes.size(); i++)
+      {
+         addToFingerprint(pFingerprint, type->mBaseTypes[i].mType->getHash());
+         addToFingerprint(pFingerprint, (uint32_t)type->mBaseTypes[i].mOffset);
+      }
 
-               if(!arguments.empty())
-               {
-                  cursor++;
-               }
+      addToFingerprint(pFingerprint, (uint32_t)type->mMembers.size());
 
-               break;
-            }
-         }
+      for(size_t i = 0u; i < type->mMembers.size(); i++)
+      {
+         const Member* member = type->mMembers[i];
+         addToFingerprint(pFingerprint, member->mIdentifier.mHash);
+         addToFingerprint(pFingerprint, member->mTypeUsage);
+         addToFingerprint(pFingerprint, member->mMemberType == MemberType::Field
+            ? (uint32_t)static_cast<const Field*>(member)->mOffset
+            : (uint32_t)static_cast<const BitField*>(member)->mBitSize);
       }
 
-      // skip carriage return characters
-      while(pCode[cursor] == '\r')
+      addToFingerprint(pFingerprint, (uint32_t)type->mMethods.size());
+
+      for(size_t i = 0u; i < type->mMethods.size(); i++)
       {
-         cursor++;
+         const Method& method = type->mMethods[i];
+         addToFingerprint(pFingerprint, method.mIdentifier.mHash);
+         addToFingerprint(pFingerprint, method.mReturnTypeUsage);
+         addToFingerprint(pFingerprint, (uint32_t)method.mFlags);
+         addToFingerprint(pFingerprint, method.mParameters);
+         addToFingerprint(pFingerprint, method.mTemplateTypes);
       }
 
-      // add the current character to the preprocessed code
-      preprocessedCode.push_back(pCode[cursor]);
+      CflatSTLVector(Function*) staticMethods;
+      type->mFunctionsHolder.getAllFunctions(&staticMethods);
+      addToFingerprint(pFingerprint, staticMethods);
+
+      addToFingerprint(pFingerprint, type->mInstancesHolder, instances);
+
+      CflatSTLVector(const TypeAlias*) typeAliases;
+      type->mTypesHolder.getAllTypeAliases(&typeAliases);
+      addToFingerprint(pFingerprint, typeAliases);
 
-      cursor++;
+      CflatSTLVector(Type*) nestedTypes;
+      type->mTypesHolder.getAllTypes(&nestedTypes);
+      addToFingerprint(pFingerprint, (uint32_t)nestedTypes.size());
+
+      for(size_t i = 0u; i < nestedTypes.size(); i++)
+      {
+         addToFingerprint(pFingerprint, nestedTypes[i]);
+      }
    }
+}
 
-   if(preprocessedCode.back() != '\n')
+static Type* findCachedType(Namespace* pNamespace, Type* pParent, const Identifier& pIdentifier,
+   const CflatArgsVector(TypeUsage)& pTemplateTypes)
+{
+   if(pParent)
    {
-      preprocessedCode.push_back('\n');
+      return pParent->mCategory == TypeCategory::StructOrClass
+         ? static_cast<Struct*>(pParent)->getType(pIdentifier, pTemplateTypes)
+         : nullptr;
    }
 
-   preprocessedCode.shrink_to_fit();
+   return pNamespace ? pNamespace->getType(pIdentifier, pTemplateTypes) : nullptr;
 }
 
-void Environment::tokenize(ParsingContext& pContext) const
+static Function* findCachedFunction(Namespace* pNamespace, Type* pOwnerType,
+   const Identifier& pIdentifier, const CflatArgsVector(TypeUsage)& pParameterTypes,
+   const CflatArgsVector(TypeUsage)& pTemplateTypes)
 {
-   Tokenizer::tokenize(pContext.mPreprocessedCode.c_str(), pContext.mTokens);
+   if(pOwnerType)
+   {
+      return pOwnerType->mCategory == TypeCategory::StructOrClass
+         ? static_cast<Struct*>(pOwnerType)->mFunctionsHolder.getFunctionPerfectMatch(
+            pIdentifier, pParameterTypes, pTemplateTypes)
+         : nullptr;
+   }
+
+   return pNamespace
+      ? pNamespace->getFunctionPerfectMatch(pIdentifier, pParameterTypes, pTemplateTypes)
+      : nullptr;
 }
 
-void Environment::parse(ParsingContext& pContext)
+static Struct* findMethodOwner(Type* pType, const Method* pMethod)
 {
-   size_t& tokenIndex = pContext.mTokenIndex;
+   if(!pType || pType->mCategory != TypeCategory::StructOrClass)
+   {
+      return nullptr;
+   }
 
-   for(tokenIndex = 0u; tokenIndex < pContext.mTokens.size(); tokenIndex++)
+   Struct* type = static_cast<Struct*>(pType);
+
+   if(!type->mMethods.empty() &&
+      pMethod >= &type->mMethods[0] &&
+      pMethod < &type->mMethods[0] + type->mMethods.size())
    {
-      Statement* statement = parseStatement(pContext);
+      return type;
+   }
 
-      if(!mErrorMessage.empty())
-      {
-         break;
-      }
+   for(size_t i = 0u; i < type->mBaseTypes.size(); i++)
+   {
+      Struct* owner = findMethodOwner(type->mBaseTypes[i].mType, pMethod);
 
-      if(statement)
+      if(owner)
       {
-         pContext.mProgram->mStatements.push_back(statement);
+         return owner;
       }
    }
+
+   return nullptr;
 }
 
-Expression* Environment::parseExpression(ParsingContext& pContext, size_t pTokenLastIndex,
-   bool pNullAllowed)
+static void collectStaticMethodOwners(Type* pType,
+   ProgramCacheWriter::StaticMethodOwnersRegistry& pOwners)
 {
-   Expression* expression = nullptr;
-
-   const size_t tokensCount = pTokenLastIndex - pContext.mTokenIndex + 1u;
-
-   if(tokensCount != 0u)
+   if(pType->mCategory != TypeCategory::StructOrClass)
    {
-      if(tokensCount == 1u)
-      {
-         expression = parseExpressionSingleToken(pContext);
-      }
-      else
-      {
-         expression = parseExpressionMultipleTokens(pContext, pContext.mTokenIndex, pTokenLastIndex);
-      }
+      return;
    }
 
-   if(!pNullAllowed && !expression)
+   Struct* type = static_cast<Struct*>(pType);
+
+   CflatSTLVector(Function*) staticMethods;
+   type->mFunctionsHolder.getAllFunctions(&staticMethods);
+
+   for(size_t i = 0u; i < staticMethods.size(); i++)
    {
-      throwCompileErrorUnexpectedSymbol(pContext);
+      pOwners[(uintptr_t)staticMethods[i]] = type;
    }
 
-   if(expression && !mErrorMessage.empty())
+   CflatSTLVector(Type*) nestedTypes;
+   type->mTypesHolder.getAllTypes(&nestedTypes);
+
+   for(size_t i = 0u; i < nestedTypes.size(); i++)
    {
-      CflatInvokeDtor(Expression, expression);
-      CflatFree(expression);
-      expression = nullptr;
+      collectStaticMethodOwners(nestedTypes[i], pOwners);
    }
+}
 
-   return expression;
+ProgramCacheWriter::ProgramCacheWriter(Namespace* pGlobalNamespace)
+   : mStringsCount(0u)
+   , mTypesCount(0u)
+   , mFunctionsCount(0u)
+   , mStaticMethodOwnersCollected(false)
+   , mSupported(true)
+{
+   mNamespaceStack.push_back(pGlobalNamespace);
 }
 
-Expression* Environment::parseExpressionSingleToken(ParsingContext& pContext)
+ProgramCacheReader::ProgramCacheReader(const char* pData, size_t pSize)
+   : mCursor(pData)
+   , mEnd(pData + pSize)
+   , mFailed(false)
+   , mScopeLevel(0u)
 {
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t& tokenIndex = pContext.mTokenIndex;
-   const Token& token = tokens[tokenIndex];
-   Expression* expression = nullptr;
+}
 
-   if(token.mType == TokenType::Number)
-   {
-      TypeUsage typeUsage;
-      Value value;
 
-      pContext.mStringBuffer.assign(token.mStart, token.mLength);
-      const char* numberStr = pContext.mStringBuffer.c_str();
-      const size_t numberStrLength = strlen(numberStr);
+//
+//  CallStackEntry
+//
+CallStackEntry::CallStackEntry(const Program* pProgram, const Function* pFunction)
+   : mProgram(pProgram)
+   , mFunction(pFunction)
+   , mLine(0u)
+{
+}
 
-      // decimal value
-      if(strchr(numberStr, '.'))
+
+//
+//  ExecutionProfile
+//
+static uint64_t getProfilerTime()
+{
+   return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ExecutionProfile::ExecutionProfile(uint32_t pThreadIndex)
+   : mThreadIndex(pThreadIndex)
+{
+   reset();
+}
+
+uint32_t ExecutionProfile::findCallNode(const void* pCallee) const
+{
+   const uint32_t parent = mFrames.empty() ? 0u : mFrames.back().mNode;
+
+   for(uint32_t i = mNodes[parent].mFirstChild; i != kInvalidNode; i = mNodes[i].mNextSibling)
+   {
+      if(mNodes[i].mCallee == pCallee)
       {
-         // float
-         if(numberStr[numberStrLength - 1u] == 'f')
-         {
-            typeUsage.mType = mTypeFloat;
+         return i;
+      }
+   }
 
-            char* endPtr = nullptr;
-            const float number = strtof(numberStr, &endPtr);
+   return kInvalidNode;
+}
 
-            if(endPtr != (numberStr + token.mLength - 1))
-            {
-               throwCompileError(pContext, CompileError::InvalidNumericValue, numberStr);
-               return nullptr;
-            }
+uint32_t ExecutionProfile::addCallNode(const void* pCallee, const Identifier& pName)
+{
+   const uint32_t parent = mFrames.empty() ? 0u : mFrames.back().mNode;
+   const uint32_t nodeIndex = (uint32_t)mNodes.size();
 
-            value.initOnStack(typeUsage, &mExecutionContext.mStack);
-            value.set(&number);
-         }
-         // double
-         else
-         {
-            typeUsage.mType = mTypeDouble;
+   Node node;
+   node.mCallee = pCallee;
+   node.mName = pName;
+   node.mParent = parent;
+   node.mFirstChild = kInvalidNode;
+   node.mNextSibling = mNodes[parent].mFirstChild;
+   node.mCallsCount = 0u;
+   node.mInclusiveTime = 0u;
+   node.mChildrenTime = 0u;
+   mNodes.push_back(node);
 
-            char* endPtr = nullptr;
-            const double number = strtod(numberStr, &endPtr);
+   mNodes[parent].mFirstChild = nodeIndex;
 
-            if(endPtr != (numberStr + token.mLength))
-            {
-               throwCompileError(pContext, CompileError::InvalidNumericValue, numberStr);
-               return nullptr;
-            }
+   return nodeIndex;
+}
 
-            value.initOnStack(typeUsage, &mExecutionContext.mStack);
-            value.set(&number);
-         }
-      }
-      // integer value
-      else
-      {
-         // unsigned
-         if(numberStr[numberStrLength - 1u] == 'u')
-         {
-            typeUsage.mType = mTypeUInt32;
-            const uint32_t number = (uint32_t)atoi(numberStr);
-            value.initOnStack(typeUsage, &mExecutionContext.mStack);
-            value.set(&number);
-         }
-         // hex
-         else if(numberStr[0] == '0' && numberStr[1] == 'x')
-         {
-            typeUsage.mType = mTypeUInt32;
-            const uint32_t number = (uint32_t)strtoul(numberStr, nullptr, 16);
-            value.initOnStack(typeUsage, &mExecutionContext.mStack);
-            value.set(&number);
-         }
-         // invalid float
-         else if(numberStr[numberStrLength - 1u] == 'f')
-         {
-            throwCompileError(pContext, CompileError::InvalidNumericValue, numberStr);
-            return nullptr;
-         }
-         // signed
-         else
-         {
-            typeUsage.mType = mTypeInt32;
-            const int number = atoi(numberStr);
-            value.initOnStack(typeUsage, &mExecutionContext.mStack);
-            value.set(&number);
-         }
-      }
+void ExecutionProfile::beginCall(uint32_t pNode, uint64_t pTime)
+{
+   Frame frame;
+   frame.mNode = pNode;
+   frame.mStartTime = pTime;
+   mFrames.push_back(frame);
+}
 
-      expression = (ExpressionValue*)CflatMalloc(sizeof(ExpressionValue));
-      CflatInvokeCtor(ExpressionValue, expression)(value);
-   }
-   else if(token.mType == TokenType::Identifier)
-   {
-      // variable access / enum value
-      pContext.mStringBuffer.assign(token.mStart, token.mLength);
-      const Identifier identifier(pContext.mStringBuffer.c_str());
+void ExecutionProfile::endCall(uint64_t pTime)
+{
+   const Frame frame = mFrames.back();
+   mFrames.pop_back();
 
-      Instance* instance = retrieveInstance(pContext, identifier);
+   const uint64_t duration = pTime - frame.mStartTime;
 
-      if(instance && instance->mTypeUsage.mType)
-      {
-         if(CflatHasFlag(instance->mFlags, InstanceFlags::EnumValue))
-         {
-            expression = (ExpressionValue*)CflatMalloc(sizeof(ExpressionValue));
-            CflatInvokeCtor(ExpressionValue, expression)(instance->mValue);
-         }
-         else
-         {
-            expression = (ExpressionVariableAccess*)CflatMalloc(sizeof(ExpressionVariableAccess));
-            CflatInvokeCtor(ExpressionVariableAccess, expression)(identifier, instance->mTypeUsage);
-         }
-      }
-      else
-      {
-         throwCompileError(pContext, CompileError::UndefinedVariable, identifier.mName);
-      }
-   }
-   else if(token.mType == TokenType::Keyword)
+   Node& node = mNodes[frame.mNode];
+   node.mCallsCount++;
+   node.mInclusiveTime += duration;
+   mNodes[node.mParent].mChildrenTime += duration;
+
+   if(mTraceEvents.size() < kMaxTraceEvents)
    {
-      if(strncmp(token.mStart, "nullptr", 7u) == 0)
-      {
-         TypeUsage typeUsage = mTypeUsageVoidPtr;
-         CflatSetFlag(typeUsage.mFlags, TypeUsageFlags::Const);
+      TraceEvent traceEvent;
+      traceEvent.mNode = frame.mNode;
+      traceEvent.mStartTime = frame.mStartTime;
+      traceEvent.mDuration = duration;
+      mTraceEvents.push_back(traceEvent);
+   }
+}
 
-         expression = (ExpressionNullPointer*)CflatMalloc(sizeof(ExpressionNullPointer));
-         CflatInvokeCtor(ExpressionNullPointer, expression)(typeUsage);
-      }
-      else if(strncmp(token.mStart, "true", 4u) == 0)
-      {
-         Value value;
-         value.initOnStack(mTypeUsageBool, &mExecutionContext.mStack);
+void ExecutionProfile::reset()
+{
+   mNodes.clear();
+   mFrames.clear();
+   mTraceEvents.clear();
 
-         const bool boolValue = true;
-         value.set(&boolValue);
+   Node root;
+   root.mCallee = nullptr;
+   root.mParent = kInvalidNode;
+   root.mFirstChild = kInvalidNode;
+   root.mNextSibling = kInvalidNode;
+   root.mCallsCount = 0u;
+   root.mInclusiveTime = 0u;
+   root.mChildrenTime = 0u;
+   mNodes.push_back(root);
+}
 
-         expression = (ExpressionValue*)CflatMalloc(sizeof(ExpressionValue));
-         CflatInvokeCtor(ExpressionValue, expression)(value);
-      }
-      else if(strncmp(token.mStart, "false", 5u) == 0)
-      {
-         Value value;
-         value.initOnStack(mTypeUsageBool, &mExecutionContext.mStack);
 
-         const bool boolValue = false;
-         value.set(&boolValue);
+//
+//  ExecutionContext
+//
+ExecutionCounters::ExecutionCounters()
+   : mStatementsCount(0u)
+   , mExpressionsCount(0u)
+   , mScriptCallsCount(0u)
+   , mNativeCallsCount(0u)
+   , mOperatorOverloadCallsCount(0u)
+   , mNameLookupMissesCount(0u)
+   , mStackPeakBytes(0u)
+{
+}
 
-         expression = (ExpressionValue*)CflatMalloc(sizeof(ExpressionValue));
-         CflatInvokeCtor(ExpressionValue, expression)(value);
-      }
-   }
-   else if(token.mType == TokenType::String || token.mType == TokenType::WideString)
+void ExecutionCounters::add(const ExecutionCounters& pOther)
+{
+   mStatementsCount += pOther.mStatementsCount;
+   mExpressionsCount += pOther.mExpressionsCount;
+   mScriptCallsCount += pOther.mScriptCallsCount;
+   mNativeCallsCount += pOther.mNativeCallsCount;
+   mOperatorOverloadCallsCount += pOther.mOperatorOverloadCallsCount;
+   mNameLookupMissesCount += pOther.mNameLookupMissesCount;
+
+   // each context has its own stack
+   if(pOther.mStackPeakBytes > mStackPeakBytes)
    {
-      expression = parseExpressionLiteralString(pContext, token.mType);
+      mStackPeakBytes = pOther.mStackPeakBytes;
    }
-   else if(token.mType == TokenType::Character || token.mType == TokenType::WideCharacter)
+}
+
+
+//
+//  ExecutionContext
+//
+ExecutionContext::ExecutionContext(Namespace* pGlobalNamespace, CflatSTLString& pErrorMessage)
+   : Context(ContextType::Execution, pGlobalNamespace)
+   , mJumpStatement(JumpStatement::None)
+   , mErrorMessage(pErrorMessage)
+   , mProfile(nullptr)
+   , mResumableCall(nullptr)
+   , mCoroutine(nullptr)
+{
+}
+
+
+//
+//  ParallelWorker
+//
+Environment::ParallelWorker::ParallelWorker(Namespace* pGlobalNamespace)
+   : mContext(pGlobalNamespace, mErrorMessage)
+   , mRange(0u)
+{
+}
+
+
+//
+//  QueuedCall
+//
+QueuedCall::QueuedCall(Function* pFunction)
+   : mFunction(pFunction)
+   , mNext(nullptr)
+   , mReferences(2u)
+   , mDone(false)
+{
+}
+
+
+//
+//  CallFuture
+//
+CallFuture::CallFuture()
+   : mCall(nullptr)
+{
+}
+
+CallFuture::CallFuture(QueuedCall* pCall)
+   : mCall(pCall)
+{
+}
+
+CallFuture::CallFuture(const CallFuture& pOther)
+   : mCall(pOther.mCall)
+{
+   if(mCall)
    {
-      expression = parseExpressionLiteralCharacter(pContext, token.mType);
+      mCall->mReferences.fetch_add(1u, std::memory_order_relaxed);
    }
+}
 
-   return expression;
+CallFuture::~CallFuture()
+{
+   if(mCall)
+   {
+      release(mCall);
+   }
 }
 
-Expression* Environment::parseExpressionMultipleTokens(ParsingContext& pContext,
-   size_t pTokenFirstIndex, size_t pTokenLastIndex)
+CallFuture& CallFuture::operator=(const CallFuture& pOther)
 {
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t& tokenIndex = pContext.mTokenIndex;
-   const Token& token = tokens[tokenIndex];
-   Expression* expression = nullptr;
+   if(pOther.mCall)
+   {
+      pOther.mCall->mReferences.fetch_add(1u, std::memory_order_relaxed);
+   }
 
-   size_t assignmentOperatorTokenIndex = 0u;
-   size_t binaryOperatorTokenIndex = 0u;
-   uint8_t binaryOperatorPrecedence = 0u;
-   size_t memberAccessTokenIndex = 0u;
-   size_t conditionalTokenIndex = 0u;
+   if(mCall)
+   {
+      release(mCall);
+   }
 
-   uint32_t parenthesisLevel = tokens[pTokenLastIndex].mStart[0] == ')' ? 1u : 0u;
-   uint32_t squareBracketLevel = tokens[pTokenLastIndex].mStart[0] == ']' ? 1u : 0u;
-   uint32_t curlyBracketLevel = tokens[pTokenLastIndex].mStart[0] == '}' ? 1u : 0u;
-   uint32_t templateLevel = tokens[pTokenLastIndex].mStart[0] == '>' ? 1u : 0u;
+   mCall = pOther.mCall;
 
-   for(size_t i = pTokenLastIndex - 1u; i > tokenIndex; i--)
-   {
-      if(tokens[i].mLength == 1u)
-      {
-         if(tokens[i].mStart[0] == ')')
-         {
-            parenthesisLevel++;
-            continue;
-         }
-         else if(tokens[i].mStart[0] == '(')
-         {
-            parenthesisLevel--;
-            continue;
-         }
-         else if(tokens[i].mStart[0] == ']')
-         {
-            squareBracketLevel++;
-            continue;
-         }
-         else if(tokens[i].mStart[0] == '[')
-         {
-            squareBracketLevel--;
-            continue;
-         }
-         else if(tokens[i].mStart[0] == '}')
-         {
-            curlyBracketLevel++;
-            continue;
-         }
-         else if(tokens[i].mStart[0] == '{')
-         {
-            curlyBracketLevel--;
-            continue;
-         }
-         else if(tokens[i].mStart[0] == '>')
-         {
-            const size_t templateOpeningIndex = findOpeningTokenIndex(pContext, '<', '>', i);
-            const bool isTemplateClosure =
-               templateOpeningIndex < i && isTemplate(pContext, templateOpeningIndex, i);
+   return *this;
+}
 
-            if(isTemplateClosure)
-            {
-               templateLevel++;
-               continue;
-            }
-         }
-         else if(tokens[i].mStart[0] == '<')
-         {
-            const size_t cachedTokenIndex = tokenIndex;
-            tokenIndex = i;
-            const size_t templateClosureIndex =
-               findClosureTokenIndex(pContext, '<', '>', pTokenLastIndex - 1u);
-            tokenIndex = cachedTokenIndex;
+bool CallFuture::isValid() const
+{
+   return mCall != nullptr;
+}
 
-            const bool isTemplateOpening =
-               templateClosureIndex > i && isTemplate(pContext, i, templateClosureIndex);
+bool CallFuture::isReady() const
+{
+   CflatAssert(mCall);
+   return mCall->mDone.load(std::memory_order_acquire);
+}
 
-            if(isTemplateOpening)
-            {
-               templateLevel--;
-               continue;
-            }
-         }
-      }
+void CallFuture::wait() const
+{
+   CflatAssert(isReady() || !gProcessingQueuedCalls);
 
-      if(parenthesisLevel == 0u &&
-         squareBracketLevel == 0u &&
-         curlyBracketLevel == 0u &&
-         templateLevel == 0u)
-      {
-         if(i > tokenIndex &&
-            tokens[i].mType == TokenType::Operator &&
-            tokens[i - 1u].mType != TokenType::Operator)
-         {
-            if(tokens[i].mLength == 1u && tokens[i].mStart[0] == '?')
-            {
-               conditionalTokenIndex = i;
-            }
-            else
-            {
-               for(size_t j = 0u; j < kCflatAssignmentOperatorsCount; j++)
-               {
-                  const size_t operatorLength = strlen(kCflatAssignmentOperators[j]);
+   while(!isReady())
+   {
+      std::this_thread::yield();
+   }
+}
 
-                  if(tokens[i].mLength == operatorLength &&
-                     strncmp(tokens[i].mStart, kCflatAssignmentOperators[j], operatorLength) == 0)
-                  {
-                     assignmentOperatorTokenIndex = i;
-                     break;
-                  }
-               }
+const Value& CallFuture::getReturnValue() const
+{
+   wait();
+   return mCall->mReturnValue;
+}
 
-               if(assignmentOperatorTokenIndex == 0u)
-               {
-                  const uint8_t precedence = getBinaryOperatorPrecedence(pContext, i);
+const char* CallFuture::getErrorMessage() const
+{
+   wait();
+   return mCall->mErrorMessage.empty() ? nullptr : mCall->mErrorMessage.c_str();
+}
 
-                  if(precedence > binaryOperatorPrecedence)
-                  {
-                     binaryOperatorTokenIndex = i;
-                     binaryOperatorPrecedence = precedence;
-                  }
-               }
-            }
-         }
-         else if(tokens[i].mType == TokenType::Punctuation && memberAccessTokenIndex == 0u)
-         {
-            if(tokens[i].mStart[0] == '.' || strncmp(tokens[i].mStart, "->", 2u) == 0)
-            {
-               memberAccessTokenIndex = i;
-            }
-         }
-      }
+void CallFuture::release(QueuedCall* pCall)
+{
+   // the call is shared by the futures and the queue, and released by the last one
+   if(pCall->mReferences.fetch_sub(1u, std::memory_order_acq_rel) == 1u)
+   {
+      CflatInvokeDtor(QueuedCall, pCall);
+      CflatFree(pCall);
    }
+}
 
-   bool isCStyleCast = false;
-   TypeUsage cStyleCastTypeUsage;
 
-   if(tokens[tokenIndex].mStart[0] == '(')
-   {
-      const size_t cachedTokenIndex = tokenIndex;
-      tokenIndex++;
+//
+//  ExecutionBudget
+//
+ExecutionBudget::ExecutionBudget()
+   : mStatementsCount(0u)
+   , mTime(0u)
+{
+}
 
-      cStyleCastTypeUsage = parseTypeUsage(pContext, pTokenLastIndex - 1u);
-      isCStyleCast = cStyleCastTypeUsage.mType != nullptr && tokens[tokenIndex].mStart[0] == ')';
+ExecutionBudget::ExecutionBudget(uint64_t pStatementsCount, uint64_t pTime)
+   : mStatementsCount(pStatementsCount)
+   , mTime(pTime)
+{
+}
 
-      if(!isCStyleCast)
-      {
-         tokenIndex = cachedTokenIndex;
-      }
-   }
 
-   // C-style cast
-   if(isCStyleCast)
-   {
-      tokenIndex++;
-      Expression* expressionToCast = parseExpression(pContext, pTokenLastIndex);
+//
+//  ResumableCall
+//
+ResumableCall::ResumableCall(Environment* pEnvironment, Function* pFunction,
+   Namespace* pGlobalNamespace)
+   : mEnvironment(pEnvironment)
+   , mFunction(pFunction)
+   , mContext(pGlobalNamespace, mErrorMessage)
+   , mNativeState(nullptr)
+   , mStackSize(kCoroutineStackSize)
+   , mFinished(false)
+   , mAborting(false)
+   , mSliceStatementsCount(0u)
+   , mSliceStart(0u)
+   , mStatementsCount(0u)
+   , mResumesCount(0u)
+{
+}
 
-      expression = (ExpressionCast*)CflatMalloc(sizeof(ExpressionCast));
-      CflatInvokeCtor(ExpressionCast, expression)
-         (CastType::CStyle, cStyleCastTypeUsage, expressionToCast);
+ResumableCall::~ResumableCall()
+{
+   CflatAssert(!mNativeState);
+}
 
-      const TypeUsage& sourceTypeUsage = getTypeUsage(expressionToCast);
+bool ResumableCall::isFinished() const
+{
+   return mFinished;
+}
 
-      if(!isCastAllowed(CastType::CStyle, sourceTypeUsage, cStyleCastTypeUsage))
-      {
-         throwCompileError(pContext, CompileError::InvalidCast);
-      }
-   }
-   // assignment
-   else if(assignmentOperatorTokenIndex > 0u)
-   {
-      Expression* left = parseExpression(pContext, assignmentOperatorTokenIndex - 1u);
+uint32_t ResumableCall::getResumesCount() const
+{
+   return mResumesCount;
+}
 
-      if(left)
-      {
-         const TypeUsage& leftTypeUsage = getTypeUsage(left);
+uint64_t ResumableCall::getStatementsCount() const
+{
+   return mStatementsCount;
+}
 
-         if(!leftTypeUsage.isConst())
-         {
-            const Token& operatorToken = pContext.mTokens[assignmentOperatorTokenIndex];
-            CflatSTLString operatorStr(operatorToken.mStart, operatorToken.mLength);
+const Value& ResumableCall::getReturnValue() const
+{
+   CflatAssert(mFinished);
+   return mReturnValue;
+}
 
-            tokenIndex = assignmentOperatorTokenIndex + 1u;
-            Expression* right = parseExpression(pContext, pTokenLastIndex);
+const char* ResumableCall::getErrorMessage() const
+{
+   CflatAssert(mFinished);
+   return mErrorMessage.empty() ? nullptr : mErrorMessage.c_str();
+}
 
-            if(right)
-            {
-               expression = (ExpressionAssignment*)CflatMalloc(sizeof(ExpressionAssignment));
-               CflatInvokeCtor(ExpressionAssignment, expression)(left, right, operatorStr.c_str());
-            }
-            else
-            {
-               CflatInvokeDtor(Expression, left);
-               CflatFree(left);
-            }
 
-            tokenIndex = pTokenLastIndex + 1u;
-         }
-         else
-         {
-            throwCompileError(pContext, Environment::CompileError::CannotModifyConstExpression);
-         }
-      }
-   }
-   // conditional expression
-   else if(conditionalTokenIndex > 0u)
-   {
-      const size_t elseTokenIndex = findSeparationTokenIndex(pContext, ':', pTokenLastIndex);
+//
+//  Coroutine
+//
+Coroutine::Coroutine(Environment* pEnvironment, Function* pFunction, Namespace* pGlobalNamespace)
+   : mEnvironment(pEnvironment)
+   , mFunction(pFunction)
+   , mContext(pGlobalNamespace, mErrorMessage)
+   , mNativeState(nullptr)
+   , mStackSize(kCoroutineStackSize)
+   , mIndex(0u)
+   , mFinished(false)
+   , mAborting(false)
+   , mResumesCount(0u)
+{
+   mContext.mCoroutine = this;
+}
 
-      if(elseTokenIndex > 0u)
-      {
-         Expression* condition = parseExpression(pContext, conditionalTokenIndex - 1u);
-         tokenIndex = conditionalTokenIndex + 1u;
+Coroutine::~Coroutine()
+{
+   CflatAssert(!mNativeState);
+}
 
-         Expression* ifExpression = parseExpression(pContext, elseTokenIndex - 1u);
-         tokenIndex = elseTokenIndex + 1u;
+bool Coroutine::isFinished() const
+{
+   return mFinished;
+}
 
-         Expression* elseExpression = parseExpression(pContext, pTokenLastIndex);
-         tokenIndex = pTokenLastIndex + 1u;
+uint32_t Coroutine::getResumesCount() const
+{
+   return mResumesCount;
+}
 
-         expression = (ExpressionConditional*)CflatMalloc(sizeof(ExpressionConditional));
-         CflatInvokeCtor(ExpressionConditional, expression)(condition, ifExpression, elseExpression);
-      }
-      else
-      {
-         throwCompileError(pContext, CompileError::InvalidConditionalExpression);
-      }
-   }
-   // binary operator
-   else if(binaryOperatorTokenIndex > 0u)
-   {
-      Expression* left = parseExpression(pContext, binaryOperatorTokenIndex - 1u);
+const Value& Coroutine::getReturnValue() const
+{
+   CflatAssert(mFinished);
+   return mReturnValue;
+}
 
-      if(left)
-      {
-         const TypeUsage& leftTypeUsage = getTypeUsage(left);
+const char* Coroutine::getErrorMessage() const
+{
+   CflatAssert(mFinished);
+   return mErrorMessage.empty() ? nullptr : mErrorMessage.c_str();
+}
 
-         const Token& operatorToken = pContext.mTokens[binaryOperatorTokenIndex];
-         CflatSTLString operatorStr(operatorToken.mStart, operatorToken.mLength);
 
-         tokenIndex = binaryOperatorTokenIndex + 1u;
-         Expression* right = parseExpression(pContext, pTokenLastIndex);
+//
+//  ReadWriteLock
+//
+ReadWriteLock::ReadWriteLock()
+   : mReaders(0u)
+   , mWaitingWriters(0u)
+   , mWriter(false)
+{
+}
 
-         if(right)
-         {
-            bool operatorIsValid = true;
-            TypeUsage overloadedOperatorTypeUsage;
+void ReadWriteLock::lockShared()
+{
+   std::unique_lock<std::mutex> lock(mMutex);
 
-            if(!leftTypeUsage.isPointer() &&
-               leftTypeUsage.mType &&
-               leftTypeUsage.mType->mCategory == TypeCategory::StructOrClass)
-            {
-               const TypeUsage& rightTypeUsage = getTypeUsage(right);
-
-               if(rightTypeUsage.mType)
-               {
-                  CflatArgsVector(TypeUsage) args;
-                  args.push_back(rightTypeUsage);
-
-                  pContext.mStringBuffer.assign("operator");
-                  pContext.mStringBuffer.append(operatorStr);
-                  const Identifier operatorIdentifier(pContext.mStringBuffer.c_str());
-
-                  Struct* leftType = static_cast<Struct*>(leftTypeUsage.mType);
-                  Method* operatorMethod = leftType->findMethod(operatorIdentifier, args);
+   // waiting writers take precedence, so that readers cannot starve them
+   while(mWriter || mWaitingWriters > 0u)
+   {
+      mCondition.wait(lock);
+   }
 
-                  if(operatorMethod)
-                  {
-                     overloadedOperatorTypeUsage = operatorMethod->mReturnTypeUsage;
+   mReaders++;
+}
 
-                     if(!isMethodCallAllowed(operatorMethod, leftTypeUsage))
-                     {
-                        throwCompileError(pContext, CompileError::CannotCallNonConstMethod);
-                        operatorIsValid = false;
-                     }
-                  }
-                  else
-                  {
-                     args.insert(args.begin(), leftTypeUsage);
+void ReadWriteLock::unlockShared()
+{
+   std::unique_lock<std::mutex> lock(mMutex);
+   CflatAssert(mReaders > 0u);
+   mReaders--;
 
-                     Function* operatorFunction =
-                        leftTypeUsage.mType->mNamespace->getFunction(operatorIdentifier, args);
+   if(mReaders == 0u)
+   {
+      lock.unlock();
+      mCondition.notify_all();
+   }
+}
 
-                     if(!operatorFunction)
-                     {
-                        operatorFunction = findFunction(pContext, operatorIdentifier, args);
+void ReadWriteLock::lock()
+{
+   std::unique_lock<std::mutex> lock(mMutex);
+   mWaitingWriters++;
 
-                        if(!operatorFunction)
-                        {
-                           CflatSTLString typeFullName;
-                           getTypeFullName(leftTypeUsage.mType, &typeFullName);
+   while(mWriter || mReaders > 0u)
+   {
+      mCondition.wait(lock);
+   }
 
-                           throwCompileError(pContext, CompileError::InvalidOperator,
-                              typeFullName.c_str(), operatorStr.c_str());
-                           operatorIsValid = false;
-                        }
-                     }
+   mWaitingWriters--;
+   mWriter = true;
+}
 
-                     if(operatorFunction)
-                     {
-                        overloadedOperatorTypeUsage = operatorFunction->mReturnTypeUsage;
-                     }
-                  }
-               }
-            }
+void ReadWriteLock::unlock()
+{
+   std::unique_lock<std::mutex> lock(mMutex);
+   CflatAssert(mWriter);
+   mWriter = false;
 
-            if(operatorIsValid)
-            {
-               TypeUsage typeUsage;
+   lock.unlock();
+   mCondition.notify_all();
+}
 
-               if(overloadedOperatorTypeUsage.mType)
-               {
-                  typeUsage = overloadedOperatorTypeUsage;
-               }
-               else
-               {
-                  bool logicalOperator = false;
 
-                  for(size_t i = 0u; i < kCflatLogicalOperatorsCount; i++)
-                  {
-                     if(strcmp(operatorStr.c_str(), kCflatLogicalOperators[i]) == 0)
-                     {
-                        logicalOperator = true;
-                        break;
-                     }
-                  }
+//
+//  Environment
+//
+struct ParallelWorkerBinding
+{
+   const Environment* mEnvironment;
+   ExecutionContext* mContext;
+};
+static thread_local ParallelWorkerBinding gCurrentParallelWorker = { nullptr, nullptr };
 
-                  if(logicalOperator)
-                  {
-                     typeUsage = mTypeUsageBool;
-                  }
-                  else
-                  {
-                     const TypeUsage& rightTypeUsage = getTypeUsage(right);
+static thread_local const Environment::AccessScope* gCurrentAccessScope = nullptr;
 
-                     if(leftTypeUsage.mType->isInteger() && !rightTypeUsage.mType->isInteger())
-                     {
-                        typeUsage = rightTypeUsage;
-                     }
-                     else
-                     {
-                        typeUsage = leftTypeUsage;
-                     }
+Environment::AccessScope::AccessScope(const Environment* pEnvironment, AccessType pAccessType)
+   : mEnvironment(const_cast<Environment*>(pEnvironment))
+   , mPreviousScope(gCurrentAccessScope)
+   , mAccessType(pAccessType)
+   , mSharedLocked(false)
+   , mExclusiveLocked(false)
+   , mExecutionLocked(false)
+{
+   bool accessGranted = false;
+   bool executionGranted = false;
 
-                     CflatResetFlag(typeUsage.mFlags, TypeUsageFlags::Reference);
-                  }
-               }
+   for(const AccessScope* scope = mPreviousScope; scope; scope = scope->mPreviousScope)
+   {
+      if(scope->mEnvironment == mEnvironment)
+      {
+         // the shared lock held by an enclosing scope cannot be upgraded
+         CflatAssert(mAccessType != AccessType::Write || scope->mAccessType == AccessType::Write);
 
-               expression =
-                  (ExpressionBinaryOperation*)CflatMalloc(sizeof(ExpressionBinaryOperation));
-               CflatInvokeCtor(ExpressionBinaryOperation, expression)
-                  (left, right, operatorStr.c_str(), typeUsage);
-            }
-            else
-            {
-               CflatInvokeDtor(Expression, left);
-               CflatFree(left);
-               CflatInvokeDtor(Expression, right);
-               CflatFree(right);
-            }
-         }
-         else
-         {
-            CflatInvokeDtor(Expression, left);
-            CflatFree(left);
-         }
+         accessGranted = true;
+         executionGranted |= scope->mAccessType != AccessType::Read;
       }
-
-      tokenIndex = pTokenLastIndex + 1u;
    }
-   // unary operator
-   else if(tokens[pTokenFirstIndex].mType == TokenType::Operator ||
-      tokens[pTokenLastIndex].mType == TokenType::Operator)
-   {
-      size_t operatorTokenIndex;
-      size_t operandExpressionTokenFirstIndex;
-      size_t operandExpressionTokenLastIndex;
-      bool postOperator;
 
-      if(tokens[pTokenLastIndex].mType == TokenType::Operator)
+   if(!accessGranted)
+   {
+      if(mAccessType == AccessType::Write)
       {
-         operatorTokenIndex = pTokenLastIndex;
-         operandExpressionTokenFirstIndex = pTokenFirstIndex;
-         operandExpressionTokenLastIndex = pTokenLastIndex - 1u;
-         postOperator = true;
+         mEnvironment->mAccessLock.lock();
+         mExclusiveLocked = true;
+         executionGranted = true;
       }
       else
       {
-         operatorTokenIndex = pTokenFirstIndex;
-         operandExpressionTokenFirstIndex = pTokenFirstIndex + 1u;
-         operandExpressionTokenLastIndex = pTokenLastIndex;
-         postOperator = false;
+         mEnvironment->mAccessLock.lockShared();
+         mSharedLocked = true;
       }
+   }
 
-      pContext.mTokenIndex = operandExpressionTokenFirstIndex;
-      Expression* operandExpression = parseExpression(pContext, operandExpressionTokenLastIndex);
+   if(mAccessType == AccessType::Execute && !executionGranted)
+   {
+      mEnvironment->mExecutionMutex.lock();
+      mExecutionLocked = true;
+   }
 
-      if(operandExpression)
-      {
-         const Token& operatorToken = tokens[operatorTokenIndex];
+   gCurrentAccessScope = this;
+}
 
-         char operatorStr[kSmallLocalStringBufferSize];
-         strncpy(operatorStr, operatorToken.mStart, operatorToken.mLength);
-         operatorStr[operatorToken.mLength] = '\0';
+Environment::AccessScope::AccessScope(const Environment* pEnvironment,
+   const AccessScope* pGrantingScope)
+   : mEnvironment(const_cast<Environment*>(pEnvironment))
+   , mPreviousScope(gCurrentAccessScope)
+   , mAccessType(pGrantingScope->mAccessType)
+   , mSharedLocked(false)
+   , mExclusiveLocked(false)
+   , mExecutionLocked(false)
+{
+   CflatAssert(pGrantingScope->mEnvironment == mEnvironment);
+   gCurrentAccessScope = this;
+}
 
-         expression =
-            parseExpressionUnaryOperator(pContext, operandExpression, operatorStr, postOperator);
-      }
+Environment::AccessScope::~AccessScope()
+{
+   CflatAssert(gCurrentAccessScope == this);
+   gCurrentAccessScope = mPreviousScope;
+
+   if(mExecutionLocked)
+   {
+      mEnvironment->mExecutionMutex.unlock();
    }
-   // member access
-   else if(memberAccessTokenIndex > 0u)
+
+   if(mExclusiveLocked)
    {
-      if(tokens[memberAccessTokenIndex + 1u].mType == TokenType::Identifier)
-      {
-         Expression* memberOwner = parseExpression(pContext, memberAccessTokenIndex - 1u);
-         tokenIndex = memberAccessTokenIndex + 1u;
+      mEnvironment->mWriteAccessGeneration++;
+      mEnvironment->mAccessLock.unlock();
+   }
+   else if(mSharedLocked)
+   {
+      mEnvironment->mAccessLock.unlockShared();
+   }
+}
 
-         if(memberOwner &&
-            memberOwner->getTypeUsage().mType &&
-            memberOwner->getTypeUsage().mType->mCategory == TypeCategory::StructOrClass)
-         {
-            pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
-            const Identifier memberIdentifier(pContext.mStringBuffer.c_str());
+// Innermost allocation-free scope on the current thread
+static thread_local Environment::AllocationFreeScope* gCurrentAllocationFreeScope = nullptr;
+// Set while an allocation gets recorded, so that the ones made in the process are not
+static thread_local bool gRecordingAllocation = false;
 
-            const bool isMemberAccess = tokens[memberAccessTokenIndex].mStart[0] == '.';
-            const bool isPtrMemberAccess =
-               !isMemberAccess && strncmp(tokens[memberAccessTokenIndex].mStart, "->", 2u) == 0;
+Environment::AllocationFreeScope::AllocationFreeScope(Environment* pEnvironment,
+   bool pAssertOnAllocation)
+   : mEnvironment(pEnvironment)
+   , mPreviousScope(gCurrentAllocationFreeScope)
+   , mAllocationsCount(0u)
+   , mAssertOnAllocation(pAssertOnAllocation)
+{
+   CflatAssert(pEnvironment->isAllocationTrackingEnabled());
+   gCurrentAllocationFreeScope = this;
+}
 
-            bool memberAccessIsValid = true;
+Environment::AllocationFreeScope::~AllocationFreeScope()
+{
+   CflatAssert(gCurrentAllocationFreeScope == this);
+   gCurrentAllocationFreeScope = mPreviousScope;
+}
 
-            const TypeUsage& ownerTypeUsage = getTypeUsage(memberOwner);
+uint32_t Environment::AllocationFreeScope::getAllocationsCount() const
+{
+   return mAllocationsCount;
+}
 
-            bool isMethodCall = false;
-            Member* member = nullptr;
+Environment::AllocationReport::AllocationReport()
+   : mAllocationsCount(0u)
+   , mBytes(0u)
+{
+}
 
-            if((tokenIndex + 1u) < tokens.size())
-            {
-               isMethodCall = tokens[tokenIndex + 1u].mStart[0] == '(';
+Environment::MemoryStats::MemoryStats()
+   : mIdentifierPoolBytes(0u)
+   , mLiteralStringsPoolBytes(0u)
+   , mLiteralWideStringsPoolBytes(0u)
+   , mTypesCount(0u)
+   , mFunctionsCount(0u)
+   , mMethodsCount(0u)
+   , mStackBytes(0u)
+   , mStackPeakBytes(0u)
+{
+}
 
-               if(!isMethodCall)
-               {
-                  tokenIndex++;
-                  isMethodCall = isTemplate(pContext, pTokenLastIndex);
-                  tokenIndex--;
-               }
+Environment::Environment()
+   : Environment(*Memory::getDefaultAllocator())
+{
+}
+
+Environment::Environment(const Memory::Allocator& pAllocator)
+   : mAllocator(pAllocator.mMalloc, pAllocator.mFree, pAllocator.mUserData, &mMemoryStats)
+   , mAllocatorBeforeConstruction(Memory::setCurrentAllocator(&mAllocator))
+   , mWriteAccessGeneration(0u)
+   , mSettings(0u)
+   , mMacrosGeneration(0u)
+   , mRegistrationGeneration(0u)
+   , mQueuedCalls(nullptr)
+   , mParallelJob(nullptr)
+   , mParallelJobGeneration(0u)
+   , mParallelShutdown(false)
+   , mLoadBatch(nullptr)
+   , mLoadBatchGeneration(0u)
+   , mLoadShutdown(false)
+   , mLocalStatics(nullptr)
+   , mExecutionContext(&mGlobalNamespace, mErrorMessage)
+   , mTypeUsageParsingContext(&mGlobalNamespace)
+   , mGlobalNamespace("", nullptr, this)
+   , mExecutionHook(nullptr)
+   , mCompiledExpressionsMacrosGeneration(0u)
+   , mCompiledExpressionsRegistrationGeneration(0u)
+   , mProfilingStartTime(0u)
+   , mProfilingEnabled(false)
+   , mLineCountingEnabled(false)
+   , mAllocationTrackingEnabled(false)
+{
+   static_assert(kPreprocessorErrorStringsCount == (size_t)Environment::PreprocessorError::Count,
+      "Missing preprocessor error strings");
+   static_assert(kCompileErrorStringsCount == (size_t)Environment::CompileError::Count,
+      "Missing compile error strings");
+   static_assert(kRuntimeErrorStringsCount == (size_t)Environment::RuntimeError::Count,
+      "Missing runtime error strings");
 
-               if(!isMethodCall)
-               {
-                  Struct* type = static_cast<Struct*>(ownerTypeUsage.mType);
-                  member = type->findMember(memberIdentifier);
+   registerBuiltInTypes();
 
-                  if(!member)
-                  {
-                     CflatSTLString typeFullName;
-                     getTypeFullName(type, &typeFullName);
+   mTypeAuto = registerType<BuiltInType>("auto");
+   mTypeVoid = registerType<BuiltInType>("void");
+   mTypeInt32 = getType("int");
+   mTypeUInt32 = getType("uint32_t");
+   mTypeFloat = getType("float");
+   mTypeDouble = getType("double");
 
-                     throwCompileError(pContext, CompileError::MissingMember,
-                        memberIdentifier.mName, typeFullName.c_str());
-                     memberAccessIsValid = false;
-                  }
-               }
-            }
+   mTypeUsageVoid = getTypeUsage("void");
+   mTypeUsageSizeT = getTypeUsage("size_t");
+   mTypeUsageBool = getTypeUsage("bool");
+   mTypeUsageCString = getTypeUsage("const char*");
+   mTypeUsageWideString = getTypeUsage("const wchar_t*");
+   mTypeUsageCharacter = getTypeUsage("const char");
+   mTypeUsageWideCharacter = getTypeUsage("const wchar_t");
+   mTypeUsageVoidPtr = getTypeUsage("void*");
 
-            if(memberAccessIsValid)
-            {
-               if(ownerTypeUsage.isPointer())
-               {
-                  if(!isPtrMemberAccess)
-                  {
-                     throwCompileError(pContext, CompileError::InvalidMemberAccessOperatorPtr,
-                        memberIdentifier.mName);
-                     memberAccessIsValid = false;
-                  }
-               }
-               else
-               {
-                  if(isPtrMemberAccess)
-                  {
-                     throwCompileError(pContext, CompileError::InvalidMemberAccessOperatorNonPtr,
-                        memberIdentifier.mName);
-                     memberAccessIsValid = false;
-                  }
-               }
-            }
+   {
+      // suspends the coroutine being executed
+      Function* function = registerFunction("yield");
+      function->execute = [this](const CflatArgsVector(Value)&, Value*)
+      {
+         yieldCoroutine();
+      };
+   }
 
-            if(memberAccessIsValid)
-            {
-               ExpressionMemberAccess* memberAccess =
-                  (ExpressionMemberAccess*)CflatMalloc(sizeof(ExpressionMemberAccess));
-               CflatInvokeCtor(ExpressionMemberAccess, memberAccess)(memberOwner, memberIdentifier);
-               expression = memberAccess;
+   Memory::setCurrentAllocator(mAllocatorBeforeConstruction);
+}
 
-               // method call
-               if(isMethodCall)
-               {
-                  expression = parseExpressionMethodCall(pContext, memberAccess);
+Environment::~Environment()
+{
+   AccessScope accessScope(this, AccessType::Write);
+   Memory::AllocatorScope allocatorScope(&mAllocator);
 
-                  if(expression)
-                  {
-                     Method* method =
-                        static_cast<ExpressionMethodCall*>(expression)->mMethodUsage.mMethod;
+   mAllocator.mHook = nullptr;
 
-                     if(method)
-                     {
-                        memberAccess->mMemberAccessType = MemberAccessType::Method;
-                        memberAccess->assignTypeUsage(method->mReturnTypeUsage);
+   releaseCoroutines();
+   releaseResumableCalls();
+   releaseParallelWorkers();
+   releaseLoadWorkers();
+   discardQueuedCalls();
+   releaseCompiledExpressions();
+   releaseProfiles();
+   releaseLocalStatics();
+   releaseRetiredPrograms();
+   mGlobalNamespace.releaseInstances(0, true);
 
-                        if(!isMethodCallAllowed(method, ownerTypeUsage))
-                        {
-                           throwCompileError(pContext, CompileError::CannotCallNonConstMethod);
-                        }
-                     }
-                  }
-               }
-               else if(member)
-               {
-                  memberAccess->mMemberAccessType = (MemberAccessType)member->mMemberType;
-                  memberAccess->assignTypeUsage(member->mTypeUsage);
-               }
-            }
-         }
-      }
-      else
+   for(ProgramsRegistry::iterator it = mPrograms.begin(); it != mPrograms.end(); it++)
+   {
+      CflatInvokeDtor(Program, it->second);
+      CflatFree(it->second);
+   }
+}
+
+const Memory::Allocator* Environment::getAllocator() const
+{
+   return &mAllocator;
+}
+
+void Environment::getMemoryStats(MemoryStats* pOutStats) const
+{
+   CflatAssert(pOutStats);
+
+   AccessScope accessScope(this, AccessType::Read);
+
+   mMemoryStats.getStats(&pOutStats->mHeap);
+
+   pOutStats->mPrograms.clear();
+
+   for(ProgramsRegistry::const_iterator it = mPrograms.begin(); it != mPrograms.end(); it++)
+   {
+      MemoryStats::ProgramEntry entry;
+      entry.mProgram = it->second;
+      entry.mUsage = it->second->mMemoryUsage;
+      pOutStats->mPrograms.push_back(entry);
+   }
+
+   const Identifier::NamesRegistry* namesRegistry = Identifier::getNamesRegistry();
+   pOutStats->mIdentifierPoolBytes = (size_t)(namesRegistry->mPointer - namesRegistry->mMemory);
+   pOutStats->mLiteralStringsPoolBytes =
+      (size_t)(mLiteralStringsPool.mPointer - mLiteralStringsPool.mMemory);
+   pOutStats->mLiteralWideStringsPoolBytes =
+      (size_t)(mLiteralWideStringsPool.mPointer - mLiteralWideStringsPool.mMemory) * sizeof(wchar_t);
+
+   CflatSTLVector(Type*) types;
+   mGlobalNamespace.getAllTypes(&types, true);
+   pOutStats->mTypesCount = types.size();
+   pOutStats->mMethodsCount = 0u;
+
+   CflatSTLVector(Function*) functions;
+   mGlobalNamespace.getAllFunctions(&functions, true);
+   pOutStats->mFunctionsCount = functions.size();
+
+   for(size_t i = 0u; i < types.size(); i++)
+   {
+      if(types[i]->mCategory == TypeCategory::StructOrClass)
       {
-         tokenIndex = memberAccessTokenIndex;
-         throwCompileErrorUnexpectedSymbol(pContext);
+         const Struct* type = static_cast<const Struct*>(types[i]);
+         pOutStats->mMethodsCount += type->mMethods.size();
+         pOutStats->mFunctionsCount += type->mFunctionsHolder.getFunctionsCount();
       }
    }
-   // parenthesized expression
-   else if(tokens[tokenIndex].mStart[0] == '(')
+
+   CflatSTLVector(Instance*) instances;
+   mGlobalNamespace.getAllInstances(&instances, true);
+   pOutStats->mGlobalValues = Memory::Usage();
+
+   for(size_t i = 0u; i < instances.size(); i++)
    {
-      const size_t closureTokenIndex = findClosureTokenIndex(pContext, '(', ')', pTokenLastIndex);
-      tokenIndex++;
+      const Value& value = instances[i]->mValue;
 
-      if(closureTokenIndex > tokenIndex)
+      if(value.mValueBufferType == ValueBufferType::Heap)
       {
-         Expression* innerExpression = parseExpression(pContext, closureTokenIndex - 1u);
+         pOutStats->mGlobalValues.mBytes += value.mTypeUsage.getSize();
+         pOutStats->mGlobalValues.mAllocations++;
+      }
+   }
 
-         if(innerExpression)
-         {
-            expression = (ExpressionParenthesized*)CflatMalloc(sizeof(ExpressionParenthesized));
-            CflatInvokeCtor(ExpressionParenthesized, expression)(innerExpression);
-         }
+   pOutStats->mLocalStaticValues = Memory::Usage();
 
-         tokenIndex = closureTokenIndex + 1u;
-      }
-      else
+   for(const StatementVariableDeclaration* statement = mLocalStatics;
+      statement; statement = statement->mNextStatic)
+   {
+      pOutStats->mLocalStaticValues.mBytes += statement->mStaticValue.mTypeUsage.getSize();
+      pOutStats->mLocalStaticValues.mAllocations++;
+   }
+
+   const EnvironmentStack& stack = mExecutionContext.mStack;
+   pOutStats->mStackBytes = (size_t)(stack.mPointer - stack.mMemory);
+   pOutStats->mStackPeakBytes = (size_t)(stack.mPeakPointer - stack.mMemory);
+}
+
+void Environment::getLoadStats(LoadStats* pOutStats) const
+{
+   AccessScope accessScope(this, AccessType::Read);
+   CflatAssert(pOutStats);
+
+   pOutStats->mPrograms.clear();
+   pOutStats->mTotal = ProgramLoadStats();
+
+   for(ProgramsRegistry::const_iterator it = mPrograms.begin(); it != mPrograms.end(); it++)
+   {
+      LoadStats::ProgramEntry entry;
+      entry.mProgram = it->second;
+      entry.mStats = it->second->mLoadStats;
+      pOutStats->mPrograms.push_back(entry);
+
+      pOutStats->mTotal.add(entry.mStats);
+   }
+
+   std::sort(pOutStats->mPrograms.begin(), pOutStats->mPrograms.end(),
+      [](const LoadStats::ProgramEntry& pA, const LoadStats::ProgramEntry& pB)
       {
-         throwCompileErrorUnexpectedSymbol(pContext);
-      }
+         return pA.mStats.getTotalTime() > pB.mStats.getTotalTime();
+      });
+}
+
+void Environment::addSetting(Settings pSetting)
+{
+   CflatSetFlag(mSettings, pSetting);
+}
+
+void Environment::removeSetting(Settings pSetting)
+{
+   CflatResetFlag(mSettings, pSetting);
+}
+
+void Environment::setProgramCacheDirectory(const char* pDirectoryPath)
+{
+   AccessScope accessScope(this, AccessType::Write);
+   Memory::AllocatorScope allocatorScope(&mAllocator);
+
+   if(pDirectoryPath)
+   {
+      mProgramCacheDirectory.assign(pDirectoryPath);
    }
-   // array initialization
-   else if(tokens[tokenIndex].mStart[0] == '{')
+   else
+   {
+      mProgramCacheDirectory.clear();
+   }
+}
+
+void Environment::defineMacro(const char* pDefinition, const char* pBody)
+{
+   AccessScope accessScope(this, AccessType::Write);
+   Memory::AllocatorScope allocatorScope(&mAllocator);
+
+   mMacrosLock.lock();
+   mMacros.defineMacro(pDefinition, pBody);
+   mMacrosGeneration++;
+   mMacrosLock.unlock();
+}
+
+void Environment::registerBuiltInTypes()
+{
+   CflatRegisterBuiltInType(this, int);
+   CflatRegisterBuiltInType(this, uint32_t);
+   CflatRegisterBuiltInType(this, size_t);
+   CflatRegisterBuiltInType(this, char);
+   CflatRegisterBuiltInType(this, bool);
+   CflatRegisterBuiltInType(this, uint8_t);
+   CflatRegisterBuiltInType(this, short);
+   CflatRegisterBuiltInType(this, wchar_t);
+   CflatRegisterBuiltInType(this, uint16_t);
+   CflatRegisterBuiltInType(this, int64_t);
+   CflatRegisterBuiltInType(this, uint64_t);
+   CflatRegisterBuiltInType(this, float);
+   CflatRegisterBuiltInType(this, double);
+
+   CflatRegisterBuiltInTypedef(this, int32_t, int);
+   CflatRegisterBuiltInTypedef(this, int8_t, char);
+   CflatRegisterBuiltInTypedef(this, int16_t, short);
+}
+
+TypeUsage Environment::parseTypeUsage(ParsingContext& pContext, size_t pTokenLastIndex) const
+{
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t& tokenIndex = pContext.mTokenIndex;
+   size_t cachedTokenIndex = tokenIndex;
+
+   TypeUsage typeUsage;
+   char baseTypeName[kDefaultLocalStringBufferSize];
+
+   if(tokens[tokenIndex].mType == TokenType::Keyword &&
+      strncmp(tokens[tokenIndex].mStart, "const", 5u) == 0)
    {
+      CflatSetFlag(typeUsage.mFlags, TypeUsageFlags::Const);
       tokenIndex++;
+   }
 
-      ExpressionArrayInitialization* arrayInitialization =
-         (ExpressionArrayInitialization*)CflatMalloc(sizeof(ExpressionArrayInitialization));
-      CflatInvokeCtor(ExpressionArrayInitialization, arrayInitialization)();
-      expression = arrayInitialization;
+   pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
 
-      const size_t closureIndex = findClosureTokenIndex(pContext, '{', '}', pTokenLastIndex);
+   while(tokenIndex < (tokens.size() - 1u) &&
+      tokens[tokenIndex + 1u].mLength == 2u &&
+      strncmp(tokens[tokenIndex + 1u].mStart, "::", 2u) == 0)
+   {
+      tokenIndex += 2u;
+      pContext.mStringBuffer.append("::");
+      pContext.mStringBuffer.append(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
+   }
 
-      while(tokenIndex < closureIndex)
-      {
-         const size_t separatorIndex = findSeparationTokenIndex(pContext, ',', closureIndex);
-         const size_t lastArrayValueIndex = separatorIndex > 0u
-            ? separatorIndex - 1u
-            : closureIndex - 1u;
+   strcpy(baseTypeName, pContext.mStringBuffer.c_str());
+   const Identifier baseTypeIdentifier(baseTypeName);
+   CflatArgsVector(TypeUsage) templateTypes;
+   bool anyInvalidTemplateType = false;
 
-         Expression* arrayValueExpression = parseExpression(pContext, lastArrayValueIndex);
-         arrayInitialization->mValues.push_back(arrayValueExpression);
+   if(tokenIndex < (tokens.size() - 1u) && tokens[tokenIndex + 1u].mStart[0] == '<')
+   {
+      tokenIndex += 2u;
+      const size_t closureTokenIndex = findClosureTokenIndex(pContext, '<', '>');
 
-         if(arrayInitialization->mElementTypeUsage.mType)
+      if((pTokenLastIndex == 0u || closureTokenIndex <= pTokenLastIndex) &&
+         isTemplate(pContext, tokenIndex - 1u, closureTokenIndex))
+      {
+         while(tokenIndex < closureTokenIndex)
          {
-            const TypeHelper::Compatibility compatibility = TypeHelper::getCompatibility(
-               arrayValueExpression->getTypeUsage(), arrayInitialization->mElementTypeUsage);
+            const TypeUsage templateTypeUsage = parseTypeUsage(pContext, closureTokenIndex - 1u);
 
-            if(compatibility == TypeHelper::Compatibility::Incompatible)
+            if(!templateTypeUsage.mType)
             {
-               throwCompileError(pContext, Environment::CompileError::NonHomogeneousTypeList);
+               anyInvalidTemplateType = true;
                break;
             }
-         }
-         else
-         {
-            arrayInitialization->mElementTypeUsage = arrayValueExpression->getTypeUsage();
+
+            templateTypes.push_back(templateTypeUsage);
+            tokenIndex++;
          }
 
-         tokenIndex = lastArrayValueIndex + 2u;
+         tokenIndex = closureTokenIndex;
       }
-
-      arrayInitialization->assignTypeUsage();
    }
-   // array element access / operator[]
-   else if(tokens[pTokenLastIndex].mStart[0] == ']')
-   {
-      const size_t openingIndex = findOpeningTokenIndex(pContext, '[', ']', pTokenLastIndex);
 
-      if(pTokenLastIndex > (openingIndex + 1u))
+   if(!anyInvalidTemplateType)
+   {   
+      for(size_t i = 0u; i < pContext.mTypeAliases.size(); i++)
       {
-         Expression* arrayAccess = parseExpression(pContext, openingIndex - 1u);
-
-         if(arrayAccess)
+         if(pContext.mTypeAliases[i].mIdentifier == baseTypeIdentifier)
          {
-            tokenIndex = openingIndex + 1u;
-            Expression* arrayElementIndex = parseExpression(pContext, pTokenLastIndex - 1u);
+            typeUsage = pContext.mTypeAliases[i].mTypeUsage;
+            break;
+         }
+      }
 
-            TypeUsage typeUsage = getTypeUsage(arrayAccess);
+      if(!typeUsage.mType)
+      {
+         for(int i = (int)pContext.mLocalNamespaceStack.size() - 1; i >= 0; i--)
+         {
+            Namespace* ns = pContext.mLocalNamespaceStack[i].mNamespace;
+            typeUsage.mType = ns->getType(baseTypeIdentifier, templateTypes);
 
-            if(typeUsage.isArray() || typeUsage.isPointer())
+            if(typeUsage.mType)
             {
-               if(typeUsage.isArray())
-               {
-                  CflatResetFlag(typeUsage.mFlags, TypeUsageFlags::Array);
-                  typeUsage.mArraySize = 1u;
-               }
-               else
-               {
-                  typeUsage.mPointerLevel--;
-               }
-
-               expression =
-                  (ExpressionArrayElementAccess*)CflatMalloc(sizeof(ExpressionArrayElementAccess));
-               CflatInvokeCtor(ExpressionArrayElementAccess, expression)
-                  (arrayAccess, arrayElementIndex, typeUsage);
+               break;
             }
-            else if(typeUsage.mType->mCategory == TypeCategory::StructOrClass)
-            {
-               Struct* type = static_cast<Struct*>(typeUsage.mType);
-               const Identifier operatorMethodID("operator[]");
-               Method* operatorMethod = type->findMethod(operatorMethodID);
-
-               if(operatorMethod)
-               {
-                  ExpressionMemberAccess* memberAccess =
-                     (ExpressionMemberAccess*)CflatMalloc(sizeof(ExpressionMemberAccess));
-                  CflatInvokeCtor(ExpressionMemberAccess, memberAccess)
-                     (arrayAccess, operatorMethodID);
-                  memberAccess->assignTypeUsage(operatorMethod->mReturnTypeUsage);
+         }
+      }
 
-                  ExpressionMethodCall* methodCall =
-                     (ExpressionMethodCall*)CflatMalloc(sizeof(ExpressionMethodCall));
-                  CflatInvokeCtor(ExpressionMethodCall, methodCall)(memberAccess);
-                  expression = methodCall;
+      if(!typeUsage.mType)
+      {
+         for(int i = (int)pContext.mNamespaceStack.size() - 1; i >= 0; i--)
+         {
+            Namespace* ns = pContext.mNamespaceStack[i];
+            const TypeAlias* typeAlias = ns->getTypeAlias(baseTypeIdentifier);
 
-                  methodCall->mArguments.push_back(arrayElementIndex);
-                  methodCall->mMethodUsage.mMethod = operatorMethod;
-                  methodCall->assignTypeUsage(mTypeUsageVoid);
-               }
-               else
-               {
-                  throwCompileErrorUnexpectedSymbol(pContext);
-               }
-            }
-            else
+            if(typeAlias)
             {
-               throwCompileErrorUnexpectedSymbol(pContext);
+               typeUsage = typeAlias->mTypeUsage;
+               break;
             }
-
-            tokenIndex = pTokenLastIndex + 1u;
          }
-         else
+
+         if(!typeUsage.mType)
          {
-            throwCompileErrorUnexpectedSymbol(pContext);
+            typeUsage.mType = findType(pContext, baseTypeIdentifier, templateTypes);
          }
       }
-      else
-      {
-         throwCompileErrorUnexpectedSymbol(pContext);
-      }
    }
-   else if(token.mType == TokenType::Identifier)
-   {
-      pContext.mStringBuffer.assign(token.mStart, token.mLength);
 
-      while(tokenIndex < (tokens.size() - 1u) && strncmp(tokens[++tokenIndex].mStart, "::", 2u) == 0)
+   if(typeUsage.mType)
+   {
+      while(tokenIndex < (tokens.size() - 1u) && *tokens[tokenIndex + 1u].mStart == '*')
       {
+         typeUsage.mPointerLevel++;
          tokenIndex++;
-         pContext.mStringBuffer.append("::");
-         pContext.mStringBuffer.append(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
       }
 
-      const Identifier fullIdentifier(pContext.mStringBuffer.c_str());
-      bool isFunctionCall = tokens[tokenIndex].mStart[0] == '(';
+      if(typeUsage.mPointerLevel > 0u && typeUsage.isConst())
+      {
+         CflatResetFlag(typeUsage.mFlags, TypeUsageFlags::Const);
+         CflatSetFlag(typeUsage.mFlags, TypeUsageFlags::ConstPointer);
+      }
 
-      TypeUsage templateTypeUsage;
-         
-      if(!isFunctionCall && isTemplate(pContext, pTokenLastIndex))
+      if(tokenIndex < (tokens.size() - 1u) && *tokens[tokenIndex + 1u].mStart == '&')
       {
-         const size_t templateClosureIndex =
-            findClosureTokenIndex(pContext, '<', '>', pTokenLastIndex);
-         isFunctionCall =
-            templateClosureIndex > 0u && tokens[templateClosureIndex + 1u].mStart[0] == '(';
+         CflatSetFlag(typeUsage.mFlags, TypeUsageFlags::Reference);
+         tokenIndex++;
+      }
 
-         if(isFunctionCall)
-         {
-            pContext.mTokenIndex = pTokenFirstIndex;
-            templateTypeUsage = parseTypeUsage(pContext, templateClosureIndex);
+      tokenIndex++;
 
-            if(!templateTypeUsage.mType)
-            {
-               pContext.mTokenIndex++;
-            }
-         }
+      if(tokenIndex < tokens.size() &&
+         typeUsage.mPointerLevel > 0u &&
+         tokens[tokenIndex].mType == TokenType::Keyword &&
+         strncmp(tokens[tokenIndex].mStart, "const", 5u) == 0)
+      {
+         CflatSetFlag(typeUsage.mFlags, TypeUsageFlags::Const);
+         tokenIndex++;
       }
+   }
+   else
+   {
+      tokenIndex = cachedTokenIndex;
+   }
 
-      // function call / object construction
-      if(isFunctionCall)
+   return typeUsage;
+}
+
+void Environment::throwPreprocessorError(ParsingContext& pContext, PreprocessorError pError,
+   size_t pCursor, const char* pArg)
+{
+   char errorMsg[kDefaultLocalStringBufferSize];
+   snprintf(errorMsg, sizeof(errorMsg), kPreprocessorErrorStrings[(int)pError], pArg);
+
+   const char* code = pContext.mProgram->mCode.c_str();
+   uint16_t line = 1u;
+
+   for(size_t i = 0u; i < pCursor; i++)
+   {
+      if(code[i] == '\n')
       {
-         Type* type = templateTypeUsage.mType
-            ? templateTypeUsage.mType
-            : findType(pContext, fullIdentifier);
-         expression = type
-            ? parseExpressionObjectConstruction(pContext, type)
-            : parseExpressionFunctionCall(pContext, fullIdentifier);
+         line++;
       }
-      // aggregate initialization
-      else if(tokens[tokenIndex].mStart[0] == '{')
+   }
+
+   char lineAsString[kSmallLocalStringBufferSize];
+   snprintf(lineAsString, sizeof(lineAsString), "%d", line);
+
+   pContext.mErrorMessage.assign("[Preprocessor Error] '");
+   pContext.mErrorMessage.append(pContext.mProgram ? pContext.mProgram->mIdentifier.mName : "");
+   pContext.mErrorMessage.append("' -- Line ");
+   pContext.mErrorMessage.append(lineAsString);
+   pContext.mErrorMessage.append(": ");
+   pContext.mErrorMessage.append(errorMsg);
+}
+
+void Environment::throwCompileError(ParsingContext& pContext, CompileError pError,
+   const char* pArg1, const char* pArg2)
+{
+   if(!pContext.mErrorMessage.empty())
+      return;
+
+   const Token& token = pContext.mTokenIndex < pContext.mTokens.size()
+      ? pContext.mTokens[pContext.mTokenIndex]
+      : pContext.mTokens[pContext.mTokens.size() - 1u];
+
+   char errorMsg[kDefaultLocalStringBufferSize];
+   snprintf(errorMsg, sizeof(errorMsg), kCompileErrorStrings[(int)pError], pArg1, pArg2);
+
+   char lineAsString[kSmallLocalStringBufferSize];
+   snprintf(lineAsString, sizeof(lineAsString), "%d", token.mLine);
+
+   pContext.mErrorMessage.assign("[Compile Error] '");
+   // expressions evaluated out of any program get compiled without one
+   pContext.mErrorMessage.append(pContext.mProgram ? pContext.mProgram->mIdentifier.mName : "");
+   pContext.mErrorMessage.append("' -- Line ");
+   pContext.mErrorMessage.append(lineAsString);
+   pContext.mErrorMessage.append(": ");
+   pContext.mErrorMessage.append(errorMsg);
+}
+
+void Environment::throwCompileErrorUnexpectedSymbol(ParsingContext& pContext)
+{
+   const Token& token = pContext.mTokens[pContext.mTokenIndex];
+   pContext.mStringBuffer.assign(token.mStart, token.mLength);
+   throwCompileError(pContext, CompileError::UnexpectedSymbol, pContext.mStringBuffer.c_str());
+}
+
+void Environment::preprocess(ParsingContext& pContext, const char* pCode)
+{
+   // Comments and preprocessor directives are handled and macros are expanded while the code
+   // gets tokenized, in a single pass. Tokens reference the given code, which must outlive
+   // them, or the macro expansions held by the context.
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   tokens.clear();
+
+   pContext.mObjectLikeMacroExpansions.clear();
+
+   mMacrosLock.lockShared();
+   pContext.mMacrosGeneration = mMacrosGeneration;
+
+   const char* cursor = pCode;
+   uint16_t currentLine = 1u;
+
+   while(*cursor != '\0')
+   {
+      cursor = Tokenizer::skipWhitespace(cursor, &currentLine);
+
+      if(*cursor == '\0')
       {
-         Type* type = findType(pContext, fullIdentifier);
+         break;
+      }
 
-         if(type)
+      // line comment
+      if(cursor[0] == '/' && cursor[1] == '/')
+      {
+         while(*cursor != '\n' && *cursor != '\0')
          {
-            expression = parseExpressionAggregateInitialization(pContext, type, pTokenLastIndex);
+            cursor++;
          }
+
+         continue;
       }
-      // variable access with namespace / static member access
-      else
+
+      // block comment
+      if(cursor[0] == '/' && cursor[1] == '*')
       {
-         Instance* variableInstance = retrieveInstance(pContext, fullIdentifier);
-         Instance* enumInstance = nullptr;
+         cursor += 2u;
 
-         if(!variableInstance)
+         while(*cursor != '\0' && !(cursor[0] == '*' && cursor[1] == '/'))
          {
-            const char* lastSeparator = fullIdentifier.findLastSeparator();
-
-            if(lastSeparator)
+            if(*cursor == '\n')
             {
-               char buffer[kDefaultLocalStringBufferSize];
-               const size_t containerIdentifierLength = lastSeparator - fullIdentifier.mName;
-               strncpy(buffer, fullIdentifier.mName, containerIdentifierLength);
-               buffer[containerIdentifierLength] = '\0';
-               const Identifier containerIdentifier(buffer);
-               const Identifier memberIdentifier(lastSeparator + 2);
+               currentLine++;
+            }
 
-               Type* type = findType(pContext, containerIdentifier);
+            cursor++;
+         }
 
-               if(type)
-               {
-                  if(type->mCategory == TypeCategory::StructOrClass)
-                  {
-                     variableInstance =
-                        static_cast<Struct*>(type)->mInstancesHolder.retrieveInstance(memberIdentifier);
+         if(*cursor != '\0')
+         {
+            cursor += 2u;
+         }
 
-                     if(!variableInstance)
-                     {
-                        CflatSTLString typeFullName;
-                        getTypeFullName(type, &typeFullName);
+         continue;
+      }
 
-                        throwCompileError(pContext, Environment::CompileError::MissingStaticMember,
-                           memberIdentifier.mName, typeFullName.c_str());
-                     }
-                  }
-                  else if(type->mCategory == TypeCategory::Enum)
-                  {
-                     enumInstance =
-                        static_cast<Enum*>(type)->mInstancesHolder.retrieveInstance(memberIdentifier);
-                  }
-                  else if(type->mCategory == TypeCategory::EnumClass)
-                  {
-                     enumInstance =
-                        static_cast<EnumClass*>(type)->mInstancesHolder.retrieveInstance(memberIdentifier);
-                  }
-               }
-            }
-         }
+      // preprocessor directive
+      if(*cursor == '#')
+      {
+         cursor++;
 
-         if(variableInstance)
+         while(*cursor == ' ' || *cursor == '\t')
          {
-            expression = (ExpressionVariableAccess*)CflatMalloc(sizeof(ExpressionVariableAccess));
-            CflatInvokeCtor(ExpressionVariableAccess, expression)
-               (fullIdentifier, variableInstance->mTypeUsage);
+            cursor++;
          }
-         else if(enumInstance)
+
+         // #include (valid, but ignored)
+         if(strncmp(cursor, "include", 7u) == 0)
          {
-            expression = (ExpressionValue*)CflatMalloc(sizeof(ExpressionValue));
-            CflatInvokeCtor(ExpressionValue, expression)(enumInstance->mValue);
+            cursor += 7u;
          }
-         else
+         // #ifdef (valid, but ignored)
+         else if(strncmp(cursor, "ifdef", 5u) == 0)
          {
-            throwCompileError(pContext, Environment::CompileError::UndefinedType,
-               fullIdentifier.mName);
+            cursor += 5u;
          }
-      }
-   }
-   else if(token.mType == TokenType::Keyword)
-   {
-      if(strncmp(token.mStart, "sizeof", 6u) == 0)
-      {
-         if(tokens[tokenIndex + 1u].mStart[0] == '(')
+         // #if (valid, but ignored)
+         else if(strncmp(cursor, "if", 2u) == 0)
          {
-            tokenIndex++;
-            const size_t closureTokenIndex =
-               findClosureTokenIndex(pContext, '(', ')', pTokenLastIndex);
-            tokenIndex++;
+            cursor += 2u;
+         }
+         // #pragma (valid, but ignored)
+         else if(strncmp(cursor, "pragma", 6u) == 0)
+         {
+            cursor += 6u;
+         }
+         // #define
+         else if(strncmp(cursor, "define", 6u) == 0)
+         {
+            cursor += 6u;
 
-            ExpressionSizeOf* concreteExpression =
-               (ExpressionSizeOf*)CflatMalloc(sizeof(ExpressionSizeOf));
-            CflatInvokeCtor(ExpressionSizeOf, concreteExpression)(mTypeUsageSizeT);
-            expression = concreteExpression;
+            if(*cursor != ' ' && *cursor != '\t')
+            {
+               throwPreprocessorError(pContext, PreprocessorError::InvalidPreprocessorDirective,
+                  cursor - pCode);
+               break;
+            }
 
-            concreteExpression->mSizeOfTypeUsage = parseTypeUsage(pContext, closureTokenIndex - 1u);
+            while(*cursor == ' ' || *cursor == '\t')
+            {
+               cursor++;
+            }
 
-            if(!concreteExpression->mSizeOfTypeUsage.mType)
+            if(*cursor == '\n' || *cursor == '\0')
             {
-               concreteExpression->mSizeOfExpression = parseExpression(pContext, closureTokenIndex - 1u);
+               throwPreprocessorError(pContext, PreprocessorError::InvalidPreprocessorDirective,
+                  cursor - pCode);
+               break;
             }
 
-            tokenIndex = closureTokenIndex;
+            char macroDefinition[kDefaultLocalStringBufferSize];
+            size_t macroCursor = 0u;
+
+            while(*cursor != ' ' &&
+               *cursor != '\t' &&
+               *cursor != '\n' &&
+               *cursor != '\0')
+            {
+               if(*cursor == '(')
+               {
+                  while(*cursor != ')')
+                  {
+                     macroDefinition[macroCursor++] = *cursor++;
+                  }
+               }
+               macroDefinition[macroCursor++] = *cursor++;
+            }
+
+            macroDefinition[macroCursor] = '\0';
+
+            while(*cursor == ' ' || *cursor == '\t')
+            {
+               cursor++;
+            }
+
+            char macroBody[kDefaultLocalStringBufferSize];
+            macroCursor = 0u;
+
+            while(*cursor != '\n' && *cursor != '\r' && *cursor != '\0')
+            {
+               macroBody[macroCursor++] = *cursor++;
+            }
+
+            macroBody[macroCursor] = '\0';
+
+            pContext.mMacros.defineMacro(macroDefinition, macroBody);
+
+            // the macros of the code might have been moved or redefined
+            pContext.mObjectLikeMacroExpansions.clear();
          }
          else
          {
-            throwCompileErrorUnexpectedSymbol(pContext);
+            throwPreprocessorError(pContext, PreprocessorError::InvalidPreprocessorDirective,
+               cursor - pCode);
+            break;
          }
+
+         while(*cursor != '\n' && *cursor != '\0')
+         {
+            cursor++;
+         }
+
+         continue;
       }
-      else if(strncmp(token.mStart, "static_cast", 11u) == 0)
-      {
-         tokenIndex++;
-         expression = parseExpressionCast(pContext, CastType::Static, pTokenLastIndex);
-      }
-      else if(strncmp(token.mStart, "dynamic_cast", 12u) == 0)
+
+      Token token;
+      token.mLine = currentLine;
+      cursor = Tokenizer::scanToken(cursor, &token);
+
+      const Macro* macro = nullptr;
+
+      if(token.mType == TokenType::Identifier || token.mType == TokenType::Keyword)
       {
-         tokenIndex++;
-         expression = parseExpressionCast(pContext, CastType::Dynamic, pTokenLastIndex);
+         // macros defined by the code itself take precedence, since they are defined later
+         macro = pContext.mMacros.getMacro(token.mStart, token.mLength);
+
+         if(!macro)
+         {
+            macro = mMacros.getMacro(token.mStart, token.mLength);
+         }
       }
-      else if(strncmp(token.mStart, "reinterpret_cast", 16u) == 0)
+
+      if(!macro)
       {
-         tokenIndex++;
-         expression = parseExpressionCast(pContext, CastType::Reinterpret, pTokenLastIndex);
+         tokens.push_back(token);
+         continue;
       }
-      else if(strncmp(token.mStart, "const_cast", 10u) == 0)
+
+      // object-like macros have their expansion tokenized already, and the tokens of all
+      // their uses reference the same copy of it
+      if(macro->mExpansionCached && *cursor != '(')
       {
-         tokenIndex++;
-         expression = parseExpressionCast(pContext, CastType::Const, pTokenLastIndex);
-      }
-   }
-   else if(token.mType == TokenType::String || token.mType == TokenType::WideString)
-   {
-      expression = parseExpressionLiteralString(pContext, token.mType);
-   }
-   else if(token.mType == TokenType::Character || token.mType == TokenType::WideCharacter)
-   {
-      expression = parseExpressionLiteralCharacter(pContext, token.mType);
-   }
+         char*& expansion = pContext.mObjectLikeMacroExpansions[(uintptr_t)macro];
 
-   return expression;
-}
+         if(!expansion)
+         {
+            pContext.mMacroExpansions.emplace_back(macro->mExpansion);
+            expansion = const_cast<char*>(pContext.mMacroExpansions.back().c_str());
+         }
 
-Expression* Environment::parseExpressionLiteralString(ParsingContext& pContext, TokenType pTokenType)
-{
-   pContext.mStringBuffer.clear();
+         for(size_t j = 0u; j < macro->mExpansionTokens.size(); j++)
+         {
+            const MacroToken& macroToken = macro->mExpansionTokens[j];
+
+            Token expansionToken;
+            expansionToken.mType = macroToken.mType;
+            expansionToken.mStart = expansion + macroToken.mOffset;
+            expansionToken.mLength = (size_t)macroToken.mLength;
+            expansionToken.mLine = (uint16_t)(currentLine + macroToken.mLineOffset);
+            tokens.push_back(expansionToken);
+         }
 
-   const size_t firstIndex = pTokenType == TokenType::String ? 1u : 2u;
+         continue;
+      }
 
-   do
-   {
-      const Token& token = pContext.mTokens[pContext.mTokenIndex];
+      // perform macro replacement
+      const char* invocationEnd = cursor;
 
-      for(size_t i = firstIndex; i < (token.mLength - 1u); i++)
+      if(macro->mParametersCount > 0u)
       {
-         const char currentChar = *(token.mStart + i);
-
-         if(currentChar == '\\')
+         while(*cursor == ' ' || *cursor == '\n')
          {
-            const char escapeChar = *(token.mStart + i + 1u);
+            cursor++;
+         }
+      }
 
-            if(escapeChar == 'n')
+      // parse arguments
+      CflatSTLVector(CflatSTLString) arguments;
+
+      if(*cursor == '(')
+      {
+         int parenthesisLevel = 1;
+
+         arguments.emplace_back();
+         cursor++;
+
+         while(parenthesisLevel > 0 && *cursor != '\0')
+         {
+            if(*cursor == '(')
             {
-               pContext.mStringBuffer.push_back('\n');
+               parenthesisLevel++;
             }
-            else if(escapeChar == '\\')
+            else if(*cursor == ')')
             {
-               pContext.mStringBuffer.push_back('\\');
+               parenthesisLevel--;
+               if(parenthesisLevel == 0)
+               {
+                  break;
+               }
             }
-            else if(escapeChar == 't')
+
+            if(*cursor == '"')
             {
-               pContext.mStringBuffer.push_back('\t');
+               do
+               {
+                  arguments.back().push_back(*cursor);
+                  cursor++;
+               }
+               while(*cursor != '\0' && !(*cursor == '"' && *(cursor - 1) != '\\'));
+
+               if(*cursor != '\0')
+               {
+                  arguments.back().push_back(*cursor);
+                  cursor++;
+               }
             }
-            else if(escapeChar == 'r')
+            else if(*cursor == ',')
             {
-               pContext.mStringBuffer.push_back('\r');
+               arguments.emplace_back();
+               cursor++;
+
+               while(*cursor == ' ' || *cursor == '\n')
+               {
+                  cursor++;
+               }
             }
-            else if(escapeChar == '"')
+            else
             {
-               pContext.mStringBuffer.push_back('\"');
+               arguments.back().push_back(*cursor);
+               cursor++;
             }
-            else if(escapeChar == '\'')
+         }
+
+         if(*cursor == ')')
+         {
+            cursor++;
+         }
+      }
+
+      // build the replaced code
+      pContext.mMacroExpansions.emplace_back();
+      CflatSTLString& expansion = pContext.mMacroExpansions.back();
+
+      for(size_t j = 0u; j < macro->mBody.size(); j++)
+      {
+         const CflatSTLString& bodyChunk = macro->mBody[j];
+
+         if(bodyChunk[0] == '$')
+         {
+            const size_t parameterIndex = (size_t)(bodyChunk[1] - '1');
+
+            if(parameterIndex >= arguments.size())
             {
-               pContext.mStringBuffer.push_back('\'');
+               throwPreprocessorError(pContext, PreprocessorError::InvalidMacroArgumentCount,
+                  cursor - pCode, macro->mName.c_str());
+               break;
             }
-            else if(escapeChar == '0')
+
+            const MacroArgumentType argumentType = (MacroArgumentType)(bodyChunk[2] - '0');
+
+            if(argumentType == MacroArgumentType::Stringize)
             {
-               pContext.mStringBuffer.push_back('\0');
+               expansion.push_back('\"');
+               expansion.append(arguments[parameterIndex]);
+               expansion.push_back('\"');
             }
             else
             {
-               pContext.mStringBuffer.clear();
-               pContext.mStringBuffer.push_back(escapeChar);
-               
-               throwCompileError(pContext, CompileError::InvalidEscapeSequence,
-                  pContext.mStringBuffer.c_str());
-               
-               return nullptr;
+               expansion.append(arguments[parameterIndex]);
             }
-
-            i++;
          }
          else
          {
-            pContext.mStringBuffer.push_back(currentChar);
+            expansion.append(bodyChunk);
          }
       }
 
-      pContext.mTokenIndex++;
-   }
-   while(pContext.mTokenIndex < pContext.mTokens.size() &&
-      pContext.mTokens[pContext.mTokenIndex].mType == pTokenType);
+      if(!pContext.mErrorMessage.empty())
+      {
+         break;
+      }
 
-   pContext.mStringBuffer.push_back('\0');
+      // tokenize the replaced code, which is not expanded any further
+      const char* expansionCursor = expansion.c_str();
+      uint16_t expansionLine = currentLine;
 
-   const Hash stringHash = hash(pContext.mStringBuffer.c_str());
-   Value value;
+      while(*expansionCursor != '\0')
+      {
+         expansionCursor = Tokenizer::skipWhitespace(expansionCursor, &expansionLine);
 
-   if(pTokenType == TokenType::String)
-   {
-      const char* string =
-         mLiteralStringsPool.registerString(stringHash, pContext.mStringBuffer.c_str());
+         if(*expansionCursor == '\0')
+         {
+            break;
+         }
 
-      value.initOnStack(mTypeUsageCString, &mExecutionContext.mStack);
-      value.set(&string);
-   }
-   else
-   {
-      const wchar_t* string =
-         mLiteralWideStringsPool.registerString(stringHash, pContext.mStringBuffer.c_str());
+         Token expansionToken;
+         expansionToken.mLine = expansionLine;
+         expansionCursor = Tokenizer::scanToken(expansionCursor, &expansionToken);
+         tokens.push_back(expansionToken);
+      }
 
-      value.initOnStack(mTypeUsageWideString, &mExecutionContext.mStack);
-      value.set(&string);
+      for(const char* invocationCursor = invocationEnd; invocationCursor < cursor; invocationCursor++)
+      {
+         if(*invocationCursor == '\n')
+         {
+            currentLine++;
+         }
+      }
    }
 
-   ExpressionValue* expression = (ExpressionValue*)CflatMalloc(sizeof(ExpressionValue));
-   CflatInvokeCtor(ExpressionValue, expression)(value);
+   mMacrosLock.unlockShared();
 
-   return expression;
+   pContext.mTokensIndex.build(tokens);
 }
 
-Expression* Environment::parseExpressionLiteralCharacter(ParsingContext& pContext, TokenType pTokenType)
+void Environment::parse(ParsingContext& pContext)
 {
-   const Token& token = pContext.mTokens[pContext.mTokenIndex];
-   const size_t expectedTokenSize = pTokenType == TokenType::Character ? 3u : 4u;
+   size_t& tokenIndex = pContext.mTokenIndex;
 
-   if(token.mLength != expectedTokenSize)
+   for(tokenIndex = 0u; tokenIndex < pContext.mTokens.size(); tokenIndex++)
    {
-      throwCompileErrorUnexpectedSymbol(pContext);
-      return nullptr;
-   }
-
-   Value value;
+      Statement* statement = parseStatement(pContext);
 
-   if(pTokenType == TokenType::Character)
-   {
-      const char character = token.mStart[1];
+      // statements left incomplete by an error get released along with the program
+      if(statement)
+      {
+         pContext.mProgram->mStatements.push_back(statement);
+      }
 
-      value.initOnStack(mTypeUsageCharacter, &mExecutionContext.mStack);
-      value.set(&character);
+      if(!pContext.mErrorMessage.empty())
+      {
+         break;
+      }
    }
-   else
+}
+
+Expression* Environment::parseExpression(ParsingContext& pContext, size_t pTokenLastIndex,
+   bool pNullAllowed)
+{
+   Expression* expression = nullptr;
+
+   const size_t tokensCount = pTokenLastIndex - pContext.mTokenIndex + 1u;
+
+   if(tokensCount != 0u)
    {
-      const wchar_t character = (wchar_t)token.mStart[2];
+      if(tokensCount == 1u)
+      {
+         expression = parseExpressionSingleToken(pContext);
+      }
+      else
+      {
+         expression = parseExpressionMultipleTokens(pContext, pContext.mTokenIndex, pTokenLastIndex);
+      }
+   }
 
-      value.initOnStack(mTypeUsageWideCharacter, &mExecutionContext.mStack);
-      value.set(&character);
+   if(!pNullAllowed && !expression)
+   {
+      throwCompileErrorUnexpectedSymbol(pContext);
    }
 
-   ExpressionValue* expression = (ExpressionValue*)CflatMalloc(sizeof(ExpressionValue));
-   CflatInvokeCtor(ExpressionValue, expression)(value);
+   if(expression && !pContext.mErrorMessage.empty())
+   {
+      CflatInvokeDtor(Expression, expression);
+      CflatFree(expression);
+      expression = nullptr;
+   }
 
    return expression;
 }
 
-Expression* Environment::parseExpressionUnaryOperator(ParsingContext& pContext, Expression* pOperand,
-   const char* pOperator, bool pPostOperator)
+Expression* Environment::parseExpressionSingleToken(ParsingContext& pContext)
 {
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t& tokenIndex = pContext.mTokenIndex;
+   const Token& token = tokens[tokenIndex];
    Expression* expression = nullptr;
-   bool validOperation = true;
-
-   const TypeUsage& operandTypeUsage = getTypeUsage(pOperand);
-
-   Method* operatorMethod = nullptr;
-   Function* operatorFunction = nullptr;
-   TypeUsage overloadedOperatorTypeUsage;
 
-   if(operandTypeUsage.mType &&
-      operandTypeUsage.mType->mCategory == TypeCategory::StructOrClass &&
-      !operandTypeUsage.isPointer())
+   if(token.mType == TokenType::Number)
    {
-      pContext.mStringBuffer.assign("operator");
-      pContext.mStringBuffer.append(pOperator);
+      TypeUsage typeUsage;
+      Value value;
 
-      Struct* operandType = static_cast<Struct*>(operandTypeUsage.mType);
-      const Identifier operatorIdentifier(pContext.mStringBuffer.c_str());
-      operatorMethod = operandType->findMethod(operatorIdentifier, TypeUsage::kEmptyList());
-      
-      if(operatorMethod)
+      pContext.mStringBuffer.assign(token.mStart, token.mLength);
+      const char* numberStr = pContext.mStringBuffer.c_str();
+      const size_t numberStrLength = strlen(numberStr);
+
+      // decimal value
+      if(strchr(numberStr, '.'))
       {
-         if(isMethodCallAllowed(operatorMethod, operandTypeUsage))
+         // float
+         if(numberStr[numberStrLength - 1u] == 'f')
          {
-            overloadedOperatorTypeUsage = operatorMethod->mReturnTypeUsage;
+            typeUsage.mType = mTypeFloat;
+
+            char* endPtr = nullptr;
+            const float number = strtof(numberStr, &endPtr);
+
+            if(endPtr != (numberStr + token.mLength - 1))
+            {
+               throwCompileError(pContext, CompileError::InvalidNumericValue, numberStr);
+               return nullptr;
+            }
+
+            value.initOnStack(typeUsage, &pContext.mStack);
+            value.set(&number);
          }
+         // double
          else
          {
-            validOperation = false;
-            throwCompileError(pContext, CompileError::CannotCallNonConstMethod);
-         }
-      }
-      else
-      {
-         CflatArgsVector(TypeUsage) parameterTypes;
-         parameterTypes.push_back(operandTypeUsage);
+            typeUsage.mType = mTypeDouble;
 
-         operatorFunction =
-            operandTypeUsage.mType->mNamespace->getFunction(operatorIdentifier, parameterTypes);
+            char* endPtr = nullptr;
+            const double number = strtod(numberStr, &endPtr);
 
-         if(!operatorFunction)
-         {
-            operatorFunction = findFunction(pContext, operatorIdentifier, parameterTypes);
-         }
+            if(endPtr != (numberStr + token.mLength))
+            {
+               throwCompileError(pContext, CompileError::InvalidNumericValue, numberStr);
+               return nullptr;
+            }
 
-         if(operatorFunction)
-         {
-            overloadedOperatorTypeUsage = operatorFunction->mReturnTypeUsage;
+            value.initOnStack(typeUsage, &pContext.mStack);
+            value.set(&number);
          }
       }
-   }
-
-   if(!operatorMethod && !operatorFunction)
-   {
-      const bool isIncrementOrDecrement =
-         strncmp(pOperator, "++", 2u) == 0 ||
-         strncmp(pOperator, "--", 2u) == 0;
-
-      if(isIncrementOrDecrement)
+      // integer value
+      else
       {
-         if(operandTypeUsage.isConst())
+         // unsigned
+         if(numberStr[numberStrLength - 1u] == 'u')
          {
-            throwCompileError(pContext, Environment::CompileError::CannotModifyConstExpression);
-            validOperation = false;
+            typeUsage.mType = mTypeUInt32;
+            const uint32_t number = (uint32_t)atoi(numberStr);
+            value.initOnStack(typeUsage, &pContext.mStack);
+            value.set(&number);
          }
-      }
-   }
-
-   if(validOperation)
-   {
-      TypeUsage typeUsage;
-
-      if(overloadedOperatorTypeUsage.mType)
-      {
-         typeUsage = overloadedOperatorTypeUsage;
-      }
-      else
-      {
-         typeUsage = pOperator[0] == '!'
-            ? mTypeUsageBool
-            : getTypeUsage(pOperand);
-         CflatResetFlag(typeUsage.mFlags, TypeUsageFlags::Reference);
-
-         if(pOperator[0] == '&')
+         // hex
+         else if(numberStr[0] == '0' && numberStr[1] == 'x')
          {
-            typeUsage.mPointerLevel++;
+            typeUsage.mType = mTypeUInt32;
+            const uint32_t number = (uint32_t)strtoul(numberStr, nullptr, 16);
+            value.initOnStack(typeUsage, &pContext.mStack);
+            value.set(&number);
          }
-         else if(pOperator[0] == '*')
+         // invalid float
+         else if(numberStr[numberStrLength - 1u] == 'f')
          {
-            typeUsage.mPointerLevel--;
+            throwCompileError(pContext, CompileError::InvalidNumericValue, numberStr);
+            return nullptr;
+         }
+         // signed
+         else
+         {
+            typeUsage.mType = mTypeInt32;
+            const int number = atoi(numberStr);
+            value.initOnStack(typeUsage, &pContext.mStack);
+            value.set(&number);
          }
       }
 
-      expression = (ExpressionUnaryOperation*)CflatMalloc(sizeof(ExpressionUnaryOperation));
-      CflatInvokeCtor(ExpressionUnaryOperation, expression)
-         (pOperand, pOperator, pPostOperator, typeUsage);
+      expression = (ExpressionValue*)CflatMalloc(sizeof(ExpressionValue));
+      CflatInvokeCtor(ExpressionValue, expression)(value);
    }
-
-   return expression;
-}
-
-Expression* Environment::parseExpressionCast(ParsingContext& pContext, CastType pCastType,
-   size_t pTokenLastIndex)
-{
-   if(pCastType == CastType::Dynamic && CflatHasFlag(mSettings, Settings::DisallowDynamicCast))
+   else if(token.mType == TokenType::Identifier)
    {
-      throwCompileError(pContext, CompileError::DynamicCastNotAllowed);
-      return nullptr;
-   }
-
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t& tokenIndex = pContext.mTokenIndex;
-   Expression* expression = nullptr;
+      // variable access / enum value
+      pContext.mStringBuffer.assign(token.mStart, token.mLength);
+      const Identifier identifier(pContext.mStringBuffer.c_str());
 
-   if(tokens[tokenIndex].mStart[0] == '<')
-   {
-      tokenIndex++;
-      const TypeUsage targetTypeUsage = parseTypeUsage(pContext, pTokenLastIndex - 1u);
+      Instance* instance = retrieveInstance(pContext, identifier);
 
-      if(targetTypeUsage.mType)
+      if(instance && instance->mTypeUsage.mType)
       {
-         if(tokens[tokenIndex].mStart[0] == '>')
+         if(CflatHasFlag(instance->mFlags, InstanceFlags::EnumValue))
          {
-            tokenIndex++;
+            expression = (ExpressionValue*)CflatMalloc(sizeof(ExpressionValue));
+            CflatInvokeCtor(ExpressionValue, expression)(instance->mValue);
+         }
+         else
+         {
+            ExpressionVariableAccess* variableAccess =
+               (ExpressionVariableAccess*)CflatMalloc(sizeof(ExpressionVariableAccess));
+            CflatInvokeCtor(ExpressionVariableAccess, variableAccess)(identifier, instance->mTypeUsage);
 
-            if(tokens[tokenIndex].mStart[0] == '(')
+            if(CflatHasFlag(instance->mFlags, InstanceFlags::LocalStatic))
             {
-               const size_t closureTokenIndex =
-                  findClosureTokenIndex(pContext, '(', ')', pTokenLastIndex);
-
-               if(closureTokenIndex > 0u)
+               for(size_t i = pContext.mRegisteredInstances.size(); i > 0u; i--)
                {
-                  tokenIndex++;
-
-                  Expression* expressionToCast =
-                     parseExpression(pContext, closureTokenIndex - 1u);
+                  const ParsingContext::RegisteredInstance& registeredInstance =
+                     pContext.mRegisteredInstances[i - 1u];
 
-                  if(expressionToCast)
+                  if(registeredInstance.mInstance == instance)
                   {
-                     const TypeUsage& sourceTypeUsage = getTypeUsage(expressionToCast);
-
-                     if(isCastAllowed(pCastType, sourceTypeUsage, targetTypeUsage))
-                     {
-                        expression = (ExpressionCast*)CflatMalloc(sizeof(ExpressionCast));
-                        CflatInvokeCtor(ExpressionCast, expression)
-                           (pCastType, targetTypeUsage, expressionToCast);
-                     }
-                     else
-                     {
-                        throwCompileError(pContext, CompileError::InvalidCast);
-                     }
+                     variableAccess->mStaticValue = &registeredInstance.mStaticDeclaration->mStaticValue;
+                     break;
                   }
                }
-               else
-               {
-                  tokenIndex = pTokenLastIndex - 1u;
-                  throwCompileErrorUnexpectedSymbol(pContext);
-               }
-            }
-            else
-            {
-               throwCompileErrorUnexpectedSymbol(pContext);
             }
+
+            expression = variableAccess;
          }
       }
       else
       {
-         throwCompileErrorUnexpectedSymbol(pContext);
+         throwCompileError(pContext, CompileError::UndefinedVariable, identifier.mName);
       }
    }
-   else
+   else if(token.mType == TokenType::Keyword)
    {
-      throwCompileErrorUnexpectedSymbol(pContext);
-   }
+      if(strncmp(token.mStart, "nullptr", 7u) == 0)
+      {
+         TypeUsage typeUsage = mTypeUsageVoidPtr;
+         CflatSetFlag(typeUsage.mFlags, TypeUsageFlags::Const);
 
-   return expression;
-}
+         expression = (ExpressionNullPointer*)CflatMalloc(sizeof(ExpressionNullPointer));
+         CflatInvokeCtor(ExpressionNullPointer, expression)(typeUsage);
+      }
+      else if(strncmp(token.mStart, "true", 4u) == 0)
+      {
+         Value value;
+         value.initOnStack(mTypeUsageBool, &pContext.mStack);
 
-Expression* Environment::parseExpressionFunctionCall(ParsingContext& pContext,
-   const Identifier& pFunctionIdentifier)
-{
-   ExpressionFunctionCall* expression =
-      (ExpressionFunctionCall*)CflatMalloc(sizeof(ExpressionFunctionCall));
-   CflatInvokeCtor(ExpressionFunctionCall, expression)(pFunctionIdentifier);
+         const bool boolValue = true;
+         value.set(&boolValue);
 
-   parseFunctionCallArguments(pContext, &expression->mArguments, &expression->mTemplateTypes);
+         expression = (ExpressionValue*)CflatMalloc(sizeof(ExpressionValue));
+         CflatInvokeCtor(ExpressionValue, expression)(value);
+      }
+      else if(strncmp(token.mStart, "false", 5u) == 0)
+      {
+         Value value;
+         value.initOnStack(mTypeUsageBool, &pContext.mStack);
 
-   if(!mErrorMessage.empty())
+         const bool boolValue = false;
+         value.set(&boolValue);
+
+         expression = (ExpressionValue*)CflatMalloc(sizeof(ExpressionValue));
+         CflatInvokeCtor(ExpressionValue, expression)(value);
+      }
+   }
+   else if(token.mType == TokenType::String || token.mType == TokenType::WideString)
    {
-      return nullptr;
+      expression = parseExpressionLiteralString(pContext, token.mType);
    }
-
-   CflatArgsVector(TypeUsage) argumentTypes;
-
-   for(size_t i = 0u; i < expression->mArguments.size(); i++)
+   else if(token.mType == TokenType::Character || token.mType == TokenType::WideCharacter)
    {
-      const TypeUsage& typeUsage = getTypeUsage(expression->mArguments[i]);
-      argumentTypes.push_back(typeUsage);
+      expression = parseExpressionLiteralCharacter(pContext, token.mType);
    }
 
-   CflatArgsVector(TypeUsage) templateTypes;
-   toArgsVector(expression->mTemplateTypes, templateTypes);
-
-   expression->mFunction = findFunction(pContext, pFunctionIdentifier, argumentTypes, templateTypes);
+   return expression;
+}
 
-   if(!expression->mFunction)
-   {
-      const char* lastSeparator = pFunctionIdentifier.findLastSeparator();
+Expression* Environment::parseExpressionMultipleTokens(ParsingContext& pContext,
+   size_t pTokenFirstIndex, size_t pTokenLastIndex)
+{
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t& tokenIndex = pContext.mTokenIndex;
+   const Token& token = tokens[tokenIndex];
+   Expression* expression = nullptr;
 
-      if(lastSeparator)
-      {
-         char buffer[kDefaultLocalStringBufferSize];
-         const size_t typeIdentifierLength = lastSeparator - pFunctionIdentifier.mName;
-         strncpy(buffer, pFunctionIdentifier.mName, typeIdentifierLength);
-         buffer[typeIdentifierLength] = '\0';
-         const Identifier typeIdentifier(buffer);
-         const Identifier staticMethodIdentifier(lastSeparator + 2);
+   size_t assignmentOperatorTokenIndex = 0u;
+   size_t binaryOperatorTokenIndex = 0u;
+   uint8_t binaryOperatorPrecedence = 0u;
+   size_t memberAccessTokenIndex = 0u;
+   size_t conditionalTokenIndex = 0u;
 
-         Type* type = findType(pContext, typeIdentifier);
+   uint32_t parenthesisLevel = tokens[pTokenLastIndex].mStart[0] == ')' ? 1u : 0u;
+   uint32_t squareBracketLevel = tokens[pTokenLastIndex].mStart[0] == ']' ? 1u : 0u;
+   uint32_t curlyBracketLevel = tokens[pTokenLastIndex].mStart[0] == '}' ? 1u : 0u;
+   uint32_t templateLevel = tokens[pTokenLastIndex].mStart[0] == '>' ? 1u : 0u;
 
-         if(type && type->mCategory == TypeCategory::StructOrClass)
+   for(size_t i = pTokenLastIndex - 1u; i > tokenIndex; i--)
+   {
+      if(tokens[i].mLength == 1u)
+      {
+         if(tokens[i].mStart[0] == ')')
          {
-            Struct* castType = static_cast<Struct*>(type);
-            expression->mFunction =
-               castType->findStaticMethod(staticMethodIdentifier, argumentTypes, templateTypes);
+            parenthesisLevel++;
+            continue;
+         }
+         else if(tokens[i].mStart[0] == '(')
+         {
+            parenthesisLevel--;
+            continue;
+         }
+         else if(tokens[i].mStart[0] == ']')
+         {
+            squareBracketLevel++;
+            continue;
+         }
+         else if(tokens[i].mStart[0] == '[')
+         {
+            squareBracketLevel--;
+            continue;
+         }
+         else if(tokens[i].mStart[0] == '}')
+         {
+            curlyBracketLevel++;
+            continue;
+         }
+         else if(tokens[i].mStart[0] == '{')
+         {
+            curlyBracketLevel--;
+            continue;
+         }
+         else if(tokens[i].mStart[0] == '>')
+         {
+            const size_t templateOpeningIndex = findOpeningTokenIndex(pContext, '<', '>', i);
+            const bool isTemplateClosure =
+               templateOpeningIndex < i && isTemplate(pContext, templateOpeningIndex, i);
 
-            if(!expression->mFunction)
+            if(isTemplateClosure)
             {
-               CflatSTLString typeFullName;
-               getTypeFullName(type, &typeFullName);
+               templateLevel++;
+               continue;
+            }
+         }
+         else if(tokens[i].mStart[0] == '<')
+         {
+            const size_t cachedTokenIndex = tokenIndex;
+            tokenIndex = i;
+            const size_t templateClosureIndex =
+               findClosureTokenIndex(pContext, '<', '>', pTokenLastIndex - 1u);
+            tokenIndex = cachedTokenIndex;
 
-               throwCompileError(pContext, CompileError::MissingStaticMethod,
-                  staticMethodIdentifier.mName, typeFullName.c_str());
+            const bool isTemplateOpening =
+               templateClosureIndex > i && isTemplate(pContext, i, templateClosureIndex);
+
+            if(isTemplateOpening)
+            {
+               templateLevel--;
+               continue;
             }
          }
       }
-   }
 
-   if(expression->mFunction)
-   {
-      expression->assignTypeUsage(mTypeUsageVoid);
-   }
-   else
-   {
-      CflatInvokeDtor(ExpressionFunctionCall, expression);
-      CflatFree(expression);
-      expression = nullptr;
+      if(parenthesisLevel == 0u &&
+         squareBracketLevel == 0u &&
+         curlyBracketLevel == 0u &&
+         templateLevel == 0u)
+      {
+         if(i > tokenIndex &&
+            tokens[i].mType == TokenType::Operator &&
+            tokens[i - 1u].mType != TokenType::Operator)
+         {
+            if(tokens[i].mLength == 1u && tokens[i].mStart[0] == '?')
+            {
+               conditionalTokenIndex = i;
+            }
+            else
+            {
+               for(size_t j = 0u; j < kCflatAssignmentOperatorsCount; j++)
+               {
+                  const size_t operatorLength = strlen(kCflatAssignmentOperators[j]);
 
-      throwCompileError(pContext, CompileError::UndefinedFunction, pFunctionIdentifier.mName);
-   }
+                  if(tokens[i].mLength == operatorLength &&
+                     strncmp(tokens[i].mStart, kCflatAssignmentOperators[j], operatorLength) == 0)
+                  {
+                     assignmentOperatorTokenIndex = i;
+                     break;
+                  }
+               }
 
-   return expression;
-}
+               if(assignmentOperatorTokenIndex == 0u)
+               {
+                  const uint8_t precedence = getBinaryOperatorPrecedence(pContext, i);
 
-Expression* Environment::parseExpressionMethodCall(ParsingContext& pContext, Expression* pMemberAccess)
-{
-   ExpressionMethodCall* expression = 
-      (ExpressionMethodCall*)CflatMalloc(sizeof(ExpressionMethodCall));
-   CflatInvokeCtor(ExpressionMethodCall, expression)(pMemberAccess);
+                  if(precedence > binaryOperatorPrecedence)
+                  {
+                     binaryOperatorTokenIndex = i;
+                     binaryOperatorPrecedence = precedence;
+                  }
+               }
+            }
+         }
+         else if(tokens[i].mType == TokenType::Punctuation && memberAccessTokenIndex == 0u)
+         {
+            if(tokens[i].mStart[0] == '.' || strncmp(tokens[i].mStart, "->", 2u) == 0)
+            {
+               memberAccessTokenIndex = i;
+            }
+         }
+      }
+   }
 
-   pContext.mTokenIndex++;
-   parseFunctionCallArguments(pContext, &expression->mArguments, &expression->mTemplateTypes);
+   bool isCStyleCast = false;
+   TypeUsage cStyleCastTypeUsage;
 
-   if(!mErrorMessage.empty())
+   if(tokens[tokenIndex].mStart[0] == '(')
    {
-      return nullptr;
-   }
+      const size_t cachedTokenIndex = tokenIndex;
+      tokenIndex++;
 
-   ExpressionMemberAccess* memberAccess = static_cast<ExpressionMemberAccess*>(pMemberAccess);
-   const TypeUsage& methodOwnerTypeUsage = getTypeUsage(memberAccess->mMemberOwner);
-   CflatAssert(methodOwnerTypeUsage.mType);
-   CflatAssert(methodOwnerTypeUsage.mType->mCategory == TypeCategory::StructOrClass);
+      cStyleCastTypeUsage = parseTypeUsage(pContext, pTokenLastIndex - 1u);
+      isCStyleCast = cStyleCastTypeUsage.mType != nullptr && tokens[tokenIndex].mStart[0] == ')';
 
-   Struct* methodOwnerType = static_cast<Struct*>(methodOwnerTypeUsage.mType);
-   CflatArgsVector(TypeUsage) argumentTypes;
+      if(!isCStyleCast)
+      {
+         tokenIndex = cachedTokenIndex;
+      }
+   }
 
-   for(size_t i = 0u; i < expression->mArguments.size(); i++)
+   // C-style cast
+   if(isCStyleCast)
    {
-      const TypeUsage& typeUsage = getTypeUsage(expression->mArguments[i]);
-      argumentTypes.push_back(typeUsage);
-   }
+      tokenIndex++;
+      Expression* expressionToCast = parseExpression(pContext, pTokenLastIndex);
 
-   CflatArgsVector(TypeUsage) templateTypes;
-   toArgsVector(expression->mTemplateTypes, templateTypes);
+      expression = (ExpressionCast*)CflatMalloc(sizeof(ExpressionCast));
+      CflatInvokeCtor(ExpressionCast, expression)
+         (CastType::CStyle, cStyleCastTypeUsage, expressionToCast);
 
-   const Identifier& methodId = memberAccess->mMemberIdentifier;
-   expression->mMethodUsage =
-      methodOwnerType->findMethodUsage(methodId, 0u, argumentTypes, templateTypes);
+      const TypeUsage& sourceTypeUsage = getTypeUsage(pContext, expressionToCast);
 
-   if(expression->mMethodUsage.mMethod)
-   {
-      expression->assignTypeUsage(mTypeUsageVoid);
+      if(!isCastAllowed(CastType::CStyle, sourceTypeUsage, cStyleCastTypeUsage))
+      {
+         throwCompileError(pContext, CompileError::InvalidCast);
+      }
    }
-   else
+   // assignment
+   else if(assignmentOperatorTokenIndex > 0u)
    {
-      CflatSTLString typeFullName;
-      getTypeFullName(methodOwnerType, &typeFullName);
+      Expression* left = parseExpression(pContext, assignmentOperatorTokenIndex - 1u);
 
-      throwCompileError(pContext, CompileError::MissingMethod, methodId.mName, typeFullName.c_str());
-   }
+      if(left)
+      {
+         const TypeUsage& leftTypeUsage = getTypeUsage(pContext, left);
 
-   return expression;
-}
+         if(!leftTypeUsage.isConst())
+         {
+            const Token& operatorToken = pContext.mTokens[assignmentOperatorTokenIndex];
+            CflatSTLString operatorStr(operatorToken.mStart, operatorToken.mLength);
 
-Expression* Environment::parseExpressionObjectConstruction(ParsingContext& pContext, Type* pType)
-{
-   ExpressionObjectConstruction* expression =
-      (ExpressionObjectConstruction*)CflatMalloc(sizeof(ExpressionObjectConstruction));
-   CflatInvokeCtor(ExpressionObjectConstruction, expression)(pType);
-
-   parseFunctionCallArguments(pContext, &expression->mArguments);
-
-   if(!mErrorMessage.empty())
-   {
-      return nullptr;
-   }
-
-   CflatArgsVector(TypeUsage) argumentTypes;
+            tokenIndex = assignmentOperatorTokenIndex + 1u;
+            Expression* right = parseExpression(pContext, pTokenLastIndex);
 
-   for(size_t i = 0u; i < expression->mArguments.size(); i++)
-   {
-      const TypeUsage& typeUsage = getTypeUsage(expression->mArguments[i]);
-      argumentTypes.push_back(typeUsage);
-   }
+            if(right)
+            {
+               expression = (ExpressionAssignment*)CflatMalloc(sizeof(ExpressionAssignment));
+               CflatInvokeCtor(ExpressionAssignment, expression)(left, right, operatorStr.c_str());
+            }
+            else
+            {
+               CflatInvokeDtor(Expression, left);
+               CflatFree(left);
+            }
 
-   if(pType->mCategory == TypeCategory::StructOrClass)
-   {
-      Struct* type = static_cast<Struct*>(pType);
-      expression->mConstructor = type->findConstructor(argumentTypes);
+            tokenIndex = pTokenLastIndex + 1u;
+         }
+         else
+         {
+            throwCompileError(pContext, Environment::CompileError::CannotModifyConstExpression);
+         }
+      }
    }
-
-   if(!expression->mConstructor)
+   // conditional expression
+   else if(conditionalTokenIndex > 0u)
    {
-      CflatSTLString typeFullName;
-      getTypeFullName(pType, &typeFullName);
-
-      throwCompileError(pContext, CompileError::MissingConstructor, typeFullName.c_str());
-   }
-
-   return expression;
-}
-
-Expression* Environment::parseExpressionAggregateInitialization(ParsingContext& pContext, Type* pType,
-   size_t pTokenLastIndex)
-{
-   CflatAssert(pType->mCategory == TypeCategory::StructOrClass);
-   Struct* type = static_cast<Struct*>(pType);
-
-   ExpressionAggregateInitialization* expression =
-      (ExpressionAggregateInitialization*)CflatMalloc(sizeof(ExpressionAggregateInitialization));
-   CflatInvokeCtor(ExpressionAggregateInitialization, expression)(pType);
-
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t& tokenIndex = pContext.mTokenIndex;
-   tokenIndex++;
-
-   size_t typeMemberIndex = 0u;
-   const size_t closureIndex = findClosureTokenIndex(pContext, '{', '}', pTokenLastIndex);
+      const size_t elseTokenIndex = findSeparationTokenIndex(pContext, ':', pTokenLastIndex);
 
-   while(tokenIndex < closureIndex)
-   {
-      if(typeMemberIndex == type->mMembers.size())
+      if(elseTokenIndex > 0u)
       {
-         throwCompileError(pContext, Environment::CompileError::TooManyArgumentsInAggregate);
-         break;
-      }
-
-      const size_t separatorIndex = findSeparationTokenIndex(pContext, ',', closureIndex);
-      const size_t lastValueIndex = separatorIndex > 0u
-         ? separatorIndex - 1u
-         : closureIndex - 1u;
+         Expression* condition = parseExpression(pContext, conditionalTokenIndex - 1u);
+         tokenIndex = conditionalTokenIndex + 1u;
 
-      Expression* valueExpression = parseExpression(pContext, lastValueIndex);
-      expression->mValues.push_back(valueExpression);
+         Expression* ifExpression = parseExpression(pContext, elseTokenIndex - 1u);
+         tokenIndex = elseTokenIndex + 1u;
 
-      if(valueExpression)
-      {
-         const TypeHelper::Compatibility compatibility = TypeHelper::getCompatibility(
-            valueExpression->getTypeUsage(), type->mMembers[typeMemberIndex]->mTypeUsage);
+         Expression* elseExpression = parseExpression(pContext, pTokenLastIndex);
+         tokenIndex = pTokenLastIndex + 1u;
 
-         if(compatibility == TypeHelper::Compatibility::Incompatible)
-         {
-            throwCompileError(pContext, Environment::CompileError::MismatchingTypeInAggregate,
-               type->mMembers[typeMemberIndex]->mIdentifier.mName);
-            break;
-         }
+         expression = (ExpressionConditional*)CflatMalloc(sizeof(ExpressionConditional));
+         CflatInvokeCtor(ExpressionConditional, expression)(condition, ifExpression, elseExpression);
       }
       else
       {
-         break;
+         throwCompileError(pContext, CompileError::InvalidConditionalExpression);
       }
-
-      tokenIndex = lastValueIndex + 2u;
-      typeMemberIndex++;
    }
+   // binary operator
+   else if(binaryOperatorTokenIndex > 0u)
+   {
+      Expression* left = parseExpression(pContext, binaryOperatorTokenIndex - 1u);
 
-   return expression;
-}
-
-size_t Environment::findClosureTokenIndex(ParsingContext& pContext, char pOpeningChar, char pClosureChar,
-   size_t pTokenIndexLimit) const
-{
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t closureTokenIndex = 0u;
+      if(left)
+      {
+         const TypeUsage& leftTypeUsage = getTypeUsage(pContext, left);
 
-   if(pTokenIndexLimit == 0u)
-   {
-      pTokenIndexLimit = pContext.mTokens.size() - 1u;
-   }
+         const Token& operatorToken = pContext.mTokens[binaryOperatorTokenIndex];
+         CflatSTLString operatorStr(operatorToken.mStart, operatorToken.mLength);
 
-   if(tokens[pContext.mTokenIndex].mStart[0] == pClosureChar)
-   {
-      closureTokenIndex = pContext.mTokenIndex;
-   }
-   else
-   {
-      uint32_t scopeLevel = 0u;
+         tokenIndex = binaryOperatorTokenIndex + 1u;
+         Expression* right = parseExpression(pContext, pTokenLastIndex);
 
-      for(size_t i = (pContext.mTokenIndex + 1u); i <= pTokenIndexLimit; i++)
-      {
-         if(tokens[i].mLength > 1u)
+         if(right)
          {
-            continue;
-         }
+            bool operatorIsValid = true;
+            TypeUsage overloadedOperatorTypeUsage;
 
-         if(tokens[i].mStart[0] == pClosureChar)
-         {
-            if(scopeLevel == 0u)
+            if(!leftTypeUsage.isPointer() &&
+               leftTypeUsage.mType &&
+               leftTypeUsage.mType->mCategory == TypeCategory::StructOrClass)
             {
-               closureTokenIndex = i;
-               break;
-            }
-
-            scopeLevel--;
-         }
-         else if(tokens[i].mStart[0] == pOpeningChar)
-         {
-            scopeLevel++;
-         }
-      }
-   }
+               const TypeUsage& rightTypeUsage = getTypeUsage(pContext, right);
 
-   return closureTokenIndex;
-}
+               if(rightTypeUsage.mType)
+               {
+                  CflatArgsVector(TypeUsage) args;
+                  args.push_back(rightTypeUsage);
 
-size_t Environment::findOpeningTokenIndex(ParsingContext& pContext, char pOpeningChar, char pClosureChar,
-   size_t pClosureIndex) const
-{
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t openingTokenIndex = pClosureIndex;
+                  pContext.mStringBuffer.assign("operator");
+                  pContext.mStringBuffer.append(operatorStr);
+                  const Identifier operatorIdentifier(pContext.mStringBuffer.c_str());
 
-   if(openingTokenIndex > 0u)
-   {
-      uint32_t scopeLevel = 0u;
+                  Struct* leftType = static_cast<Struct*>(leftTypeUsage.mType);
+                  Method* operatorMethod = leftType->findMethod(operatorIdentifier, args);
 
-      for(int i = (int)pClosureIndex - 1; i >= (int)pContext.mTokenIndex; i--)
-      {
-         if(tokens[i].mLength > 1u)
-         {
-            continue;
-         }
+                  if(operatorMethod)
+                  {
+                     overloadedOperatorTypeUsage = operatorMethod->mReturnTypeUsage;
 
-         if(tokens[i].mStart[0] == pOpeningChar)
-         {
-            if(scopeLevel == 0u)
-            {
-               openingTokenIndex = i;
-               break;
-            }
+                     if(!isMethodCallAllowed(operatorMethod, leftTypeUsage))
+                     {
+                        throwCompileError(pContext, CompileError::CannotCallNonConstMethod);
+                        operatorIsValid = false;
+                     }
+                  }
+                  else
+                  {
+                     args.insert(args.begin(), leftTypeUsage);
 
-            scopeLevel--;
-         }
-         else if(tokens[i].mStart[0] == pClosureChar)
-         {
-            scopeLevel++;
-         }
-      }
-   }
+                     Function* operatorFunction =
+                        leftTypeUsage.mType->mNamespace->getFunction(operatorIdentifier, args);
 
-   return openingTokenIndex;
-}
+                     if(!operatorFunction)
+                     {
+                        operatorFunction = findFunction(pContext, operatorIdentifier, args);
 
-size_t Environment::findSeparationTokenIndex(ParsingContext& pContext, char pSeparationChar,
-   size_t pClosureIndex) const
-{
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t separationTokenIndex = 0u;
+                        if(!operatorFunction)
+                        {
+                           CflatSTLString typeFullName;
+                           getTypeFullName(leftTypeUsage.mType, &typeFullName);
 
-   uint32_t scopeLevel = 0u;
+                           throwCompileError(pContext, CompileError::InvalidOperator,
+                              typeFullName.c_str(), operatorStr.c_str());
+                           operatorIsValid = false;
+                        }
+                     }
 
-   for(size_t i = pContext.mTokenIndex; i < pClosureIndex; i++)
-   {
-      if(tokens[i].mLength > 1u)
-      {
-         continue;
-      }
+                     if(operatorFunction)
+                     {
+                        overloadedOperatorTypeUsage = operatorFunction->mReturnTypeUsage;
+                     }
+                  }
+               }
+            }
 
-      if(i > pContext.mTokenIndex && tokens[i].mStart[0] == pSeparationChar && scopeLevel == 0u)
-      {
-         separationTokenIndex = i;
-         break;
-      }
+            if(operatorIsValid)
+            {
+               TypeUsage typeUsage;
 
-      if(tokens[i].mStart[0] == '(' || tokens[i].mStart[0] == '{')
-      {
-         scopeLevel++;
-      }
-      else if(tokens[i].mStart[0] == ')' || tokens[i].mStart[0] == '}')
-      {
-         scopeLevel--;
-      }
-   }
+               if(overloadedOperatorTypeUsage.mType)
+               {
+                  typeUsage = overloadedOperatorTypeUsage;
+               }
+               else
+               {
+                  bool logicalOperator = false;
 
-   return separationTokenIndex;
-}
+                  for(size_t i = 0u; i < kCflatLogicalOperatorsCount; i++)
+                  {
+                     if(strcmp(operatorStr.c_str(), kCflatLogicalOperators[i]) == 0)
+                     {
+                        logicalOperator = true;
+                        break;
+                     }
+                  }
 
-uint8_t Environment::getBinaryOperatorPrecedence(ParsingContext& pContext, size_t pTokenIndex) const
-{
-   const Token& token = pContext.mTokens[pTokenIndex];
-   CflatAssert(token.mType == TokenType::Operator);
+                  if(logicalOperator)
+                  {
+                     typeUsage = mTypeUsageBool;
+                  }
+                  else
+                  {
+                     const TypeUsage& rightTypeUsage = getTypeUsage(pContext, right);
 
-   uint8_t precedence = 0u;
+                     if(leftTypeUsage.mType->isInteger() && !rightTypeUsage.mType->isInteger())
+                     {
+                        typeUsage = rightTypeUsage;
+                     }
+                     else
+                     {
+                        typeUsage = leftTypeUsage;
+                     }
 
-   for(size_t i = 0u; i < kCflatBinaryOperatorsCount; i++)
+                     CflatResetFlag(typeUsage.mFlags, TypeUsageFlags::Reference);
+                  }
+               }
+
+               expression =
+                  (ExpressionBinaryOperation*)CflatMalloc(sizeof(ExpressionBinaryOperation));
+               CflatInvokeCtor(ExpressionBinaryOperation, expression)
+                  (left, right, operatorStr.c_str(), typeUsage);
+            }
+            else
+            {
+               CflatInvokeDtor(Expression, left);
+               CflatFree(left);
+               CflatInvokeDtor(Expression, right);
+               CflatFree(right);
+            }
+         }
+         else
+         {
+            CflatInvokeDtor(Expression, left);
+            CflatFree(left);
+         }
+      }
+
+      tokenIndex = pTokenLastIndex + 1u;
+   }
+   // unary operator
+   else if(tokens[pTokenFirstIndex].mType == TokenType::Operator ||
+      tokens[pTokenLastIndex].mType == TokenType::Operator)
    {
-      const size_t operatorLength = strlen(kCflatBinaryOperators[i]);
+      size_t operatorTokenIndex;
+      size_t operandExpressionTokenFirstIndex;
+      size_t operandExpressionTokenLastIndex;
+      bool postOperator;
 
-      if(token.mLength == operatorLength &&
-         strncmp(token.mStart, kCflatBinaryOperators[i], operatorLength) == 0)
+      if(tokens[pTokenLastIndex].mType == TokenType::Operator)
       {
-         precedence = kCflatBinaryOperatorsPrecedence[i];
-         break;
+         operatorTokenIndex = pTokenLastIndex;
+         operandExpressionTokenFirstIndex = pTokenFirstIndex;
+         operandExpressionTokenLastIndex = pTokenLastIndex - 1u;
+         postOperator = true;
+      }
+      else
+      {
+         operatorTokenIndex = pTokenFirstIndex;
+         operandExpressionTokenFirstIndex = pTokenFirstIndex + 1u;
+         operandExpressionTokenLastIndex = pTokenLastIndex;
+         postOperator = false;
       }
-   }
 
-   return precedence;
-}
+      pContext.mTokenIndex = operandExpressionTokenFirstIndex;
+      Expression* operandExpression = parseExpression(pContext, operandExpressionTokenLastIndex);
 
-bool Environment::isTemplate(ParsingContext& pContext, size_t pOpeningTokenIndex, size_t pClosureTokenIndex) const
-{
-   if(pClosureTokenIndex <= pOpeningTokenIndex)
-      return false;
+      if(operandExpression)
+      {
+         const Token& operatorToken = tokens[operatorTokenIndex];
 
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
+         char operatorStr[kSmallLocalStringBufferSize];
+         strncpy(operatorStr, operatorToken.mStart, operatorToken.mLength);
+         operatorStr[operatorToken.mLength] = '\0';
 
-   const Token& openingToken = tokens[pOpeningTokenIndex];
+         expression =
+            parseExpressionUnaryOperator(pContext, operandExpression, operatorStr, postOperator);
+      }
+   }
+   // member access
+   else if(memberAccessTokenIndex > 0u)
+   {
+      if(tokens[memberAccessTokenIndex + 1u].mType == TokenType::Identifier)
+      {
+         Expression* memberOwner = parseExpression(pContext, memberAccessTokenIndex - 1u);
+         tokenIndex = memberAccessTokenIndex + 1u;
 
-   if(openingToken.mLength != 1u || openingToken.mStart[0] != '<')
-      return false;
+         if(memberOwner &&
+            memberOwner->getTypeUsage().mType &&
+            memberOwner->getTypeUsage().mType->mCategory == TypeCategory::StructOrClass)
+         {
+            pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
+            const Identifier memberIdentifier(pContext.mStringBuffer.c_str());
 
-   const Token& closureToken = tokens[pClosureTokenIndex];
+            const bool isMemberAccess = tokens[memberAccessTokenIndex].mStart[0] == '.';
+            const bool isPtrMemberAccess =
+               !isMemberAccess && strncmp(tokens[memberAccessTokenIndex].mStart, "->", 2u) == 0;
 
-   if(closureToken.mLength != 1u || closureToken.mStart[0] != '>')
-      return false;
+            bool memberAccessIsValid = true;
 
-   for(size_t operatorTokenIndex = pOpeningTokenIndex + 1u;
-      operatorTokenIndex < pClosureTokenIndex;
-      operatorTokenIndex++)
-   {
-      if(tokens[operatorTokenIndex].mType == TokenType::Operator)
-      {
-         if(tokens[operatorTokenIndex].mStart[0] == '<' && tokens[operatorTokenIndex].mLength == 1u)
-         {
-            const size_t cachedTokenIndex = pContext.mTokenIndex;
-            pContext.mTokenIndex = operatorTokenIndex;
-            const size_t innerTemplateClosureTokenIndex =
-               findClosureTokenIndex(pContext, '<', '>', pClosureTokenIndex - 1u);
-            pContext.mTokenIndex = cachedTokenIndex;
+            const TypeUsage& ownerTypeUsage = getTypeUsage(pContext, memberOwner);
 
-            if(isTemplate(pContext, operatorTokenIndex, innerTemplateClosureTokenIndex))
+            bool isMethodCall = false;
+            Member* member = nullptr;
+
+            if((tokenIndex + 1u) < tokens.size())
             {
-               operatorTokenIndex = innerTemplateClosureTokenIndex;
-               continue;
+               isMethodCall = tokens[tokenIndex + 1u].mStart[0] == '(';
+
+               if(!isMethodCall)
+               {
+                  tokenIndex++;
+                  isMethodCall = isTemplate(pContext, pTokenLastIndex);
+                  tokenIndex--;
+               }
+
+               if(!isMethodCall)
+               {
+                  Struct* type = static_cast<Struct*>(ownerTypeUsage.mType);
+                  member = type->findMember(memberIdentifier);
+
+                  if(!member)
+                  {
+                     CflatSTLString typeFullName;
+                     getTypeFullName(type, &typeFullName);
+
+                     throwCompileError(pContext, CompileError::MissingMember,
+                        memberIdentifier.mName, typeFullName.c_str());
+                     memberAccessIsValid = false;
+                  }
+               }
             }
-            else
+
+            if(memberAccessIsValid)
             {
-               return false;
+               if(ownerTypeUsage.isPointer())
+               {
+                  if(!isPtrMemberAccess)
+                  {
+                     throwCompileError(pContext, CompileError::InvalidMemberAccessOperatorPtr,
+                        memberIdentifier.mName);
+                     memberAccessIsValid = false;
+                  }
+               }
+               else
+               {
+                  if(isPtrMemberAccess)
+                  {
+                     throwCompileError(pContext, CompileError::InvalidMemberAccessOperatorNonPtr,
+                        memberIdentifier.mName);
+                     memberAccessIsValid = false;
+                  }
+               }
             }
-         }
-
-         bool isPointerOrRefOperator = false;
 
-         if(tokens[operatorTokenIndex].mLength == 1u &&
-            (tokens[operatorTokenIndex].mStart[0] == '*' || tokens[operatorTokenIndex].mStart[0] == '&'))
-         {
-            for(size_t i = operatorTokenIndex - 1u; i > pOpeningTokenIndex; i--)
+            if(memberAccessIsValid)
             {
-               const size_t cachedTokenIndex = pContext.mTokenIndex;
-               pContext.mTokenIndex = i;
-               const TypeUsage typeUsage = parseTypeUsage(pContext, operatorTokenIndex);
-               pContext.mTokenIndex = cachedTokenIndex;
+               ExpressionMemberAccess* memberAccess =
+                  (ExpressionMemberAccess*)CflatMalloc(sizeof(ExpressionMemberAccess));
+               CflatInvokeCtor(ExpressionMemberAccess, memberAccess)(memberOwner, memberIdentifier);
+               expression = memberAccess;
 
-               isPointerOrRefOperator =
-                  typeUsage.mType && (typeUsage.isPointer() || typeUsage.isReference());
+               // method call
+               if(isMethodCall)
+               {
+                  expression = parseExpressionMethodCall(pContext, memberAccess);
 
-               if(isPointerOrRefOperator)
+                  if(expression)
+                  {
+                     Method* method =
+                        static_cast<ExpressionMethodCall*>(expression)->mMethodUsage.mMethod;
+
+                     if(method)
+                     {
+                        memberAccess->mMemberAccessType = MemberAccessType::Method;
+                        memberAccess->assignTypeUsage(method->mReturnTypeUsage);
+
+                        if(!isMethodCallAllowed(method, ownerTypeUsage))
+                        {
+                           throwCompileError(pContext, CompileError::CannotCallNonConstMethod);
+                        }
+                     }
+                  }
+               }
+               else if(member)
                {
-                  break;
+                  memberAccess->mMemberAccessType = (MemberAccessType)member->mMemberType;
+                  memberAccess->assignTypeUsage(member->mTypeUsage);
                }
             }
          }
-
-         if(!isPointerOrRefOperator)
-         {
-            return false;
-         }
+      }
+      else
+      {
+         tokenIndex = memberAccessTokenIndex;
+         throwCompileErrorUnexpectedSymbol(pContext);
       }
    }
+   // parenthesized expression
+   else if(tokens[tokenIndex].mStart[0] == '(')
+   {
+      const size_t closureTokenIndex = findClosureTokenIndex(pContext, '(', ')', pTokenLastIndex);
+      tokenIndex++;
+
+      if(closureTokenIndex > tokenIndex)
+      {
+         Expression* innerExpression = parseExpression(pContext, closureTokenIndex - 1u);
+
+         if(innerExpression)
+         {
+            expression = (ExpressionParenthesized*)CflatMalloc(sizeof(ExpressionParenthesized));
+            CflatInvokeCtor(ExpressionParenthesized, expression)(innerExpression);
+         }
+
+         tokenIndex = closureTokenIndex + 1u;
+      }
+      else
+      {
+         throwCompileErrorUnexpectedSymbol(pContext);
+      }
+   }
+   // array initialization
+   else if(tokens[tokenIndex].mStart[0] == '{')
+   {
+      tokenIndex++;
+
+      ExpressionArrayInitialization* arrayInitialization =
+         (ExpressionArrayInitialization*)CflatMalloc(sizeof(ExpressionArrayInitialization));
+      CflatInvokeCtor(ExpressionArrayInitialization, arrayInitialization)();
+      expression = arrayInitialization;
+
+      const size_t closureIndex = findClosureTokenIndex(pContext, '{', '}', pTokenLastIndex);
+
+      while(tokenIndex < closureIndex)
+      {
+         const size_t separatorIndex = findSeparationTokenIndex(pContext, ',', closureIndex);
+         const size_t lastArrayValueIndex = separatorIndex > 0u
+            ? separatorIndex - 1u
+            : closureIndex - 1u;
+
+         Expression* arrayValueExpression = parseExpression(pContext, lastArrayValueIndex);
+         arrayInitialization->mValues.push_back(arrayValueExpression);
+
+         if(arrayInitialization->mElementTypeUsage.mType)
+         {
+            const TypeHelper::Compatibility compatibility = TypeHelper::getCompatibility(
+               arrayValueExpression->getTypeUsage(), arrayInitialization->mElementTypeUsage);
+
+            if(compatibility == TypeHelper::Compatibility::Incompatible)
+            {
+               throwCompileError(pContext, Environment::CompileError::NonHomogeneousTypeList);
+               break;
+            }
+         }
+         else
+         {
+            arrayInitialization->mElementTypeUsage = arrayValueExpression->getTypeUsage();
+         }
+
+         tokenIndex = lastArrayValueIndex + 2u;
+      }
+
+      arrayInitialization->assignTypeUsage();
+   }
+   // array element access / operator[]
+   else if(tokens[pTokenLastIndex].mStart[0] == ']')
+   {
+      const size_t openingIndex = findOpeningTokenIndex(pContext, '[', ']', pTokenLastIndex);
+
+      if(pTokenLastIndex > (openingIndex + 1u))
+      {
+         Expression* arrayAccess = parseExpression(pContext, openingIndex - 1u);
+
+         if(arrayAccess)
+         {
+            tokenIndex = openingIndex + 1u;
+            Expression* arrayElementIndex = parseExpression(pContext, pTokenLastIndex - 1u);
+
+            TypeUsage typeUsage = getTypeUsage(pContext, arrayAccess);
+
+            if(typeUsage.isArray() || typeUsage.isPointer())
+            {
+               if(typeUsage.isArray())
+               {
+                  CflatResetFlag(typeUsage.mFlags, TypeUsageFlags::Array);
+                  typeUsage.mArraySize = 1u;
+               }
+               else
+               {
+                  typeUsage.mPointerLevel--;
+               }
+
+               expression =
+                  (ExpressionArrayElementAccess*)CflatMalloc(sizeof(ExpressionArrayElementAccess));
+               CflatInvokeCtor(ExpressionArrayElementAccess, expression)
+                  (arrayAccess, arrayElementIndex, typeUsage);
+            }
+            else if(typeUsage.mType->mCategory == TypeCategory::StructOrClass)
+            {
+               Struct* type = static_cast<Struct*>(typeUsage.mType);
+               const Identifier operatorMethodID("operator[]");
+               Method* operatorMethod = type->findMethod(operatorMethodID);
+
+               if(operatorMethod)
+               {
+                  ExpressionMemberAccess* memberAccess =
+                     (ExpressionMemberAccess*)CflatMalloc(sizeof(ExpressionMemberAccess));
+                  CflatInvokeCtor(ExpressionMemberAccess, memberAccess)
+                     (arrayAccess, operatorMethodID);
+                  memberAccess->assignTypeUsage(operatorMethod->mReturnTypeUsage);
+
+                  ExpressionMethodCall* methodCall =
+                     (ExpressionMethodCall*)CflatMalloc(sizeof(ExpressionMethodCall));
+                  CflatInvokeCtor(ExpressionMethodCall, methodCall)(memberAccess);
+                  expression = methodCall;
+
+                  methodCall->mArguments.push_back(arrayElementIndex);
+                  methodCall->mMethodUsage.mMethod = operatorMethod;
+                  methodCall->assignTypeUsage(mTypeUsageVoid);
+               }
+               else
+               {
+                  throwCompileErrorUnexpectedSymbol(pContext);
+               }
+            }
+            else
+            {
+               throwCompileErrorUnexpectedSymbol(pContext);
+            }
+
+            tokenIndex = pTokenLastIndex + 1u;
+         }
+         else
+         {
+            throwCompileErrorUnexpectedSymbol(pContext);
+         }
+      }
+      else
+      {
+         throwCompileErrorUnexpectedSymbol(pContext);
+      }
+   }
+   else if(token.mType == TokenType::Identifier)
+   {
+      pContext.mStringBuffer.assign(token.mStart, token.mLength);
+
+      while(tokenIndex < (tokens.size() - 1u) && strncmp(tokens[++tokenIndex].mStart, "::", 2u) == 0)
+      {
+         tokenIndex++;
+         pContext.mStringBuffer.append("::");
+         pContext.mStringBuffer.append(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
+      }
+
+      const Identifier fullIdentifier(pContext.mStringBuffer.c_str());
+      bool isFunctionCall = tokens[tokenIndex].mStart[0] == '(';
+
+      TypeUsage templateTypeUsage;
+         
+      if(!isFunctionCall && isTemplate(pContext, pTokenLastIndex))
+      {
+         const size_t templateClosureIndex =
+            findClosureTokenIndex(pContext, '<', '>', pTokenLastIndex);
+         isFunctionCall =
+            templateClosureIndex > 0u && tokens[templateClosureIndex + 1u].mStart[0] == '(';
+
+         if(isFunctionCall)
+         {
+            pContext.mTokenIndex = pTokenFirstIndex;
+            templateTypeUsage = parseTypeUsage(pContext, templateClosureIndex);
+
+            if(!templateTypeUsage.mType)
+            {
+               pContext.mTokenIndex++;
+            }
+         }
+      }
+
+      // function call / object construction
+      if(isFunctionCall)
+      {
+         Type* type = templateTypeUsage.mType
+            ? templateTypeUsage.mType
+            : findType(pContext, fullIdentifier);
+         expression = type
+            ? parseExpressionObjectConstruction(pContext, type)
+            : parseExpressionFunctionCall(pContext, fullIdentifier);
+      }
+      // aggregate initialization
+      else if(tokens[tokenIndex].mStart[0] == '{')
+      {
+         Type* type = findType(pContext, fullIdentifier);
+
+         if(type)
+         {
+            expression = parseExpressionAggregateInitialization(pContext, type, pTokenLastIndex);
+         }
+      }
+      // variable access with namespace / static member access
+      else
+      {
+         Instance* variableInstance = retrieveInstance(pContext, fullIdentifier);
+         Instance* enumInstance = nullptr;
+
+         if(!variableInstance)
+         {
+            const char* lastSeparator = fullIdentifier.findLastSeparator();
+
+            if(lastSeparator)
+            {
+               char buffer[kDefaultLocalStringBufferSize];
+               const size_t containerIdentifierLength = lastSeparator - fullIdentifier.mName;
+               strncpy(buffer, fullIdentifier.mName, containerIdentifierLength);
+               buffer[containerIdentifierLength] = '\0';
+               const Identifier containerIdentifier(buffer);
+               const Identifier memberIdentifier(lastSeparator + 2);
+
+               Type* type = findType(pContext, containerIdentifier);
+
+               if(type)
+               {
+                  if(type->mCategory == TypeCategory::StructOrClass)
+                  {
+                     variableInstance =
+                        static_cast<Struct*>(type)->mInstancesHolder.retrieveInstance(memberIdentifier);
+
+                     if(!variableInstance)
+                     {
+                        CflatSTLString typeFullName;
+                        getTypeFullName(type, &typeFullName);
+
+                        throwCompileError(pContext, Environment::CompileError::MissingStaticMember,
+                           memberIdentifier.mName, typeFullName.c_str());
+                     }
+                  }
+                  else if(type->mCategory == TypeCategory::Enum)
+                  {
+                     enumInstance =
+                        static_cast<Enum*>(type)->mInstancesHolder.retrieveInstance(memberIdentifier);
+                  }
+                  else if(type->mCategory == TypeCategory::EnumClass)
+                  {
+                     enumInstance =
+                        static_cast<EnumClass*>(type)->mInstancesHolder.retrieveInstance(memberIdentifier);
+                  }
+               }
+            }
+         }
+
+         if(variableInstance)
+         {
+            expression = (ExpressionVariableAccess*)CflatMalloc(sizeof(ExpressionVariableAccess));
+            CflatInvokeCtor(ExpressionVariableAccess, expression)
+               (fullIdentifier, variableInstance->mTypeUsage);
+         }
+         else if(enumInstance)
+         {
+            expression = (ExpressionValue*)CflatMalloc(sizeof(ExpressionValue));
+            CflatInvokeCtor(ExpressionValue, expression)(enumInstance->mValue);
+         }
+         else
+         {
+            throwCompileError(pContext, Environment::CompileError::UndefinedType,
+               fullIdentifier.mName);
+         }
+      }
+   }
+   else if(token.mType == TokenType::Keyword)
+   {
+      if(strncmp(token.mStart, "sizeof", 6u) == 0)
+      {
+         if(tokens[tokenIndex + 1u].mStart[0] == '(')
+         {
+            tokenIndex++;
+            const size_t closureTokenIndex =
+               findClosureTokenIndex(pContext, '(', ')', pTokenLastIndex);
+            tokenIndex++;
+
+            ExpressionSizeOf* concreteExpression =
+               (ExpressionSizeOf*)CflatMalloc(sizeof(ExpressionSizeOf));
+            CflatInvokeCtor(ExpressionSizeOf, concreteExpression)(mTypeUsageSizeT);
+            expression = concreteExpression;
+
+            concreteExpression->mSizeOfTypeUsage = parseTypeUsage(pContext, closureTokenIndex - 1u);
+
+            if(!concreteExpression->mSizeOfTypeUsage.mType)
+            {
+               concreteExpression->mSizeOfExpression = parseExpression(pContext, closureTokenIndex - 1u);
+            }
+
+            tokenIndex = closureTokenIndex;
+         }
+         else
+         {
+            throwCompileErrorUnexpectedSymbol(pContext);
+         }
+      }
+      else if(strncmp(token.mStart, "static_cast", 11u) == 0)
+      {
+         tokenIndex++;
+         expression = parseExpressionCast(pContext, CastType::Static, pTokenLastIndex);
+      }
+      else if(strncmp(token.mStart, "dynamic_cast", 12u) == 0)
+      {
+         tokenIndex++;
+         expression = parseExpressionCast(pContext, CastType::Dynamic, pTokenLastIndex);
+      }
+      else if(strncmp(token.mStart, "reinterpret_cast", 16u) == 0)
+      {
+         tokenIndex++;
+         expression = parseExpressionCast(pContext, CastType::Reinterpret, pTokenLastIndex);
+      }
+      else if(strncmp(token.mStart, "const_cast", 10u) == 0)
+      {
+         tokenIndex++;
+         expression = parseExpressionCast(pContext, CastType::Const, pTokenLastIndex);
+      }
+   }
+   else if(token.mType == TokenType::String || token.mType == TokenType::WideString)
+   {
+      expression = parseExpressionLiteralString(pContext, token.mType);
+   }
+   else if(token.mType == TokenType::Character || token.mType == TokenType::WideCharacter)
+   {
+      expression = parseExpressionLiteralCharacter(pContext, token.mType);
+   }
+
+   return expression;
+}
+
+Expression* Environment::parseExpressionLiteralString(ParsingContext& pContext, TokenType pTokenType)
+{
+   pContext.mStringBuffer.clear();
+
+   const size_t firstIndex = pTokenType == TokenType::String ? 1u : 2u;
+
+   do
+   {
+      const Token& token = pContext.mTokens[pContext.mTokenIndex];
+
+      for(size_t i = firstIndex; i < (token.mLength - 1u); i++)
+      {
+         const char currentChar = *(token.mStart + i);
+
+         if(currentChar == '\\')
+         {
+            const char escapeChar = *(token.mStart + i + 1u);
+
+            if(escapeChar == 'n')
+            {
+               pContext.mStringBuffer.push_back('\n');
+            }
+            else if(escapeChar == '\\')
+            {
+               pContext.mStringBuffer.push_back('\\');
+            }
+            else if(escapeChar == 't')
+            {
+               pContext.mStringBuffer.push_back('\t');
+            }
+            else if(escapeChar == 'r')
+            {
+               pContext.mStringBuffer.push_back('\r');
+            }
+            else if(escapeChar == '"')
+            {
+               pContext.mStringBuffer.push_back('\"');
+            }
+            else if(escapeChar == '\'')
+            {
+               pContext.mStringBuffer.push_back('\'');
+            }
+            else if(escapeChar == '0')
+            {
+               pContext.mStringBuffer.push_back('\0');
+            }
+            else
+            {
+               pContext.mStringBuffer.clear();
+               pContext.mStringBuffer.push_back(escapeChar);
+               
+               throwCompileError(pContext, CompileError::InvalidEscapeSequence,
+                  pContext.mStringBuffer.c_str());
+               
+               return nullptr;
+            }
+
+            i++;
+         }
+         else
+         {
+            pContext.mStringBuffer.push_back(currentChar);
+         }
+      }
+
+      pContext.mTokenIndex++;
+   }
+   while(pContext.mTokenIndex < pContext.mTokens.size() &&
+      pContext.mTokens[pContext.mTokenIndex].mType == pTokenType);
+
+   pContext.mStringBuffer.push_back('\0');
+
+   const Hash stringHash = hash(pContext.mStringBuffer.c_str());
+   Value value;
+
+   if(pTokenType == TokenType::String)
+   {
+      mLiteralStringsMutex.lock();
+      const char* string =
+         mLiteralStringsPool.registerString(stringHash, pContext.mStringBuffer.c_str());
+      mLiteralStringsMutex.unlock();
+
+      value.initOnStack(mTypeUsageCString, &pContext.mStack);
+      value.set(&string);
+   }
+   else
+   {
+      mLiteralStringsMutex.lock();
+      const wchar_t* string =
+         mLiteralWideStringsPool.registerString(stringHash, pContext.mStringBuffer.c_str());
+      mLiteralStringsMutex.unlock();
+
+      value.initOnStack(mTypeUsageWideString, &pContext.mStack);
+      value.set(&string);
+   }
+
+   ExpressionValue* expression = (ExpressionValue*)CflatMalloc(sizeof(ExpressionValue));
+   CflatInvokeCtor(ExpressionValue, expression)(value);
+
+   return expression;
+}
+
+Expression* Environment::parseExpressionLiteralCharacter(ParsingContext& pContext, TokenType pTokenType)
+{
+   const Token& token = pContext.mTokens[pContext.mTokenIndex];
+   const size_t expectedTokenSize = pTokenType == TokenType::Character ? 3u : 4u;
+
+   if(token.mLength != expectedTokenSize)
+   {
+      throwCompileErrorUnexpectedSymbol(pContext);
+      return nullptr;
+   }
+
+   Value value;
+
+   if(pTokenType == TokenType::Character)
+   {
+      const char character = token.mStart[1];
+
+      value.initOnStack(mTypeUsageCharacter, &pContext.mStack);
+      value.set(&character);
+   }
+   else
+   {
+      const wchar_t character = (wchar_t)token.mStart[2];
+
+      value.initOnStack(mTypeUsageWideCharacter, &pContext.mStack);
+      value.set(&character);
+   }
+
+   ExpressionValue* expression = (ExpressionValue*)CflatMalloc(sizeof(ExpressionValue));
+   CflatInvokeCtor(ExpressionValue, expression)(value);
+
+   return expression;
+}
+
+Expression* Environment::parseExpressionUnaryOperator(ParsingContext& pContext, Expression* pOperand,
+   const char* pOperator, bool pPostOperator)
+{
+   Expression* expression = nullptr;
+   bool validOperation = true;
+
+   const TypeUsage& operandTypeUsage = getTypeUsage(pContext, pOperand);
+
+   Method* operatorMethod = nullptr;
+   Function* operatorFunction = nullptr;
+   TypeUsage overloadedOperatorTypeUsage;
+
+   if(operandTypeUsage.mType &&
+      operandTypeUsage.mType->mCategory == TypeCategory::StructOrClass &&
+      !operandTypeUsage.isPointer())
+   {
+      pContext.mStringBuffer.assign("operator");
+      pContext.mStringBuffer.append(pOperator);
+
+      Struct* operandType = static_cast<Struct*>(operandTypeUsage.mType);
+      const Identifier operatorIdentifier(pContext.mStringBuffer.c_str());
+      operatorMethod = operandType->findMethod(operatorIdentifier, TypeUsage::kEmptyList());
+      
+      if(operatorMethod)
+      {
+         if(isMethodCallAllowed(operatorMethod, operandTypeUsage))
+         {
+            overloadedOperatorTypeUsage = operatorMethod->mReturnTypeUsage;
+         }
+         else
+         {
+            validOperation = false;
+            throwCompileError(pContext, CompileError::CannotCallNonConstMethod);
+         }
+      }
+      else
+      {
+         CflatArgsVector(TypeUsage) parameterTypes;
+         parameterTypes.push_back(operandTypeUsage);
+
+         operatorFunction =
+            operandTypeUsage.mType->mNamespace->getFunction(operatorIdentifier, parameterTypes);
+
+         if(!operatorFunction)
+         {
+            operatorFunction = findFunction(pContext, operatorIdentifier, parameterTypes);
+         }
+
+         if(operatorFunction)
+         {
+            overloadedOperatorTypeUsage = operatorFunction->mReturnTypeUsage;
+         }
+      }
+   }
+
+   if(!operatorMethod && !operatorFunction)
+   {
+      const bool isIncrementOrDecrement =
+         strncmp(pOperator, "++", 2u) == 0 ||
+         strncmp(pOperator, "--", 2u) == 0;
+
+      if(isIncrementOrDecrement)
+      {
+         if(operandTypeUsage.isConst())
+         {
+            throwCompileError(pContext, Environment::CompileError::CannotModifyConstExpression);
+            validOperation = false;
+         }
+      }
+   }
+
+   if(validOperation)
+   {
+      TypeUsage typeUsage;
+
+      if(overloadedOperatorTypeUsage.mType)
+      {
+         typeUsage = overloadedOperatorTypeUsage;
+      }
+      else
+      {
+         typeUsage = pOperator[0] == '!'
+            ? mTypeUsageBool
+            : getTypeUsage(pContext, pOperand);
+         CflatResetFlag(typeUsage.mFlags, TypeUsageFlags::Reference);
+
+         if(pOperator[0] == '&')
+         {
+            typeUsage.mPointerLevel++;
+         }
+         else if(pOperator[0] == '*')
+         {
+            typeUsage.mPointerLevel--;
+         }
+      }
+
+      expression = (ExpressionUnaryOperation*)CflatMalloc(sizeof(ExpressionUnaryOperation));
+      CflatInvokeCtor(ExpressionUnaryOperation, expression)
+         (pOperand, pOperator, pPostOperator, typeUsage);
+   }
+
+   return expression;
+}
+
+Expression* Environment::parseExpressionCast(ParsingContext& pContext, CastType pCastType,
+   size_t pTokenLastIndex)
+{
+   if(pCastType == CastType::Dynamic && CflatHasFlag(mSettings, Settings::DisallowDynamicCast))
+   {
+      throwCompileError(pContext, CompileError::DynamicCastNotAllowed);
+      return nullptr;
+   }
+
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t& tokenIndex = pContext.mTokenIndex;
+   Expression* expression = nullptr;
+
+   if(tokens[tokenIndex].mStart[0] == '<')
+   {
+      tokenIndex++;
+      const TypeUsage targetTypeUsage = parseTypeUsage(pContext, pTokenLastIndex - 1u);
+
+      if(targetTypeUsage.mType)
+      {
+         if(tokens[tokenIndex].mStart[0] == '>')
+         {
+            tokenIndex++;
+
+            if(tokens[tokenIndex].mStart[0] == '(')
+            {
+               const size_t closureTokenIndex =
+                  findClosureTokenIndex(pContext, '(', ')', pTokenLastIndex);
+
+               if(closureTokenIndex > 0u)
+               {
+                  tokenIndex++;
+
+                  Expression* expressionToCast =
+                     parseExpression(pContext, closureTokenIndex - 1u);
+
+                  if(expressionToCast)
+                  {
+                     const TypeUsage& sourceTypeUsage = getTypeUsage(pContext, expressionToCast);
+
+                     if(isCastAllowed(pCastType, sourceTypeUsage, targetTypeUsage))
+                     {
+                        expression = (ExpressionCast*)CflatMalloc(sizeof(ExpressionCast));
+                        CflatInvokeCtor(ExpressionCast, expression)
+                           (pCastType, targetTypeUsage, expressionToCast);
+                     }
+                     else
+                     {
+                        throwCompileError(pContext, CompileError::InvalidCast);
+                     }
+                  }
+               }
+               else
+               {
+                  tokenIndex = pTokenLastIndex - 1u;
+                  throwCompileErrorUnexpectedSymbol(pContext);
+               }
+            }
+            else
+            {
+               throwCompileErrorUnexpectedSymbol(pContext);
+            }
+         }
+      }
+      else
+      {
+         throwCompileErrorUnexpectedSymbol(pContext);
+      }
+   }
+   else
+   {
+      throwCompileErrorUnexpectedSymbol(pContext);
+   }
+
+   return expression;
+}
+
+Expression* Environment::parseExpressionFunctionCall(ParsingContext& pContext,
+   const Identifier& pFunctionIdentifier)
+{
+   ExpressionFunctionCall* expression =
+      (ExpressionFunctionCall*)CflatMalloc(sizeof(ExpressionFunctionCall));
+   CflatInvokeCtor(ExpressionFunctionCall, expression)(pFunctionIdentifier);
+
+   parseFunctionCallArguments(pContext, &expression->mArguments, &expression->mTemplateTypes);
+
+   if(!pContext.mErrorMessage.empty())
+   {
+      return nullptr;
+   }
+
+   CflatArgsVector(TypeUsage) argumentTypes;
+
+   for(size_t i = 0u; i < expression->mArguments.size(); i++)
+   {
+      const TypeUsage& typeUsage = getTypeUsage(pContext, expression->mArguments[i]);
+      argumentTypes.push_back(typeUsage);
+   }
+
+   CflatArgsVector(TypeUsage) templateTypes;
+   toArgsVector(expression->mTemplateTypes, templateTypes);
+
+   expression->mFunction = findFunction(pContext, pFunctionIdentifier, argumentTypes, templateTypes);
+
+   if(!expression->mFunction)
+   {
+      const char* lastSeparator = pFunctionIdentifier.findLastSeparator();
+
+      if(lastSeparator)
+      {
+         char buffer[kDefaultLocalStringBufferSize];
+         const size_t typeIdentifierLength = lastSeparator - pFunctionIdentifier.mName;
+         strncpy(buffer, pFunctionIdentifier.mName, typeIdentifierLength);
+         buffer[typeIdentifierLength] = '\0';
+         const Identifier typeIdentifier(buffer);
+         const Identifier staticMethodIdentifier(lastSeparator + 2);
+
+         Type* type = findType(pContext, typeIdentifier);
+
+         if(type && type->mCategory == TypeCategory::StructOrClass)
+         {
+            Struct* castType = static_cast<Struct*>(type);
+            expression->mFunction =
+               castType->findStaticMethod(staticMethodIdentifier, argumentTypes, templateTypes);
+
+            if(!expression->mFunction)
+            {
+               CflatSTLString typeFullName;
+               getTypeFullName(type, &typeFullName);
+
+               throwCompileError(pContext, CompileError::MissingStaticMethod,
+                  staticMethodIdentifier.mName, typeFullName.c_str());
+            }
+         }
+      }
+   }
+
+   if(expression->mFunction)
+   {
+      expression->assignTypeUsage(mTypeUsageVoid);
+   }
+   else
+   {
+      CflatInvokeDtor(ExpressionFunctionCall, expression);
+      CflatFree(expression);
+      expression = nullptr;
+
+      throwCompileError(pContext, CompileError::UndefinedFunction, pFunctionIdentifier.mName);
+   }
+
+   return expression;
+}
+
+Expression* Environment::parseExpressionMethodCall(ParsingContext& pContext, Expression* pMemberAccess)
+{
+   ExpressionMethodCall* expression = 
+      (ExpressionMethodCall*)CflatMalloc(sizeof(ExpressionMethodCall));
+   CflatInvokeCtor(ExpressionMethodCall, expression)(pMemberAccess);
+
+   pContext.mTokenIndex++;
+   parseFunctionCallArguments(pContext, &expression->mArguments, &expression->mTemplateTypes);
+
+   if(!pContext.mErrorMessage.empty())
+   {
+      return nullptr;
+   }
+
+   ExpressionMemberAccess* memberAccess = static_cast<ExpressionMemberAccess*>(pMemberAccess);
+   const TypeUsage& methodOwnerTypeUsage = getTypeUsage(pContext, memberAccess->mMemberOwner);
+   CflatAssert(methodOwnerTypeUsage.mType);
+   CflatAssert(methodOwnerTypeUsage.mType->mCategory == TypeCategory::StructOrClass);
+
+   Struct* methodOwnerType = static_cast<Struct*>(methodOwnerTypeUsage.mType);
+   CflatArgsVector(TypeUsage) argumentTypes;
+
+   for(size_t i = 0u; i < expression->mArguments.size(); i++)
+   {
+      const TypeUsage& typeUsage = getTypeUsage(pContext, expression->mArguments[i]);
+      argumentTypes.push_back(typeUsage);
+   }
+
+   CflatArgsVector(TypeUsage) templateTypes;
+   toArgsVector(expression->mTemplateTypes, templateTypes);
+
+   const Identifier& methodId = memberAccess->mMemberIdentifier;
+   expression->mMethodUsage =
+      methodOwnerType->findMethodUsage(methodId, 0u, argumentTypes, templateTypes);
+
+   if(expression->mMethodUsage.mMethod)
+   {
+      expression->assignTypeUsage(mTypeUsageVoid);
+   }
+   else
+   {
+      CflatSTLString typeFullName;
+      getTypeFullName(methodOwnerType, &typeFullName);
+
+      throwCompileError(pContext, CompileError::MissingMethod, methodId.mName, typeFullName.c_str());
+   }
+
+   return expression;
+}
+
+Expression* Environment::parseExpressionObjectConstruction(ParsingContext& pContext, Type* pType)
+{
+   ExpressionObjectConstruction* expression =
+      (ExpressionObjectConstruction*)CflatMalloc(sizeof(ExpressionObjectConstruction));
+   CflatInvokeCtor(ExpressionObjectConstruction, expression)(pType);
+
+   parseFunctionCallArguments(pContext, &expression->mArguments);
+
+   if(!pContext.mErrorMessage.empty())
+   {
+      return nullptr;
+   }
+
+   CflatArgsVector(TypeUsage) argumentTypes;
+
+   for(size_t i = 0u; i < expression->mArguments.size(); i++)
+   {
+      const TypeUsage& typeUsage = getTypeUsage(pContext, expression->mArguments[i]);
+      argumentTypes.push_back(typeUsage);
+   }
+
+   if(pType->mCategory == TypeCategory::StructOrClass)
+   {
+      Struct* type = static_cast<Struct*>(pType);
+      expression->mConstructor = type->findConstructor(argumentTypes);
+   }
+
+   if(!expression->mConstructor)
+   {
+      CflatSTLString typeFullName;
+      getTypeFullName(pType, &typeFullName);
+
+      throwCompileError(pContext, CompileError::MissingConstructor, typeFullName.c_str());
+   }
+
+   return expression;
+}
+
+Expression* Environment::parseExpressionAggregateInitialization(ParsingContext& pContext, Type* pType,
+   size_t pTokenLastIndex)
+{
+   CflatAssert(pType->mCategory == TypeCategory::StructOrClass);
+   Struct* type = static_cast<Struct*>(pType);
+
+   ExpressionAggregateInitialization* expression =
+      (ExpressionAggregateInitialization*)CflatMalloc(sizeof(ExpressionAggregateInitialization));
+   CflatInvokeCtor(ExpressionAggregateInitialization, expression)(pType);
+
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t& tokenIndex = pContext.mTokenIndex;
+   tokenIndex++;
+
+   size_t typeMemberIndex = 0u;
+   const size_t closureIndex = findClosureTokenIndex(pContext, '{', '}', pTokenLastIndex);
+
+   while(tokenIndex < closureIndex)
+   {
+      if(typeMemberIndex == type->mMembers.size())
+      {
+         throwCompileError(pContext, Environment::CompileError::TooManyArgumentsInAggregate);
+         break;
+      }
+
+      const size_t separatorIndex = findSeparationTokenIndex(pContext, ',', closureIndex);
+      const size_t lastValueIndex = separatorIndex > 0u
+         ? separatorIndex - 1u
+         : closureIndex - 1u;
+
+      Expression* valueExpression = parseExpression(pContext, lastValueIndex);
+      expression->mValues.push_back(valueExpression);
+
+      if(valueExpression)
+      {
+         const TypeHelper::Compatibility compatibility = TypeHelper::getCompatibility(
+            valueExpression->getTypeUsage(), type->mMembers[typeMemberIndex]->mTypeUsage);
+
+         if(compatibility == TypeHelper::Compatibility::Incompatible)
+         {
+            throwCompileError(pContext, Environment::CompileError::MismatchingTypeInAggregate,
+               type->mMembers[typeMemberIndex]->mIdentifier.mName);
+            break;
+         }
+      }
+      else
+      {
+         break;
+      }
+
+      tokenIndex = lastValueIndex + 2u;
+      typeMemberIndex++;
+   }
+
+   return expression;
+}
+
+size_t Environment::findClosureTokenIndex(ParsingContext& pContext, char pOpeningChar, char pClosureChar,
+   size_t pTokenIndexLimit) const
+{
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t closureTokenIndex = 0u;
+
+   if(pTokenIndexLimit == 0u)
+   {
+      pTokenIndexLimit = pContext.mTokens.size() - 1u;
+   }
+
+   if(tokens[pContext.mTokenIndex].mStart[0] == pClosureChar)
+   {
+      closureTokenIndex = pContext.mTokenIndex;
+   }
+   else if(!pContext.mTokensIndex.isBuilt(tokens) ||
+      !pContext.mTokensIndex.findClosure(pContext.mTokenIndex, pOpeningChar, pClosureChar,
+         pTokenIndexLimit, &closureTokenIndex))
+   {
+      uint32_t scopeLevel = 0u;
+
+      for(size_t i = (pContext.mTokenIndex + 1u); i <= pTokenIndexLimit; i++)
+      {
+         if(tokens[i].mLength > 1u)
+         {
+            continue;
+         }
+
+         if(tokens[i].mStart[0] == pClosureChar)
+         {
+            if(scopeLevel == 0u)
+            {
+               closureTokenIndex = i;
+               break;
+            }
+
+            scopeLevel--;
+         }
+         else if(tokens[i].mStart[0] == pOpeningChar)
+         {
+            scopeLevel++;
+         }
+      }
+   }
+
+   return closureTokenIndex;
+}
+
+size_t Environment::findOpeningTokenIndex(ParsingContext& pContext, char pOpeningChar, char pClosureChar,
+   size_t pClosureIndex) const
+{
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t openingTokenIndex = pClosureIndex;
+
+   if(pContext.mTokensIndex.isBuilt(tokens) &&
+      pContext.mTokensIndex.findOpening(pContext.mTokenIndex, pOpeningChar, pClosureChar,
+         pClosureIndex, &openingTokenIndex))
+   {
+      return openingTokenIndex;
+   }
+
+   if(openingTokenIndex > 0u)
+   {
+      uint32_t scopeLevel = 0u;
+
+      for(int i = (int)pClosureIndex - 1; i >= (int)pContext.mTokenIndex; i--)
+      {
+         if(tokens[i].mLength > 1u)
+         {
+            continue;
+         }
+
+         if(tokens[i].mStart[0] == pOpeningChar)
+         {
+            if(scopeLevel == 0u)
+            {
+               openingTokenIndex = i;
+               break;
+            }
+
+            scopeLevel--;
+         }
+         else if(tokens[i].mStart[0] == pClosureChar)
+         {
+            scopeLevel++;
+         }
+      }
+   }
+
+   return openingTokenIndex;
+}
+
+size_t Environment::findSeparationTokenIndex(ParsingContext& pContext, char pSeparationChar,
+   size_t pClosureIndex) const
+{
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t separationTokenIndex = 0u;
+
+   if(pContext.mTokensIndex.isBuilt(tokens) &&
+      pContext.mTokensIndex.findSeparation(pContext.mTokenIndex, pSeparationChar, pClosureIndex,
+         &separationTokenIndex))
+   {
+      return separationTokenIndex;
+   }
+
+   uint32_t scopeLevel = 0u;
+
+   for(size_t i = pContext.mTokenIndex; i < pClosureIndex; i++)
+   {
+      if(tokens[i].mLength > 1u)
+      {
+         continue;
+      }
+
+      if(i > pContext.mTokenIndex && tokens[i].mStart[0] == pSeparationChar && scopeLevel == 0u)
+      {
+         separationTokenIndex = i;
+         break;
+      }
+
+      if(tokens[i].mStart[0] == '(' || tokens[i].mStart[0] == '{')
+      {
+         scopeLevel++;
+      }
+      else if(tokens[i].mStart[0] == ')' || tokens[i].mStart[0] == '}')
+      {
+         scopeLevel--;
+      }
+   }
+
+   return separationTokenIndex;
+}
+
+uint8_t Environment::getBinaryOperatorPrecedence(ParsingContext& pContext, size_t pTokenIndex) const
+{
+   const Token& token = pContext.mTokens[pTokenIndex];
+   CflatAssert(token.mType == TokenType::Operator);
+
+   uint8_t precedence = 0u;
+
+   for(size_t i = 0u; i < kCflatBinaryOperatorsCount; i++)
+   {
+      const size_t operatorLength = strlen(kCflatBinaryOperators[i]);
+
+      if(token.mLength == operatorLength &&
+         strncmp(token.mStart, kCflatBinaryOperators[i], operatorLength) == 0)
+      {
+         precedence = kCflatBinaryOperatorsPrecedence[i];
+         break;
+      }
+   }
+
+   return precedence;
+}
+
+bool Environment::isTemplate(ParsingContext& pContext, size_t pOpeningTokenIndex, size_t pClosureTokenIndex) const
+{
+   if(pClosureTokenIndex <= pOpeningTokenIndex)
+      return false;
+
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+
+   const Token& openingToken = tokens[pOpeningTokenIndex];
+
+   if(openingToken.mLength != 1u || openingToken.mStart[0] != '<')
+      return false;
+
+   const Token& closureToken = tokens[pClosureTokenIndex];
+
+   if(closureToken.mLength != 1u || closureToken.mStart[0] != '>')
+      return false;
+
+   for(size_t operatorTokenIndex = pOpeningTokenIndex + 1u;
+      operatorTokenIndex < pClosureTokenIndex;
+      operatorTokenIndex++)
+   {
+      if(tokens[operatorTokenIndex].mType == TokenType::Operator)
+      {
+         if(tokens[operatorTokenIndex].mStart[0] == '<' && tokens[operatorTokenIndex].mLength == 1u)
+         {
+            const size_t cachedTokenIndex = pContext.mTokenIndex;
+            pContext.mTokenIndex = operatorTokenIndex;
+            const size_t innerTemplateClosureTokenIndex =
+               findClosureTokenIndex(pContext, '<', '>', pClosureTokenIndex - 1u);
+            pContext.mTokenIndex = cachedTokenIndex;
+
+            if(isTemplate(pContext, operatorTokenIndex, innerTemplateClosureTokenIndex))
+            {
+               operatorTokenIndex = innerTemplateClosureTokenIndex;
+               continue;
+            }
+            else
+            {
+               return false;
+            }
+         }
+
+         bool isPointerOrRefOperator = false;
+
+         if(tokens[operatorTokenIndex].mLength == 1u &&
+            (tokens[operatorTokenIndex].mStart[0] == '*' || tokens[operatorTokenIndex].mStart[0] == '&'))
+         {
+            for(size_t i = operatorTokenIndex - 1u; i > pOpeningTokenIndex; i--)
+            {
+               const size_t cachedTokenIndex = pContext.mTokenIndex;
+               pContext.mTokenIndex = i;
+               const TypeUsage typeUsage = parseTypeUsage(pContext, operatorTokenIndex);
+               pContext.mTokenIndex = cachedTokenIndex;
+
+               isPointerOrRefOperator =
+                  typeUsage.mType && (typeUsage.isPointer() || typeUsage.isReference());
+
+               if(isPointerOrRefOperator)
+               {
+                  break;
+               }
+            }
+         }
+
+         if(!isPointerOrRefOperator)
+         {
+            return false;
+         }
+      }
+   }
+
+   return true;
+}
+
+bool Environment::isTemplate(ParsingContext& pContext, size_t pTokenLastIndex) const
+{
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t& tokenIndex = pContext.mTokenIndex;
+
+   if(tokens[tokenIndex].mLength != 1u || tokens[tokenIndex].mStart[0] != '<')
+      return false;
+
+   const size_t templateClosureTokenIndex =
+      findClosureTokenIndex(pContext, '<', '>', pTokenLastIndex);
+
+   return isTemplate(pContext, tokenIndex, templateClosureTokenIndex);
+}
+
+bool Environment::isCastAllowed(CastType pCastType, const TypeUsage& pFrom, const TypeUsage& pTo) const
+{
+   if(!pFrom.mType || !pTo.mType)
+   {
+      return false;
+   }
+
+   if(pTo == pFrom)
+   {
+      return true;
+   }
+
+   if(pFrom.isPointer() && pTo.isPointer() && (pFrom == mTypeUsageVoidPtr || pTo == mTypeUsageVoidPtr))
+   {
+      return true;
+   }
+
+   if(pTo == mTypeUsageVoid && pCastType == CastType::CStyle)
+   {
+      return true;
+   }
+
+   bool castAllowed = false;
+
+   switch(pCastType)
+   {
+   case CastType::CStyle:
+   case CastType::Static:
+      if(pFrom.mType->mCategory == TypeCategory::BuiltIn &&
+         pTo.mType->mCategory == TypeCategory::BuiltIn)
+      {
+         castAllowed = true;
+      }
+      else if(pFrom.mType->isInteger() && pTo.mType->isInteger())
+      {
+         castAllowed = true;
+      }
+      else if(pFrom.mType->isInteger() && pTo.mType->isDecimal())
+      {
+         castAllowed = true;
+      }
+      else if(pFrom.mType->isDecimal() && pTo.mType->isInteger())
+      {
+         castAllowed = true;
+      }
+      else if(pFrom.mType->mCategory == TypeCategory::EnumClass &&
+         pTo.mType->mCategory == TypeCategory::BuiltIn)
+      {
+         castAllowed = true;
+      }
+      else if(pFrom.mType->mCategory == TypeCategory::BuiltIn &&
+         pTo.mType->mCategory == TypeCategory::EnumClass)
+      {
+         castAllowed = true;
+      }
+      else if(pFrom.mType->mCategory == TypeCategory::StructOrClass &&
+         pFrom.isPointer() &&
+         pTo.mType->mCategory == TypeCategory::StructOrClass &&
+         pTo.isPointer())
+      {
+         Struct* sourceType = static_cast<Struct*>(pFrom.mType);
+         Struct* targetType = static_cast<Struct*>(pTo.mType);
+         castAllowed =
+            sourceType->derivedFrom(targetType) || targetType->derivedFrom(sourceType);
+      }
+      break;
+   case CastType::Dynamic:
+      castAllowed =
+         pFrom.isPointer() &&
+         pFrom.mType->mCategory == TypeCategory::StructOrClass &&
+         pTo.isPointer() &&
+         pTo.mType->mCategory == TypeCategory::StructOrClass;
+      break;
+   case CastType::Reinterpret:
+      castAllowed =
+         pFrom.isPointer() &&
+         pTo.isPointer();
+      break;
+   case CastType::Const:
+      castAllowed = pFrom.mType == pTo.mType;
+      break;
+   default:
+      break;
+   }
+
+   return castAllowed;
+}
+
+bool Environment::isMethodCallAllowed(Method* pMethod, const TypeUsage& pOwnerTypeUsage) const
+{
+   if(!CflatHasFlag(pMethod->mFlags, MethodFlags::Const))
+   {
+      if((pOwnerTypeUsage.isPointer() && pOwnerTypeUsage.isConstPointer()) ||
+         (!pOwnerTypeUsage.isPointer() && pOwnerTypeUsage.isConst()))
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+Statement* Environment::parseStatement(ParsingContext& pContext)
+{
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t& tokenIndex = pContext.mTokenIndex;
+   const Token& token = tokens[tokenIndex];
+
+   Statement* statement = nullptr;
+   const uint16_t statementLine = token.mLine;
+
+   if(token.mType == TokenType::Punctuation && (token.mStart[0] == '{' || token.mStart[0] == '}'))
+   {
+      // block
+      if(token.mStart[0] == '{')
+      {
+         statement = parseStatementBlock(pContext, true, false);
+      }
+   }
+   else if(token.mType == TokenType::Keyword &&
+      strncmp(token.mStart, "const", 5u) != 0 &&
+      strncmp(token.mStart, "static", 6u) != 0 &&
+      strncmp(token.mStart, "void", 4u) != 0)
+   {
+      // if
+      if(strncmp(token.mStart, "if", 2u) == 0)
+      {
+         tokenIndex++;
+         statement = parseStatementIf(pContext);
+      }
+      // switch
+      else if(strncmp(token.mStart, "switch", 6u) == 0)
+      {
+         tokenIndex++;
+         statement = parseStatementSwitch(pContext);
+      }
+      // while
+      else if(strncmp(token.mStart, "while", 5u) == 0)
+      {
+         tokenIndex++;
+         statement = parseStatementWhile(pContext);
+      }
+      // do
+      else if(strncmp(token.mStart, "do", 2u) == 0)
+      {
+         tokenIndex++;
+         statement = parseStatementDoWhile(pContext);
+      }
+      // for
+      else if(strncmp(token.mStart, "for", 3u) == 0)
+      {
+         tokenIndex++;
+         statement = parseStatementFor(pContext);
+      }
+      // break
+      else if(strncmp(token.mStart, "break", 5u) == 0)
+      {
+         tokenIndex++;
+         statement = parseStatementBreak(pContext);
+      }
+      // continue
+      else if(strncmp(token.mStart, "continue", 8u) == 0)
+      {
+         tokenIndex++;
+         statement = parseStatementContinue(pContext);
+      }
+      // return
+      else if(strncmp(token.mStart, "return", 6u) == 0)
+      {
+         tokenIndex++;
+         statement = parseStatementReturn(pContext);
+      }
+      // using
+      else if(strncmp(token.mStart, "using", 5u) == 0)
+      {
+         tokenIndex++;
+         statement = parseStatementUsingDirective(pContext);
+      }
+      // struct
+      else if(strncmp(token.mStart, "struct", 6u) == 0)
+      {
+         tokenIndex++;
+         statement = parseStatementStructDeclaration(pContext);
+      }
+      // namespace
+      else if(strncmp(token.mStart, "namespace", 9u) == 0)
+      {
+         tokenIndex++;
+         statement = parseStatementNamespaceDeclaration(pContext);
+      }
+      // typedef
+      else if(strncmp(token.mStart, "typedef", 7u) == 0)
+      {
+         tokenIndex++;
+         statement = parseStatementTypeDefinition(pContext);
+      }
+      // (unexpected)
+      else
+      {
+         throwCompileErrorUnexpectedSymbol(pContext);
+      }
+   }
+   else
+   {
+      // static?
+      bool staticDeclaration = false;
+
+      if(token.mLength == 6u && strncmp(token.mStart, "static", 6u) == 0)
+      {
+         staticDeclaration = true;
+         tokenIndex++;
+      }
+
+      // type
+      TypeUsage typeUsage = parseTypeUsage(pContext, 0u);
+
+      if(typeUsage.mType)
+      {
+         const Token& identifierToken = tokens[tokenIndex];
+         pContext.mStringBuffer.assign(identifierToken.mStart, identifierToken.mLength);
+         const Identifier identifier(pContext.mStringBuffer.c_str());
+         tokenIndex++;
+
+         if(tokens[tokenIndex].mType != TokenType::Operator &&
+            tokens[tokenIndex].mType != TokenType::Punctuation)
+         {
+            pContext.mStringBuffer.assign(token.mStart, token.mLength);
+            throwCompileError(pContext, CompileError::UnexpectedSymbol, pContext.mStringBuffer.c_str());
+            return nullptr;
+         }
+
+         if (!pContext.mStringBuffer.empty() && !Tokenizer::isValidIdentifierBeginningCharacter(*pContext.mStringBuffer.c_str()))
+         {
+            throwCompileError(pContext, CompileError::UnexpectedSymbol, pContext.mStringBuffer.c_str());
+            return nullptr;
+         }
+
+         bool isFunctionDeclaration = tokens[tokenIndex].mStart[0] == '(';
+
+         if(isFunctionDeclaration)
+         {
+             size_t savedTokenIndex = tokenIndex;
+             // Check if the next token after the opening parenthesis is either a
+             // typeusage or a closing parenthesis. This would be indicating that
+             // we're dealing with a function declaration and not a variable
+             // declaration.
+             tokenIndex++;
+
+             if ((savedTokenIndex + 1u) < tokens.size() &&
+                 tokens[savedTokenIndex + 1].mStart[0] != ')')
+             {
+                 // The next token after the opening parenthesis is not a  closing parenthesis
+
+                 // Checks if the next token after the opening parenthesis is a type description which
+                 // would indicate that it is a function declaration
+                 TypeUsage parameterTypeUsage = parseTypeUsage(pContext, 0u);
+                 if (!parameterTypeUsage.mType)
+                 {
+                     // Would indicate object construction/variable declaration
+                     isFunctionDeclaration = false;
+                 }
+             }
+
+             tokenIndex = savedTokenIndex;
+         }
+
+         // function declaration
+         if(isFunctionDeclaration)
+         {
+            tokenIndex--;
+            statement = parseStatementFunctionDeclaration(pContext, typeUsage, staticDeclaration);
+         }
+         // variable / const declaration
+         else
+         {
+            if(typeUsage.mType != mTypeVoid || typeUsage.mPointerLevel > 0u)
+            {
+               statement =
+                  parseStatementVariableDeclaration(pContext, typeUsage, identifier, staticDeclaration);
+            }
+            else
+            {
+               throwCompileError(pContext, Environment::CompileError::InvalidType, "void");
+            }
+         }
+      }
+      // expression
+      else
+      {
+         const size_t closureTokenIndex = findClosureTokenIndex(pContext, 0, ';');
+
+         if(closureTokenIndex == 0u)
+         {
+            throwCompileError(pContext, CompileError::Expected, ";");
+            return nullptr;
+         }
+
+         Expression* expression = parseExpression(pContext, closureTokenIndex - 1u);
+         tokenIndex = closureTokenIndex;
+
+         statement = (StatementExpression*)CflatMalloc(sizeof(StatementExpression));
+         CflatInvokeCtor(StatementExpression, statement)(expression);
+      }
+   }
+
+   if(statement)
+   {
+      statement->mProgram = pContext.mProgram;
+      statement->mLine = statementLine;
+   }
+
+   return statement;
+}
+
+StatementBlock* Environment::parseStatementBlock(ParsingContext& pContext,
+   bool pAlterScope, bool pAllowInGlobalScope)
+{
+   if(!pAllowInGlobalScope && pContext.mScopeLevel == 0u)
+   {
+      throwCompileErrorUnexpectedSymbol(pContext);
+      return nullptr;
+   }
+
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t& tokenIndex = pContext.mTokenIndex;
+   const Token& token = tokens[tokenIndex];
+
+   if(token.mStart[0] != '{')
+   {
+      throwCompileError(pContext, CompileError::Expected, "{");
+      return nullptr;
+   }
+
+   StatementBlock* block = (StatementBlock*)CflatMalloc(sizeof(StatementBlock));
+   CflatInvokeCtor(StatementBlock, block)(pAlterScope);
+
+   const size_t closureTokenIndex = findClosureTokenIndex(pContext, '{', '}');
+
+   if(closureTokenIndex > 0u)
+   {
+      incrementBlockLevel(pContext);
+
+      if(pAlterScope)
+      {
+         incrementScopeLevel(pContext);
+
+         if(!pContext.mSharedAccess)
+         {
+            incrementScopeLevel(mExecutionContext);
+         }
+      }
+
+      while(tokenIndex < closureTokenIndex)
+      {
+         tokenIndex++;
+         Statement* statement = parseStatement(pContext);
+
+         if(statement)
+         {
+            block->mStatements.push_back(statement);
+         }
+
+         if(!pContext.mErrorMessage.empty())
+         {
+            break;
+         }
+      }
+
+      if(pAlterScope)
+      {
+         if(!pContext.mSharedAccess)
+         {
+            decrementScopeLevel(mExecutionContext);
+         }
+
+         decrementScopeLevel(pContext);
+      }
+
+      decrementBlockLevel(pContext);
+   }
+   else
+   {
+      throwCompileError(pContext, CompileError::Expected, "}");
+   }
+
+   if(pContext.mErrorMessage.empty())
+   {
+      block->mProgram = pContext.mProgram;
+      block->mLine = token.mLine;
+   }
+   else
+   {
+      CflatInvokeDtor(StatementBlock, block);
+      CflatFree(block);
+      block = nullptr;
+   }
+
+   return block;
+}
+
+StatementUsingDirective* Environment::parseStatementUsingDirective(ParsingContext& pContext)
+{
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t& tokenIndex = pContext.mTokenIndex;
+   const Token& token = tokens[tokenIndex];
+
+   StatementUsingDirective* statement = nullptr;
+   const size_t closureTokenIndex = findClosureTokenIndex(pContext, 0, ';');
+
+   if(closureTokenIndex > 0u)
+   {
+      if(strncmp(token.mStart, "namespace", 9u) == 0)
+      {
+         tokenIndex++;
+         Token& namespaceToken = const_cast<Token&>(pContext.mTokens[tokenIndex]);
+         pContext.mStringBuffer.clear();
+
+         do
+         {
+            pContext.mStringBuffer.append(namespaceToken.mStart, namespaceToken.mLength);
+            tokenIndex++;
+            namespaceToken = tokens[tokenIndex];
+         }
+         while(*namespaceToken.mStart != ';');
+
+         const Identifier identifier(pContext.mStringBuffer.c_str());
+         Namespace* ns = nullptr;
+
+         for(int i = (int)pContext.mNamespaceStack.size() - 1; i >= 0; i--)
+         {
+            ns = pContext.mNamespaceStack[i]->getNamespace(identifier);
+
+            if(ns)
+            {
+               break;
+            }
+         }
+
+         if(ns)
+         {
+            UsingDirective usingDirective(ns);
+            usingDirective.mBlockLevel = pContext.mBlockLevel;
+            pContext.mUsingDirectives.push_back(usingDirective);
+
+            statement = (StatementUsingDirective*)CflatMalloc(sizeof(StatementUsingDirective));
+            CflatInvokeCtor(StatementUsingDirective, statement)(ns);
+         }
+         else
+         {
+            throwCompileError(pContext, CompileError::UnknownNamespace, identifier.mName);
+         }
+      }
+      else if(tokenIndex < closureTokenIndex && tokens[tokenIndex].mType == TokenType::Identifier)
+      {
+         const size_t equalTokenIndex = findClosureTokenIndex(pContext, 0, '=', closureTokenIndex);
+
+         if(equalTokenIndex > 0u)
+         {
+            pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
+            const Identifier alias(pContext.mStringBuffer.c_str());
+            tokenIndex++;
+
+            if(tokenIndex == equalTokenIndex)
+            {
+               tokenIndex++;
+
+               const TypeUsage typeUsage = parseTypeUsage(pContext, closureTokenIndex - 1u);
+
+               if(typeUsage.mType && tokenIndex == closureTokenIndex)
+               {
+                  registerTypeAlias(pContext, alias, typeUsage);
+
+                  statement = (StatementUsingDirective*)CflatMalloc(sizeof(StatementUsingDirective));
+                  CflatInvokeCtor(StatementUsingDirective, statement)(alias, typeUsage);
+               }
+               else
+               {
+                  throwCompileErrorUnexpectedSymbol(pContext);
+               }
+            }
+            else
+            {
+               throwCompileErrorUnexpectedSymbol(pContext);
+            }
+         }
+         else
+         {
+            const TypeUsage typeUsage = parseTypeUsage(pContext, closureTokenIndex - 1u);
+
+            if(typeUsage.mType && tokenIndex == closureTokenIndex && typeUsage.mFlags == 0u)
+            {
+               const Identifier& alias = typeUsage.mType->mIdentifier;
+               registerTypeAlias(pContext, alias, typeUsage);
+
+               statement = (StatementUsingDirective*)CflatMalloc(sizeof(StatementUsingDirective));
+               CflatInvokeCtor(StatementUsingDirective, statement)(alias, typeUsage);
+            }
+            else
+            {
+               throwCompileErrorUnexpectedSymbol(pContext);
+            }
+         }
+      }
+      else
+      {
+         throwCompileError(pContext, CompileError::UnexpectedSymbol, "using");
+      }
+
+      tokenIndex = closureTokenIndex;
+   }
+   else
+   {
+      throwCompileError(pContext, CompileError::Expected, ";");
+   }
+
+   return statement;
+}
+
+StatementTypeDefinition* Environment::parseStatementTypeDefinition(ParsingContext& pContext)
+{
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t& tokenIndex = pContext.mTokenIndex;
+
+   StatementTypeDefinition* statement = nullptr;
+   const size_t closureTokenIndex = findClosureTokenIndex(pContext, 0, ';');
+
+   if(closureTokenIndex > 0u)
+   {
+      const TypeUsage typeUsage = parseTypeUsage(pContext, closureTokenIndex - 1u);
+
+      if(typeUsage.mType)
+      {
+         if(tokenIndex == (closureTokenIndex - 1u) && tokens[tokenIndex].mType == TokenType::Identifier)
+         {
+            pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
+            const Identifier alias(pContext.mStringBuffer.c_str());
+            registerTypeAlias(pContext, alias, typeUsage);
+
+            statement = (StatementTypeDefinition*)CflatMalloc(sizeof(StatementTypeDefinition));
+            CflatInvokeCtor(StatementTypeDefinition, statement)(alias, typeUsage);
+         }
+         else
+         {
+            throwCompileErrorUnexpectedSymbol(pContext);
+         }
+      }
+      else
+      {
+         pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
+         throwCompileError(pContext, CompileError::UndefinedType, pContext.mStringBuffer.c_str());
+      }
+
+      tokenIndex = closureTokenIndex;
+   }
+   else
+   {
+      throwCompileError(pContext, CompileError::Expected, ";");
+   }
+
+   return statement;
+}
+
+StatementNamespaceDeclaration* Environment::parseStatementNamespaceDeclaration(ParsingContext& pContext)
+{
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t& tokenIndex = pContext.mTokenIndex;
+   const Token& token = tokens[tokenIndex];
+
+   StatementNamespaceDeclaration* statement = nullptr;
+
+   if(token.mType == TokenType::Identifier)
+   {
+      pContext.mStringBuffer.assign(token.mStart, token.mLength);
+      const Identifier nsIdentifier(pContext.mStringBuffer.c_str());
+
+      Namespace* ns = pContext.mSharedAccess
+         ? pContext.mNamespaceStack.back()->getNamespace(nsIdentifier)
+         : pContext.mNamespaceStack.back()->requestNamespace(nsIdentifier);
+
+      if(!ns)
+      {
+         requireWriteAccess(pContext);
+         return nullptr;
+      }
+
+      // the namespaces of the execution context are only needed for evaluating the constants
+      // in namespace scope, which does not happen when parsing with shared access
+      pContext.mNamespaceStack.push_back(ns);
+
+      if(!pContext.mSharedAccess)
+      {
+         mExecutionContext.mNamespaceStack.push_back(ns);
+      }
+
+      statement = (StatementNamespaceDeclaration*)CflatMalloc(sizeof(StatementNamespaceDeclaration));
+      CflatInvokeCtor(StatementNamespaceDeclaration, statement)(nsIdentifier);
+
+      tokenIndex++;
+      statement->mBody = parseStatementBlock(pContext, false, true);
+
+      if(!pContext.mSharedAccess)
+      {
+         mExecutionContext.mNamespaceStack.pop_back();
+      }
+
+      pContext.mNamespaceStack.pop_back();
+   }
+   else
+   {
+      throwCompileError(pContext, CompileError::UnexpectedSymbol, "namespace");
+   }
+
+   return statement;
+}
+
+StatementVariableDeclaration* Environment::parseStatementVariableDeclaration(ParsingContext& pContext,
+   TypeUsage& pTypeUsage, const Identifier& pIdentifier, bool pStatic)
+{
+   if(pStatic &&
+      CflatHasFlag(mSettings, Settings::DisallowStaticPointers) &&
+      pTypeUsage.isPointer() &&
+      pTypeUsage != mTypeUsageCString &&
+      pTypeUsage != mTypeUsageWideString)
+   {
+      throwCompileError(pContext, CompileError::StaticPointersNotAllowed);
+      return nullptr;
+   }
+
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t& tokenIndex = pContext.mTokenIndex;
+   const Token& token = tokens[tokenIndex];
+
+   StatementVariableDeclaration* statement = nullptr;
+
+   bool instanceAlreadyRegistered =
+      pContext.mLocalInstancesHolder.retrieveInstance(pIdentifier, pContext.mScopeLevel) != nullptr;
+
+   if(!instanceAlreadyRegistered)
+   {
+      for(size_t i = 0u; i < pContext.mRegisteredInstances.size(); i++)
+      {
+         if(pContext.mRegisteredInstances[i].mIdentifier == pIdentifier &&
+            pContext.mRegisteredInstances[i].mNamespace == pContext.mNamespaceStack.back() &&
+            pContext.mRegisteredInstances[i].mScopeLevel == pContext.mScopeLevel)
+         {
+            instanceAlreadyRegistered = true;
+            break;
+         }
+      }
+   }
+
+   if(!instanceAlreadyRegistered)
+   {
+      Expression* initialValueExpression = nullptr;
+
+      // array
+      if(token.mStart[0] == '[')
+      {
+         uint16_t arraySize = 0u;
+
+         const size_t arrayClosure = findClosureTokenIndex(pContext, '[', ']');
+         const bool arraySizeSpecified = arrayClosure > (tokenIndex + 1u);
+
+         if(arraySizeSpecified)
+         {
+            tokenIndex++;
+            Expression* arraySizeExpression = parseExpression(pContext, arrayClosure - 1u);
+            CflatAssert(arraySizeExpression);
+
+            // literal sizes are taken as they are, the rest gets evaluated
+            if(arraySizeExpression->getType() == ExpressionType::Value)
+            {
+               const Value& arraySizeValue =
+                  static_cast<ExpressionValue*>(arraySizeExpression)->mValue;
+               arraySize = (uint16_t)getValueAsInteger(arraySizeValue);
+            }
+            else if(requireWriteAccess(pContext))
+            {
+               // the size can be of any integer type
+               Value arraySizeValue;
+               arraySizeValue.mValueInitializationHint = ValueInitializationHint::Stack;
+               evaluateExpression(mExecutionContext, arraySizeExpression, &arraySizeValue);
+
+               arraySize = (uint16_t)getValueAsInteger(arraySizeValue);
+
+               // runtime errors stop the parsing as well
+               if(!mErrorMessage.empty())
+               {
+                  pContext.mErrorMessage.assign(mErrorMessage);
+               }
+            }
+
+            CflatInvokeDtor(Expression, arraySizeExpression);
+            CflatFree(arraySizeExpression);
+         }
+
+         tokenIndex = arrayClosure + 1u;
+
+         if(tokens[tokenIndex].mStart[0] == '=')
+         {
+            tokenIndex++;
+
+            const size_t closureTokenIndex = findClosureTokenIndex(pContext, 0, ';');
+
+            if(closureTokenIndex > 0u)
+            {
+               initialValueExpression = parseExpression(pContext, closureTokenIndex - 1u);
+
+               if(!initialValueExpression ||
+                  initialValueExpression->getType() != ExpressionType::ArrayInitialization)
+               {
+                  throwCompileError(pContext, CompileError::ArrayInitializationExpected);
+                  return nullptr;
+               }
+
+               ExpressionArrayInitialization* arrayInitialization =
+                  static_cast<ExpressionArrayInitialization*>(initialValueExpression);
+
+               if(!arraySizeSpecified)
+               {
+                  arraySize = (uint16_t)arrayInitialization->mValues.size();
+               }
+
+               tokenIndex = closureTokenIndex;
+            }
+            else
+            {
+               throwCompileError(pContext, CompileError::Expected, ";");
+               return nullptr;
+            }
+         }
+         else if(!arraySizeSpecified)
+         {
+            throwCompileError(pContext, CompileError::ArrayInitializationExpected);
+            return nullptr;
+         }
+
+         CflatAssert(arraySize > 0u);
+         CflatSetFlag(pTypeUsage.mFlags, TypeUsageFlags::Array);
+         pTypeUsage.mArraySize = arraySize;
+      }
+      // variable/object
+      else if(token.mStart[0] == '=')
+      {
+         tokenIndex++;
+
+         const size_t closureTokenIndex = findClosureTokenIndex(pContext, 0, ';');
+
+         if(closureTokenIndex > 0u)
+         {
+            initialValueExpression = parseExpression(pContext, closureTokenIndex - 1u);
+
+            if(pTypeUsage.mType == mTypeAuto)
+            {
+               const TypeUsage& initialValueTypeUsage = getTypeUsage(pContext, initialValueExpression);
+
+               const bool autoConst = pTypeUsage.isConst();
+               const bool autoReference = pTypeUsage.isReference();
+
+               pTypeUsage = initialValueTypeUsage;
+
+               if(autoConst)
+               {
+                  CflatSetFlag(pTypeUsage.mFlags, TypeUsageFlags::Const);
+               }
+               else
+               {
+                  bool resetConstFlag = true;
+
+                  // Exception #1: keep 'const' if the initial value is the result of a function call
+                  // whose return type is a const ref, and the variable has been declared as auto&
+                  if(autoReference &&
+                     initialValueTypeUsage.isConst() && initialValueTypeUsage.isReference())
+                  {
+                     resetConstFlag = false;
+                  }
+                  // Exception #2: keep 'const' for C-strings
+                  else if(initialValueTypeUsage == mTypeUsageCString ||
+                     initialValueTypeUsage == mTypeUsageWideString)
+                  {
+                     resetConstFlag = false;
+                  }
+
+                  if(resetConstFlag)
+                  {
+                     CflatResetFlag(pTypeUsage.mFlags, TypeUsageFlags::Const);
+                  }
+               }
+
+               if(autoReference)
+               {
+                  CflatSetFlag(pTypeUsage.mFlags, TypeUsageFlags::Reference);
+               }
+               else
+               {
+                  CflatResetFlag(pTypeUsage.mFlags, TypeUsageFlags::Reference);
+               }
+            }
+            // Assigning something to a const ref
+            else if (initialValueExpression && pTypeUsage.isConst() && pTypeUsage.isReference())
+            {
+               const bool isFunctionCall =
+                  initialValueExpression->getType() == ExpressionType::FunctionCall ||
+                  initialValueExpression->getType() == ExpressionType::MethodCall;
+
+               if (isFunctionCall)
+               {
+                  const TypeUsage& initialValueTypeUsage = getTypeUsage(pContext, initialValueExpression);
+
+                  // If a value is being assigned to a const ref, treat it like a const value
+                  if (!initialValueTypeUsage.isReference())
+                  {
+                     CflatResetFlag(pTypeUsage.mFlags, TypeUsageFlags::Reference);
+                  }
+               }
+            }
+
+            tokenIndex = closureTokenIndex;
+         }
+         else
+         {
+            throwCompileError(pContext, CompileError::Expected, ";");
+            return nullptr;
+         }
+      }
+      // object with construction
+      else if(pTypeUsage.mType &&
+         pTypeUsage.mType->mCategory == TypeCategory::StructOrClass &&
+         !pTypeUsage.isPointer())
+      {
+         Struct* type = static_cast<Struct*>(pTypeUsage.mType);
+
+         if(token.mStart[0] == '(')
+         {
+            initialValueExpression = parseExpressionObjectConstruction(pContext, type);
+         }
+         else
+         {
+            const Identifier emptyId;
+            Method* anyCtor = type->findMethod(emptyId);
+
+            if(anyCtor)
+            {
+               Method* defaultCtor = type->getDefaultConstructor();
+
+               if(!defaultCtor)
+               {
+                  CflatSTLString typeFullName;
+                  getTypeFullName(type, &typeFullName);
+
+                  throwCompileError(pContext, CompileError::NoDefaultConstructor,
+                     typeFullName.c_str());
+                  return nullptr;
+               }
+            }
+         }
+      }
+
+      if(pTypeUsage.isReference() && !initialValueExpression)
+      {
+         throwCompileError(pContext, CompileError::UninitializedReference, pIdentifier.mName);
+         return nullptr;
+      }
+
+      // the variables in namespace scope are kept by reloads, as long as their types do not change
+      if(pContext.mSharedAccess && pContext.mScopeLevel == 0u)
+      {
+         Instance* existingInstance = pContext.mNamespaceStack.back()->retrieveInstance(pIdentifier);
+
+         if(!existingInstance || existingInstance->mTypeUsage != pTypeUsage)
+         {
+            requireWriteAccess(pContext);
+            return nullptr;
+         }
+      }
+
+      Instance* instance = registerInstance(pContext, pTypeUsage, pIdentifier);
+
+      statement = (StatementVariableDeclaration*)CflatMalloc(sizeof(StatementVariableDeclaration));
+      CflatInvokeCtor(StatementVariableDeclaration, statement)
+         (pTypeUsage, pIdentifier, initialValueExpression, pStatic);
+
+      const bool isLocalStaticVariable = pStatic && pContext.mScopeLevel > 0u;
+
+      if(isLocalStaticVariable)
+      {
+         CflatSetFlag(instance->mFlags, InstanceFlags::LocalStatic);
+      }
+
+      pContext.mRegisteredInstances.emplace_back();
+      ParsingContext::RegisteredInstance& registeredInstance = pContext.mRegisteredInstances.back();
+      registeredInstance.mIdentifier = pIdentifier;
+      registeredInstance.mNamespace = pContext.mNamespaceStack.back();
+      registeredInstance.mScopeLevel = pContext.mScopeLevel;
+      registeredInstance.mInstance = instance;
+      registeredInstance.mStaticDeclaration = isLocalStaticVariable ? statement : nullptr;
+
+      if(initialValueExpression)
+      {
+         bool validAssignment = false;
+
+         if(pTypeUsage.isPointer() && initialValueExpression->getType() == ExpressionType::NullPointer)
+         {
+            validAssignment = true;
+         }
+         else
+         {
+            const TypeUsage& initialValueTypeUsage = getTypeUsage(pContext, initialValueExpression);
+
+            if(initialValueTypeUsage.mType)
+            {
+               if(initialValueTypeUsage.mType != mTypeVoid || initialValueTypeUsage.isPointer())
+               {
+                  if(pTypeUsage.isPointer() && !pTypeUsage.isArray() &&
+                     !initialValueTypeUsage.isPointer() && initialValueTypeUsage.isArray() &&
+                     pTypeUsage.mType == initialValueTypeUsage.mType)
+                  {
+                     validAssignment = true;
+                  }
+                  else
+                  {
+                     const TypeHelper::Compatibility compatibility =
+                        TypeHelper::getCompatibility(pTypeUsage, initialValueTypeUsage);
+                     validAssignment = compatibility != TypeHelper::Compatibility::Incompatible;
+                  }
+               }
+            }
+         }
+
+         if(validAssignment)
+         {
+            // the constants are evaluated already by the previous version of the program when
+            // parsing with shared access, since the code outside function bodies is the same
+            if(pStatic && pTypeUsage.isConst() && pContext.mScopeLevel == 0u &&
+               !pContext.mSharedAccess)
+            {
+               Instance* execInstance = registerInstance(mExecutionContext, pTypeUsage, pIdentifier);
+
+               Value initialValue;
+               initialValue.mValueInitializationHint = ValueInitializationHint::Stack;
+               evaluateExpression(mExecutionContext, initialValueExpression, &initialValue);
+
+               assignValue(mExecutionContext, initialValue, &execInstance->mValue, true);
+
+               // runtime errors stop the parsing as well
+               if(!mErrorMessage.empty())
+               {
+                  pContext.mErrorMessage.assign(mErrorMessage);
+               }
+            }
+         }
+         else
+         {
+            throwCompileError(pContext, CompileError::InvalidAssignment);
+         }
+      }
+   }
+   else
+   {
+      throwCompileError(pContext, CompileError::VariableRedefinition, pIdentifier.mName);
+   }
+
+   return statement;
+}
+
+StatementFunctionDeclaration* Environment::parseStatementFunctionDeclaration(ParsingContext& pContext,
+   const TypeUsage& pReturnType, bool pStatic)
+{
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t& tokenIndex = pContext.mTokenIndex;
+   const Token& token = tokens[tokenIndex];
+
+   pContext.mStringBuffer.assign(token.mStart, token.mLength);
+   const Identifier functionIdentifier(pContext.mStringBuffer.c_str());
+   const size_t functionToken = tokenIndex;
+
+   if(pReturnType.mType->mCategory == TypeCategory::StructOrClass &&
+      !pReturnType.isPointer() &&
+      !pReturnType.isReference())
+   {
+      Struct* returnType = static_cast<Struct*>(pReturnType.mType);
+      Method* copyConstructor = returnType->getCopyConstructor();
+
+      if(!copyConstructor)
+      {
+         CflatSTLString typeFullName;
+         getTypeFullName(pReturnType.mType, &typeFullName);
+
+         throwCompileError(pContext, CompileError::NoCopyConstructor, typeFullName.c_str());
+         return nullptr;
+      }
+   }
+
+   StatementFunctionDeclaration* statement =
+      (StatementFunctionDeclaration*)CflatMalloc(sizeof(StatementFunctionDeclaration));
+   CflatInvokeCtor(StatementFunctionDeclaration, statement)(pReturnType, functionIdentifier);
+
+   tokenIndex++;
+
+   while(tokens[tokenIndex++].mStart[0] != ')')
+   {
+      // no arguments
+      if(tokens[tokenIndex].mStart[0] == ')')
+      {
+         tokenIndex++;
+         break;
+      }
+
+      TypeUsage parameterType = parseTypeUsage(pContext, 0u);
+
+      if(!parameterType.mType)
+      {
+         pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
+         throwCompileError(pContext, Environment::CompileError::UndefinedType,
+            pContext.mStringBuffer.c_str());
+         return statement;
+      }
+
+      pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
+      Identifier parameterIdentifier(pContext.mStringBuffer.c_str());
+
+      for(size_t i = 0u; i < statement->mParameterIdentifiers.size(); i++)
+      {
+         if(parameterIdentifier == statement->mParameterIdentifiers[i])
+         {
+            pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
+            throwCompileError(pContext, Environment::CompileError::ParameterRedefinition,
+               parameterIdentifier.mName);
+            return statement;
+         }
+      }
+
+      tokenIndex++;
+
+      statement->mParameterTypes.push_back(parameterType);
+      statement->mParameterIdentifiers.push_back(parameterIdentifier);
+
+      pContext.mScopeLevel++;
+      registerInstance(pContext, parameterType, parameterIdentifier);
+      pContext.mScopeLevel--;
+   }
+
+   CflatArgsVector(TypeUsage) parameterTypes;
+   toArgsVector(statement->mParameterTypes, parameterTypes);
+
+   Namespace* ns = pContext.mNamespaceStack.back();
+   Function* function = ns->getFunctionPerfectMatch(statement->mFunctionIdentifier, parameterTypes);
+
+   if(pContext.mSharedAccess)
+   {
+      // the declaration must match the registered function, which does not get altered
+      const bool functionUnchanged = function &&
+         function->mReturnTypeUsage == statement->mReturnType &&
+         CflatHasFlag(function->mFlags, FunctionFlags::Static) == pStatic;
+
+      if(!functionUnchanged)
+      {
+         CflatInvokeDtor(StatementFunctionDeclaration, statement);
+         CflatFree(statement);
+
+         requireWriteAccess(pContext);
+         return nullptr;
+      }
+   }
+   else if(!function)
+   {
+      Memory::CategoryScope categoryScope(Memory::Category::Function);
+
+      function = ns->registerFunction(statement->mFunctionIdentifier);
+      function->mProgram = pContext.mProgram;
+      function->mLine = token.mLine;
+
+      for(size_t i = 0u; i < statement->mParameterTypes.size(); i++)
+      {
+         function->mParameters.push_back(statement->mParameterTypes[i]);
+         function->mParameterIdentifiers.push_back(statement->mParameterIdentifiers[i]);
+      }
+   }
+
+   if(!pContext.mSharedAccess)
+   {
+      function->mReturnTypeUsage = statement->mReturnType;
+
+      if(pStatic)
+      {
+         CflatSetFlag(function->mFlags, FunctionFlags::Static);
+      }
+      else
+      {
+         CflatResetFlag(function->mFlags, FunctionFlags::Static);
+      }
+   }
+
+   pContext.mCurrentFunction = function;
+
+   if(tokens[tokenIndex].mStart[0] != ';')
+   {
+      const ParsingContext::FunctionBody* functionBody =
+         pContext.mScopeLevel == 0u ? findFunctionBody(pContext, tokenIndex) : nullptr;
+      bool bodySkipped = false;
+
+      if(functionBody)
+      {
+         statement->mBodyFingerprint = functionBody->mFingerprint;
+
+         if(pContext.mIncrementalReload)
+         {
+            const size_t functionBodyIndex = (size_t)(functionBody - pContext.mFunctionBodies.data());
+            Statement** previousStatement = pContext.mPreviousFunctionDeclarations[functionBodyIndex];
+            StatementFunctionDeclaration* previousDeclaration =
+               static_cast<StatementFunctionDeclaration*>(*previousStatement);
+
+            // the unchanged body does not get parsed, the previous declaration is kept instead
+            if(previousDeclaration->mBodyFingerprint == functionBody->mFingerprint &&
+               !previousDeclaration->mBodyDeferred)
+            {
+               ParsingContext::UnchangedFunctionDeclaration unchangedFunctionDeclaration;
+               unchangedFunctionDeclaration.mStatement = statement;
+               unchangedFunctionDeclaration.mPreviousStatement = previousStatement;
+               pContext.mUnchangedFunctionDeclarations.push_back(unchangedFunctionDeclaration);
+
+               bodySkipped = true;
+            }
+         }
+
+         // the body gets parsed on the first call, with the state it would be parsed with now,
+         // unless it registers anything: the first call only has shared access to the environment
+         if(!bodySkipped && CflatHasFlag(mSettings, Settings::LazyFunctionBodies) &&
+            !functionBody->mRegistering)
+         {
+            DeferredFunctionBody* deferredBody =
+               (DeferredFunctionBody*)CflatMalloc(sizeof(DeferredFunctionBody));
+            CflatInvokeCtor(DeferredFunctionBody, deferredBody)();
+            deferredBody->mFunctionTokenIndex = functionToken;
+            deferredBody->mOpeningTokenIndex = tokenIndex;
+            deferredBody->mNamespace = ns;
+            deferredBody->mUsingDirectives = pContext.mUsingDirectives;
+            deferredBody->mTypeAliases = pContext.mTypeAliases;
+
+            statement->mDeferredBody = deferredBody;
+            statement->mBodyDeferred = true;
+            pContext.mProgram->mDeferredFunctionBodiesCount++;
+
+            bodySkipped = true;
+         }
+      }
+
+      if(bodySkipped)
+      {
+         // the parameters have been registered for parsing the body
+         pContext.mLocalInstancesHolder.releaseInstances(1u, false);
+         tokenIndex = functionBody->mClosureTokenIndex;
+      }
+      else
+      {
+         statement->mBody = parseStatementBlock(pContext, true, true);
+      }
+   }
+
+   pContext.mCurrentFunction = nullptr;
+
+   if(statement->mBody && pReturnType.mType != mTypeVoid)
+   {
+      if(!doAllExecutionPathsReturn(statement->mBody))
+      {
+         tokenIndex = functionToken;
+         throwCompileError(pContext, CompileError::MissingReturnStatement, functionIdentifier.mName);
+      }
+   }
+
+   return statement;
+}
+
+StatementStructDeclaration* Environment::parseStatementStructDeclaration(ParsingContext& pContext)
+{
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t& tokenIndex = pContext.mTokenIndex;
+   const Token& token = tokens[tokenIndex];
+
+   pContext.mStringBuffer.assign(token.mStart, token.mLength);
+   const Identifier structIdentifier(pContext.mStringBuffer.c_str());
+   tokenIndex++;
+
+   if(tokens[tokenIndex].mStart[0] != '{')
+   {
+      throwCompileError(pContext, CompileError::Expected, "{");
+      return nullptr;
+   }
+
+   const size_t closureTokenIndex = findClosureTokenIndex(pContext, '{', '}');
+
+   if(closureTokenIndex == 0u)
+   {
+      tokenIndex = tokens.size() - 1u;
+      throwCompileError(pContext, CompileError::Expected, "}");
+      return nullptr;
+   }
+
+   // The struct has not changed since the previous version of the program, and the kept
+   // function bodies refer to the registered type, so it does not get registered again
+   if(pContext.mIncrementalReload && pContext.mScopeLevel == 0u)
+   {
+      tokenIndex = closureTokenIndex + 1u;
+
+      if(tokenIndex >= tokens.size() || tokens[tokenIndex].mStart[0] != ';')
+      {
+         throwCompileError(pContext, CompileError::Expected, ";");
+      }
+
+      return nullptr;
+   }
+
+   // local structs get registered in namespaces of their own
+   if(!requireWriteAccess(pContext))
+   {
+      return nullptr;
+   }
+
+   tokenIndex++;
+
+   StatementStructDeclaration* statement =
+      (StatementStructDeclaration*)CflatMalloc(sizeof(StatementStructDeclaration));
+   CflatInvokeCtor(StatementStructDeclaration, statement)();
+
+   Namespace* ns = pContext.mNamespaceStack.back();
+
+   if(pContext.mScopeLevel > 0u)
+   {
+      CflatAssert(pContext.mCurrentFunction);
+      ns = ns->requestNamespace(pContext.mCurrentFunction->mIdentifier);
+
+      char buffer[kDefaultLocalStringBufferSize];
+      snprintf(buffer, sizeof(buffer), "__local%u", pContext.mLocalNamespaceGlobalIndex);
+      const Identifier internalNamespaceIdentifier(buffer);
+      ns = ns->requestNamespace(internalNamespaceIdentifier);
+
+      pContext.mLocalNamespaceStack.emplace_back();
+      ParsingContext::LocalNamespace& localNamespace = pContext.mLocalNamespaceStack.back();
+      localNamespace.mNamespace = ns;
+      localNamespace.mScopeLevel = pContext.mScopeLevel;
+
+      pContext.mLocalNamespaceGlobalIndex++;
+   }
+
+   Type* existingType = ns->getType(structIdentifier);
+
+   if(existingType)
+   {
+      ns->deregisterType(existingType);
+   }
+
+   statement->mStruct = ns->registerType<Struct>(structIdentifier);
+
+   size_t structSize = 0u;
+   size_t structAlignment = 1u;
+
+   do
+   {
+      TypeUsage typeUsage = parseTypeUsage(pContext, closureTokenIndex - 1u);
+
+      if(!typeUsage.mType)
+      {
+         pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
+         throwCompileError(pContext, CompileError::UndefinedType, pContext.mStringBuffer.c_str());
+         break;
+      }
+
+      pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
+      tokenIndex++;
+
+      if(tokens[tokenIndex].mStart[0] != ';')
+      {
+         throwCompileError(pContext, CompileError::Expected, ";");
+         break;
+      }
+
+      const size_t typeUsageSize = typeUsage.getSize();
+      const size_t typeUsageAlignment = TypeHelper::calculateAlignment(typeUsage);
+
+      if(typeUsageAlignment > structAlignment)
+      {
+         structAlignment = typeUsageAlignment;
+      }
+
+      const size_t misalignment = structSize % typeUsageAlignment;
+
+      if(misalignment > 0u)
+      {
+         const size_t padding = typeUsageAlignment - misalignment;
+         structSize += padding;
+      }
+
+      const Identifier memberIdentifier(pContext.mStringBuffer.c_str());
+      Field* member = statement->mStruct->requestField(memberIdentifier);
+      member->mTypeUsage = typeUsage;
+      member->mOffset = (uint16_t)structSize;
+
+      structSize += typeUsageSize;
+   }
+   while(++tokenIndex < closureTokenIndex);
+
+   const size_t misalignment = structSize % structAlignment;
+
+   if(misalignment > 0u)
+   {
+      const size_t padding = structAlignment - misalignment;
+      structSize += padding;
+   }
+
+   statement->mStruct->mSize = structSize;
+   statement->mStruct->mAlignment = (uint8_t)structAlignment;
+
+   if(tokens[++tokenIndex].mStart[0] != ';')
+   {
+      throwCompileError(pContext, CompileError::Expected, ";");
+   }
+
+   return statement;
+}
+
+StatementIf* Environment::parseStatementIf(ParsingContext& pContext)
+{
+   if(pContext.mScopeLevel == 0u)
+   {
+      throwCompileErrorUnexpectedSymbol(pContext);
+      return nullptr;
+   }
+
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t& tokenIndex = pContext.mTokenIndex;
+
+   if(tokens[tokenIndex].mStart[0] != '(')
+   {
+      throwCompileError(pContext, CompileError::UnexpectedSymbol, "if");
+      return nullptr;
+   }
+
+   const size_t conditionClosureTokenIndex = findClosureTokenIndex(pContext, '(', ')');
+
+   if(conditionClosureTokenIndex == 0u)
+   {
+      throwCompileError(pContext, CompileError::Expected, ")");
+      return nullptr;
+   }
+
+   tokenIndex++;
+   Expression* condition = parseExpression(pContext, conditionClosureTokenIndex - 1u);
+   tokenIndex = conditionClosureTokenIndex + 1u;
+
+   Statement* ifStatement = parseStatement(pContext);
+
+   if(!ifStatement)
+   {
+      throwCompileErrorUnexpectedSymbol(pContext);
+      return nullptr;
+   }
+
+   const size_t tokenIndexForElseCheck = tokenIndex + 1u;
+   Statement* elseStatement = nullptr;
+
+   if(tokens[tokenIndexForElseCheck].mType == TokenType::Keyword &&
+      strncmp(tokens[tokenIndexForElseCheck].mStart, "else", 4u) == 0)
+   {
+      tokenIndex = tokenIndexForElseCheck + 1u;
+      elseStatement = parseStatement(pContext);
+   }
+
+   StatementIf* statement = (StatementIf*)CflatMalloc(sizeof(StatementIf));
+   CflatInvokeCtor(StatementIf, statement)(condition, ifStatement, elseStatement);
+
+   return statement;
+}
+
+StatementSwitch* Environment::parseStatementSwitch(ParsingContext& pContext)
+{
+   if(pContext.mScopeLevel == 0u)
+   {
+      throwCompileErrorUnexpectedSymbol(pContext);
+      return nullptr;
+   }
+
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t& tokenIndex = pContext.mTokenIndex;
+
+   if(tokens[tokenIndex].mStart[0] != '(')
+   {
+      throwCompileError(pContext, CompileError::UnexpectedSymbol, "switch");
+      return nullptr;
+   }
+
+   const size_t conditionClosureTokenIndex = findClosureTokenIndex(pContext, '(', ')');
+
+   if(conditionClosureTokenIndex == 0u)
+   {
+      throwCompileError(pContext, CompileError::Expected, ")");
+      return nullptr;
+   }
+
+   if(tokens[conditionClosureTokenIndex + 1u].mStart[0] != '{')
+   {
+      pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
+      throwCompileError(pContext, CompileError::UnexpectedSymbol, pContext.mStringBuffer.c_str());
+      return nullptr;
+   }
+
+   tokenIndex++;
+   Expression* condition = parseExpression(pContext, conditionClosureTokenIndex - 1u);
+   tokenIndex = conditionClosureTokenIndex + 1u;
+
+   tokenIndex++;
+   const size_t lastSwitchTokenIndex = findClosureTokenIndex(pContext, '{', '}');
+
+   if(lastSwitchTokenIndex == 0u)
+   {
+      if(condition)
+      {
+         CflatInvokeDtor(Expression, condition);
+         CflatFree(condition);
+      }
+
+      throwCompileError(pContext, CompileError::Expected, "}");
+      return nullptr;
+   }
+
+   StatementSwitch* statement = (StatementSwitch*)CflatMalloc(sizeof(StatementSwitch));
+   CflatInvokeCtor(StatementSwitch, statement)(condition);
+
+   StatementSwitch::CaseSection* currentCaseSection = nullptr;
+
+   for(; tokenIndex < lastSwitchTokenIndex; tokenIndex++)
+   {
+      if(tokens[tokenIndex].mType == TokenType::Keyword)
+      {
+         if(strncmp(tokens[tokenIndex].mStart, "case", 4u) == 0)
+         {
+            tokenIndex++;
+            const size_t lastCaseTokenIndex =
+               findClosureTokenIndex(pContext, 0, ':', lastSwitchTokenIndex);
+
+            StatementSwitch::CaseSection caseSection;
+            caseSection.mExpression = parseExpression(pContext, lastCaseTokenIndex - 1u);
+            tokenIndex = lastCaseTokenIndex + 1u;
+
+            statement->mCaseSections.push_back(caseSection);
+            currentCaseSection = &statement->mCaseSections.back();
+         }
+         else if(strncmp(tokens[tokenIndex].mStart, "default", 7u) == 0)
+         {
+            tokenIndex += 2u;
+
+            StatementSwitch::CaseSection caseSection;
+            caseSection.mExpression = nullptr;
+
+            statement->mCaseSections.push_back(caseSection);
+            currentCaseSection = &statement->mCaseSections.back();
+         }
+      }
+
+      if(!currentCaseSection)
+      {
+         if(condition)
+         {
+            CflatInvokeDtor(Expression, condition);
+            CflatFree(condition);
+         }
+
+         pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
+         throwCompileError(pContext, CompileError::UnexpectedSymbol, pContext.mStringBuffer.c_str());
+         return nullptr;
+      }
+
+      Statement* caseSectionStatement = parseStatement(pContext);
+
+      if(caseSectionStatement)
+      {
+         currentCaseSection->mStatements.push_back(caseSectionStatement);
+      }
+   }
+
+   return statement;
+}
+
+StatementWhile* Environment::parseStatementWhile(ParsingContext& pContext)
+{
+   if(pContext.mScopeLevel == 0u)
+   {
+      throwCompileErrorUnexpectedSymbol(pContext);
+      return nullptr;
+   }
+
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t& tokenIndex = pContext.mTokenIndex;
+
+   if(tokens[tokenIndex].mStart[0] != '(')
+   {
+      throwCompileError(pContext, CompileError::UnexpectedSymbol, "while");
+      return nullptr;
+   }
+
+   const size_t conditionClosureTokenIndex = findClosureTokenIndex(pContext, '(', ')');
+
+   if(conditionClosureTokenIndex == 0u)
+   {
+      throwCompileError(pContext, CompileError::Expected, ")");
+      return nullptr;
+   }
+
+   tokenIndex++;
+   Expression* condition = parseExpression(pContext, conditionClosureTokenIndex - 1u);
+   tokenIndex = conditionClosureTokenIndex + 1u;
+
+   Statement* loopStatement = parseStatement(pContext);
+
+   StatementWhile* statement = (StatementWhile*)CflatMalloc(sizeof(StatementWhile));
+   CflatInvokeCtor(StatementWhile, statement)(condition, loopStatement);
+
+   return statement;
+}
+
+StatementDoWhile* Environment::parseStatementDoWhile(ParsingContext& pContext)
+{
+   if(pContext.mScopeLevel == 0u)
+   {
+      throwCompileErrorUnexpectedSymbol(pContext);
+      return nullptr;
+   }
+
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t& tokenIndex = pContext.mTokenIndex;
+
+   Statement* loopStatement = parseStatement(pContext);
+   tokenIndex++;
+
+   if(strncmp(tokens[tokenIndex].mStart, "while", 5u) != 0)
+   {
+      if(loopStatement)
+      {
+         CflatInvokeDtor(Statement, loopStatement);
+         CflatFree(loopStatement);
+      }
+
+      throwCompileErrorUnexpectedSymbol(pContext);
+      return nullptr;
+   }
+
+   tokenIndex++;
+
+   if(tokens[tokenIndex].mStart[0] != '(')
+   {
+      if(loopStatement)
+      {
+         CflatInvokeDtor(Statement, loopStatement);
+         CflatFree(loopStatement);
+      }
+
+      throwCompileErrorUnexpectedSymbol(pContext);
+      return nullptr;
+   }
+
+   const size_t conditionClosureTokenIndex = findClosureTokenIndex(pContext, '(', ')');
+
+   if(conditionClosureTokenIndex == 0u)
+   {
+      if(loopStatement)
+      {
+         CflatInvokeDtor(Statement, loopStatement);
+         CflatFree(loopStatement);
+      }
+
+      throwCompileError(pContext, CompileError::Expected, ")");
+      return nullptr;
+   }
+
+   tokenIndex++;
+   Expression* condition = parseExpression(pContext, conditionClosureTokenIndex - 1u);
+   tokenIndex = conditionClosureTokenIndex + 1u;
+
+   StatementDoWhile* statement = (StatementDoWhile*)CflatMalloc(sizeof(StatementDoWhile));
+   CflatInvokeCtor(StatementDoWhile, statement)(condition, loopStatement);
+
+   return statement;
+}
+
+Statement* Environment::parseStatementFor(ParsingContext& pContext)
+{
+   if(pContext.mScopeLevel == 0u)
+   {
+      throwCompileErrorUnexpectedSymbol(pContext);
+      return nullptr;
+   }
+
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t& tokenIndex = pContext.mTokenIndex;
+
+   if(tokens[tokenIndex].mStart[0] != '(')
+   {
+      throwCompileError(pContext, CompileError::UnexpectedSymbol, "for");
+      return nullptr;
+   }
+
+   incrementScopeLevel(pContext);
+
+   if(!pContext.mSharedAccess)
+   {
+      incrementScopeLevel(mExecutionContext);
+   }
+
+   tokenIndex++;
+
+   const size_t initializationClosureTokenIndex = findClosureTokenIndex(pContext, 0, ';');
+   const size_t variableClosureTokenIndex = findClosureTokenIndex(pContext, 0, ':');
+
+   if(initializationClosureTokenIndex == 0u && variableClosureTokenIndex == 0u)
+   {
+      throwCompileError(pContext, CompileError::Expected, "';' or variable declaration");
+      return nullptr;
+   }
+
+   Statement* statement = nullptr;
+
+   if((initializationClosureTokenIndex > 0u && variableClosureTokenIndex == 0u) ||
+      (initializationClosureTokenIndex < variableClosureTokenIndex))
+   {
+      statement = parseStatementForRegular(pContext, initializationClosureTokenIndex);
+   }
+   else
+   {
+      statement = parseStatementForRangeBased(pContext, variableClosureTokenIndex);
+   }
+
+   if(!pContext.mSharedAccess)
+   {
+      decrementScopeLevel(mExecutionContext);
+   }
+
+   decrementScopeLevel(pContext);
+
+   return statement;
+}
+
+StatementFor* Environment::parseStatementForRegular(ParsingContext& pContext,
+   size_t pInitializationClosureTokenIndex)
+{
+   size_t& tokenIndex = pContext.mTokenIndex;
+
+   Statement* initialization = nullptr;
+   
+   if(pInitializationClosureTokenIndex > tokenIndex)
+   {
+      initialization = parseStatement(pContext);
+   }
+
+   tokenIndex = pInitializationClosureTokenIndex + 1u;
+
+   const size_t conditionClosureTokenIndex = findClosureTokenIndex(pContext, 0, ';');
+
+   if(conditionClosureTokenIndex == 0u)
+   {
+      throwCompileError(pContext, CompileError::Expected, ";");
+      return nullptr;
+   }
+
+   Expression* condition = nullptr;
+   
+   if(conditionClosureTokenIndex > tokenIndex)
+   {
+      condition = parseExpression(pContext, conditionClosureTokenIndex - 1u);
+   }
+
+   tokenIndex = conditionClosureTokenIndex + 1u;
+
+   const size_t incrementClosureTokenIndex = findClosureTokenIndex(pContext, '(', ')');
+
+   if(incrementClosureTokenIndex == 0u)
+   {
+      throwCompileError(pContext, CompileError::Expected, ")");
+      return nullptr;
+   }
+
+   Expression* increment = nullptr;
+   
+   if(incrementClosureTokenIndex > tokenIndex)
+   {
+      increment = parseExpression(pContext, incrementClosureTokenIndex - 1u);
+   }
+
+   tokenIndex = incrementClosureTokenIndex + 1u;
+
+   Statement* loopStatement = parseStatement(pContext);
+
+   StatementFor* statement = (StatementFor*)CflatMalloc(sizeof(StatementFor));
+   CflatInvokeCtor(StatementFor, statement)(initialization, condition, increment, loopStatement);
+
+   return statement;
+}
+
+StatementForRangeBased* Environment::parseStatementForRangeBased(ParsingContext& pContext,
+   size_t pVariableClosureTokenIndex)
+{
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t& tokenIndex = pContext.mTokenIndex;
+
+   TypeUsage variableTypeUsage = parseTypeUsage(pContext, pVariableClosureTokenIndex - 1u);
+
+   if(!variableTypeUsage.mType)
+   {
+      throwCompileErrorUnexpectedSymbol(pContext);
+      return nullptr;
+   }
+
+   Identifier variableIdentifier;
+
+   if(tokens[tokenIndex].mType == TokenType::Identifier)
+   {
+      pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
+      variableIdentifier = Identifier(pContext.mStringBuffer.c_str());
+   }
+   else
+   {
+      throwCompileErrorUnexpectedSymbol(pContext);
+      return nullptr;
+   }
+
+   tokenIndex = pVariableClosureTokenIndex + 1u;
+   const size_t collectionClosureTokenIndex = findClosureTokenIndex(pContext, '(', ')');
+
+   if(collectionClosureTokenIndex <= tokenIndex)
+   {
+      throwCompileError(pContext, CompileError::Expected, ")");
+      return nullptr;
+   }
+
+   Expression* collection = parseExpression(pContext, collectionClosureTokenIndex - 1u);
+
+   if(!collection)
+   {
+      return nullptr;
+   }
+
+   bool validStatement = false;
+   const TypeUsage& collectionTypeUsage = getTypeUsage(pContext, collection);
+
+   if(collectionTypeUsage.isArray() && !variableTypeUsage.isArray() &&
+      collectionTypeUsage.mPointerLevel == variableTypeUsage.mPointerLevel)
+   {
+      if(variableTypeUsage.mType == mTypeAuto)
+      {
+         variableTypeUsage.mType = collectionTypeUsage.mType;
+      }
+
+      TypeUsage elementTypeUsage;
+      elementTypeUsage.mType = collectionTypeUsage.mType;
+
+      const TypeHelper::Compatibility compatibility =
+         TypeHelper::getCompatibility(elementTypeUsage, variableTypeUsage);
+      validStatement = compatibility == TypeHelper::Compatibility::PerfectMatch;
+   }
+   else if(collectionTypeUsage.mType->mCategory == TypeCategory::StructOrClass)
+   {
+      Struct* collectionType = static_cast<Struct*>(collectionTypeUsage.mType);
+      Method* beginMethod = collectionType->findMethod("begin", TypeUsage::kEmptyList());
+
+      if(beginMethod)
+      {
+         Method* endMethod = collectionType->findMethod("end", TypeUsage::kEmptyList());
+
+         if(endMethod && beginMethod->mReturnTypeUsage == endMethod->mReturnTypeUsage)
+         {
+            const TypeUsage iteratorTypeUsage = beginMethod->mReturnTypeUsage;
+
+            if(iteratorTypeUsage.mType->mCategory == TypeCategory::StructOrClass && !iteratorTypeUsage.isPointer())
+            {
+               Struct* castIteratorType = static_cast<Struct*>(iteratorTypeUsage.mType);
+               Method* indirectionOperatorMethod =
+                  castIteratorType->findMethod("operator*", TypeUsage::kEmptyList());
+
+               if(indirectionOperatorMethod)
+               {
+                  CflatArgsVector(TypeUsage) nonEqualOperatorParameterTypes;
+                  nonEqualOperatorParameterTypes.push_back(iteratorTypeUsage);
+
+                  validStatement = 
+                     castIteratorType->findMethod("operator!=", nonEqualOperatorParameterTypes) &&
+                     castIteratorType->findMethod("operator++", TypeUsage::kEmptyList());
+
+                  if(validStatement && variableTypeUsage.mType == mTypeAuto)
+                  {
+                     variableTypeUsage.mType = indirectionOperatorMethod->mReturnTypeUsage.mType;
+                  }
+               }
+            }
+            else
+            {
+               if(variableTypeUsage.mType == mTypeAuto)
+               {
+                  variableTypeUsage.mType = iteratorTypeUsage.mType;
+               }
+
+               validStatement = iteratorTypeUsage.isPointer();
+            }
+         }
+      }
+   }
+
+   if(!validStatement)
+   {
+      throwCompileErrorUnexpectedSymbol(pContext);
+      return nullptr;
+   }
+
+   registerInstance(pContext, variableTypeUsage, variableIdentifier);
+
+   tokenIndex = collectionClosureTokenIndex + 1u;
+   Statement* loopStatement = parseStatement(pContext);
+
+   StatementForRangeBased* statement =
+      (StatementForRangeBased*)CflatMalloc(sizeof(StatementForRangeBased));
+   CflatInvokeCtor(StatementForRangeBased, statement)
+      (variableTypeUsage, variableIdentifier, collection, loopStatement);
+
+   return statement;
+}
+
+StatementBreak* Environment::parseStatementBreak(ParsingContext& pContext)
+{
+   if(pContext.mScopeLevel == 0u)
+   {
+      throwCompileErrorUnexpectedSymbol(pContext);
+      return nullptr;
+   }
+
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t& tokenIndex = pContext.mTokenIndex;
+
+   if(tokens[tokenIndex].mStart[0] != ';')
+   {
+      throwCompileError(pContext, CompileError::UnexpectedSymbol, "break");
+      return nullptr;
+   }
+
+   StatementBreak* statement = (StatementBreak*)CflatMalloc(sizeof(StatementBreak));
+   CflatInvokeCtor(StatementBreak, statement)();
+
+   return statement;
+}
+
+StatementContinue* Environment::parseStatementContinue(ParsingContext& pContext)
+{
+   if(pContext.mScopeLevel == 0u)
+   {
+      throwCompileErrorUnexpectedSymbol(pContext);
+      return nullptr;
+   }
+
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t& tokenIndex = pContext.mTokenIndex;
+
+   if(tokens[tokenIndex].mStart[0] != ';')
+   {
+      throwCompileError(pContext, CompileError::UnexpectedSymbol, "continue");
+      return nullptr;
+   }
+
+   StatementContinue* statement = (StatementContinue*)CflatMalloc(sizeof(StatementContinue));
+   CflatInvokeCtor(StatementContinue, statement)();
+
+   return statement;
+}
+
+StatementReturn* Environment::parseStatementReturn(ParsingContext& pContext)
+{
+   if(pContext.mScopeLevel == 0u || !pContext.mCurrentFunction)
+   {
+      throwCompileErrorUnexpectedSymbol(pContext);
+      return nullptr;
+   }
+
+   const size_t closureTokenIndex = findClosureTokenIndex(pContext, 0, ';');
+
+   if(closureTokenIndex == 0u)
+   {
+      throwCompileError(pContext, CompileError::Expected, ";");
+      return nullptr;
+   }
+
+   const size_t expressionTokenIndex = pContext.mTokenIndex;
+   Expression* expression = parseExpression(pContext, closureTokenIndex - 1u, true);
+
+   if(pContext.mCurrentFunction->mReturnTypeUsage != mTypeUsageVoid)
+   {
+      if(expression)
+      {
+         const TypeUsage& expressionTypeUsage = getTypeUsage(pContext, expression);
+         const TypeHelper::Compatibility compatibility =
+            TypeHelper::getCompatibility(pContext.mCurrentFunction->mReturnTypeUsage, expressionTypeUsage);
+
+         if(compatibility == TypeHelper::Compatibility::Incompatible)
+         {
+            throwCompileError(pContext, CompileError::IncompatibleReturnExpressionType,
+               pContext.mCurrentFunction->mIdentifier.mName);
+         }
+      }
+      else
+      {
+         throwCompileError(pContext, CompileError::MissingReturnExpression);
+      }
+   }
+   else
+   {
+      if(expression)
+      {
+         throwCompileError(pContext, CompileError::VoidFunctionReturningValue);
+      }
+   }
+
+   StatementReturn* statement = (StatementReturn*)CflatMalloc(sizeof(StatementReturn));
+   CflatInvokeCtor(StatementReturn, statement)(expression);
+
+   pContext.mTokenIndex = closureTokenIndex;
+
+   return statement;
+}
+
+bool Environment::parseFunctionCallArguments(ParsingContext& pContext,
+   CflatSTLVector(Expression*)* pArguments, CflatSTLVector(TypeUsage)* pTemplateTypes)
+{
+   CflatSTLVector(Token)& tokens = pContext.mTokens;
+   size_t& tokenIndex = pContext.mTokenIndex;
+
+   if(tokens[tokenIndex].mStart[0] == '<')
+   {
+      if(pTemplateTypes)
+      {
+         const size_t closureTokenIndex = findClosureTokenIndex(pContext, '<', '>');
+
+         if(closureTokenIndex > 0u)
+         {
+            while(tokenIndex++ < closureTokenIndex)
+            {
+               TypeUsage typeUsage = parseTypeUsage(pContext, closureTokenIndex - 1u);
+
+               if(typeUsage.mType)
+               {
+                  pTemplateTypes->push_back(typeUsage);
+               }
+               else
+               {
+                  pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
+                  throwCompileError(pContext, Environment::CompileError::UndefinedType,
+                     pContext.mStringBuffer.c_str());
+                  return false;
+               }
+            }
+         }
+         else
+         {
+            throwCompileError(pContext, CompileError::Expected, ">");
+            return false;
+         }
+      }
+      else
+      {
+         throwCompileError(pContext, CompileError::Expected, "(");
+         return false;
+      }
+   }
+
+   const size_t closureTokenIndex = findClosureTokenIndex(pContext, '(', ')');
+
+   if(closureTokenIndex > 0u)
+   {
+      while(tokenIndex++ < closureTokenIndex)
+      {
+         const size_t separatorTokenIndex =
+            findSeparationTokenIndex(pContext, ',', closureTokenIndex);
+         const size_t tokenLastIndex = 
+           separatorTokenIndex > 0u ? separatorTokenIndex : closureTokenIndex;
+
+         Expression* argument = parseExpression(pContext, tokenLastIndex - 1u, true);
+
+         if(!pContext.mErrorMessage.empty())
+         {
+            return false;
+         }
+
+         if(argument)
+         {
+            pArguments->push_back(argument);
+         }
+
+         tokenIndex = tokenLastIndex;
+      }
+   }
+   else
+   {
+      throwCompileError(pContext, CompileError::Expected, ")");
+      return false;
+   }
+
+   return true;
+}
+
+const TypeUsage& Environment::getTypeUsage(Expression* pExpression) const
+{
+   static const TypeUsage kDefaultTypeUsage;
+   return pExpression && mErrorMessage.empty() ? pExpression->getTypeUsage() : kDefaultTypeUsage;
+}
+
+const TypeUsage& Environment::getTypeUsage(const ParsingContext& pContext,
+   Expression* pExpression) const
+{
+   static const TypeUsage kDefaultTypeUsage;
+   return pExpression && pContext.mErrorMessage.empty() ? pExpression->getTypeUsage() : kDefaultTypeUsage;
+}
+
+bool Environment::requireWriteAccess(ParsingContext& pContext)
+{
+   if(!pContext.mSharedAccess)
+      return true;
+
+   // the parsing stops here, and the error message never gets reported
+   pContext.mWriteAccessRequired = true;
+
+   if(pContext.mErrorMessage.empty())
+   {
+      pContext.mErrorMessage.assign("[Compile Error] Write access required");
+   }
+
+   return false;
+}
+
+Type* Environment::findType(const Context& pContext, const Identifier& pIdentifier,
+   const CflatArgsVector(TypeUsage)& pTemplateTypes) const
+{
+   Type* type = nullptr;
+
+   for(size_t i = 0u; i < pContext.mTypeAliases.size(); i++)
+   {
+      if(pContext.mTypeAliases[i].mIdentifier == pIdentifier)
+      {
+         const TypeUsage& typeUsage = pContext.mTypeAliases[i].mTypeUsage;
+
+         if(typeUsage.mFlags == 0u)
+         {
+            type = typeUsage.mType;
+            break;
+         }
+      }
+   }
+
+   if(!type)
+   {
+      type = pContext.mNamespaceStack.back()->getType(pIdentifier, pTemplateTypes, true);
+   }
+
+   if(!type)
+   {
+      for(size_t i = 0u; i < pContext.mUsingDirectives.size(); i++)
+      {
+         type = pContext.mUsingDirectives[i].mNamespace->getType(pIdentifier, pTemplateTypes);
+
+         if(type)
+         {
+            break;
+         }
+      }
+   }
+
+   return type;
+}
+
+Function* Environment::findFunction(const Context& pContext, const Identifier& pIdentifier,
+   const CflatArgsVector(TypeUsage)& pParameterTypes,
+   const CflatArgsVector(TypeUsage)& pTemplateTypes) const
+{
+   Namespace* ns = pContext.mNamespaceStack.back();
+   Function* function = ns->getFunction(pIdentifier, pParameterTypes, pTemplateTypes, true);
+
+   if(!function)
+   {
+      for(size_t i = 0u; i < pContext.mUsingDirectives.size(); i++)
+      {
+         Namespace* usingNS = pContext.mUsingDirectives[i].mNamespace;
+         function =
+            usingNS->getFunction(pIdentifier, pParameterTypes, pTemplateTypes, true);
+
+         if(function)
+         {
+            break;
+         }
+      }
+   }
+
+   return function;
+}
+
+Function* Environment::findFunction(const Context& pContext, const Identifier& pIdentifier,
+   const CflatArgsVector(Value)& pArguments,
+   const CflatArgsVector(TypeUsage)& pTemplateTypes) const
+{
+   CflatArgsVector(TypeUsage) typeUsages;
+
+   for(size_t i = 0u; i < pArguments.size(); i++)
+   {
+      typeUsages.push_back(pArguments[i].mTypeUsage);
+   }
+
+   return findFunction(pContext, pIdentifier, typeUsages, pTemplateTypes);
+}
+
+void Environment::registerTypeAlias(
+  Context& pContext, const Identifier& pIdentifier, const TypeUsage& pTypeUsage)
+{
+   if(pContext.mScopeLevel > 0u)
+   {
+      TypeAlias typeAlias(pIdentifier, pTypeUsage);
+      typeAlias.mScopeLevel = pContext.mScopeLevel;
+      pContext.mTypeAliases.push_back(typeAlias);
+   }
+   else if(pContext.mType == ContextType::Parsing &&
+      static_cast<ParsingContext&>(pContext).mSharedAccess)
+   {
+      // the aliases in namespace scope are kept by reloads, as long as they do not change
+      const TypeAlias* typeAlias = pContext.mNamespaceStack.back()->getTypeAlias(pIdentifier);
+
+      if(!typeAlias || typeAlias->mTypeUsage != pTypeUsage)
+      {
+         requireWriteAccess(static_cast<ParsingContext&>(pContext));
+      }
+   }
+   else
+   {
+      pContext.mNamespaceStack.back()->registerTypeAlias(pIdentifier, pTypeUsage);
+   }
+}
+
+Instance* Environment::registerInstance(Context& pContext,
+   const TypeUsage& pTypeUsage, const Identifier& pIdentifier)
+{
+   AllocationReasonScope reasonScope(AllocationReason::Instance);
+
+   Instance* instance = nullptr;
+   bool initializationRequired = false;
+
+   if(pContext.mScopeLevel > 0u)
+   {
+      instance = pContext.mLocalInstancesHolder.registerInstance(pTypeUsage, pIdentifier, pContext.mScopeLevel);
+      initializationRequired = true;
+   }
+   else
+   {
+      instance = pContext.mNamespaceStack.back()->retrieveInstance(pIdentifier);
+
+      if(!instance)
+      {
+         instance = pContext.mNamespaceStack.back()->registerInstance(pTypeUsage, pIdentifier);
+         initializationRequired = true;
+      }
+      else if(instance->mTypeUsage != pTypeUsage)
+      {
+         instance->mTypeUsage = pTypeUsage;
+         initializationRequired = true;
+      }
+   }
+
+   CflatAssert(instance);
+
+   if(initializationRequired)
+   {
+      if(instance->mTypeUsage.isReference())
+      {
+         instance->mValue.initExternal(instance->mTypeUsage);
+      }
+      else if(pContext.mScopeLevel == 0u)
+      {
+         instance->mValue.initOnHeap(instance->mTypeUsage);
+      }
+      else
+      {
+         pContext.mLocalInstancesHolder.initOnStack(instance);
+      }
+   }
+
+   CflatAssert(instance->mTypeUsage == pTypeUsage);
+
+   instance->mScopeLevel = pContext.mScopeLevel;
+
+   return instance;
+}
+
+Instance* Environment::retrieveInstance(Context& pContext, const Identifier& pIdentifier) const
+{
+   Instance* instance = pContext.mLocalInstancesHolder.retrieveInstance(pIdentifier);
+
+   if(!instance)
+   {
+      if(pContext.mType == ContextType::Execution)
+      {
+         CflatCountExecution(static_cast<ExecutionContext&>(pContext), mNameLookupMissesCount);
+      }
+
+      instance = pContext.mNamespaceStack.back()->retrieveInstance(pIdentifier, true);
+
+      if(!instance)
+      {
+         for(size_t i = 0u; i < pContext.mUsingDirectives.size(); i++)
+         {
+            instance = pContext.mUsingDirectives[i].mNamespace->retrieveInstance(pIdentifier, true);
+
+            if(instance)
+            {
+               break;
+            }
+         }
+      }
+
+      if(!instance)
+      {
+         const char* lastSeparator = pIdentifier.findLastSeparator();
+
+         if(lastSeparator)
+         {
+            char buffer[kDefaultLocalStringBufferSize];
+            const size_t typeIdentifierLength = lastSeparator - pIdentifier.mName;
+            strncpy(buffer, pIdentifier.mName, typeIdentifierLength);
+            buffer[typeIdentifierLength] = '\0';
+            const Identifier typeIdentifier(buffer);
+            const Identifier staticMemberIdentifier(lastSeparator + 2);
+
+            Type* type = findType(pContext, typeIdentifier);
+
+            if(type && type->mCategory == TypeCategory::StructOrClass)
+            {
+               instance = static_cast<Struct*>(type)->getStaticMemberInstance(staticMemberIdentifier);
+            }
+         }
+      }
+   }
+
+   return instance;
+}
+
+void Environment::incrementBlockLevel(Context& pContext)
+{
+   pContext.mBlockLevel++;
+}
+
+void Environment::decrementBlockLevel(Context& pContext)
+{
+   while(!pContext.mUsingDirectives.empty() &&
+      pContext.mUsingDirectives.back().mBlockLevel >= pContext.mBlockLevel)
+   {
+      pContext.mUsingDirectives.pop_back();
+   }
+
+   pContext.mBlockLevel--;
+}
+
+void Environment::incrementScopeLevel(Context& pContext)
+{
+   pContext.mScopeLevel++;
+}
+
+void Environment::decrementScopeLevel(Context& pContext)
+{
+   const bool isExecutionContext = pContext.mType == ContextType::Execution;
+
+   if(!isExecutionContext)
+   {
+      ParsingContext& parsingContext = static_cast<ParsingContext&>(pContext);
+
+      while(!parsingContext.mRegisteredInstances.empty() &&
+         parsingContext.mRegisteredInstances.back().mScopeLevel >= pContext.mScopeLevel)
+      {
+         parsingContext.mRegisteredInstances.pop_back();
+      }
+
+      while(!parsingContext.mLocalNamespaceStack.empty() &&
+         parsingContext.mLocalNamespaceStack.back().mScopeLevel >= pContext.mScopeLevel)
+      {
+         parsingContext.mLocalNamespaceStack.pop_back();
+      }
+   }
+
+   while(!pContext.mTypeAliases.empty() &&
+      pContext.mTypeAliases.back().mScopeLevel >= pContext.mScopeLevel)
+   {
+      pContext.mTypeAliases.pop_back();
+   }
+
+   pContext.mLocalInstancesHolder.releaseInstances(pContext.mScopeLevel, isExecutionContext);
+
+   pContext.mScopeLevel--;
+}
+
+void Environment::throwRuntimeError(ExecutionContext& pContext, RuntimeError pError, const char* pArg)
+{
+   if(!pContext.mErrorMessage.empty())
+      return;
+
+   char errorMsg[kDefaultLocalStringBufferSize];
+   snprintf(errorMsg, sizeof(errorMsg), kRuntimeErrorStrings[(int)pError], pArg);
+
+   char lineAsString[kSmallLocalStringBufferSize];
+   snprintf(lineAsString, sizeof(lineAsString), "%d", pContext.mCallStack.back().mLine);
+
+   pContext.mErrorMessage.assign("[Runtime Error] '");
+   pContext.mErrorMessage.append(pContext.mProgram->mIdentifier.mName);
+   pContext.mErrorMessage.append("' -- Line ");
+   pContext.mErrorMessage.append(lineAsString);
+   pContext.mErrorMessage.append(": ");
+   pContext.mErrorMessage.append(errorMsg);
+}
+
+void Environment::evaluateExpression(ExecutionContext& pContext, Expression* pExpression, Value* pOutValue)
+{
+   if(!pContext.mErrorMessage.empty())
+      return;
+
+   CflatCountExecution(pContext, mExpressionsCount);
+
+   switch(pExpression->getType())
+   {
+   case ExpressionType::Value:
+      {
+         ExpressionValue* expression = static_cast<ExpressionValue*>(pExpression);
+         *pOutValue = expression->mValue;
+      }
+      break;
+   case ExpressionType::NullPointer:
+      {
+         assertValueInitialization(pContext, mTypeUsageVoidPtr, pOutValue);
+         const void* nullPointer = nullptr;
+         pOutValue->set(&nullPointer);
+      }
+      break;
+   case ExpressionType::VariableAccess:
+      {
+         ExpressionVariableAccess* expression = static_cast<ExpressionVariableAccess*>(pExpression);
+         const Value* value = expression->mStaticValue;
+
+         if(!value)
+         {
+            value = &retrieveInstance(pContext, expression->mVariableIdentifier)->mValue;
+         }
+
+         if(pOutValue->mTypeUsage.isPointer() && value->mTypeUsage.isArray())
+         {
+            getAddressOfValue(pContext, *value, pOutValue);
+         }
+         else
+         {
+            *pOutValue = *value;
+         }
+      }
+      break;
+   case ExpressionType::MemberAccess:
+      {
+         ExpressionMemberAccess* expression = static_cast<ExpressionMemberAccess*>(pExpression);
+
+         if(expression->mMemberAccessType == MemberAccessType::BitField)
+         {
+            Value instanceDataValue;
+            getInstanceDataValue(pContext, expression->mMemberOwner, &instanceDataValue);
+
+            Struct* type = static_cast<Struct*>(instanceDataValue.mTypeUsage.mType);
+            BitField* bitField = type->findBitField(expression->mMemberIdentifier);
+            CflatAssert(bitField);
+            assertValueInitialization(pContext, bitField->mTypeUsage, pOutValue);
+
+            const int64_t bitFieldValue = bitField->getter(instanceDataValue.mValueBuffer);
+            setValueAsInteger(bitFieldValue, pOutValue);
+         }
+         else
+         {
+            getInstanceDataValue(pContext, expression, pOutValue);
+         }
+      }
+      break;
+   case ExpressionType::ArrayElementAccess:
+      {
+         ExpressionArrayElementAccess* expression =
+            static_cast<ExpressionArrayElementAccess*>(pExpression);
+
+         const TypeUsage& arrayTypeUsage = getTypeUsage(expression->mArray);
+         CflatAssert(arrayTypeUsage.isArray() || arrayTypeUsage.isPointer());
+
+         TypeUsage arrayElementTypeUsage = arrayTypeUsage;
+
+         if(arrayElementTypeUsage.isArray())
+         {
+            CflatResetFlag(arrayElementTypeUsage.mFlags, TypeUsageFlags::Array);
+            arrayElementTypeUsage.mArraySize = 1u;
+         }
+         else
+         {
+            arrayElementTypeUsage.mPointerLevel--;
+         }
+         
+         assertValueInitialization(pContext, arrayElementTypeUsage, pOutValue);
+
+         Value arrayValue;
+         arrayValue.mValueInitializationHint = ValueInitializationHint::Stack;
+         evaluateExpression(pContext, expression->mArray, &arrayValue);
+
+         Value indexValue;
+         indexValue.mValueInitializationHint = ValueInitializationHint::Stack;
+         evaluateExpression(pContext, expression->mArrayElementIndex, &indexValue);
+         const size_t index = (size_t)getValueAsInteger(indexValue);
+         
+         if(arrayValue.mTypeUsage.isArray())
+         {
+            const size_t arraySize = (size_t)arrayTypeUsage.mArraySize;
+
+            if(index < arraySize)
+            {
+               const size_t arrayElementSize = arrayElementTypeUsage.getSize();
+               const size_t offset = arrayElementSize * index;
+               pOutValue->set(arrayValue.mValueBuffer + offset);
+            }
+            else
+            {
+               char buffer[kDefaultLocalStringBufferSize];
+               snprintf(buffer, sizeof(buffer), "size %zu, index %zu", arraySize, index);
+               throwRuntimeError(pContext, RuntimeError::InvalidArrayIndex, buffer);
+            }
+         }
+         else
+         {
+            const size_t arrayElementTypeSize = arrayElementTypeUsage.getSize();
+            const size_t ptrOffset = arrayElementTypeSize * index;
+            const char* ptr = CflatValueAs(&arrayValue, char*) + ptrOffset;
+            memcpy(pOutValue->mValueBuffer, ptr, arrayElementTypeSize);
+         }
+      }
+      break;
+   case ExpressionType::UnaryOperation:
+      {
+         ExpressionUnaryOperation* expression = static_cast<ExpressionUnaryOperation*>(pExpression);
+
+         const TypeUsage& typeUsage = getTypeUsage(expression);
+         assertValueInitialization(pContext, typeUsage, pOutValue);
+
+         Value operand;
+
+         const bool isIndirection = expression->mOperator[0] == '*';
+
+         if(isIndirection)
+         {
+            operand.mValueInitializationHint = ValueInitializationHint::Stack; 
+         }
+         else
+         {
+            operand.initExternal(getTypeUsage(expression->mExpression));
+         }
+
+         evaluateExpression(pContext, expression->mExpression, &operand);
+
+         const bool isIncrementOrDecrement =
+            strncmp(expression->mOperator, "++", 2u) == 0 ||
+            strncmp(expression->mOperator, "--", 2u) == 0;
+
+         if(isIncrementOrDecrement)
+         {
+            pOutValue->set(operand.mValueBuffer);
+
+            applyUnaryOperator(pContext, operand, expression->mOperator, &operand);
+
+            if(!expression->mPostOperator)
+            {
+               pOutValue->set(operand.mValueBuffer);
+            }
+         }
+         else
+         {
+            applyUnaryOperator(pContext, operand, expression->mOperator, pOutValue);
+         }
+      }
+      break;
+   case ExpressionType::BinaryOperation:
+      {
+         ExpressionBinaryOperation* expression = static_cast<ExpressionBinaryOperation*>(pExpression);
+
+         const TypeUsage& typeUsage = getTypeUsage(expression);
+         assertValueInitialization(pContext, typeUsage, pOutValue);
+
+         Value leftValue;
+         leftValue.mValueInitializationHint = ValueInitializationHint::Stack;
+         evaluateExpression(pContext, expression->mLeft, &leftValue);
+
+         Value rightValue;
+         bool evaluateRightValue = true;
+
+         if(strcmp(expression->mOperator, "&&") == 0)
+         {
+            if(!getValueAsInteger(leftValue))
+            {
+               const bool value = false;
+               rightValue.initOnStack(mTypeUsageBool, &pContext.mStack);
+               rightValue.set(&value);
+               evaluateRightValue = false;
+            }
+         }
+         else if(strcmp(expression->mOperator, "||") == 0)
+         {
+            if(getValueAsInteger(leftValue))
+            {
+               const bool value = true;
+               rightValue.initOnStack(mTypeUsageBool, &pContext.mStack);
+               rightValue.set(&value);
+               evaluateRightValue = false;
+            }
+         }
+
+         if(evaluateRightValue)
+         {
+            rightValue.mValueInitializationHint = ValueInitializationHint::Stack;
+            evaluateExpression(pContext, expression->mRight, &rightValue);
+         }
+
+         applyBinaryOperator(pContext, leftValue, rightValue, expression->mOperator, pOutValue);
+      }
+      break;
+   case ExpressionType::Parenthesized:
+      {
+         ExpressionParenthesized* expression = static_cast<ExpressionParenthesized*>(pExpression);
+         evaluateExpression(pContext, expression->mExpression, pOutValue);
+      }
+      break;
+   case ExpressionType::SizeOf:
+      {
+         ExpressionSizeOf* expression = static_cast<ExpressionSizeOf*>(pExpression);
+         size_t size = 0u;
+         
+         if(expression->mSizeOfTypeUsage.mType)
+         {
+            size = expression->mSizeOfTypeUsage.getSize();
+         }
+         else if(expression->mSizeOfExpression)
+         {
+            Value value;
+            value.mValueInitializationHint = ValueInitializationHint::Stack;
+            evaluateExpression(pContext, expression->mSizeOfExpression, &value);
+            size = value.mTypeUsage.getSize();
+         }
+
+         assertValueInitialization(pContext, mTypeUsageSizeT, pOutValue);
+         pOutValue->set(&size);
+      }
+      break;
+   case ExpressionType::Cast:
+      {
+         ExpressionCast* expression = static_cast<ExpressionCast*>(pExpression);
+
+         assertValueInitialization(pContext, expression->getTypeUsage(), pOutValue);
+
+         Value valueToCast;
+         valueToCast.mValueInitializationHint = ValueInitializationHint::Stack;
+         evaluateExpression(pContext, expression->mExpression, &valueToCast);
+
+         const TypeUsage& targetTypeUsage = expression->getTypeUsage();
+
+         if(targetTypeUsage == mTypeUsageVoid)
+         {
+            // Ignore the result of the expression in void casts
+         }
+         else if(valueToCast.mTypeUsage == mTypeUsageVoidPtr ||
+            targetTypeUsage == mTypeUsageVoidPtr ||
+            expression->mCastType == CastType::Reinterpret)
+         {
+            const void* ptr = CflatValueAs(&valueToCast, void*);
+            pOutValue->set(&ptr);
+         }
+         else if(expression->mCastType == CastType::CStyle || expression->mCastType == CastType::Static)
+         {
+            performStaticCast(pContext, valueToCast, targetTypeUsage, pOutValue);
+         }
+         else if(expression->mCastType == CastType::Dynamic)
+         {
+            performInheritanceCast(pContext, valueToCast, targetTypeUsage, pOutValue);
+         }
+         else if(expression->mCastType == CastType::Const)
+         {
+            *pOutValue = valueToCast;
+            pOutValue->mTypeUsage.mFlags = expression->getTypeUsage().mFlags;
+         }
+      }
+      break;
+   case ExpressionType::Conditional:
+      {
+         ExpressionConditional* expression = static_cast<ExpressionConditional*>(pExpression);
+
+         bool conditionMet = false;
+         {
+            Value conditionValue;
+            conditionValue.mValueInitializationHint = ValueInitializationHint::Stack;
+            evaluateExpression(pContext, expression->mCondition, &conditionValue);
+            conditionMet = getValueAsInteger(conditionValue) != 0;
+         }
+
+         assertValueInitialization(pContext, expression->getTypeUsage(), pOutValue);
+
+         Expression* valueSource = conditionMet
+            ? expression->mIfExpression
+            : expression->mElseExpression;
+
+         Value expressionValue;
+         expressionValue.mValueInitializationHint = ValueInitializationHint::Stack;
+         evaluateExpression(pContext, valueSource, &expressionValue);
+         assignValue(pContext, expressionValue, pOutValue, false);
+      }
+      break;
+   case ExpressionType::Assignment:
+      {
+         ExpressionAssignment* expression = static_cast<ExpressionAssignment*>(pExpression);
+
+         const TypeUsage& expressionTypeUsage = getTypeUsage(expression->mRightValue);
+         Value expressionValue;
+         expressionValue.initOnStack(expressionTypeUsage, &pContext.mStack);
+         evaluateExpression(pContext, expression->mRightValue, &expressionValue);
+
+         Expression* instancedDataExpression = expression->mLeftValue;
+         bool bitFieldAssignment = false;
+
+         if(expression->mLeftValue->getType() == ExpressionType::MemberAccess)
+         {
+            ExpressionMemberAccess* memberAccess =
+               static_cast<ExpressionMemberAccess*>(expression->mLeftValue);
+            bitFieldAssignment = memberAccess->mMemberAccessType == MemberAccessType::BitField;
+
+            if(bitFieldAssignment)
+            {
+               instancedDataExpression = memberAccess->mMemberOwner;
+            }
+         }
+
+         const TypeUsage& instancedDataTypeUsage = getTypeUsage(instancedDataExpression);
+         Value instanceDataValue;
+         instanceDataValue.initExternal(instancedDataTypeUsage);
+         getInstanceDataValue(pContext, expression->mLeftValue, &instanceDataValue);
+
+         if(instanceDataValue.mValueBuffer)
+         {
+            if(bitFieldAssignment)
+            {
+               ExpressionMemberAccess* memberAccess =
+                  static_cast<ExpressionMemberAccess*>(expression->mLeftValue);
+
+               Struct* type = static_cast<Struct*>(instancedDataTypeUsage.mType);
+               BitField* bitField = type->findBitField(memberAccess->mMemberIdentifier);
+               CflatAssert(bitField);
+               const int64_t bitFieldValue = getValueAsInteger(expressionValue);
+               bitField->setter(instanceDataValue.mValueBuffer, bitFieldValue);
+            }
+            else
+            {
+               performAssignment(pContext, expressionValue, expression->mOperator, &instanceDataValue);
+               *pOutValue = instanceDataValue;
+            }
+         }
+      }
+      break;
+   case ExpressionType::FunctionCall:
+      {
+         ExpressionFunctionCall* expression = static_cast<ExpressionFunctionCall*>(pExpression);
+
+         Function* function = expression->mFunction;
+         CflatAssert(function);
+
+         if(function->execute)
+         {
+            assertValueInitialization(pContext, function->mReturnTypeUsage, pOutValue);
+
+            CflatArgsVector(Value) argumentValues;
+            getArgumentValues(pContext, function->mParameters, expression->mArguments, argumentValues);
+
+            if(pContext.mErrorMessage.empty())
+            {
+               CflatArgsVector(Value) preparedArgumentValues;
+               prepareArgumentsForFunctionCall(pContext, function->mParameters, argumentValues,
+                  preparedArgumentValues);
+
+               const bool functionReturnValueIsConst =
+                  CflatHasFlag(function->mReturnTypeUsage.mFlags, TypeUsageFlags::Const);
+               const bool outValueIsConst =
+                  CflatHasFlag(pOutValue->mTypeUsage.mFlags, TypeUsageFlags::Const);
+
+               if(outValueIsConst && !functionReturnValueIsConst)
+               {
+                  CflatResetFlag(pOutValue->mTypeUsage.mFlags, TypeUsageFlags::Const);
+               }
+
+               if(!function->mProgram)
+               {
+                  CflatCountExecution(pContext, mNativeCallsCount);
+               }
+
+               if(pContext.mProfile)
+               {
+                  beginProfiledCall(pContext, function);
+               }
+
+               function->execute(preparedArgumentValues, pOutValue);
+
+               if(pContext.mProfile)
+               {
+                  pContext.mProfile->endCall(getProfilerTime());
+               }
+
+               if(outValueIsConst && !functionReturnValueIsConst)
+               {
+                  CflatSetFlag(pOutValue->mTypeUsage.mFlags, TypeUsageFlags::Const);
+               }
+
+               while(!preparedArgumentValues.empty())
+               {
+                  preparedArgumentValues.pop_back();
+               }
+            }
+
+            while(!argumentValues.empty())
+            {
+               argumentValues.pop_back();
+            }
+         }
+         else
+         {
+            throwRuntimeError(pContext, RuntimeError::MissingFunctionImplementation,
+               function->mIdentifier.mName);
+         }
+      }
+      break;
+   case ExpressionType::MethodCall:
+      {
+         ExpressionMethodCall* expression = static_cast<ExpressionMethodCall*>(pExpression);
+         ExpressionMemberAccess* memberAccess =
+            static_cast<ExpressionMemberAccess*>(expression->mMemberAccess);
+
+         Method* method = expression->mMethodUsage.mMethod;
+         CflatAssert(method);
+
+         assertValueInitialization(pContext, method->mReturnTypeUsage, pOutValue);
+
+         Value instanceDataValue;
+         getInstanceDataValue(pContext, memberAccess->mMemberOwner, &instanceDataValue);
+
+         if(instanceDataValue.mTypeUsage.isPointer() && !CflatValueAs(&instanceDataValue, void*))
+         {
+            throwRuntimeError(pContext, RuntimeError::NullPointerAccess,
+               memberAccess->mMemberIdentifier.mName);
+         }
+
+         if(!pContext.mErrorMessage.empty())
+            break;
+
+         CflatArgsVector(Value) argumentValues;
+         getArgumentValues(pContext, method->mParameters, expression->mArguments, argumentValues);
+
+         if(pContext.mErrorMessage.empty())
+         {
+            CflatArgsVector(Value) preparedArgumentValues;
+            prepareArgumentsForFunctionCall(pContext, method->mParameters, argumentValues,
+               preparedArgumentValues);
+
+            {
+               Value thisPtr;
+
+               if(instanceDataValue.mTypeUsage.isPointer())
+               {
+                  thisPtr.initOnStack(instanceDataValue.mTypeUsage, &pContext.mStack);
+                  thisPtr.set(instanceDataValue.mValueBuffer);
+               }
+               else
+               {
+                  thisPtr.mValueInitializationHint = ValueInitializationHint::Stack;
+                  getAddressOfValue(pContext, instanceDataValue, &thisPtr);
+               }
+
+               if(expression->mMethodUsage.mOffset > 0u)
+               {
+                  const char* offsetThisPtr =
+                     CflatValueAs(&thisPtr, char*) + expression->mMethodUsage.mOffset;
+                  memcpy(thisPtr.mValueBuffer, &offsetThisPtr, sizeof(char*));
+               }
+
+               // methods can only be registered natively
+               CflatCountExecution(pContext, mNativeCallsCount);
+
+               if(pContext.mProfile)
+               {
+                  beginProfiledCall(pContext, method, instanceDataValue.mTypeUsage.mType);
+               }
+
+               method->execute(thisPtr, preparedArgumentValues, pOutValue);
+
+               if(pContext.mProfile)
+               {
+                  pContext.mProfile->endCall(getProfilerTime());
+               }
+            }
+
+            while(!preparedArgumentValues.empty())
+            {
+               preparedArgumentValues.pop_back();
+            }
+         }
+
+         while(!argumentValues.empty())
+         {
+            argumentValues.pop_back();
+         }
+      }
+      break;
+   case ExpressionType::ArrayInitialization:
+      {
+         ExpressionArrayInitialization* expression =
+            static_cast<ExpressionArrayInitialization*>(pExpression);
+
+         assertValueInitialization(pContext, expression->getTypeUsage(), pOutValue);
+
+         const size_t arrayElementSize = expression->mElementTypeUsage.getSize();
+
+         for(size_t i = 0u; i < expression->mValues.size(); i++)
+         {
+            Value arrayElementValue;
+            arrayElementValue.initOnStack(expression->mElementTypeUsage, &pContext.mStack);
+            evaluateExpression(pContext, expression->mValues[i], &arrayElementValue);
+
+            const size_t offset = i * arrayElementSize;
+            memcpy(pOutValue->mValueBuffer + offset, arrayElementValue.mValueBuffer, arrayElementSize);
+         }
+      }
+      break;
+   case ExpressionType::AggregateInitialization:
+      {
+         ExpressionAggregateInitialization* expression =
+            static_cast<ExpressionAggregateInitialization*>(pExpression);
+
+         assertValueInitialization(pContext, expression->getTypeUsage(), pOutValue);
+
+         Struct* type = static_cast<Struct*>(expression->getTypeUsage().mType);
+         CflatAssert(type->mMembers.size() >= expression->mValues.size());
+
+         Value objectPtrValue;
+         getAddressOfValue(pContext, *pOutValue, &objectPtrValue);
+         void* objectPtr = CflatValueAs(&objectPtrValue, void*);
+
+         for(size_t i = 0u; i < expression->mValues.size(); i++)
+         {
+            Value memberValue;
+            memberValue.mValueInitializationHint = ValueInitializationHint::Stack;
+            evaluateExpression(pContext, expression->mValues[i], &memberValue);
+
+            Member* member = type->mMembers[i];
+            CflatAssert(member->mMemberType == MemberType::Field);
+            Field* field = static_cast<Field*>(member);
+
+            char* objectMemberPtr = (char*)objectPtr + (size_t)field->mOffset;
+            const size_t objectMemberSize = field->mTypeUsage.getSize();
+            memcpy(objectMemberPtr, memberValue.mValueBuffer, objectMemberSize);
+         }
+      }
+      break;
+   case ExpressionType::ObjectConstruction:
+      {
+         ExpressionObjectConstruction* expression =
+            static_cast<ExpressionObjectConstruction*>(pExpression);
+
+         Method* ctor = expression->mConstructor;
+         CflatAssert(ctor);
+
+         assertValueInitialization(pContext, expression->getTypeUsage(), pOutValue);
+
+         CflatArgsVector(Value) argumentValues;
+         getArgumentValues(pContext, ctor->mParameters, expression->mArguments, argumentValues);
+
+         CflatArgsVector(Value) preparedArgumentValues;
+         prepareArgumentsForFunctionCall(pContext, ctor->mParameters, argumentValues,
+            preparedArgumentValues);
+
+         {
+            Value thisPtr;
+            thisPtr.mValueInitializationHint = ValueInitializationHint::Stack;
+            getAddressOfValue(pContext, *pOutValue, &thisPtr);
+
+            ctor->execute(thisPtr, preparedArgumentValues, nullptr);
+         }
+
+         while(!preparedArgumentValues.empty())
+         {
+            preparedArgumentValues.pop_back();
+         }
+
+         while(!argumentValues.empty())
+         {
+            argumentValues.pop_back();
+         }
+      }
+      break;
+   default:
+      break;
+   }
+}
+
+void Environment::getInstanceDataValue(ExecutionContext& pContext, Expression* pExpression,
+   Value* pOutValue)
+{
+   if(pExpression->getType() == ExpressionType::VariableAccess)
+   {
+      ExpressionVariableAccess* variableAccess =
+         static_cast<ExpressionVariableAccess*>(pExpression);
+
+      if(variableAccess->mStaticValue)
+      {
+         *pOutValue = *variableAccess->mStaticValue;
+      }
+      else
+      {
+         Instance* instance = retrieveInstance(pContext, variableAccess->mVariableIdentifier);
+         *pOutValue = instance->mValue;
+      }
+   }
+   else if(pExpression->getType() == ExpressionType::MemberAccess)
+   {
+      ExpressionMemberAccess* memberAccess =
+         static_cast<ExpressionMemberAccess*>(pExpression);
+
+      // parallel workers cannot share the value cached in the expression
+      if(&pContext != &mExecutionContext &&
+         memberAccess->mMemberOwnerSlot >= pContext.mMemberOwnerValues.size())
+      {
+         pContext.mMemberOwnerValues.resize(memberAccess->mMemberOwnerSlot + 1u);
+      }
+
+      Value& memberOwnerValue = &pContext == &mExecutionContext
+         ? memberAccess->mMemberOwnerValue
+         : pContext.mMemberOwnerValues[memberAccess->mMemberOwnerSlot];
+
+      evaluateExpression(pContext, memberAccess->mMemberOwner, &memberOwnerValue);
+
+      if(memberOwnerValue.mTypeUsage.isPointer() &&
+         !CflatValueAs(&memberOwnerValue, void*))
+      {
+         throwRuntimeError(pContext, RuntimeError::NullPointerAccess,
+            memberAccess->mMemberIdentifier.mName);
+      }
+
+      if(!pContext.mErrorMessage.empty())
+      {
+         return;
+      }
+
+      if(memberAccess->mMemberAccessType != MemberAccessType::Method)
+      {
+         char* instanceDataPtr = memberOwnerValue.mTypeUsage.isPointer()
+            ? CflatValueAs(&memberOwnerValue, char*)
+            : memberOwnerValue.mValueBuffer;
+
+         if(instanceDataPtr)
+         {
+            Struct* type = static_cast<Struct*>(memberOwnerValue.mTypeUsage.mType);
+
+            TypeUsage typeUsage;
+            int instanceDataPtrOffset = 0;
+
+            if(memberAccess->mMemberAccessType == MemberAccessType::Field)
+            {
+               Field* field = type->findField(memberAccess->mMemberIdentifier);
+               
+               if(field)
+               {
+                  typeUsage = field->mTypeUsage;
+                  instanceDataPtrOffset = (int)field->mOffset;
+               }
+            }
+            else
+            {
+               typeUsage.mType = type;
+            }
+
+            if(typeUsage.mType)
+            {
+               TypeUsage referenceTypeUsage = typeUsage;
+               CflatSetFlag(referenceTypeUsage.mFlags, TypeUsageFlags::Reference);
+
+               assertValueInitialization(pContext, referenceTypeUsage, pOutValue);
+               pOutValue->set(instanceDataPtr + instanceDataPtrOffset);
+            }
+         }
+      }
+   }
+   else if(pExpression->getType() == ExpressionType::ArrayElementAccess)
+   {
+      ExpressionArrayElementAccess* arrayElementAccess =
+         static_cast<ExpressionArrayElementAccess*>(pExpression);
+
+      const TypeUsage& arrayTypeUsage = getTypeUsage(arrayElementAccess->mArray);
+      const size_t arraySize = (size_t)arrayTypeUsage.mArraySize;
+
+      Value arrayIndexValue;
+      arrayIndexValue.mValueInitializationHint = ValueInitializationHint::Stack;
+      evaluateExpression(pContext, arrayElementAccess->mArrayElementIndex, &arrayIndexValue);
+      const size_t arrayIndex = (size_t)getValueAsInteger(arrayIndexValue);
+
+      if(arrayIndex < arraySize)
+      {
+         TypeUsage arrayElementTypeUsage = arrayTypeUsage;
+         CflatResetFlag(arrayElementTypeUsage.mFlags, TypeUsageFlags::Array);
+         arrayElementTypeUsage.mArraySize = 1u;
+
+         Value arrayDataValue;
+         arrayDataValue.initExternal(arrayElementTypeUsage);
+         getInstanceDataValue(pContext, arrayElementAccess->mArray, &arrayDataValue);
+
+         pOutValue->mValueBuffer =
+            arrayDataValue.mValueBuffer + (arrayIndex * arrayElementTypeUsage.getSize());
+      }
+      else
+      {
+         char buffer[kDefaultLocalStringBufferSize];
+         snprintf(buffer, sizeof(buffer), "size %zu, index %zu", arraySize, arrayIndex);
+         throwRuntimeError(pContext, Environment::RuntimeError::InvalidArrayIndex, buffer);
+      }
+   }
+   else if(pExpression->getType() == ExpressionType::UnaryOperation &&
+      static_cast<ExpressionUnaryOperation*>(pExpression)->mOperator[0] == '*')
+   {
+      ExpressionUnaryOperation* unaryOperation = static_cast<ExpressionUnaryOperation*>(pExpression);
+
+      Value value;
+      value.mValueInitializationHint = ValueInitializationHint::Stack;
+      evaluateExpression(pContext, unaryOperation->mExpression, &value);
+      CflatAssert(value.mTypeUsage.isPointer());
+
+      const void* ptr = CflatValueAs(&value, void*);
+      pOutValue->set(ptr);
+   }
+   else
+   {
+      assertValueInitialization(pContext, pExpression->getTypeUsage(), pOutValue);
+      evaluateExpression(pContext, pExpression, pOutValue);
+   }
+}
+
+void Environment::getAddressOfValue(ExecutionContext& pContext, const Value& pInstanceDataValue,
+   Value* pOutValue)
+{
+   TypeUsage pointerTypeUsage = pInstanceDataValue.mTypeUsage;
+   pointerTypeUsage.mPointerLevel++;
+   pointerTypeUsage.mArraySize = 1u;
+
+   assertValueInitialization(pContext, pointerTypeUsage, pOutValue);
+   pOutValue->set(&pInstanceDataValue.mValueBuffer);
+}
+
+void Environment::getArgumentValues(ExecutionContext& pContext, const CflatSTLVector(TypeUsage)& pParameters,
+   const CflatSTLVector(Expression*)& pExpressions, CflatArgsVector(Value)& pValues)
+{
+   pValues.resize(pExpressions.size());
+
+   for(size_t i = 0u; i < pExpressions.size(); i++)
+   {
+      pValues[i].mValueInitializationHint = ValueInitializationHint::Stack;
+
+      if(i < pParameters.size() && pParameters[i].isPointer())
+      {
+         // Set the pointer level for the value beforehand, to handle the special case where the
+         // parameter expects a pointer and the argument is an array name
+         pValues[i].mTypeUsage.mPointerLevel = pParameters[i].mPointerLevel;
+      }
+
+      evaluateExpression(pContext, pExpressions[i], &pValues[i]);
+   }
+}
+
+void Environment::prepareArgumentsForFunctionCall(ExecutionContext& pContext,
+   const CflatSTLVector(TypeUsage)& pParameters, const CflatArgsVector(Value)& pOriginalValues,
+   CflatArgsVector(Value)& pPreparedValues)
+{
+   pPreparedValues.resize(pOriginalValues.size());
+
+   for(size_t i = 0u; i < pOriginalValues.size(); i++)
+   {
+      const bool nonVariadicParameter = i < pParameters.size();
+      const TypeUsage& valueTypeUsage = nonVariadicParameter
+         ? pParameters[i]
+         : pOriginalValues[i].mTypeUsage;
+      const TypeHelper::Compatibility compatibility =
+         TypeHelper::getCompatibility(valueTypeUsage, pOriginalValues[i].mTypeUsage);
+
+      // pass by reference
+      if(nonVariadicParameter &&
+         pParameters[i].isReference() &&
+         compatibility != TypeHelper::Compatibility::ImplicitConstructable)
+      {
+         pPreparedValues[i] = pOriginalValues[i];
+         CflatSetFlag(pPreparedValues[i].mTypeUsage.mFlags, TypeUsageFlags::Reference);
+      }
+      // pass by value
+      else
+      {
+         pPreparedValues[i].initOnStack(valueTypeUsage, &pContext.mStack);
+         assignValue(pContext, pOriginalValues[i], &pPreparedValues[i], false, compatibility);
+      }
+   }
+}
+
+void Environment::applyUnaryOperator(ExecutionContext& pContext, const Value& pOperand,
+   const char* pOperator, Value* pOutValue)
+{
+   Type* type = pOperand.mTypeUsage.mType;
+
+   // overloaded operator
+   if(type->mCategory == TypeCategory::StructOrClass && !pOperand.mTypeUsage.isPointer())
+   {
+      pContext.mStringBuffer.assign("operator");
+      pContext.mStringBuffer.append(pOperator);
+
+      CflatArgsVector(Value) argumentValues;
+
+      Struct* castType = static_cast<Struct*>(type);
+      const Identifier operatorIdentifier(pContext.mStringBuffer.c_str());
+      Method* operatorMethod = castType->findMethod(operatorIdentifier);
+      Function* operatorFunction = nullptr;
+      
+      if(operatorMethod)
+      {
+         Value thisPtrValue;
+         thisPtrValue.mValueInitializationHint = ValueInitializationHint::Stack;
+         getAddressOfValue(pContext, pOperand, &thisPtrValue);
+
+         CflatCountExecution(pContext, mOperatorOverloadCallsCount);
+         operatorMethod->execute(thisPtrValue, argumentValues, pOutValue);
+      }
+      else
+      {
+         argumentValues.push_back(pOperand);
+
+         operatorFunction = type->mNamespace->getFunction(operatorIdentifier, argumentValues);
+
+         if(!operatorFunction)
+         {
+            operatorFunction = findFunction(pContext, operatorIdentifier, argumentValues);
+
+            if(operatorFunction)
+            {
+               CflatCountExecution(pContext, mOperatorOverloadCallsCount);
+               operatorFunction->execute(argumentValues, pOutValue);
+            }
+         }
+      }
+
+      if(operatorMethod || operatorFunction)
+      {
+         return;
+      }
+   }
+
+   // address of
+   if(pOperator[0] == '&')
+   {
+      getAddressOfValue(pContext, pOperand, pOutValue);
+   }
+   // integer built-in / pointer
+   else if(type->isInteger() || pOperand.mTypeUsage.isPointer())
+   {
+      if(pOperator[0] == '*')
+      {
+         CflatAssert(pOperand.mTypeUsage.isPointer());
+         CflatAssert(pOperand.mTypeUsage.mType == pOutValue->mTypeUsage.mType);
+         CflatAssert(pOperand.mTypeUsage.mPointerLevel == (pOutValue->mTypeUsage.mPointerLevel + 1u));
+
+         const void* ptr = CflatValueAs(&pOperand, void*);
+         pOutValue->set(ptr);
+      }
+      else
+      {
+         const int64_t valueAsInteger = getValueAsInteger(pOperand);
+
+         if(pOperator[0] == '!')
+         {
+            setValueAsInteger(!valueAsInteger, pOutValue);
+         }
+         else if(strcmp(pOperator, "++") == 0 || strcmp(pOperator, "--") == 0)
+         {
+            int64_t increment = 1;
+
+            if(pOutValue->mTypeUsage.isPointer())
+            {
+               TypeUsage indirectionTypeUsage = pOutValue->mTypeUsage;
+               indirectionTypeUsage.mPointerLevel--;
+               increment = (int64_t)indirectionTypeUsage.getSize();
+            }
+
+            if(pOperator[0] == '-')
+            {
+               increment *= -1;
+            }
+
+            setValueAsInteger(valueAsInteger + increment, pOutValue);
+         }
+         else if(pOperator[0] == '-')
+         {
+            setValueAsInteger(-valueAsInteger, pOutValue);
+         }
+         else if(pOperator[0] == '~')
+         {
+            setValueAsInteger(~valueAsInteger, pOutValue);
+         }
+      }
+   }
+   // decimal built-in
+   else if(type->mCategory == TypeCategory::BuiltIn)
+   {
+      if(pOperator[0] == '-')
+      {
+         const double valueAsDecimal = getValueAsDecimal(pOperand);
+         setValueAsDecimal(-valueAsDecimal, pOutValue);
+      }
+   }
+}
+
+void Environment::applyBinaryOperator(ExecutionContext& pContext, const Value& pLeft, const Value& pRight,
+   const char* pOperator, Value* pOutValue)
+{
+   if(!pContext.mErrorMessage.empty())
+   {
+      return;
+   }
+
+   Type* leftType = pLeft.mTypeUsage.mType;
+   Type* rightType = pRight.mTypeUsage.mType;
+
+   const bool leftIsNumericValue =
+      leftType->mCategory == TypeCategory::BuiltIn ||
+      leftType->mCategory == TypeCategory::Enum ||
+      leftType->mCategory == TypeCategory::EnumClass ||
+      pLeft.mTypeUsage.isPointer();
+   const bool rightIsNumericValue =
+      rightType->mCategory == TypeCategory::BuiltIn ||
+      rightType->mCategory == TypeCategory::Enum ||
+      rightType->mCategory == TypeCategory::EnumClass ||
+      pRight.mTypeUsage.isPointer();
+
+   if(leftIsNumericValue && rightIsNumericValue)
+   {
+      const bool integerLeftValue =
+         leftType->isInteger() ||
+         leftType->mCategory == TypeCategory::EnumClass ||
+         pLeft.mTypeUsage.isPointer();
+      const bool integerRightValue =
+         rightType->isInteger() ||
+         rightType->mCategory == TypeCategory::EnumClass ||
+         pRight.mTypeUsage.isPointer();
+      const bool integerValues = integerLeftValue && integerRightValue;
+
+      int64_t leftValueAsInteger = getValueAsInteger(pLeft);
+      int64_t rightValueAsInteger = getValueAsInteger(pRight);
+      double leftValueAsDecimal = 0.0;
+      double rightValueAsDecimal = 0.0;
+
+      if(integerLeftValue)
+      { 
+         if(!integerRightValue)
+         {
+            leftValueAsDecimal = (double)leftValueAsInteger;
+         }
+      }
+      else
+      {
+         leftValueAsDecimal = getValueAsDecimal(pLeft);
+      }
+
+      if(integerRightValue)
+      {
+         if(!integerLeftValue)
+         {
+            rightValueAsDecimal = (double)rightValueAsInteger;
+         }
+      }
+      else
+      {
+         rightValueAsDecimal = getValueAsDecimal(pRight);
+      }
+
+      if(strcmp(pOperator, "==") == 0)
+      {
+         const bool result = leftValueAsInteger == rightValueAsInteger;
+         pOutValue->assign(&result);
+      }
+      else if(strcmp(pOperator, "!=") == 0)
+      {
+         const bool result = leftValueAsInteger != rightValueAsInteger;
+         pOutValue->assign(&result);
+      }
+      else if(strcmp(pOperator, "<") == 0)
+      {
+         const bool result = integerValues
+            ? leftValueAsInteger < rightValueAsInteger
+            : leftValueAsDecimal < rightValueAsDecimal;
+         pOutValue->assign(&result);
+      }
+      else if(strcmp(pOperator, ">") == 0)
+      {
+         const bool result = integerValues
+            ? leftValueAsInteger > rightValueAsInteger
+            : leftValueAsDecimal > rightValueAsDecimal;
+         pOutValue->assign(&result);
+      }
+      else if(strcmp(pOperator, "<=") == 0)
+      {
+         const bool result = integerValues
+            ? leftValueAsInteger <= rightValueAsInteger
+            : leftValueAsDecimal <= rightValueAsDecimal;
+         pOutValue->assign(&result);
+      }
+      else if(strcmp(pOperator, ">=") == 0)
+      {
+         const bool result = integerValues
+            ? leftValueAsInteger >= rightValueAsInteger
+            : leftValueAsDecimal >= rightValueAsDecimal;
+         pOutValue->assign(&result);
+      }
+      else if(strcmp(pOperator, "&&") == 0)
+      {
+         const bool result = leftValueAsInteger && rightValueAsInteger;
+         pOutValue->assign(&result);
+      }
+      else if(strcmp(pOperator, "||") == 0)
+      {
+         const bool result = leftValueAsInteger || rightValueAsInteger;
+         pOutValue->assign(&result);
+      }
+      else if(strcmp(pOperator, "+") == 0)
+      {
+         if(integerValues)
+         {
+            if(pLeft.mTypeUsage.isPointer())
+            {
+               TypeUsage indirectionTypeUsage = pLeft.mTypeUsage;
+               indirectionTypeUsage.mPointerLevel--;
+               rightValueAsInteger *= (int64_t)indirectionTypeUsage.getSize();
+            }
+
+            setValueAsInteger(leftValueAsInteger + rightValueAsInteger, pOutValue);
+         }
+         else
+         {
+            setValueAsDecimal(leftValueAsDecimal + rightValueAsDecimal, pOutValue);
+         }
+      }
+      else if(strcmp(pOperator, "-") == 0)
+      {
+         if(integerValues)
+         {
+            if(pLeft.mTypeUsage.isPointer())
+            {
+               TypeUsage indirectionTypeUsage = pLeft.mTypeUsage;
+               indirectionTypeUsage.mPointerLevel--;
+               rightValueAsInteger *= (int64_t)indirectionTypeUsage.getSize();
+            }
+
+            setValueAsInteger(leftValueAsInteger - rightValueAsInteger, pOutValue);
+         }
+         else
+         {
+            setValueAsDecimal(leftValueAsDecimal - rightValueAsDecimal, pOutValue);
+         }
+      }
+      else if(strcmp(pOperator, "*") == 0)
+      {
+         if(integerValues)
+         {
+            setValueAsInteger(leftValueAsInteger * rightValueAsInteger, pOutValue);
+         }
+         else
+         {
+            setValueAsDecimal(leftValueAsDecimal * rightValueAsDecimal, pOutValue);
+         }
+      }
+      else if(strcmp(pOperator, "/") == 0)
+      {
+         if(integerValues)
+         {
+            if(rightValueAsInteger != 0)
+            {
+               setValueAsInteger(leftValueAsInteger / rightValueAsInteger, pOutValue);
+            }
+            else
+            {
+               throwRuntimeError(pContext, RuntimeError::DivisionByZero);
+            }
+         }
+         else
+         {
+            if(fabs(rightValueAsDecimal) > 0.000000001)
+            {
+               setValueAsDecimal(leftValueAsDecimal / rightValueAsDecimal, pOutValue);
+            }
+            else
+            {
+               throwRuntimeError(pContext, RuntimeError::DivisionByZero);
+            }
+         }
+      }
+      else if(strcmp(pOperator, "%") == 0)
+      {
+         setValueAsInteger(leftValueAsInteger % rightValueAsInteger, pOutValue);
+      }
+      else if(strcmp(pOperator, "&") == 0)
+      {
+         setValueAsInteger(leftValueAsInteger & rightValueAsInteger, pOutValue);
+      }
+      else if(strcmp(pOperator, "|") == 0)
+      {
+         setValueAsInteger(leftValueAsInteger | rightValueAsInteger, pOutValue);
+      }
+      else if(strcmp(pOperator, "^") == 0)
+      {
+         setValueAsInteger(leftValueAsInteger ^ rightValueAsInteger, pOutValue);
+      }
+      else if(strcmp(pOperator, "<<") == 0)
+      {
+         setValueAsInteger(leftValueAsInteger << rightValueAsInteger, pOutValue);
+      }
+      else if(strcmp(pOperator, ">>") == 0)
+      {
+         setValueAsInteger(leftValueAsInteger >> rightValueAsInteger, pOutValue);
+      }
+   }
+   else
+   {
+      pContext.mStringBuffer.assign("operator");
+      pContext.mStringBuffer.append(pOperator);
+
+      CflatArgsVector(Value) argumentValues;
+      argumentValues.push_back(pRight);
+
+      const Identifier operatorIdentifier(pContext.mStringBuffer.c_str());
+      Method* operatorMethod = leftType->mCategory == TypeCategory::StructOrClass
+         ? static_cast<Struct*>(leftType)->findMethod(operatorIdentifier, argumentValues)
+         : nullptr;
+      
+      if(operatorMethod)
+      {
+         Value thisPtrValue;
+         thisPtrValue.mValueInitializationHint = ValueInitializationHint::Stack;
+         getAddressOfValue(pContext, pLeft, &thisPtrValue);
+
+         CflatArgsVector(Value) preparedArgumentValues;
+         prepareArgumentsForFunctionCall(pContext, operatorMethod->mParameters,
+            argumentValues, preparedArgumentValues);
+
+         CflatCountExecution(pContext, mOperatorOverloadCallsCount);
+         operatorMethod->execute(thisPtrValue, preparedArgumentValues, pOutValue);
+
+         while(!preparedArgumentValues.empty())
+         {
+            preparedArgumentValues.pop_back();
+         }
+      }
+      else
+      {
+         argumentValues.insert(argumentValues.begin(), pLeft);
+
+         Function* operatorFunction =
+            leftType->mNamespace->getFunction(operatorIdentifier, argumentValues);
+
+         if(!operatorFunction)
+         {
+            operatorFunction = findFunction(pContext, operatorIdentifier, argumentValues);
+         }
+
+         CflatAssert(operatorFunction);
+
+         CflatArgsVector(Value) preparedArgumentValues;
+         prepareArgumentsForFunctionCall(pContext, operatorFunction->mParameters,
+            argumentValues, preparedArgumentValues);
+
+         CflatCountExecution(pContext, mOperatorOverloadCallsCount);
+         operatorFunction->execute(preparedArgumentValues, pOutValue);
+
+         while(!preparedArgumentValues.empty())
+         {
+            preparedArgumentValues.pop_back();
+         }
+      }
+   }
+}
+
+void Environment::performAssignment(ExecutionContext& pContext, const Value& pValue,
+   const char* pOperator, Value* pInstanceDataValue)
+{
+   if(strcmp(pOperator, "=") == 0)
+   {
+      assignValue(pContext, pValue, pInstanceDataValue, false);
+   }
+   else
+   {
+      char binaryOperator[2];
+      binaryOperator[0] = pOperator[0];
+      binaryOperator[1] = '\0';
+
+      applyBinaryOperator(pContext, *pInstanceDataValue, pValue, binaryOperator, pInstanceDataValue);
+   }
+}
+
+void Environment::performStaticCast(ExecutionContext& pContext, const Value& pValueToCast,
+   const TypeUsage& pTargetTypeUsage, Value* pOutValue)
+{
+   const TypeUsage& sourceTypeUsage = pValueToCast.mTypeUsage;
+
+   if(pTargetTypeUsage.mType->mCategory == TypeCategory::StructOrClass)
+   {
+      if(sourceTypeUsage.mType->mCategory == TypeCategory::StructOrClass)
+      {
+         performInheritanceCast(pContext, pValueToCast, pTargetTypeUsage, pOutValue);
+      }
+   }
+   else
+   {
+      if(sourceTypeUsage.mType->isInteger() ||
+         sourceTypeUsage.mType->mCategory == TypeCategory::EnumClass)
+      {
+         const int64_t sourceValueAsInteger = getValueAsInteger(pValueToCast);
+
+         if(pTargetTypeUsage.mType->isInteger() ||
+            pTargetTypeUsage.mType->mCategory == TypeCategory::EnumClass)
+         {
+            setValueAsInteger(sourceValueAsInteger, pOutValue);
+         }
+         else
+         {
+            setValueAsDecimal((double)sourceValueAsInteger, pOutValue);
+         }
+      }
+      else if(sourceTypeUsage.mType->isDecimal())
+      {
+         const double sourceValueAsDecimal = getValueAsDecimal(pValueToCast);
+
+         if(pTargetTypeUsage.mType->isInteger() ||
+            pTargetTypeUsage.mType->mCategory == TypeCategory::EnumClass)
+         {
+            setValueAsInteger((int64_t)sourceValueAsDecimal, pOutValue);
+         }
+         else
+         {
+            setValueAsDecimal(sourceValueAsDecimal, pOutValue);
+         }
+      }
+   }
+}
+
+void Environment::performIntegerCast(ExecutionContext& pContext, const Value& pValueToCast,
+   const TypeUsage& pTargetTypeUsage, Value* pOutValue)
+{
+   setValueAsInteger(getValueAsInteger(pValueToCast), pOutValue);
+}
+
+void Environment::performIntegerFloatCast(ExecutionContext& pContext, const Value& pValueToCast,
+   const TypeUsage& pTargetTypeUsage, Value* pOutValue)
+{
+   Type* sourceType = pValueToCast.mTypeUsage.mType;
+   Type* targetType = pTargetTypeUsage.mType;
+
+   CflatAssert(sourceType->mCategory == TypeCategory::BuiltIn);
+   CflatAssert(targetType->mCategory == TypeCategory::BuiltIn);
+
+   if(sourceType->isInteger() && targetType->isDecimal())
+   {
+      const int64_t integerValue = getValueAsInteger(pValueToCast);
+      setValueAsDecimal((double)integerValue, pOutValue);
+   }
+   else if(sourceType->isDecimal() && targetType->isInteger())
+   {
+      const double decimalValue = getValueAsDecimal(pValueToCast);
+      setValueAsInteger((int64_t)decimalValue, pOutValue);
+   }
+}
+
+void Environment::performFloatCast(ExecutionContext& pContext, const Value& pValueToCast,
+   const TypeUsage& pTargetTypeUsage, Value* pOutValue)
+{
+   Type* sourceType = pValueToCast.mTypeUsage.mType;
+   Type* targetType = pTargetTypeUsage.mType;
+
+   CflatAssert(sourceType->mCategory == TypeCategory::BuiltIn);
+   CflatAssert(targetType->mCategory == TypeCategory::BuiltIn);
+
+   const double decimalValue = getValueAsDecimal(pValueToCast);
+   setValueAsDecimal(decimalValue, pOutValue);
+}
+
+void Environment::performInheritanceCast(ExecutionContext& pContext, const Value& pValueToCast,
+   const TypeUsage& pTargetTypeUsage, Value* pOutValue)
+{
+   CflatAssert(pValueToCast.mTypeUsage.mType->mCategory == TypeCategory::StructOrClass);
+   CflatAssert(pTargetTypeUsage.mType->mCategory == TypeCategory::StructOrClass);
+
+   Struct* sourceType = static_cast<Struct*>(pValueToCast.mTypeUsage.mType);
+   Struct* targetType = static_cast<Struct*>(pTargetTypeUsage.mType);
+
+   char* ptr = nullptr;
+
+   if(sourceType == targetType)
+   {
+      ptr = CflatValueAs(&pValueToCast, char*);
+   }
+   else if(sourceType->derivedFrom(targetType))
+   {
+      ptr = CflatValueAs(&pValueToCast, char*) + sourceType->getOffset(targetType);
+   }
+   else if(targetType->derivedFrom(sourceType))
+   {
+      ptr = CflatValueAs(&pValueToCast, char*) - targetType->getOffset(sourceType);
+   }
+
+   pOutValue->assign(&ptr);
+}
+
+void Environment::performImplicitConstruction(ExecutionContext& pContext, Type* pCtorType,
+   const Value& pCtorArg, Value* pObjectValue)
+{
+   static const Hash kInitializerListIdentifierHash = hash("initializer_list");
+
+   CflatAssert(pCtorType->mCategory == TypeCategory::StructOrClass);
+   Struct* ctorType = static_cast<Struct*>(pCtorType);
+
+   CflatArgsVector(Value) ctorArgs;
+   ctorArgs.push_back(pCtorArg);
+   Method* ctor = ctorType->findConstructor(ctorArgs);
+   CflatAssert(ctor);
+
+   Value thisPtrValue;
+   thisPtrValue.mValueInitializationHint = ValueInitializationHint::Stack;
+   getAddressOfValue(pContext, *pObjectValue, &thisPtrValue);
+
+   // Special case: array initializer list
+   if(ctor->mParameters[0].mType->mIdentifier.mHash == kInitializerListIdentifierHash &&
+      pCtorArg.mTypeUsage.isArray())
+   {
+      Type* initializerListType = ctor->mParameters[0].mType;
+      TypeUsage initializerListTypeUsage;
+      initializerListTypeUsage.mType = initializerListType;
+
+      Value initializerListValue;
+      initializerListValue.initOnStack(initializerListTypeUsage, &pContext.mStack);
+
+      TypeUsage arrayElementConstPtr;
+      arrayElementConstPtr.mType = pCtorArg.mTypeUsage.mType;
+      arrayElementConstPtr.mPointerLevel = pCtorArg.mTypeUsage.mPointerLevel + 1u;
+      CflatSetFlag(arrayElementConstPtr.mFlags, TypeUsageFlags::Const);
+
+      void* arrayBeginPtr = pCtorArg.mValueBuffer;
+      void* arrayEndPtr = (char*)arrayBeginPtr + pCtorArg.mTypeUsage.getSize();
+
+      CflatArgsVector(Value) initializerListCtorArgs;
+      initializerListCtorArgs.emplace_back();
+      Value& initializerListCtorArgArrayBeginPtr = initializerListCtorArgs.back();
+      initializerListCtorArgArrayBeginPtr.initOnStack(arrayElementConstPtr, &pContext.mStack);
+      initializerListCtorArgArrayBeginPtr.set(&arrayBeginPtr);
+      initializerListCtorArgs.emplace_back();
+      Value& initializerListCtorArgArrayEndPtr = initializerListCtorArgs.back();
+      initializerListCtorArgArrayEndPtr.initOnStack(arrayElementConstPtr, &pContext.mStack);
+      initializerListCtorArgArrayEndPtr.set(&arrayEndPtr);
 
-   return true;
+      Value initializerListPtrValue;
+      initializerListPtrValue.mValueInitializationHint = ValueInitializationHint::Stack;
+      getAddressOfValue(pContext, initializerListValue, &initializerListPtrValue);
+
+      Method* initializerListCtor =
+         static_cast<Struct*>(initializerListType)->findConstructor(initializerListCtorArgs);
+      CflatAssert(initializerListCtor);
+
+      Value unusedReturnValue;
+      initializerListCtor->execute(initializerListPtrValue, initializerListCtorArgs, &unusedReturnValue);
+
+      ctorArgs[0] = initializerListValue;
+      ctor->execute(thisPtrValue, ctorArgs, &unusedReturnValue);
+   }
+   // General case
+   else
+   {
+      Value unusedReturnValue;
+      ctor->execute(thisPtrValue, ctorArgs, &unusedReturnValue);
+   }
 }
 
-bool Environment::isTemplate(ParsingContext& pContext, size_t pTokenLastIndex) const
+void Environment::assignValue(ExecutionContext& pContext, const Value& pSource, Value* pTarget,
+   bool pDeclaration)
 {
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t& tokenIndex = pContext.mTokenIndex;
+   const TypeHelper::Compatibility compatibility =
+      TypeHelper::getCompatibility(pTarget->mTypeUsage, pSource.mTypeUsage);
+   assignValue(pContext, pSource, pTarget, pDeclaration, compatibility);
+}
 
-   if(tokens[tokenIndex].mLength != 1u || tokens[tokenIndex].mStart[0] != '<')
-      return false;
+void Environment::assignValue(ExecutionContext& pContext, const Value& pSource, Value* pTarget,
+   bool pDeclaration, TypeHelper::Compatibility pCompatibility)
+{
+   const TypeUsage typeUsage = pTarget->mTypeUsage;
 
-   const size_t templateClosureTokenIndex =
-      findClosureTokenIndex(pContext, '<', '>', pTokenLastIndex);
+   if(pCompatibility == TypeHelper::Compatibility::ImplicitCastableInteger)
+   {
+      performIntegerCast(pContext, pSource, typeUsage, pTarget);
+   }
+   else if(pCompatibility == TypeHelper::Compatibility::ImplicitCastableIntegerFloat)
+   {
+      performIntegerFloatCast(pContext, pSource, typeUsage, pTarget);
+   }
+   else if(pCompatibility == TypeHelper::Compatibility::ImplicitCastableFloat)
+   {
+      performFloatCast(pContext, pSource, typeUsage, pTarget);
+   }
+   else if(pCompatibility == TypeHelper::Compatibility::ImplicitCastableInheritance)
+   {
+      performInheritanceCast(pContext, pSource, typeUsage, pTarget);
+   }
+   else if(pCompatibility == TypeHelper::Compatibility::ImplicitConstructable)
+   {
+      performImplicitConstruction(pContext, typeUsage.mType, pSource, pTarget);
+   }
+   else
+   {
+      bool valueAssigned = false;
 
-   return isTemplate(pContext, tokenIndex, templateClosureTokenIndex);
+      if(!pTarget->mTypeUsage.isPointer() &&
+         pTarget->mTypeUsage.mType->mCategory == TypeCategory::StructOrClass)
+      {
+         Struct* type = static_cast<Struct*>(pTarget->mTypeUsage.mType);
+
+         if(pDeclaration)
+         {
+            if(!pTarget->mTypeUsage.isReference())
+            {
+               Method* copyCtor = type->getCopyConstructor();
+
+               if(copyCtor)
+               {
+                  Value thisPtrValue;
+                  thisPtrValue.mValueInitializationHint = ValueInitializationHint::Stack;
+                  getAddressOfValue(pContext, *pTarget, &thisPtrValue);
+
+                  Method* defaultCtor = type->getDefaultConstructor();
+
+                  if(defaultCtor)
+                  {
+                     defaultCtor->execute(thisPtrValue, Value::kEmptyList(), nullptr);
+                  }
+
+                  TypeUsage referenceTypeUsage;
+                  referenceTypeUsage.mType = type;
+                  CflatSetFlag(referenceTypeUsage.mFlags, TypeUsageFlags::Reference);
+
+                  Value referenceValue;
+                  referenceValue.initExternal(referenceTypeUsage);
+                  referenceValue.set(pSource.mValueBuffer);
+
+                  CflatArgsVector(Value) copyCtorArgs;
+                  copyCtorArgs.push_back(referenceValue);
+                  copyCtor->execute(thisPtrValue, copyCtorArgs, nullptr);
+
+                  valueAssigned = true;
+               }
+            }
+         }
+         else
+         {
+            CflatArgsVector(Value) args;
+            args.push_back(pSource);
+
+            const Identifier operatorIdentifier("operator=");
+            Method* operatorMethod = type->findMethod(operatorIdentifier, args);
+
+            if(operatorMethod && operatorMethod->mReturnTypeUsage.mType == type)
+            {
+               Value thisPtrValue;
+               thisPtrValue.mValueInitializationHint = ValueInitializationHint::Stack;
+               getAddressOfValue(pContext, *pTarget, &thisPtrValue);
+
+               Method* defaultCtor = type->getDefaultConstructor();
+
+               if(defaultCtor)
+               {
+                  defaultCtor->execute(thisPtrValue, Value::kEmptyList(), nullptr);
+               }
+
+               operatorMethod->execute(thisPtrValue, args, pTarget);
+
+               valueAssigned = true;
+            }
+         }
+      }
+
+      if(!valueAssigned)
+      {
+         if(pDeclaration)
+         {
+            *pTarget = pSource;
+         }
+         else
+         {
+            pTarget->assign(pSource.mValueBuffer);
+         }
+      }
+   }
+}
+
+void Environment::execute(ExecutionContext& pContext, const Program& pProgram)
+{
+   pContext.mJumpStatement = JumpStatement::None;
+
+   {
+      AllocationReasonScope reasonScope(AllocationReason::ExecutionState);
+      pContext.mCallStack.emplace_back(&pProgram);
+   }
+
+   for(size_t i = 0u; i < pProgram.mStatements.size(); i++)
+   {
+      execute(pContext, pProgram.mStatements[i]);
+
+      if(!pContext.mErrorMessage.empty())
+      {
+         break;
+      }
+   }
+
+   pContext.mCallStack.pop_back();
+
+   if(mExecutionHook)
+   {
+      mExecutionHook(this, pContext.mCallStack);
+   }
+
+   pContext.mUsingDirectives.clear();
+}
+
+void Environment::assertValueInitialization(ExecutionContext& pContext, const TypeUsage& pTypeUsage,
+   Value* pOutValue)
+{
+   if(pOutValue->mValueBufferType == ValueBufferType::Uninitialized)
+   {
+      if(pTypeUsage.isReference())
+      {
+         pOutValue->initExternal(pTypeUsage);
+      }
+      else if(pOutValue->mValueInitializationHint == ValueInitializationHint::Stack)
+      {
+         pOutValue->initOnStack(pTypeUsage, &pContext.mStack);
+      }
+      else
+      {
+         pOutValue->initOnHeap(pTypeUsage);
+      }
+   }
+}
+
+int64_t Environment::getValueAsInteger(const Value& pValue)
+{
+   const bool signedType =
+      !pValue.mTypeUsage.isPointer() &&
+      pValue.mTypeUsage.mType->mCategory == TypeCategory::BuiltIn &&
+      pValue.mTypeUsage.mType->mIdentifier.mName[0] == 'i';
+
+   const size_t typeUsageSize = pValue.mTypeUsage.getSize();
+   int64_t valueAsInteger = 0;
+
+   if(typeUsageSize == sizeof(int32_t))
+   {
+      valueAsInteger = signedType
+         ? (int64_t)CflatValueAs(&pValue, int32_t)
+         : (int64_t)CflatValueAs(&pValue, uint32_t);
+   }
+   else if(typeUsageSize == sizeof(int64_t))
+   {
+      valueAsInteger = CflatValueAs(&pValue, int64_t);
+   }
+   else if(typeUsageSize == sizeof(int16_t))
+   {
+      valueAsInteger = signedType
+         ? (int64_t)CflatValueAs(&pValue, int16_t)
+         : (int64_t)CflatValueAs(&pValue, uint16_t);
+   }
+   else if(typeUsageSize == sizeof(int8_t))
+   {
+      valueAsInteger = signedType
+         ? (int64_t)CflatValueAs(&pValue, int8_t)
+         : (int64_t)CflatValueAs(&pValue, uint8_t);
+   }
+   else
+   {
+      CflatAssert(false); // Unsupported
+   }
+
+   return valueAsInteger;
+}
+
+double Environment::getValueAsDecimal(const Value& pValue)
+{
+   const size_t typeUsageSize = pValue.mTypeUsage.getSize();
+   double valueAsDecimal = 0.0;
+
+   if(typeUsageSize == sizeof(float))
+   {
+      valueAsDecimal = (double)CflatValueAs(&pValue, float);
+   }
+   else if(typeUsageSize == sizeof(double))
+   {
+      valueAsDecimal = CflatValueAs(&pValue, double);
+   }
+   else
+   {
+      CflatAssert(false); // Unsupported
+   }
+
+   return valueAsDecimal;
 }
 
-bool Environment::isCastAllowed(CastType pCastType, const TypeUsage& pFrom, const TypeUsage& pTo) const
+void Environment::setValueAsInteger(int64_t pInteger, Value* pOutValue)
 {
-   if(!pFrom.mType || !pTo.mType)
-   {
-      return false;
-   }
+   const size_t typeUsageSize = pOutValue->mTypeUsage.getSize();
 
-   if(pTo == pFrom)
+   if(typeUsageSize == sizeof(int32_t))
    {
-      return true;
+      const int32_t value = (int32_t)pInteger;
+      pOutValue->assign(&value);
    }
-
-   if(pFrom.isPointer() && pTo.isPointer() && (pFrom == mTypeUsageVoidPtr || pTo == mTypeUsageVoidPtr))
+   else if(typeUsageSize == sizeof(int64_t))
    {
-      return true;
+      pOutValue->assign(&pInteger);
    }
-
-   if(pTo == mTypeUsageVoid && pCastType == CastType::CStyle)
+   else if(typeUsageSize == sizeof(int16_t))
    {
-      return true;
+      const int16_t value = (int16_t)pInteger;
+      pOutValue->assign(&value);
    }
-
-   bool castAllowed = false;
-
-   switch(pCastType)
+   else if(typeUsageSize == sizeof(int8_t))
    {
-   case CastType::CStyle:
-   case CastType::Static:
-      if(pFrom.mType->mCategory == TypeCategory::BuiltIn &&
-         pTo.mType->mCategory == TypeCategory::BuiltIn)
-      {
-         castAllowed = true;
-      }
-      else if(pFrom.mType->isInteger() && pTo.mType->isInteger())
-      {
-         castAllowed = true;
-      }
-      else if(pFrom.mType->isInteger() && pTo.mType->isDecimal())
-      {
-         castAllowed = true;
-      }
-      else if(pFrom.mType->isDecimal() && pTo.mType->isInteger())
-      {
-         castAllowed = true;
-      }
-      else if(pFrom.mType->mCategory == TypeCategory::EnumClass &&
-         pTo.mType->mCategory == TypeCategory::BuiltIn)
-      {
-         castAllowed = true;
-      }
-      else if(pFrom.mType->mCategory == TypeCategory::BuiltIn &&
-         pTo.mType->mCategory == TypeCategory::EnumClass)
-      {
-         castAllowed = true;
-      }
-      else if(pFrom.mType->mCategory == TypeCategory::StructOrClass &&
-         pFrom.isPointer() &&
-         pTo.mType->mCategory == TypeCategory::StructOrClass &&
-         pTo.isPointer())
-      {
-         Struct* sourceType = static_cast<Struct*>(pFrom.mType);
-         Struct* targetType = static_cast<Struct*>(pTo.mType);
-         castAllowed =
-            sourceType->derivedFrom(targetType) || targetType->derivedFrom(sourceType);
-      }
-      break;
-   case CastType::Dynamic:
-      castAllowed =
-         pFrom.isPointer() &&
-         pFrom.mType->mCategory == TypeCategory::StructOrClass &&
-         pTo.isPointer() &&
-         pTo.mType->mCategory == TypeCategory::StructOrClass;
-      break;
-   case CastType::Reinterpret:
-      castAllowed =
-         pFrom.isPointer() &&
-         pTo.isPointer();
-      break;
-   case CastType::Const:
-      castAllowed = pFrom.mType == pTo.mType;
-      break;
-   default:
-      break;
+      const int8_t value = (int8_t)pInteger;
+      pOutValue->assign(&value);
    }
-
-   return castAllowed;
-}
-
-bool Environment::isMethodCallAllowed(Method* pMethod, const TypeUsage& pOwnerTypeUsage) const
-{
-   if(!CflatHasFlag(pMethod->mFlags, MethodFlags::Const))
+   else
    {
-      if((pOwnerTypeUsage.isPointer() && pOwnerTypeUsage.isConstPointer()) ||
-         (!pOwnerTypeUsage.isPointer() && pOwnerTypeUsage.isConst()))
-      {
-         return false;
-      }
+      CflatAssert(false); // Unsupported
    }
-
-   return true;
 }
 
-Statement* Environment::parseStatement(ParsingContext& pContext)
+void Environment::setValueAsDecimal(double pDecimal, Value* pOutValue)
 {
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t& tokenIndex = pContext.mTokenIndex;
-   const Token& token = tokens[tokenIndex];
-
-   Statement* statement = nullptr;
-   const uint16_t statementLine = token.mLine;
+   const size_t typeUsageSize = pOutValue->mTypeUsage.getSize();
 
-   if(token.mType == TokenType::Punctuation && (token.mStart[0] == '{' || token.mStart[0] == '}'))
+   if(typeUsageSize == sizeof(float))
    {
-      // block
-      if(token.mStart[0] == '{')
-      {
-         statement = parseStatementBlock(pContext, true, false);
-      }
+      const float value = (float)pDecimal;
+      pOutValue->assign(&value);
    }
-   else if(token.mType == TokenType::Keyword &&
-      strncmp(token.mStart, "const", 5u) != 0 &&
-      strncmp(token.mStart, "static", 6u) != 0 &&
-      strncmp(token.mStart, "void", 4u) != 0)
+   else if(typeUsageSize == sizeof(double))
    {
-      // if
-      if(strncmp(token.mStart, "if", 2u) == 0)
-      {
-         tokenIndex++;
-         statement = parseStatementIf(pContext);
-      }
-      // switch
-      else if(strncmp(token.mStart, "switch", 6u) == 0)
-      {
-         tokenIndex++;
-         statement = parseStatementSwitch(pContext);
-      }
-      // while
-      else if(strncmp(token.mStart, "while", 5u) == 0)
-      {
-         tokenIndex++;
-         statement = parseStatementWhile(pContext);
-      }
-      // do
-      else if(strncmp(token.mStart, "do", 2u) == 0)
-      {
-         tokenIndex++;
-         statement = parseStatementDoWhile(pContext);
-      }
-      // for
-      else if(strncmp(token.mStart, "for", 3u) == 0)
-      {
-         tokenIndex++;
-         statement = parseStatementFor(pContext);
-      }
-      // break
-      else if(strncmp(token.mStart, "break", 5u) == 0)
-      {
-         tokenIndex++;
-         statement = parseStatementBreak(pContext);
-      }
-      // continue
-      else if(strncmp(token.mStart, "continue", 8u) == 0)
-      {
-         tokenIndex++;
-         statement = parseStatementContinue(pContext);
-      }
-      // return
-      else if(strncmp(token.mStart, "return", 6u) == 0)
-      {
-         tokenIndex++;
-         statement = parseStatementReturn(pContext);
-      }
-      // using
-      else if(strncmp(token.mStart, "using", 5u) == 0)
-      {
-         tokenIndex++;
-         statement = parseStatementUsingDirective(pContext);
-      }
-      // struct
-      else if(strncmp(token.mStart, "struct", 6u) == 0)
-      {
-         tokenIndex++;
-         statement = parseStatementStructDeclaration(pContext);
-      }
-      // namespace
-      else if(strncmp(token.mStart, "namespace", 9u) == 0)
-      {
-         tokenIndex++;
-         statement = parseStatementNamespaceDeclaration(pContext);
-      }
-      // typedef
-      else if(strncmp(token.mStart, "typedef", 7u) == 0)
-      {
-         tokenIndex++;
-         statement = parseStatementTypeDefinition(pContext);
-      }
-      // (unexpected)
-      else
-      {
-         throwCompileErrorUnexpectedSymbol(pContext);
-      }
+      pOutValue->assign(&pDecimal);
    }
    else
    {
-      // static?
-      bool staticDeclaration = false;
+      CflatAssert(false); // Unsupported
+   }
+}
 
-      if(token.mLength == 6u && strncmp(token.mStart, "static", 6u) == 0)
-      {
-         staticDeclaration = true;
-         tokenIndex++;
-      }
+void Environment::getTypeFullName(Type* pType, CflatSTLString* pOutString)
+{
+   if(pType->mNamespace->getFullIdentifier().mHash != 0u)
+   {
+      pOutString->append(pType->mNamespace->getFullIdentifier().mName);
+      pOutString->append("::");
+   }
 
-      // type
-      TypeUsage typeUsage = parseTypeUsage(pContext, 0u);
+   pOutString->append(pType->mIdentifier.mName);
 
-      if(typeUsage.mType)
+   if(pType->mCategory == TypeCategory::StructOrClass)
+   {
+      Struct* structOrClassType = static_cast<Struct*>(pType);
+      
+      if(!structOrClassType->mTemplateTypes.empty())
       {
-         const Token& identifierToken = tokens[tokenIndex];
-         pContext.mStringBuffer.assign(identifierToken.mStart, identifierToken.mLength);
-         const Identifier identifier(pContext.mStringBuffer.c_str());
-         tokenIndex++;
+         pOutString->append("<");
+
+         for(size_t i = 0u; i < structOrClassType->mTemplateTypes.size(); i++)
+         {
+            if(i > 0u)
+            {
+               pOutString->append(", ");
+            }
+
+            getTypeFullName(structOrClassType->mTemplateTypes[i].mType, pOutString);
+         }
+
+         pOutString->append(">");
+      }
+   }
+}
+
+bool Environment::doAllExecutionPathsReturn(Statement* pStatement)
+{
+   if(pStatement->getType() == StatementType::Return)
+   {
+      return true;
+   }
 
-         if(tokens[tokenIndex].mType != TokenType::Operator &&
-            tokens[tokenIndex].mType != TokenType::Punctuation)
-         {
-            pContext.mStringBuffer.assign(token.mStart, token.mLength);
-            throwCompileError(pContext, CompileError::UnexpectedSymbol, pContext.mStringBuffer.c_str());
-            return nullptr;
-         }
+   if(pStatement->getType() == StatementType::Block)
+   {
+      StatementBlock* blockStatement = static_cast<StatementBlock*>(pStatement);
 
-         if (!pContext.mStringBuffer.empty() && !Tokenizer::isValidIdentifierBeginningCharacter(*pContext.mStringBuffer.c_str()))
+      for(int i = (int)blockStatement->mStatements.size() - 1; i >= 0; i--)
+      {
+         if(doAllExecutionPathsReturn(blockStatement->mStatements[i]))
          {
-            throwCompileError(pContext, CompileError::UnexpectedSymbol, pContext.mStringBuffer.c_str());
-            return nullptr;
+            return true;
          }
+      }
+   }
 
-         bool isFunctionDeclaration = tokens[tokenIndex].mStart[0] == '(';
-
-         if(isFunctionDeclaration)
-         {
-             size_t savedTokenIndex = tokenIndex;
-             // Check if the next token after the opening parenthesis is either a
-             // typeusage or a closing parenthesis. This would be indicating that
-             // we're dealing with a function declaration and not a variable
-             // declaration.
-             tokenIndex++;
+   if(pStatement->getType() == StatementType::If)
+   {
+      StatementIf* ifStatement = static_cast<StatementIf*>(pStatement);
 
-             if ((savedTokenIndex + 1u) < tokens.size() &&
-                 tokens[savedTokenIndex + 1].mStart[0] != ')')
-             {
-                 // The next token after the opening parenthesis is not a  closing parenthesis
+      return
+         ifStatement->mElseStatement &&
+         doAllExecutionPathsReturn(ifStatement->mIfStatement) &&
+         doAllExecutionPathsReturn(ifStatement->mElseStatement);
+   }
 
-                 // Checks if the next token after the opening parenthesis is a type description which
-                 // would indicate that it is a function declaration
-                 TypeUsage parameterTypeUsage = parseTypeUsage(pContext, 0u);
-                 if (!parameterTypeUsage.mType)
-                 {
-                     // Would indicate object construction/variable declaration
-                     isFunctionDeclaration = false;
-                 }
-             }
+   if(pStatement->getType() == StatementType::Switch)
+   {
+      StatementSwitch* switchStatement = static_cast<StatementSwitch*>(pStatement);
+      
+      const bool containsDefaultSection =
+         switchStatement->mCaseSections.back().mExpression == nullptr;
 
-             tokenIndex = savedTokenIndex;
-         }
+      if(containsDefaultSection)
+      {
+         bool allExecutionPathsInSwitchReturn = true;
 
-         // function declaration
-         if(isFunctionDeclaration)
-         {
-            tokenIndex--;
-            statement = parseStatementFunctionDeclaration(pContext, typeUsage, staticDeclaration);
-         }
-         // variable / const declaration
-         else
+         for(size_t i = 0u; i < switchStatement->mCaseSections.size(); i++)
          {
-            if(typeUsage.mType != mTypeVoid || typeUsage.mPointerLevel > 0u)
+            const StatementSwitch::CaseSection& caseSection = switchStatement->mCaseSections[i];
+            bool allExecutionPathsInCaseSectionReturn = false;
+
+            for(int j = (int)caseSection.mStatements.size() - 1; j >= 0; j--)
             {
-               statement =
-                  parseStatementVariableDeclaration(pContext, typeUsage, identifier, staticDeclaration);
+               if(doAllExecutionPathsReturn(caseSection.mStatements[j]))
+               {
+                  allExecutionPathsInCaseSectionReturn = true;
+                  break;
+               }
             }
-            else
+
+            if(!allExecutionPathsInCaseSectionReturn)
             {
-               throwCompileError(pContext, Environment::CompileError::InvalidType, "void");
+               allExecutionPathsInSwitchReturn = false;
+               break;
             }
          }
+
+         return allExecutionPathsInSwitchReturn;
       }
-      // expression
-      else
-      {
-         const size_t closureTokenIndex = findClosureTokenIndex(pContext, 0, ';');
+   }
 
-         if(closureTokenIndex == 0u)
-         {
-            throwCompileError(pContext, CompileError::Expected, ";");
-            return nullptr;
-         }
+   return false;
+}
 
-         Expression* expression = parseExpression(pContext, closureTokenIndex - 1u);
-         tokenIndex = closureTokenIndex;
+void Environment::initArgumentsForFunctionCall(Function* pFunction, CflatArgsVector(Value)& pArgs)
+{
+   ExecutionContext& context = getCurrentExecutionContext();
 
-         statement = (StatementExpression*)CflatMalloc(sizeof(StatementExpression));
-         CflatInvokeCtor(StatementExpression, statement)(expression);
-      }
-   }
+   pArgs.resize(pFunction->mParameters.size());
 
-   if(statement)
+   for(size_t i = 0u; i < pFunction->mParameters.size(); i++)
    {
-      statement->mProgram = pContext.mProgram;
-      statement->mLine = statementLine;
-   }
+      const TypeUsage& typeUsage = pFunction->mParameters[i];
 
-   return statement;
+      if(typeUsage.isReference())
+      {
+         pArgs[i].initExternal(typeUsage);
+      }
+      else
+      {
+         pArgs[i].initOnStack(typeUsage, &context.mStack);
+      }
+   }
 }
 
-StatementBlock* Environment::parseStatementBlock(ParsingContext& pContext,
-   bool pAlterScope, bool pAllowInGlobalScope)
+void Environment::executeConstructionPlan(ExecutionContext& pContext, const Value& pValue, Struct* pType)
 {
-   if(!pAllowInGlobalScope && pContext.mScopeLevel == 0u)
+   const CflatSTLVector(Struct::ConstructionStep)& constructionPlan = pType->getConstructionPlan();
+
+   if(constructionPlan.empty())
    {
-      throwCompileErrorUnexpectedSymbol(pContext);
-      return nullptr;
+      return;
    }
 
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t& tokenIndex = pContext.mTokenIndex;
-   const Token& token = tokens[tokenIndex];
+   Value thisPtr;
+   thisPtr.mValueInitializationHint = ValueInitializationHint::Stack;
+   getAddressOfValue(pContext, pValue, &thisPtr);
 
-   if(token.mStart[0] != '{')
+   const char* instanceAddress = CflatValueAs(&thisPtr, char*);
+   CflatArgsVector(Value) args;
+
+   for(size_t i = 0u; i < constructionPlan.size(); i++)
    {
-      throwCompileError(pContext, CompileError::Expected, "{");
-      return nullptr;
-   }
+      const Struct::ConstructionStep& step = constructionPlan[i];
 
-   StatementBlock* block = (StatementBlock*)CflatMalloc(sizeof(StatementBlock));
-   CflatInvokeCtor(StatementBlock, block)(pAlterScope);
+      const char* offsetThisPtr = instanceAddress + step.mOffset;
+      memcpy(thisPtr.mValueBuffer, &offsetThisPtr, sizeof(char*));
 
-   const size_t closureTokenIndex = findClosureTokenIndex(pContext, '{', '}');
+      step.mType->getDefaultConstructor()->execute(thisPtr, args, nullptr);
+   }
+}
 
-   if(closureTokenIndex > 0u)
+void Environment::execute(ExecutionContext& pContext, Statement* pStatement)
+{
+   if(!pContext.mErrorMessage.empty())
+      return;
+
+   if(pContext.mResumableCall)
    {
-      incrementBlockLevel(pContext);
+      consumeExecutionBudget(pContext);
 
-      if(pAlterScope)
-      {
-         incrementScopeLevel(pContext);
-         incrementScopeLevel(mExecutionContext);
-      }
+      if(!pContext.mErrorMessage.empty())
+         return;
+   }
 
-      while(tokenIndex < closureTokenIndex)
-      {
-         tokenIndex++;
-         Statement* statement = parseStatement(pContext);
+   CflatCountExecution(pContext, mStatementsCount);
 
-         if(!mErrorMessage.empty())
-         {
-            break;
-         }
+   pContext.mProgram = pStatement->mProgram;
 
-         if(statement)
-         {
-            block->mStatements.push_back(statement);
-         }
-      }
+   pContext.mCallStack.back().mProgram = pStatement->mProgram;
+   pContext.mCallStack.back().mLine = pStatement->mLine;
 
-      if(pAlterScope)
-      {
-         decrementScopeLevel(mExecutionContext);
-         decrementScopeLevel(pContext);
-      }
+   if(mExecutionHook)
+   {
+      mExecutionHook(this, pContext.mCallStack);
+   }
 
-      decrementBlockLevel(pContext);
+   // blocks are not accounted on their own, only their statements
+   if(mLineCountingEnabled &&
+      pStatement->getType() != StatementType::Block &&
+      pStatement->mProgram->mLineCounters)
+   {
+      executeCountingLine(pContext, pStatement);
    }
    else
    {
-      throwCompileError(pContext, CompileError::Expected, "}");
+      executeStatement(pContext, pStatement);
    }
+}
 
-   if(mErrorMessage.empty())
+// Accounts the execution of a statement in the line counters of its program, with the time
+// spent on the statements nested in it (including the called functions) excluded
+void Environment::executeCountingLine(ExecutionContext& pContext, Statement* pStatement)
+{
    {
-      block->mProgram = pContext.mProgram;
-      block->mLine = token.mLine;
+      AllocationReasonScope reasonScope(AllocationReason::ExecutionState);
+      pContext.mNestedStatementsTimes.push_back(0u);
    }
-   else
+
+   const uint64_t startTime = getProfilerTime();
+
+   executeStatement(pContext, pStatement);
+
+   const uint64_t elapsedTime = getProfilerTime() - startTime;
+   const uint64_t nestedStatementsTime = pContext.mNestedStatementsTimes.back();
+   pContext.mNestedStatementsTimes.pop_back();
+
+   if(!pContext.mNestedStatementsTimes.empty())
    {
-      CflatInvokeDtor(StatementBlock, block);
-      CflatFree(block);
-      block = nullptr;
+      pContext.mNestedStatementsTimes.back() += elapsedTime;
    }
 
-   return block;
+   const Program* program = pStatement->mProgram;
+
+   if(pStatement->mLine < program->mLineCountersCount)
+   {
+      LineCounter& lineCounter = program->mLineCounters[pStatement->mLine];
+      lineCounter.mExecutionsCount.fetch_add(1u, std::memory_order_relaxed);
+      lineCounter.mTime.fetch_add(elapsedTime - nestedStatementsTime, std::memory_order_relaxed);
+   }
 }
 
-StatementUsingDirective* Environment::parseStatementUsingDirective(ParsingContext& pContext)
+void Environment::executeStatement(ExecutionContext& pContext, Statement* pStatement)
 {
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t& tokenIndex = pContext.mTokenIndex;
-   const Token& token = tokens[tokenIndex];
-
-   StatementUsingDirective* statement = nullptr;
-   const size_t closureTokenIndex = findClosureTokenIndex(pContext, 0, ';');
-
-   if(closureTokenIndex > 0u)
+   switch(pStatement->getType())
    {
-      if(strncmp(token.mStart, "namespace", 9u) == 0)
+   case StatementType::Expression:
       {
-         tokenIndex++;
-         Token& namespaceToken = const_cast<Token&>(pContext.mTokens[tokenIndex]);
-         pContext.mStringBuffer.clear();
+         StatementExpression* statement = static_cast<StatementExpression*>(pStatement);
 
-         do
+         Value unusedValue;
+         unusedValue.mValueInitializationHint = ValueInitializationHint::Stack;
+         evaluateExpression(pContext, statement->mExpression, &unusedValue);
+      }
+      break;
+   case StatementType::Block:
+      {
+         StatementBlock* statement = static_cast<StatementBlock*>(pStatement);
+
+         incrementBlockLevel(pContext);
+
+         if(statement->mAlterScope)
          {
-            pContext.mStringBuffer.append(namespaceToken.mStart, namespaceToken.mLength);
-            tokenIndex++;
-            namespaceToken = tokens[tokenIndex];
+            incrementScopeLevel(pContext);
          }
-         while(*namespaceToken.mStart != ';');
 
-         const Identifier identifier(pContext.mStringBuffer.c_str());
-         Namespace* ns = nullptr;
-
-         for(int i = (int)pContext.mNamespaceStack.size() - 1; i >= 0; i--)
+         for(size_t i = 0u; i < statement->mStatements.size(); i++)
          {
-            ns = pContext.mNamespaceStack[i]->getNamespace(identifier);
+            execute(pContext, statement->mStatements[i]);
 
-            if(ns)
+            if(pContext.mJumpStatement != JumpStatement::None)
             {
                break;
             }
          }
 
-         if(ns)
+         if(statement->mAlterScope)
+         {
+            decrementScopeLevel(pContext);
+         }
+
+         decrementBlockLevel(pContext);
+      }
+      break;
+   case StatementType::UsingDirective:
+      {
+         StatementUsingDirective* statement =
+            static_cast<StatementUsingDirective*>(pStatement);
+
+         if(statement->mNamespace)
          {
-            UsingDirective usingDirective(ns);
+            UsingDirective usingDirective(statement->mNamespace);
             usingDirective.mBlockLevel = pContext.mBlockLevel;
-            pContext.mUsingDirectives.push_back(usingDirective);
 
-            statement = (StatementUsingDirective*)CflatMalloc(sizeof(StatementUsingDirective));
-            CflatInvokeCtor(StatementUsingDirective, statement)(ns);
+            AllocationReasonScope reasonScope(AllocationReason::ExecutionState);
+            pContext.mUsingDirectives.push_back(usingDirective);
          }
          else
          {
-            throwCompileError(pContext, CompileError::UnknownNamespace, identifier.mName);
+            registerTypeAlias(pContext, statement->mAliasIdentifier, statement->mAliasTypeUsage);
          }
       }
-      else if(tokenIndex < closureTokenIndex && tokens[tokenIndex].mType == TokenType::Identifier)
+      break;
+   case StatementType::TypeDefinition:
       {
-         const size_t equalTokenIndex = findClosureTokenIndex(pContext, 0, '=', closureTokenIndex);
+         StatementTypeDefinition* statement =
+            static_cast<StatementTypeDefinition*>(pStatement);
 
-         if(equalTokenIndex > 0u)
-         {
-            pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
-            const Identifier alias(pContext.mStringBuffer.c_str());
-            tokenIndex++;
+         TypeAlias typeAlias(statement->mAlias, statement->mReferencedTypeUsage);
+         typeAlias.mScopeLevel = pContext.mScopeLevel;
+         pContext.mTypeAliases.push_back(typeAlias);
+      }
+      break;
+   case StatementType::NamespaceDeclaration:
+      {
+         StatementNamespaceDeclaration* statement =
+            static_cast<StatementNamespaceDeclaration*>(pStatement);
+         Namespace* ns =
+            pContext.mNamespaceStack.back()->requestNamespace(statement->mNamespaceIdentifier);
 
-            if(tokenIndex == equalTokenIndex)
-            {
-               tokenIndex++;
+         pContext.mNamespaceStack.push_back(ns);
+         execute(pContext, statement->mBody);
+         pContext.mNamespaceStack.pop_back();
+      }
+      break;
+   case StatementType::VariableDeclaration:
+      {
+         StatementVariableDeclaration* statement = static_cast<StatementVariableDeclaration*>(pStatement);
 
-               const TypeUsage typeUsage = parseTypeUsage(pContext, closureTokenIndex - 1u);
+         const bool isLocalStaticVariable = statement->mStatic && pContext.mScopeLevel > 0u;
 
-               if(typeUsage.mType && tokenIndex == closureTokenIndex)
-               {
-                  registerTypeAlias(pContext, alias, typeUsage);
+         Value* value;
+         bool valueUninitialized = true;
 
-                  statement = (StatementUsingDirective*)CflatMalloc(sizeof(StatementUsingDirective));
-                  CflatInvokeCtor(StatementUsingDirective, statement)(alias, typeUsage);
+         std::unique_lock<std::recursive_mutex> localStaticsLock(mLocalStaticsMutex, std::defer_lock);
+
+         if(isLocalStaticVariable)
+         {
+            // the lock is only taken until the static has been initialized
+            if(statement->mStaticInitialized.load(std::memory_order_acquire))
+            {
+               valueUninitialized = false;
+            }
+            else
+            {
+               localStaticsLock.lock();
+
+               // already linked if initialized meanwhile, or being initialized further up the
+               // call stack of this thread
+               if(statement->mStaticListHead)
+               {
+                  valueUninitialized = false;
                }
                else
                {
-                  throwCompileErrorUnexpectedSymbol(pContext);
+                  if(statement->mTypeUsage.isReference())
+                  {
+                     statement->mStaticValue.initExternal(statement->mTypeUsage);
+                  }
+                  else
+                  {
+                     statement->mStaticValue.initOnHeap(statement->mTypeUsage);
+                  }
+
+                  statement->linkStatic(&mLocalStatics);
                }
             }
-            else
-            {
-               throwCompileErrorUnexpectedSymbol(pContext);
-            }
+
+            // no local instance gets registered, since the accesses to the variable are bound
+            // to the storage owned by the statement when parsing
+            value = &statement->mStaticValue;
          }
          else
          {
-            const TypeUsage typeUsage = parseTypeUsage(pContext, closureTokenIndex - 1u);
+            Instance* instance =
+               registerInstance(pContext, statement->mTypeUsage, statement->mVariableIdentifier);
+            value = &instance->mValue;
+         }
 
-            if(typeUsage.mType && tokenIndex == closureTokenIndex && typeUsage.mFlags == 0u)
-            {
-               const Identifier& alias = typeUsage.mType->mIdentifier;
-               registerTypeAlias(pContext, alias, typeUsage);
+         if(valueUninitialized)
+         {
+            const TypeUsage& typeUsage = statement->mTypeUsage;
+            const bool isStructOrClassInstance =
+               typeUsage.mType &&
+               typeUsage.mType->mCategory == TypeCategory::StructOrClass &&
+               !typeUsage.isPointer() &&
+               !typeUsage.isReference();
 
-               statement = (StatementUsingDirective*)CflatMalloc(sizeof(StatementUsingDirective));
-               CflatInvokeCtor(StatementUsingDirective, statement)(alias, typeUsage);
-            }
-            else
+            if(isStructOrClassInstance)
             {
-               throwCompileErrorUnexpectedSymbol(pContext);
+               executeConstructionPlan(pContext, *value, static_cast<Struct*>(typeUsage.mType));
             }
-         }
-      }
-      else
-      {
-         throwCompileError(pContext, CompileError::UnexpectedSymbol, "using");
-      }
 
-      tokenIndex = closureTokenIndex;
-   }
-   else
-   {
-      throwCompileError(pContext, CompileError::Expected, ";");
-   }
+            if(statement->mInitialValue)
+            {
+               // Special case: reference from dereferenced pointer
+               if(statement->mTypeUsage.isReference() &&
+                  !statement->mTypeUsage.isConst() &&
+                  statement->mInitialValue->getType() == ExpressionType::UnaryOperation &&
+                  static_cast<ExpressionUnaryOperation*>(statement->mInitialValue)->mOperator[0] == '*')
+               {
+                  Expression* deferencedExpression =
+                     static_cast<ExpressionUnaryOperation*>(statement->mInitialValue)->mExpression;
+                  CflatAssert(deferencedExpression->getTypeUsage().isPointer());
 
-   return statement;
-}
+                  Value initialValueAddress;
+                  initialValueAddress.mTypeUsage = deferencedExpression->getTypeUsage();
+                  initialValueAddress.mValueInitializationHint = ValueInitializationHint::Stack;
+                  evaluateExpression(pContext, deferencedExpression, &initialValueAddress);
 
-StatementTypeDefinition* Environment::parseStatementTypeDefinition(ParsingContext& pContext)
-{
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t& tokenIndex = pContext.mTokenIndex;
+                  CflatAssert(value->mValueBufferType == ValueBufferType::External);
+                  value->mValueBuffer = CflatValueAs(&initialValueAddress, char*);
+               }
+               // Regular case
+               else
+               {
+                  Value initialValue;
+                  initialValue.mTypeUsage = typeUsage;
+                  initialValue.mValueInitializationHint = ValueInitializationHint::Stack;
+                  evaluateExpression(pContext, statement->mInitialValue, &initialValue);
 
-   StatementTypeDefinition* statement = nullptr;
-   const size_t closureTokenIndex = findClosureTokenIndex(pContext, 0, ';');
+                  const bool initialValueIsArray = initialValue.mTypeUsage.isArray();
+                  initialValue.mTypeUsage.mFlags = typeUsage.mFlags;
 
-   if(closureTokenIndex > 0u)
-   {
-      const TypeUsage typeUsage = parseTypeUsage(pContext, closureTokenIndex - 1u);
+                  if(initialValueIsArray)
+                  {
+                     CflatSetFlag(initialValue.mTypeUsage.mFlags, TypeUsageFlags::Array);
+                  }
 
-      if(typeUsage.mType)
-      {
-         if(tokenIndex == (closureTokenIndex - 1u) && tokens[tokenIndex].mType == TokenType::Identifier)
-         {
-            pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
-            const Identifier alias(pContext.mStringBuffer.c_str());
-            registerTypeAlias(pContext, alias, typeUsage);
+                  assignValue(pContext, initialValue, value, !isLocalStaticVariable);
+               }
+            }
 
-            statement = (StatementTypeDefinition*)CflatMalloc(sizeof(StatementTypeDefinition));
-            CflatInvokeCtor(StatementTypeDefinition, statement)(alias, typeUsage);
-         }
-         else
-         {
-            throwCompileErrorUnexpectedSymbol(pContext);
+            if(isLocalStaticVariable)
+            {
+               statement->mStaticInitialized.store(true, std::memory_order_release);
+            }
          }
       }
-      else
+      break;
+   case StatementType::FunctionDeclaration:
       {
-         pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
-         throwCompileError(pContext, CompileError::UndefinedType, pContext.mStringBuffer.c_str());
-      }
-
-      tokenIndex = closureTokenIndex;
-   }
-   else
-   {
-      throwCompileError(pContext, CompileError::Expected, ";");
-   }
-
-   return statement;
-}
+         StatementFunctionDeclaration* statement = static_cast<StatementFunctionDeclaration*>(pStatement);
 
-StatementNamespaceDeclaration* Environment::parseStatementNamespaceDeclaration(ParsingContext& pContext)
-{
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t& tokenIndex = pContext.mTokenIndex;
-   const Token& token = tokens[tokenIndex];
+         CflatArgsVector(TypeUsage) parameterTypes;
+         toArgsVector(statement->mParameterTypes, parameterTypes);
 
-   StatementNamespaceDeclaration* statement = nullptr;
+         Namespace* functionNS = pContext.mNamespaceStack.back();
+         Function* function = functionNS->getFunction(statement->mFunctionIdentifier, parameterTypes);
+         CflatAssert(function);
 
-   if(token.mType == TokenType::Identifier)
-   {
-      pContext.mStringBuffer.assign(token.mStart, token.mLength);
-      const Identifier nsIdentifier(pContext.mStringBuffer.c_str());
+         function->mProgram = statement->mProgram;
+         function->mLine = statement->mLine;
 
-      Namespace* ns = pContext.mNamespaceStack.back()->requestNamespace(nsIdentifier);
-      pContext.mNamespaceStack.push_back(ns);
-      mExecutionContext.mNamespaceStack.push_back(ns);
+         statement->mFunction = function;
 
-      statement = (StatementNamespaceDeclaration*)CflatMalloc(sizeof(StatementNamespaceDeclaration));
-      CflatInvokeCtor(StatementNamespaceDeclaration, statement)(nsIdentifier);
+         if(statement->mBody || statement->mDeferredBody)
+         {
+            function->mUsingDirectives = pContext.mUsingDirectives;
 
-      tokenIndex++;
-      statement->mBody = parseStatementBlock(pContext, false, true);
+            // the previous body might still be getting executed, e.g. by a suspended call
+            if(function->execute)
+            {
+               FunctionBody* body = (FunctionBody*)CflatMalloc(sizeof(FunctionBody));
+               CflatInvokeCtor(FunctionBody, body)();
+               body->swap(function->execute);
+               mRetiredFunctionBodies.push_back(body);
+            }
 
-      mExecutionContext.mNamespaceStack.pop_back();
-      pContext.mNamespaceStack.pop_back();
-   }
-   else
-   {
-      throwCompileError(pContext, CompileError::UnexpectedSymbol, "namespace");
-   }
+            function->execute =
+               [this, function, functionNS, statement]
+               (const CflatArgsVector(Value)& pArguments, Value* pOutReturnValue)
+            {
+               CflatAssert(function->mParameters.size() == pArguments.size());
 
-   return statement;
-}
+               AccessScope accessScope(this, AccessType::Execute);
 
-StatementVariableDeclaration* Environment::parseStatementVariableDeclaration(ParsingContext& pContext,
-   TypeUsage& pTypeUsage, const Identifier& pIdentifier, bool pStatic)
-{
-   if(pStatic &&
-      CflatHasFlag(mSettings, Settings::DisallowStaticPointers) &&
-      pTypeUsage.isPointer() &&
-      pTypeUsage != mTypeUsageCString &&
-      pTypeUsage != mTypeUsageWideString)
-   {
-      throwCompileError(pContext, CompileError::StaticPointersNotAllowed);
-      return nullptr;
-   }
+               // the function might be getting called from a parallel worker, which has its
+               // own context
+               ExecutionContext& context = getCurrentExecutionContext();
 
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t& tokenIndex = pContext.mTokenIndex;
-   const Token& token = tokens[tokenIndex];
+               Memory::AllocatorScope allocatorScope(&mAllocator);
+               Memory::CategoryScope categoryScope(Memory::Category::Execution);
 
-   StatementVariableDeclaration* statement = nullptr;
+               CflatCountExecution(context, mScriptCallsCount);
 
-   bool instanceAlreadyRegistered =
-      pContext.mLocalInstancesHolder.retrieveInstance(pIdentifier, pContext.mScopeLevel) != nullptr;
+               context.mErrorMessage.clear();
 
-   if(!instanceAlreadyRegistered)
-   {
-      for(size_t i = 0u; i < pContext.mRegisteredInstances.size(); i++)
-      {
-         if(pContext.mRegisteredInstances[i].mIdentifier == pIdentifier &&
-            pContext.mRegisteredInstances[i].mNamespace == pContext.mNamespaceStack.back() &&
-            pContext.mRegisteredInstances[i].mScopeLevel == pContext.mScopeLevel)
-         {
-            instanceAlreadyRegistered = true;
-            break;
-         }
-      }
-   }
+               if(statement->mBodyDeferred && !parseCalledFunctionBody(context, statement))
+               {
+                  context.mErrorMessage.assign(statement->mDeferredBody->mErrorMessage);
+                  return;
+               }
 
-   if(!instanceAlreadyRegistered)
-   {
-      Expression* initialValueExpression = nullptr;
+               const bool mustReturnValue = function->mReturnTypeUsage != mTypeUsageVoid;
+               
+               if(mustReturnValue)
+               {
+                  if(pOutReturnValue)
+                  {
+                     assertValueInitialization(context, function->mReturnTypeUsage, pOutReturnValue);
+                  }
 
-      // array
-      if(token.mStart[0] == '[')
-      {
-         uint16_t arraySize = 0u;
+                  context.mReturnValues.push_back(pOutReturnValue);
+               }
 
-         const size_t arrayClosure = findClosureTokenIndex(pContext, '[', ']');
-         const bool arraySizeSpecified = arrayClosure > (tokenIndex + 1u);
+               {
+                  AllocationReasonScope reasonScope(AllocationReason::ExecutionState);
 
-         if(arraySizeSpecified)
-         {
-            tokenIndex++;
-            Expression* arraySizeExpression = parseExpression(pContext, arrayClosure - 1u);
-            CflatAssert(arraySizeExpression);
+                  context.mNamespaceStack.push_back(functionNS);
 
-            Value arraySizeValue;
-            arraySizeValue.initOnStack(mTypeUsageSizeT, &mExecutionContext.mStack);
-            evaluateExpression(mExecutionContext, arraySizeExpression, &arraySizeValue);
+                  for(size_t i = 0u; i < pArguments.size(); i++)
+                  {
+                     const TypeUsage parameterType = statement->mParameterTypes[i];
+                     const Identifier& parameterIdentifier = statement->mParameterIdentifiers[i];
 
-            arraySize = (uint16_t)CflatValueAs(&arraySizeValue, size_t);
+                     context.mScopeLevel++;
+                     Instance* argumentInstance =
+                        registerInstance(context, parameterType, parameterIdentifier);
+                     context.mScopeLevel--;
 
-            CflatInvokeDtor(Expression, arraySizeExpression);
-            CflatFree(arraySizeExpression);
-         }
+                     assignValue(context, pArguments[i], &argumentInstance->mValue, true);
+                  }
 
-         tokenIndex = arrayClosure + 1u;
+                  for(size_t i = 0u; i < function->mUsingDirectives.size(); i++)
+                  {
+                     context.mUsingDirectives.push_back(function->mUsingDirectives[i]);
+                     context.mUsingDirectives.back().mBlockLevel = 0u;
+                  }
 
-         if(tokens[tokenIndex].mStart[0] == '=')
-         {
-            tokenIndex++;
+                  context.mCallStack.emplace_back(statement->mProgram, function);
+               }
 
-            const size_t closureTokenIndex = findClosureTokenIndex(pContext, 0, ';');
+               execute(context, statement->mBody);
 
-            if(closureTokenIndex > 0u)
-            {
-               initialValueExpression = parseExpression(pContext, closureTokenIndex - 1u);
+               context.mCallStack.pop_back();
 
-               if(!initialValueExpression ||
-                  initialValueExpression->getType() != ExpressionType::ArrayInitialization)
+               for(size_t i = 0u; i < function->mUsingDirectives.size(); i++)
                {
-                  throwCompileError(pContext, CompileError::ArrayInitializationExpected);
-                  return nullptr;
+                  context.mUsingDirectives.pop_back();
                }
 
-               ExpressionArrayInitialization* arrayInitialization =
-                  static_cast<ExpressionArrayInitialization*>(initialValueExpression);
+               if(mExecutionHook && context.mCallStack.empty())
+               {
+                  mExecutionHook(this, context.mCallStack);
+               }
 
-               if(!arraySizeSpecified)
+               context.mNamespaceStack.pop_back();
+
+               if(mustReturnValue)
                {
-                  arraySize = (uint16_t)arrayInitialization->mValues.size();
+                  context.mReturnValues.pop_back();
                }
 
-               tokenIndex = closureTokenIndex;
-            }
-            else
-            {
-               throwCompileError(pContext, CompileError::Expected, ";");
-               return nullptr;
-            }
-         }
-         else if(!arraySizeSpecified)
-         {
-            throwCompileError(pContext, CompileError::ArrayInitializationExpected);
-            return nullptr;
+               context.mJumpStatement = JumpStatement::None;
+            };
          }
-
-         CflatAssert(arraySize > 0u);
-         CflatSetFlag(pTypeUsage.mFlags, TypeUsageFlags::Array);
-         pTypeUsage.mArraySize = arraySize;
       }
-      // variable/object
-      else if(token.mStart[0] == '=')
+      break;
+   case StatementType::If:
       {
-         tokenIndex++;
+         StatementIf* statement = static_cast<StatementIf*>(pStatement);
 
-         const size_t closureTokenIndex = findClosureTokenIndex(pContext, 0, ';');
+         Value conditionValue;
+         conditionValue.mValueInitializationHint = ValueInitializationHint::Stack;
+         evaluateExpression(pContext, statement->mCondition, &conditionValue);
 
-         if(closureTokenIndex > 0u)
+         if(getValueAsInteger(conditionValue))
          {
-            initialValueExpression = parseExpression(pContext, closureTokenIndex - 1u);
+            execute(pContext, statement->mIfStatement);
+         }
+         else if(statement->mElseStatement)
+         {
+            execute(pContext, statement->mElseStatement);
+         }
+      }
+      break;
+   case StatementType::Switch:
+      {
+         StatementSwitch* statement = static_cast<StatementSwitch*>(pStatement);
 
-            if(pTypeUsage.mType == mTypeAuto)
-            {
-               const TypeUsage& initialValueTypeUsage = getTypeUsage(initialValueExpression);
+         Value conditionValue;
+         conditionValue.mValueInitializationHint = ValueInitializationHint::Stack;
+         evaluateExpression(pContext, statement->mCondition, &conditionValue);
 
-               const bool autoConst = pTypeUsage.isConst();
-               const bool autoReference = pTypeUsage.isReference();
+         const int64_t conditionValueAsInteger = getValueAsInteger(conditionValue);
+         bool statementExecution = false;
 
-               pTypeUsage = initialValueTypeUsage;
+         for(size_t i = 0u; i < statement->mCaseSections.size(); i++)
+         {
+            const StatementSwitch::CaseSection& caseSection = statement->mCaseSections[i];
 
-               if(autoConst)
-               {
-                  CflatSetFlag(pTypeUsage.mFlags, TypeUsageFlags::Const);
-               }
-               else
+            if(!statementExecution)
+            {
+               // case
+               if(caseSection.mExpression)
                {
-                  bool resetConstFlag = true;
+                  Value caseValue;
+                  caseValue.mValueInitializationHint = ValueInitializationHint::Stack;
+                  evaluateExpression(pContext, caseSection.mExpression, &caseValue);
 
-                  // Exception #1: keep 'const' if the initial value is the result of a function call
-                  // whose return type is a const ref, and the variable has been declared as auto&
-                  if(autoReference &&
-                     initialValueTypeUsage.isConst() && initialValueTypeUsage.isReference())
-                  {
-                     resetConstFlag = false;
-                  }
-                  // Exception #2: keep 'const' for C-strings
-                  else if(initialValueTypeUsage == mTypeUsageCString ||
-                     initialValueTypeUsage == mTypeUsageWideString)
-                  {
-                     resetConstFlag = false;
-                  }
+                  const int64_t caseValueAsInteger = getValueAsInteger(caseValue);
 
-                  if(resetConstFlag)
+                  if(caseValueAsInteger == conditionValueAsInteger)
                   {
-                     CflatResetFlag(pTypeUsage.mFlags, TypeUsageFlags::Const);
+                     statementExecution = true;
                   }
                }
-
-               if(autoReference)
-               {
-                  CflatSetFlag(pTypeUsage.mFlags, TypeUsageFlags::Reference);
-               }
+               // default
                else
                {
-                  CflatResetFlag(pTypeUsage.mFlags, TypeUsageFlags::Reference);
+                  statementExecution = true;
                }
             }
-            // Assigning something to a const ref
-            else if (initialValueExpression && pTypeUsage.isConst() && pTypeUsage.isReference())
-            {
-               const bool isFunctionCall =
-                  initialValueExpression->getType() == ExpressionType::FunctionCall ||
-                  initialValueExpression->getType() == ExpressionType::MethodCall;
 
-               if (isFunctionCall)
+            if(statementExecution)
+            {
+               for(size_t j = 0u; j < caseSection.mStatements.size(); j++)
                {
-                  const TypeUsage& initialValueTypeUsage = getTypeUsage(initialValueExpression);
+                  execute(pContext, caseSection.mStatements[j]);
 
-                  // If a value is being assigned to a const ref, treat it like a const value
-                  if (!initialValueTypeUsage.isReference())
+                  if(pContext.mJumpStatement == JumpStatement::Break)
                   {
-                     CflatResetFlag(pTypeUsage.mFlags, TypeUsageFlags::Reference);
+                     break;
                   }
                }
             }
 
-            tokenIndex = closureTokenIndex;
+            if(pContext.mJumpStatement == JumpStatement::Break)
+            {
+               pContext.mJumpStatement = JumpStatement::None;
+               break;
+            }
          }
-         else
+      }
+      break;
+   case StatementType::While:
+      {
+         StatementWhile* statement = static_cast<StatementWhile*>(pStatement);
+
+         Value conditionValue;
+         conditionValue.mValueInitializationHint = ValueInitializationHint::Stack;
+         evaluateExpression(pContext, statement->mCondition, &conditionValue);
+
+         while(getValueAsInteger(conditionValue))
          {
-            throwCompileError(pContext, CompileError::Expected, ";");
-            return nullptr;
+            execute(pContext, statement->mLoopStatement);
+
+            if(!pContext.mErrorMessage.empty())
+            {
+               break;
+            }
+
+            if(pContext.mJumpStatement == JumpStatement::Continue)
+            {
+               pContext.mJumpStatement = JumpStatement::None;
+            }
+            else if(pContext.mJumpStatement == JumpStatement::Break)
+            {
+               pContext.mJumpStatement = JumpStatement::None;
+               break;
+            }
+
+            evaluateExpression(pContext, statement->mCondition, &conditionValue);
          }
       }
-      // object with construction
-      else if(pTypeUsage.mType &&
-         pTypeUsage.mType->mCategory == TypeCategory::StructOrClass &&
-         !pTypeUsage.isPointer())
+      break;
+   case StatementType::DoWhile:
       {
-         Struct* type = static_cast<Struct*>(pTypeUsage.mType);
+         StatementDoWhile* statement = static_cast<StatementDoWhile*>(pStatement);
 
-         if(token.mStart[0] == '(')
+         Value conditionValue;
+         conditionValue.mValueInitializationHint = ValueInitializationHint::Stack;
+
+         do
          {
-            initialValueExpression = parseExpressionObjectConstruction(pContext, type);
+            execute(pContext, statement->mLoopStatement);
+
+            if(!pContext.mErrorMessage.empty())
+            {
+               break;
+            }
+
+            if(pContext.mJumpStatement == JumpStatement::Continue)
+            {
+               pContext.mJumpStatement = JumpStatement::None;
+            }
+            else if(pContext.mJumpStatement == JumpStatement::Break)
+            {
+               pContext.mJumpStatement = JumpStatement::None;
+               break;
+            }
+
+            evaluateExpression(pContext, statement->mCondition, &conditionValue);
          }
-         else
+         while(getValueAsInteger(conditionValue));
+      }
+      break;
+   case StatementType::For:
+      {
+         StatementFor* statement = static_cast<StatementFor*>(pStatement);
+
+         incrementScopeLevel(pContext);
+
+         if(statement->mInitialization)
          {
-            const Identifier emptyId;
-            Method* anyCtor = type->findMethod(emptyId);
+            execute(pContext, statement->mInitialization);
+         }
+
+         {
+            const bool defaultConditionValue = true;
+
+            Value conditionValue;
+            conditionValue.initOnStack(mTypeUsageBool, &pContext.mStack);
+            conditionValue.set(&defaultConditionValue);
+
+            bool conditionMet = defaultConditionValue;
+
+            if(statement->mCondition)
+            {
+               evaluateExpression(pContext, statement->mCondition, &conditionValue);
+               conditionMet = getValueAsInteger(conditionValue) != 0;
+            }
+
+            while(conditionMet)
+            {
+               execute(pContext, statement->mLoopStatement);
+
+               if(!pContext.mErrorMessage.empty())
+               {
+                  break;
+               }
 
-            if(anyCtor)
-            {
-               Method* defaultCtor = type->getDefaultConstructor();
+               if(pContext.mJumpStatement == JumpStatement::Continue)
+               {
+                  pContext.mJumpStatement = JumpStatement::None;
+               }
+               else if(pContext.mJumpStatement == JumpStatement::Break)
+               {
+                  pContext.mJumpStatement = JumpStatement::None;
+                  break;
+               }
 
-               if(!defaultCtor)
+               if(statement->mIncrement)
                {
-                  CflatSTLString typeFullName;
-                  getTypeFullName(type, &typeFullName);
+                  Value unusedValue;
+                  evaluateExpression(pContext, statement->mIncrement, &unusedValue);
+               }
 
-                  throwCompileError(pContext, CompileError::NoDefaultConstructor,
-                     typeFullName.c_str());
-                  return nullptr;
+               if(statement->mCondition)
+               {
+                  evaluateExpression(pContext, statement->mCondition, &conditionValue);
+                  conditionMet = getValueAsInteger(conditionValue) != 0;
                }
             }
          }
-      }
 
-      if(pTypeUsage.isReference() && !initialValueExpression)
-      {
-         throwCompileError(pContext, CompileError::UninitializedReference, pIdentifier.mName);
-         return nullptr;
+         decrementScopeLevel(pContext);
       }
+      break;
+   case StatementType::ForRangeBased:
+      {
+         StatementForRangeBased* statement = static_cast<StatementForRangeBased*>(pStatement);
 
-      registerInstance(pContext, pTypeUsage, pIdentifier);
-
-      pContext.mRegisteredInstances.emplace_back();
-      ParsingContext::RegisteredInstance& registeredInstance = pContext.mRegisteredInstances.back();
-      registeredInstance.mIdentifier = pIdentifier;
-      registeredInstance.mNamespace = pContext.mNamespaceStack.back();
-      registeredInstance.mScopeLevel = pContext.mScopeLevel;
+         incrementScopeLevel(pContext);
 
-      statement = (StatementVariableDeclaration*)CflatMalloc(sizeof(StatementVariableDeclaration));
-      CflatInvokeCtor(StatementVariableDeclaration, statement)
-         (pTypeUsage, pIdentifier, initialValueExpression, pStatic);
+         {
+            Instance* elementInstance = registerInstance(
+               pContext, statement->mVariableTypeUsage, statement->mVariableIdentifier);
 
-      if(initialValueExpression)
-      {
-         bool validAssignment = false;
+            Value collectionDataValue;
+            collectionDataValue.mValueInitializationHint = ValueInitializationHint::Stack;
+            getInstanceDataValue(pContext, statement->mCollection, &collectionDataValue);
 
-         if(pTypeUsage.isPointer() && initialValueExpression->getType() == ExpressionType::NullPointer)
-         {
-            validAssignment = true;
-         }
-         else
-         {
-            const TypeUsage& initialValueTypeUsage = getTypeUsage(initialValueExpression);
+            Value collectionThisValue;
+            collectionThisValue.mValueInitializationHint = ValueInitializationHint::Stack;
+            getAddressOfValue(pContext, collectionDataValue, &collectionThisValue);
 
-            if(initialValueTypeUsage.mType)
+            if(collectionDataValue.mTypeUsage.isArray())
             {
-               if(initialValueTypeUsage.mType != mTypeVoid || initialValueTypeUsage.isPointer())
+               size_t elementIndex = 0u;
+
+               while(elementIndex < collectionDataValue.mTypeUsage.mArraySize)
                {
-                  if(pTypeUsage.isPointer() && !pTypeUsage.isArray() &&
-                     !initialValueTypeUsage.isPointer() && initialValueTypeUsage.isArray() &&
-                     pTypeUsage.mType == initialValueTypeUsage.mType)
+                  const size_t arrayElementSize = statement->mVariableTypeUsage.getSize();
+                  const char* arrayElementData =
+                     collectionDataValue.mValueBuffer + (arrayElementSize * elementIndex);
+                  elementInstance->mValue.set(arrayElementData);
+
+                  execute(pContext, statement->mLoopStatement);
+
+                  if(pContext.mJumpStatement == JumpStatement::Continue)
                   {
-                     validAssignment = true;
+                     pContext.mJumpStatement = JumpStatement::None;
                   }
-                  else
+                  else if(pContext.mJumpStatement == JumpStatement::Break)
                   {
-                     const TypeHelper::Compatibility compatibility =
-                        TypeHelper::getCompatibility(pTypeUsage, initialValueTypeUsage);
-                     validAssignment = compatibility != TypeHelper::Compatibility::Incompatible;
+                     pContext.mJumpStatement = JumpStatement::None;
+                     break;
                   }
+
+                  elementIndex++;
                }
             }
-         }
-
-         if(validAssignment)
-         {
-            if(pStatic && pTypeUsage.isConst() && pContext.mScopeLevel == 0u)
+            else
             {
-               Instance* execInstance = registerInstance(mExecutionContext, pTypeUsage, pIdentifier);
-
-               Value initialValue;
-               initialValue.mValueInitializationHint = ValueInitializationHint::Stack;
-               evaluateExpression(mExecutionContext, initialValueExpression, &initialValue);
+               Struct* collectionType = static_cast<Struct*>(collectionDataValue.mTypeUsage.mType);
 
-               assignValue(mExecutionContext, initialValue, &execInstance->mValue, true);
-            }
-         }
-         else
-         {
-            throwCompileError(pContext, CompileError::InvalidAssignment);
-         }
-      }
-   }
-   else
-   {
-      throwCompileError(pContext, CompileError::VariableRedefinition, pIdentifier.mName);
-   }
+               Method* collectionBeginMethod =
+                  collectionType->findMethod("begin", TypeUsage::kEmptyList());
+               Value iteratorValue;
+               iteratorValue.initOnStack(collectionBeginMethod->mReturnTypeUsage, &pContext.mStack);
+               collectionBeginMethod->execute(collectionThisValue, Value::kEmptyList(), &iteratorValue);
 
-   return statement;
-}
+               Method* collectionEndMethod =
+                  collectionType->findMethod("end", TypeUsage::kEmptyList());
+               Value collectionEndValue;
+               collectionEndValue.initOnStack(collectionEndMethod->mReturnTypeUsage, &pContext.mStack);
+               collectionEndMethod->execute(collectionThisValue, Value::kEmptyList(), &collectionEndValue);
 
-StatementFunctionDeclaration* Environment::parseStatementFunctionDeclaration(ParsingContext& pContext,
-   const TypeUsage& pReturnType, bool pStatic)
-{
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t& tokenIndex = pContext.mTokenIndex;
-   const Token& token = tokens[tokenIndex];
+               Type* iteratorType = collectionBeginMethod->mReturnTypeUsage.mType;
 
-   pContext.mStringBuffer.assign(token.mStart, token.mLength);
-   const Identifier functionIdentifier(pContext.mStringBuffer.c_str());
-   const size_t functionToken = tokenIndex;
+               Value conditionValue;
+               conditionValue.initOnStack(mTypeUsageBool, &pContext.mStack);
+               applyBinaryOperator(pContext, iteratorValue, collectionEndValue, "!=", &conditionValue);
 
-   if(pReturnType.mType->mCategory == TypeCategory::StructOrClass &&
-      !pReturnType.isPointer() &&
-      !pReturnType.isReference())
-   {
-      Struct* returnType = static_cast<Struct*>(pReturnType.mType);
-      Method* copyConstructor = returnType->getCopyConstructor();
+               while(CflatValueAs(&conditionValue, bool))
+               {
+                  applyUnaryOperator(pContext, iteratorValue, "*", &elementInstance->mValue);
 
-      if(!copyConstructor)
-      {
-         CflatSTLString typeFullName;
-         getTypeFullName(pReturnType.mType, &typeFullName);
+                  execute(pContext, statement->mLoopStatement);
 
-         throwCompileError(pContext, CompileError::NoCopyConstructor, typeFullName.c_str());
-         return nullptr;
-      }
-   }
+                  if(!pContext.mErrorMessage.empty())
+                  {
+                     break;
+                  }
 
-   StatementFunctionDeclaration* statement =
-      (StatementFunctionDeclaration*)CflatMalloc(sizeof(StatementFunctionDeclaration));
-   CflatInvokeCtor(StatementFunctionDeclaration, statement)(pReturnType, functionIdentifier);
+                  if(pContext.mJumpStatement == JumpStatement::Continue)
+                  {
+                     pContext.mJumpStatement = JumpStatement::None;
+                  }
+                  else if(pContext.mJumpStatement == JumpStatement::Break)
+                  {
+                     pContext.mJumpStatement = JumpStatement::None;
+                     break;
+                  }
 
-   tokenIndex++;
+                  applyUnaryOperator(pContext, iteratorValue, "++", &iteratorValue);
+                  applyBinaryOperator(pContext, iteratorValue, collectionEndValue, "!=", &conditionValue);
+               }
+            }
+         }
 
-   while(tokens[tokenIndex++].mStart[0] != ')')
-   {
-      // no arguments
-      if(tokens[tokenIndex].mStart[0] == ')')
-      {
-         tokenIndex++;
-         break;
+         decrementScopeLevel(pContext);
       }
-
-      TypeUsage parameterType = parseTypeUsage(pContext, 0u);
-
-      if(!parameterType.mType)
+      break;
+   case StatementType::Break:
       {
-         pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
-         throwCompileError(pContext, Environment::CompileError::UndefinedType,
-            pContext.mStringBuffer.c_str());
-         return statement;
+         pContext.mJumpStatement = JumpStatement::Break;
       }
-
-      pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
-      Identifier parameterIdentifier(pContext.mStringBuffer.c_str());
-
-      for(size_t i = 0u; i < statement->mParameterIdentifiers.size(); i++)
+      break;
+   case StatementType::Continue:
       {
-         if(parameterIdentifier == statement->mParameterIdentifiers[i])
-         {
-            pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
-            throwCompileError(pContext, Environment::CompileError::ParameterRedefinition,
-               parameterIdentifier.mName);
-            return statement;
-         }
+         pContext.mJumpStatement = JumpStatement::Continue;
       }
-
-      tokenIndex++;
-
-      statement->mParameterTypes.push_back(parameterType);
-      statement->mParameterIdentifiers.push_back(parameterIdentifier);
-
-      pContext.mScopeLevel++;
-      registerInstance(pContext, parameterType, parameterIdentifier);
-      pContext.mScopeLevel--;
-   }
-
-   CflatArgsVector(TypeUsage) parameterTypes;
-   toArgsVector(statement->mParameterTypes, parameterTypes);
-
-   Namespace* ns = pContext.mNamespaceStack.back();
-   Function* function = ns->getFunctionPerfectMatch(statement->mFunctionIdentifier, parameterTypes);
-
-   if(!function)
-   {
-      function = ns->registerFunction(statement->mFunctionIdentifier);
-      function->mProgram = pContext.mProgram;
-      function->mLine = token.mLine;
-
-      for(size_t i = 0u; i < statement->mParameterTypes.size(); i++)
+      break;
+   case StatementType::Return:
       {
-         function->mParameters.push_back(statement->mParameterTypes[i]);
-         function->mParameterIdentifiers.push_back(statement->mParameterIdentifiers[i]);
-      }
-   }
-
-   function->mReturnTypeUsage = statement->mReturnType;
-
-   if(pStatic)
-   {
-      CflatSetFlag(function->mFlags, FunctionFlags::Static);
-   }
-   else
-   {
-      CflatResetFlag(function->mFlags, FunctionFlags::Static);
-   }
-
-   pContext.mCurrentFunction = function;
+         StatementReturn* statement = static_cast<StatementReturn*>(pStatement);
 
-   if(tokens[tokenIndex].mStart[0] != ';')
-   {
-      statement->mBody = parseStatementBlock(pContext, true, true);
-   }
+         if(statement->mExpression)
+         {
+            Value returnValue;
+            returnValue.mValueInitializationHint = ValueInitializationHint::Stack;
+            evaluateExpression(pContext, statement->mExpression, &returnValue);
 
-   pContext.mCurrentFunction = nullptr;
+            assignValue(pContext, returnValue, pContext.mReturnValues.back(), true);
+         }
 
-   if(statement->mBody && pReturnType.mType != mTypeVoid)
-   {
-      if(!doAllExecutionPathsReturn(statement->mBody))
-      {
-         tokenIndex = functionToken;
-         throwCompileError(pContext, CompileError::MissingReturnStatement, functionIdentifier.mName);
+         pContext.mJumpStatement = JumpStatement::Return;
       }
+      break;
+   default:
+      break;
    }
-
-   return statement;
 }
 
-StatementStructDeclaration* Environment::parseStatementStructDeclaration(ParsingContext& pContext)
+void Environment::assignReturnValueFromFunctionCall(const TypeUsage& pReturnTypeUsage,
+   const void* pReturnValue, Value* pOutValue)
 {
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t& tokenIndex = pContext.mTokenIndex;
-   const Token& token = tokens[tokenIndex];
-
-   pContext.mStringBuffer.assign(token.mStart, token.mLength);
-   const Identifier structIdentifier(pContext.mStringBuffer.c_str());
-   tokenIndex++;
+   bool assigned = false;
 
-   if(tokens[tokenIndex].mStart[0] != '{')
+   if(pReturnTypeUsage.mType->mCategory == TypeCategory::StructOrClass &&
+      !pReturnTypeUsage.isReference() &&
+      !pReturnTypeUsage.isPointer())
    {
-      throwCompileError(pContext, CompileError::Expected, "{");
-      return nullptr;
-   }
-
-   const size_t closureTokenIndex = findClosureTokenIndex(pContext, '{', '}');
+      Struct* returnType = static_cast<Struct*>(pReturnTypeUsage.mType);
+      Method* copyCtor = returnType->getCopyConstructor();
 
-   if(closureTokenIndex == 0u)
-   {
-      tokenIndex = tokens.size() - 1u;
-      throwCompileError(pContext, CompileError::Expected, "}");
-      return nullptr;
-   }
+      if(copyCtor)
+      {
+         TypeUsage typeUsageReference;
+         typeUsageReference.mType = returnType;
+         typeUsageReference.mFlags |= (uint8_t)TypeUsageFlags::Reference;
 
-   tokenIndex++;
+         TypeUsage thisPtrTypeUsage;
+         thisPtrTypeUsage.mType = returnType;
+         thisPtrTypeUsage.mPointerLevel = 1u;
 
-   StatementStructDeclaration* statement =
-      (StatementStructDeclaration*)CflatMalloc(sizeof(StatementStructDeclaration));
-   CflatInvokeCtor(StatementStructDeclaration, statement)();
+         Value thisPtrValue;
+         thisPtrValue.initExternal(thisPtrTypeUsage);
+         thisPtrValue.set(&pOutValue->mValueBuffer);
 
-   Namespace* ns = pContext.mNamespaceStack.back();
+         Method* defaultCtor = returnType->getDefaultConstructor();
 
-   if(pContext.mScopeLevel > 0u)
-   {
-      CflatAssert(pContext.mCurrentFunction);
-      ns = ns->requestNamespace(pContext.mCurrentFunction->mIdentifier);
+         if(defaultCtor)
+         {
+            defaultCtor->execute(thisPtrValue, Value::kEmptyList(), nullptr);
+         }
 
-      char buffer[kDefaultLocalStringBufferSize];
-      snprintf(buffer, sizeof(buffer), "__local%u", pContext.mLocalNamespaceGlobalIndex);
-      const Identifier internalNamespaceIdentifier(buffer);
-      ns = ns->requestNamespace(internalNamespaceIdentifier);
+         Value referenceValue;
+         referenceValue.initExternal(typeUsageReference);
+         referenceValue.set(pReturnValue);
 
-      pContext.mLocalNamespaceStack.emplace_back();
-      ParsingContext::LocalNamespace& localNamespace = pContext.mLocalNamespaceStack.back();
-      localNamespace.mNamespace = ns;
-      localNamespace.mScopeLevel = pContext.mScopeLevel;
+         CflatArgsVector(Value) args;
+         args.push_back(referenceValue);
+         copyCtor->execute(thisPtrValue, args, nullptr);
 
-      pContext.mLocalNamespaceGlobalIndex++;
+         assigned = true;
+      }
    }
 
-   Type* existingType = ns->getType(structIdentifier);
-
-   if(existingType)
+   if(!assigned)
    {
-      ns->deregisterType(existingType);
+      pOutValue->set(pReturnValue);
    }
+}
 
-   statement->mStruct = ns->registerType<Struct>(structIdentifier);
-
-   size_t structSize = 0u;
-   size_t structAlignment = 1u;
-
-   do
-   {
-      TypeUsage typeUsage = parseTypeUsage(pContext, closureTokenIndex - 1u);
-
-      if(!typeUsage.mType)
-      {
-         pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
-         throwCompileError(pContext, CompileError::UndefinedType, pContext.mStringBuffer.c_str());
-         break;
-      }
+Namespace* Environment::getGlobalNamespace()
+{
+   return &mGlobalNamespace;
+}
 
-      pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
-      tokenIndex++;
+Namespace* Environment::getNamespace(const Identifier& pIdentifier)
+{
+   AccessScope accessScope(this, AccessType::Read);
+   return mGlobalNamespace.getNamespace(pIdentifier);
+}
 
-      if(tokens[tokenIndex].mStart[0] != ';')
-      {
-         throwCompileError(pContext, CompileError::Expected, ";");
-         break;
-      }
+Namespace* Environment::requestNamespace(const Identifier& pIdentifier)
+{
+   AccessScope accessScope(this, AccessType::Write);
+   Memory::AllocatorScope allocatorScope(&mAllocator);
 
-      const size_t typeUsageSize = typeUsage.getSize();
-      const size_t typeUsageAlignment = TypeHelper::calculateAlignment(typeUsage);
+   // anything might get registered in the namespace afterwards
+   mRegistrationGeneration++;
 
-      if(typeUsageAlignment > structAlignment)
-      {
-         structAlignment = typeUsageAlignment;
-      }
+   return mGlobalNamespace.requestNamespace(pIdentifier);
+}
 
-      const size_t misalignment = structSize % typeUsageAlignment;
+void Environment::registerTypeAlias(const Identifier& pIdentifier, const TypeUsage& pTypeUsage)
+{
+   AccessScope accessScope(this, AccessType::Write);
+   Memory::AllocatorScope allocatorScope(&mAllocator);
 
-      if(misalignment > 0u)
-      {
-         const size_t padding = typeUsageAlignment - misalignment;
-         structSize += padding;
-      }
+   mRegistrationGeneration++;
+   mGlobalNamespace.registerTypeAlias(pIdentifier, pTypeUsage);
+}
 
-      const Identifier memberIdentifier(pContext.mStringBuffer.c_str());
-      Field* member = statement->mStruct->requestField(memberIdentifier);
-      member->mTypeUsage = typeUsage;
-      member->mOffset = (uint16_t)structSize;
+Type* Environment::getType(const Identifier& pIdentifier) const
+{
+   AccessScope accessScope(this, AccessType::Read);
+   return mGlobalNamespace.getType(pIdentifier);
+}
 
-      structSize += typeUsageSize;
-   }
-   while(++tokenIndex < closureTokenIndex);
+Type* Environment::getType(const Identifier& pIdentifier, const CflatArgsVector(TypeUsage)& pTemplateTypes) const
+{
+   AccessScope accessScope(this, AccessType::Read);
+   return mGlobalNamespace.getType(pIdentifier, pTemplateTypes);
+}
 
-   const size_t misalignment = structSize % structAlignment;
+TypeUsage Environment::getTypeUsage(const char* pTypeName, Namespace* pNamespace) const
+{
+   AccessScope accessScope(this, AccessType::Read);
 
-   if(misalignment > 0u)
+   if(!pTypeName || pTypeName[0] == '\0')
    {
-      const size_t padding = structAlignment - misalignment;
-      structSize += padding;
+      return TypeUsage();
    }
 
-   statement->mStruct->mSize = structSize;
-   statement->mStruct->mAlignment = (uint8_t)structAlignment;
+   std::lock_guard<std::mutex> lock(mTypeUsageParsingMutex);
+   ParsingContext& parsingContext = mTypeUsageParsingContext;
 
-   if(tokens[++tokenIndex].mStart[0] != ';')
-   {
-      throwCompileError(pContext, CompileError::Expected, ";");
-   }
+   parsingContext.mNamespaceStack.clear();
+   parsingContext.mNamespaceStack.push_back(pNamespace ? pNamespace : const_cast<Namespace*>(&mGlobalNamespace));
+   parsingContext.mErrorMessage.clear();
+   parsingContext.mTokenIndex = 0u;
 
-   return statement;
+   Tokenizer::tokenize(pTypeName, parsingContext.mTokens);
+   parsingContext.mTokensIndex.build(parsingContext.mTokens);
+
+   return parseTypeUsage(parsingContext, 0u);
 }
 
-StatementIf* Environment::parseStatementIf(ParsingContext& pContext)
+Function* Environment::registerFunction(const Identifier& pIdentifier)
 {
-   if(pContext.mScopeLevel == 0u)
-   {
-      throwCompileErrorUnexpectedSymbol(pContext);
-      return nullptr;
-   }
+   AccessScope accessScope(this, AccessType::Write);
+   Memory::AllocatorScope allocatorScope(&mAllocator);
 
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t& tokenIndex = pContext.mTokenIndex;
+   mRegistrationGeneration++;
+   return mGlobalNamespace.registerFunction(pIdentifier);
+}
 
-   if(tokens[tokenIndex].mStart[0] != '(')
-   {
-      throwCompileError(pContext, CompileError::UnexpectedSymbol, "if");
-      return nullptr;
-   }
+Function* Environment::getFunction(const Identifier& pIdentifier) const
+{
+   AccessScope accessScope(this, AccessType::Read);
+   return mGlobalNamespace.getFunction(pIdentifier);
+}
 
-   const size_t conditionClosureTokenIndex = findClosureTokenIndex(pContext, '(', ')');
+Function* Environment::getFunction(const Identifier& pIdentifier,
+   const CflatArgsVector(TypeUsage)& pParameterTypes) const
+{
+   AccessScope accessScope(this, AccessType::Read);
+   return mGlobalNamespace.getFunction(pIdentifier, pParameterTypes);
+}
 
-   if(conditionClosureTokenIndex == 0u)
-   {
-      throwCompileError(pContext, CompileError::Expected, ")");
-      return nullptr;
-   }
+Function* Environment::getFunction(const Identifier& pIdentifier,
+   const CflatArgsVector(Value)& pArguments) const
+{
+   AccessScope accessScope(this, AccessType::Read);
+   return mGlobalNamespace.getFunction(pIdentifier, pArguments);
+}
 
-   tokenIndex++;
-   Expression* condition = parseExpression(pContext, conditionClosureTokenIndex - 1u);
-   tokenIndex = conditionClosureTokenIndex + 1u;
+CflatSTLVector(Function*)* Environment::getFunctions(const Identifier& pIdentifier) const
+{
+   AccessScope accessScope(this, AccessType::Read);
+   return mGlobalNamespace.getFunctions(pIdentifier);
+}
 
-   Statement* ifStatement = parseStatement(pContext);
+Instance* Environment::setVariable(const TypeUsage& pTypeUsage, const Identifier& pIdentifier,
+   const Value& pValue)
+{
+   AccessScope accessScope(this, AccessType::Write);
+   Memory::AllocatorScope allocatorScope(&mAllocator);
 
-   if(!ifStatement)
-   {
-      throwCompileErrorUnexpectedSymbol(pContext);
-      return nullptr;
-   }
+   mRegistrationGeneration++;
+   return mGlobalNamespace.setVariable(pTypeUsage, pIdentifier, pValue);
+}
 
-   const size_t tokenIndexForElseCheck = tokenIndex + 1u;
-   Statement* elseStatement = nullptr;
+Value* Environment::getVariable(const Identifier& pIdentifier) const
+{
+   AccessScope accessScope(this, AccessType::Read);
+   return mGlobalNamespace.getVariable(pIdentifier);
+}
 
-   if(tokens[tokenIndexForElseCheck].mType == TokenType::Keyword &&
-      strncmp(tokens[tokenIndexForElseCheck].mStart, "else", 4u) == 0)
-   {
-      tokenIndex = tokenIndexForElseCheck + 1u;
-      elseStatement = parseStatement(pContext);
-   }
+Instance* Environment::registerInstance(const TypeUsage& pTypeUsage, const Identifier& pIdentifier)
+{
+   AccessScope accessScope(this, AccessType::Write);
+   Memory::AllocatorScope allocatorScope(&mAllocator);
 
-   StatementIf* statement = (StatementIf*)CflatMalloc(sizeof(StatementIf));
-   CflatInvokeCtor(StatementIf, statement)(condition, ifStatement, elseStatement);
+   mRegistrationGeneration++;
+   return mGlobalNamespace.registerInstance(pTypeUsage, pIdentifier);
+}
 
-   return statement;
+Instance* Environment::retrieveInstance(const Identifier& pIdentifier) const
+{
+   AccessScope accessScope(this, AccessType::Read);
+   return mGlobalNamespace.retrieveInstance(pIdentifier);
 }
 
-StatementSwitch* Environment::parseStatementSwitch(ParsingContext& pContext)
+void Environment::voidFunctionCall(Function* pFunction)
 {
-   if(pContext.mScopeLevel == 0u)
-   {
-      throwCompileErrorUnexpectedSymbol(pContext);
-      return nullptr;
-   }
+   AccessScope accessScope(this, AccessType::Execute);
+   CflatAssert(pFunction);
 
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t& tokenIndex = pContext.mTokenIndex;
+   Memory::AllocatorScope allocatorScope(&mAllocator);
 
-   if(tokens[tokenIndex].mStart[0] != '(')
-   {
-      throwCompileError(pContext, CompileError::UnexpectedSymbol, "switch");
-      return nullptr;
-   }
+   mErrorMessage.clear();
 
-   const size_t conditionClosureTokenIndex = findClosureTokenIndex(pContext, '(', ')');
+   Value returnValue;
 
-   if(conditionClosureTokenIndex == 0u)
-   {
-      throwCompileError(pContext, CompileError::Expected, ")");
-      return nullptr;
-   }
+   CflatArgsVector(Value) args;
+   pFunction->execute(args, &returnValue);
+}
+
+CallFuture Environment::submitFunctionCall(Function* pFunction, const void* const* pArgData,
+   size_t pArgsCount)
+{
+   // The call can be submitted from any thread. It is shared with the futures, which might
+   // outlive the environment, so it does not come from the environment's allocator
+   QueuedCall* call = nullptr;
 
-   if(tokens[conditionClosureTokenIndex + 1u].mStart[0] != '{')
    {
-      pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
-      throwCompileError(pContext, CompileError::UnexpectedSymbol, pContext.mStringBuffer.c_str());
-      return nullptr;
+      Memory::AllocatorScope defaultAllocatorScope(Memory::getDefaultAllocator());
+      call = (QueuedCall*)CflatMalloc(sizeof(QueuedCall));
+      CflatInvokeCtor(QueuedCall, call)(pFunction);
    }
 
-   tokenIndex++;
-   Expression* condition = parseExpression(pContext, conditionClosureTokenIndex - 1u);
-   tokenIndex = conditionClosureTokenIndex + 1u;
+   // The arguments do, and get released as soon as the call gets processed or discarded
+   Memory::AllocatorScope allocatorScope(&mAllocator);
+   copyCallArguments(pFunction, pArgData, pArgsCount, call->mArgs);
 
-   tokenIndex++;
-   const size_t lastSwitchTokenIndex = findClosureTokenIndex(pContext, '{', '}');
+   QueuedCall* head = mQueuedCalls.load(std::memory_order_relaxed);
 
-   if(lastSwitchTokenIndex == 0u)
+   do
    {
-      if(condition)
-      {
-         CflatInvokeDtor(Expression, condition);
-         CflatFree(condition);
-      }
-
-      throwCompileError(pContext, CompileError::Expected, "}");
-      return nullptr;
+      call->mNext = head;
    }
+   while(!mQueuedCalls.compare_exchange_weak(head, call,
+      std::memory_order_release, std::memory_order_relaxed));
 
-   StatementSwitch* statement = (StatementSwitch*)CflatMalloc(sizeof(StatementSwitch));
-   CflatInvokeCtor(StatementSwitch, statement)(condition);
+   return CallFuture(call);
+}
 
-   StatementSwitch::CaseSection* currentCaseSection = nullptr;
+void Environment::copyCallArguments(Function* pFunction, const void* const* pArgData,
+   size_t pArgsCount, CflatArgsVector(Value)& pOutArgs)
+{
+   pOutArgs.resize(pArgsCount);
 
-   for(; tokenIndex < lastSwitchTokenIndex; tokenIndex++)
+   for(size_t i = 0u; i < pArgsCount; i++)
    {
-      if(tokens[tokenIndex].mType == TokenType::Keyword)
-      {
-         if(strncmp(tokens[tokenIndex].mStart, "case", 4u) == 0)
-         {
-            tokenIndex++;
-            const size_t lastCaseTokenIndex =
-               findClosureTokenIndex(pContext, 0, ':', lastSwitchTokenIndex);
-
-            StatementSwitch::CaseSection caseSection;
-            caseSection.mExpression = parseExpression(pContext, lastCaseTokenIndex - 1u);
-            tokenIndex = lastCaseTokenIndex + 1u;
-
-            statement->mCaseSections.push_back(caseSection);
-            currentCaseSection = &statement->mCaseSections.back();
-         }
-         else if(strncmp(tokens[tokenIndex].mStart, "default", 7u) == 0)
-         {
-            tokenIndex += 2u;
-
-            StatementSwitch::CaseSection caseSection;
-            caseSection.mExpression = nullptr;
-
-            statement->mCaseSections.push_back(caseSection);
-            currentCaseSection = &statement->mCaseSections.back();
-         }
-      }
+      const TypeUsage& typeUsage = pFunction->mParameters[i];
 
-      if(!currentCaseSection)
+      if(typeUsage.isReference())
       {
-         if(condition)
-         {
-            CflatInvokeDtor(Expression, condition);
-            CflatFree(condition);
-         }
-
-         pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
-         throwCompileError(pContext, CompileError::UnexpectedSymbol, pContext.mStringBuffer.c_str());
-         return nullptr;
+         pOutArgs[i].initExternal(typeUsage);
       }
-
-      Statement* caseSectionStatement = parseStatement(pContext);
-
-      if(caseSectionStatement)
+      else
       {
-         currentCaseSection->mStatements.push_back(caseSectionStatement);
+         pOutArgs[i].initOnHeap(typeUsage);
       }
-   }
 
-   return statement;
+      pOutArgs[i].set(pArgData[i]);
+   }
 }
 
-StatementWhile* Environment::parseStatementWhile(ParsingContext& pContext)
+size_t Environment::processQueuedCalls()
 {
-   if(pContext.mScopeLevel == 0u)
-   {
-      throwCompileErrorUnexpectedSymbol(pContext);
-      return nullptr;
-   }
-
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t& tokenIndex = pContext.mTokenIndex;
+   QueuedCall* head = mQueuedCalls.exchange(nullptr, std::memory_order_acquire);
 
-   if(tokens[tokenIndex].mStart[0] != '(')
-   {
-      throwCompileError(pContext, CompileError::UnexpectedSymbol, "while");
-      return nullptr;
-   }
+   if(!head)
+      return 0u;
 
-   const size_t conditionClosureTokenIndex = findClosureTokenIndex(pContext, '(', ')');
+   // Calls are pushed at the front, so the list is reversed to process them in order
+   QueuedCall* call = nullptr;
 
-   if(conditionClosureTokenIndex == 0u)
+   while(head)
    {
-      throwCompileError(pContext, CompileError::Expected, ")");
-      return nullptr;
+      QueuedCall* next = head->mNext;
+      head->mNext = call;
+      call = head;
+      head = next;
    }
 
-   tokenIndex++;
-   Expression* condition = parseExpression(pContext, conditionClosureTokenIndex - 1u);
-   tokenIndex = conditionClosureTokenIndex + 1u;
-
-   Statement* loopStatement = parseStatement(pContext);
+   AccessScope accessScope(this, AccessType::Execute);
+   Memory::AllocatorScope allocatorScope(&mAllocator);
 
-   StatementWhile* statement = (StatementWhile*)CflatMalloc(sizeof(StatementWhile));
-   CflatInvokeCtor(StatementWhile, statement)(condition, loopStatement);
+   const bool wasProcessingQueuedCalls = gProcessingQueuedCalls;
+   gProcessingQueuedCalls = true;
 
-   return statement;
-}
+   size_t processedCallsCount = 0u;
 
-StatementDoWhile* Environment::parseStatementDoWhile(ParsingContext& pContext)
-{
-   if(pContext.mScopeLevel == 0u)
+   while(call)
    {
-      throwCompileErrorUnexpectedSymbol(pContext);
-      return nullptr;
-   }
+      Function* function = call->mFunction;
+      const bool mustReturnValue = function->mReturnTypeUsage != mTypeUsageVoid;
 
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t& tokenIndex = pContext.mTokenIndex;
+      {
+         Value returnValue;
 
-   Statement* loopStatement = parseStatement(pContext);
-   tokenIndex++;
+         if(mustReturnValue)
+         {
+            returnValue.initOnStack(function->mReturnTypeUsage, &mExecutionContext.mStack);
+         }
 
-   if(strncmp(tokens[tokenIndex].mStart, "while", 5u) != 0)
-   {
-      if(loopStatement)
-      {
-         CflatInvokeDtor(Statement, loopStatement);
-         CflatFree(loopStatement);
-      }
+         mErrorMessage.clear();
+         function->execute(call->mArgs, &returnValue);
 
-      throwCompileErrorUnexpectedSymbol(pContext);
-      return nullptr;
-   }
+         // the result is released by whichever thread releases the call last, which might
+         // happen after the environment has been destroyed
+         Memory::AllocatorScope defaultAllocatorScope(Memory::getDefaultAllocator());
 
-   tokenIndex++;
+         if(mustReturnValue)
+         {
+            call->mReturnValue.initOnHeap(function->mReturnTypeUsage);
+            call->mReturnValue.set(returnValue.mValueBuffer);
+         }
 
-   if(tokens[tokenIndex].mStart[0] != '(')
-   {
-      if(loopStatement)
-      {
-         CflatInvokeDtor(Statement, loopStatement);
-         CflatFree(loopStatement);
+         call->mErrorMessage.assign(mErrorMessage.c_str());
       }
 
-      throwCompileErrorUnexpectedSymbol(pContext);
-      return nullptr;
-   }
-
-   const size_t conditionClosureTokenIndex = findClosureTokenIndex(pContext, '(', ')');
+      call->mArgs.resize(0u);
 
-   if(conditionClosureTokenIndex == 0u)
-   {
-      if(loopStatement)
-      {
-         CflatInvokeDtor(Statement, loopStatement);
-         CflatFree(loopStatement);
-      }
+      QueuedCall* next = call->mNext;
+      call->mDone.store(true, std::memory_order_release);
+      CallFuture::release(call);
 
-      throwCompileError(pContext, CompileError::Expected, ")");
-      return nullptr;
+      call = next;
+      processedCallsCount++;
    }
 
-   tokenIndex++;
-   Expression* condition = parseExpression(pContext, conditionClosureTokenIndex - 1u);
-   tokenIndex = conditionClosureTokenIndex + 1u;
-
-   StatementDoWhile* statement = (StatementDoWhile*)CflatMalloc(sizeof(StatementDoWhile));
-   CflatInvokeCtor(StatementDoWhile, statement)(condition, loopStatement);
+   gProcessingQueuedCalls = wasProcessingQueuedCalls;
 
-   return statement;
+   return processedCallsCount;
 }
 
-Statement* Environment::parseStatementFor(ParsingContext& pContext)
+void Environment::discardQueuedCalls()
 {
-   if(pContext.mScopeLevel == 0u)
-   {
-      throwCompileErrorUnexpectedSymbol(pContext);
-      return nullptr;
-   }
+   Memory::AllocatorScope allocatorScope(Memory::getDefaultAllocator());
 
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t& tokenIndex = pContext.mTokenIndex;
+   QueuedCall* call = mQueuedCalls.exchange(nullptr, std::memory_order_acquire);
 
-   if(tokens[tokenIndex].mStart[0] != '(')
+   while(call)
    {
-      throwCompileError(pContext, CompileError::UnexpectedSymbol, "for");
-      return nullptr;
+      QueuedCall* next = call->mNext;
+      call->mArgs.resize(0u);
+      call->mErrorMessage.assign("[Runtime Error] the call was discarded before being processed");
+      call->mDone.store(true, std::memory_order_release);
+      CallFuture::release(call);
+
+      call = next;
    }
+}
 
-   incrementScopeLevel(pContext);
-   incrementScopeLevel(mExecutionContext);
+// Thread-local state of the execution which runs on a thread, which native executions keep on
+// their own while suspended, and the resuming code while they run
+struct ThreadExecutionState
+{
+   const Memory::Allocator* mAllocator;
+   Memory::Category mCategory;
+   Environment::AllocationReason mAllocationReason;
+   ParallelWorkerBinding mParallelWorker;
+   const Environment::AccessScope* mAccessScope;
+};
 
-   tokenIndex++;
+static void swapThreadExecutionState(ThreadExecutionState* pState)
+{
+   std::swap(pState->mAllocator, gCurrentAllocator);
+   std::swap(pState->mCategory, gCurrentCategory);
+   std::swap(pState->mAllocationReason, gAllocationReason);
+   std::swap(pState->mParallelWorker, gCurrentParallelWorker);
+   std::swap(pState->mAccessScope, gCurrentAccessScope);
+}
+
+namespace Cflat
+{
+   // Native stack which coroutines and resumable calls run on, along with the states to switch
+   // between. The resuming thread switches to it, and the execution switches back when it
+   // suspends itself or finishes.
+   struct NativeExecutionState
+   {
+#if defined (CflatCoroutineFibers)
+      void* mFiber;
+      void* mResumerFiber;
+#elif defined (CflatCoroutineUContext)
+      ucontext_t mContext;
+      ucontext_t mResumerContext;
+      char* mStack;
+#else
+      std::thread mThread;
+      std::mutex mSwitchMutex;
+      std::condition_variable mSwitchCondition;
+      // Whether the native execution is the one running, while the other side waits
+      bool mNativeRunning;
+#endif
+      ThreadExecutionState mThreadState;
+      const Environment::AccessScope* mResumingScope;
+      void (*mEntryPoint)(void*);
+      void* mEntryArgument;
+      // Work which the native execution hands over to the resuming thread, to get it done on
+      // the resuming thread's stack rather than on its own
+      void (*mResumerTask)(void*);
+      void* mResumerTaskArgument;
+   };
+}
 
-   const size_t initializationClosureTokenIndex = findClosureTokenIndex(pContext, 0, ';');
-   const size_t variableClosureTokenIndex = findClosureTokenIndex(pContext, 0, ':');
+#if defined (CflatCoroutineUContext)
+// Native execution being started on the current thread, picked up by its entry point
+static thread_local NativeExecutionState* gStartingNativeExecution = nullptr;
+#endif
 
-   if(initializationClosureTokenIndex == 0u && variableClosureTokenIndex == 0u)
-   {
-      throwCompileError(pContext, CompileError::Expected, "';' or variable declaration");
-      return nullptr;
-   }
+static NativeExecutionState* createNativeExecutionState(Environment* pEnvironment,
+   ExecutionContext* pContext, const Environment::AccessScope* pResumingScope, size_t pStackSize,
+   void (*pEntryPoint)(void*), void* pEntryArgument)
+{
+   NativeExecutionState* state = (NativeExecutionState*)CflatMalloc(sizeof(NativeExecutionState));
+   CflatInvokeCtor(NativeExecutionState, state);
 
-   Statement* statement = nullptr;
+   state->mThreadState.mAllocator = gCurrentAllocator;
+   state->mThreadState.mCategory = gCurrentCategory;
+   state->mThreadState.mAllocationReason = gAllocationReason;
+   state->mThreadState.mParallelWorker.mEnvironment = pEnvironment;
+   state->mThreadState.mParallelWorker.mContext = pContext;
+   state->mThreadState.mAccessScope = nullptr;
+   state->mResumingScope = pResumingScope;
+   state->mEntryPoint = pEntryPoint;
+   state->mEntryArgument = pEntryArgument;
+   state->mResumerTask = nullptr;
+   state->mResumerTaskArgument = nullptr;
 
-   if((initializationClosureTokenIndex > 0u && variableClosureTokenIndex == 0u) ||
-      (initializationClosureTokenIndex < variableClosureTokenIndex))
+#if defined (CflatCoroutineFibers)
+   state->mFiber = CreateFiber(pStackSize, [](void* pState)
    {
-      statement = parseStatementForRegular(pContext, initializationClosureTokenIndex);
-   }
-   else
+      NativeExecutionState* startingState = static_cast<NativeExecutionState*>(pState);
+      startingState->mEntryPoint(startingState->mEntryArgument);
+   }, state);
+#elif defined (CflatCoroutineUContext)
+   state->mStack = (char*)CflatMalloc(pStackSize);
+
+   getcontext(&state->mContext);
+   state->mContext.uc_stack.ss_sp = state->mStack;
+   state->mContext.uc_stack.ss_size = pStackSize;
+   state->mContext.uc_link = nullptr;
+   makecontext(&state->mContext, []()
    {
-      statement = parseStatementForRangeBased(pContext, variableClosureTokenIndex);
-   }
+      NativeExecutionState* startingState = gStartingNativeExecution;
+      gStartingNativeExecution = nullptr;
+      startingState->mEntryPoint(startingState->mEntryArgument);
+   }, 0);
 
-   decrementScopeLevel(mExecutionContext);
-   decrementScopeLevel(pContext);
+   gStartingNativeExecution = state;
+#else
+   // threads get the default stack size of the platform
+   (void)pStackSize;
 
-   return statement;
+   state->mNativeRunning = false;
+   state->mThread = std::thread([state]()
+   {
+      // the thread-local state of the native execution stays on its own thread
+      swapThreadExecutionState(&state->mThreadState);
+
+      {
+         std::unique_lock<std::mutex> lock(state->mSwitchMutex);
+         state->mSwitchCondition.wait(lock, [state]() { return state->mNativeRunning; });
+      }
+
+      state->mEntryPoint(state->mEntryArgument);
+   });
+#endif
+
+   return state;
 }
 
-StatementFor* Environment::parseStatementForRegular(ParsingContext& pContext,
-   size_t pInitializationClosureTokenIndex)
-{
-   size_t& tokenIndex = pContext.mTokenIndex;
+static void releaseNativeExecutionState(NativeExecutionState* pState)
+{
+#if defined (CflatCoroutineFibers)
+   DeleteFiber(pState->mFiber);
+#elif defined (CflatCoroutineUContext)
+   CflatFree(pState->mStack);
+#else
+   // the thread of a finished execution is waiting to be switched to, only to return
+   {
+      std::unique_lock<std::mutex> lock(pState->mSwitchMutex);
+      pState->mNativeRunning = true;
+   }
+
+   pState->mSwitchCondition.notify_one();
+   pState->mThread.join();
+#endif
 
-   Statement* initialization = nullptr;
-   
-   if(pInitializationClosureTokenIndex > tokenIndex)
-   {
-      initialization = parseStatement(pContext);
-   }
+   CflatInvokeDtor(NativeExecutionState, pState);
+   CflatFree(pState);
+}
 
-   tokenIndex = pInitializationClosureTokenIndex + 1u;
+// Runs the native execution until it suspends itself or finishes
+static void switchToNativeExecution(NativeExecutionState* pState)
+{
+   do
+   {
+      // the task handed over by the native execution, if any, which then continues
+      if(pState->mResumerTask)
+      {
+         pState->mResumerTask(pState->mResumerTaskArgument);
+         pState->mResumerTask = nullptr;
+      }
 
-   const size_t conditionClosureTokenIndex = findClosureTokenIndex(pContext, 0, ';');
+#if defined (CflatCoroutineFibers)
+      swapThreadExecutionState(&pState->mThreadState);
 
-   if(conditionClosureTokenIndex == 0u)
-   {
-      throwCompileError(pContext, CompileError::Expected, ";");
-      return nullptr;
-   }
+      const bool convertedThread = !IsThreadAFiber();
+      pState->mResumerFiber = convertedThread ? ConvertThreadToFiber(nullptr) : GetCurrentFiber();
+      SwitchToFiber(pState->mFiber);
 
-   Expression* condition = nullptr;
-   
-   if(conditionClosureTokenIndex > tokenIndex)
-   {
-      condition = parseExpression(pContext, conditionClosureTokenIndex - 1u);
+      if(convertedThread)
+      {
+         ConvertFiberToThread();
+      }
+
+      swapThreadExecutionState(&pState->mThreadState);
+#elif defined (CflatCoroutineUContext)
+      swapThreadExecutionState(&pState->mThreadState);
+      swapcontext(&pState->mResumerContext, &pState->mContext);
+      swapThreadExecutionState(&pState->mThreadState);
+#else
+      std::unique_lock<std::mutex> lock(pState->mSwitchMutex);
+      pState->mNativeRunning = true;
+      pState->mSwitchCondition.notify_one();
+      pState->mSwitchCondition.wait(lock, [pState]() { return !pState->mNativeRunning; });
+#endif
    }
+   while(pState->mResumerTask);
+}
 
-   tokenIndex = conditionClosureTokenIndex + 1u;
+// Hands control back to the resuming thread, from the native execution
+static void switchToResumer(NativeExecutionState* pState)
+{
+#if defined (CflatCoroutineFibers)
+   SwitchToFiber(pState->mResumerFiber);
+#elif defined (CflatCoroutineUContext)
+   swapcontext(&pState->mContext, &pState->mResumerContext);
+#else
+   std::unique_lock<std::mutex> lock(pState->mSwitchMutex);
+   pState->mNativeRunning = false;
+   pState->mSwitchCondition.notify_one();
+   pState->mSwitchCondition.wait(lock, [pState]() { return pState->mNativeRunning; });
+#endif
+}
 
-   const size_t incrementClosureTokenIndex = findClosureTokenIndex(pContext, '(', ')');
+// Gets the task done by the resuming thread, from the native execution
+static void runOnResumer(NativeExecutionState* pState, void (*pTask)(void*), void* pArgument)
+{
+   pState->mResumerTask = pTask;
+   pState->mResumerTaskArgument = pArgument;
+   switchToResumer(pState);
+}
 
-   if(incrementClosureTokenIndex == 0u)
-   {
-      throwCompileError(pContext, CompileError::Expected, ")");
-      return nullptr;
-   }
+ResumableCall* Environment::createResumableCall(Function* pFunction, const void* const* pArgData,
+   size_t pArgsCount)
+{
+   AccessScope accessScope(this, AccessType::Execute);
 
-   Expression* increment = nullptr;
-   
-   if(incrementClosureTokenIndex > tokenIndex)
-   {
-      increment = parseExpression(pContext, incrementClosureTokenIndex - 1u);
-   }
+   Memory::AllocatorScope allocatorScope(&mAllocator);
 
-   tokenIndex = incrementClosureTokenIndex + 1u;
+   ResumableCall* call = (ResumableCall*)CflatMalloc(sizeof(ResumableCall));
+   CflatInvokeCtor(ResumableCall, call)(this, pFunction, &mGlobalNamespace);
 
-   Statement* loopStatement = parseStatement(pContext);
+   copyCallArguments(pFunction, pArgData, pArgsCount, call->mArgs);
 
-   StatementFor* statement = (StatementFor*)CflatMalloc(sizeof(StatementFor));
-   CflatInvokeCtor(StatementFor, statement)(initialization, condition, increment, loopStatement);
+   mResumableCalls.push_back(call);
 
-   return statement;
+   return call;
 }
 
-StatementForRangeBased* Environment::parseStatementForRangeBased(ParsingContext& pContext,
-   size_t pVariableClosureTokenIndex)
+void Environment::setResumableCallStackSize(ResumableCall* pCall, size_t pStackSize)
 {
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t& tokenIndex = pContext.mTokenIndex;
+   CflatAssert(pCall && pCall->mEnvironment == this);
+   // the stack is already in use once the call has been resumed
+   CflatAssert(!pCall->mNativeState);
+   CflatAssert(pStackSize > 0u);
 
-   TypeUsage variableTypeUsage = parseTypeUsage(pContext, pVariableClosureTokenIndex - 1u);
+   pCall->mStackSize = pStackSize;
+}
 
-   if(!variableTypeUsage.mType)
-   {
-      throwCompileErrorUnexpectedSymbol(pContext);
-      return nullptr;
-   }
+bool Environment::resumeCall(ResumableCall* pCall, const ExecutionBudget& pBudget)
+{
+   CflatAssert(pCall && pCall->mEnvironment == this);
+   CflatAssert(!pCall->mFinished);
+   // the call cannot resume itself
+   CflatAssert(gCurrentParallelWorker.mContext != &pCall->mContext);
 
-   Identifier variableIdentifier;
+   AccessScope accessScope(this, AccessType::Execute);
 
-   if(tokens[tokenIndex].mType == TokenType::Identifier)
-   {
-      pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
-      variableIdentifier = Identifier(pContext.mStringBuffer.c_str());
-   }
-   else
+   pCall->mBudget = pBudget;
+   pCall->mSliceStatementsCount = 0u;
+   pCall->mSliceStart = getProfilerTime();
+   pCall->mResumesCount++;
+
+   if(!pCall->mNativeState)
    {
-      throwCompileErrorUnexpectedSymbol(pContext);
-      return nullptr;
+      Memory::AllocatorScope allocatorScope(&mAllocator);
+
+      pCall->mNativeState = createNativeExecutionState(this, &pCall->mContext, &accessScope,
+         pCall->mStackSize, [](void* pResumableCall)
+         {
+            ResumableCall* call = static_cast<ResumableCall*>(pResumableCall);
+            call->mEnvironment->runResumableCall(call);
+         }, pCall);
    }
 
-   tokenIndex = pVariableClosureTokenIndex + 1u;
-   const size_t collectionClosureTokenIndex = findClosureTokenIndex(pContext, '(', ')');
+   switchToNativeExecution(pCall->mNativeState);
 
-   if(collectionClosureTokenIndex <= tokenIndex)
-   {
-      throwCompileError(pContext, CompileError::Expected, ")");
-      return nullptr;
-   }
+   return pCall->mFinished;
+}
 
-   Expression* collection = parseExpression(pContext, collectionClosureTokenIndex - 1u);
+void Environment::releaseResumableCall(ResumableCall* pCall)
+{
+   CflatAssert(pCall && pCall->mEnvironment == this);
 
-   if(!collection)
+   AccessScope accessScope(this, AccessType::Execute);
+
+   if(pCall->mNativeState)
    {
-      return nullptr;
-   }
+      if(!pCall->mFinished)
+      {
+         pCall->mAborting = true;
+         resumeCall(pCall);
+         CflatAssert(pCall->mFinished);
+      }
 
-   bool validStatement = false;
-   const TypeUsage& collectionTypeUsage = getTypeUsage(collection);
+      Memory::AllocatorScope allocatorScope(&mAllocator);
 
-   if(collectionTypeUsage.isArray() && !variableTypeUsage.isArray() &&
-      collectionTypeUsage.mPointerLevel == variableTypeUsage.mPointerLevel)
+      releaseNativeExecutionState(pCall->mNativeState);
+      pCall->mNativeState = nullptr;
+   }
+
+   for(size_t i = 0u; i < mResumableCalls.size(); i++)
    {
-      if(variableTypeUsage.mType == mTypeAuto)
+      if(mResumableCalls[i] == pCall)
       {
-         variableTypeUsage.mType = collectionTypeUsage.mType;
+         mResumableCalls.erase(mResumableCalls.begin() + i);
+         break;
       }
+   }
 
-      TypeUsage elementTypeUsage;
-      elementTypeUsage.mType = collectionTypeUsage.mType;
+   Memory::AllocatorScope allocatorScope(&mAllocator);
 
-      const TypeHelper::Compatibility compatibility =
-         TypeHelper::getCompatibility(elementTypeUsage, variableTypeUsage);
-      validStatement = compatibility == TypeHelper::Compatibility::PerfectMatch;
-   }
-   else if(collectionTypeUsage.mType->mCategory == TypeCategory::StructOrClass)
+   CflatInvokeDtor(ResumableCall, pCall);
+   CflatFree(pCall);
+}
+
+void Environment::runResumableCall(ResumableCall* pCall)
+{
    {
-      Struct* collectionType = static_cast<Struct*>(collectionTypeUsage.mType);
-      Method* beginMethod = collectionType->findMethod("begin", TypeUsage::kEmptyList());
+      // the resuming thread holds execution access while the call runs
+      AccessScope accessScope(this, pCall->mNativeState->mResumingScope);
 
-      if(beginMethod)
-      {
-         Method* endMethod = collectionType->findMethod("end", TypeUsage::kEmptyList());
+      Memory::AllocatorScope allocatorScope(&mAllocator);
+      Memory::CategoryScope categoryScope(Memory::Category::Execution);
 
-         if(endMethod && beginMethod->mReturnTypeUsage == endMethod->mReturnTypeUsage)
-         {
-            const TypeUsage iteratorTypeUsage = beginMethod->mReturnTypeUsage;
+      ExecutionContext& context = pCall->mContext;
+      Function* function = pCall->mFunction;
+      const bool mustReturnValue = function->mReturnTypeUsage != mTypeUsageVoid;
 
-            if(iteratorTypeUsage.mType->mCategory == TypeCategory::StructOrClass && !iteratorTypeUsage.isPointer())
-            {
-               Struct* castIteratorType = static_cast<Struct*>(iteratorTypeUsage.mType);
-               Method* indirectionOperatorMethod =
-                  castIteratorType->findMethod("operator*", TypeUsage::kEmptyList());
+      context.mProgram = const_cast<Program*>(function->mProgram);
+      context.mResumableCall = pCall;
 
-               if(indirectionOperatorMethod)
-               {
-                  CflatArgsVector(TypeUsage) nonEqualOperatorParameterTypes;
-                  nonEqualOperatorParameterTypes.push_back(iteratorTypeUsage);
+      {
+         Value returnValue;
 
-                  validStatement = 
-                     castIteratorType->findMethod("operator!=", nonEqualOperatorParameterTypes) &&
-                     castIteratorType->findMethod("operator++", TypeUsage::kEmptyList());
+         if(mustReturnValue)
+         {
+            returnValue.initOnStack(function->mReturnTypeUsage, &context.mStack);
+         }
 
-                  if(validStatement && variableTypeUsage.mType == mTypeAuto)
-                  {
-                     variableTypeUsage.mType = indirectionOperatorMethod->mReturnTypeUsage.mType;
-                  }
-               }
-            }
-            else
-            {
-               if(variableTypeUsage.mType == mTypeAuto)
-               {
-                  variableTypeUsage.mType = iteratorTypeUsage.mType;
-               }
+         function->execute(pCall->mArgs, &returnValue);
 
-               validStatement = iteratorTypeUsage.isPointer();
-            }
+         if(mustReturnValue)
+         {
+            pCall->mReturnValue.initOnHeap(function->mReturnTypeUsage);
+            pCall->mReturnValue.set(returnValue.mValueBuffer);
          }
       }
-   }
 
-   if(!validStatement)
-   {
-      throwCompileErrorUnexpectedSymbol(pContext);
-      return nullptr;
+      context.mResumableCall = nullptr;
    }
 
-   registerInstance(pContext, variableTypeUsage, variableIdentifier);
-
-   tokenIndex = collectionClosureTokenIndex + 1u;
-   Statement* loopStatement = parseStatement(pContext);
-
-   StatementForRangeBased* statement =
-      (StatementForRangeBased*)CflatMalloc(sizeof(StatementForRangeBased));
-   CflatInvokeCtor(StatementForRangeBased, statement)
-      (variableTypeUsage, variableIdentifier, collection, loopStatement);
+   pCall->mFinished = true;
 
-   return statement;
+   // the native stack of a finished call does not get switched to anymore
+   switchToResumer(pCall->mNativeState);
 }
 
-StatementBreak* Environment::parseStatementBreak(ParsingContext& pContext)
+void Environment::consumeExecutionBudget(ExecutionContext& pContext)
 {
-   if(pContext.mScopeLevel == 0u)
-   {
-      throwCompileErrorUnexpectedSymbol(pContext);
-      return nullptr;
-   }
+   ResumableCall* call = pContext.mResumableCall;
+   const ExecutionBudget& budget = call->mBudget;
 
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t& tokenIndex = pContext.mTokenIndex;
+   // at least one statement gets executed each time the call is resumed
+   const bool budgetExhausted = !call->mAborting && call->mSliceStatementsCount > 0u &&
+      ((budget.mStatementsCount > 0u && call->mSliceStatementsCount >= budget.mStatementsCount) ||
+      (budget.mTime > 0u && getProfilerTime() - call->mSliceStart >= budget.mTime));
 
-   if(tokens[tokenIndex].mStart[0] != ';')
+   if(budgetExhausted)
    {
-      throwCompileError(pContext, CompileError::UnexpectedSymbol, "break");
-      return nullptr;
+      // hand control back to the resuming thread, until the call gets resumed again
+      switchToResumer(call->mNativeState);
    }
 
-   StatementBreak* statement = (StatementBreak*)CflatMalloc(sizeof(StatementBreak));
-   CflatInvokeCtor(StatementBreak, statement)();
+   if(call->mAborting)
+   {
+      pContext.mErrorMessage.assign("[Runtime Error] the call was released before finishing");
+      return;
+   }
 
-   return statement;
+   call->mSliceStatementsCount++;
+   call->mStatementsCount++;
 }
 
-StatementContinue* Environment::parseStatementContinue(ParsingContext& pContext)
+void Environment::releaseResumableCalls()
 {
-   if(pContext.mScopeLevel == 0u)
+   while(!mResumableCalls.empty())
    {
-      throwCompileErrorUnexpectedSymbol(pContext);
-      return nullptr;
+      releaseResumableCall(mResumableCalls.back());
    }
+}
 
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t& tokenIndex = pContext.mTokenIndex;
+Coroutine* Environment::createCoroutine(Function* pFunction, const void* const* pArgData,
+   size_t pArgsCount)
+{
+   AccessScope accessScope(this, AccessType::Execute);
 
-   if(tokens[tokenIndex].mStart[0] != ';')
-   {
-      throwCompileError(pContext, CompileError::UnexpectedSymbol, "continue");
-      return nullptr;
-   }
+   Memory::AllocatorScope allocatorScope(&mAllocator);
 
-   StatementContinue* statement = (StatementContinue*)CflatMalloc(sizeof(StatementContinue));
-   CflatInvokeCtor(StatementContinue, statement)();
+   Coroutine* coroutine = (Coroutine*)CflatMalloc(sizeof(Coroutine));
+   CflatInvokeCtor(Coroutine, coroutine)(this, pFunction, &mGlobalNamespace);
 
-   return statement;
+   copyCallArguments(pFunction, pArgData, pArgsCount, coroutine->mArgs);
+
+   coroutine->mIndex = mCoroutines.size();
+   mCoroutines.push_back(coroutine);
+
+   return coroutine;
 }
 
-StatementReturn* Environment::parseStatementReturn(ParsingContext& pContext)
+void Environment::setCoroutineStackSize(Coroutine* pCoroutine, size_t pStackSize)
 {
-   if(pContext.mScopeLevel == 0u || !pContext.mCurrentFunction)
-   {
-      throwCompileErrorUnexpectedSymbol(pContext);
-      return nullptr;
-   }
+   CflatAssert(pCoroutine && pCoroutine->mEnvironment == this);
+   // the stack is already in use once the coroutine has been resumed
+   CflatAssert(!pCoroutine->mNativeState);
+   CflatAssert(pStackSize > 0u);
 
-   const size_t closureTokenIndex = findClosureTokenIndex(pContext, 0, ';');
+   pCoroutine->mStackSize = pStackSize;
+}
 
-   if(closureTokenIndex == 0u)
-   {
-      throwCompileError(pContext, CompileError::Expected, ";");
-      return nullptr;
-   }
+bool Environment::resumeCoroutine(Coroutine* pCoroutine)
+{
+   CflatAssert(pCoroutine && pCoroutine->mEnvironment == this);
+   CflatAssert(!pCoroutine->mFinished);
+   // the coroutine cannot resume itself
+   CflatAssert(gCurrentParallelWorker.mContext != &pCoroutine->mContext);
 
-   const size_t expressionTokenIndex = pContext.mTokenIndex;
-   Expression* expression = parseExpression(pContext, closureTokenIndex - 1u, true);
+   AccessScope accessScope(this, AccessType::Execute);
 
-   if(pContext.mCurrentFunction->mReturnTypeUsage != mTypeUsageVoid)
+   pCoroutine->mResumesCount++;
+
+   if(!pCoroutine->mNativeState)
    {
-      if(expression)
-      {
-         const TypeUsage& expressionTypeUsage = getTypeUsage(expression);
-         const TypeHelper::Compatibility compatibility =
-            TypeHelper::getCompatibility(pContext.mCurrentFunction->mReturnTypeUsage, expressionTypeUsage);
+      Memory::AllocatorScope allocatorScope(&mAllocator);
 
-         if(compatibility == TypeHelper::Compatibility::Incompatible)
+      pCoroutine->mNativeState = createNativeExecutionState(this, &pCoroutine->mContext,
+         &accessScope, pCoroutine->mStackSize, [](void* pCoroutine)
          {
-            throwCompileError(pContext, CompileError::IncompatibleReturnExpressionType,
-               pContext.mCurrentFunction->mIdentifier.mName);
-         }
-      }
-      else
-      {
-         throwCompileError(pContext, CompileError::MissingReturnExpression);
-      }
-   }
-   else
-   {
-      if(expression)
-      {
-         throwCompileError(pContext, CompileError::VoidFunctionReturningValue);
-      }
+            Coroutine* coroutine = static_cast<Coroutine*>(pCoroutine);
+            coroutine->mEnvironment->runCoroutine(coroutine);
+         }, pCoroutine);
    }
 
-   StatementReturn* statement = (StatementReturn*)CflatMalloc(sizeof(StatementReturn));
-   CflatInvokeCtor(StatementReturn, statement)(expression);
-
-   pContext.mTokenIndex = closureTokenIndex;
+   switchToNativeExecution(pCoroutine->mNativeState);
 
-   return statement;
+   return pCoroutine->mFinished;
 }
 
-bool Environment::parseFunctionCallArguments(ParsingContext& pContext,
-   CflatSTLVector(Expression*)* pArguments, CflatSTLVector(TypeUsage)* pTemplateTypes)
+void Environment::runCoroutine(Coroutine* pCoroutine)
 {
-   CflatSTLVector(Token)& tokens = pContext.mTokens;
-   size_t& tokenIndex = pContext.mTokenIndex;
-
-   if(tokens[tokenIndex].mStart[0] == '<')
    {
-      if(pTemplateTypes)
-      {
-         const size_t closureTokenIndex = findClosureTokenIndex(pContext, '<', '>');
+      // the resuming thread holds execution access while the coroutine runs
+      AccessScope accessScope(this, pCoroutine->mNativeState->mResumingScope);
 
-         if(closureTokenIndex > 0u)
-         {
-            while(tokenIndex++ < closureTokenIndex)
-            {
-               TypeUsage typeUsage = parseTypeUsage(pContext, closureTokenIndex - 1u);
+      Memory::AllocatorScope allocatorScope(&mAllocator);
+      Memory::CategoryScope categoryScope(Memory::Category::Execution);
 
-               if(typeUsage.mType)
-               {
-                  pTemplateTypes->push_back(typeUsage);
-               }
-               else
-               {
-                  pContext.mStringBuffer.assign(tokens[tokenIndex].mStart, tokens[tokenIndex].mLength);
-                  throwCompileError(pContext, Environment::CompileError::UndefinedType,
-                     pContext.mStringBuffer.c_str());
-                  return false;
-               }
-            }
-         }
-         else
-         {
-            throwCompileError(pContext, CompileError::Expected, ">");
-            return false;
-         }
+      ExecutionContext& context = pCoroutine->mContext;
+      Function* function = pCoroutine->mFunction;
+      const bool mustReturnValue = function->mReturnTypeUsage != mTypeUsageVoid;
+
+      context.mProgram = const_cast<Program*>(function->mProgram);
+
+      Value returnValue;
+
+      if(mustReturnValue)
+      {
+         returnValue.initOnStack(function->mReturnTypeUsage, &context.mStack);
       }
-      else
+
+      function->execute(pCoroutine->mArgs, &returnValue);
+
+      if(mustReturnValue)
       {
-         throwCompileError(pContext, CompileError::Expected, "(");
-         return false;
+         pCoroutine->mReturnValue.initOnHeap(function->mReturnTypeUsage);
+         pCoroutine->mReturnValue.set(returnValue.mValueBuffer);
       }
    }
 
-   const size_t closureTokenIndex = findClosureTokenIndex(pContext, '(', ')');
+   pCoroutine->mFinished = true;
 
-   if(closureTokenIndex > 0u)
+   // the native stack of a finished coroutine does not get switched to anymore
+   switchToResumer(pCoroutine->mNativeState);
+}
+
+void Environment::yieldCoroutine()
+{
+   ExecutionContext& context = getCurrentExecutionContext();
+   Coroutine* coroutine = context.mCoroutine;
+
+   if(!coroutine)
    {
-      while(tokenIndex++ < closureTokenIndex)
+      if(!context.mCallStack.empty())
       {
-         const size_t separatorTokenIndex =
-            findSeparationTokenIndex(pContext, ',', closureTokenIndex);
-         const size_t tokenLastIndex = 
-           separatorTokenIndex > 0u ? separatorTokenIndex : closureTokenIndex;
+         throwRuntimeError(context, RuntimeError::YieldOutsideCoroutine);
+      }
 
-         Expression* argument = parseExpression(pContext, tokenLastIndex - 1u, true);
+      return;
+   }
 
-         if(!mErrorMessage.empty())
-         {
-            return false;
-         }
+   switchToResumer(coroutine->mNativeState);
 
-         if(argument)
-         {
-            pArguments->push_back(argument);
-         }
+   if(coroutine->mAborting)
+   {
+      context.mErrorMessage.assign("[Runtime Error] the coroutine was released before finishing");
+   }
+}
 
-         tokenIndex = tokenLastIndex;
+void Environment::releaseCoroutine(Coroutine* pCoroutine)
+{
+   CflatAssert(pCoroutine && pCoroutine->mEnvironment == this);
+
+   AccessScope accessScope(this, AccessType::Execute);
+
+   if(pCoroutine->mNativeState)
+   {
+      if(!pCoroutine->mFinished)
+      {
+         pCoroutine->mAborting = true;
+         resumeCoroutine(pCoroutine);
+         CflatAssert(pCoroutine->mFinished);
       }
+
+      Memory::AllocatorScope allocatorScope(&mAllocator);
+
+      releaseNativeExecutionState(pCoroutine->mNativeState);
+      pCoroutine->mNativeState = nullptr;
    }
-   else
+
+   Coroutine* lastCoroutine = mCoroutines.back();
+   lastCoroutine->mIndex = pCoroutine->mIndex;
+   mCoroutines[pCoroutine->mIndex] = lastCoroutine;
+   mCoroutines.pop_back();
+
+   Memory::AllocatorScope allocatorScope(&mAllocator);
+
+   CflatInvokeDtor(Coroutine, pCoroutine);
+   CflatFree(pCoroutine);
+}
+
+void Environment::releaseCoroutines()
+{
+   while(!mCoroutines.empty())
    {
-      throwCompileError(pContext, CompileError::Expected, ")");
-      return false;
+      releaseCoroutine(mCoroutines.back());
    }
+}
 
-   return true;
+bool Environment::hasSuspendedCalls() const
+{
+   for(size_t i = 0u; i < mResumableCalls.size(); i++)
+   {
+      if(mResumableCalls[i]->mNativeState && !mResumableCalls[i]->mFinished)
+         return true;
+   }
+
+   for(size_t i = 0u; i < mCoroutines.size(); i++)
+   {
+      if(mCoroutines[i]->mNativeState && !mCoroutines[i]->mFinished)
+         return true;
+   }
+
+   return false;
 }
 
-const TypeUsage& Environment::getTypeUsage(Expression* pExpression) const
+ExecutionContext& Environment::getCurrentExecutionContext()
 {
-   static const TypeUsage kDefaultTypeUsage;
-   return pExpression && mErrorMessage.empty() ? pExpression->getTypeUsage() : kDefaultTypeUsage;
+   if(gCurrentParallelWorker.mEnvironment == this)
+   {
+      return *gCurrentParallelWorker.mContext;
+   }
+
+   return mExecutionContext;
 }
 
-Type* Environment::findType(const Context& pContext, const Identifier& pIdentifier,
-   const CflatArgsVector(TypeUsage)& pTemplateTypes) const
+bool Environment::parallelInvoke(Function* pFunction, const void* const* pArgsArray, size_t pCount,
+   void* pOutReturnValues, size_t pThreadsCount)
 {
-   Type* type = nullptr;
+   CflatAssert(pFunction);
+   CflatAssert(pArgsArray || pFunction->mParameters.empty());
+   CflatAssert(pCount <= (size_t)UINT32_MAX);
+   // parallel invocations cannot be nested
+   CflatAssert(gCurrentParallelWorker.mEnvironment != this);
 
-   for(size_t i = 0u; i < pContext.mTypeAliases.size(); i++)
+   AccessScope accessScope(this, AccessType::Execute);
+   Memory::AllocatorScope allocatorScope(&mAllocator);
+
+   mErrorMessage.clear();
+
+   if(pCount == 0u)
+      return true;
+
+   size_t threadsCount = pThreadsCount;
+
+   if(threadsCount == 0u)
    {
-      if(pContext.mTypeAliases[i].mIdentifier == pIdentifier)
-      {
-         const TypeUsage& typeUsage = pContext.mTypeAliases[i].mTypeUsage;
+      threadsCount = (size_t)std::thread::hardware_concurrency();
+   }
 
-         if(typeUsage.mFlags == 0u)
-         {
-            type = typeUsage.mType;
-            break;
-         }
-      }
+   threadsCount = std::max((size_t)1u, std::min(threadsCount, pCount));
+
+   // the workers read the error message of the environment, which gets written when parsing,
+   // so deferred function bodies cannot get parsed once they have started
+   parseAllDeferredFunctionBodies();
+
+   requestParallelWorkers(threadsCount);
+
+   // Split the calls evenly; workers running out of calls steal from the others
+   for(size_t i = 0u; i < threadsCount; i++)
+   {
+      const uint64_t rangeBegin = (uint64_t)(pCount * i / threadsCount);
+      const uint64_t rangeEnd = (uint64_t)(pCount * (i + 1u) / threadsCount);
+      mParallelWorkers[i]->mRange.store((rangeBegin << 32u) | rangeEnd, std::memory_order_relaxed);
+      mParallelWorkers[i]->mFirstErrorMessage.clear();
+      mParallelWorkers[i]->mContext.mMemberOwnerValues.clear();
    }
 
-   if(!type)
+   ParallelJob job;
+   job.mFunction = pFunction;
+   job.mArgsArray = pArgsArray;
+   job.mOutReturnValues = pOutReturnValues;
+   job.mThreadsCount = threadsCount;
+   job.mPendingWorkers.store(threadsCount - 1u);
+   job.mAccessScope = &accessScope;
+
+   if(threadsCount > 1u)
    {
-      type = pContext.mNamespaceStack.back()->getType(pIdentifier, pTemplateTypes, true);
+      std::lock_guard<std::mutex> lock(mParallelMutex);
+      mParallelJob = &job;
+      mParallelJobGeneration++;
+      mParallelJobCondition.notify_all();
    }
 
-   if(!type)
+   // the invoking thread acts as the first worker
+   runParallelWorker(job, 0u);
+
+   if(threadsCount > 1u)
    {
-      for(size_t i = 0u; i < pContext.mUsingDirectives.size(); i++)
-      {
-         type = pContext.mUsingDirectives[i].mNamespace->getType(pIdentifier, pTemplateTypes);
+      std::unique_lock<std::mutex> lock(mParallelMutex);
+      mParallelDoneCondition.wait(lock, [&job]() { return job.mPendingWorkers.load() == 0u; });
+      mParallelJob = nullptr;
+   }
 
-         if(type)
-         {
-            break;
-         }
+   for(size_t i = 0u; i < threadsCount; i++)
+   {
+      if(!mParallelWorkers[i]->mFirstErrorMessage.empty())
+      {
+         mErrorMessage.assign(mParallelWorkers[i]->mFirstErrorMessage.c_str());
+         break;
       }
    }
 
-   return type;
+   return mErrorMessage.empty();
 }
 
-Function* Environment::findFunction(const Context& pContext, const Identifier& pIdentifier,
-   const CflatArgsVector(TypeUsage)& pParameterTypes,
-   const CflatArgsVector(TypeUsage)& pTemplateTypes) const
+void Environment::requestParallelWorkers(size_t pWorkersCount)
 {
-   Namespace* ns = pContext.mNamespaceStack.back();
-   Function* function = ns->getFunction(pIdentifier, pParameterTypes, pTemplateTypes, true);
+   Memory::AllocatorScope allocatorScope(&mAllocator);
 
-   if(!function)
+   while(mParallelWorkers.size() < pWorkersCount)
    {
-      for(size_t i = 0u; i < pContext.mUsingDirectives.size(); i++)
+      ParallelWorker* worker = (ParallelWorker*)CflatMalloc(sizeof(ParallelWorker));
+      CflatInvokeCtor(ParallelWorker, worker)(&mGlobalNamespace);
+      mParallelWorkers.push_back(worker);
+
+      if(mProfilingEnabled)
       {
-         Namespace* usingNS = pContext.mUsingDirectives[i].mNamespace;
-         function =
-            usingNS->getFunction(pIdentifier, pParameterTypes, pTemplateTypes, true);
+         worker->mContext.mProfile = acquireProfile((uint32_t)mParallelWorkers.size());
+      }
 
-         if(function)
-         {
-            break;
-         }
+      if(mParallelWorkers.size() > 1u)
+      {
+         const size_t workerIndex = mParallelWorkers.size() - 1u;
+
+         std::thread* thread = (std::thread*)CflatMalloc(sizeof(std::thread));
+         CflatInvokeCtor(std::thread, thread)(&Environment::runParallelWorkerThread, this, workerIndex);
+         mParallelThreads.push_back(thread);
       }
    }
-
-   return function;
 }
 
-Function* Environment::findFunction(const Context& pContext, const Identifier& pIdentifier,
-   const CflatArgsVector(Value)& pArguments,
-   const CflatArgsVector(TypeUsage)& pTemplateTypes) const
+void Environment::releaseParallelWorkers()
 {
-   CflatArgsVector(TypeUsage) typeUsages;
-
-   for(size_t i = 0u; i < pArguments.size(); i++)
    {
-      typeUsages.push_back(pArguments[i].mTypeUsage);
+      std::lock_guard<std::mutex> lock(mParallelMutex);
+      mParallelShutdown = true;
+      mParallelJobCondition.notify_all();
    }
 
-   return findFunction(pContext, pIdentifier, typeUsages, pTemplateTypes);
-}
-
-void Environment::registerTypeAlias(
-  Context& pContext, const Identifier& pIdentifier, const TypeUsage& pTypeUsage)
-{
-   if(pContext.mScopeLevel > 0u)
+   for(size_t i = 0u; i < mParallelThreads.size(); i++)
    {
-      TypeAlias typeAlias(pIdentifier, pTypeUsage);
-      typeAlias.mScopeLevel = pContext.mScopeLevel;
-      pContext.mTypeAliases.push_back(typeAlias);
+      mParallelThreads[i]->join();
+      CflatInvokeDtor(thread, mParallelThreads[i]);
+      CflatFree(mParallelThreads[i]);
    }
-   else
+
+   mParallelThreads.clear();
+
+   for(size_t i = 0u; i < mParallelWorkers.size(); i++)
    {
-      pContext.mNamespaceStack.back()->registerTypeAlias(pIdentifier, pTypeUsage);
+      CflatInvokeDtor(ParallelWorker, mParallelWorkers[i]);
+      CflatFree(mParallelWorkers[i]);
    }
+
+   mParallelWorkers.clear();
 }
 
-Instance* Environment::registerInstance(Context& pContext,
-   const TypeUsage& pTypeUsage, const Identifier& pIdentifier)
+void Environment::runParallelWorkerThread(size_t pWorkerIndex)
 {
-   Instance* instance = nullptr;
-   bool initializationRequired = false;
+   uint32_t lastJobGeneration = 0u;
 
-   if(pContext.mScopeLevel > 0u)
-   {
-      instance = pContext.mLocalInstancesHolder.registerInstance(pTypeUsage, pIdentifier);
-      initializationRequired = true;
-   }
-   else
+   for(;;)
    {
-      instance = pContext.mNamespaceStack.back()->retrieveInstance(pIdentifier);
+      ParallelJob* job = nullptr;
 
-      if(!instance)
       {
-         instance = pContext.mNamespaceStack.back()->registerInstance(pTypeUsage, pIdentifier);
-         initializationRequired = true;
+         std::unique_lock<std::mutex> lock(mParallelMutex);
+         mParallelJobCondition.wait(lock, [this, lastJobGeneration]()
+         {
+            return mParallelShutdown || mParallelJobGeneration != lastJobGeneration;
+         });
+
+         if(mParallelShutdown)
+            return;
+
+         lastJobGeneration = mParallelJobGeneration;
+
+         // the job might have already been completed by the workers taking part in it
+         if(mParallelJob && pWorkerIndex < mParallelJob->mThreadsCount)
+         {
+            job = mParallelJob;
+         }
       }
-      else if(instance->mTypeUsage != pTypeUsage)
+
+      if(!job)
+         continue;
+
       {
-         instance->mTypeUsage = pTypeUsage;
-         initializationRequired = true;
+         // the invoking thread holds execution access while waiting for the workers
+         AccessScope accessScope(this, job->mAccessScope);
+         runParallelWorker(*job, pWorkerIndex);
+      }
+
+      if(job->mPendingWorkers.fetch_sub(1u) == 1u)
+      {
+         std::lock_guard<std::mutex> lock(mParallelMutex);
+         mParallelDoneCondition.notify_all();
       }
    }
+}
 
-   CflatAssert(instance);
+void Environment::runParallelWorker(ParallelJob& pJob, size_t pWorkerIndex)
+{
+   ParallelWorker* worker = mParallelWorkers[pWorkerIndex];
+   ExecutionContext& context = worker->mContext;
 
-   if(initializationRequired)
+   const ParallelWorkerBinding previousBinding = gCurrentParallelWorker;
+   gCurrentParallelWorker.mEnvironment = this;
+   gCurrentParallelWorker.mContext = &context;
+
+   Memory::AllocatorScope allocatorScope(&mAllocator);
+   Memory::CategoryScope categoryScope(Memory::Category::Execution);
+
+   Function* function = pJob.mFunction;
+   const size_t parametersCount = function->mParameters.size();
+   const bool mustReturnValue = function->mReturnTypeUsage != mTypeUsageVoid;
+   const size_t returnValueSize = mustReturnValue ? function->mReturnTypeUsage.getSize() : 0u;
+
+   context.mProgram = const_cast<Program*>(function->mProgram);
+
+   size_t callIndex = 0u;
+
+   while(takeParallelCall(pWorkerIndex, pJob.mThreadsCount, &callIndex))
    {
-      if(instance->mTypeUsage.isReference())
+      Value returnValue;
+
+      if(mustReturnValue)
       {
-         instance->mValue.initExternal(instance->mTypeUsage);
+         returnValue.initOnStack(function->mReturnTypeUsage, &context.mStack);
       }
-      else if(pContext.mScopeLevel == 0u)
+
+      CflatArgsVector(Value) args;
+      initArgumentsForFunctionCall(function, args);
+
+      const void* const* argData = pJob.mArgsArray + callIndex * parametersCount;
+
+      for(size_t i = 0u; i < parametersCount; i++)
       {
-         instance->mValue.initOnHeap(instance->mTypeUsage);
+         args[i].set(argData[i]);
       }
-      else
+
+      function->execute(args, &returnValue);
+
+      while(!args.empty())
       {
-         instance->mValue.initOnStack(instance->mTypeUsage, &pContext.mStack);
+         args.pop_back();
       }
-   }
 
-   CflatAssert(instance->mTypeUsage == pTypeUsage);
+      if(!context.mErrorMessage.empty() && worker->mFirstErrorMessage.empty())
+      {
+         // keep the first error, since the next call clears the one in the context
+         worker->mFirstErrorMessage.assign(context.mErrorMessage.c_str());
+      }
 
-   instance->mScopeLevel = pContext.mScopeLevel;
+      if(mustReturnValue && pJob.mOutReturnValues)
+      {
+         memcpy((char*)pJob.mOutReturnValues + callIndex * returnValueSize,
+            returnValue.mValueBuffer, returnValueSize);
+      }
+   }
 
-   return instance;
+   gCurrentParallelWorker = previousBinding;
 }
 
-Instance* Environment::retrieveInstance(Context& pContext, const Identifier& pIdentifier) const
+bool Environment::takeParallelCall(size_t pWorkerIndex, size_t pWorkersCount, size_t* pOutCallIndex)
 {
-   Instance* instance = pContext.mLocalInstancesHolder.retrieveInstance(pIdentifier);
+   // Take the next call from the front of the own range
+   std::atomic<uint64_t>& ownRange = mParallelWorkers[pWorkerIndex]->mRange;
+   uint64_t range = ownRange.load(std::memory_order_acquire);
 
-   if(!instance)
+   while((range >> 32u) < (range & UINT32_MAX))
    {
-      instance = pContext.mNamespaceStack.back()->retrieveInstance(pIdentifier, true);
+      const uint64_t rangeBegin = range >> 32u;
 
-      if(!instance)
+      if(ownRange.compare_exchange_weak(range, ((rangeBegin + 1u) << 32u) | (range & UINT32_MAX),
+         std::memory_order_acq_rel, std::memory_order_acquire))
       {
-         for(size_t i = 0u; i < pContext.mUsingDirectives.size(); i++)
-         {
-            instance = pContext.mUsingDirectives[i].mNamespace->retrieveInstance(pIdentifier, true);
-
-            if(instance)
-            {
-               break;
-            }
-         }
+         *pOutCallIndex = (size_t)rangeBegin;
+         return true;
       }
+   }
 
-      if(!instance)
+   // Steal the back half of the range from another worker
+   for(size_t i = 1u; i < pWorkersCount; i++)
+   {
+      std::atomic<uint64_t>& victimRange = mParallelWorkers[(pWorkerIndex + i) % pWorkersCount]->mRange;
+      range = victimRange.load(std::memory_order_acquire);
+
+      while((range >> 32u) < (range & UINT32_MAX))
       {
-         const char* lastSeparator = pIdentifier.findLastSeparator();
+         const uint64_t rangeBegin = range >> 32u;
+         const uint64_t rangeEnd = range & UINT32_MAX;
+         const uint64_t rangeMiddle = rangeBegin + (rangeEnd - rangeBegin) / 2u;
 
-         if(lastSeparator)
+         if(victimRange.compare_exchange_weak(range, (rangeBegin << 32u) | rangeMiddle,
+            std::memory_order_acq_rel, std::memory_order_acquire))
          {
-            char buffer[kDefaultLocalStringBufferSize];
-            const size_t typeIdentifierLength = lastSeparator - pIdentifier.mName;
-            strncpy(buffer, pIdentifier.mName, typeIdentifierLength);
-            buffer[typeIdentifierLength] = '\0';
-            const Identifier typeIdentifier(buffer);
-            const Identifier staticMemberIdentifier(lastSeparator + 2);
-
-            Type* type = findType(pContext, typeIdentifier);
-
-            if(type && type->mCategory == TypeCategory::StructOrClass)
-            {
-               instance = static_cast<Struct*>(type)->getStaticMemberInstance(staticMemberIdentifier);
-            }
+            // the own range is empty, so no other worker tries to steal from it
+            ownRange.store(((rangeMiddle + 1u) << 32u) | rangeEnd, std::memory_order_release);
+            *pOutCallIndex = (size_t)rangeMiddle;
+            return true;
          }
       }
    }
 
-   return instance;
+   return false;
+}
+
+bool Environment::load(const char* pProgramName, const char* pCode)
+{
+   ParsingContext* parsingContext = nullptr;
+
+   // Preprocessing and tokenization happen off to the side, without blocking readers nor
+   // script executions, and so does parsing for reloads which only change function bodies
+   {
+      AccessScope accessScope(this, AccessType::Read);
+      parsingContext = prepareProgram(pProgramName, pCode);
+      parseReload(parsingContext);
+   }
+
+   // Parsing registers declarations in the namespaces, so it requires write access, which
+   // is also held while publishing and executing the program
+   AccessScope accessScope(this, AccessType::Write);
+   return commitProgram(parsingContext);
+}
+
+bool Environment::load(const char* pFilePath)
+{
+   Memory::AllocatorScope allocatorScope(&mAllocator);
+
+   char* code = readFile(pFilePath);
+
+   if(!code)
+      return false;
+
+   const bool success = load(pFilePath, code);
+   CflatFree(code);
+
+   return success;
 }
 
-void Environment::incrementBlockLevel(Context& pContext)
+bool Environment::loadMany(const char* const* pProgramNames, const char* const* pCodes,
+   size_t pCount, CflatSTLVector(CflatSTLString)* pOutErrorMessages)
 {
-   pContext.mBlockLevel++;
+   CflatAssert(pCodes);
+   return loadPrograms(pProgramNames, pCodes, pCount, pOutErrorMessages);
 }
 
-void Environment::decrementBlockLevel(Context& pContext)
+bool Environment::loadMany(const char* const* pFilePaths, size_t pCount,
+   CflatSTLVector(CflatSTLString)* pOutErrorMessages)
 {
-   while(!pContext.mUsingDirectives.empty() &&
-      pContext.mUsingDirectives.back().mBlockLevel >= pContext.mBlockLevel)
-   {
-      pContext.mUsingDirectives.pop_back();
-   }
+   return loadPrograms(pFilePaths, nullptr, pCount, pOutErrorMessages);
+}
 
-   pContext.mBlockLevel--;
+const Program* Environment::getProgram(const Identifier& pProgramIdentifier) const
+{
+   AccessScope accessScope(this, AccessType::Read);
+
+   ProgramsRegistry::const_iterator it = mPrograms.find(pProgramIdentifier.mHash);
+   return it != mPrograms.end() ? it->second : nullptr;
 }
 
-void Environment::incrementScopeLevel(Context& pContext)
+char* Environment::readFile(const char* pFilePath)
 {
-   pContext.mScopeLevel++;
+   FILE* file = fopen(pFilePath, "rb");
+
+   if(!file)
+      return nullptr;
+
+   fseek(file, 0, SEEK_END);
+   const size_t fileSize = (size_t)ftell(file);
+   rewind(file);
+
+   char* code = (char*)CflatMalloc(fileSize + 1u);
+   code[fileSize] = '\0';
+
+   fread(code, 1u, fileSize, file);
+   fclose(file);
+
+   return code;
 }
 
-void Environment::decrementScopeLevel(Context& pContext)
+ParsingContext* Environment::prepareProgram(const char* pProgramName, const char* pCode)
 {
-   const bool isExecutionContext = pContext.mType == ContextType::Execution;
+   // Programs can be prepared from any thread
+   Memory::AllocatorScope allocatorScope(&mAllocator);
 
-   if(!isExecutionContext)
-   {
-      ParsingContext& parsingContext = static_cast<ParsingContext&>(pContext);
+   Program* program = (Program*)CflatMalloc(sizeof(Program));
+   CflatInvokeCtor(Program, program);
 
-      while(!parsingContext.mRegisteredInstances.empty() &&
-         parsingContext.mRegisteredInstances.back().mScopeLevel >= pContext.mScopeLevel)
-      {
-         parsingContext.mRegisteredInstances.pop_back();
-      }
+   program->mIdentifier = Identifier(pProgramName);
+   program->mCode.assign(pCode);
 
-      while(!parsingContext.mLocalNamespaceStack.empty() &&
-         parsingContext.mLocalNamespaceStack.back().mScopeLevel >= pContext.mScopeLevel)
-      {
-         parsingContext.mLocalNamespaceStack.pop_back();
-      }
-   }
+   ParsingContext* parsingContext = (ParsingContext*)CflatMalloc(sizeof(ParsingContext));
+   CflatInvokeCtor(ParsingContext, parsingContext)(&mGlobalNamespace);
+   parsingContext->mProgram = program;
 
-   while(!pContext.mTypeAliases.empty() &&
-      pContext.mTypeAliases.back().mScopeLevel >= pContext.mScopeLevel)
+   const uint64_t preprocessStart = getProfilerTime();
+
+   // the tokens reference the code owned by the program, and they are not needed when the
+   // program can be read from the cache
+   if(mProgramCacheDirectory.empty() || !readProgramCacheHeader(*parsingContext))
    {
-      pContext.mTypeAliases.pop_back();
+      preprocess(*parsingContext, program->mCode.c_str());
    }
 
-   pContext.mLocalInstancesHolder.releaseInstances(pContext.mScopeLevel, isExecutionContext);
+   program->mLoadStats.mPreprocessTime = getProfilerTime() - preprocessStart;
 
-   pContext.mScopeLevel--;
+   return parsingContext;
 }
 
-void Environment::throwRuntimeError(ExecutionContext& pContext, RuntimeError pError, const char* pArg)
+void Environment::parseReload(ParsingContext* pParsingContext)
 {
-   if(!mErrorMessage.empty())
+   // Reloads which only change function bodies leave everything declared in namespace scope
+   // as it is, so they can be parsed without altering the environment, with shared access.
+   // Otherwise, the parsing stops, and the program gets parsed again when committed.
+   if(!CflatHasFlag(mSettings, Settings::IncrementalReload) ||
+      !pParsingContext->mErrorMessage.empty())
+   {
       return;
+   }
 
-   char errorMsg[kDefaultLocalStringBufferSize];
-   snprintf(errorMsg, sizeof(errorMsg), kRuntimeErrorStrings[(int)pError], pArg);
-
-   char lineAsString[kSmallLocalStringBufferSize];
-   snprintf(lineAsString, sizeof(lineAsString), "%d", pContext.mCallStack.back().mLine);
-
-   mErrorMessage.assign("[Runtime Error] '");
-   mErrorMessage.append(pContext.mProgram->mIdentifier.mName);
-   mErrorMessage.append("' -- Line ");
-   mErrorMessage.append(lineAsString);
-   mErrorMessage.append(": ");
-   mErrorMessage.append(errorMsg);
-}
+   Program* program = pParsingContext->mProgram;
+   ProgramsRegistry::const_iterator it = mPrograms.find(program->mIdentifier.mHash);
 
-void Environment::evaluateExpression(ExecutionContext& pContext, Expression* pExpression, Value* pOutValue)
-{
-   if(!mErrorMessage.empty())
+   if(it == mPrograms.end())
       return;
 
-   switch(pExpression->getType())
-   {
-   case ExpressionType::Value:
-      {
-         ExpressionValue* expression = static_cast<ExpressionValue*>(pExpression);
-         *pOutValue = expression->mValue;
-      }
-      break;
-   case ExpressionType::NullPointer:
-      {
-         assertValueInitialization(pContext, mTypeUsageVoidPtr, pOutValue);
-         const void* nullPointer = nullptr;
-         pOutValue->set(&nullPointer);
-      }
-      break;
-   case ExpressionType::VariableAccess:
-      {
-         ExpressionVariableAccess* expression = static_cast<ExpressionVariableAccess*>(pExpression);
-         Instance* instance = retrieveInstance(pContext, expression->mVariableIdentifier);
+   Memory::AllocatorScope allocatorScope(&mAllocator);
 
-         if(pOutValue->mTypeUsage.isPointer() && instance->mTypeUsage.isArray())
-         {
-            getAddressOfValue(pContext, instance->mValue, pOutValue);
-         }
-         else
-         {
-            *pOutValue = instance->mValue;
-         }
-      }
-      break;
-   case ExpressionType::MemberAccess:
-      {
-         ExpressionMemberAccess* expression = static_cast<ExpressionMemberAccess*>(pExpression);
+   ProgramLoadStats& loadStats = program->mLoadStats;
 
-         if(expression->mMemberAccessType == MemberAccessType::BitField)
-         {
-            Value instanceDataValue;
-            getInstanceDataValue(pContext, expression->mMemberOwner, &instanceDataValue);
+   // reloads need the tokens to find out what has changed
+   if(!pParsingContext->mCachedProgram.empty())
+   {
+      const uint64_t preprocessStart = getProfilerTime();
 
-            Struct* type = static_cast<Struct*>(instanceDataValue.mTypeUsage.mType);
-            BitField* bitField = type->findBitField(expression->mMemberIdentifier);
-            CflatAssert(bitField);
-            assertValueInitialization(pContext, bitField->mTypeUsage, pOutValue);
+      pParsingContext->mCachedProgram.clear();
+      pParsingContext->mMacros = MacrosHolder();
+      preprocess(*pParsingContext, program->mCode.c_str());
 
-            const int64_t bitFieldValue = bitField->getter(instanceDataValue.mValueBuffer);
-            setValueAsInteger(bitFieldValue, pOutValue);
-         }
-         else
-         {
-            getInstanceDataValue(pContext, expression, pOutValue);
-         }
-      }
-      break;
-   case ExpressionType::ArrayElementAccess:
-      {
-         ExpressionArrayElementAccess* expression =
-            static_cast<ExpressionArrayElementAccess*>(pExpression);
+      loadStats.mPreprocessTime += getProfilerTime() - preprocessStart;
 
-         const TypeUsage& arrayTypeUsage = getTypeUsage(expression->mArray);
-         CflatAssert(arrayTypeUsage.isArray() || arrayTypeUsage.isPointer());
+      if(!pParsingContext->mErrorMessage.empty())
+         return;
+   }
 
-         TypeUsage arrayElementTypeUsage = arrayTypeUsage;
+   indexFunctionBodies(*pParsingContext);
+   prepareIncrementalReload(*pParsingContext, it->second);
 
-         if(arrayElementTypeUsage.isArray())
-         {
-            CflatResetFlag(arrayElementTypeUsage.mFlags, TypeUsageFlags::Array);
-            arrayElementTypeUsage.mArraySize = 1u;
-         }
-         else
-         {
-            arrayElementTypeUsage.mPointerLevel--;
-         }
-         
-         assertValueInitialization(pContext, arrayElementTypeUsage, pOutValue);
+   if(!pParsingContext->mIncrementalReload)
+      return;
 
-         Value arrayValue;
-         arrayValue.mValueInitializationHint = ValueInitializationHint::Stack;
-         evaluateExpression(pContext, expression->mArray, &arrayValue);
+   const Memory::Usage allocatedBefore = mMemoryStats.mAccumulated.load();
+   const Memory::Usage programUsageBefore =
+      mMemoryStats.mCategories[(size_t)Memory::Category::Program].load();
 
-         Value indexValue;
-         indexValue.mValueInitializationHint = ValueInitializationHint::Stack;
-         evaluateExpression(pContext, expression->mArrayElementIndex, &indexValue);
-         const size_t index = (size_t)getValueAsInteger(indexValue);
-         
-         if(arrayValue.mTypeUsage.isArray())
-         {
-            const size_t arraySize = (size_t)arrayTypeUsage.mArraySize;
+   ProgramLoadStats* previousLoadingProgramStats = gLoadingProgramStats;
+   gLoadingProgramStats = &loadStats;
 
-            if(index < arraySize)
-            {
-               const size_t arrayElementSize = arrayElementTypeUsage.getSize();
-               const size_t offset = arrayElementSize * index;
-               pOutValue->set(arrayValue.mValueBuffer + offset);
-            }
-            else
-            {
-               char buffer[kDefaultLocalStringBufferSize];
-               snprintf(buffer, sizeof(buffer), "size %zu, index %zu", arraySize, index);
-               throwRuntimeError(pContext, RuntimeError::InvalidArrayIndex, buffer);
-            }
-         }
-         else
-         {
-            const size_t arrayElementTypeSize = arrayElementTypeUsage.getSize();
-            const size_t ptrOffset = arrayElementTypeSize * index;
-            const char* ptr = CflatValueAs(&arrayValue, char*) + ptrOffset;
-            memcpy(pOutValue->mValueBuffer, ptr, arrayElementTypeSize);
-         }
-      }
-      break;
-   case ExpressionType::UnaryOperation:
-      {
-         ExpressionUnaryOperation* expression = static_cast<ExpressionUnaryOperation*>(pExpression);
+   const uint64_t parseStart = getProfilerTime();
 
-         const TypeUsage& typeUsage = getTypeUsage(expression);
-         assertValueInitialization(pContext, typeUsage, pOutValue);
+   pParsingContext->mSharedAccess = true;
+   pParsingContext->mWriteAccessGeneration = mWriteAccessGeneration;
 
-         Value operand;
+   {
+      Memory::CategoryScope categoryScope(Memory::Category::Program);
+      parse(*pParsingContext);
+   }
 
-         const bool isIndirection = expression->mOperator[0] == '*';
+   pParsingContext->mSharedAccess = false;
+   pParsingContext->mParsed = true;
 
-         if(isIndirection)
-         {
-            operand.mValueInitializationHint = ValueInitializationHint::Stack; 
-         }
-         else
-         {
-            operand.initExternal(getTypeUsage(expression->mExpression));
-         }
+   loadStats.mParseTime += getProfilerTime() - parseStart;
+   gLoadingProgramStats = previousLoadingProgramStats;
 
-         evaluateExpression(pContext, expression->mExpression, &operand);
+   const Memory::Usage programUsageAfter =
+      mMemoryStats.mCategories[(size_t)Memory::Category::Program].load();
+   program->mMemoryUsage.mBytes += programUsageAfter.mBytes - programUsageBefore.mBytes;
+   program->mMemoryUsage.mAllocations +=
+      programUsageAfter.mAllocations - programUsageBefore.mAllocations;
 
-         const bool isIncrementOrDecrement =
-            strncmp(expression->mOperator, "++", 2u) == 0 ||
-            strncmp(expression->mOperator, "--", 2u) == 0;
+   const Memory::Usage allocatedAfter = mMemoryStats.mAccumulated.load();
+   loadStats.mAllocated.mBytes += allocatedAfter.mBytes - allocatedBefore.mBytes;
+   loadStats.mAllocated.mAllocations += allocatedAfter.mAllocations - allocatedBefore.mAllocations;
+}
 
-         if(isIncrementOrDecrement)
-         {
-            pOutValue->set(operand.mValueBuffer);
+static void countDeclarations(const Statement* pStatement, ProgramLoadStats* pOutStats)
+{
+   if(!pStatement)
+      return;
 
-            applyUnaryOperator(pContext, operand, expression->mOperator, &operand);
+   switch(pStatement->getType())
+   {
+   case StatementType::Block:
+      {
+         const StatementBlock* statement = static_cast<const StatementBlock*>(pStatement);
 
-            if(!expression->mPostOperator)
-            {
-               pOutValue->set(operand.mValueBuffer);
-            }
-         }
-         else
+         for(size_t i = 0u; i < statement->mStatements.size(); i++)
          {
-            applyUnaryOperator(pContext, operand, expression->mOperator, pOutValue);
+            countDeclarations(statement->mStatements[i], pOutStats);
          }
       }
       break;
-   case ExpressionType::BinaryOperation:
+   case StatementType::NamespaceDeclaration:
       {
-         ExpressionBinaryOperation* expression = static_cast<ExpressionBinaryOperation*>(pExpression);
+         const StatementNamespaceDeclaration* statement =
+            static_cast<const StatementNamespaceDeclaration*>(pStatement);
+         countDeclarations(statement->mBody, pOutStats);
+      }
+      break;
+   case StatementType::FunctionDeclaration:
+      pOutStats->mFunctionsCount++;
+      break;
+   case StatementType::StructDeclaration:
+      {
+         const StatementStructDeclaration* statement =
+            static_cast<const StatementStructDeclaration*>(pStatement);
+         pOutStats->mTypesCount++;
+         pOutStats->mFunctionsCount += (uint32_t)statement->mStruct->mMethods.size();
+      }
+      break;
+   default:
+      break;
+   }
+}
 
-         const TypeUsage& typeUsage = getTypeUsage(expression);
-         assertValueInitialization(pContext, typeUsage, pOutValue);
+bool Environment::commitProgram(ParsingContext* pParsingContext)
+{
+   Memory::AllocatorScope allocatorScope(&mAllocator);
 
-         Value leftValue;
-         leftValue.mValueInitializationHint = ValueInitializationHint::Stack;
-         evaluateExpression(pContext, expression->mLeft, &leftValue);
+   const Memory::Usage allocatedBefore = mMemoryStats.mAccumulated.load();
 
-         Value rightValue;
-         bool evaluateRightValue = true;
+   // a reload parsed with shared access is only valid as long as the environment has not been
+   // altered since, and as long as it has not required write access itself
+   const bool parsingDiscarded = pParsingContext->mParsed &&
+      (pParsingContext->mWriteAccessRequired ||
+         pParsingContext->mWriteAccessGeneration != mWriteAccessGeneration);
 
-         if(strcmp(expression->mOperator, "&&") == 0)
-         {
-            if(!getValueAsInteger(leftValue))
-            {
-               const bool value = false;
-               rightValue.initOnStack(mTypeUsageBool, &pContext.mStack);
-               rightValue.set(&value);
-               evaluateRightValue = false;
-            }
-         }
-         else if(strcmp(expression->mOperator, "||") == 0)
-         {
-            if(getValueAsInteger(leftValue))
-            {
-               const bool value = true;
-               rightValue.initOnStack(mTypeUsageBool, &pContext.mStack);
-               rightValue.set(&value);
-               evaluateRightValue = false;
-            }
-         }
+   if(pParsingContext->mMacrosGeneration != mMacrosGeneration || parsingDiscarded)
+   {
+      // the macros have changed since the program was prepared, or it has to be parsed again
+      Program* preparedProgram = pParsingContext->mProgram;
+      ParsingContext* parsingContext =
+         prepareProgram(preparedProgram->mIdentifier.mName, preparedProgram->mCode.c_str());
+
+      CflatInvokeDtor(ParsingContext, pParsingContext);
+      CflatFree(pParsingContext);
+      CflatInvokeDtor(Program, preparedProgram);
+      CflatFree(preparedProgram);
 
-         if(evaluateRightValue)
-         {
-            rightValue.mValueInitializationHint = ValueInitializationHint::Stack;
-            evaluateExpression(pContext, expression->mRight, &rightValue);
-         }
+      pParsingContext = parsingContext;
+   }
 
-         applyBinaryOperator(pContext, leftValue, rightValue, expression->mOperator, pOutValue);
+   Program* previousProgram = nullptr;
+
+   if(CflatHasFlag(mSettings, Settings::IncrementalReload))
+   {
+      ProgramsRegistry::const_iterator it =
+         mPrograms.find(pParsingContext->mProgram->mIdentifier.mHash);
+
+      if(it != mPrograms.end())
+      {
+         previousProgram = it->second;
       }
-      break;
-   case ExpressionType::Parenthesized:
+   }
+
+   Hash bindingsFingerprint = 0u;
+
+   if(!mProgramCacheDirectory.empty() || previousProgram)
+   {
+      if(!mProgramCacheDirectory.empty())
       {
-         ExpressionParenthesized* expression = static_cast<ExpressionParenthesized*>(pExpression);
-         evaluateExpression(pContext, expression->mExpression, pOutValue);
+         bindingsFingerprint = getBindingsFingerprint();
       }
-      break;
-   case ExpressionType::SizeOf:
+
+      // the cached program might reference bindings which are not there anymore, and reloads
+      // need the tokens to find out what has changed
+      if(!pParsingContext->mCachedProgram.empty() &&
+         (previousProgram || pParsingContext->mCachedBindingsFingerprint != bindingsFingerprint))
       {
-         ExpressionSizeOf* expression = static_cast<ExpressionSizeOf*>(pExpression);
-         size_t size = 0u;
-         
-         if(expression->mSizeOfTypeUsage.mType)
-         {
-            size = expression->mSizeOfTypeUsage.getSize();
-         }
-         else if(expression->mSizeOfExpression)
-         {
-            Value value;
-            value.mValueInitializationHint = ValueInitializationHint::Stack;
-            evaluateExpression(pContext, expression->mSizeOfExpression, &value);
-            size = value.mTypeUsage.getSize();
-         }
+         const uint64_t preprocessStart = getProfilerTime();
 
-         assertValueInitialization(pContext, mTypeUsageSizeT, pOutValue);
-         pOutValue->set(&size);
+         pParsingContext->mCachedProgram.clear();
+         pParsingContext->mMacros = MacrosHolder();
+         preprocess(*pParsingContext, pParsingContext->mProgram->mCode.c_str());
+
+         pParsingContext->mProgram->mLoadStats.mPreprocessTime += getProfilerTime() - preprocessStart;
       }
-      break;
-   case ExpressionType::Cast:
+   }
+
+   const CflatSTLVector(Macro)& definedMacros = pParsingContext->mMacros.getMacros();
+
+   if(!definedMacros.empty())
+   {
+      mMacrosLock.lock();
+
+      for(size_t i = 0u; i < definedMacros.size(); i++)
       {
-         ExpressionCast* expression = static_cast<ExpressionCast*>(pExpression);
+         mMacros.registerMacro(definedMacros[i]);
+      }
 
-         assertValueInitialization(pContext, expression->getTypeUsage(), pOutValue);
+      mMacrosGeneration++;
+      mMacrosLock.unlock();
+   }
 
-         Value valueToCast;
-         valueToCast.mValueInitializationHint = ValueInitializationHint::Stack;
-         evaluateExpression(pContext, expression->mExpression, &valueToCast);
+   Program* program = pParsingContext->mProgram;
+   const Identifier programIdentifier = program->mIdentifier;
 
-         const TypeUsage& targetTypeUsage = expression->getTypeUsage();
+   mErrorMessage.assign(pParsingContext->mErrorMessage);
 
-         if(targetTypeUsage == mTypeUsageVoid)
-         {
-            // Ignore the result of the expression in void casts
-         }
-         else if(valueToCast.mTypeUsage == mTypeUsageVoidPtr ||
-            targetTypeUsage == mTypeUsageVoidPtr ||
-            expression->mCastType == CastType::Reinterpret)
+   const Memory::Usage programUsageBefore =
+      mMemoryStats.mCategories[(size_t)Memory::Category::Program].load();
+
+   bool incrementalReload = false;
+
+   ProgramLoadStats& loadStats = program->mLoadStats;
+   ProgramLoadStats* previousLoadingProgramStats = gLoadingProgramStats;
+   gLoadingProgramStats = &loadStats;
+
+   const uint64_t parseStart = getProfilerTime();
+   uint64_t parsePreprocessTime = 0u;
+
+   {
+      Memory::CategoryScope categoryScope(Memory::Category::Program);
+
+      if(!pParsingContext->mCachedProgram.empty() && !readProgramCache(*pParsingContext))
+      {
+         // the tokens are only needed while parsing, so they are not accounted as program memory
+         Memory::CategoryScope generalCategoryScope(Memory::Category::General);
+
+         // the nodes read until the cache was found to be invalid have been released
+         loadStats.mStatementsCount = 0u;
+         loadStats.mExpressionsCount = 0u;
+
+         const uint64_t preprocessStart = getProfilerTime();
+         preprocess(*pParsingContext, program->mCode.c_str());
+         parsePreprocessTime = getProfilerTime() - preprocessStart;
+
+         mErrorMessage.assign(pParsingContext->mErrorMessage);
+      }
+
+      loadStats.mTokensCount = (uint32_t)pParsingContext->mTokens.size();
+
+      if(!program->mLoadedFromCache && mErrorMessage.empty())
+      {
+         // reloads might have been parsed already, with shared access
+         if(!pParsingContext->mParsed)
          {
-            const void* ptr = CflatValueAs(&valueToCast, void*);
-            pOutValue->set(&ptr);
+            if(CflatHasFlag(mSettings, Settings::IncrementalReload) ||
+               CflatHasFlag(mSettings, Settings::LazyFunctionBodies))
+            {
+               indexFunctionBodies(*pParsingContext);
+
+               if(previousProgram)
+               {
+                  prepareIncrementalReload(*pParsingContext, previousProgram);
+               }
+            }
+
+            parse(*pParsingContext);
          }
-         else if(expression->mCastType == CastType::CStyle || expression->mCastType == CastType::Static)
+
+         mErrorMessage.assign(pParsingContext->mErrorMessage);
+
+         if(program->mDeferredFunctionBodiesCount > 0u && mErrorMessage.empty())
          {
-            performStaticCast(pContext, valueToCast, targetTypeUsage, pOutValue);
+            retainDeferredTokens(*pParsingContext);
          }
-         else if(expression->mCastType == CastType::Dynamic)
+
+         if(pParsingContext->mIncrementalReload)
          {
-            performInheritanceCast(pContext, valueToCast, targetTypeUsage, pOutValue);
+            incrementalReload = true;
+
+            if(mErrorMessage.empty())
+            {
+               keepUnchangedFunctionDeclarations(*pParsingContext);
+            }
          }
-         else if(expression->mCastType == CastType::Const)
+         // the program is not complete without the kept declarations of the previous version,
+         // nor without the deferred function bodies
+         else if(!mProgramCacheDirectory.empty() && mErrorMessage.empty() &&
+            program->mDeferredFunctionBodiesCount == 0u)
          {
-            *pOutValue = valueToCast;
-            pOutValue->mTypeUsage.mFlags = expression->getTypeUsage().mFlags;
+            writeProgramCache(*pParsingContext, bindingsFingerprint);
          }
       }
-      break;
-   case ExpressionType::Conditional:
+
+      CflatInvokeDtor(ParsingContext, pParsingContext);
+      CflatFree(pParsingContext);
+   }
+
+   gLoadingProgramStats = previousLoadingProgramStats;
+
+   loadStats.mPreprocessTime += parsePreprocessTime;
+   loadStats.mParseTime += getProfilerTime() - parseStart - parsePreprocessTime;
+
+   if(mErrorMessage.empty())
+   {
+      for(size_t i = 0u; i < program->mStatements.size(); i++)
       {
-         ExpressionConditional* expression = static_cast<ExpressionConditional*>(pExpression);
+         countDeclarations(program->mStatements[i], &loadStats);
+      }
+   }
 
-         bool conditionMet = false;
-         {
-            Value conditionValue;
-            conditionValue.mValueInitializationHint = ValueInitializationHint::Stack;
-            evaluateExpression(pContext, expression->mCondition, &conditionValue);
-            conditionMet = getValueAsInteger(conditionValue) != 0;
-         }
+   // the parsing context has already been released at this point, so that only
+   // the memory owned by the program remains accounted in the category
+   const Memory::Usage programUsageAfter =
+      mMemoryStats.mCategories[(size_t)Memory::Category::Program].load();
+   program->mMemoryUsage.mBytes += programUsageAfter.mBytes - programUsageBefore.mBytes;
+   program->mMemoryUsage.mAllocations +=
+      programUsageAfter.mAllocations - programUsageBefore.mAllocations;
 
-         assertValueInitialization(pContext, expression->getTypeUsage(), pOutValue);
+   if(!mErrorMessage.empty())
+   {
+      CflatInvokeDtor(Program, program);
+      CflatFree(program);
 
-         Expression* valueSource = conditionMet
-            ? expression->mIfExpression
-            : expression->mElseExpression;
+      return false;
+   }
 
-         Value expressionValue;
-         expressionValue.mValueInitializationHint = ValueInitializationHint::Stack;
-         evaluateExpression(pContext, valueSource, &expressionValue);
-         assignValue(pContext, expressionValue, pOutValue, false);
+   ProgramsRegistry::const_iterator it = mPrograms.find(programIdentifier.mHash);
+
+   if(it != mPrograms.end())
+   {
+      // the previous version might still be referenced by the call stack, in case
+      // the program is being loaded from a script function call
+      mRetiredPrograms.push_back(it->second);
+   }
+
+   mPrograms[programIdentifier.mHash] = program;
+
+   // compiled expressions might reference types and functions from the previous version
+   releaseCompiledExpressions();
+
+   if(mLineCountingEnabled)
+   {
+      allocateLineCounters(program);
+   }
+
+   const uint64_t executeStart = getProfilerTime();
+
+   {
+      Memory::CategoryScope categoryScope(Memory::Category::Execution);
+
+      if(incrementalReload)
+      {
+         executeReloaded(mExecutionContext, *program);
       }
-      break;
-   case ExpressionType::Assignment:
+      else
       {
-         ExpressionAssignment* expression = static_cast<ExpressionAssignment*>(pExpression);
+         execute(mExecutionContext, *program);
+      }
+   }
 
-         const TypeUsage& expressionTypeUsage = getTypeUsage(expression->mRightValue);
-         Value expressionValue;
-         expressionValue.initOnStack(expressionTypeUsage, &pContext.mStack);
-         evaluateExpression(pContext, expression->mRightValue, &expressionValue);
+   loadStats.mExecuteTime = getProfilerTime() - executeStart;
+   const Memory::Usage allocatedAfter = mMemoryStats.mAccumulated.load();
+   loadStats.mAllocated.mBytes += allocatedAfter.mBytes - allocatedBefore.mBytes;
+   loadStats.mAllocated.mAllocations += allocatedAfter.mAllocations - allocatedBefore.mAllocations;
 
-         Expression* instancedDataExpression = expression->mLeftValue;
-         bool bitFieldAssignment = false;
+   // suspended calls might still be referencing the replaced programs
+   if(mExecutionContext.mCallStack.empty() && !hasSuspendedCalls())
+   {
+      releaseRetiredPrograms();
+   }
 
-         if(expression->mLeftValue->getType() == ExpressionType::MemberAccess)
-         {
-            ExpressionMemberAccess* memberAccess =
-               static_cast<ExpressionMemberAccess*>(expression->mLeftValue);
-            bitFieldAssignment = memberAccess->mMemberAccessType == MemberAccessType::BitField;
+   return mErrorMessage.empty();
+}
 
-            if(bitFieldAssignment)
-            {
-               instancedDataExpression = memberAccess->mMemberOwner;
-            }
-         }
+// Macros registered by one of the programs of a batch load, along with the macros generation
+// their registration led to
+struct LoadedProgramMacros
+{
+   uint32_t mMacrosGeneration;
+   CflatSTLVector(CflatSTLString) mNames;
+   // the names are not known for programs which got prepared again when committed
+   bool mNamesKnown;
+};
 
-         const TypeUsage& instancedDataTypeUsage = getTypeUsage(instancedDataExpression);
-         Value instanceDataValue;
-         instanceDataValue.initExternal(instancedDataTypeUsage);
-         getInstanceDataValue(pContext, expression->mLeftValue, &instanceDataValue);
+// Whether the code might use any of the macros registered since it was prepared, which needs
+// it to be prepared again. Only the macros of the programs committed before it in the same
+// batch can be checked, the ones registered from elsewhere in the meantime count as used.
+static bool mightUseMacrosSince(const char* pCode, uint32_t pPreparedMacrosGeneration,
+   uint32_t pCurrentMacrosGeneration, const CflatSTLVector(LoadedProgramMacros)& pLoadedMacros)
+{
+   uint32_t checkedGenerationsCount = 0u;
 
-         if(instanceDataValue.mValueBuffer)
-         {
-            if(bitFieldAssignment)
-            {
-               ExpressionMemberAccess* memberAccess =
-                  static_cast<ExpressionMemberAccess*>(expression->mLeftValue);
+   for(size_t i = 0u; i < pLoadedMacros.size(); i++)
+   {
+      const LoadedProgramMacros& loadedMacros = pLoadedMacros[i];
 
-               Struct* type = static_cast<Struct*>(instancedDataTypeUsage.mType);
-               BitField* bitField = type->findBitField(memberAccess->mMemberIdentifier);
-               CflatAssert(bitField);
-               const int64_t bitFieldValue = getValueAsInteger(expressionValue);
-               bitField->setter(instanceDataValue.mValueBuffer, bitFieldValue);
-            }
-            else
-            {
-               performAssignment(pContext, expressionValue, expression->mOperator, &instanceDataValue);
-               *pOutValue = instanceDataValue;
-            }
-         }
-      }
-      break;
-   case ExpressionType::FunctionCall:
+      if(loadedMacros.mMacrosGeneration <= pPreparedMacrosGeneration)
+         continue;
+
+      if(!loadedMacros.mNamesKnown)
+         return true;
+
+      for(size_t j = 0u; j < loadedMacros.mNames.size(); j++)
       {
-         ExpressionFunctionCall* expression = static_cast<ExpressionFunctionCall*>(pExpression);
+         if(strstr(pCode, loadedMacros.mNames[j].c_str()))
+            return true;
+      }
 
-         Function* function = expression->mFunction;
-         CflatAssert(function);
+      checkedGenerationsCount++;
+   }
 
-         if(function->execute)
-         {
-            assertValueInitialization(pContext, function->mReturnTypeUsage, pOutValue);
+   return checkedGenerationsCount != pCurrentMacrosGeneration - pPreparedMacrosGeneration;
+}
 
-            CflatArgsVector(Value) argumentValues;
-            getArgumentValues(pContext, function->mParameters, expression->mArguments, argumentValues);
+bool Environment::loadPrograms(const char* const* pProgramNames, const char* const* pCodes,
+   size_t pCount, CflatSTLVector(CflatSTLString)* pOutErrorMessages)
+{
+   // The workers are shared by all the batches
+   std::lock_guard<std::mutex> batchLock(mLoadBatchMutex);
+   Memory::AllocatorScope allocatorScope(&mAllocator);
 
-            if(mErrorMessage.empty())
-            {
-               CflatArgsVector(Value) preparedArgumentValues;
-               prepareArgumentsForFunctionCall(pContext, function->mParameters, argumentValues,
-                  preparedArgumentValues);
+   if(pOutErrorMessages)
+   {
+      pOutErrorMessages->clear();
+      pOutErrorMessages->resize(pCount);
+   }
 
-               const bool functionReturnValueIsConst =
-                  CflatHasFlag(function->mReturnTypeUsage.mFlags, TypeUsageFlags::Const);
-               const bool outValueIsConst =
-                  CflatHasFlag(pOutValue->mTypeUsage.mFlags, TypeUsageFlags::Const);
+   if(pCount == 0u)
+   {
+      AccessScope accessScope(this, AccessType::Write);
+      mErrorMessage.clear();
+      return true;
+   }
 
-               if(outValueIsConst && !functionReturnValueIsConst)
-               {
-                  CflatResetFlag(pOutValue->mTypeUsage.mFlags, TypeUsageFlags::Const);
-               }
+   LoadBatch batch;
+   batch.mProgramNames = pProgramNames;
+   batch.mCodes = pCodes;
+   batch.mCount = pCount;
+   batch.mNextProgramIndex.store(0u);
+   batch.mParsingContexts.resize(pCount, nullptr);
+   batch.mPrepared.resize(pCount, false);
 
-               function->execute(preparedArgumentValues, pOutValue);
+   const size_t hardwareThreadsCount = (size_t)std::thread::hardware_concurrency();
+   requestLoadWorkers(hardwareThreadsCount > 1u ? std::min(hardwareThreadsCount, pCount) : 1u);
 
-               if(outValueIsConst && !functionReturnValueIsConst)
-               {
-                  CflatSetFlag(pOutValue->mTypeUsage.mFlags, TypeUsageFlags::Const);
-               }
+   // Workers preprocess and tokenize the programs in any order, while this thread parses and
+   // executes them in the order they were given, as soon as each of them is ready
+   {
+      std::lock_guard<std::mutex> lock(mLoadMutex);
+      batch.mPendingWorkers = mLoadThreads.size();
+      mLoadBatch = &batch;
+      mLoadBatchGeneration++;
+      mLoadBatchCondition.notify_all();
+   }
+
+   CflatSTLVector(LoadedProgramMacros) loadedMacros;
+
+   bool success = true;
+   CflatSTLString firstErrorMessage;
+
+   for(size_t i = 0u; i < pCount; i++)
+   {
+      ParsingContext* parsingContext = nullptr;
+
+      {
+         std::unique_lock<std::mutex> lock(mLoadMutex);
+         mLoadPreparedCondition.wait(lock, [&batch, i]() { return (bool)batch.mPrepared[i]; });
+         parsingContext = batch.mParsingContexts[i];
+      }
+
+      AccessScope accessScope(this, AccessType::Write);
+
+      if(parsingContext)
+      {
+         // programs prepared before the previous ones of the batch registered their macros only
+         // get prepared again in case they might use them
+         if(parsingContext->mMacrosGeneration != mMacrosGeneration &&
+            !mightUseMacrosSince(parsingContext->mProgram->mCode.c_str(),
+               parsingContext->mMacrosGeneration, mMacrosGeneration, loadedMacros))
+         {
+            parsingContext->mMacrosGeneration = mMacrosGeneration;
+         }
+
+         const uint32_t macrosGenerationBefore = mMacrosGeneration;
 
-               while(!preparedArgumentValues.empty())
-               {
-                  preparedArgumentValues.pop_back();
-               }
-            }
+         LoadedProgramMacros programMacros;
+         programMacros.mNamesKnown = parsingContext->mMacrosGeneration == mMacrosGeneration;
 
-            while(!argumentValues.empty())
-            {
-               argumentValues.pop_back();
-            }
+         const CflatSTLVector(Macro)& definedMacros = parsingContext->mMacros.getMacros();
+
+         for(size_t j = 0u; j < definedMacros.size(); j++)
+         {
+            programMacros.mNames.push_back(definedMacros[j].mName);
          }
-         else
+
+         commitProgram(parsingContext);
+
+         if(mMacrosGeneration != macrosGenerationBefore)
          {
-            throwRuntimeError(pContext, RuntimeError::MissingFunctionImplementation,
-               function->mIdentifier.mName);
+            programMacros.mMacrosGeneration = mMacrosGeneration;
+            loadedMacros.push_back(programMacros);
          }
       }
-      break;
-   case ExpressionType::MethodCall:
+      else
       {
-         ExpressionMethodCall* expression = static_cast<ExpressionMethodCall*>(pExpression);
-         ExpressionMemberAccess* memberAccess =
-            static_cast<ExpressionMemberAccess*>(expression->mMemberAccess);
-
-         Method* method = expression->mMethodUsage.mMethod;
-         CflatAssert(method);
-
-         assertValueInitialization(pContext, method->mReturnTypeUsage, pOutValue);
+         mErrorMessage.assign("[Load Error] '");
+         mErrorMessage.append(pProgramNames[i]);
+         mErrorMessage.append("': the file could not be read");
+      }
 
-         Value instanceDataValue;
-         getInstanceDataValue(pContext, memberAccess->mMemberOwner, &instanceDataValue);
+      if(!mErrorMessage.empty())
+      {
+         if(success)
+         {
+            firstErrorMessage.assign(mErrorMessage);
+            success = false;
+         }
 
-         if(instanceDataValue.mTypeUsage.isPointer() && !CflatValueAs(&instanceDataValue, void*))
+         if(pOutErrorMessages)
          {
-            throwRuntimeError(pContext, RuntimeError::NullPointerAccess,
-               memberAccess->mMemberIdentifier.mName);
+            (*pOutErrorMessages)[i].assign(mErrorMessage);
          }
+      }
+   }
 
-         if(!mErrorMessage.empty())
-            break;
+   {
+      std::unique_lock<std::mutex> lock(mLoadMutex);
+      mLoadPreparedCondition.wait(lock, [&batch]() { return batch.mPendingWorkers == 0u; });
+      mLoadBatch = nullptr;
+   }
 
-         CflatArgsVector(Value) argumentValues;
-         getArgumentValues(pContext, method->mParameters, expression->mArguments, argumentValues);
+   AccessScope accessScope(this, AccessType::Write);
+   mErrorMessage.assign(firstErrorMessage);
 
-         if(mErrorMessage.empty())
-         {
-            CflatArgsVector(Value) preparedArgumentValues;
-            prepareArgumentsForFunctionCall(pContext, method->mParameters, argumentValues,
-               preparedArgumentValues);
+   return success;
+}
 
-            {
-               Value thisPtr;
+void Environment::requestLoadWorkers(size_t pWorkersCount)
+{
+   while(mLoadThreads.size() < pWorkersCount)
+   {
+      std::thread* thread = (std::thread*)CflatMalloc(sizeof(std::thread));
+      CflatInvokeCtor(std::thread, thread)
+         (&Environment::runLoadWorkerThread, this, mLoadBatchGeneration);
+      mLoadThreads.push_back(thread);
+   }
+}
 
-               if(instanceDataValue.mTypeUsage.isPointer())
-               {
-                  thisPtr.initOnStack(instanceDataValue.mTypeUsage, &pContext.mStack);
-                  thisPtr.set(instanceDataValue.mValueBuffer);
-               }
-               else
-               {
-                  thisPtr.mValueInitializationHint = ValueInitializationHint::Stack;
-                  getAddressOfValue(pContext, instanceDataValue, &thisPtr);
-               }
+void Environment::releaseLoadWorkers()
+{
+   {
+      std::lock_guard<std::mutex> lock(mLoadMutex);
+      mLoadShutdown = true;
+      mLoadBatchCondition.notify_all();
+   }
 
-               if(expression->mMethodUsage.mOffset > 0u)
-               {
-                  const char* offsetThisPtr =
-                     CflatValueAs(&thisPtr, char*) + expression->mMethodUsage.mOffset;
-                  memcpy(thisPtr.mValueBuffer, &offsetThisPtr, sizeof(char*));
-               }
+   for(size_t i = 0u; i < mLoadThreads.size(); i++)
+   {
+      mLoadThreads[i]->join();
+      CflatInvokeDtor(thread, mLoadThreads[i]);
+      CflatFree(mLoadThreads[i]);
+   }
 
-               method->execute(thisPtr, preparedArgumentValues, pOutValue);
-            }
+   mLoadThreads.clear();
+}
 
-            while(!preparedArgumentValues.empty())
-            {
-               preparedArgumentValues.pop_back();
-            }
-         }
+void Environment::runLoadWorkerThread(uint32_t pBatchGeneration)
+{
+   uint32_t lastBatchGeneration = pBatchGeneration;
 
-         while(!argumentValues.empty())
+   for(;;)
+   {
+      LoadBatch* batch = nullptr;
+
+      {
+         std::unique_lock<std::mutex> lock(mLoadMutex);
+         mLoadBatchCondition.wait(lock, [this, lastBatchGeneration]()
          {
-            argumentValues.pop_back();
-         }
+            return mLoadShutdown || mLoadBatchGeneration != lastBatchGeneration;
+         });
+
+         if(mLoadShutdown)
+            return;
+
+         lastBatchGeneration = mLoadBatchGeneration;
+         batch = mLoadBatch;
       }
-      break;
-   case ExpressionType::ArrayInitialization:
-      {
-         ExpressionArrayInitialization* expression =
-            static_cast<ExpressionArrayInitialization*>(pExpression);
 
-         assertValueInitialization(pContext, expression->getTypeUsage(), pOutValue);
+      // the loading thread waits for all the workers before releasing the batch
+      prepareLoadBatch(*batch);
 
-         const size_t arrayElementSize = expression->mElementTypeUsage.getSize();
+      std::lock_guard<std::mutex> lock(mLoadMutex);
+      batch->mPendingWorkers--;
+      mLoadPreparedCondition.notify_all();
+   }
+}
 
-         for(size_t i = 0u; i < expression->mValues.size(); i++)
+void Environment::prepareLoadBatch(LoadBatch& pBatch)
+{
+   Memory::AllocatorScope allocatorScope(&mAllocator);
+
+   for(size_t i = pBatch.mNextProgramIndex++; i < pBatch.mCount; i = pBatch.mNextProgramIndex++)
+   {
+      ParsingContext* parsingContext = nullptr;
+
+      {
+         // as for single loads, programs get prepared without blocking readers nor executions
+         AccessScope accessScope(this, AccessType::Read);
+
+         if(pBatch.mCodes)
          {
-            Value arrayElementValue;
-            arrayElementValue.initOnStack(expression->mElementTypeUsage, &pContext.mStack);
-            evaluateExpression(pContext, expression->mValues[i], &arrayElementValue);
+            parsingContext = prepareProgram(pBatch.mProgramNames[i], pBatch.mCodes[i]);
+         }
+         else
+         {
+            char* code = readFile(pBatch.mProgramNames[i]);
 
-            const size_t offset = i * arrayElementSize;
-            memcpy(pOutValue->mValueBuffer + offset, arrayElementValue.mValueBuffer, arrayElementSize);
+            if(code)
+            {
+               parsingContext = prepareProgram(pBatch.mProgramNames[i], code);
+               CflatFree(code);
+            }
          }
       }
-      break;
-   case ExpressionType::AggregateInitialization:
-      {
-         ExpressionAggregateInitialization* expression =
-            static_cast<ExpressionAggregateInitialization*>(pExpression);
 
-         assertValueInitialization(pContext, expression->getTypeUsage(), pOutValue);
+      std::lock_guard<std::mutex> lock(mLoadMutex);
+      pBatch.mParsingContexts[i] = parsingContext;
+      pBatch.mPrepared[i] = true;
+      mLoadPreparedCondition.notify_all();
+   }
+}
 
-         Struct* type = static_cast<Struct*>(expression->getTypeUsage().mType);
-         CflatAssert(type->mMembers.size() >= expression->mValues.size());
+static bool isPunctuationToken(const Token& pToken, char pCharacter)
+{
+   return pToken.mType == TokenType::Punctuation && pToken.mLength == 1u &&
+      pToken.mStart[0] == pCharacter;
+}
 
-         Value objectPtrValue;
-         getAddressOfValue(pContext, *pOutValue, &objectPtrValue);
-         void* objectPtr = CflatValueAs(&objectPtrValue, void*);
+static bool isKeywordToken(const Token& pToken, const char* pKeyword)
+{
+   return pToken.mType == TokenType::Keyword && pToken.mLength == strlen(pKeyword) &&
+      strncmp(pToken.mStart, pKeyword, pToken.mLength) == 0;
+}
 
-         for(size_t i = 0u; i < expression->mValues.size(); i++)
-         {
-            Value memberValue;
-            memberValue.mValueInitializationHint = ValueInitializationHint::Stack;
-            evaluateExpression(pContext, expression->mValues[i], &memberValue);
+static bool isOperatorToken(const Token& pToken, char pCharacter)
+{
+   return pToken.mType == TokenType::Operator && pToken.mLength == 1u &&
+      pToken.mStart[0] == pCharacter;
+}
 
-            Member* member = type->mMembers[i];
-            CflatAssert(member->mMemberType == MemberType::Field);
-            Field* field = static_cast<Field*>(member);
+// Whether parsing the function body would register anything in the environment, which is the
+// case for local structs and namespaces, and for arrays whose size has to be evaluated. Array
+// accesses right after a type-like token count as such declarations as well.
+static bool isRegisteringFunctionBody(const CflatSTLVector(Token)& pTokens,
+   size_t pOpeningTokenIndex, size_t pClosureTokenIndex)
+{
+   for(size_t i = pOpeningTokenIndex + 1u; i < pClosureTokenIndex; i++)
+   {
+      const Token& token = pTokens[i];
 
-            char* objectMemberPtr = (char*)objectPtr + (size_t)field->mOffset;
-            const size_t objectMemberSize = field->mTypeUsage.getSize();
-            memcpy(objectMemberPtr, memberValue.mValueBuffer, objectMemberSize);
-         }
+      if(isKeywordToken(token, "struct") || isKeywordToken(token, "class") ||
+         isKeywordToken(token, "namespace"))
+      {
+         return true;
       }
-      break;
-   case ExpressionType::ObjectConstruction:
+
+      if(isPunctuationToken(token, '[') &&
+         pTokens[i - 1u].mType == TokenType::Identifier &&
+         (pTokens[i - 2u].mType == TokenType::Identifier ||
+            pTokens[i - 2u].mType == TokenType::Keyword ||
+            isOperatorToken(pTokens[i - 2u], '*') ||
+            isOperatorToken(pTokens[i - 2u], '&') ||
+            isOperatorToken(pTokens[i - 2u], '>')))
       {
-         ExpressionObjectConstruction* expression =
-            static_cast<ExpressionObjectConstruction*>(pExpression);
+         const bool literalSize = isPunctuationToken(pTokens[i + 1u], ']') ||
+            (pTokens[i + 1u].mType == TokenType::Number && isPunctuationToken(pTokens[i + 2u], ']'));
 
-         Method* ctor = expression->mConstructor;
-         CflatAssert(ctor);
+         if(!literalSize)
+         {
+            return true;
+         }
+      }
+   }
 
-         assertValueInitialization(pContext, expression->getTypeUsage(), pOutValue);
+   return false;
+}
 
-         CflatArgsVector(Value) argumentValues;
-         getArgumentValues(pContext, ctor->mParameters, expression->mArguments, argumentValues);
+static void addToCodeFingerprint(uint64_t* pFingerprint, const Token& pToken)
+{
+   const uint8_t tokenType = (uint8_t)pToken.mType;
+   addToCodeFingerprint(pFingerprint, &tokenType, sizeof(tokenType));
+   addToCodeFingerprint(pFingerprint, &pToken.mLength, sizeof(pToken.mLength));
+   addToCodeFingerprint(pFingerprint, pToken.mStart, pToken.mLength);
+}
 
-         CflatArgsVector(Value) preparedArgumentValues;
-         prepareArgumentsForFunctionCall(pContext, ctor->mParameters, argumentValues,
-            preparedArgumentValues);
+// Function declarations in namespace scope, in the order they appear in the code
+static void collectFunctionDeclarations(CflatSTLVector(Statement*)& pStatements,
+   CflatSTLVector(Statement**)* pOutStatements)
+{
+   for(size_t i = 0u; i < pStatements.size(); i++)
+   {
+      Statement* statement = pStatements[i];
 
-         {
-            Value thisPtr;
-            thisPtr.mValueInitializationHint = ValueInitializationHint::Stack;
-            getAddressOfValue(pContext, *pOutValue, &thisPtr);
+      if(statement->getType() == StatementType::FunctionDeclaration)
+      {
+         pOutStatements->push_back(&pStatements[i]);
+      }
+      else if(statement->getType() == StatementType::NamespaceDeclaration)
+      {
+         StatementBlock* body = static_cast<StatementNamespaceDeclaration*>(statement)->mBody;
 
-            ctor->execute(thisPtr, preparedArgumentValues, nullptr);
+         if(body)
+         {
+            collectFunctionDeclarations(body->mStatements, pOutStatements);
          }
+      }
+   }
+}
 
-         while(!preparedArgumentValues.empty())
+// Moves a statement kept from a previous version of a program into the current one
+static void relocateStatement(Statement* pStatement, Program* pProgram, int pLineOffset)
+{
+   if(!pStatement)
+      return;
+
+   pStatement->mProgram = pProgram;
+   pStatement->mLine = (uint16_t)((int)pStatement->mLine + pLineOffset);
+
+   switch(pStatement->getType())
+   {
+   case StatementType::Block:
+      {
+         StatementBlock* statement = static_cast<StatementBlock*>(pStatement);
+
+         for(size_t i = 0u; i < statement->mStatements.size(); i++)
          {
-            preparedArgumentValues.pop_back();
+            relocateStatement(statement->mStatements[i], pProgram, pLineOffset);
          }
+      }
+      break;
+   case StatementType::NamespaceDeclaration:
+      {
+         StatementNamespaceDeclaration* statement =
+            static_cast<StatementNamespaceDeclaration*>(pStatement);
+         relocateStatement(statement->mBody, pProgram, pLineOffset);
+      }
+      break;
+   case StatementType::FunctionDeclaration:
+      {
+         StatementFunctionDeclaration* statement =
+            static_cast<StatementFunctionDeclaration*>(pStatement);
+         relocateStatement(statement->mBody, pProgram, pLineOffset);
+      }
+      break;
+   case StatementType::If:
+      {
+         StatementIf* statement = static_cast<StatementIf*>(pStatement);
+         relocateStatement(statement->mIfStatement, pProgram, pLineOffset);
+         relocateStatement(statement->mElseStatement, pProgram, pLineOffset);
+      }
+      break;
+   case StatementType::Switch:
+      {
+         StatementSwitch* statement = static_cast<StatementSwitch*>(pStatement);
 
-         while(!argumentValues.empty())
+         for(size_t i = 0u; i < statement->mCaseSections.size(); i++)
          {
-            argumentValues.pop_back();
+            StatementSwitch::CaseSection& caseSection = statement->mCaseSections[i];
+
+            for(size_t j = 0u; j < caseSection.mStatements.size(); j++)
+            {
+               relocateStatement(caseSection.mStatements[j], pProgram, pLineOffset);
+            }
          }
       }
       break;
-   default:
+   case StatementType::While:
+   case StatementType::DoWhile:
+      {
+         StatementWhile* statement = static_cast<StatementWhile*>(pStatement);
+         relocateStatement(statement->mLoopStatement, pProgram, pLineOffset);
+      }
+      break;
+   case StatementType::For:
+      {
+         StatementFor* statement = static_cast<StatementFor*>(pStatement);
+         relocateStatement(statement->mInitialization, pProgram, pLineOffset);
+         relocateStatement(statement->mLoopStatement, pProgram, pLineOffset);
+      }
+      break;
+   case StatementType::ForRangeBased:
+      {
+         StatementForRangeBased* statement = static_cast<StatementForRangeBased*>(pStatement);
+         relocateStatement(statement->mLoopStatement, pProgram, pLineOffset);
+      }
+      break;
+   default:
       break;
    }
-}
-
-void Environment::getInstanceDataValue(ExecutionContext& pContext, Expression* pExpression,
-   Value* pOutValue)
-{
-   if(pExpression->getType() == ExpressionType::VariableAccess)
-   {
-      ExpressionVariableAccess* variableAccess =
-         static_cast<ExpressionVariableAccess*>(pExpression);
-      Instance* instance = retrieveInstance(pContext, variableAccess->mVariableIdentifier);
-      *pOutValue = instance->mValue;
-   }
-   else if(pExpression->getType() == ExpressionType::MemberAccess)
-   {
-      ExpressionMemberAccess* memberAccess =
-         static_cast<ExpressionMemberAccess*>(pExpression);
+}
+
+void Environment::indexFunctionBodies(ParsingContext& pContext)
+{
+   Memory::AllocatorScope allocatorScope(&mAllocator);
+
+   const CflatSTLVector(Token)& tokens = pContext.mTokens;
+
+   // lazy function bodies only need the token ranges
+   const bool fingerprinting = CflatHasFlag(mSettings, Settings::IncrementalReload);
+   const bool lazyFunctionBodies = CflatHasFlag(mSettings, Settings::LazyFunctionBodies);
+
+   // the settings take part in the outline, since they affect how the code gets parsed
+   uint64_t outlineFingerprint = kCodeFingerprintBasis;
+   addToCodeFingerprint(&outlineFingerprint, &mSettings, sizeof(mSettings));
+
+   // whether each opened brace belongs to a namespace declaration
+   CflatSTLVector(bool) openedBraces;
+   size_t openedNonNamespaceBraces = 0u;
+
+   CflatSTLVector(size_t) openedParentheses;
+   size_t lastParenthesisOpeningIndex = 0u;
+
+   pContext.mFunctionBodies.clear();
 
-      evaluateExpression(pContext, memberAccess->mMemberOwner, &memberAccess->mMemberOwnerValue);
+   for(size_t i = 0u; i < tokens.size(); i++)
+   {
+      const Token& token = tokens[i];
 
-      if(memberAccess->mMemberOwnerValue.mTypeUsage.isPointer() &&
-         !CflatValueAs(&memberAccess->mMemberOwnerValue, void*))
+      if(isPunctuationToken(token, '('))
       {
-         throwRuntimeError(pContext, RuntimeError::NullPointerAccess,
-            memberAccess->mMemberIdentifier.mName);
+         openedParentheses.push_back(i);
       }
-
-      if(!mErrorMessage.empty())
+      else if(isPunctuationToken(token, ')'))
       {
-         return;
+         if(!openedParentheses.empty())
+         {
+            lastParenthesisOpeningIndex = openedParentheses.back();
+            openedParentheses.pop_back();
+         }
       }
-
-      if(memberAccess->mMemberAccessType != MemberAccessType::Method)
+      else if(isPunctuationToken(token, '{'))
       {
-         char* instanceDataPtr = memberAccess->mMemberOwnerValue.mTypeUsage.isPointer()
-            ? CflatValueAs(&memberAccess->mMemberOwnerValue, char*)
-            : memberAccess->mMemberOwnerValue.mValueBuffer;
-
-         if(instanceDataPtr)
+         // function body: in namespace scope, right after the parameters list
+         if(openedNonNamespaceBraces == 0u &&
+            i > 0u && isPunctuationToken(tokens[i - 1u], ')') &&
+            lastParenthesisOpeningIndex > 0u &&
+            tokens[lastParenthesisOpeningIndex - 1u].mType == TokenType::Identifier)
          {
-            Struct* type = static_cast<Struct*>(memberAccess->mMemberOwnerValue.mTypeUsage.mType);
+            uint64_t bodyFingerprint = kCodeFingerprintBasis;
+            size_t level = 0u;
+            size_t closureTokenIndex = 0u;
 
-            TypeUsage typeUsage;
-            int instanceDataPtrOffset = 0;
-
-            if(memberAccess->mMemberAccessType == MemberAccessType::Field)
+            for(size_t j = i; j < tokens.size(); j++)
             {
-               Field* field = type->findField(memberAccess->mMemberIdentifier);
-               
-               if(field)
+               if(fingerprinting)
                {
-                  typeUsage = field->mTypeUsage;
-                  instanceDataPtrOffset = (int)field->mOffset;
+                  // lines relative to the body, so that moving it around does not change it
+                  const uint16_t line = (uint16_t)(tokens[j].mLine - token.mLine);
+                  addToCodeFingerprint(&bodyFingerprint, &line, sizeof(line));
+                  addToCodeFingerprint(&bodyFingerprint, tokens[j]);
+               }
+
+               if(isPunctuationToken(tokens[j], '{'))
+               {
+                  level++;
+               }
+               else if(isPunctuationToken(tokens[j], '}') && --level == 0u)
+               {
+                  closureTokenIndex = j;
+                  break;
                }
-            }
-            else
-            {
-               typeUsage.mType = type;
             }
 
-            if(typeUsage.mType)
+            if(closureTokenIndex > 0u)
             {
-               TypeUsage referenceTypeUsage = typeUsage;
-               CflatSetFlag(referenceTypeUsage.mFlags, TypeUsageFlags::Reference);
-
-               assertValueInitialization(pContext, referenceTypeUsage, pOutValue);
-               pOutValue->set(instanceDataPtr + instanceDataPtrOffset);
+               ParsingContext::FunctionBody functionBody;
+               functionBody.mOpeningTokenIndex = i;
+               functionBody.mClosureTokenIndex = closureTokenIndex;
+               functionBody.mFingerprint = bodyFingerprint;
+               functionBody.mRegistering = lazyFunctionBodies &&
+                  isRegisteringFunctionBody(tokens, i, closureTokenIndex);
+               pContext.mFunctionBodies.push_back(functionBody);
+
+               i = closureTokenIndex;
+               continue;
             }
          }
-      }
-   }
-   else if(pExpression->getType() == ExpressionType::ArrayElementAccess)
-   {
-      ExpressionArrayElementAccess* arrayElementAccess =
-         static_cast<ExpressionArrayElementAccess*>(pExpression);
 
-      const TypeUsage& arrayTypeUsage = getTypeUsage(arrayElementAccess->mArray);
-      const size_t arraySize = (size_t)arrayTypeUsage.mArraySize;
+         const bool namespaceBody = openedNonNamespaceBraces == 0u &&
+            ((i > 0u && tokens[i - 1u].mType == TokenType::Keyword &&
+               strncmp(tokens[i - 1u].mStart, "namespace", 9u) == 0) ||
+            (i > 1u && tokens[i - 1u].mType == TokenType::Identifier &&
+               tokens[i - 2u].mType == TokenType::Keyword &&
+               strncmp(tokens[i - 2u].mStart, "namespace", 9u) == 0));
 
-      Value arrayIndexValue;
-      arrayIndexValue.mValueInitializationHint = ValueInitializationHint::Stack;
-      evaluateExpression(pContext, arrayElementAccess->mArrayElementIndex, &arrayIndexValue);
-      const size_t arrayIndex = (size_t)getValueAsInteger(arrayIndexValue);
+         openedBraces.push_back(namespaceBody);
 
-      if(arrayIndex < arraySize)
+         if(!namespaceBody)
+         {
+            openedNonNamespaceBraces++;
+         }
+      }
+      else if(isPunctuationToken(token, '}'))
       {
-         TypeUsage arrayElementTypeUsage = arrayTypeUsage;
-         CflatResetFlag(arrayElementTypeUsage.mFlags, TypeUsageFlags::Array);
-         arrayElementTypeUsage.mArraySize = 1u;
-
-         Value arrayDataValue;
-         arrayDataValue.initExternal(arrayElementTypeUsage);
-         getInstanceDataValue(pContext, arrayElementAccess->mArray, &arrayDataValue);
+         if(!openedBraces.empty())
+         {
+            if(!openedBraces.back())
+            {
+               openedNonNamespaceBraces--;
+            }
 
-         pOutValue->mValueBuffer =
-            arrayDataValue.mValueBuffer + (arrayIndex * arrayElementTypeUsage.getSize());
+            openedBraces.pop_back();
+         }
       }
-      else
+
+      if(fingerprinting)
       {
-         char buffer[kDefaultLocalStringBufferSize];
-         snprintf(buffer, sizeof(buffer), "size %zu, index %zu", arraySize, arrayIndex);
-         throwRuntimeError(pContext, Environment::RuntimeError::InvalidArrayIndex, buffer);
+         addToCodeFingerprint(&outlineFingerprint, token);
       }
    }
-   else if(pExpression->getType() == ExpressionType::UnaryOperation &&
-      static_cast<ExpressionUnaryOperation*>(pExpression)->mOperator[0] == '*')
-   {
-      ExpressionUnaryOperation* unaryOperation = static_cast<ExpressionUnaryOperation*>(pExpression);
-
-      Value value;
-      value.mValueInitializationHint = ValueInitializationHint::Stack;
-      evaluateExpression(pContext, unaryOperation->mExpression, &value);
-      CflatAssert(value.mTypeUsage.isPointer());
 
-      const void* ptr = CflatValueAs(&value, void*);
-      pOutValue->set(ptr);
-   }
-   else
-   {
-      assertValueInitialization(pContext, pExpression->getTypeUsage(), pOutValue);
-      evaluateExpression(pContext, pExpression, pOutValue);
-   }
+   pContext.mProgram->mOutlineFingerprint = fingerprinting ? outlineFingerprint : 0u;
 }
 
-void Environment::getAddressOfValue(ExecutionContext& pContext, const Value& pInstanceDataValue,
-   Value* pOutValue)
+void Environment::prepareIncrementalReload(ParsingContext& pContext, Program* pPreviousProgram)
 {
-   TypeUsage pointerTypeUsage = pInstanceDataValue.mTypeUsage;
-   pointerTypeUsage.mPointerLevel++;
-   pointerTypeUsage.mArraySize = 1u;
+   if(pPreviousProgram->mOutlineFingerprint == 0u ||
+      pPreviousProgram->mOutlineFingerprint != pContext.mProgram->mOutlineFingerprint)
+   {
+      return;
+   }
 
-   assertValueInitialization(pContext, pointerTypeUsage, pOutValue);
-   pOutValue->set(&pInstanceDataValue.mValueBuffer);
-}
+   Memory::AllocatorScope allocatorScope(&mAllocator);
 
-void Environment::getArgumentValues(ExecutionContext& pContext, const CflatSTLVector(TypeUsage)& pParameters,
-   const CflatSTLVector(Expression*)& pExpressions, CflatArgsVector(Value)& pValues)
-{
-   pValues.resize(pExpressions.size());
+   CflatSTLVector(Statement**) functionDeclarations;
+   collectFunctionDeclarations(pPreviousProgram->mStatements, &functionDeclarations);
 
-   for(size_t i = 0u; i < pExpressions.size(); i++)
+   for(size_t i = 0u; i < functionDeclarations.size(); i++)
    {
-      pValues[i].mValueInitializationHint = ValueInitializationHint::Stack;
+      StatementFunctionDeclaration* functionDeclaration =
+         static_cast<StatementFunctionDeclaration*>(*functionDeclarations[i]);
 
-      if(i < pParameters.size() && pParameters[i].isPointer())
+      if(functionDeclaration->mBody || functionDeclaration->mDeferredBody)
       {
-         // Set the pointer level for the value beforehand, to handle the special case where the
-         // parameter expects a pointer and the argument is an array name
-         pValues[i].mTypeUsage.mPointerLevel = pParameters[i].mPointerLevel;
+         pContext.mPreviousFunctionDeclarations.push_back(functionDeclarations[i]);
       }
+   }
 
-      evaluateExpression(pContext, pExpressions[i], &pValues[i]);
+   // the declarations and the bodies are matched by their order
+   if(pContext.mPreviousFunctionDeclarations.size() != pContext.mFunctionBodies.size())
+   {
+      pContext.mPreviousFunctionDeclarations.clear();
+      return;
    }
+
+   pContext.mIncrementalReload = true;
 }
 
-void Environment::prepareArgumentsForFunctionCall(ExecutionContext& pContext,
-   const CflatSTLVector(TypeUsage)& pParameters, const CflatArgsVector(Value)& pOriginalValues,
-   CflatArgsVector(Value)& pPreparedValues)
+const ParsingContext::FunctionBody* Environment::findFunctionBody(ParsingContext& pContext,
+   size_t pOpeningTokenIndex)
 {
-   pPreparedValues.resize(pOriginalValues.size());
+   const CflatSTLVector(ParsingContext::FunctionBody)& functionBodies = pContext.mFunctionBodies;
 
-   for(size_t i = 0u; i < pOriginalValues.size(); i++)
+   size_t first = 0u;
+   size_t last = functionBodies.size();
+
+   while(first < last)
    {
-      const bool nonVariadicParameter = i < pParameters.size();
-      const TypeUsage& valueTypeUsage = nonVariadicParameter
-         ? pParameters[i]
-         : pOriginalValues[i].mTypeUsage;
-      const TypeHelper::Compatibility compatibility =
-         TypeHelper::getCompatibility(valueTypeUsage, pOriginalValues[i].mTypeUsage);
+      const size_t middle = first + (last - first) / 2u;
 
-      // pass by reference
-      if(nonVariadicParameter &&
-         pParameters[i].isReference() &&
-         compatibility != TypeHelper::Compatibility::ImplicitConstructable)
+      if(functionBodies[middle].mOpeningTokenIndex < pOpeningTokenIndex)
       {
-         pPreparedValues[i] = pOriginalValues[i];
-         CflatSetFlag(pPreparedValues[i].mTypeUsage.mFlags, TypeUsageFlags::Reference);
+         first = middle + 1u;
       }
-      // pass by value
       else
       {
-         pPreparedValues[i].initOnStack(valueTypeUsage, &pContext.mStack);
-         assignValue(pContext, pOriginalValues[i], &pPreparedValues[i], false, compatibility);
+         last = middle;
       }
    }
+
+   if(first < functionBodies.size() &&
+      functionBodies[first].mOpeningTokenIndex == pOpeningTokenIndex)
+   {
+      return &functionBodies[first];
+   }
+
+   return nullptr;
 }
 
-void Environment::applyUnaryOperator(ExecutionContext& pContext, const Value& pOperand,
-   const char* pOperator, Value* pOutValue)
+void Environment::keepUnchangedFunctionDeclarations(ParsingContext& pContext)
 {
-   Type* type = pOperand.mTypeUsage.mType;
+   const CflatSTLVector(ParsingContext::UnchangedFunctionDeclaration)& unchangedDeclarations =
+      pContext.mUnchangedFunctionDeclarations;
+
+   if(unchangedDeclarations.empty())
+      return;
+
+   Program* program = pContext.mProgram;
+   CflatSTLVector(Statement**) functionDeclarations;
 
-   // overloaded operator
-   if(type->mCategory == TypeCategory::StructOrClass && !pOperand.mTypeUsage.isPointer())
    {
-      pContext.mStringBuffer.assign("operator");
-      pContext.mStringBuffer.append(pOperator);
+      Memory::AllocatorScope allocatorScope(&mAllocator);
+      collectFunctionDeclarations(program->mStatements, &functionDeclarations);
+   }
 
-      CflatArgsVector(Value) argumentValues;
+   size_t unchangedDeclarationIndex = 0u;
 
-      Struct* castType = static_cast<Struct*>(type);
-      const Identifier operatorIdentifier(pContext.mStringBuffer.c_str());
-      Method* operatorMethod = castType->findMethod(operatorIdentifier);
-      Function* operatorFunction = nullptr;
-      
-      if(operatorMethod)
-      {
-         Value thisPtrValue;
-         thisPtrValue.mValueInitializationHint = ValueInitializationHint::Stack;
-         getAddressOfValue(pContext, pOperand, &thisPtrValue);
+   for(size_t i = 0u; i < functionDeclarations.size(); i++)
+   {
+      if(unchangedDeclarationIndex == unchangedDeclarations.size())
+         break;
 
-         operatorMethod->execute(thisPtrValue, argumentValues, pOutValue);
-      }
-      else
-      {
-         argumentValues.push_back(pOperand);
+      const ParsingContext::UnchangedFunctionDeclaration& unchangedDeclaration =
+         unchangedDeclarations[unchangedDeclarationIndex];
 
-         operatorFunction = type->mNamespace->getFunction(operatorIdentifier, argumentValues);
+      if(*functionDeclarations[i] != unchangedDeclaration.mStatement)
+         continue;
 
-         if(!operatorFunction)
-         {
-            operatorFunction = findFunction(pContext, operatorIdentifier, argumentValues);
+      // the declarations get swapped, so that the previous program releases the new one,
+      // which has no body, while the previous one stays bound to its function
+      StatementFunctionDeclaration* previousStatement =
+         static_cast<StatementFunctionDeclaration*>(*unchangedDeclaration.mPreviousStatement);
+      const int lineOffset =
+         (int)unchangedDeclaration.mStatement->mLine - (int)previousStatement->mLine;
 
-            if(operatorFunction)
-            {
-               operatorFunction->execute(argumentValues, pOutValue);
-            }
-         }
-      }
+      *unchangedDeclaration.mPreviousStatement = unchangedDeclaration.mStatement;
+      *functionDeclarations[i] = previousStatement;
 
-      if(operatorMethod || operatorFunction)
+      relocateStatement(previousStatement, program, lineOffset);
+
+      if(previousStatement->mFunction)
       {
-         return;
+         previousStatement->mFunction->mProgram = program;
+         previousStatement->mFunction->mLine = previousStatement->mLine;
       }
-   }
 
-   // address of
-   if(pOperator[0] == '&')
-   {
-      getAddressOfValue(pContext, pOperand, pOutValue);
+      unchangedDeclarationIndex++;
    }
-   // integer built-in / pointer
-   else if(type->isInteger() || pOperand.mTypeUsage.isPointer())
-   {
-      if(pOperator[0] == '*')
-      {
-         CflatAssert(pOperand.mTypeUsage.isPointer());
-         CflatAssert(pOperand.mTypeUsage.mType == pOutValue->mTypeUsage.mType);
-         CflatAssert(pOperand.mTypeUsage.mPointerLevel == (pOutValue->mTypeUsage.mPointerLevel + 1u));
-
-         const void* ptr = CflatValueAs(&pOperand, void*);
-         pOutValue->set(ptr);
-      }
-      else
-      {
-         const int64_t valueAsInteger = getValueAsInteger(pOperand);
 
-         if(pOperator[0] == '!')
-         {
-            setValueAsInteger(!valueAsInteger, pOutValue);
-         }
-         else if(strcmp(pOperator, "++") == 0 || strcmp(pOperator, "--") == 0)
-         {
-            int64_t increment = 1;
+   CflatAssert(unchangedDeclarationIndex == unchangedDeclarations.size());
+}
 
-            if(pOutValue->mTypeUsage.isPointer())
-            {
-               TypeUsage indirectionTypeUsage = pOutValue->mTypeUsage;
-               indirectionTypeUsage.mPointerLevel--;
-               increment = (int64_t)indirectionTypeUsage.getSize();
-            }
+void Environment::executeReloaded(ExecutionContext& pContext, const Program& pProgram)
+{
+   pContext.mJumpStatement = JumpStatement::None;
 
-            if(pOperator[0] == '-')
-            {
-               increment *= -1;
-            }
+   pContext.mCallStack.emplace_back(&pProgram);
 
-            setValueAsInteger(valueAsInteger + increment, pOutValue);
-         }
-         else if(pOperator[0] == '-')
-         {
-            setValueAsInteger(-valueAsInteger, pOutValue);
-         }
-         else if(pOperator[0] == '~')
-         {
-            setValueAsInteger(~valueAsInteger, pOutValue);
-         }
-      }
-   }
-   // decimal built-in
-   else if(type->mCategory == TypeCategory::BuiltIn)
+   for(size_t i = 0u; i < pProgram.mStatements.size(); i++)
    {
-      if(pOperator[0] == '-')
+      executeReloaded(pContext, pProgram.mStatements[i]);
+
+      if(!pContext.mErrorMessage.empty())
       {
-         const double valueAsDecimal = getValueAsDecimal(pOperand);
-         setValueAsDecimal(-valueAsDecimal, pOutValue);
+         break;
       }
    }
-}
 
-void Environment::applyBinaryOperator(ExecutionContext& pContext, const Value& pLeft, const Value& pRight,
-   const char* pOperator, Value* pOutValue)
-{
-   if(!mErrorMessage.empty())
+   pContext.mCallStack.pop_back();
+
+   if(mExecutionHook)
    {
-      return;
+      mExecutionHook(this, pContext.mCallStack);
    }
 
-   Type* leftType = pLeft.mTypeUsage.mType;
-   Type* rightType = pRight.mTypeUsage.mType;
-
-   const bool leftIsNumericValue =
-      leftType->mCategory == TypeCategory::BuiltIn ||
-      leftType->mCategory == TypeCategory::Enum ||
-      leftType->mCategory == TypeCategory::EnumClass ||
-      pLeft.mTypeUsage.isPointer();
-   const bool rightIsNumericValue =
-      rightType->mCategory == TypeCategory::BuiltIn ||
-      rightType->mCategory == TypeCategory::Enum ||
-      rightType->mCategory == TypeCategory::EnumClass ||
-      pRight.mTypeUsage.isPointer();
+   pContext.mUsingDirectives.clear();
+}
 
-   if(leftIsNumericValue && rightIsNumericValue)
+void Environment::executeReloaded(ExecutionContext& pContext, Statement* pStatement)
+{
+   switch(pStatement->getType())
    {
-      const bool integerLeftValue =
-         leftType->isInteger() ||
-         leftType->mCategory == TypeCategory::EnumClass ||
-         pLeft.mTypeUsage.isPointer();
-      const bool integerRightValue =
-         rightType->isInteger() ||
-         rightType->mCategory == TypeCategory::EnumClass ||
-         pRight.mTypeUsage.isPointer();
-      const bool integerValues = integerLeftValue && integerRightValue;
+   case StatementType::Block:
+      {
+         StatementBlock* statement = static_cast<StatementBlock*>(pStatement);
 
-      int64_t leftValueAsInteger = getValueAsInteger(pLeft);
-      int64_t rightValueAsInteger = getValueAsInteger(pRight);
-      double leftValueAsDecimal = 0.0;
-      double rightValueAsDecimal = 0.0;
+         incrementBlockLevel(pContext);
 
-      if(integerLeftValue)
-      { 
-         if(!integerRightValue)
+         for(size_t i = 0u; i < statement->mStatements.size(); i++)
          {
-            leftValueAsDecimal = (double)leftValueAsInteger;
+            executeReloaded(pContext, statement->mStatements[i]);
          }
+
+         decrementBlockLevel(pContext);
       }
-      else
+      break;
+   case StatementType::NamespaceDeclaration:
       {
-         leftValueAsDecimal = getValueAsDecimal(pLeft);
-      }
+         StatementNamespaceDeclaration* statement =
+            static_cast<StatementNamespaceDeclaration*>(pStatement);
+         Namespace* ns =
+            pContext.mNamespaceStack.back()->requestNamespace(statement->mNamespaceIdentifier);
 
-      if(integerRightValue)
+         pContext.mNamespaceStack.push_back(ns);
+         executeReloaded(pContext, statement->mBody);
+         pContext.mNamespaceStack.pop_back();
+      }
+      break;
+   case StatementType::FunctionDeclaration:
       {
-         if(!integerLeftValue)
+         // the kept declarations are still bound to their functions
+         if(!static_cast<StatementFunctionDeclaration*>(pStatement)->mFunction)
          {
-            rightValueAsDecimal = (double)rightValueAsInteger;
+            execute(pContext, pStatement);
          }
       }
-      else
-      {
-         rightValueAsDecimal = getValueAsDecimal(pRight);
-      }
+      break;
+   case StatementType::UsingDirective:
+   case StatementType::TypeDefinition:
+      execute(pContext, pStatement);
+      break;
+   default:
+      // the global variables keep their values, and the rest of statements in namespace scope
+      // have already been executed along with the previous version of the program
+      break;
+   }
+}
 
-      if(strcmp(pOperator, "==") == 0)
-      {
-         const bool result = leftValueAsInteger == rightValueAsInteger;
-         pOutValue->assign(&result);
-      }
-      else if(strcmp(pOperator, "!=") == 0)
-      {
-         const bool result = leftValueAsInteger != rightValueAsInteger;
-         pOutValue->assign(&result);
-      }
-      else if(strcmp(pOperator, "<") == 0)
-      {
-         const bool result = integerValues
-            ? leftValueAsInteger < rightValueAsInteger
-            : leftValueAsDecimal < rightValueAsDecimal;
-         pOutValue->assign(&result);
-      }
-      else if(strcmp(pOperator, ">") == 0)
+void Environment::retainDeferredTokens(ParsingContext& pContext)
+{
+   // the tokens reference the code owned by the program and the macro expansions, which get
+   // kept along with them
+   Program* program = pContext.mProgram;
+   program->mDeferredTokens.swap(pContext.mTokens);
+   std::swap(program->mDeferredTokensIndex, pContext.mTokensIndex);
+   program->mDeferredMacroExpansions.swap(pContext.mMacroExpansions);
+   program->mLocalNamespaceGlobalIndex = pContext.mLocalNamespaceGlobalIndex;
+}
+
+bool Environment::parseDeferredFunctionBody(StatementFunctionDeclaration* pStatement)
+{
+   DeferredFunctionBody* deferredBody = pStatement->mDeferredBody;
+
+   if(!deferredBody->mErrorMessage.empty())
+      return false;
+
+   Program* program = pStatement->mProgram;
+
+   Memory::CategoryScope categoryScope(Memory::Category::Program);
+
+   const Memory::Usage programUsageBefore =
+      mMemoryStats.mCategories[(size_t)Memory::Category::Program].load();
+
+   // the constants evaluated while parsing report their errors through the environment's
+   // error message, which might be holding an error already
+   CflatSTLString previousErrorMessage;
+   previousErrorMessage.swap(mErrorMessage);
+
+   StatementBlock* body = nullptr;
+
+   {
+      // the body might get parsed with execution access only, which readers share, so it must
+      // not alter the environment; the bodies that would are not deferred in the first place
+      ParsingContext parsingContext(&mGlobalNamespace);
+      parsingContext.mProgram = program;
+      parsingContext.mSharedAccess = true;
+      parsingContext.mTokens.swap(program->mDeferredTokens);
+      std::swap(parsingContext.mTokensIndex, program->mDeferredTokensIndex);
+      parsingContext.mLocalNamespaceGlobalIndex = program->mLocalNamespaceGlobalIndex;
+      parsingContext.mUsingDirectives = deferredBody->mUsingDirectives;
+      parsingContext.mTypeAliases = deferredBody->mTypeAliases;
+
+      for(Namespace* ns = deferredBody->mNamespace; ns != &mGlobalNamespace; ns = ns->getParent())
       {
-         const bool result = integerValues
-            ? leftValueAsInteger > rightValueAsInteger
-            : leftValueAsDecimal > rightValueAsDecimal;
-         pOutValue->assign(&result);
+         parsingContext.mNamespaceStack.insert(parsingContext.mNamespaceStack.begin() + 1u, ns);
       }
-      else if(strcmp(pOperator, "<=") == 0)
+
+      CflatArgsVector(TypeUsage) parameterTypes;
+      toArgsVector(pStatement->mParameterTypes, parameterTypes);
+
+      Function* function = deferredBody->mNamespace->getFunctionPerfectMatch(
+         pStatement->mFunctionIdentifier, parameterTypes);
+      CflatAssert(function);
+
+      parsingContext.mCurrentFunction = function;
+
+      parsingContext.mScopeLevel++;
+
+      for(size_t i = 0u; i < pStatement->mParameterTypes.size(); i++)
       {
-         const bool result = integerValues
-            ? leftValueAsInteger <= rightValueAsInteger
-            : leftValueAsDecimal <= rightValueAsDecimal;
-         pOutValue->assign(&result);
+         registerInstance(parsingContext, pStatement->mParameterTypes[i],
+            pStatement->mParameterIdentifiers[i]);
       }
-      else if(strcmp(pOperator, ">=") == 0)
+
+      parsingContext.mScopeLevel--;
+
+      parsingContext.mTokenIndex = deferredBody->mOpeningTokenIndex;
+      body = parseStatementBlock(parsingContext, true, true);
+
+      parsingContext.mCurrentFunction = nullptr;
+
+      if(body && pStatement->mReturnType.mType != mTypeVoid && !doAllExecutionPathsReturn(body))
       {
-         const bool result = integerValues
-            ? leftValueAsInteger >= rightValueAsInteger
-            : leftValueAsDecimal >= rightValueAsDecimal;
-         pOutValue->assign(&result);
+         parsingContext.mTokenIndex = deferredBody->mFunctionTokenIndex;
+         throwCompileError(parsingContext, CompileError::MissingReturnStatement,
+            pStatement->mFunctionIdentifier.mName);
       }
-      else if(strcmp(pOperator, "&&") == 0)
+
+      if(body && !parsingContext.mErrorMessage.empty())
       {
-         const bool result = leftValueAsInteger && rightValueAsInteger;
-         pOutValue->assign(&result);
+         CflatInvokeDtor(StatementBlock, body);
+         CflatFree(body);
+         body = nullptr;
       }
-      else if(strcmp(pOperator, "||") == 0)
+
+      if(!body)
       {
-         const bool result = leftValueAsInteger || rightValueAsInteger;
-         pOutValue->assign(&result);
+         // the error is kept, so that it gets reported again on further calls
+         deferredBody->mErrorMessage.assign(parsingContext.mErrorMessage);
       }
-      else if(strcmp(pOperator, "+") == 0)
-      {
-         if(integerValues)
-         {
-            if(pLeft.mTypeUsage.isPointer())
-            {
-               TypeUsage indirectionTypeUsage = pLeft.mTypeUsage;
-               indirectionTypeUsage.mPointerLevel--;
-               rightValueAsInteger *= (int64_t)indirectionTypeUsage.getSize();
-            }
 
-            setValueAsInteger(leftValueAsInteger + rightValueAsInteger, pOutValue);
-         }
-         else
-         {
-            setValueAsDecimal(leftValueAsDecimal + rightValueAsDecimal, pOutValue);
-         }
-      }
-      else if(strcmp(pOperator, "-") == 0)
-      {
-         if(integerValues)
-         {
-            if(pLeft.mTypeUsage.isPointer())
-            {
-               TypeUsage indirectionTypeUsage = pLeft.mTypeUsage;
-               indirectionTypeUsage.mPointerLevel--;
-               rightValueAsInteger *= (int64_t)indirectionTypeUsage.getSize();
-            }
+      program->mLocalNamespaceGlobalIndex = parsingContext.mLocalNamespaceGlobalIndex;
+      parsingContext.mTokens.swap(program->mDeferredTokens);
+      std::swap(parsingContext.mTokensIndex, program->mDeferredTokensIndex);
+   }
 
-            setValueAsInteger(leftValueAsInteger - rightValueAsInteger, pOutValue);
-         }
-         else
-         {
-            setValueAsDecimal(leftValueAsDecimal - rightValueAsDecimal, pOutValue);
-         }
-      }
-      else if(strcmp(pOperator, "*") == 0)
-      {
-         if(integerValues)
-         {
-            setValueAsInteger(leftValueAsInteger * rightValueAsInteger, pOutValue);
-         }
-         else
-         {
-            setValueAsDecimal(leftValueAsDecimal * rightValueAsDecimal, pOutValue);
-         }
-      }
-      else if(strcmp(pOperator, "/") == 0)
+   if(body)
+   {
+      pStatement->mBody = body;
+      pStatement->mDeferredBody = nullptr;
+      pStatement->mBodyDeferred = false;
+
+      CflatInvokeDtor(DeferredFunctionBody, deferredBody);
+      CflatFree(deferredBody);
+   }
+
+   mErrorMessage.swap(previousErrorMessage);
+
+   program->mDeferredFunctionBodiesCount--;
+
+   if(program->mDeferredFunctionBodiesCount == 0u)
+   {
+      CflatSTLVector(Token)().swap(program->mDeferredTokens);
+      program->mDeferredTokensIndex = TokensIndex();
+      CflatSTLDeque(CflatSTLString)().swap(program->mDeferredMacroExpansions);
+   }
+
+   const Memory::Usage programUsageAfter =
+      mMemoryStats.mCategories[(size_t)Memory::Category::Program].load();
+   program->mMemoryUsage.mBytes += programUsageAfter.mBytes - programUsageBefore.mBytes;
+   program->mMemoryUsage.mAllocations +=
+      programUsageAfter.mAllocations - programUsageBefore.mAllocations;
+
+   return body != nullptr;
+}
+
+bool Environment::parseCalledFunctionBody(ExecutionContext& pContext,
+   StatementFunctionDeclaration* pStatement)
+{
+   NativeExecutionState* nativeState = nullptr;
+
+   if(pContext.mResumableCall)
+   {
+      nativeState = pContext.mResumableCall->mNativeState;
+   }
+   else if(pContext.mCoroutine)
+   {
+      nativeState = pContext.mCoroutine->mNativeState;
+   }
+
+   // the parsing might take more stack than native executions have, so the body gets parsed
+   // on the stack of the resuming thread, which holds the access to the environment
+   if(nativeState)
+   {
+      struct BodyParsing
       {
-         if(integerValues)
-         {
-            if(rightValueAsInteger != 0)
-            {
-               setValueAsInteger(leftValueAsInteger / rightValueAsInteger, pOutValue);
-            }
-            else
-            {
-               throwRuntimeError(pContext, RuntimeError::DivisionByZero);
-            }
-         }
-         else
-         {
-            if(fabs(rightValueAsDecimal) > 0.000000001)
-            {
-               setValueAsDecimal(leftValueAsDecimal / rightValueAsDecimal, pOutValue);
-            }
-            else
-            {
-               throwRuntimeError(pContext, RuntimeError::DivisionByZero);
-            }
-         }
-      }
-      else if(strcmp(pOperator, "%") == 0)
+         Environment* mEnvironment;
+         StatementFunctionDeclaration* mStatement;
+         bool mParsed;
+      };
+      BodyParsing bodyParsing = { this, pStatement, false };
+
+      runOnResumer(nativeState, [](void* pBodyParsing)
       {
-         setValueAsInteger(leftValueAsInteger % rightValueAsInteger, pOutValue);
-      }
-      else if(strcmp(pOperator, "&") == 0)
+         BodyParsing* bodyParsing = static_cast<BodyParsing*>(pBodyParsing);
+         Memory::AllocatorScope allocatorScope(&bodyParsing->mEnvironment->mAllocator);
+         bodyParsing->mParsed =
+            bodyParsing->mEnvironment->parseDeferredFunctionBody(bodyParsing->mStatement);
+      }, &bodyParsing);
+
+      return bodyParsing.mParsed;
+   }
+
+   return parseDeferredFunctionBody(pStatement);
+}
+
+void Environment::parseAllDeferredFunctionBodies()
+{
+   Memory::AllocatorScope allocatorScope(&mAllocator);
+
+   CflatSTLVector(Statement**) functionDeclarations;
+
+   for(ProgramsRegistry::const_iterator it = mPrograms.begin(); it != mPrograms.end(); it++)
+   {
+      if(it->second->mDeferredFunctionBodiesCount == 0u)
+         continue;
+
+      functionDeclarations.clear();
+      collectFunctionDeclarations(it->second->mStatements, &functionDeclarations);
+
+      for(size_t i = 0u; i < functionDeclarations.size(); i++)
       {
-         setValueAsInteger(leftValueAsInteger & rightValueAsInteger, pOutValue);
+         StatementFunctionDeclaration* statement =
+            static_cast<StatementFunctionDeclaration*>(*functionDeclarations[i]);
+
+         // the bodies which do not compile keep the error, reported when they get called
+         if(statement->mBodyDeferred)
+         {
+            parseDeferredFunctionBody(statement);
+         }
       }
-      else if(strcmp(pOperator, "|") == 0)
+   }
+}
+
+bool Environment::parseDeferredFunctionBodies(const Identifier& pProgramIdentifier)
+{
+   AccessScope accessScope(this, AccessType::Write);
+   Memory::AllocatorScope allocatorScope(&mAllocator);
+
+   mErrorMessage.clear();
+
+   ProgramsRegistry::const_iterator it = mPrograms.find(pProgramIdentifier.mHash);
+
+   if(it == mPrograms.end())
+      return false;
+
+   CflatSTLVector(Statement**) functionDeclarations;
+   collectFunctionDeclarations(it->second->mStatements, &functionDeclarations);
+
+   for(size_t i = 0u; i < functionDeclarations.size(); i++)
+   {
+      StatementFunctionDeclaration* statement =
+         static_cast<StatementFunctionDeclaration*>(*functionDeclarations[i]);
+
+      if(statement->mBodyDeferred && !parseDeferredFunctionBody(statement))
       {
-         setValueAsInteger(leftValueAsInteger | rightValueAsInteger, pOutValue);
+         mErrorMessage.assign(statement->mDeferredBody->mErrorMessage);
+         return false;
       }
-      else if(strcmp(pOperator, "^") == 0)
+   }
+
+   return true;
+}
+
+Hash Environment::getBindingsFingerprint() const
+{
+   Memory::AllocatorScope allocatorScope(&mAllocator);
+
+   CflatSTLVector(Namespace*) namespaces;
+   namespaces.push_back(const_cast<Namespace*>(&mGlobalNamespace));
+   mGlobalNamespace.getAllNamespaces(&namespaces, true);
+
+   CflatSTLVector(Type*) types;
+   CflatSTLVector(const TypeAlias*) typeAliases;
+   CflatSTLVector(Function*) functions;
+   CflatSTLVector(Instance*) instances;
+
+   Hash fingerprint = kFingerprintBasis;
+
+   for(size_t i = 0u; i < namespaces.size(); i++)
+   {
+      const Namespace* ns = namespaces[i];
+      addToFingerprint(&fingerprint, ns->getFullIdentifier().mHash);
+
+      types.clear();
+      ns->getAllTypes(&types);
+      addToFingerprint(&fingerprint, (uint32_t)types.size());
+
+      for(size_t j = 0u; j < types.size(); j++)
       {
-         setValueAsInteger(leftValueAsInteger ^ rightValueAsInteger, pOutValue);
+         addToFingerprint(&fingerprint, types[j]);
       }
-      else if(strcmp(pOperator, "<<") == 0)
+
+      typeAliases.clear();
+      ns->getAllTypeAliases(&typeAliases);
+      addToFingerprint(&fingerprint, typeAliases);
+
+      functions.clear();
+      ns->getAllFunctions(&functions);
+      addToFingerprint(&fingerprint, functions);
+
+      instances.clear();
+      ns->getAllInstances(&instances);
+      addToFingerprint(&fingerprint, (uint32_t)instances.size());
+
+      for(size_t j = 0u; j < instances.size(); j++)
       {
-         setValueAsInteger(leftValueAsInteger << rightValueAsInteger, pOutValue);
+         addToFingerprint(&fingerprint, instances[j]->mIdentifier.mHash);
+         addToFingerprint(&fingerprint, instances[j]->mTypeUsage);
       }
-      else if(strcmp(pOperator, ">>") == 0)
+   }
+
+   return fingerprint;
+}
+
+Hash Environment::getMacrosFingerprint(uint32_t* pOutMacrosGeneration)
+{
+   Hash fingerprint = kFingerprintBasis;
+
+   mMacrosLock.lockShared();
+
+   const CflatSTLVector(Macro)& macros = mMacros.getMacros();
+
+   for(size_t i = 0u; i < macros.size(); i++)
+   {
+      const Macro& macro = macros[i];
+      addToFingerprint(&fingerprint, hash(macro.mName.c_str(), macro.mName.size()));
+      addToFingerprint(&fingerprint, (uint32_t)macro.mParametersCount);
+      addToFingerprint(&fingerprint, (uint32_t)macro.mBody.size());
+
+      for(size_t j = 0u; j < macro.mBody.size(); j++)
       {
-         setValueAsInteger(leftValueAsInteger >> rightValueAsInteger, pOutValue);
+         addToFingerprint(&fingerprint, hash(macro.mBody[j].c_str(), macro.mBody[j].size()));
       }
    }
-   else
+
+   *pOutMacrosGeneration = mMacrosGeneration;
+
+   mMacrosLock.unlockShared();
+
+   return fingerprint;
+}
+
+void Environment::getProgramCachePath(const Identifier& pProgramIdentifier,
+   CflatSTLString* pOutPath) const
+{
+   char fileName[32];
+   snprintf(fileName, sizeof(fileName), "%08x.cflatc", pProgramIdentifier.mHash);
+
+   pOutPath->assign(mProgramCacheDirectory);
+
+   if(!pOutPath->empty() && pOutPath->back() != '/' && pOutPath->back() != '\\')
    {
-      pContext.mStringBuffer.assign("operator");
-      pContext.mStringBuffer.append(pOperator);
+      pOutPath->push_back('/');
+   }
 
-      CflatArgsVector(Value) argumentValues;
-      argumentValues.push_back(pRight);
+   pOutPath->append(fileName);
+}
 
-      const Identifier operatorIdentifier(pContext.mStringBuffer.c_str());
-      Method* operatorMethod = leftType->mCategory == TypeCategory::StructOrClass
-         ? static_cast<Struct*>(leftType)->findMethod(operatorIdentifier, argumentValues)
-         : nullptr;
-      
-      if(operatorMethod)
-      {
-         Value thisPtrValue;
-         thisPtrValue.mValueInitializationHint = ValueInitializationHint::Stack;
-         getAddressOfValue(pContext, pLeft, &thisPtrValue);
+bool Environment::readProgramCacheHeader(ParsingContext& pContext)
+{
+   Program* program = pContext.mProgram;
 
-         CflatArgsVector(Value) preparedArgumentValues;
-         prepareArgumentsForFunctionCall(pContext, operatorMethod->mParameters,
-            argumentValues, preparedArgumentValues);
+   uint32_t macrosGeneration = 0u;
+   pContext.mMacrosFingerprint = getMacrosFingerprint(&macrosGeneration);
 
-         operatorMethod->execute(thisPtrValue, preparedArgumentValues, pOutValue);
+   CflatSTLString path;
+   getProgramCachePath(program->mIdentifier, &path);
 
-         while(!preparedArgumentValues.empty())
-         {
-            preparedArgumentValues.pop_back();
-         }
-      }
-      else
-      {
-         argumentValues.insert(argumentValues.begin(), pLeft);
+   FILE* file = fopen(path.c_str(), "rb");
 
-         Function* operatorFunction =
-            leftType->mNamespace->getFunction(operatorIdentifier, argumentValues);
+   if(!file)
+      return false;
 
-         if(!operatorFunction)
-         {
-            operatorFunction = findFunction(pContext, operatorIdentifier, argumentValues);
-         }
+   fseek(file, 0, SEEK_END);
+   const long fileSize = ftell(file);
+   rewind(file);
 
-         CflatAssert(operatorFunction);
+   size_t readSize = 0u;
 
-         CflatArgsVector(Value) preparedArgumentValues;
-         prepareArgumentsForFunctionCall(pContext, operatorFunction->mParameters,
-            argumentValues, preparedArgumentValues);
+   if(fileSize > 0)
+   {
+      pContext.mCachedProgram.resize((size_t)fileSize);
+      readSize = fread(&pContext.mCachedProgram[0], 1u, (size_t)fileSize, file);
+   }
 
-         operatorFunction->execute(preparedArgumentValues, pOutValue);
+   fclose(file);
 
-         while(!preparedArgumentValues.empty())
+   ProgramCacheReader reader(pContext.mCachedProgram.data(), readSize);
+
+   bool valid =
+      readCacheValue<uint32_t>(reader) == kProgramCacheSignature &&
+      readCacheValue<uint32_t>(reader) == kProgramCacheVersion;
+
+   if(valid)
+   {
+      // Checksum of everything after it, so that a truncated or corrupted file gets rejected
+      // before any of its contents are trusted
+      const uint64_t checksum = readCacheValue<uint64_t>(reader);
+      valid = !reader.mFailed &&
+         checksum == getCodeFingerprint(reader.mCursor, (size_t)(reader.mEnd - reader.mCursor));
+   }
+
+   valid = valid &&
+      readCacheValue<uint32_t>(reader) == (uint32_t)program->mCode.size() &&
+      readCacheValue<uint64_t>(reader) ==
+         getCodeFingerprint(program->mCode.c_str(), program->mCode.size()) &&
+      readCacheValue<Hash>(reader) == pContext.mMacrosFingerprint &&
+      readCacheValue<uint32_t>(reader) == mSettings;
+
+   if(valid)
+   {
+      pContext.mCachedBindingsFingerprint = readCacheValue<Hash>(reader);
+
+      uint32_t nameLength = 0u;
+      const char* name = readCacheString(reader, &nameLength);
+
+      valid = nameLength == program->mIdentifier.mNameLength &&
+         strncmp(name, program->mIdentifier.mName, nameLength) == 0;
+   }
+
+   if(valid)
+   {
+      // Macros defined by the code, which would otherwise have been defined while preprocessing
+      const uint32_t macrosCount = readCacheValue<uint32_t>(reader);
+
+      for(uint32_t i = 0u; i < macrosCount && !reader.mFailed; i++)
+      {
+         Macro macro;
+
+         uint32_t length = 0u;
+         const char* string = readCacheString(reader, &length);
+         macro.mName.assign(string, length);
+         macro.mParametersCount = readCacheValue<uint8_t>(reader);
+
+         const uint32_t bodyCount = readCacheValue<uint32_t>(reader);
+
+         for(uint32_t j = 0u; j < bodyCount && !reader.mFailed; j++)
          {
-            preparedArgumentValues.pop_back();
+            string = readCacheString(reader, &length);
+            macro.mBody.emplace_back();
+            macro.mBody.back().assign(string, length);
          }
+
+         pContext.mMacros.registerMacro(macro);
       }
-   }
-}
 
-void Environment::performAssignment(ExecutionContext& pContext, const Value& pValue,
-   const char* pOperator, Value* pInstanceDataValue)
-{
-   if(strcmp(pOperator, "=") == 0)
-   {
-      assignValue(pContext, pValue, pInstanceDataValue, false);
+      valid = !reader.mFailed;
    }
-   else
+
+   if(!valid)
    {
-      char binaryOperator[2];
-      binaryOperator[0] = pOperator[0];
-      binaryOperator[1] = '\0';
+      pContext.mCachedProgram.clear();
+      pContext.mMacros = MacrosHolder();
 
-      applyBinaryOperator(pContext, *pInstanceDataValue, pValue, binaryOperator, pInstanceDataValue);
+      return false;
    }
+
+   pContext.mCachedProgramOffset = (size_t)(reader.mCursor - pContext.mCachedProgram.data());
+   pContext.mMacrosGeneration = macrosGeneration;
+
+   return true;
 }
 
-void Environment::performStaticCast(ExecutionContext& pContext, const Value& pValueToCast,
-   const TypeUsage& pTargetTypeUsage, Value* pOutValue)
+bool Environment::readProgramCache(ParsingContext& pContext)
 {
-   const TypeUsage& sourceTypeUsage = pValueToCast.mTypeUsage;
+   Program* program = pContext.mProgram;
+   const CflatSTLVector(char)& cachedProgram = pContext.mCachedProgram;
 
-   if(pTargetTypeUsage.mType->mCategory == TypeCategory::StructOrClass)
+   ProgramCacheReader* reader = nullptr;
+
+   // The tables are only needed while reading, so they are not accounted as program memory
    {
-      if(sourceTypeUsage.mType->mCategory == TypeCategory::StructOrClass)
+      Memory::CategoryScope categoryScope(Memory::Category::General);
+
+      reader = (ProgramCacheReader*)CflatMalloc(sizeof(ProgramCacheReader));
+      CflatInvokeCtor(ProgramCacheReader, reader)
+         (cachedProgram.data() + pContext.mCachedProgramOffset,
+            cachedProgram.size() - pContext.mCachedProgramOffset);
+
+      const uint32_t stringsCount = readCacheValue<uint32_t>(*reader);
+      reader->mStrings.reserve(stringsCount);
+
+      CflatSTLString stringBuffer;
+
+      for(uint32_t i = 0u; i < stringsCount && !reader->mFailed; i++)
       {
-         performInheritanceCast(pContext, pValueToCast, pTargetTypeUsage, pOutValue);
+         uint32_t length = 0u;
+         const char* string = readCacheString(*reader, &length);
+         stringBuffer.assign(string, length);
+         reader->mStrings.push_back(Identifier(stringBuffer.c_str()));
       }
-   }
-   else
-   {
-      if(sourceTypeUsage.mType->isInteger() ||
-         sourceTypeUsage.mType->mCategory == TypeCategory::EnumClass)
+
+      const uint32_t typesCount = readCacheValue<uint32_t>(*reader);
+      reader->mTypes.reserve(typesCount);
+
+      for(uint32_t i = 0u; i < typesCount && !reader->mFailed; i++)
       {
-         const int64_t sourceValueAsInteger = getValueAsInteger(pValueToCast);
+         const uint32_t parentIndex = readCacheValue<uint32_t>(*reader);
+         const uint32_t namespaceIndex = readCacheValue<uint32_t>(*reader);
+         const Identifier identifier = readCachedString(*reader);
 
-         if(pTargetTypeUsage.mType->isInteger() ||
-            pTargetTypeUsage.mType->mCategory == TypeCategory::EnumClass)
+         CflatArgsVector(TypeUsage) templateTypes;
+         const uint32_t templateTypesCount = readCacheValue<uint32_t>(*reader);
+
+         if(templateTypesCount > kArgsVectorSize)
          {
-            setValueAsInteger(sourceValueAsInteger, pOutValue);
+            reader->mFailed = true;
+            break;
          }
-         else
+
+         for(uint32_t j = 0u; j < templateTypesCount; j++)
          {
-            setValueAsDecimal((double)sourceValueAsInteger, pOutValue);
+            templateTypes.push_back(readCachedTypeUsage(*reader));
          }
-      }
-      else if(sourceTypeUsage.mType->isDecimal())
-      {
-         const double sourceValueAsDecimal = getValueAsDecimal(pValueToCast);
 
-         if(pTargetTypeUsage.mType->isInteger() ||
-            pTargetTypeUsage.mType->mCategory == TypeCategory::EnumClass)
+         Type* parent = parentIndex < reader->mTypes.size() ? reader->mTypes[parentIndex] : nullptr;
+         Namespace* ns = namespaceIndex < reader->mStrings.size()
+            ? mGlobalNamespace.getNamespace(reader->mStrings[namespaceIndex])
+            : &mGlobalNamespace;
+
+         Type* type = findCachedType(ns, parent, identifier, templateTypes);
+
+         if(!type || (parentIndex != kProgramCacheNullIndex && !parent))
          {
-            setValueAsInteger((int64_t)sourceValueAsDecimal, pOutValue);
+            reader->mFailed = true;
+            break;
          }
-         else
+
+         reader->mTypes.push_back(type);
+      }
+
+      // Function entries: static method flag, owner, identifier, parameters and template types
+      const uint32_t functionsCount = readCacheValue<uint32_t>(*reader);
+      reader->mFunctionEntries.reserve(functionsCount);
+
+      for(uint32_t i = 0u; i < functionsCount && !reader->mFailed; i++)
+      {
+         reader->mFunctionEntries.push_back(reader->mCursor);
+
+         readCacheValue<uint8_t>(*reader);
+         readCacheValue<uint32_t>(*reader);
+         readCacheValue<uint32_t>(*reader);
+
+         for(uint32_t j = 0u; j < 2u; j++)
          {
-            setValueAsDecimal(sourceValueAsDecimal, pOutValue);
+            const uint32_t typeUsagesCount = readCacheValue<uint32_t>(*reader);
+
+            for(uint32_t k = 0u; k < typeUsagesCount && !reader->mFailed; k++)
+            {
+               readCachedTypeUsage(*reader);
+            }
          }
       }
+
+      reader->mFunctions.resize(reader->mFunctionEntries.size(), nullptr);
    }
-}
 
-void Environment::performIntegerCast(ExecutionContext& pContext, const Value& pValueToCast,
-   const TypeUsage& pTargetTypeUsage, Value* pOutValue)
-{
-   setValueAsInteger(getValueAsInteger(pValueToCast), pOutValue);
+   const uint32_t statementsCount = readCacheValue<uint32_t>(*reader);
+
+   for(uint32_t i = 0u; i < statementsCount && !reader->mFailed; i++)
+   {
+      Statement* statement = readCachedStatement(*reader, pContext);
+
+      if(statement)
+      {
+         program->mStatements.push_back(statement);
+      }
+   }
+
+   const bool success = !reader->mFailed && reader->mCursor == reader->mEnd;
+
+   CflatInvokeDtor(ProgramCacheReader, reader);
+   CflatFree(reader);
+
+   if(!success)
+   {
+      for(size_t i = 0u; i < program->mStatements.size(); i++)
+      {
+         CflatInvokeDtor(Statement, program->mStatements[i]);
+         CflatFree(program->mStatements[i]);
+      }
+
+      program->mStatements.clear();
+      pContext.mCachedProgram.clear();
+
+      return false;
+   }
+
+   program->mLoadedFromCache = true;
+
+   return true;
 }
 
-void Environment::performIntegerFloatCast(ExecutionContext& pContext, const Value& pValueToCast,
-   const TypeUsage& pTargetTypeUsage, Value* pOutValue)
+void Environment::writeProgramCache(ParsingContext& pContext, Hash pBindingsFingerprint)
 {
-   Type* sourceType = pValueToCast.mTypeUsage.mType;
-   Type* targetType = pTargetTypeUsage.mType;
+   // The cache is not owned by the program, so it is not accounted as program memory
+   Memory::CategoryScope categoryScope(Memory::Category::General);
+
+   Program* program = pContext.mProgram;
+   ProgramCacheWriter writer(&mGlobalNamespace);
+
+   writeCacheValue(writer.mStatements, (uint32_t)program->mStatements.size());
+
+   for(size_t i = 0u; i < program->mStatements.size(); i++)
+   {
+      writeCachedStatement(writer, program->mStatements[i]);
+   }
+
+   CflatSTLString path;
+   getProgramCachePath(program->mIdentifier, &path);
+
+   if(!writer.mSupported)
+   {
+      // a previous version of the program might have been cached
+      remove(path.c_str());
+      return;
+   }
+
+   CflatSTLVector(char) header;
+   writeCacheValue(header, kProgramCacheSignature);
+   writeCacheValue(header, kProgramCacheVersion);
+   const size_t checksumOffset = header.size();
+   writeCacheValue(header, (uint64_t)0u);
+   writeCacheValue(header, (uint32_t)program->mCode.size());
+   writeCacheValue(header, getCodeFingerprint(program->mCode.c_str(), program->mCode.size()));
+   writeCacheValue(header, pContext.mMacrosFingerprint);
+   writeCacheValue(header, mSettings);
+   writeCacheValue(header, pBindingsFingerprint);
+   writeCacheString(header, program->mIdentifier.mName, program->mIdentifier.mNameLength);
+
+   const CflatSTLVector(Macro)& macros = pContext.mMacros.getMacros();
+   writeCacheValue(header, (uint32_t)macros.size());
+
+   for(size_t i = 0u; i < macros.size(); i++)
+   {
+      writeCacheString(header, macros[i].mName.c_str(), macros[i].mName.size());
+      writeCacheValue(header, macros[i].mParametersCount);
+      writeCacheValue(header, (uint32_t)macros[i].mBody.size());
+
+      for(size_t j = 0u; j < macros[i].mBody.size(); j++)
+      {
+         writeCacheString(header, macros[i].mBody[j].c_str(), macros[i].mBody[j].size());
+      }
+   }
+
+   writeCacheValue(header, writer.mStringsCount);
+   writeCacheData(header, writer.mStrings.data(), writer.mStrings.size());
+   writeCacheValue(header, writer.mTypesCount);
+   writeCacheData(header, writer.mTypes.data(), writer.mTypes.size());
+   writeCacheValue(header, writer.mFunctionsCount);
+   writeCacheData(header, writer.mFunctions.data(), writer.mFunctions.size());
+
+   const size_t checksumEnd = checksumOffset + sizeof(uint64_t);
+   uint64_t checksum = kCodeFingerprintBasis;
+   addToCodeFingerprint(&checksum, header.data() + checksumEnd, header.size() - checksumEnd);
+   addToCodeFingerprint(&checksum, writer.mStatements.data(), writer.mStatements.size());
+   memcpy(header.data() + checksumOffset, &checksum, sizeof(uint64_t));
+
+   // The file gets written under a temporary name first, so that a partially written one
+   // never replaces a valid cache
+   CflatSTLString temporaryPath(path);
+   temporaryPath.append(".tmp");
+
+   FILE* file = fopen(temporaryPath.c_str(), "wb");
+
+   if(!file)
+      return;
+
+   const bool written =
+      fwrite(header.data(), 1u, header.size(), file) == header.size() &&
+      fwrite(writer.mStatements.data(), 1u, writer.mStatements.size(), file) ==
+         writer.mStatements.size();
+   fclose(file);
 
-   CflatAssert(sourceType->mCategory == TypeCategory::BuiltIn);
-   CflatAssert(targetType->mCategory == TypeCategory::BuiltIn);
+   remove(path.c_str());
 
-   if(sourceType->isInteger() && targetType->isDecimal())
-   {
-      const int64_t integerValue = getValueAsInteger(pValueToCast);
-      setValueAsDecimal((double)integerValue, pOutValue);
-   }
-   else if(sourceType->isDecimal() && targetType->isInteger())
+   if(!written || rename(temporaryPath.c_str(), path.c_str()) != 0)
    {
-      const double decimalValue = getValueAsDecimal(pValueToCast);
-      setValueAsInteger((int64_t)decimalValue, pOutValue);
+      remove(temporaryPath.c_str());
    }
 }
 
-void Environment::performFloatCast(ExecutionContext& pContext, const Value& pValueToCast,
-   const TypeUsage& pTargetTypeUsage, Value* pOutValue)
+uint32_t Environment::writeCachedString(ProgramCacheWriter& pWriter, const Identifier& pIdentifier)
 {
-   Type* sourceType = pValueToCast.mTypeUsage.mType;
-   Type* targetType = pTargetTypeUsage.mType;
+   ProgramCacheWriter::StringIndicesRegistry::const_iterator it =
+      pWriter.mStringIndices.find(pIdentifier.mHash);
 
-   CflatAssert(sourceType->mCategory == TypeCategory::BuiltIn);
-   CflatAssert(targetType->mCategory == TypeCategory::BuiltIn);
+   if(it != pWriter.mStringIndices.end())
+   {
+      return it->second;
+   }
 
-   const double decimalValue = getValueAsDecimal(pValueToCast);
-   setValueAsDecimal(decimalValue, pOutValue);
+   writeCacheString(pWriter.mStrings, pIdentifier.mName, pIdentifier.mNameLength);
+
+   const uint32_t index = pWriter.mStringsCount++;
+   pWriter.mStringIndices[pIdentifier.mHash] = index;
+
+   return index;
 }
 
-void Environment::performInheritanceCast(ExecutionContext& pContext, const Value& pValueToCast,
-   const TypeUsage& pTargetTypeUsage, Value* pOutValue)
+uint32_t Environment::writeCachedType(ProgramCacheWriter& pWriter, Type* pType)
 {
-   CflatAssert(pValueToCast.mTypeUsage.mType->mCategory == TypeCategory::StructOrClass);
-   CflatAssert(pTargetTypeUsage.mType->mCategory == TypeCategory::StructOrClass);
+   if(!pType)
+   {
+      return kProgramCacheNullIndex;
+   }
 
-   Struct* sourceType = static_cast<Struct*>(pValueToCast.mTypeUsage.mType);
-   Struct* targetType = static_cast<Struct*>(pTargetTypeUsage.mType);
+   ProgramCacheWriter::ReferenceIndicesRegistry::const_iterator it =
+      pWriter.mTypeIndices.find((uintptr_t)pType);
 
-   char* ptr = nullptr;
+   if(it != pWriter.mTypeIndices.end())
+   {
+      return it->second;
+   }
 
-   if(sourceType == targetType)
+   // The types it depends on get written first, so that they are resolved before it
+   const uint32_t parentIndex = writeCachedType(pWriter, pType->mParent);
+
+   CflatArgsVector(TypeUsage) templateTypes;
+
+   if(pType->mCategory == TypeCategory::StructOrClass)
    {
-      ptr = CflatValueAs(&pValueToCast, char*);
+      toArgsVector(static_cast<Struct*>(pType)->mTemplateTypes, templateTypes);
    }
-   else if(sourceType->derivedFrom(targetType))
+
+   for(size_t i = 0u; i < templateTypes.size(); i++)
    {
-      ptr = CflatValueAs(&pValueToCast, char*) + sourceType->getOffset(targetType);
+      writeCachedType(pWriter, templateTypes[i].mType);
    }
-   else if(targetType->derivedFrom(sourceType))
+
+   const Identifier& nsIdentifier = pType->mNamespace->getFullIdentifier();
+   const uint32_t namespaceIndex = nsIdentifier.mHash != 0u
+      ? writeCachedString(pWriter, nsIdentifier)
+      : kProgramCacheNullIndex;
+   const uint32_t identifierIndex = writeCachedString(pWriter, pType->mIdentifier);
+
+   Namespace* ns = nsIdentifier.mHash != 0u
+      ? mGlobalNamespace.getNamespace(nsIdentifier)
+      : &mGlobalNamespace;
+
+   if(findCachedType(ns, pType->mParent, pType->mIdentifier, templateTypes) != pType)
    {
-      ptr = CflatValueAs(&pValueToCast, char*) - targetType->getOffset(sourceType);
+      pWriter.mSupported = false;
    }
 
-   pOutValue->assign(&ptr);
-}
+   writeCacheValue(pWriter.mTypes, parentIndex);
+   writeCacheValue(pWriter.mTypes, namespaceIndex);
+   writeCacheValue(pWriter.mTypes, identifierIndex);
+   writeCacheValue(pWriter.mTypes, (uint32_t)templateTypes.size());
 
-void Environment::performImplicitConstruction(ExecutionContext& pContext, Type* pCtorType,
-   const Value& pCtorArg, Value* pObjectValue)
-{
-   static const Hash kInitializerListIdentifierHash = hash("initializer_list");
+   for(size_t i = 0u; i < templateTypes.size(); i++)
+   {
+      writeCachedTypeUsage(pWriter, pWriter.mTypes, templateTypes[i]);
+   }
 
-   CflatAssert(pCtorType->mCategory == TypeCategory::StructOrClass);
-   Struct* ctorType = static_cast<Struct*>(pCtorType);
+   const uint32_t index = pWriter.mTypesCount++;
+   pWriter.mTypeIndices[(uintptr_t)pType] = index;
 
-   CflatArgsVector(Value) ctorArgs;
-   ctorArgs.push_back(pCtorArg);
-   Method* ctor = ctorType->findConstructor(ctorArgs);
-   CflatAssert(ctor);
+   return index;
+}
 
-   Value thisPtrValue;
-   thisPtrValue.mValueInitializationHint = ValueInitializationHint::Stack;
-   getAddressOfValue(pContext, *pObjectValue, &thisPtrValue);
+void Environment::writeCachedTypeUsage(ProgramCacheWriter& pWriter, CflatSTLVector(char)& pBuffer,
+   const TypeUsage& pTypeUsage)
+{
+   writeCacheValue(pBuffer, writeCachedType(pWriter, pTypeUsage.mType));
+   writeCacheValue(pBuffer, pTypeUsage.mArraySize);
+   writeCacheValue(pBuffer, pTypeUsage.mPointerLevel);
+   writeCacheValue(pBuffer, pTypeUsage.mFlags);
+}
 
-   // Special case: array initializer list
-   if(ctor->mParameters[0].mType->mIdentifier.mHash == kInitializerListIdentifierHash &&
-      pCtorArg.mTypeUsage.isArray())
+uint32_t Environment::writeCachedFunction(ProgramCacheWriter& pWriter, Function* pFunction)
+{
+   if(!pFunction)
    {
-      Type* initializerListType = ctor->mParameters[0].mType;
-      TypeUsage initializerListTypeUsage;
-      initializerListTypeUsage.mType = initializerListType;
+      return kProgramCacheNullIndex;
+   }
 
-      Value initializerListValue;
-      initializerListValue.initOnStack(initializerListTypeUsage, &pContext.mStack);
+   ProgramCacheWriter::ReferenceIndicesRegistry::const_iterator it =
+      pWriter.mFunctionIndices.find((uintptr_t)pFunction);
 
-      TypeUsage arrayElementConstPtr;
-      arrayElementConstPtr.mType = pCtorArg.mTypeUsage.mType;
-      arrayElementConstPtr.mPointerLevel = pCtorArg.mTypeUsage.mPointerLevel + 1u;
-      CflatSetFlag(arrayElementConstPtr.mFlags, TypeUsageFlags::Const);
+   if(it != pWriter.mFunctionIndices.end())
+   {
+      return it->second;
+   }
 
-      void* arrayBeginPtr = pCtorArg.mValueBuffer;
-      void* arrayEndPtr = (char*)arrayBeginPtr + pCtorArg.mTypeUsage.getSize();
+   Namespace* ns = nullptr;
+   Type* ownerType = nullptr;
+   uint32_t ownerIndex = kProgramCacheNullIndex;
 
-      CflatArgsVector(Value) initializerListCtorArgs;
-      initializerListCtorArgs.emplace_back();
-      Value& initializerListCtorArgArrayBeginPtr = initializerListCtorArgs.back();
-      initializerListCtorArgArrayBeginPtr.initOnStack(arrayElementConstPtr, &pContext.mStack);
-      initializerListCtorArgArrayBeginPtr.set(&arrayBeginPtr);
-      initializerListCtorArgs.emplace_back();
-      Value& initializerListCtorArgArrayEndPtr = initializerListCtorArgs.back();
-      initializerListCtorArgArrayEndPtr.initOnStack(arrayElementConstPtr, &pContext.mStack);
-      initializerListCtorArgArrayEndPtr.set(&arrayEndPtr);
+   // Static methods do not belong to any namespace, but to their type
+   if(!pFunction->mNamespace)
+   {
+      if(!pWriter.mStaticMethodOwnersCollected)
+      {
+         CflatSTLVector(Type*) types;
+         mGlobalNamespace.getAllTypes(&types, true);
 
-      Value initializerListPtrValue;
-      initializerListPtrValue.mValueInitializationHint = ValueInitializationHint::Stack;
-      getAddressOfValue(pContext, initializerListValue, &initializerListPtrValue);
+         for(size_t i = 0u; i < types.size(); i++)
+         {
+            collectStaticMethodOwners(types[i], pWriter.mStaticMethodOwners);
+         }
 
-      Method* initializerListCtor =
-         static_cast<Struct*>(initializerListType)->findConstructor(initializerListCtorArgs);
-      CflatAssert(initializerListCtor);
+         pWriter.mStaticMethodOwnersCollected = true;
+      }
 
-      Value unusedReturnValue;
-      initializerListCtor->execute(initializerListPtrValue, initializerListCtorArgs, &unusedReturnValue);
+      ProgramCacheWriter::StaticMethodOwnersRegistry::const_iterator ownerIt =
+         pWriter.mStaticMethodOwners.find((uintptr_t)pFunction);
 
-      ctorArgs[0] = initializerListValue;
-      ctor->execute(thisPtrValue, ctorArgs, &unusedReturnValue);
+      if(ownerIt == pWriter.mStaticMethodOwners.end())
+      {
+         pWriter.mSupported = false;
+         return kProgramCacheNullIndex;
+      }
+
+      ownerType = ownerIt->second;
+      ownerIndex = writeCachedType(pWriter, ownerType);
    }
-   // General case
    else
    {
-      Value unusedReturnValue;
-      ctor->execute(thisPtrValue, ctorArgs, &unusedReturnValue);
+      const Identifier& nsIdentifier = pFunction->mNamespace->getFullIdentifier();
+
+      if(nsIdentifier.mHash != 0u)
+      {
+         ownerIndex = writeCachedString(pWriter, nsIdentifier);
+         ns = mGlobalNamespace.getNamespace(nsIdentifier);
+      }
+      else
+      {
+         ns = &mGlobalNamespace;
+      }
    }
-}
 
-void Environment::assignValue(ExecutionContext& pContext, const Value& pSource, Value* pTarget,
-   bool pDeclaration)
-{
-   const TypeHelper::Compatibility compatibility =
-      TypeHelper::getCompatibility(pTarget->mTypeUsage, pSource.mTypeUsage);
-   assignValue(pContext, pSource, pTarget, pDeclaration, compatibility);
-}
+   const uint32_t identifierIndex = writeCachedString(pWriter, pFunction->mIdentifier);
 
-void Environment::assignValue(ExecutionContext& pContext, const Value& pSource, Value* pTarget,
-   bool pDeclaration, TypeHelper::Compatibility pCompatibility)
-{
-   const TypeUsage typeUsage = pTarget->mTypeUsage;
+   CflatArgsVector(TypeUsage) parameterTypes;
+   toArgsVector(pFunction->mParameters, parameterTypes);
 
-   if(pCompatibility == TypeHelper::Compatibility::ImplicitCastableInteger)
+   CflatArgsVector(TypeUsage) templateTypes;
+   toArgsVector(pFunction->mTemplateTypes, templateTypes);
+
+   for(size_t i = 0u; i < parameterTypes.size(); i++)
    {
-      performIntegerCast(pContext, pSource, typeUsage, pTarget);
+      writeCachedType(pWriter, parameterTypes[i].mType);
    }
-   else if(pCompatibility == TypeHelper::Compatibility::ImplicitCastableIntegerFloat)
+
+   for(size_t i = 0u; i < templateTypes.size(); i++)
    {
-      performIntegerFloatCast(pContext, pSource, typeUsage, pTarget);
+      writeCachedType(pWriter, templateTypes[i].mType);
    }
-   else if(pCompatibility == TypeHelper::Compatibility::ImplicitCastableFloat)
+
+   if(findCachedFunction(ns, ownerType, pFunction->mIdentifier, parameterTypes, templateTypes) !=
+      pFunction)
    {
-      performFloatCast(pContext, pSource, typeUsage, pTarget);
+      pWriter.mSupported = false;
    }
-   else if(pCompatibility == TypeHelper::Compatibility::ImplicitCastableInheritance)
+
+   writeCacheValue(pWriter.mFunctions, (uint8_t)(ownerType ? 1u : 0u));
+   writeCacheValue(pWriter.mFunctions, ownerIndex);
+   writeCacheValue(pWriter.mFunctions, identifierIndex);
+   writeCacheValue(pWriter.mFunctions, (uint32_t)parameterTypes.size());
+
+   for(size_t i = 0u; i < parameterTypes.size(); i++)
    {
-      performInheritanceCast(pContext, pSource, typeUsage, pTarget);
+      writeCachedTypeUsage(pWriter, pWriter.mFunctions, parameterTypes[i]);
    }
-   else if(pCompatibility == TypeHelper::Compatibility::ImplicitConstructable)
+
+   writeCacheValue(pWriter.mFunctions, (uint32_t)templateTypes.size());
+
+   for(size_t i = 0u; i < templateTypes.size(); i++)
    {
-      performImplicitConstruction(pContext, typeUsage.mType, pSource, pTarget);
+      writeCachedTypeUsage(pWriter, pWriter.mFunctions, templateTypes[i]);
    }
-   else
+
+   const uint32_t index = pWriter.mFunctionsCount++;
+   pWriter.mFunctionIndices[(uintptr_t)pFunction] = index;
+
+   return index;
+}
+
+void Environment::writeCachedMethod(ProgramCacheWriter& pWriter, Type* pOwnerType, Method* pMethod,
+   size_t pOffset)
+{
+   CflatSTLVector(char)& buffer = pWriter.mStatements;
+   Struct* owner = pMethod ? findMethodOwner(pOwnerType, pMethod) : nullptr;
+
+   if(!owner)
    {
-      bool valueAssigned = false;
+      if(pMethod)
+      {
+         pWriter.mSupported = false;
+      }
 
-      if(!pTarget->mTypeUsage.isPointer() &&
-         pTarget->mTypeUsage.mType->mCategory == TypeCategory::StructOrClass)
+      writeCacheValue(buffer, kProgramCacheNullIndex);
+      return;
+   }
+
+   writeCacheValue(buffer, writeCachedType(pWriter, owner));
+   writeCacheValue(buffer, (uint32_t)(pMethod - &owner->mMethods[0]));
+   writeCacheValue(buffer, (uint32_t)pOffset);
+}
+
+void Environment::writeCachedExpression(ProgramCacheWriter& pWriter, Expression* pExpression)
+{
+   CflatSTLVector(char)& buffer = pWriter.mStatements;
+
+   if(!pExpression)
+   {
+      writeCacheValue(buffer, kProgramCacheNullNode);
+      return;
+   }
+
+   writeCacheValue(buffer, (uint8_t)pExpression->getType());
+   writeCachedTypeUsage(pWriter, buffer, pExpression->getTypeUsage());
+
+   switch(pExpression->getType())
+   {
+   case ExpressionType::Value:
+      {
+         ExpressionValue* expression = static_cast<ExpressionValue*>(pExpression);
+         const TypeUsage& valueTypeUsage = expression->mValue.mTypeUsage;
+         writeCachedTypeUsage(pWriter, buffer, valueTypeUsage);
+
+         if(valueTypeUsage == mTypeUsageCString)
+         {
+            const char* string = CflatValueAs(&expression->mValue, const char*);
+            writeCacheString(buffer, string, strlen(string));
+         }
+         else if(valueTypeUsage == mTypeUsageWideString)
+         {
+            // literal wide strings are registered from their multibyte form
+            const wchar_t* string = CflatValueAs(&expression->mValue, const wchar_t*);
+            const size_t length = wcstombs(nullptr, string, 0u);
+
+            if(length != (size_t)-1)
+            {
+               CflatSTLVector(char) multibyteString;
+               multibyteString.resize(length + 1u);
+               wcstombs(&multibyteString[0], string, length + 1u);
+               writeCacheString(buffer, multibyteString.data(), length);
+            }
+            else
+            {
+               pWriter.mSupported = false;
+               writeCacheString(buffer, "", 0u);
+            }
+         }
+         else if(valueTypeUsage.mType &&
+            valueTypeUsage.mType->mCategory != TypeCategory::StructOrClass &&
+            !valueTypeUsage.isPointer() &&
+            !valueTypeUsage.isArray() &&
+            !valueTypeUsage.isReference())
+         {
+            writeCacheData(buffer, expression->mValue.mValueBuffer, valueTypeUsage.getSize());
+         }
+         else
+         {
+            pWriter.mSupported = false;
+         }
+      }
+      break;
+   case ExpressionType::NullPointer:
+      break;
+   case ExpressionType::VariableAccess:
+      {
+         ExpressionVariableAccess* expression = static_cast<ExpressionVariableAccess*>(pExpression);
+         writeCacheValue(buffer, writeCachedString(pWriter, expression->mVariableIdentifier));
+
+         uint32_t staticValueIndex = kProgramCacheNullIndex;
+
+         if(expression->mStaticValue)
+         {
+            ProgramCacheWriter::ReferenceIndicesRegistry::const_iterator it =
+               pWriter.mStaticValueIndices.find((uintptr_t)expression->mStaticValue);
+
+            if(it != pWriter.mStaticValueIndices.end())
+            {
+               staticValueIndex = it->second;
+            }
+            else
+            {
+               pWriter.mSupported = false;
+            }
+         }
+
+         writeCacheValue(buffer, staticValueIndex);
+      }
+      break;
+   case ExpressionType::MemberAccess:
+      {
+         ExpressionMemberAccess* expression = static_cast<ExpressionMemberAccess*>(pExpression);
+         writeCachedExpression(pWriter, expression->mMemberOwner);
+         writeCacheValue(buffer, writeCachedString(pWriter, expression->mMemberIdentifier));
+         writeCacheValue(buffer, (uint8_t)expression->mMemberAccessType);
+      }
+      break;
+   case ExpressionType::ArrayElementAccess:
+      {
+         ExpressionArrayElementAccess* expression =
+            static_cast<ExpressionArrayElementAccess*>(pExpression);
+         writeCachedExpression(pWriter, expression->mArray);
+         writeCachedExpression(pWriter, expression->mArrayElementIndex);
+      }
+      break;
+   case ExpressionType::UnaryOperation:
+      {
+         ExpressionUnaryOperation* expression = static_cast<ExpressionUnaryOperation*>(pExpression);
+         writeCachedExpression(pWriter, expression->mExpression);
+         writeCacheData(buffer, expression->mOperator, sizeof(expression->mOperator));
+         writeCacheValue(buffer, (uint8_t)expression->mPostOperator);
+      }
+      break;
+   case ExpressionType::BinaryOperation:
+      {
+         ExpressionBinaryOperation* expression = static_cast<ExpressionBinaryOperation*>(pExpression);
+         writeCachedExpression(pWriter, expression->mLeft);
+         writeCachedExpression(pWriter, expression->mRight);
+         writeCacheData(buffer, expression->mOperator, sizeof(expression->mOperator));
+      }
+      break;
+   case ExpressionType::Parenthesized:
+      {
+         ExpressionParenthesized* expression = static_cast<ExpressionParenthesized*>(pExpression);
+         writeCachedExpression(pWriter, expression->mExpression);
+      }
+      break;
+   case ExpressionType::SizeOf:
+      {
+         ExpressionSizeOf* expression = static_cast<ExpressionSizeOf*>(pExpression);
+         writeCachedTypeUsage(pWriter, buffer, expression->mSizeOfTypeUsage);
+         writeCachedExpression(pWriter, expression->mSizeOfExpression);
+      }
+      break;
+   case ExpressionType::Cast:
+      {
+         ExpressionCast* expression = static_cast<ExpressionCast*>(pExpression);
+         writeCacheValue(buffer, (uint8_t)expression->mCastType);
+         writeCachedExpression(pWriter, expression->mExpression);
+      }
+      break;
+   case ExpressionType::Conditional:
+      {
+         ExpressionConditional* expression = static_cast<ExpressionConditional*>(pExpression);
+         writeCachedExpression(pWriter, expression->mCondition);
+         writeCachedExpression(pWriter, expression->mIfExpression);
+         writeCachedExpression(pWriter, expression->mElseExpression);
+      }
+      break;
+   case ExpressionType::Assignment:
       {
-         Struct* type = static_cast<Struct*>(pTarget->mTypeUsage.mType);
+         ExpressionAssignment* expression = static_cast<ExpressionAssignment*>(pExpression);
+         writeCachedExpression(pWriter, expression->mLeftValue);
+         writeCachedExpression(pWriter, expression->mRightValue);
+         writeCacheData(buffer, expression->mOperator, sizeof(expression->mOperator));
+      }
+      break;
+   case ExpressionType::FunctionCall:
+      {
+         ExpressionFunctionCall* expression = static_cast<ExpressionFunctionCall*>(pExpression);
+         writeCacheValue(buffer, writeCachedString(pWriter, expression->mFunctionIdentifier));
+         writeCacheValue(buffer, (uint32_t)expression->mArguments.size());
 
-         if(pDeclaration)
+         for(size_t i = 0u; i < expression->mArguments.size(); i++)
          {
-            if(!pTarget->mTypeUsage.isReference())
-            {
-               Method* copyCtor = type->getCopyConstructor();
+            writeCachedExpression(pWriter, expression->mArguments[i]);
+         }
 
-               if(copyCtor)
-               {
-                  Value thisPtrValue;
-                  thisPtrValue.mValueInitializationHint = ValueInitializationHint::Stack;
-                  getAddressOfValue(pContext, *pTarget, &thisPtrValue);
+         writeCacheValue(buffer, (uint32_t)expression->mTemplateTypes.size());
 
-                  Method* defaultCtor = type->getDefaultConstructor();
+         for(size_t i = 0u; i < expression->mTemplateTypes.size(); i++)
+         {
+            writeCachedTypeUsage(pWriter, buffer, expression->mTemplateTypes[i]);
+         }
 
-                  if(defaultCtor)
-                  {
-                     defaultCtor->execute(thisPtrValue, Value::kEmptyList(), nullptr);
-                  }
+         writeCacheValue(buffer, writeCachedFunction(pWriter, expression->mFunction));
+      }
+      break;
+   case ExpressionType::MethodCall:
+      {
+         ExpressionMethodCall* expression = static_cast<ExpressionMethodCall*>(pExpression);
+         writeCachedExpression(pWriter, expression->mMemberAccess);
+         writeCacheValue(buffer, (uint32_t)expression->mArguments.size());
 
-                  TypeUsage referenceTypeUsage;
-                  referenceTypeUsage.mType = type;
-                  CflatSetFlag(referenceTypeUsage.mFlags, TypeUsageFlags::Reference);
+         for(size_t i = 0u; i < expression->mArguments.size(); i++)
+         {
+            writeCachedExpression(pWriter, expression->mArguments[i]);
+         }
 
-                  Value referenceValue;
-                  referenceValue.initExternal(referenceTypeUsage);
-                  referenceValue.set(pSource.mValueBuffer);
+         writeCacheValue(buffer, (uint32_t)expression->mTemplateTypes.size());
 
-                  CflatArgsVector(Value) copyCtorArgs;
-                  copyCtorArgs.push_back(referenceValue);
-                  copyCtor->execute(thisPtrValue, copyCtorArgs, nullptr);
+         for(size_t i = 0u; i < expression->mTemplateTypes.size(); i++)
+         {
+            writeCachedTypeUsage(pWriter, buffer, expression->mTemplateTypes[i]);
+         }
 
-                  valueAssigned = true;
-               }
-            }
+         ExpressionMemberAccess* memberAccess =
+            static_cast<ExpressionMemberAccess*>(expression->mMemberAccess);
+         Type* ownerType = memberAccess && memberAccess->mMemberOwner
+            ? getTypeUsage(memberAccess->mMemberOwner).mType
+            : nullptr;
+         writeCachedMethod(pWriter, ownerType, expression->mMethodUsage.mMethod,
+            expression->mMethodUsage.mOffset);
+      }
+      break;
+   case ExpressionType::ArrayInitialization:
+      {
+         ExpressionArrayInitialization* expression =
+            static_cast<ExpressionArrayInitialization*>(pExpression);
+         writeCachedTypeUsage(pWriter, buffer, expression->mElementTypeUsage);
+         writeCacheValue(buffer, (uint32_t)expression->mValues.size());
+
+         for(size_t i = 0u; i < expression->mValues.size(); i++)
+         {
+            writeCachedExpression(pWriter, expression->mValues[i]);
          }
-         else
+      }
+      break;
+   case ExpressionType::AggregateInitialization:
+      {
+         ExpressionAggregateInitialization* expression =
+            static_cast<ExpressionAggregateInitialization*>(pExpression);
+         writeCacheValue(buffer, (uint32_t)expression->mValues.size());
+
+         for(size_t i = 0u; i < expression->mValues.size(); i++)
          {
-            CflatArgsVector(Value) args;
-            args.push_back(pSource);
+            writeCachedExpression(pWriter, expression->mValues[i]);
+         }
+      }
+      break;
+   case ExpressionType::ObjectConstruction:
+      {
+         ExpressionObjectConstruction* expression =
+            static_cast<ExpressionObjectConstruction*>(pExpression);
+         writeCacheValue(buffer, (uint32_t)expression->mArguments.size());
 
-            const Identifier operatorIdentifier("operator=");
-            Method* operatorMethod = type->findMethod(operatorIdentifier, args);
+         for(size_t i = 0u; i < expression->mArguments.size(); i++)
+         {
+            writeCachedExpression(pWriter, expression->mArguments[i]);
+         }
 
-            if(operatorMethod && operatorMethod->mReturnTypeUsage.mType == type)
-            {
-               Value thisPtrValue;
-               thisPtrValue.mValueInitializationHint = ValueInitializationHint::Stack;
-               getAddressOfValue(pContext, *pTarget, &thisPtrValue);
+         writeCachedMethod(pWriter, expression->getTypeUsage().mType, expression->mConstructor, 0u);
+      }
+      break;
+   default:
+      pWriter.mSupported = false;
+      break;
+   }
+}
 
-               Method* defaultCtor = type->getDefaultConstructor();
+void Environment::writeCachedStatement(ProgramCacheWriter& pWriter, Statement* pStatement)
+{
+   CflatSTLVector(char)& buffer = pWriter.mStatements;
 
-               if(defaultCtor)
-               {
-                  defaultCtor->execute(thisPtrValue, Value::kEmptyList(), nullptr);
-               }
+   if(!pStatement)
+   {
+      writeCacheValue(buffer, kProgramCacheNullNode);
+      return;
+   }
 
-               operatorMethod->execute(thisPtrValue, args, pTarget);
+   writeCacheValue(buffer, (uint8_t)pStatement->getType());
+   writeCacheValue(buffer, pStatement->mLine);
 
-               valueAssigned = true;
-            }
-         }
+   switch(pStatement->getType())
+   {
+   case StatementType::Expression:
+      {
+         StatementExpression* statement = static_cast<StatementExpression*>(pStatement);
+         writeCachedExpression(pWriter, statement->mExpression);
       }
+      break;
+   case StatementType::Block:
+      {
+         StatementBlock* statement = static_cast<StatementBlock*>(pStatement);
+         writeCacheValue(buffer, (uint8_t)statement->mAlterScope);
+         writeCacheValue(buffer, (uint32_t)statement->mStatements.size());
 
-      if(!valueAssigned)
+         for(size_t i = 0u; i < statement->mStatements.size(); i++)
+         {
+            writeCachedStatement(pWriter, statement->mStatements[i]);
+         }
+      }
+      break;
+   case StatementType::UsingDirective:
       {
-         if(pDeclaration)
+         StatementUsingDirective* statement = static_cast<StatementUsingDirective*>(pStatement);
+         writeCacheValue(buffer, (uint8_t)(statement->mNamespace ? 1u : 0u));
+
+         if(statement->mNamespace)
          {
-            *pTarget = pSource;
+            writeCacheValue(buffer,
+               writeCachedString(pWriter, statement->mNamespace->getFullIdentifier()));
          }
          else
          {
-            pTarget->assign(pSource.mValueBuffer);
+            writeCacheValue(buffer, writeCachedString(pWriter, statement->mAliasIdentifier));
+            writeCachedTypeUsage(pWriter, buffer, statement->mAliasTypeUsage);
          }
       }
-   }
-}
+      break;
+   case StatementType::TypeDefinition:
+      {
+         StatementTypeDefinition* statement = static_cast<StatementTypeDefinition*>(pStatement);
+         writeCacheValue(buffer, writeCachedString(pWriter, statement->mAlias));
+         writeCachedTypeUsage(pWriter, buffer, statement->mReferencedTypeUsage);
+      }
+      break;
+   case StatementType::VariableDeclaration:
+      {
+         StatementVariableDeclaration* statement =
+            static_cast<StatementVariableDeclaration*>(pStatement);
+         writeCachedTypeUsage(pWriter, buffer, statement->mTypeUsage);
+         writeCacheValue(buffer, writeCachedString(pWriter, statement->mVariableIdentifier));
+         writeCacheValue(buffer, (uint8_t)statement->mStatic);
+         writeCachedExpression(pWriter, statement->mInitialValue);
 
-void Environment::execute(ExecutionContext& pContext, const Program& pProgram)
-{
-   pContext.mJumpStatement = JumpStatement::None;
+         // accesses to local statics refer to their declarations by index
+         if(statement->mStatic)
+         {
+            const uint32_t staticValueIndex = (uint32_t)pWriter.mStaticValueIndices.size();
+            pWriter.mStaticValueIndices[(uintptr_t)&statement->mStaticValue] = staticValueIndex;
+         }
+      }
+      break;
+   case StatementType::NamespaceDeclaration:
+      {
+         StatementNamespaceDeclaration* statement =
+            static_cast<StatementNamespaceDeclaration*>(pStatement);
+         writeCacheValue(buffer, writeCachedString(pWriter, statement->mNamespaceIdentifier));
 
-   pContext.mCallStack.emplace_back(&pProgram);
+         Namespace* ns = pWriter.mNamespaceStack.back()->getNamespace(statement->mNamespaceIdentifier);
 
-   for(size_t i = 0u; i < pProgram.mStatements.size(); i++)
-   {
-      execute(pContext, pProgram.mStatements[i]);
+         if(!ns)
+         {
+            pWriter.mSupported = false;
+            ns = pWriter.mNamespaceStack.back();
+         }
 
-      if(!mErrorMessage.empty())
-      {
-         break;
+         pWriter.mNamespaceStack.push_back(ns);
+         writeCachedStatement(pWriter, statement->mBody);
+         pWriter.mNamespaceStack.pop_back();
       }
-   }
+      break;
+   case StatementType::FunctionDeclaration:
+      {
+         StatementFunctionDeclaration* statement =
+            static_cast<StatementFunctionDeclaration*>(pStatement);
+         writeCachedTypeUsage(pWriter, buffer, statement->mReturnType);
+         writeCacheValue(buffer, writeCachedString(pWriter, statement->mFunctionIdentifier));
 
-   pContext.mCallStack.pop_back();
+         CflatArgsVector(TypeUsage) parameterTypes;
+         toArgsVector(statement->mParameterTypes, parameterTypes);
 
-   if(mExecutionHook)
-   {
-      mExecutionHook(this, pContext.mCallStack);
-   }
+         // the static flag is not kept in the statement, but in the registered function
+         Function* function = pWriter.mNamespaceStack.back()->getFunctionPerfectMatch(
+            statement->mFunctionIdentifier, parameterTypes);
 
-   pContext.mUsingDirectives.clear();
-}
+         if(!function)
+         {
+            pWriter.mSupported = false;
+         }
 
-void Environment::assertValueInitialization(ExecutionContext& pContext, const TypeUsage& pTypeUsage,
-   Value* pOutValue)
-{
-   if(pOutValue->mValueBufferType == ValueBufferType::Uninitialized)
-   {
-      if(pTypeUsage.isReference())
-      {
-         pOutValue->initExternal(pTypeUsage);
+         const bool isStatic = function && CflatHasFlag(function->mFlags, FunctionFlags::Static);
+         writeCacheValue(buffer, (uint8_t)isStatic);
+         writeCacheValue(buffer, (uint32_t)statement->mParameterTypes.size());
+
+         for(size_t i = 0u; i < statement->mParameterTypes.size(); i++)
+         {
+            writeCachedTypeUsage(pWriter, buffer, statement->mParameterTypes[i]);
+            writeCacheValue(buffer, writeCachedString(pWriter, statement->mParameterIdentifiers[i]));
+         }
+
+         writeCachedStatement(pWriter, statement->mBody);
       }
-      else if(pOutValue->mValueInitializationHint == ValueInitializationHint::Stack)
+      break;
+   case StatementType::If:
       {
-         pOutValue->initOnStack(pTypeUsage, &pContext.mStack);
+         StatementIf* statement = static_cast<StatementIf*>(pStatement);
+         writeCachedExpression(pWriter, statement->mCondition);
+         writeCachedStatement(pWriter, statement->mIfStatement);
+         writeCachedStatement(pWriter, statement->mElseStatement);
       }
-      else
+      break;
+   case StatementType::Switch:
       {
-         pOutValue->initOnHeap(pTypeUsage);
-      }
-   }
-}
-
-int64_t Environment::getValueAsInteger(const Value& pValue)
-{
-   const bool signedType =
-      !pValue.mTypeUsage.isPointer() &&
-      pValue.mTypeUsage.mType->mCategory == TypeCategory::BuiltIn &&
-      pValue.mTypeUsage.mType->mIdentifier.mName[0] == 'i';
+         StatementSwitch* statement = static_cast<StatementSwitch*>(pStatement);
+         writeCachedExpression(pWriter, statement->mCondition);
+         writeCacheValue(buffer, (uint32_t)statement->mCaseSections.size());
 
-   const size_t typeUsageSize = pValue.mTypeUsage.getSize();
-   int64_t valueAsInteger = 0;
+         for(size_t i = 0u; i < statement->mCaseSections.size(); i++)
+         {
+            const StatementSwitch::CaseSection& caseSection = statement->mCaseSections[i];
+            writeCachedExpression(pWriter, caseSection.mExpression);
+            writeCacheValue(buffer, (uint32_t)caseSection.mStatements.size());
 
-   if(typeUsageSize == sizeof(int32_t))
-   {
-      valueAsInteger = signedType
-         ? (int64_t)CflatValueAs(&pValue, int32_t)
-         : (int64_t)CflatValueAs(&pValue, uint32_t);
-   }
-   else if(typeUsageSize == sizeof(int64_t))
-   {
-      valueAsInteger = CflatValueAs(&pValue, int64_t);
-   }
-   else if(typeUsageSize == sizeof(int16_t))
-   {
-      valueAsInteger = signedType
-         ? (int64_t)CflatValueAs(&pValue, int16_t)
-         : (int64_t)CflatValueAs(&pValue, uint16_t);
-   }
-   else if(typeUsageSize == sizeof(int8_t))
-   {
-      valueAsInteger = signedType
-         ? (int64_t)CflatValueAs(&pValue, int8_t)
-         : (int64_t)CflatValueAs(&pValue, uint8_t);
+            for(size_t j = 0u; j < caseSection.mStatements.size(); j++)
+            {
+               writeCachedStatement(pWriter, caseSection.mStatements[j]);
+            }
+         }
+      }
+      break;
+   case StatementType::While:
+   case StatementType::DoWhile:
+      {
+         StatementWhile* statement = static_cast<StatementWhile*>(pStatement);
+         writeCachedExpression(pWriter, statement->mCondition);
+         writeCachedStatement(pWriter, statement->mLoopStatement);
+      }
+      break;
+   case StatementType::For:
+      {
+         StatementFor* statement = static_cast<StatementFor*>(pStatement);
+         writeCachedStatement(pWriter, statement->mInitialization);
+         writeCachedExpression(pWriter, statement->mCondition);
+         writeCachedExpression(pWriter, statement->mIncrement);
+         writeCachedStatement(pWriter, statement->mLoopStatement);
+      }
+      break;
+   case StatementType::ForRangeBased:
+      {
+         StatementForRangeBased* statement = static_cast<StatementForRangeBased*>(pStatement);
+         writeCachedTypeUsage(pWriter, buffer, statement->mVariableTypeUsage);
+         writeCacheValue(buffer, writeCachedString(pWriter, statement->mVariableIdentifier));
+         writeCachedExpression(pWriter, statement->mCollection);
+         writeCachedStatement(pWriter, statement->mLoopStatement);
+      }
+      break;
+   case StatementType::Break:
+   case StatementType::Continue:
+      break;
+   case StatementType::Return:
+      {
+         StatementReturn* statement = static_cast<StatementReturn*>(pStatement);
+         writeCachedExpression(pWriter, statement->mExpression);
+      }
+      break;
+   default:
+      // struct declarations register types whose methods are bound to their statements
+      pWriter.mSupported = false;
+      break;
    }
-   else
+}
+
+Identifier Environment::readCachedString(ProgramCacheReader& pReader)
+{
+   const uint32_t index = readCacheValue<uint32_t>(pReader);
+
+   if(index >= pReader.mStrings.size())
    {
-      CflatAssert(false); // Unsupported
+      pReader.mFailed = true;
+      return Identifier();
    }
 
-   return valueAsInteger;
+   return pReader.mStrings[index];
 }
 
-double Environment::getValueAsDecimal(const Value& pValue)
+TypeUsage Environment::readCachedTypeUsage(ProgramCacheReader& pReader)
 {
-   const size_t typeUsageSize = pValue.mTypeUsage.getSize();
-   double valueAsDecimal = 0.0;
+   TypeUsage typeUsage;
 
-   if(typeUsageSize == sizeof(float))
-   {
-      valueAsDecimal = (double)CflatValueAs(&pValue, float);
-   }
-   else if(typeUsageSize == sizeof(double))
-   {
-      valueAsDecimal = CflatValueAs(&pValue, double);
-   }
-   else
+   const uint32_t typeIndex = readCacheValue<uint32_t>(pReader);
+   typeUsage.mArraySize = readCacheValue<uint16_t>(pReader);
+   typeUsage.mPointerLevel = readCacheValue<uint8_t>(pReader);
+   typeUsage.mFlags = readCacheValue<uint8_t>(pReader);
+
+   if(typeIndex != kProgramCacheNullIndex)
    {
-      CflatAssert(false); // Unsupported
+      if(typeIndex < pReader.mTypes.size())
+      {
+         typeUsage.mType = pReader.mTypes[typeIndex];
+      }
+      else
+      {
+         pReader.mFailed = true;
+      }
    }
 
-   return valueAsDecimal;
+   return typeUsage;
 }
 
-void Environment::setValueAsInteger(int64_t pInteger, Value* pOutValue)
+Function* Environment::readCachedFunction(ProgramCacheReader& pReader)
 {
-   const size_t typeUsageSize = pOutValue->mTypeUsage.getSize();
+   const uint32_t index = readCacheValue<uint32_t>(pReader);
 
-   if(typeUsageSize == sizeof(int32_t))
-   {
-      const int32_t value = (int32_t)pInteger;
-      pOutValue->assign(&value);
-   }
-   else if(typeUsageSize == sizeof(int64_t))
-   {
-      pOutValue->assign(&pInteger);
-   }
-   else if(typeUsageSize == sizeof(int16_t))
+   if(pReader.mFailed || index >= pReader.mFunctions.size())
    {
-      const int16_t value = (int16_t)pInteger;
-      pOutValue->assign(&value);
+      pReader.mFailed = true;
+      return nullptr;
    }
-   else if(typeUsageSize == sizeof(int8_t))
+
+   if(!pReader.mFunctions[index])
    {
-      const int8_t value = (int8_t)pInteger;
-      pOutValue->assign(&value);
+      const char* cursor = pReader.mCursor;
+      pReader.mCursor = pReader.mFunctionEntries[index];
+
+      const bool isStaticMethod = readCacheValue<uint8_t>(pReader) != 0u;
+      const uint32_t ownerIndex = readCacheValue<uint32_t>(pReader);
+      const Identifier identifier = readCachedString(pReader);
+
+      CflatArgsVector(TypeUsage) parameterTypes;
+      CflatArgsVector(TypeUsage) templateTypes;
+
+      const uint32_t parameterTypesCount = readCacheValue<uint32_t>(pReader);
+
+      for(uint32_t i = 0u; i < parameterTypesCount && i < kArgsVectorSize; i++)
+      {
+         parameterTypes.push_back(readCachedTypeUsage(pReader));
+      }
+
+      const uint32_t templateTypesCount = readCacheValue<uint32_t>(pReader);
+
+      for(uint32_t i = 0u; i < templateTypesCount && i < kArgsVectorSize; i++)
+      {
+         templateTypes.push_back(readCachedTypeUsage(pReader));
+      }
+
+      pReader.mCursor = cursor;
+
+      Namespace* ns = nullptr;
+      Type* ownerType = nullptr;
+
+      if(isStaticMethod)
+      {
+         ownerType = ownerIndex < pReader.mTypes.size() ? pReader.mTypes[ownerIndex] : nullptr;
+      }
+      else
+      {
+         ns = ownerIndex < pReader.mStrings.size()
+            ? mGlobalNamespace.getNamespace(pReader.mStrings[ownerIndex])
+            : &mGlobalNamespace;
+      }
+
+      if(!pReader.mFailed)
+      {
+         pReader.mFunctions[index] =
+            findCachedFunction(ns, ownerType, identifier, parameterTypes, templateTypes);
+      }
    }
-   else
+
+   if(!pReader.mFunctions[index])
    {
-      CflatAssert(false); // Unsupported
+      pReader.mFailed = true;
    }
+
+   return pReader.mFunctions[index];
 }
 
-void Environment::setValueAsDecimal(double pDecimal, Value* pOutValue)
+Method* Environment::readCachedMethod(ProgramCacheReader& pReader, size_t* pOutOffset)
 {
-   const size_t typeUsageSize = pOutValue->mTypeUsage.getSize();
+   *pOutOffset = 0u;
 
-   if(typeUsageSize == sizeof(float))
-   {
-      const float value = (float)pDecimal;
-      pOutValue->assign(&value);
-   }
-   else if(typeUsageSize == sizeof(double))
+   const uint32_t typeIndex = readCacheValue<uint32_t>(pReader);
+
+   if(typeIndex == kProgramCacheNullIndex)
    {
-      pOutValue->assign(&pDecimal);
+      return nullptr;
    }
-   else
+
+   const uint32_t methodIndex = readCacheValue<uint32_t>(pReader);
+   *pOutOffset = (size_t)readCacheValue<uint32_t>(pReader);
+
+   Type* type = typeIndex < pReader.mTypes.size() ? pReader.mTypes[typeIndex] : nullptr;
+
+   if(!type ||
+      type->mCategory != TypeCategory::StructOrClass ||
+      methodIndex >= static_cast<Struct*>(type)->mMethods.size())
    {
-      CflatAssert(false); // Unsupported
+      pReader.mFailed = true;
+      return nullptr;
    }
+
+   return &static_cast<Struct*>(type)->mMethods[methodIndex];
 }
 
-void Environment::getTypeFullName(Type* pType, CflatSTLString* pOutString)
+Expression* Environment::readCachedExpression(ProgramCacheReader& pReader)
 {
-   if(pType->mNamespace->getFullIdentifier().mHash != 0u)
+   const uint8_t expressionType = readCacheValue<uint8_t>(pReader);
+
+   if(pReader.mFailed || expressionType == kProgramCacheNullNode)
    {
-      pOutString->append(pType->mNamespace->getFullIdentifier().mName);
-      pOutString->append("::");
+      return nullptr;
    }
 
-   pOutString->append(pType->mIdentifier.mName);
+   const TypeUsage typeUsage = readCachedTypeUsage(pReader);
+   Expression* expression = nullptr;
 
-   if(pType->mCategory == TypeCategory::StructOrClass)
+   switch((ExpressionType)expressionType)
    {
-      Struct* structOrClassType = static_cast<Struct*>(pType);
-      
-      if(!structOrClassType->mTemplateTypes.empty())
+   case ExpressionType::Value:
       {
-         pOutString->append("<");
+         const TypeUsage valueTypeUsage = readCachedTypeUsage(pReader);
 
-         for(size_t i = 0u; i < structOrClassType->mTemplateTypes.size(); i++)
+         if(pReader.mFailed || !valueTypeUsage.mType)
          {
-            if(i > 0u)
+            pReader.mFailed = true;
+            break;
+         }
+
+         Value value;
+         value.initOnStack(valueTypeUsage, &mExecutionContext.mStack);
+
+         if(valueTypeUsage == mTypeUsageCString || valueTypeUsage == mTypeUsageWideString)
+         {
+            uint32_t length = 0u;
+            const char* string = readCacheString(pReader, &length);
+
+            CflatSTLString& stringBuffer = mExecutionContext.mStringBuffer;
+            stringBuffer.assign(string, length);
+            const Hash stringHash = hash(stringBuffer.c_str());
+
+            if(valueTypeUsage == mTypeUsageCString)
             {
-               pOutString->append(", ");
+               const char* literalString =
+                  mLiteralStringsPool.registerString(stringHash, stringBuffer.c_str());
+               value.set(&literalString);
             }
+            else
+            {
+               const wchar_t* literalString =
+                  mLiteralWideStringsPool.registerString(stringHash, stringBuffer.c_str());
+               value.set(&literalString);
+            }
+         }
+         else
+         {
+            readCacheData(pReader, value.mValueBuffer, valueTypeUsage.getSize());
+         }
 
-            getTypeFullName(structOrClassType->mTemplateTypes[i].mType, pOutString);
+         expression = (ExpressionValue*)CflatMalloc(sizeof(ExpressionValue));
+         CflatInvokeCtor(ExpressionValue, expression)(value);
+      }
+      break;
+   case ExpressionType::NullPointer:
+      {
+         expression = (ExpressionNullPointer*)CflatMalloc(sizeof(ExpressionNullPointer));
+         CflatInvokeCtor(ExpressionNullPointer, expression)(typeUsage);
+      }
+      break;
+   case ExpressionType::VariableAccess:
+      {
+         const Identifier variableIdentifier = readCachedString(pReader);
+         const uint32_t staticValueIndex = readCacheValue<uint32_t>(pReader);
+
+         ExpressionVariableAccess* variableAccess =
+            (ExpressionVariableAccess*)CflatMalloc(sizeof(ExpressionVariableAccess));
+         CflatInvokeCtor(ExpressionVariableAccess, variableAccess)(variableIdentifier, typeUsage);
+         expression = variableAccess;
+
+         if(staticValueIndex != kProgramCacheNullIndex)
+         {
+            if(staticValueIndex < pReader.mStaticValues.size())
+            {
+               variableAccess->mStaticValue = pReader.mStaticValues[staticValueIndex];
+            }
+            else
+            {
+               pReader.mFailed = true;
+            }
          }
+      }
+      break;
+   case ExpressionType::MemberAccess:
+      {
+         Expression* memberOwner = readCachedExpression(pReader);
+         const Identifier memberIdentifier = readCachedString(pReader);
 
-         pOutString->append(">");
+         ExpressionMemberAccess* memberAccess =
+            (ExpressionMemberAccess*)CflatMalloc(sizeof(ExpressionMemberAccess));
+         CflatInvokeCtor(ExpressionMemberAccess, memberAccess)(memberOwner, memberIdentifier);
+         memberAccess->mMemberAccessType = (MemberAccessType)readCacheValue<uint8_t>(pReader);
+         memberAccess->assignTypeUsage(typeUsage);
+
+         expression = memberAccess;
       }
-   }
-}
+      break;
+   case ExpressionType::ArrayElementAccess:
+      {
+         Expression* array = readCachedExpression(pReader);
+         Expression* arrayElementIndex = readCachedExpression(pReader);
 
-bool Environment::doAllExecutionPathsReturn(Statement* pStatement)
-{
-   if(pStatement->getType() == StatementType::Return)
-   {
-      return true;
-   }
+         expression =
+            (ExpressionArrayElementAccess*)CflatMalloc(sizeof(ExpressionArrayElementAccess));
+         CflatInvokeCtor(ExpressionArrayElementAccess, expression)
+            (array, arrayElementIndex, typeUsage);
+      }
+      break;
+   case ExpressionType::UnaryOperation:
+      {
+         Expression* operand = readCachedExpression(pReader);
 
-   if(pStatement->getType() == StatementType::Block)
-   {
-      StatementBlock* blockStatement = static_cast<StatementBlock*>(pStatement);
+         char unaryOperator[sizeof(ExpressionUnaryOperation::mOperator)];
+         readCacheData(pReader, unaryOperator, sizeof(unaryOperator));
+         unaryOperator[sizeof(unaryOperator) - 1u] = '\0';
 
-      for(int i = (int)blockStatement->mStatements.size() - 1; i >= 0; i--)
+         const bool postOperator = readCacheValue<uint8_t>(pReader) != 0u;
+
+         expression = (ExpressionUnaryOperation*)CflatMalloc(sizeof(ExpressionUnaryOperation));
+         CflatInvokeCtor(ExpressionUnaryOperation, expression)
+            (operand, unaryOperator, postOperator, typeUsage);
+      }
+      break;
+   case ExpressionType::BinaryOperation:
       {
-         if(doAllExecutionPathsReturn(blockStatement->mStatements[i]))
+         Expression* left = readCachedExpression(pReader);
+         Expression* right = readCachedExpression(pReader);
+
+         char binaryOperator[sizeof(ExpressionBinaryOperation::mOperator)];
+         readCacheData(pReader, binaryOperator, sizeof(binaryOperator));
+         binaryOperator[sizeof(binaryOperator) - 1u] = '\0';
+
+         expression = (ExpressionBinaryOperation*)CflatMalloc(sizeof(ExpressionBinaryOperation));
+         CflatInvokeCtor(ExpressionBinaryOperation, expression)
+            (left, right, binaryOperator, typeUsage);
+      }
+      break;
+   case ExpressionType::Parenthesized:
+      {
+         Expression* innerExpression = readCachedExpression(pReader);
+
+         if(!innerExpression)
          {
-            return true;
+            pReader.mFailed = true;
+            break;
          }
+
+         expression = (ExpressionParenthesized*)CflatMalloc(sizeof(ExpressionParenthesized));
+         CflatInvokeCtor(ExpressionParenthesized, expression)(innerExpression);
       }
-   }
+      break;
+   case ExpressionType::SizeOf:
+      {
+         ExpressionSizeOf* sizeOf = (ExpressionSizeOf*)CflatMalloc(sizeof(ExpressionSizeOf));
+         CflatInvokeCtor(ExpressionSizeOf, sizeOf)(typeUsage);
+         sizeOf->mSizeOfTypeUsage = readCachedTypeUsage(pReader);
+         sizeOf->mSizeOfExpression = readCachedExpression(pReader);
 
-   if(pStatement->getType() == StatementType::If)
-   {
-      StatementIf* ifStatement = static_cast<StatementIf*>(pStatement);
+         expression = sizeOf;
+      }
+      break;
+   case ExpressionType::Cast:
+      {
+         const CastType castType = (CastType)readCacheValue<uint8_t>(pReader);
+         Expression* castExpression = readCachedExpression(pReader);
 
-      return
-         ifStatement->mElseStatement &&
-         doAllExecutionPathsReturn(ifStatement->mIfStatement) &&
-         doAllExecutionPathsReturn(ifStatement->mElseStatement);
-   }
+         expression = (ExpressionCast*)CflatMalloc(sizeof(ExpressionCast));
+         CflatInvokeCtor(ExpressionCast, expression)(castType, typeUsage, castExpression);
+      }
+      break;
+   case ExpressionType::Conditional:
+      {
+         Expression* condition = readCachedExpression(pReader);
+         Expression* ifExpression = readCachedExpression(pReader);
+         Expression* elseExpression = readCachedExpression(pReader);
 
-   if(pStatement->getType() == StatementType::Switch)
-   {
-      StatementSwitch* switchStatement = static_cast<StatementSwitch*>(pStatement);
-      
-      const bool containsDefaultSection =
-         switchStatement->mCaseSections.back().mExpression == nullptr;
+         expression = (ExpressionConditional*)CflatMalloc(sizeof(ExpressionConditional));
+         CflatInvokeCtor(ExpressionConditional, expression)
+            (condition, ifExpression, elseExpression);
+      }
+      break;
+   case ExpressionType::Assignment:
+      {
+         Expression* leftValue = readCachedExpression(pReader);
+         Expression* rightValue = readCachedExpression(pReader);
 
-      if(containsDefaultSection)
+         char assignmentOperator[sizeof(ExpressionAssignment::mOperator)];
+         readCacheData(pReader, assignmentOperator, sizeof(assignmentOperator));
+         assignmentOperator[sizeof(assignmentOperator) - 1u] = '\0';
+
+         if(!rightValue)
+         {
+            if(leftValue)
+            {
+               CflatInvokeDtor(Expression, leftValue);
+               CflatFree(leftValue);
+            }
+
+            pReader.mFailed = true;
+            break;
+         }
+
+         expression = (ExpressionAssignment*)CflatMalloc(sizeof(ExpressionAssignment));
+         CflatInvokeCtor(ExpressionAssignment, expression)
+            (leftValue, rightValue, assignmentOperator);
+      }
+      break;
+   case ExpressionType::FunctionCall:
       {
-         bool allExecutionPathsInSwitchReturn = true;
+         const Identifier functionIdentifier = readCachedString(pReader);
 
-         for(size_t i = 0u; i < switchStatement->mCaseSections.size(); i++)
+         ExpressionFunctionCall* functionCall =
+            (ExpressionFunctionCall*)CflatMalloc(sizeof(ExpressionFunctionCall));
+         CflatInvokeCtor(ExpressionFunctionCall, functionCall)(functionIdentifier);
+         expression = functionCall;
+
+         const uint32_t argumentsCount = readCacheValue<uint32_t>(pReader);
+
+         for(uint32_t i = 0u; i < argumentsCount && !pReader.mFailed; i++)
          {
-            const StatementSwitch::CaseSection& caseSection = switchStatement->mCaseSections[i];
-            bool allExecutionPathsInCaseSectionReturn = false;
+            functionCall->mArguments.push_back(readCachedExpression(pReader));
+         }
+
+         const uint32_t templateTypesCount = readCacheValue<uint32_t>(pReader);
+
+         for(uint32_t i = 0u; i < templateTypesCount && !pReader.mFailed; i++)
+         {
+            functionCall->mTemplateTypes.push_back(readCachedTypeUsage(pReader));
+         }
+
+         functionCall->mFunction = readCachedFunction(pReader);
+
+         if(functionCall->mFunction)
+         {
+            functionCall->assignTypeUsage(mTypeUsageVoid);
+         }
+      }
+      break;
+   case ExpressionType::MethodCall:
+      {
+         Expression* memberAccess = readCachedExpression(pReader);
+
+         ExpressionMethodCall* methodCall =
+            (ExpressionMethodCall*)CflatMalloc(sizeof(ExpressionMethodCall));
+         CflatInvokeCtor(ExpressionMethodCall, methodCall)(memberAccess);
+         expression = methodCall;
+
+         const uint32_t argumentsCount = readCacheValue<uint32_t>(pReader);
+
+         for(uint32_t i = 0u; i < argumentsCount && !pReader.mFailed; i++)
+         {
+            methodCall->mArguments.push_back(readCachedExpression(pReader));
+         }
 
-            for(int j = (int)caseSection.mStatements.size() - 1; j >= 0; j--)
-            {
-               if(doAllExecutionPathsReturn(caseSection.mStatements[j]))
-               {
-                  allExecutionPathsInCaseSectionReturn = true;
-                  break;
-               }
-            }
+         const uint32_t templateTypesCount = readCacheValue<uint32_t>(pReader);
 
-            if(!allExecutionPathsInCaseSectionReturn)
-            {
-               allExecutionPathsInSwitchReturn = false;
-               break;
-            }
+         for(uint32_t i = 0u; i < templateTypesCount && !pReader.mFailed; i++)
+         {
+            methodCall->mTemplateTypes.push_back(readCachedTypeUsage(pReader));
          }
 
-         return allExecutionPathsInSwitchReturn;
+         methodCall->mMethodUsage.mMethod =
+            readCachedMethod(pReader, &methodCall->mMethodUsage.mOffset);
+
+         if(methodCall->mMethodUsage.mMethod)
+         {
+            methodCall->assignTypeUsage(mTypeUsageVoid);
+         }
+         else
+         {
+            pReader.mFailed = true;
+         }
       }
-   }
+      break;
+   case ExpressionType::ArrayInitialization:
+      {
+         ExpressionArrayInitialization* arrayInitialization =
+            (ExpressionArrayInitialization*)CflatMalloc(sizeof(ExpressionArrayInitialization));
+         CflatInvokeCtor(ExpressionArrayInitialization, arrayInitialization);
+         expression = arrayInitialization;
 
-   return false;
-}
+         arrayInitialization->mElementTypeUsage = readCachedTypeUsage(pReader);
 
-void Environment::initArgumentsForFunctionCall(Function* pFunction, CflatArgsVector(Value)& pArgs)
-{
-   pArgs.resize(pFunction->mParameters.size());
+         const uint32_t valuesCount = readCacheValue<uint32_t>(pReader);
 
-   for(size_t i = 0u; i < pFunction->mParameters.size(); i++)
-   {
-      const TypeUsage& typeUsage = pFunction->mParameters[i];
+         for(uint32_t i = 0u; i < valuesCount && !pReader.mFailed; i++)
+         {
+            arrayInitialization->mValues.push_back(readCachedExpression(pReader));
+         }
 
-      if(typeUsage.isReference())
+         arrayInitialization->assignTypeUsage();
+      }
+      break;
+   case ExpressionType::AggregateInitialization:
       {
-         pArgs[i].initExternal(typeUsage);
+         ExpressionAggregateInitialization* aggregateInitialization =
+            (ExpressionAggregateInitialization*)CflatMalloc(sizeof(ExpressionAggregateInitialization));
+         CflatInvokeCtor(ExpressionAggregateInitialization, aggregateInitialization)
+            (typeUsage.mType);
+         expression = aggregateInitialization;
+
+         const uint32_t valuesCount = readCacheValue<uint32_t>(pReader);
+
+         for(uint32_t i = 0u; i < valuesCount && !pReader.mFailed; i++)
+         {
+            aggregateInitialization->mValues.push_back(readCachedExpression(pReader));
+         }
       }
-      else
+      break;
+   case ExpressionType::ObjectConstruction:
       {
-         pArgs[i].initOnStack(typeUsage, &mExecutionContext.mStack);
+         ExpressionObjectConstruction* objectConstruction =
+            (ExpressionObjectConstruction*)CflatMalloc(sizeof(ExpressionObjectConstruction));
+         CflatInvokeCtor(ExpressionObjectConstruction, objectConstruction)(typeUsage.mType);
+         expression = objectConstruction;
+
+         const uint32_t argumentsCount = readCacheValue<uint32_t>(pReader);
+
+         for(uint32_t i = 0u; i < argumentsCount && !pReader.mFailed; i++)
+         {
+            objectConstruction->mArguments.push_back(readCachedExpression(pReader));
+         }
+
+         size_t offset = 0u;
+         objectConstruction->mConstructor = readCachedMethod(pReader, &offset);
       }
+      break;
+   default:
+      pReader.mFailed = true;
+      break;
    }
-}
-
-bool Environment::tryCallDefaultConstructor(ExecutionContext& pContext, Instance* pInstance, Type* pType, size_t pOffset)
-{
-   CflatAssert(pType->mCategory == TypeCategory::StructOrClass);
-   Struct* type = static_cast<Struct*>(pType);
-   Method* defaultCtor = type->getDefaultConstructor();
 
-   if(!defaultCtor)
+   // The type usage gets deduced again when building the expression, and it must match
+   if(expression && !pReader.mFailed && expression->getTypeUsage() != typeUsage)
    {
-      return false;
+      pReader.mFailed = true;
    }
 
-   Value thisPtr;
-   thisPtr.mValueInitializationHint = ValueInitializationHint::Stack;
-   getAddressOfValue(pContext, pInstance->mValue, &thisPtr);
-
-   if(pOffset > 0)
+   if(expression && pReader.mFailed)
    {
-      const char* offsetThisPtr = CflatValueAs(&thisPtr, char*) + pOffset;
-      memcpy(thisPtr.mValueBuffer, &offsetThisPtr, sizeof(char*));
+      CflatInvokeDtor(Expression, expression);
+      CflatFree(expression);
+      expression = nullptr;
    }
 
-   CflatArgsVector(Value) args;
-   defaultCtor->execute(thisPtr, args, nullptr);
-
-   return true;
+   return expression;
 }
 
-void Environment::execute(ExecutionContext& pContext, Statement* pStatement)
+Statement* Environment::readCachedStatement(ProgramCacheReader& pReader, ParsingContext& pContext)
 {
-   if(!mErrorMessage.empty())
-      return;
-
-   pContext.mProgram = pStatement->mProgram;
-
-   pContext.mCallStack.back().mProgram = pStatement->mProgram;
-   pContext.mCallStack.back().mLine = pStatement->mLine;
+   const uint8_t statementType = readCacheValue<uint8_t>(pReader);
 
-   if(mExecutionHook)
+   if(pReader.mFailed || statementType == kProgramCacheNullNode)
    {
-      mExecutionHook(this, pContext.mCallStack);
+      return nullptr;
    }
 
-   switch(pStatement->getType())
+   const uint16_t line = readCacheValue<uint16_t>(pReader);
+   Statement* statement = nullptr;
+
+   // Declarations in the global scope get registered as the parser would do
+   switch((StatementType)statementType)
    {
    case StatementType::Expression:
       {
-         StatementExpression* statement = static_cast<StatementExpression*>(pStatement);
+         Expression* expression = readCachedExpression(pReader);
 
-         Value unusedValue;
-         unusedValue.mValueInitializationHint = ValueInitializationHint::Stack;
-         evaluateExpression(pContext, statement->mExpression, &unusedValue);
+         statement = (StatementExpression*)CflatMalloc(sizeof(StatementExpression));
+         CflatInvokeCtor(StatementExpression, statement)(expression);
       }
       break;
    case StatementType::Block:
       {
-         StatementBlock* statement = static_cast<StatementBlock*>(pStatement);
+         const bool alterScope = readCacheValue<uint8_t>(pReader) != 0u;
 
-         incrementBlockLevel(pContext);
+         StatementBlock* block = (StatementBlock*)CflatMalloc(sizeof(StatementBlock));
+         CflatInvokeCtor(StatementBlock, block)(alterScope);
+         statement = block;
 
-         if(statement->mAlterScope)
+         const uint32_t statementsCount = readCacheValue<uint32_t>(pReader);
+
+         if(alterScope)
          {
-            incrementScopeLevel(pContext);
+            pReader.mScopeLevel++;
          }
 
-         for(size_t i = 0u; i < statement->mStatements.size(); i++)
+         for(uint32_t i = 0u; i < statementsCount && !pReader.mFailed; i++)
          {
-            execute(pContext, statement->mStatements[i]);
+            Statement* blockStatement = readCachedStatement(pReader, pContext);
 
-            if(pContext.mJumpStatement != JumpStatement::None)
+            if(blockStatement)
             {
-               break;
+               block->mStatements.push_back(blockStatement);
             }
          }
 
-         if(statement->mAlterScope)
+         if(alterScope)
          {
-            decrementScopeLevel(pContext);
+            pReader.mScopeLevel--;
          }
-
-         decrementBlockLevel(pContext);
       }
       break;
    case StatementType::UsingDirective:
       {
-         StatementUsingDirective* statement =
-            static_cast<StatementUsingDirective*>(pStatement);
+         const bool isNamespace = readCacheValue<uint8_t>(pReader) != 0u;
 
-         if(statement->mNamespace)
+         if(isNamespace)
          {
-            UsingDirective usingDirective(statement->mNamespace);
-            usingDirective.mBlockLevel = pContext.mBlockLevel;
-            pContext.mUsingDirectives.push_back(usingDirective);
+            Namespace* ns = mGlobalNamespace.getNamespace(readCachedString(pReader));
+
+            if(!ns)
+            {
+               pReader.mFailed = true;
+               break;
+            }
+
+            statement = (StatementUsingDirective*)CflatMalloc(sizeof(StatementUsingDirective));
+            CflatInvokeCtor(StatementUsingDirective, statement)(ns);
          }
          else
          {
-            registerTypeAlias(pContext, statement->mAliasIdentifier, statement->mAliasTypeUsage);
+            const Identifier alias = readCachedString(pReader);
+            const TypeUsage typeUsage = readCachedTypeUsage(pReader);
+
+            if(pReader.mScopeLevel == 0u && !pReader.mFailed)
+            {
+               registerTypeAlias(pContext, alias, typeUsage);
+            }
+
+            statement = (StatementUsingDirective*)CflatMalloc(sizeof(StatementUsingDirective));
+            CflatInvokeCtor(StatementUsingDirective, statement)(alias, typeUsage);
          }
       }
       break;
    case StatementType::TypeDefinition:
       {
-         StatementTypeDefinition* statement =
-            static_cast<StatementTypeDefinition*>(pStatement);
+         const Identifier alias = readCachedString(pReader);
+         const TypeUsage typeUsage = readCachedTypeUsage(pReader);
 
-         TypeAlias typeAlias(statement->mAlias, statement->mReferencedTypeUsage);
-         typeAlias.mScopeLevel = pContext.mScopeLevel;
-         pContext.mTypeAliases.push_back(typeAlias);
+         if(pReader.mScopeLevel == 0u && !pReader.mFailed)
+         {
+            registerTypeAlias(pContext, alias, typeUsage);
+         }
+
+         statement = (StatementTypeDefinition*)CflatMalloc(sizeof(StatementTypeDefinition));
+         CflatInvokeCtor(StatementTypeDefinition, statement)(alias, typeUsage);
+      }
+      break;
+   case StatementType::VariableDeclaration:
+      {
+         const TypeUsage typeUsage = readCachedTypeUsage(pReader);
+         const Identifier variableIdentifier = readCachedString(pReader);
+         const bool isStatic = readCacheValue<uint8_t>(pReader) != 0u;
+         Expression* initialValue = readCachedExpression(pReader);
+
+         if(pReader.mScopeLevel == 0u && !pReader.mFailed && typeUsage.mType)
+         {
+            registerInstance(pContext, typeUsage, variableIdentifier);
+
+            if(isStatic && typeUsage.isConst() && initialValue)
+            {
+               Instance* execInstance =
+                  registerInstance(mExecutionContext, typeUsage, variableIdentifier);
+
+               Value value;
+               value.mValueInitializationHint = ValueInitializationHint::Stack;
+               evaluateExpression(mExecutionContext, initialValue, &value);
+
+               assignValue(mExecutionContext, value, &execInstance->mValue, true);
+            }
+         }
+
+         statement =
+            (StatementVariableDeclaration*)CflatMalloc(sizeof(StatementVariableDeclaration));
+         CflatInvokeCtor(StatementVariableDeclaration, statement)
+            (typeUsage, variableIdentifier, initialValue, isStatic);
+
+         if(isStatic)
+         {
+            pReader.mStaticValues.push_back(
+               &static_cast<StatementVariableDeclaration*>(statement)->mStaticValue);
+         }
       }
       break;
    case StatementType::NamespaceDeclaration:
       {
-         StatementNamespaceDeclaration* statement =
-            static_cast<StatementNamespaceDeclaration*>(pStatement);
-         Namespace* ns =
-            pContext.mNamespaceStack.back()->requestNamespace(statement->mNamespaceIdentifier);
+         const Identifier nsIdentifier = readCachedString(pReader);
+
+         if(pReader.mFailed)
+         {
+            break;
+         }
+
+         StatementNamespaceDeclaration* namespaceDeclaration =
+            (StatementNamespaceDeclaration*)CflatMalloc(sizeof(StatementNamespaceDeclaration));
+         CflatInvokeCtor(StatementNamespaceDeclaration, namespaceDeclaration)(nsIdentifier);
+         statement = namespaceDeclaration;
 
+         Namespace* ns = pContext.mNamespaceStack.back()->requestNamespace(nsIdentifier);
          pContext.mNamespaceStack.push_back(ns);
-         execute(pContext, statement->mBody);
+         mExecutionContext.mNamespaceStack.push_back(ns);
+
+         Statement* body = readCachedStatement(pReader, pContext);
+
+         mExecutionContext.mNamespaceStack.pop_back();
          pContext.mNamespaceStack.pop_back();
+
+         if(body && body->getType() == StatementType::Block)
+         {
+            namespaceDeclaration->mBody = static_cast<StatementBlock*>(body);
+         }
+         else if(body)
+         {
+            CflatInvokeDtor(Statement, body);
+            CflatFree(body);
+            pReader.mFailed = true;
+         }
       }
       break;
-   case StatementType::VariableDeclaration:
+   case StatementType::FunctionDeclaration:
       {
-         StatementVariableDeclaration* statement = static_cast<StatementVariableDeclaration*>(pStatement);
+         const TypeUsage returnType = readCachedTypeUsage(pReader);
+         const Identifier functionIdentifier = readCachedString(pReader);
+         const bool isStatic = readCacheValue<uint8_t>(pReader) != 0u;
 
-         const bool isLocalStaticVariable = statement->mStatic && pContext.mScopeLevel > 0u;
+         StatementFunctionDeclaration* functionDeclaration =
+            (StatementFunctionDeclaration*)CflatMalloc(sizeof(StatementFunctionDeclaration));
+         CflatInvokeCtor(StatementFunctionDeclaration, functionDeclaration)
+            (returnType, functionIdentifier);
+         statement = functionDeclaration;
 
-         Instance* instance;
-         bool instanceValueUninitialized = true;
+         const uint32_t parametersCount = readCacheValue<uint32_t>(pReader);
 
-         if(isLocalStaticVariable)
+         if(parametersCount > kArgsVectorSize)
+         {
+            pReader.mFailed = true;
+            break;
+         }
+
+         for(uint32_t i = 0u; i < parametersCount; i++)
          {
-            instance =
-               pContext.mNamespaceStack.back()->registerInstance(statement->mTypeUsage, statement->mVariableIdentifier);
-            instance->mScopeLevel = pContext.mScopeLevel;
+            functionDeclaration->mParameterTypes.push_back(readCachedTypeUsage(pReader));
+            functionDeclaration->mParameterIdentifiers.push_back(readCachedString(pReader));
+         }
 
-            const uint64_t uniqueID = (uint64_t)statement;
-            StaticValuesRegistry::const_iterator it = mLocalStaticValues.find(uniqueID);
+         if(pReader.mFailed)
+         {
+            break;
+         }
 
-            if(it == mLocalStaticValues.end())
-            {
-               mLocalStaticValues[uniqueID] = Value();
-               mLocalStaticValues[uniqueID].initOnHeap(statement->mTypeUsage);
-            }
-            else
+         CflatArgsVector(TypeUsage) parameterTypes;
+         toArgsVector(functionDeclaration->mParameterTypes, parameterTypes);
+
+         Namespace* ns = pContext.mNamespaceStack.back();
+         Function* function = ns->getFunctionPerfectMatch(functionIdentifier, parameterTypes);
+
+         if(!function)
+         {
+            Memory::CategoryScope categoryScope(Memory::Category::Function);
+
+            function = ns->registerFunction(functionIdentifier);
+            function->mProgram = pContext.mProgram;
+            function->mLine = line;
+
+            for(size_t i = 0u; i < functionDeclaration->mParameterTypes.size(); i++)
             {
-               instanceValueUninitialized = false;
+               function->mParameters.push_back(functionDeclaration->mParameterTypes[i]);
+               function->mParameterIdentifiers.push_back(
+                  functionDeclaration->mParameterIdentifiers[i]);
             }
+         }
 
-            instance->mValue = mLocalStaticValues[uniqueID];
+         function->mReturnTypeUsage = returnType;
+
+         if(isStatic)
+         {
+            CflatSetFlag(function->mFlags, FunctionFlags::Static);
          }
          else
          {
-            instance = registerInstance(pContext, statement->mTypeUsage, statement->mVariableIdentifier);
+            CflatResetFlag(function->mFlags, FunctionFlags::Static);
          }
 
-         if(instanceValueUninitialized)
+         Statement* body = readCachedStatement(pReader, pContext);
+
+         if(body && body->getType() == StatementType::Block)
          {
-            const bool isStructOrClassInstance =
-               instance->mTypeUsage.mType &&
-               instance->mTypeUsage.mType->mCategory == TypeCategory::StructOrClass &&
-               !instance->mTypeUsage.isPointer() &&
-               !instance->mTypeUsage.isReference();
+            functionDeclaration->mBody = static_cast<StatementBlock*>(body);
+         }
+         else if(body)
+         {
+            CflatInvokeDtor(Statement, body);
+            CflatFree(body);
+            pReader.mFailed = true;
+         }
+      }
+      break;
+   case StatementType::If:
+      {
+         Expression* condition = readCachedExpression(pReader);
+         Statement* ifStatement = readCachedStatement(pReader, pContext);
+         Statement* elseStatement = readCachedStatement(pReader, pContext);
 
-            if(isStructOrClassInstance)
-            {
-               const bool defaultCtorCalled = tryCallDefaultConstructor(pContext, instance, instance->mTypeUsage.mType);
+         statement = (StatementIf*)CflatMalloc(sizeof(StatementIf));
+         CflatInvokeCtor(StatementIf, statement)(condition, ifStatement, elseStatement);
+      }
+      break;
+   case StatementType::Switch:
+      {
+         Expression* condition = readCachedExpression(pReader);
 
-               if(!defaultCtorCalled)
-               {
-                  Struct* structOrClassType = static_cast<Struct*>(instance->mTypeUsage.mType);
+         StatementSwitch* switchStatement = (StatementSwitch*)CflatMalloc(sizeof(StatementSwitch));
+         CflatInvokeCtor(StatementSwitch, switchStatement)(condition);
+         statement = switchStatement;
 
-                  for(size_t i = 0u; i < structOrClassType->mMembers.size(); i++)
-                  {
-                     Member* member = structOrClassType->mMembers[i];
+         const uint32_t caseSectionsCount = readCacheValue<uint32_t>(pReader);
 
-                     const bool isMemberStructOrClassInstance =
-                         member->mTypeUsage.mType &&
-                         member->mTypeUsage.mType->mCategory == TypeCategory::StructOrClass &&
-                         !member->mTypeUsage.isPointer() &&
-                         !member->mTypeUsage.isReference();
+         for(uint32_t i = 0u; i < caseSectionsCount && !pReader.mFailed; i++)
+         {
+            switchStatement->mCaseSections.emplace_back();
+            StatementSwitch::CaseSection& caseSection = switchStatement->mCaseSections.back();
+            caseSection.mExpression = readCachedExpression(pReader);
 
-                     if(!isMemberStructOrClassInstance)
-                     {
-                        continue;
-                     }
+            const uint32_t statementsCount = readCacheValue<uint32_t>(pReader);
 
-                     CflatAssert(member->mMemberType == MemberType::Field);
-                     Field* field = static_cast<Field*>(member);
+            for(uint32_t j = 0u; j < statementsCount && !pReader.mFailed; j++)
+            {
+               Statement* caseStatement = readCachedStatement(pReader, pContext);
 
-                     tryCallDefaultConstructor(pContext, instance, member->mTypeUsage.mType, field->mOffset);
-                  }
+               if(caseStatement)
+               {
+                  caseSection.mStatements.push_back(caseStatement);
                }
             }
+         }
+      }
+      break;
+   case StatementType::While:
+      {
+         Expression* condition = readCachedExpression(pReader);
+         Statement* loopStatement = readCachedStatement(pReader, pContext);
 
-            if(statement->mInitialValue)
-            {
-               // Special case: reference from dereferenced pointer
-               if(statement->mTypeUsage.isReference() &&
-                  !statement->mTypeUsage.isConst() &&
-                  statement->mInitialValue->getType() == ExpressionType::UnaryOperation &&
-                  static_cast<ExpressionUnaryOperation*>(statement->mInitialValue)->mOperator[0] == '*')
-               {
-                  Expression* deferencedExpression =
-                     static_cast<ExpressionUnaryOperation*>(statement->mInitialValue)->mExpression;
-                  CflatAssert(deferencedExpression->getTypeUsage().isPointer());
+         statement = (StatementWhile*)CflatMalloc(sizeof(StatementWhile));
+         CflatInvokeCtor(StatementWhile, statement)(condition, loopStatement);
+      }
+      break;
+   case StatementType::DoWhile:
+      {
+         Expression* condition = readCachedExpression(pReader);
+         Statement* loopStatement = readCachedStatement(pReader, pContext);
 
-                  Value initialValueAddress;
-                  initialValueAddress.mTypeUsage = deferencedExpression->getTypeUsage();
-                  initialValueAddress.mValueInitializationHint = ValueInitializationHint::Stack;
-                  evaluateExpression(pContext, deferencedExpression, &initialValueAddress);
+         statement = (StatementDoWhile*)CflatMalloc(sizeof(StatementDoWhile));
+         CflatInvokeCtor(StatementDoWhile, statement)(condition, loopStatement);
+      }
+      break;
+   case StatementType::For:
+      {
+         pReader.mScopeLevel++;
 
-                  CflatAssert(instance->mValue.mValueBufferType == ValueBufferType::External);
-                  instance->mValue.mValueBuffer = CflatValueAs(&initialValueAddress, char*);
-               }
-               // Regular case
-               else
-               {
-                  Value initialValue;
-                  initialValue.mTypeUsage = instance->mTypeUsage;
-                  initialValue.mValueInitializationHint = ValueInitializationHint::Stack;
-                  evaluateExpression(pContext, statement->mInitialValue, &initialValue);
+         Statement* initialization = readCachedStatement(pReader, pContext);
+         Expression* condition = readCachedExpression(pReader);
+         Expression* increment = readCachedExpression(pReader);
+         Statement* loopStatement = readCachedStatement(pReader, pContext);
+
+         pReader.mScopeLevel--;
+
+         statement = (StatementFor*)CflatMalloc(sizeof(StatementFor));
+         CflatInvokeCtor(StatementFor, statement)
+            (initialization, condition, increment, loopStatement);
+      }
+      break;
+   case StatementType::ForRangeBased:
+      {
+         pReader.mScopeLevel++;
 
-                  const bool initialValueIsArray = initialValue.mTypeUsage.isArray();
-                  initialValue.mTypeUsage.mFlags = instance->mTypeUsage.mFlags;
+         const TypeUsage variableTypeUsage = readCachedTypeUsage(pReader);
+         const Identifier variableIdentifier = readCachedString(pReader);
+         Expression* collection = readCachedExpression(pReader);
+         Statement* loopStatement = readCachedStatement(pReader, pContext);
 
-                  if(initialValueIsArray)
-                  {
-                     CflatSetFlag(initialValue.mTypeUsage.mFlags, TypeUsageFlags::Array);
-                  }
+         pReader.mScopeLevel--;
 
-                  assignValue(pContext, initialValue, &instance->mValue, !isLocalStaticVariable);
-               }
-            }
-         }
+         statement = (StatementForRangeBased*)CflatMalloc(sizeof(StatementForRangeBased));
+         CflatInvokeCtor(StatementForRangeBased, statement)
+            (variableTypeUsage, variableIdentifier, collection, loopStatement);
       }
       break;
-   case StatementType::FunctionDeclaration:
+   case StatementType::Break:
       {
-         StatementFunctionDeclaration* statement = static_cast<StatementFunctionDeclaration*>(pStatement);
+         statement = (StatementBreak*)CflatMalloc(sizeof(StatementBreak));
+         CflatInvokeCtor(StatementBreak, statement);
+      }
+      break;
+   case StatementType::Continue:
+      {
+         statement = (StatementContinue*)CflatMalloc(sizeof(StatementContinue));
+         CflatInvokeCtor(StatementContinue, statement);
+      }
+      break;
+   case StatementType::Return:
+      {
+         Expression* expression = readCachedExpression(pReader);
 
-         CflatArgsVector(TypeUsage) parameterTypes;
-         toArgsVector(statement->mParameterTypes, parameterTypes);
+         statement = (StatementReturn*)CflatMalloc(sizeof(StatementReturn));
+         CflatInvokeCtor(StatementReturn, statement)(expression);
+      }
+      break;
+   default:
+      pReader.mFailed = true;
+      break;
+   }
 
-         Namespace* functionNS = pContext.mNamespaceStack.back();
-         Function* function = functionNS->getFunction(statement->mFunctionIdentifier, parameterTypes);
-         CflatAssert(function);
+   if(statement)
+   {
+      statement->mProgram = pContext.mProgram;
+      statement->mLine = line;
 
-         function->mProgram = statement->mProgram;
-         function->mLine = statement->mLine;
+      if(pReader.mFailed)
+      {
+         CflatInvokeDtor(Statement, statement);
+         CflatFree(statement);
+         statement = nullptr;
+      }
+   }
 
-         statement->mFunction = function;
+   return statement;
+}
 
-         if(statement->mBody)
-         {
-            function->mUsingDirectives = pContext.mUsingDirectives;
-            function->execute =
-               [this, &pContext, function, functionNS, statement]
-               (const CflatArgsVector(Value)& pArguments, Value* pOutReturnValue)
-            {
-               CflatAssert(function->mParameters.size() == pArguments.size());
+const char* Environment::getErrorMessage()
+{
+   return mErrorMessage.empty() ? nullptr : mErrorMessage.c_str();
+}
 
-               mErrorMessage.clear();
+void Environment::setExecutionHook(ExecutionHook pExecutionHook)
+{
+   mExecutionHook = pExecutionHook;
+}
 
-               const bool mustReturnValue = function->mReturnTypeUsage != mTypeUsageVoid;
-               
-               if(mustReturnValue)
-               {
-                  if(pOutReturnValue)
-                  {
-                     assertValueInitialization(pContext, function->mReturnTypeUsage, pOutReturnValue);
-                  }
+bool Environment::evaluateExpression(const char* pExpression, Value* pOutValue)
+{
+   AccessScope accessScope(this, AccessType::Execute);
+   Memory::AllocatorScope allocatorScope(&mAllocator);
 
-                  pContext.mReturnValues.push_back(pOutReturnValue);
-               }
+   if(mCompiledExpressionsMacrosGeneration != mMacrosGeneration ||
+      mCompiledExpressionsRegistrationGeneration != mRegistrationGeneration)
+   {
+      releaseCompiledExpressions();
+      mCompiledExpressionsMacrosGeneration = mMacrosGeneration;
+      mCompiledExpressionsRegistrationGeneration = mRegistrationGeneration;
+   }
 
-               pContext.mNamespaceStack.push_back(functionNS);
+   const uint64_t scopeFingerprint = getScopeFingerprint(mExecutionContext);
 
-               for(size_t i = 0u; i < pArguments.size(); i++)
-               {
-                  const TypeUsage parameterType = statement->mParameterTypes[i];
-                  const Identifier& parameterIdentifier = statement->mParameterIdentifiers[i];
+   uint64_t key = getCodeFingerprint(pExpression, strlen(pExpression));
+   addToCodeFingerprint(&key, &scopeFingerprint, sizeof(scopeFingerprint));
+   addToCodeFingerprint(&key, &mRegistrationGeneration, sizeof(mRegistrationGeneration));
 
-                  pContext.mScopeLevel++;
-                  Instance* argumentInstance =
-                     registerInstance(pContext, parameterType, parameterIdentifier);
-                  pContext.mScopeLevel--;
+   CompiledExpressionsRegistry::iterator it = mCompiledExpressions.find(key);
 
-                  assignValue(pContext, pArguments[i], &argumentInstance->mValue, true);
-               }
+   if(it == mCompiledExpressions.end() ||
+      it->second.mScopeFingerprint != scopeFingerprint ||
+      it->second.mText != pExpression)
+   {
+      Expression* compiled = compileExpression(pExpression);
 
-               for(size_t i = 0u; i < function->mUsingDirectives.size(); i++)
-               {
-                  pContext.mUsingDirectives.push_back(function->mUsingDirectives[i]);
-                  pContext.mUsingDirectives.back().mBlockLevel = 0u;
-               }
+      if(!compiled)
+      {
+         mErrorMessage.clear();
+         return false;
+      }
 
-               pContext.mCallStack.emplace_back(statement->mProgram, function);
+      if(mCompiledExpressions.size() >= kMaxCompiledExpressions)
+      {
+         releaseCompiledExpressions();
+      }
 
-               execute(pContext, statement->mBody);
+      CompiledExpression& compiledExpression = mCompiledExpressions[key];
 
-               pContext.mCallStack.pop_back();
+      if(compiledExpression.mExpression)
+      {
+         CflatInvokeDtor(Expression, compiledExpression.mExpression);
+         CflatFree(compiledExpression.mExpression);
+      }
 
-               for(size_t i = 0u; i < function->mUsingDirectives.size(); i++)
-               {
-                  pContext.mUsingDirectives.pop_back();
-               }
+      compiledExpression.mText.assign(pExpression);
+      compiledExpression.mScopeFingerprint = scopeFingerprint;
+      compiledExpression.mExpression = compiled;
 
-               if(mExecutionHook && pContext.mCallStack.empty())
-               {
-                  mExecutionHook(this, pContext.mCallStack);
-               }
+      it = mCompiledExpressions.find(key);
+   }
 
-               pContext.mNamespaceStack.pop_back();
+   CflatAssert(pOutValue);
+   evaluateExpression(mExecutionContext, it->second.mExpression, pOutValue);
+   mErrorMessage.clear();
 
-               if(mustReturnValue)
-               {
-                  pContext.mReturnValues.pop_back();
-               }
+   return pOutValue->mValueBufferType != ValueBufferType::Uninitialized;
+}
 
-               pContext.mJumpStatement = JumpStatement::None;
-            };
-         }
-      }
-      break;
-   case StatementType::If:
-      {
-         StatementIf* statement = static_cast<StatementIf*>(pStatement);
+uint64_t Environment::getScopeFingerprint(const ExecutionContext& pContext) const
+{
+   uint64_t fingerprint = kCodeFingerprintBasis;
 
-         Value conditionValue;
-         conditionValue.mValueInitializationHint = ValueInitializationHint::Stack;
-         evaluateExpression(pContext, statement->mCondition, &conditionValue);
+   addToCodeFingerprint(&fingerprint, &pContext.mProgram, sizeof(pContext.mProgram));
+   addToCodeFingerprint(&fingerprint, &pContext.mNamespaceStack.back(), sizeof(Namespace*));
 
-         if(getValueAsInteger(conditionValue))
-         {
-            execute(pContext, statement->mIfStatement);
-         }
-         else if(statement->mElseStatement)
-         {
-            execute(pContext, statement->mElseStatement);
-         }
-      }
-      break;
-   case StatementType::Switch:
+   for(size_t i = 0u; i < pContext.mUsingDirectives.size(); i++)
+   {
+      const Namespace* ns = pContext.mUsingDirectives[i].mNamespace;
+      addToCodeFingerprint(&fingerprint, &ns, sizeof(ns));
+   }
+
+   // names and types of the visible local instances, which is all the parser needs from them
+   const InstancesHolder& instancesHolder = pContext.mLocalInstancesHolder;
+
+   for(uint32_t i = 0u; i < instancesHolder.mInstancesCount; i++)
+   {
+      // mixed in whole words, since this runs on every evaluation
+      const Instance* instance = instancesHolder.getInstance(i);
+      const TypeUsage& typeUsage = instance->mTypeUsage;
+      const uint64_t instanceWords[2] =
       {
-         StatementSwitch* statement = static_cast<StatementSwitch*>(pStatement);
+         (uint64_t)(uintptr_t)typeUsage.mType,
+         ((uint64_t)instance->mIdentifier.mHash << 32u) |
+            ((uint64_t)typeUsage.mArraySize << 16u) |
+            ((uint64_t)typeUsage.mPointerLevel << 8u) |
+            (uint64_t)typeUsage.mFlags
+      };
 
-         Value conditionValue;
-         conditionValue.mValueInitializationHint = ValueInitializationHint::Stack;
-         evaluateExpression(pContext, statement->mCondition, &conditionValue);
+      for(size_t j = 0u; j < 2u; j++)
+      {
+         fingerprint ^= instanceWords[j];
+         fingerprint *= kCodeFingerprintPrime;
+      }
+   }
 
-         const int64_t conditionValueAsInteger = getValueAsInteger(conditionValue);
-         bool statementExecution = false;
+   return fingerprint;
+}
 
-         for(size_t i = 0u; i < statement->mCaseSections.size(); i++)
-         {
-            const StatementSwitch::CaseSection& caseSection = statement->mCaseSections[i];
+Expression* Environment::compileExpression(const char* pExpression)
+{
+   ParsingContext parsingContext(&mGlobalNamespace);
+   parsingContext.mProgram = mExecutionContext.mProgram;
+   parsingContext.mScopeLevel = mExecutionContext.mScopeLevel;
+   parsingContext.mNamespaceStack = mExecutionContext.mNamespaceStack;
+   parsingContext.mUsingDirectives = mExecutionContext.mUsingDirectives;
 
-            if(!statementExecution)
-            {
-               // case
-               if(caseSection.mExpression)
-               {
-                  Value caseValue;
-                  caseValue.mValueInitializationHint = ValueInitializationHint::Stack;
-                  evaluateExpression(pContext, caseSection.mExpression, &caseValue);
+   preprocess(parsingContext, pExpression);
 
-                  const int64_t caseValueAsInteger = getValueAsInteger(caseValue);
+   CflatSTLVector(Token)& tokens = parsingContext.mTokens;
+   Expression* expression = nullptr;
 
-                  if(caseValueAsInteger == conditionValueAsInteger)
-                  {
-                     statementExecution = true;
-                  }
-               }
-               // default
-               else
-               {
-                  statementExecution = true;
-               }
-            }
+   if(!tokens.empty())
+   {
+      // the local instances are lent to the parser instead of copied, since the parser only
+      // looks them up; swapping the containers does not move the instances in memory
+      InstancesHolder& localInstances = mExecutionContext.mLocalInstancesHolder;
+      parsingContext.mLocalInstancesHolder.swapInstances(&localInstances);
 
-            if(statementExecution)
-            {
-               for(size_t j = 0u; j < caseSection.mStatements.size(); j++)
-               {
-                  execute(pContext, caseSection.mStatements[j]);
+      expression = parseExpression(parsingContext, tokens.size() - 1u, true);
 
-                  if(pContext.mJumpStatement == JumpStatement::Break)
-                  {
-                     break;
-                  }
-               }
-            }
+      parsingContext.mLocalInstancesHolder.swapInstances(&localInstances);
+   }
 
-            if(pContext.mJumpStatement == JumpStatement::Break)
-            {
-               pContext.mJumpStatement = JumpStatement::None;
-               break;
-            }
-         }
-      }
-      break;
-   case StatementType::While:
+   return expression;
+}
+
+void Environment::releaseCompiledExpressions()
+{
+   for(CompiledExpressionsRegistry::iterator it = mCompiledExpressions.begin();
+      it != mCompiledExpressions.end(); it++)
+   {
+      if(it->second.mExpression)
       {
-         StatementWhile* statement = static_cast<StatementWhile*>(pStatement);
+         CflatInvokeDtor(Expression, it->second.mExpression);
+         CflatFree(it->second.mExpression);
+      }
+   }
 
-         Value conditionValue;
-         conditionValue.mValueInitializationHint = ValueInitializationHint::Stack;
-         evaluateExpression(pContext, statement->mCondition, &conditionValue);
+   mCompiledExpressions.clear();
+}
 
-         while(getValueAsInteger(conditionValue))
-         {
-            execute(pContext, statement->mLoopStatement);
+void Environment::setProfilingEnabled(bool pEnabled)
+{
+   AccessScope accessScope(this, AccessType::Write);
 
-            if(!mErrorMessage.empty())
-            {
-               break;
-            }
+   if(pEnabled && mProfiles.empty())
+   {
+      mProfilingStartTime = getProfilerTime();
+   }
 
-            if(pContext.mJumpStatement == JumpStatement::Continue)
-            {
-               pContext.mJumpStatement = JumpStatement::None;
-            }
-            else if(pContext.mJumpStatement == JumpStatement::Break)
-            {
-               pContext.mJumpStatement = JumpStatement::None;
-               break;
-            }
+   mProfilingEnabled = pEnabled;
+   mExecutionContext.mProfile = pEnabled ? acquireProfile(0u) : nullptr;
 
-            evaluateExpression(pContext, statement->mCondition, &conditionValue);
-         }
-      }
-      break;
-   case StatementType::DoWhile:
+   for(size_t i = 0u; i < mParallelWorkers.size(); i++)
+   {
+      mParallelWorkers[i]->mContext.mProfile = pEnabled ? acquireProfile((uint32_t)i + 1u) : nullptr;
+   }
+}
+
+bool Environment::isProfilingEnabled() const
+{
+   return mProfilingEnabled;
+}
+
+void Environment::resetProfile()
+{
+   AccessScope accessScope(this, AccessType::Write);
+   Memory::AllocatorScope allocatorScope(&mAllocator);
+
+   for(size_t i = 0u; i < mProfiles.size(); i++)
+   {
+      if(mProfiles[i])
       {
-         StatementDoWhile* statement = static_cast<StatementDoWhile*>(pStatement);
+         mProfiles[i]->reset();
+      }
+   }
 
-         Value conditionValue;
-         conditionValue.mValueInitializationHint = ValueInitializationHint::Stack;
+   mProfilingStartTime = getProfilerTime();
+}
 
-         do
-         {
-            execute(pContext, statement->mLoopStatement);
+void Environment::getProfileStats(ProfileStats* pOutStats) const
+{
+   AccessScope accessScope(this, AccessType::Execute);
+   CflatAssert(pOutStats);
 
-            if(!mErrorMessage.empty())
-            {
-               break;
-            }
+   pOutStats->mFunctions.clear();
 
-            if(pContext.mJumpStatement == JumpStatement::Continue)
-            {
-               pContext.mJumpStatement = JumpStatement::None;
-            }
-            else if(pContext.mJumpStatement == JumpStatement::Break)
-            {
-               pContext.mJumpStatement = JumpStatement::None;
-               break;
-            }
+   // the same function reached through different call paths or threads gets a single entry
+   CflatSTLMap(Hash, size_t) entryIndices;
+
+   for(size_t i = 0u; i < mProfiles.size(); i++)
+   {
+      if(!mProfiles[i])
+         continue;
 
-            evaluateExpression(pContext, statement->mCondition, &conditionValue);
-         }
-         while(getValueAsInteger(conditionValue));
-      }
-      break;
-   case StatementType::For:
-      {
-         StatementFor* statement = static_cast<StatementFor*>(pStatement);
+      const CflatSTLVector(ExecutionProfile::Node)& nodes = mProfiles[i]->mNodes;
 
-         incrementScopeLevel(pContext);
+      for(uint32_t j = 1u; j < (uint32_t)nodes.size(); j++)
+      {
+         const ExecutionProfile::Node& node = nodes[j];
+         CflatSTLMap(Hash, size_t)::iterator it = entryIndices.find(node.mName.mHash);
 
-         if(statement->mInitialization)
+         if(it == entryIndices.end())
          {
-            execute(pContext, statement->mInitialization);
+            ProfileStats::FunctionEntry entry;
+            entry.mName = node.mName;
+            entry.mCallsCount = 0u;
+            entry.mInclusiveTime = 0u;
+            entry.mExclusiveTime = 0u;
+            pOutStats->mFunctions.push_back(entry);
+
+            it = entryIndices.insert(std::make_pair(node.mName.mHash, pOutStats->mFunctions.size() - 1u)).first;
          }
 
+         ProfileStats::FunctionEntry& entry = pOutStats->mFunctions[it->second];
+         entry.mCallsCount += node.mCallsCount;
+         entry.mExclusiveTime += node.mInclusiveTime - node.mChildrenTime;
+
+         // the time of recursive calls is already part of the outermost call
+         bool recursive = false;
+
+         for(uint32_t k = node.mParent; k != 0u && !recursive; k = nodes[k].mParent)
          {
-            const bool defaultConditionValue = true;
+            recursive = nodes[k].mName == node.mName;
+         }
 
-            Value conditionValue;
-            conditionValue.initOnStack(mTypeUsageBool, &pContext.mStack);
-            conditionValue.set(&defaultConditionValue);
+         if(!recursive)
+         {
+            entry.mInclusiveTime += node.mInclusiveTime;
+         }
+      }
+   }
 
-            bool conditionMet = defaultConditionValue;
+   std::sort(pOutStats->mFunctions.begin(), pOutStats->mFunctions.end(),
+      [](const ProfileStats::FunctionEntry& pA, const ProfileStats::FunctionEntry& pB)
+      {
+         return pA.mExclusiveTime > pB.mExclusiveTime;
+      });
+}
 
-            if(statement->mCondition)
-            {
-               evaluateExpression(pContext, statement->mCondition, &conditionValue);
-               conditionMet = getValueAsInteger(conditionValue) != 0;
-            }
+void Environment::exportProfileTrace(CflatSTLString* pOutTrace) const
+{
+   AccessScope accessScope(this, AccessType::Execute);
+   CflatAssert(pOutTrace);
 
-            while(conditionMet)
-            {
-               execute(pContext, statement->mLoopStatement);
+   char buffer[kDefaultLocalStringBufferSize];
 
-               if(!mErrorMessage.empty())
-               {
-                  break;
-               }
+   pOutTrace->assign("{\"traceEvents\":[");
+   bool firstEvent = true;
 
-               if(pContext.mJumpStatement == JumpStatement::Continue)
-               {
-                  pContext.mJumpStatement = JumpStatement::None;
-               }
-               else if(pContext.mJumpStatement == JumpStatement::Break)
-               {
-                  pContext.mJumpStatement = JumpStatement::None;
-                  break;
-               }
+   for(size_t i = 0u; i < mProfiles.size(); i++)
+   {
+      const ExecutionProfile* profile = mProfiles[i];
 
-               if(statement->mIncrement)
-               {
-                  Value unusedValue;
-                  evaluateExpression(pContext, statement->mIncrement, &unusedValue);
-               }
+      if(!profile)
+         continue;
 
-               if(statement->mCondition)
-               {
-                  evaluateExpression(pContext, statement->mCondition, &conditionValue);
-                  conditionMet = getValueAsInteger(conditionValue) != 0;
-               }
-            }
-         }
+      // the first profile belongs to the environment's execution context
+      char threadName[kSmallLocalStringBufferSize * 2u];
 
-         decrementScopeLevel(pContext);
+      if(profile->mThreadIndex == 0u)
+      {
+         snprintf(threadName, sizeof(threadName), "Cflat");
       }
-      break;
-   case StatementType::ForRangeBased:
+      else
       {
-         StatementForRangeBased* statement = static_cast<StatementForRangeBased*>(pStatement);
+         snprintf(threadName, sizeof(threadName), "Cflat worker %u", profile->mThreadIndex);
+      }
 
-         incrementScopeLevel(pContext);
+      snprintf(buffer, sizeof(buffer),
+         "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,"
+         "\"args\":{\"name\":\"%s\"}}",
+         firstEvent ? "" : ",", profile->mThreadIndex, threadName);
+      pOutTrace->append(buffer);
+      firstEvent = false;
 
-         {
-            Instance* elementInstance = registerInstance(
-               pContext, statement->mVariableTypeUsage, statement->mVariableIdentifier);
+      // identifiers do not contain characters that need to be escaped
+      for(size_t j = 0u; j < profile->mTraceEvents.size(); j++)
+      {
+         const ExecutionProfile::TraceEvent& traceEvent = profile->mTraceEvents[j];
 
-            Value collectionDataValue;
-            collectionDataValue.mValueInitializationHint = ValueInitializationHint::Stack;
-            getInstanceDataValue(pContext, statement->mCollection, &collectionDataValue);
+         pOutTrace->append(",\n{\"name\":\"");
+         pOutTrace->append(profile->mNodes[traceEvent.mNode].mName.mName);
 
-            Value collectionThisValue;
-            collectionThisValue.mValueInitializationHint = ValueInitializationHint::Stack;
-            getAddressOfValue(pContext, collectionDataValue, &collectionThisValue);
+         snprintf(buffer, sizeof(buffer),
+            "\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+            profile->mThreadIndex,
+            (double)(traceEvent.mStartTime - mProfilingStartTime) / 1000.0,
+            (double)traceEvent.mDuration / 1000.0);
+         pOutTrace->append(buffer);
+      }
+   }
 
-            if(collectionDataValue.mTypeUsage.isArray())
-            {
-               size_t elementIndex = 0u;
+   pOutTrace->append("\n],\"displayTimeUnit\":\"ns\"}\n");
+}
 
-               while(elementIndex < collectionDataValue.mTypeUsage.mArraySize)
-               {
-                  const size_t arrayElementSize = statement->mVariableTypeUsage.getSize();
-                  const char* arrayElementData =
-                     collectionDataValue.mValueBuffer + (arrayElementSize * elementIndex);
-                  elementInstance->mValue.set(arrayElementData);
+void Environment::exportProfileFoldedStacks(CflatSTLString* pOutStacks) const
+{
+   AccessScope accessScope(this, AccessType::Execute);
+   CflatAssert(pOutStacks);
 
-                  execute(pContext, statement->mLoopStatement);
+   pOutStacks->clear();
 
-                  if(pContext.mJumpStatement == JumpStatement::Continue)
-                  {
-                     pContext.mJumpStatement = JumpStatement::None;
-                  }
-                  else if(pContext.mJumpStatement == JumpStatement::Break)
-                  {
-                     pContext.mJumpStatement = JumpStatement::None;
-                     break;
-                  }
+   char buffer[kDefaultLocalStringBufferSize];
+   CflatSTLVector(uint32_t) path;
 
-                  elementIndex++;
-               }
-            }
-            else
-            {
-               Struct* collectionType = static_cast<Struct*>(collectionDataValue.mTypeUsage.mType);
+   for(size_t i = 0u; i < mProfiles.size(); i++)
+   {
+      if(!mProfiles[i])
+         continue;
 
-               Method* collectionBeginMethod =
-                  collectionType->findMethod("begin", TypeUsage::kEmptyList());
-               Value iteratorValue;
-               iteratorValue.initOnStack(collectionBeginMethod->mReturnTypeUsage, &pContext.mStack);
-               collectionBeginMethod->execute(collectionThisValue, Value::kEmptyList(), &iteratorValue);
+      const CflatSTLVector(ExecutionProfile::Node)& nodes = mProfiles[i]->mNodes;
 
-               Method* collectionEndMethod =
-                  collectionType->findMethod("end", TypeUsage::kEmptyList());
-               Value collectionEndValue;
-               collectionEndValue.initOnStack(collectionEndMethod->mReturnTypeUsage, &pContext.mStack);
-               collectionEndMethod->execute(collectionThisValue, Value::kEmptyList(), &collectionEndValue);
+      for(uint32_t j = 1u; j < (uint32_t)nodes.size(); j++)
+      {
+         const uint64_t exclusiveTime = nodes[j].mInclusiveTime - nodes[j].mChildrenTime;
 
-               Type* iteratorType = collectionBeginMethod->mReturnTypeUsage.mType;
+         if(exclusiveTime == 0u)
+            continue;
 
-               Value conditionValue;
-               conditionValue.initOnStack(mTypeUsageBool, &pContext.mStack);
-               applyBinaryOperator(pContext, iteratorValue, collectionEndValue, "!=", &conditionValue);
+         path.clear();
 
-               while(CflatValueAs(&conditionValue, bool))
-               {
-                  applyUnaryOperator(pContext, iteratorValue, "*", &elementInstance->mValue);
+         for(uint32_t k = j; k != 0u; k = nodes[k].mParent)
+         {
+            path.push_back(k);
+         }
 
-                  execute(pContext, statement->mLoopStatement);
+         for(size_t k = path.size(); k > 0u; k--)
+         {
+            pOutStacks->append(nodes[path[k - 1u]].mName.mName);
+            pOutStacks->append(k > 1u ? ";" : " ");
+         }
 
-                  if(!mErrorMessage.empty())
-                  {
-                     break;
-                  }
+         snprintf(buffer, sizeof(buffer), "%llu\n", (unsigned long long)exclusiveTime);
+         pOutStacks->append(buffer);
+      }
+   }
+}
 
-                  if(pContext.mJumpStatement == JumpStatement::Continue)
-                  {
-                     pContext.mJumpStatement = JumpStatement::None;
-                  }
-                  else if(pContext.mJumpStatement == JumpStatement::Break)
-                  {
-                     pContext.mJumpStatement = JumpStatement::None;
-                     break;
-                  }
+void Environment::setLineCountingEnabled(bool pEnabled)
+{
+   AccessScope accessScope(this, AccessType::Write);
+   Memory::AllocatorScope allocatorScope(&mAllocator);
 
-                  applyUnaryOperator(pContext, iteratorValue, "++", &iteratorValue);
-                  applyBinaryOperator(pContext, iteratorValue, collectionEndValue, "!=", &conditionValue);
-               }
-            }
-         }
+   mLineCountingEnabled = pEnabled;
 
-         decrementScopeLevel(pContext);
+   if(pEnabled)
+   {
+      for(ProgramsRegistry::const_iterator it = mPrograms.begin(); it != mPrograms.end(); it++)
+      {
+         allocateLineCounters(it->second);
+      }
+   }
+}
+
+bool Environment::isLineCountingEnabled() const
+{
+   return mLineCountingEnabled;
+}
+
+void Environment::resetLineCounters()
+{
+   AccessScope accessScope(this, AccessType::Write);
+
+   for(ProgramsRegistry::const_iterator it = mPrograms.begin(); it != mPrograms.end(); it++)
+   {
+      const Program* program = it->second;
+
+      for(uint32_t i = 0u; i < program->mLineCountersCount; i++)
+      {
+         program->mLineCounters[i].mExecutionsCount.store(0u, std::memory_order_relaxed);
+         program->mLineCounters[i].mTime.store(0u, std::memory_order_relaxed);
+      }
+   }
+}
+
+// Flags the lines containing statements, including the nested ones, as accounted by the line
+// counters (the braces of the blocks do not count)
+static void collectStatementLines(const Statement* pStatement, CflatSTLVector(uint8_t)* pOutLines)
+{
+   if(!pStatement)
+      return;
+
+   if(pStatement->getType() != StatementType::Block && pStatement->mLine < pOutLines->size())
+   {
+      (*pOutLines)[pStatement->mLine] = 1u;
+   }
+
+   switch(pStatement->getType())
+   {
+   case StatementType::Block:
+      {
+         const StatementBlock* statement = static_cast<const StatementBlock*>(pStatement);
+
+         for(size_t i = 0u; i < statement->mStatements.size(); i++)
+         {
+            collectStatementLines(statement->mStatements[i], pOutLines);
+         }
       }
       break;
-   case StatementType::Break:
+   case StatementType::NamespaceDeclaration:
       {
-         pContext.mJumpStatement = JumpStatement::Break;
+         const StatementNamespaceDeclaration* statement =
+            static_cast<const StatementNamespaceDeclaration*>(pStatement);
+         collectStatementLines(statement->mBody, pOutLines);
       }
       break;
-   case StatementType::Continue:
+   case StatementType::FunctionDeclaration:
       {
-         pContext.mJumpStatement = JumpStatement::Continue;
+         const StatementFunctionDeclaration* statement =
+            static_cast<const StatementFunctionDeclaration*>(pStatement);
+         collectStatementLines(statement->mBody, pOutLines);
       }
       break;
-   case StatementType::Return:
+   case StatementType::If:
       {
-         StatementReturn* statement = static_cast<StatementReturn*>(pStatement);
+         const StatementIf* statement = static_cast<const StatementIf*>(pStatement);
+         collectStatementLines(statement->mIfStatement, pOutLines);
+         collectStatementLines(statement->mElseStatement, pOutLines);
+      }
+      break;
+   case StatementType::Switch:
+      {
+         const StatementSwitch* statement = static_cast<const StatementSwitch*>(pStatement);
 
-         if(statement->mExpression)
+         for(size_t i = 0u; i < statement->mCaseSections.size(); i++)
          {
-            Value returnValue;
-            returnValue.mValueInitializationHint = ValueInitializationHint::Stack;
-            evaluateExpression(pContext, statement->mExpression, &returnValue);
+            const StatementSwitch::CaseSection& caseSection = statement->mCaseSections[i];
 
-            assignValue(pContext, returnValue, pContext.mReturnValues.back(), true);
+            for(size_t j = 0u; j < caseSection.mStatements.size(); j++)
+            {
+               collectStatementLines(caseSection.mStatements[j], pOutLines);
+            }
          }
-
-         pContext.mJumpStatement = JumpStatement::Return;
+      }
+      break;
+   case StatementType::While:
+   case StatementType::DoWhile:
+      {
+         const StatementWhile* statement = static_cast<const StatementWhile*>(pStatement);
+         collectStatementLines(statement->mLoopStatement, pOutLines);
+      }
+      break;
+   case StatementType::For:
+      {
+         const StatementFor* statement = static_cast<const StatementFor*>(pStatement);
+         collectStatementLines(statement->mInitialization, pOutLines);
+         collectStatementLines(statement->mLoopStatement, pOutLines);
+      }
+      break;
+   case StatementType::ForRangeBased:
+      {
+         const StatementForRangeBased* statement =
+            static_cast<const StatementForRangeBased*>(pStatement);
+         collectStatementLines(statement->mLoopStatement, pOutLines);
       }
       break;
    default:
@@ -9691,303 +17510,491 @@ void Environment::execute(ExecutionContext& pContext, Statement* pStatement)
    }
 }
 
-void Environment::assignReturnValueFromFunctionCall(const TypeUsage& pReturnTypeUsage,
-   const void* pReturnValue, Value* pOutValue)
+void Environment::getLinesReport(LinesReport* pOutReport, size_t pHottestLinesCount) const
 {
-   bool assigned = false;
+   AccessScope accessScope(this, AccessType::Execute);
+   CflatAssert(pOutReport);
 
-   if(pReturnTypeUsage.mType->mCategory == TypeCategory::StructOrClass &&
-      !pReturnTypeUsage.isReference() &&
-      !pReturnTypeUsage.isPointer())
+   pOutReport->mPrograms.clear();
+
+   CflatSTLVector(uint8_t) executableLines;
+
+   for(ProgramsRegistry::const_iterator it = mPrograms.begin(); it != mPrograms.end(); it++)
    {
-      Struct* returnType = static_cast<Struct*>(pReturnTypeUsage.mType);
-      Method* copyCtor = returnType->getCopyConstructor();
+      const Program* program = it->second;
 
-      if(copyCtor)
-      {
-         TypeUsage typeUsageReference;
-         typeUsageReference.mType = returnType;
-         typeUsageReference.mFlags |= (uint8_t)TypeUsageFlags::Reference;
+      if(!program->mLineCounters)
+         continue;
 
-         TypeUsage thisPtrTypeUsage;
-         thisPtrTypeUsage.mType = returnType;
-         thisPtrTypeUsage.mPointerLevel = 1u;
+      executableLines.assign(program->mLineCountersCount, 0u);
 
-         Value thisPtrValue;
-         thisPtrValue.initExternal(thisPtrTypeUsage);
-         thisPtrValue.set(&pOutValue->mValueBuffer);
+      for(size_t i = 0u; i < program->mStatements.size(); i++)
+      {
+         collectStatementLines(program->mStatements[i], &executableLines);
+      }
 
-         Method* defaultCtor = returnType->getDefaultConstructor();
+      pOutReport->mPrograms.emplace_back();
+      LinesReport::ProgramEntry& programEntry = pOutReport->mPrograms.back();
+      programEntry.mProgram = program;
+      programEntry.mExecutableLinesCount = 0u;
+      programEntry.mExecutedLinesCount = 0u;
 
-         if(defaultCtor)
+      for(uint32_t i = 0u; i < program->mLineCountersCount; i++)
+      {
+         const LineCounter& lineCounter = program->mLineCounters[i];
+         const uint32_t executionsCount = lineCounter.mExecutionsCount.load(std::memory_order_relaxed);
+
+         if(executableLines[i])
          {
-            defaultCtor->execute(thisPtrValue, Value::kEmptyList(), nullptr);
-         }
+            programEntry.mExecutableLinesCount++;
 
-         Value referenceValue;
-         referenceValue.initExternal(typeUsageReference);
-         referenceValue.set(pReturnValue);
+            if(executionsCount == 0u)
+            {
+               programEntry.mUncoveredLines.push_back(i);
+            }
+         }
 
-         CflatArgsVector(Value) args;
-         args.push_back(referenceValue);
-         copyCtor->execute(thisPtrValue, args, nullptr);
+         if(executionsCount > 0u)
+         {
+            programEntry.mExecutedLinesCount++;
 
-         assigned = true;
+            LinesReport::LineEntry lineEntry;
+            lineEntry.mLine = i;
+            lineEntry.mExecutionsCount = executionsCount;
+            lineEntry.mTime = lineCounter.mTime.load(std::memory_order_relaxed);
+            programEntry.mHottestLines.push_back(lineEntry);
+         }
       }
-   }
 
-   if(!assigned)
-   {
-      pOutValue->set(pReturnValue);
+      std::sort(programEntry.mHottestLines.begin(), programEntry.mHottestLines.end(),
+         [](const LinesReport::LineEntry& pA, const LinesReport::LineEntry& pB)
+         {
+            return pA.mTime > pB.mTime;
+         });
+
+      if(programEntry.mHottestLines.size() > pHottestLinesCount)
+      {
+         programEntry.mHottestLines.resize(pHottestLinesCount);
+      }
    }
 }
 
-Namespace* Environment::getGlobalNamespace()
+void Environment::setAllocationTrackingEnabled(bool pEnabled)
 {
-   return &mGlobalNamespace;
-}
+   AccessScope accessScope(this, AccessType::Write);
 
-Namespace* Environment::getNamespace(const Identifier& pIdentifier)
-{
-   return mGlobalNamespace.getNamespace(pIdentifier);
-}
+   mAllocationTrackingEnabled = pEnabled;
 
-Namespace* Environment::requestNamespace(const Identifier& pIdentifier)
-{
-   return mGlobalNamespace.requestNamespace(pIdentifier);
+   mAllocator.mHook = pEnabled ? onAllocation : nullptr;
+   mAllocator.mHookData = this;
 }
 
-void Environment::registerTypeAlias(const Identifier& pIdentifier, const TypeUsage& pTypeUsage)
+bool Environment::isAllocationTrackingEnabled() const
 {
-   mGlobalNamespace.registerTypeAlias(pIdentifier, pTypeUsage);
+   return mAllocationTrackingEnabled;
 }
 
-Type* Environment::getType(const Identifier& pIdentifier) const
+void Environment::resetAllocationReport()
 {
-   return mGlobalNamespace.getType(pIdentifier);
-}
+   AccessScope accessScope(this, AccessType::Write);
 
-Type* Environment::getType(const Identifier& pIdentifier, const CflatArgsVector(TypeUsage)& pTemplateTypes) const
-{
-   return mGlobalNamespace.getType(pIdentifier, pTemplateTypes);
+   gRecordingAllocation = true;
+   mAllocationEntries.clear();
+   gRecordingAllocation = false;
 }
 
-TypeUsage Environment::getTypeUsage(const char* pTypeName, Namespace* pNamespace) const
+void Environment::getAllocationReport(AllocationReport* pOutReport) const
 {
-   if(!pTypeName || pTypeName[0] == '\0')
+   AccessScope accessScope(this, AccessType::Execute);
+   CflatAssert(pOutReport);
+
+   // the report might be requested from a native function called by script code
+   gRecordingAllocation = true;
+
    {
-      return TypeUsage();
+      std::lock_guard<std::mutex> lock(const_cast<Environment*>(this)->mAllocationsMutex);
+      pOutReport->mEntries.assign(mAllocationEntries.begin(), mAllocationEntries.end());
    }
 
-   ParsingContext parsingContext(const_cast<Namespace*>(&mGlobalNamespace));
-
-   parsingContext.mNamespaceStack.clear();
-   parsingContext.mNamespaceStack.push_back(pNamespace ? pNamespace : const_cast<Namespace*>(&mGlobalNamespace));
+   gRecordingAllocation = false;
 
-   parsingContext.mPreprocessedCode.assign(pTypeName);
-   parsingContext.mPreprocessedCode.push_back('\n');
+   pOutReport->mAllocationsCount = 0u;
+   pOutReport->mBytes = 0u;
 
-   tokenize(parsingContext);
+   for(size_t i = 0u; i < pOutReport->mEntries.size(); i++)
+   {
+      pOutReport->mAllocationsCount += pOutReport->mEntries[i].mAllocationsCount;
+      pOutReport->mBytes += pOutReport->mEntries[i].mBytes;
+   }
 
-   return parseTypeUsage(parsingContext, 0u);
+   std::sort(pOutReport->mEntries.begin(), pOutReport->mEntries.end(),
+      [](const AllocationReport::Entry& pA, const AllocationReport::Entry& pB)
+      {
+         return pA.mAllocationsCount > pB.mAllocationsCount;
+      });
 }
 
-Function* Environment::registerFunction(const Identifier& pIdentifier)
+void Environment::getExecutionCounters(ExecutionCounters* pOutCounters) const
 {
-   return mGlobalNamespace.registerFunction(pIdentifier);
-}
+   AccessScope accessScope(this, AccessType::Execute);
+   CflatAssert(pOutCounters);
 
-Function* Environment::getFunction(const Identifier& pIdentifier) const
-{
-   return mGlobalNamespace.getFunction(pIdentifier);
-}
+   *pOutCounters = mExecutionContext.mCounters;
+   pOutCounters->mStackPeakBytes =
+      (size_t)(mExecutionContext.mStack.mPeakPointer - mExecutionContext.mStack.mMemory);
 
-Function* Environment::getFunction(const Identifier& pIdentifier,
-   const CflatArgsVector(TypeUsage)& pParameterTypes) const
-{
-   return mGlobalNamespace.getFunction(pIdentifier, pParameterTypes);
-}
+   for(size_t i = 0u; i < mParallelWorkers.size(); i++)
+   {
+      const ExecutionContext& context = mParallelWorkers[i]->mContext;
 
-Function* Environment::getFunction(const Identifier& pIdentifier,
-   const CflatArgsVector(Value)& pArguments) const
-{
-   return mGlobalNamespace.getFunction(pIdentifier, pArguments);
-}
+      ExecutionCounters counters = context.mCounters;
+      counters.mStackPeakBytes = (size_t)(context.mStack.mPeakPointer - context.mStack.mMemory);
+      pOutCounters->add(counters);
+   }
 
-CflatSTLVector(Function*)* Environment::getFunctions(const Identifier& pIdentifier) const
-{
-   return mGlobalNamespace.getFunctions(pIdentifier);
-}
+   for(size_t i = 0u; i < mResumableCalls.size(); i++)
+   {
+      const ExecutionContext& context = mResumableCalls[i]->mContext;
 
-Instance* Environment::setVariable(const TypeUsage& pTypeUsage, const Identifier& pIdentifier,
-   const Value& pValue)
-{
-   return mGlobalNamespace.setVariable(pTypeUsage, pIdentifier, pValue);
-}
+      ExecutionCounters counters = context.mCounters;
+      counters.mStackPeakBytes = (size_t)(context.mStack.mPeakPointer - context.mStack.mMemory);
+      pOutCounters->add(counters);
+   }
 
-Value* Environment::getVariable(const Identifier& pIdentifier) const
-{
-   return mGlobalNamespace.getVariable(pIdentifier);
-}
+   for(size_t i = 0u; i < mCoroutines.size(); i++)
+   {
+      const ExecutionContext& context = mCoroutines[i]->mContext;
 
-Instance* Environment::registerInstance(const TypeUsage& pTypeUsage, const Identifier& pIdentifier)
-{
-   return mGlobalNamespace.registerInstance(pTypeUsage, pIdentifier);
+      ExecutionCounters counters = context.mCounters;
+      counters.mStackPeakBytes = (size_t)(context.mStack.mPeakPointer - context.mStack.mMemory);
+      pOutCounters->add(counters);
+   }
 }
 
-Instance* Environment::retrieveInstance(const Identifier& pIdentifier) const
+void Environment::resetExecutionCounters()
 {
-   return mGlobalNamespace.retrieveInstance(pIdentifier);
-}
+   AccessScope accessScope(this, AccessType::Execute);
 
-void Environment::voidFunctionCall(Function* pFunction)
-{
-   CflatAssert(pFunction);
+   mExecutionContext.mCounters = ExecutionCounters();
+   mExecutionContext.mStack.mPeakPointer = mExecutionContext.mStack.mPointer;
 
-   mErrorMessage.clear();
+   for(size_t i = 0u; i < mParallelWorkers.size(); i++)
+   {
+      ExecutionContext& context = mParallelWorkers[i]->mContext;
+      context.mCounters = ExecutionCounters();
+      context.mStack.mPeakPointer = context.mStack.mPointer;
+   }
 
-   Value returnValue;
+   for(size_t i = 0u; i < mResumableCalls.size(); i++)
+   {
+      ExecutionContext& context = mResumableCalls[i]->mContext;
+      context.mCounters = ExecutionCounters();
+      context.mStack.mPeakPointer = context.mStack.mPointer;
+   }
 
-   CflatArgsVector(Value) args;
-   pFunction->execute(args, &returnValue);
+   for(size_t i = 0u; i < mCoroutines.size(); i++)
+   {
+      ExecutionContext& context = mCoroutines[i]->mContext;
+      context.mCounters = ExecutionCounters();
+      context.mStack.mPeakPointer = context.mStack.mPointer;
+   }
 }
 
-bool Environment::load(const char* pProgramName, const char* pCode)
+void Environment::allocateLineCounters(Program* pProgram)
 {
-   const Identifier programIdentifier(pProgramName);
+   if(pProgram->mLineCounters)
+      return;
 
-   Program* program = (Program*)CflatMalloc(sizeof(Program));
-   CflatInvokeCtor(Program, program);
+   // lines are 1-based
+   const uint32_t linesCount =
+      (uint32_t)std::count(pProgram->mCode.begin(), pProgram->mCode.end(), '\n') + 2u;
 
-   program->mIdentifier = programIdentifier;
-   program->mCode.assign(pCode);
+   pProgram->mLineCounters = (LineCounter*)CflatMalloc(sizeof(LineCounter) * linesCount);
 
-   mErrorMessage.clear();
+   for(uint32_t i = 0u; i < linesCount; i++)
+   {
+      CflatInvokeCtor(LineCounter, &pProgram->mLineCounters[i])();
+   }
 
-   ParsingContext parsingContext(&mGlobalNamespace);
-   parsingContext.mProgram = program;
+   pProgram->mLineCountersCount = linesCount;
+}
 
-   preprocess(parsingContext, pCode);
+ExecutionProfile* Environment::acquireProfile(uint32_t pThreadIndex)
+{
+   Memory::AllocatorScope allocatorScope(&mAllocator);
 
-   if(mErrorMessage.empty())
+   if(mProfiles.size() <= pThreadIndex)
    {
-      tokenize(parsingContext);
-      parse(parsingContext);
+      mProfiles.resize(pThreadIndex + 1u, nullptr);
    }
 
-   if(!mErrorMessage.empty())
+   if(!mProfiles[pThreadIndex])
    {
-      CflatInvokeDtor(Program, program);
-      CflatFree(program);
-
-      return false;
+      ExecutionProfile* profile = (ExecutionProfile*)CflatMalloc(sizeof(ExecutionProfile));
+      CflatInvokeCtor(ExecutionProfile, profile)(pThreadIndex);
+      mProfiles[pThreadIndex] = profile;
    }
 
-   ProgramsRegistry::const_iterator it = mPrograms.find(programIdentifier.mHash);
+   return mProfiles[pThreadIndex];
+}
 
-   if(it != mPrograms.end())
+void Environment::releaseProfiles()
+{
+   for(size_t i = 0u; i < mProfiles.size(); i++)
    {
-      CflatInvokeDtor(Program, it->second);
-      CflatFree(it->second);
+      if(mProfiles[i])
+      {
+         CflatInvokeDtor(ExecutionProfile, mProfiles[i]);
+         CflatFree(mProfiles[i]);
+      }
    }
 
-   mPrograms[programIdentifier.mHash] = program;
-
-   execute(mExecutionContext, *program);
-
-   return mErrorMessage.empty();
+   mProfiles.clear();
 }
 
-bool Environment::load(const char* pFilePath)
+void Environment::beginProfiledCall(ExecutionContext& pContext, const Function* pFunction)
 {
-   FILE* file = fopen(pFilePath, "rb");
-
-   if(!file)
-      return false;
-
-   fseek(file, 0, SEEK_END);
-   const size_t fileSize = (size_t)ftell(file);
-   rewind(file);
+   ExecutionProfile* profile = pContext.mProfile;
+   uint32_t node = profile->findCallNode(pFunction);
 
-   char* code = (char*)CflatMalloc(fileSize + 1u);
-   code[fileSize] = '\0';
+   if(node == ExecutionProfile::kInvalidNode)
+   {
+      // the name is resolved once per call path, since the function might not exist anymore
+      // by the time the profile gets exported
+      CflatSTLString name;
 
-   fread(code, 1u, fileSize, file);
-   fclose(file);
+      if(pFunction->mNamespace && pFunction->mNamespace->getFullIdentifier().mHash != 0u)
+      {
+         name.append(pFunction->mNamespace->getFullIdentifier().mName);
+         name.append("::");
+      }
 
-   const bool success = load(pFilePath, code);
-   CflatFree(code);
+      name.append(pFunction->mIdentifier.mName);
+      node = profile->addCallNode(pFunction, Identifier(name.c_str()));
+   }
 
-   return success;
+   profile->beginCall(node, getProfilerTime());
 }
 
-const char* Environment::getErrorMessage()
+void Environment::beginProfiledCall(ExecutionContext& pContext, const Method* pMethod,
+   const Type* pOwnerType)
 {
-   return mErrorMessage.empty() ? nullptr : mErrorMessage.c_str();
+   ExecutionProfile* profile = pContext.mProfile;
+   uint32_t node = profile->findCallNode(pMethod);
+
+   if(node == ExecutionProfile::kInvalidNode)
+   {
+      CflatSTLString name;
+      getTypeFullName(const_cast<Type*>(pOwnerType), &name);
+      name.append("::");
+      name.append(pMethod->mIdentifier.mName);
+      node = profile->addCallNode(pMethod, Identifier(name.c_str()));
+   }
+
+   profile->beginCall(node, getProfilerTime());
 }
 
-void Environment::setExecutionHook(ExecutionHook pExecutionHook)
+void Environment::onAllocation(void* pEnvironment, size_t pSize)
 {
-   mExecutionHook = pExecutionHook;
+   if(!gRecordingAllocation)
+   {
+      static_cast<Environment*>(pEnvironment)->recordAllocation(pSize);
+   }
 }
 
-bool Environment::evaluateExpression(const char* pExpression, Value* pOutValue)
+void Environment::recordAllocation(size_t pSize)
 {
-   ParsingContext parsingContext(&mGlobalNamespace);
-   parsingContext.mProgram = mExecutionContext.mProgram;
-   parsingContext.mScopeLevel = mExecutionContext.mScopeLevel;
-   parsingContext.mNamespaceStack = mExecutionContext.mNamespaceStack;
-   parsingContext.mUsingDirectives = mExecutionContext.mUsingDirectives;
-   parsingContext.mLocalInstancesHolder = mExecutionContext.mLocalInstancesHolder;
+   // Only the allocations made by script executions get recorded: the ones made by the
+   // parallel workers, from within an execution scope, or while running the statements of
+   // a program being loaded
+   const ExecutionContext* context = nullptr;
+   bool executing = false;
 
-   preprocess(parsingContext, pExpression);
-   tokenize(parsingContext);
-   
-   CflatSTLVector(Token)& tokens = parsingContext.mTokens;
-   
-   if(!tokens.empty())
+   if(gCurrentParallelWorker.mEnvironment == this)
+   {
+      context = gCurrentParallelWorker.mContext;
+      executing = true;
+   }
+   else
+   {
+      for(const AccessScope* scope = gCurrentAccessScope; scope; scope = scope->mPreviousScope)
+      {
+         if(scope->mEnvironment == this && scope->mAccessType != AccessType::Read)
+         {
+            context = &mExecutionContext;
+            executing |= scope->mAccessType == AccessType::Execute;
+         }
+      }
+   }
+
+   if(!context || (!executing && context->mCallStack.empty()))
+      return;
+
+   gRecordingAllocation = true;
+
+   Identifier programIdentifier;
+   uint32_t line = 0u;
+
+   if(!context->mCallStack.empty())
    {
-      Expression* expression = parseExpression(parsingContext, tokens.size() - 1u, true);
+      const CallStackEntry& callStackEntry = context->mCallStack.back();
 
-      if(expression)
+      if(callStackEntry.mProgram)
       {
-         CflatAssert(pOutValue);
-         evaluateExpression(mExecutionContext, expression, pOutValue);
-         mErrorMessage.clear();
+         programIdentifier = callStackEntry.mProgram->mIdentifier;
+         line = callStackEntry.mLine;
+      }
+   }
+
+   {
+      Memory::AllocatorScope allocatorScope(&mAllocator);
+      std::lock_guard<std::mutex> lock(mAllocationsMutex);
+
+      AllocationReport::Entry* entry = nullptr;
+
+      for(size_t i = 0u; i < mAllocationEntries.size(); i++)
+      {
+         AllocationReport::Entry& existingEntry = mAllocationEntries[i];
 
-         return pOutValue->mValueBufferType != ValueBufferType::Uninitialized;
+         if(existingEntry.mProgramIdentifier == programIdentifier &&
+            existingEntry.mLine == line &&
+            existingEntry.mReason == gAllocationReason)
+         {
+            entry = &existingEntry;
+            break;
+         }
+      }
+
+      if(!entry)
+      {
+         AllocationReport::Entry newEntry;
+         newEntry.mProgramIdentifier = programIdentifier;
+         newEntry.mLine = line;
+         newEntry.mReason = gAllocationReason;
+         newEntry.mAllocationsCount = 0u;
+         newEntry.mBytes = 0u;
+         mAllocationEntries.push_back(newEntry);
+
+         entry = &mAllocationEntries.back();
       }
+
+      entry->mAllocationsCount++;
+      entry->mBytes += pSize;
    }
 
-   mErrorMessage.clear();
+   gRecordingAllocation = false;
 
-   return false;
+   for(AllocationFreeScope* scope = gCurrentAllocationFreeScope; scope; scope = scope->mPreviousScope)
+   {
+      if(scope->mEnvironment == this)
+      {
+         scope->mAllocationsCount++;
+         CflatAssert(!scope->mAssertOnAllocation);
+      }
+   }
 }
 
 void Environment::throwCustomRuntimeError(const char* pErrorMessage)
 {
-   if(!mErrorMessage.empty())
+   AccessScope accessScope(this, AccessType::Execute);
+
+   ExecutionContext& context = getCurrentExecutionContext();
+   Memory::AllocatorScope allocatorScope(&mAllocator);
+
+   if(!context.mErrorMessage.empty())
       return;
 
    char lineAsString[kSmallLocalStringBufferSize];
-   snprintf(lineAsString, sizeof(lineAsString), "%d", mExecutionContext.mCallStack.back().mLine);
+   snprintf(lineAsString, sizeof(lineAsString), "%d", context.mCallStack.back().mLine);
 
-   mErrorMessage.assign("[Runtime Error] '");
-   mErrorMessage.append(mExecutionContext.mProgram->mIdentifier.mName);
-   mErrorMessage.append("' -- Line ");
-   mErrorMessage.append(lineAsString);
-   mErrorMessage.append(": ");
-   mErrorMessage.append(pErrorMessage);
+   context.mErrorMessage.assign("[Runtime Error] '");
+   context.mErrorMessage.append(context.mProgram->mIdentifier.mName);
+   context.mErrorMessage.append("' -- Line ");
+   context.mErrorMessage.append(lineAsString);
+   context.mErrorMessage.append(": ");
+   context.mErrorMessage.append(pErrorMessage);
 }
 
 void Environment::resetStatics()
 {
+   AccessScope accessScope(this, AccessType::Write);
+   Memory::AllocatorScope allocatorScope(&mAllocator);
+
    // Execute all programs to reinitialize global statics
    for(ProgramsRegistry::const_iterator it = mPrograms.begin(); it != mPrograms.end(); it++)
    {
       execute(mExecutionContext, *it->second);
    }
 
-   // Clear values for local statics
-   mLocalStaticValues.clear();
+   // Release values for local statics, so that they get initialized again
+   releaseLocalStatics();
+}
+
+void Environment::releaseRetiredPrograms()
+{
+   for(size_t i = 0u; i < mRetiredPrograms.size(); i++)
+   {
+      // local statics declared by the replaced version are destroyed along with it
+      releaseLocalStatics(mRetiredPrograms[i]);
+
+      CflatInvokeDtor(Program, mRetiredPrograms[i]);
+      CflatFree(mRetiredPrograms[i]);
+   }
+
+   mRetiredPrograms.clear();
+
+   for(size_t i = 0u; i < mRetiredFunctionBodies.size(); i++)
+   {
+      CflatInvokeDtor(FunctionBody, mRetiredFunctionBodies[i]);
+      CflatFree(mRetiredFunctionBodies[i]);
+   }
+
+   mRetiredFunctionBodies.clear();
+}
+
+void Environment::releaseLocalStatics(const Program* pProgram)
+{
+   StatementVariableDeclaration* statement = mLocalStatics;
+
+   while(statement)
+   {
+      StatementVariableDeclaration* nextStatement = statement->mNextStatic;
+
+      if(!pProgram || statement->mProgram == pProgram)
+      {
+         releaseLocalStatic(statement);
+      }
+
+      statement = nextStatement;
+   }
+}
+
+void Environment::releaseLocalStatic(StatementVariableDeclaration* pStatement)
+{
+   const TypeUsage& typeUsage = pStatement->mTypeUsage;
+
+   if(typeUsage.mType &&
+      typeUsage.mType->mCategory == TypeCategory::StructOrClass &&
+      !typeUsage.isPointer() &&
+      !typeUsage.isReference())
+   {
+      Method* dtor = static_cast<Struct*>(typeUsage.mType)->getDestructor();
+
+      if(dtor)
+      {
+         TypeUsage thisPtrTypeUsage;
+         thisPtrTypeUsage.mType = typeUsage.mType;
+         thisPtrTypeUsage.mPointerLevel = 1u;
+
+         Value thisPtrValue;
+         thisPtrValue.initExternal(thisPtrTypeUsage);
+         thisPtrValue.set(&pStatement->mStaticValue.mValueBuffer);
+
+         CflatArgsVector(Value) args;
+         dtor->execute(thisPtrValue, args, nullptr);
+      }
+   }
+
+   pStatement->mStaticValue.reset();
+   pStatement->unlinkStatic();
 }
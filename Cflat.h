@@ -38,12 +38,16 @@
 #include <set>
 #include <map>
 #include <string>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 #include "CflatConfig.h"
 #include "CflatMacros.h"
 
-#define CflatMalloc  Cflat::Memory::malloc()
-#define CflatFree  Cflat::Memory::free()
+#define CflatMalloc  Cflat::Memory::allocate
+#define CflatFree  Cflat::Memory::deallocate
 
 #define CflatHasFlag(pBitMask, pFlag)  ((pBitMask & (int)pFlag) > 0)
 #define CflatSetFlag(pBitMask, pFlag)  (pBitMask |= (int)pFlag)
@@ -74,10 +78,105 @@ namespace Cflat
       typedef void* (*mallocFunction)(size_t pSize);
       typedef void (*freeFunction)(void* pPtr);
 
+      enum class Category : uint8_t
+      {
+         General,    // anything else
+         Program,    // program code and syntax tree
+         Type,       // types, members and methods
+         Function,   // functions
+         Execution,  // values and state allocated during execution
+
+         Count
+      };
+
+      struct CflatAPI Usage
+      {
+         size_t mBytes;
+         size_t mAllocations;
+
+         Usage();
+      };
+
+      struct CflatAPI Stats
+      {
+         Usage mCategories[(size_t)Category::Count];
+         Usage mTotal;
+         size_t mPeakBytes;
+         // Everything allocated so far, including the memory already released
+         Usage mAccumulated;
+
+         Stats();
+      };
+
+      struct CflatAPI AtomicUsage
+      {
+         std::atomic<size_t> mBytes;
+         std::atomic<size_t> mAllocations;
+
+         AtomicUsage();
+
+         Usage load() const;
+      };
+
+      // Counters behind the stats, updated by the allocations made from any thread
+      struct CflatAPI StatsCounters
+      {
+         AtomicUsage mCategories[(size_t)Category::Count];
+         AtomicUsage mTotal;
+         std::atomic<size_t> mPeakBytes;
+         AtomicUsage mAccumulated;
+
+         StatsCounters();
+
+         void getStats(Stats* pOutStats) const;
+      };
+
+      struct CflatAPI Allocator
+      {
+         typedef void* (*mallocFunction)(void* pUserData, size_t pSize);
+         typedef void (*freeFunction)(void* pUserData, void* pPtr);
+         typedef void (*hookFunction)(void* pHookData, size_t pSize);
+
+         mallocFunction mMalloc;
+         freeFunction mFree;
+         void* mUserData;
+         StatsCounters* mStats;
+
+         // Called after every allocation made through the allocator, if set
+         hookFunction mHook;
+         void* mHookData;
+
+         Allocator();
+         Allocator(mallocFunction pMalloc, freeFunction pFree, void* pUserData,
+            StatsCounters* pStats = nullptr);
+      };
+
+      class CflatAPI AllocatorScope
+      {
+      private:
+         const Allocator* mPreviousAllocator;
+
+      public:
+         AllocatorScope(const Allocator* pAllocator);
+         ~AllocatorScope();
+      };
+
+      class CflatAPI CategoryScope
+      {
+      private:
+         Category mPreviousCategory;
+
+      public:
+         CategoryScope(Category pCategory);
+         ~CategoryScope();
+      };
+
    private:
       static mallocFunction smmalloc;
       static freeFunction smfree;
 
+      static Allocator smDefaultAllocator;
+
    public:
       static void setFunctions(mallocFunction pmalloc, freeFunction pfree);
       static void* getAlignedAddress(void* pAddress, size_t pAlignment);
@@ -85,6 +184,16 @@ namespace Cflat
       static mallocFunction malloc();
       static freeFunction free();
 
+      static const Allocator* getDefaultAllocator();
+      static const Allocator* getCurrentAllocator();
+      static const Allocator* setCurrentAllocator(const Allocator* pAllocator);
+
+      static Category getCurrentCategory();
+      static Category setCurrentCategory(Category pCategory);
+
+      static void* allocate(size_t pSize);
+      static void deallocate(void* pPtr);
+
       template<typename T>
       class STLAllocator
       {
@@ -328,9 +437,11 @@ namespace Cflat
       {
          char mMemory[Size];
          char* mPointer;
+         char* mPeakPointer;
 
          StackPool()
             : mPointer(mMemory)
+            , mPeakPointer(mMemory)
          {
          }
 
@@ -346,6 +457,11 @@ namespace Cflat
             const char* dataPtr = mPointer;
             mPointer += pSize;
 
+            if(mPointer > mPeakPointer)
+            {
+               mPeakPointer = mPointer;
+            }
+
             return dataPtr;
          }
          const char* push(const char* pData, size_t pSize)
@@ -356,6 +472,11 @@ namespace Cflat
             const char* dataPtr = mPointer;
             mPointer += pSize;
 
+            if(mPointer > mPeakPointer)
+            {
+               mPeakPointer = mPointer;
+            }
+
             return dataPtr;
          }
          void pop(size_t pSize)
@@ -501,6 +622,7 @@ namespace Cflat
    
 
    CflatAPI Hash hash(const char* pString);
+   CflatAPI Hash hash(const char* pString, size_t pLength);
 
 
    struct Program;
@@ -510,7 +632,8 @@ namespace Cflat
    struct CflatAPI Identifier
    {
       typedef Memory::StringsRegistry<kIdentifierStringsPoolSize> NamesRegistry;
-      static NamesRegistry* smNames;
+      // Created on first use by any thread, and published with release semantics
+      static std::atomic<NamesRegistry*> smNames;
 
       static NamesRegistry* getNamesRegistry();
       static void releaseNamesRegistry();
@@ -732,7 +855,8 @@ namespace Cflat
 
    enum class InstanceFlags : uint16_t
    {
-      EnumValue = 1 << 0
+      EnumValue = 1 << 0,
+      LocalStatic = 1 << 1
    };
 
    struct CflatAPI Instance
@@ -763,6 +887,8 @@ namespace Cflat
       template<typename T>
       T* registerType(const Identifier& pIdentifier, Namespace* pNamespace, Type* pParent)
       {
+         Memory::CategoryScope categoryScope(Memory::Category::Type);
+
          T* type = (T*)CflatMalloc(sizeof(T));
          CflatInvokeCtor(T, type)(pNamespace, pIdentifier);
 
@@ -779,6 +905,8 @@ namespace Cflat
       T* registerTemplate(const Identifier& pIdentifier, const CflatArgsVector(TypeUsage)& pTemplateTypes,
          Namespace* pNamespace, Type* pParent)
       {
+         Memory::CategoryScope categoryScope(Memory::Category::Type);
+
          T* type = (T*)CflatMalloc(sizeof(T));
          CflatInvokeCtor(T, type)(pNamespace, pIdentifier);
 
@@ -803,6 +931,7 @@ namespace Cflat
       bool deregisterType(Type* pType);
 
       void getAllTypes(CflatSTLVector(Type*)* pOutTypes) const;
+      void getAllTypeAliases(CflatSTLVector(const TypeAlias*)* pOutTypeAliases) const;
    };
 
    class CflatAPI FunctionsHolder
@@ -842,17 +971,45 @@ namespace Cflat
 
    class CflatAPI InstancesHolder
    {
+      friend class Environment;
+
    private:
-      CflatSTLDeque(Instance) mInstances;
+      // Marks the beginning of each run of instances registered in the same scope level, so
+      // that leaving a scope truncates the instances without inspecting them one by one
+      struct ScopeMark
+      {
+         uint32_t mScopeLevel;
+         uint32_t mFirstInstanceIndex;
+         uint32_t mFirstDestructibleInstanceIndex;
+         // Beginning of the first value placed on the stack by the instances of the run
+         char* mStackPointer;
+      };
+
+      static const uint32_t kInstancesChunkSize = 64u;
+
+      // Instances are laid out contiguously in fixed-size chunks, which keeps their addresses
+      // valid while new ones get registered
+      CflatSTLVector(Instance*) mInstanceChunks;
+      uint32_t mInstancesCount;
+      CflatSTLVector(ScopeMark) mScopeMarks;
+      // Indices of the instances which require a destructor call when released
+      CflatSTLVector(uint32_t) mDestructibleInstances;
+      // Stack holding the values of the instances, if any, which get released all at once
+      EnvironmentStack* mStack;
+
+      Instance* getInstance(uint32_t pIndex) const;
+      void initOnStack(Instance* pInstance);
+      void swapInstances(InstancesHolder* pOther);
 
    public:
-      InstancesHolder();
+      InstancesHolder(EnvironmentStack* pStack = nullptr);
       ~InstancesHolder();
 
       Instance* setVariable(const TypeUsage& pTypeUsage, const Identifier& pIdentifier, const Value& pValue);
       Value* getVariable(const Identifier& pIdentifier) const;
 
-      Instance* registerInstance(const TypeUsage& pTypeUsage, const Identifier& pIdentifier);
+      Instance* registerInstance(const TypeUsage& pTypeUsage, const Identifier& pIdentifier,
+         uint32_t pScopeLevel = 0u, bool pOwnsValue = true);
       Instance* retrieveInstance(const Identifier& pIdentifier) const;
       Instance* retrieveInstance(const Identifier& pIdentifier, uint32_t pScopeLevel) const;
       void releaseInstances(uint32_t pScopeLevel, bool pExecuteDestructors);
@@ -890,6 +1047,12 @@ namespace Cflat
    {
       static const int8_t kInvalidCachedMethodIndex = -1;
 
+      struct ConstructionStep
+      {
+         Struct* mType;
+         size_t mOffset;
+      };
+
       CflatSTLVector(TypeUsage) mTemplateTypes;
       CflatSTLVector(BaseType) mBaseTypes;
       CflatSTLVector(Member*) mMembers;
@@ -903,6 +1066,13 @@ namespace Cflat
       int8_t mCachedMethodIndexCopyConstructor;
       int8_t mCachedMethodIndexDestructor;
 
+      // Default constructors to call when declaring an instance, including the ones from
+      // base types and members; built on first use, and rebuilt when any struct gets new
+      // members, base types or constructors, since plans flatten the nested member types
+      static std::atomic<uint32_t> smConstructionPlansGeneration;
+      CflatSTLVector(ConstructionStep) mConstructionPlan;
+      std::atomic<uint32_t> mConstructionPlanGeneration;
+
       Struct(Namespace* pNamespace, const Identifier& pIdentifier);
       ~Struct();
 
@@ -950,6 +1120,9 @@ namespace Cflat
       void getAllMembers(CflatSTLVector(Member*)* pOutMembers) const;
 
       Method* getDefaultConstructor() const;
+      const CflatSTLVector(ConstructionStep)& getConstructionPlan();
+      static void invalidateConstructionPlans();
+      void appendConstructionSteps(size_t pOffset, CflatSTLVector(ConstructionStep)* pOutSteps);
       Method* getCopyConstructor() const;
       Method* getDestructor() const;
       Method* findConstructor(const CflatArgsVector(TypeUsage)& pParameterTypes) const;
@@ -1031,10 +1204,63 @@ namespace Cflat
    public:
       static void tokenize(const char* pCode, CflatSTLVector(Token)& pTokens);
 
+      static const char* skipWhitespace(const char* pCursor, uint16_t* pLine);
+      static const char* scanToken(const char* pCursor, Token* pToken);
+
       static bool isValidIdentifierCharacter(char pCharacter);
       static bool isValidIdentifierBeginningCharacter(char pCharacter);
    };
 
+   // Bracket pairs and separator positions of a list of tokens, built once after tokenizing
+   // so that the parser can look up closures and separators without scanning the tokens
+   class CflatAPI TokensIndex
+   {
+   private:
+      static const uint32_t kInvalidIndex = UINT32_MAX;
+
+      static const size_t kBracketKindsCount = 4u;
+      static const size_t kSeparatorKindsCount = 4u;
+
+      struct BracketEntry
+      {
+         uint32_t mTokenIndex;
+         // opening bracket: index of the matching closure token
+         uint32_t mMatchTokenIndex;
+         // index of the entry for the innermost bracket left open after this one
+         uint32_t mEnclosingEntryIndex;
+      };
+      struct SeparatorEntry
+      {
+         uint32_t mScopeLevel;
+         uint32_t mTokenIndex;
+      };
+
+      size_t mTokensCount;
+      CflatSTLVector(uint32_t) mScopeLevels;
+      CflatSTLVector(BracketEntry) mBrackets[kBracketKindsCount];
+      CflatSTLVector(uint32_t) mUnmatchedClosures[kBracketKindsCount];
+      CflatSTLVector(uint32_t) mSeparators[kSeparatorKindsCount];
+      CflatSTLVector(SeparatorEntry) mScopedSeparators[kSeparatorKindsCount];
+
+      static size_t getBracketKind(char pOpeningChar, char pClosureChar);
+      static size_t getSeparatorKind(char pSeparationChar);
+
+      uint32_t getEnclosingEntryIndex(size_t pBracketKind, size_t pTokenIndex) const;
+
+   public:
+      TokensIndex();
+
+      void build(const CflatSTLVector(Token)& pTokens);
+      bool isBuilt(const CflatSTLVector(Token)& pTokens) const;
+
+      bool findClosure(size_t pTokenIndex, char pOpeningChar, char pClosureChar,
+         size_t pTokenIndexLimit, size_t* pOutClosureIndex) const;
+      bool findOpening(size_t pTokenIndex, char pOpeningChar, char pClosureChar,
+         size_t pClosureIndex, size_t* pOutOpeningIndex) const;
+      bool findSeparation(size_t pTokenIndex, char pSeparationChar, size_t pClosureIndex,
+         size_t* pOutSeparationIndex) const;
+   };
+
 
    struct Expression;
 
@@ -1058,12 +1284,69 @@ namespace Cflat
 
    class Environment;
 
+   // Executions of the statements on a line of a program, and the time spent on them. Updated
+   // by any thread executing the program.
+   struct CflatAPI LineCounter
+   {
+      std::atomic<uint32_t> mExecutionsCount;
+      std::atomic<uint64_t> mTime;
+
+      LineCounter();
+   };
+
+   // Breakdown of the work done when loading a program
+   struct CflatAPI ProgramLoadStats
+   {
+      // Nanoseconds spent preprocessing (which tokenizes the code in the same pass), parsing
+      // (or reading the program cache), and executing the statements in namespace scope
+      uint64_t mPreprocessTime;
+      uint64_t mParseTime;
+      uint64_t mExecuteTime;
+
+      // Tokens are not produced when the program gets read from the cache
+      uint32_t mTokensCount;
+      uint32_t mStatementsCount;
+      uint32_t mExpressionsCount;
+      // Functions (including methods) and types declared by the program
+      uint32_t mFunctionsCount;
+      uint32_t mTypesCount;
+
+      // Allocated through the environment while parsing and executing, including the memory
+      // released before the load finished
+      Memory::Usage mAllocated;
+
+      ProgramLoadStats();
+
+      uint64_t getTotalTime() const;
+      void add(const ProgramLoadStats& pOther);
+   };
+
    struct CflatAPI Program
    {
       Identifier mIdentifier;
       CflatSTLString mCode;
       CflatSTLVector(Statement*) mStatements;
+      Memory::Usage mMemoryUsage;
+      // Whether the statements have been read from the program cache instead of parsed
+      bool mLoadedFromCache;
+      // Fingerprint of everything but the function bodies, for incremental reloads
+      uint64_t mOutlineFingerprint;
+
+      // Tokens of the function bodies which get parsed on their first call, kept until all
+      // of them have been parsed
+      CflatSTLVector(Token) mDeferredTokens;
+      TokensIndex mDeferredTokensIndex;
+      CflatSTLDeque(CflatSTLString) mDeferredMacroExpansions;
+      uint32_t mDeferredFunctionBodiesCount;
+      uint32_t mLocalNamespaceGlobalIndex;
+
+      // Indexed by line, allocated when loaded or present while line counting is enabled
+      LineCounter* mLineCounters;
+      uint32_t mLineCountersCount;
 
+      ProgramLoadStats mLoadStats;
+
+      Program();
       ~Program();
    };
 
@@ -1171,6 +1454,8 @@ namespace Cflat
 
       void getAllNamespaces(CflatSTLVector(Namespace*)* pOutNamespaces, bool pRecursively = false) const;
       void getAllTypes(CflatSTLVector(Type*)* pOutTypes, bool pRecursively = false) const;
+      void getAllTypeAliases(CflatSTLVector(const TypeAlias*)* pOutTypeAliases,
+         bool pRecursively = false) const;
       void getAllInstances(CflatSTLVector(Instance*)* pOutInstances, bool pRecursively = false) const;
       void getAllFunctions(CflatSTLVector(Function*)* pOutFunctions, bool pRecursively = false) const;
    };
@@ -1183,11 +1468,51 @@ namespace Cflat
       TokenPaste
    };
 
-   struct Macro
+   // Token of the expansion of an object-like macro, relative to the expansion
+   struct MacroToken
+   {
+      TokenType mType;
+      uint16_t mLineOffset;
+      uint32_t mOffset;
+      uint32_t mLength;
+   };
+
+   struct CflatAPI Macro
    {
       uint8_t mParametersCount;
       CflatSTLString mName;
       CflatSTLVector(CflatSTLString) mBody;
+
+      // Object-like macros get expanded and tokenized once, when registered
+      bool mExpansionCached;
+      CflatSTLString mExpansion;
+      CflatSTLVector(MacroToken) mExpansionTokens;
+
+      Macro();
+   };
+
+   class CflatAPI MacrosHolder
+   {
+   private:
+      // Bit per name length (up to 63) for each first character of the registered names,
+      // so that most identifiers get discarded without looking them up
+      static const size_t kNameFilterSize = 128u;
+      uint64_t mNameFilter[kNameFilterSize];
+
+      CflatSTLVector(Macro) mMacros;
+
+      typedef CflatSTLMap(Hash, size_t) MacrosRegistry;
+      MacrosRegistry mMacrosRegistry;
+
+      static void cacheExpansion(Macro* pMacro);
+
+   public:
+      MacrosHolder();
+
+      void defineMacro(const char* pDefinition, const char* pBody);
+      void registerMacro(const Macro& pMacro);
+      const Macro* getMacro(const char* pName, size_t pNameLength) const;
+      const CflatSTLVector(Macro)& getMacros() const;
    };
 
    enum class ContextType
@@ -1217,15 +1542,67 @@ namespace Cflat
 
    struct CflatAPI ParsingContext : Context
    {
-      CflatSTLString mPreprocessedCode;
+      CflatSTLString mErrorMessage;
       CflatSTLVector(Token) mTokens;
+      TokensIndex mTokensIndex;
       size_t mTokenIndex;
 
+      // Macros defined by the code, registered in the environment when committing the program
+      MacrosHolder mMacros;
+      uint32_t mMacrosGeneration;
+      // Code resulting from macro expansions, referenced by the tokens
+      CflatSTLDeque(CflatSTLString) mMacroExpansions;
+      // Expansions of the object-like macros used by the code, shared by all their uses
+      CflatSTLMap(uintptr_t, char*) mObjectLikeMacroExpansions;
+
+      // Contents of the program cache file, when it matches the code and the macros, in which
+      // case the code does not get tokenized unless the cached program cannot be used
+      CflatSTLVector(char) mCachedProgram;
+      size_t mCachedProgramOffset;
+      Hash mCachedBindingsFingerprint;
+      Hash mMacrosFingerprint;
+
+      // Bodies of the functions declared in namespace scope, indexed for incremental reloads
+      struct FunctionBody
+      {
+         size_t mOpeningTokenIndex;
+         size_t mClosureTokenIndex;
+         uint64_t mFingerprint;
+         // Whether parsing the body registers anything, which prevents it from being deferred
+         bool mRegistering;
+      };
+      CflatSTLVector(FunctionBody) mFunctionBodies;
+
+      // Set when only function bodies have changed since the previous version of the program,
+      // whose function declarations are then listed in the same order as the bodies
+      bool mIncrementalReload;
+      CflatSTLVector(Statement**) mPreviousFunctionDeclarations;
+
+      struct UnchangedFunctionDeclaration
+      {
+         StatementFunctionDeclaration* mStatement;
+         Statement** mPreviousStatement;
+      };
+      CflatSTLVector(UnchangedFunctionDeclaration) mUnchangedFunctionDeclarations;
+
+      // Set while parsing a reload with shared access, which is only possible as long as the
+      // environment does not have to be altered; otherwise, the parsing stops and the program
+      // gets parsed again once write access has been taken for committing it
+      bool mSharedAccess;
+      bool mWriteAccessRequired;
+      // Set once the program has been parsed with shared access, along with the generation of
+      // the environment's write accesses, which tells whether the parsing is still valid
+      bool mParsed;
+      uint32_t mWriteAccessGeneration;
+
       struct RegisteredInstance
       {
          Identifier mIdentifier;
          Namespace* mNamespace;
          uint32_t mScopeLevel;
+         Instance* mInstance;
+         // Declaration owning the storage, for local static variables
+         StatementVariableDeclaration* mStaticDeclaration;
       };
       CflatSTLVector(RegisteredInstance) mRegisteredInstances;
 
@@ -1242,6 +1619,60 @@ namespace Cflat
       ParsingContext(Namespace* pGlobalNamespace);
    };
 
+   // Serialization state of a parsed program. References to types and functions are written
+   // once to their own tables, and each entry gets validated by resolving it the same way it
+   // gets resolved when reading, so that only programs that can be read back get cached.
+   struct CflatAPI ProgramCacheWriter
+   {
+      CflatSTLVector(char) mStrings;
+      CflatSTLVector(char) mTypes;
+      CflatSTLVector(char) mFunctions;
+      CflatSTLVector(char) mStatements;
+
+      uint32_t mStringsCount;
+      uint32_t mTypesCount;
+      uint32_t mFunctionsCount;
+
+      typedef CflatSTLMap(Hash, uint32_t) StringIndicesRegistry;
+      StringIndicesRegistry mStringIndices;
+
+      typedef CflatSTLMap(uintptr_t, uint32_t) ReferenceIndicesRegistry;
+      ReferenceIndicesRegistry mTypeIndices;
+      ReferenceIndicesRegistry mFunctionIndices;
+      // Storage of the static variables declared by the program, in declaration order
+      ReferenceIndicesRegistry mStaticValueIndices;
+
+      // Owners of the static methods, collected the first time that one is referenced
+      typedef CflatSTLMap(uintptr_t, Struct*) StaticMethodOwnersRegistry;
+      StaticMethodOwnersRegistry mStaticMethodOwners;
+      bool mStaticMethodOwnersCollected;
+
+      CflatSTLVector(Namespace*) mNamespaceStack;
+
+      // Reset when the program contains something that cannot be cached
+      bool mSupported;
+
+      ProgramCacheWriter(Namespace* pGlobalNamespace);
+   };
+
+   struct CflatAPI ProgramCacheReader
+   {
+      const char* mCursor;
+      const char* mEnd;
+      bool mFailed;
+
+      CflatSTLVector(Identifier) mStrings;
+      CflatSTLVector(Type*) mTypes;
+      // Functions get resolved on first use, since they can be declared by the program itself
+      CflatSTLVector(const char*) mFunctionEntries;
+      CflatSTLVector(Function*) mFunctions;
+      CflatSTLVector(Value*) mStaticValues;
+
+      uint32_t mScopeLevel;
+
+      ProgramCacheReader(const char* pData, size_t pSize);
+   };
+
    enum class CastType
    {
       CStyle,
@@ -1270,13 +1701,250 @@ namespace Cflat
       Return
    };
 
+   // Calls recorded by the profiler in an execution context, arranged as a tree of call paths.
+   // Times are given in nanoseconds.
+   struct CflatAPI ExecutionProfile
+   {
+      static const uint32_t kInvalidNode = UINT32_MAX;
+      // Trace events stop being recorded beyond this count, unlike the call tree
+      static const size_t kMaxTraceEvents = 1u << 20u;
+
+      struct Node
+      {
+         // Function or method, only used to tell calls apart while recording
+         const void* mCallee;
+         Identifier mName;
+         uint32_t mParent;
+         uint32_t mFirstChild;
+         uint32_t mNextSibling;
+         uint32_t mCallsCount;
+         uint64_t mInclusiveTime;
+         uint64_t mChildrenTime;
+      };
+
+      struct Frame
+      {
+         uint32_t mNode;
+         uint64_t mStartTime;
+      };
+
+      struct TraceEvent
+      {
+         uint32_t mNode;
+         uint64_t mStartTime;
+         uint64_t mDuration;
+      };
+
+      // The first node is the root, which does not correspond to any call
+      CflatSTLVector(Node) mNodes;
+      CflatSTLVector(Frame) mFrames;
+      CflatSTLVector(TraceEvent) mTraceEvents;
+      uint32_t mThreadIndex;
+
+      ExecutionProfile(uint32_t pThreadIndex);
+
+      uint32_t findCallNode(const void* pCallee) const;
+      uint32_t addCallNode(const void* pCallee, const Identifier& pName);
+
+      void beginCall(uint32_t pNode, uint64_t pTime);
+      void endCall(uint64_t pTime);
+
+      void reset();
+   };
+
+   // Cheap counters kept by every execution context, meant to be sampled (and reset) regularly.
+   // They stay at zero when compiled out through CflatDisableExecutionCounters, except for the
+   // stack peak.
+   struct CflatAPI ExecutionCounters
+   {
+      uint64_t mStatementsCount;
+      uint64_t mExpressionsCount;
+      uint64_t mScriptCallsCount;
+      uint64_t mNativeCallsCount;
+      uint64_t mOperatorOverloadCallsCount;
+      // Variable accesses not resolved by the local instances
+      uint64_t mNameLookupMissesCount;
+      size_t mStackPeakBytes;
+
+      ExecutionCounters();
+
+      void add(const ExecutionCounters& pOther);
+   };
+
+   class ResumableCall;
+   class Coroutine;
+
    struct CflatAPI ExecutionContext : Context
    {
       JumpStatement mJumpStatement;
       Memory::StackVector<Value*, kMaxNestedFunctionCalls> mReturnValues;
       CallStack mCallStack;
+      CflatSTLString& mErrorMessage;
+      // Owner values of member accesses, indexed by their slots, for contexts other than the
+      // environment's one (a deque, so that growing it keeps the values in place)
+      CflatSTLDeque(Value) mMemberOwnerValues;
+      // Calls recorded while profiling is enabled (nullptr otherwise)
+      ExecutionProfile* mProfile;
+      // Time spent on the statements nested in the ones being executed, while line counting
+      // is enabled, so that their time does not get accounted twice
+      CflatSTLVector(uint64_t) mNestedStatementsTimes;
+      ExecutionCounters mCounters;
+      // Call whose execution budget gets checked before each statement (nullptr otherwise)
+      ResumableCall* mResumableCall;
+      // Coroutine running in the context, which 'yield' suspends (nullptr otherwise)
+      Coroutine* mCoroutine;
+
+      ExecutionContext(Namespace* pGlobalNamespace, CflatSTLString& pErrorMessage);
+   };
+
+
+   class CflatAPI ReadWriteLock
+   {
+   private:
+      std::mutex mMutex;
+      std::condition_variable mCondition;
+      uint32_t mReaders;
+      uint32_t mWaitingWriters;
+      bool mWriter;
+
+   public:
+      ReadWriteLock();
 
-      ExecutionContext(Namespace* pGlobalNamespace);
+      void lockShared();
+      void unlockShared();
+
+      void lock();
+      void unlock();
+   };
+
+
+   struct CflatAPI QueuedCall
+   {
+      Function* mFunction;
+      CflatArgsVector(Value) mArgs;
+      Value mReturnValue;
+      CflatSTLString mErrorMessage;
+      QueuedCall* mNext;
+      std::atomic<uint32_t> mReferences;
+      std::atomic<bool> mDone;
+
+      QueuedCall(Function* pFunction);
+   };
+
+   class CflatAPI CallFuture
+   {
+   private:
+      QueuedCall* mCall;
+
+   public:
+      CallFuture();
+      CallFuture(QueuedCall* pCall);
+      CallFuture(const CallFuture& pOther);
+      ~CallFuture();
+
+      CallFuture& operator=(const CallFuture& pOther);
+
+      bool isValid() const;
+      bool isReady() const;
+      // Must not be called from the thread which processes the queued calls until they have been
+      // processed, since it would never return
+      void wait() const;
+
+      // Both wait until the call has been processed. The result is owned by the future, so it
+      // remains accessible after the environment has been destroyed, although its type does not
+      const Value& getReturnValue() const;
+      const char* getErrorMessage() const;
+
+      static void release(QueuedCall* pCall);
+   };
+
+
+   struct CflatAPI ExecutionBudget
+   {
+      // Statements to execute before suspending (0 for no limit)
+      uint64_t mStatementsCount;
+      // Time to spend before suspending, in nanoseconds (0 for no limit)
+      uint64_t mTime;
+
+      ExecutionBudget();
+      ExecutionBudget(uint64_t pStatementsCount, uint64_t pTime = 0u);
+   };
+
+   struct NativeExecutionState;
+
+   class CflatAPI ResumableCall
+   {
+      friend class Environment;
+
+   private:
+      Environment* mEnvironment;
+      Function* mFunction;
+      CflatArgsVector(Value) mArgs;
+      Value mReturnValue;
+      CflatSTLString mErrorMessage;
+      ExecutionContext mContext;
+
+      // The execution state of the call lives on a native stack of its own, which the resuming
+      // thread switches to like the one of a coroutine, allocated when it gets resumed for the
+      // first time
+      NativeExecutionState* mNativeState;
+      size_t mStackSize;
+      bool mFinished;
+      bool mAborting;
+
+      ExecutionBudget mBudget;
+      uint64_t mSliceStatementsCount;
+      uint64_t mSliceStart;
+      uint64_t mStatementsCount;
+      uint32_t mResumesCount;
+
+   public:
+      ResumableCall(Environment* pEnvironment, Function* pFunction, Namespace* pGlobalNamespace);
+      ~ResumableCall();
+
+      bool isFinished() const;
+      // Number of times the call has been resumed, including the first one
+      uint32_t getResumesCount() const;
+      uint64_t getStatementsCount() const;
+
+      // Both require the call to have finished
+      const Value& getReturnValue() const;
+      const char* getErrorMessage() const;
+   };
+
+   class CflatAPI Coroutine
+   {
+      friend class Environment;
+
+   private:
+      Environment* mEnvironment;
+      Function* mFunction;
+      CflatArgsVector(Value) mArgs;
+      Value mReturnValue;
+      CflatSTLString mErrorMessage;
+      ExecutionContext mContext;
+
+      // Native stack of the coroutine and the states to switch between, allocated when it
+      // gets resumed for the first time
+      NativeExecutionState* mNativeState;
+      size_t mStackSize;
+      // Index in the coroutines of the environment
+      size_t mIndex;
+      bool mFinished;
+      bool mAborting;
+      uint32_t mResumesCount;
+
+   public:
+      Coroutine(Environment* pEnvironment, Function* pFunction, Namespace* pGlobalNamespace);
+      ~Coroutine();
+
+      bool isFinished() const;
+      // Number of times the coroutine has been resumed, including the first one
+      uint32_t getResumesCount() const;
+
+      // Both require the coroutine to have finished
+      const Value& getReturnValue() const;
+      const char* getErrorMessage() const;
    };
 
 
@@ -1286,7 +1954,182 @@ namespace Cflat
       enum class Settings : uint32_t
       {
          DisallowStaticPointers = 1 << 0,
-         DisallowDynamicCast = 1 << 1
+         DisallowDynamicCast = 1 << 1,
+         // Reloading a program when only function bodies have changed keeps the unchanged
+         // functions and the global variables as they are, and rebinds only the changed functions
+         IncrementalReload = 1 << 2,
+         // The bodies of the functions declared in namespace scope get parsed on their first
+         // call instead of when loading the program
+         LazyFunctionBodies = 1 << 3
+      };
+
+      enum class AccessType : uint8_t
+      {
+         Read,       // lookups (shared with other readers and executions)
+         Execute,    // script execution (shared with readers, exclusive among executions)
+         Write       // registration and loading (exclusive)
+      };
+
+      // Grants the calling thread access to the environment while in scope. Nested scopes on
+      // the same thread do not lock again, so a write access cannot be requested from within
+      // a read or execute scope.
+      class CflatAPI AccessScope
+      {
+         friend class Environment;
+
+      private:
+         Environment* mEnvironment;
+         const AccessScope* mPreviousScope;
+         AccessType mAccessType;
+         bool mSharedLocked;
+         bool mExclusiveLocked;
+         bool mExecutionLocked;
+
+      public:
+         AccessScope(const Environment* pEnvironment, AccessType pAccessType);
+         ~AccessScope();
+
+      private:
+         // Access granted by a scope held on another thread, which waits for this one
+         AccessScope(const Environment* pEnvironment, const AccessScope* pGrantingScope);
+      };
+
+      struct MemoryStats
+      {
+         struct ProgramEntry
+         {
+            const Program* mProgram;
+            Memory::Usage mUsage;
+         };
+
+         // Heap memory allocated through the environment, per category
+         Memory::Stats mHeap;
+         // Syntax tree memory, per program
+         CflatSTLVector(ProgramEntry) mPrograms;
+
+         // Strings pools (used bytes)
+         size_t mIdentifierPoolBytes;
+         size_t mLiteralStringsPoolBytes;
+         size_t mLiteralWideStringsPoolBytes;
+
+         // Registered elements
+         size_t mTypesCount;
+         size_t mFunctionsCount;
+         size_t mMethodsCount;
+
+         // Heap-allocated global values
+         Memory::Usage mGlobalValues;
+         // Local static values
+         Memory::Usage mLocalStaticValues;
+
+         // Environment stack (used bytes)
+         size_t mStackBytes;
+         size_t mStackPeakBytes;
+
+         MemoryStats();
+      };
+
+      struct ProfileStats
+      {
+         struct FunctionEntry
+         {
+            Identifier mName;
+            uint32_t mCallsCount;
+            // Nanoseconds; recursive calls are included once in the inclusive time
+            uint64_t mInclusiveTime;
+            uint64_t mExclusiveTime;
+         };
+
+         // Functions and methods called from script code, sorted by exclusive time
+         CflatSTLVector(FunctionEntry) mFunctions;
+      };
+
+      struct LinesReport
+      {
+         struct LineEntry
+         {
+            uint32_t mLine;
+            uint32_t mExecutionsCount;
+            // Nanoseconds spent on the statements of the line, excluding the nested ones
+            uint64_t mTime;
+         };
+
+         struct ProgramEntry
+         {
+            const Program* mProgram;
+            // Line coverage: lines with statements, and how many of them have been executed
+            uint32_t mExecutableLinesCount;
+            uint32_t mExecutedLinesCount;
+            // Executed lines sorted by time, up to the requested count
+            CflatSTLVector(LineEntry) mHottestLines;
+            // Lines with statements which have not been executed
+            CflatSTLVector(uint32_t) mUncoveredLines;
+         };
+
+         CflatSTLVector(ProgramEntry) mPrograms;
+      };
+
+      struct LoadStats
+      {
+         struct ProgramEntry
+         {
+            const Program* mProgram;
+            ProgramLoadStats mStats;
+         };
+
+         // Loaded programs, sorted by total load time
+         CflatSTLVector(ProgramEntry) mPrograms;
+         // Sum of the stats of all the loaded programs
+         ProgramLoadStats mTotal;
+      };
+
+      enum class AllocationReason : uint8_t
+      {
+         HeapValue,        // values which do not get initialized on the stack
+         Instance,         // registration of local instances
+         ExecutionState,   // growth of the call stack and the rest of the execution context
+         Other
+      };
+
+      struct AllocationReport
+      {
+         struct Entry
+         {
+            // Empty for the allocations made outside of script code (e.g. when passing the
+            // arguments of a call from the host)
+            Identifier mProgramIdentifier;
+            uint32_t mLine;
+            AllocationReason mReason;
+            uint32_t mAllocationsCount;
+            size_t mBytes;
+         };
+
+         // Sorted by allocations count
+         CflatSTLVector(Entry) mEntries;
+         uint32_t mAllocationsCount;
+         size_t mBytes;
+
+         AllocationReport();
+      };
+
+      // Marks a region of code on the calling thread in which script executions are not expected
+      // to allocate. The allocations get counted by the scope and, unless told otherwise, trigger
+      // an assertion failure. Requires allocation tracking to be enabled.
+      class CflatAPI AllocationFreeScope
+      {
+         friend class Environment;
+
+      private:
+         Environment* mEnvironment;
+         AllocationFreeScope* mPreviousScope;
+         uint32_t mAllocationsCount;
+         bool mAssertOnAllocation;
+
+      public:
+         AllocationFreeScope(Environment* pEnvironment, bool pAssertOnAllocation = true);
+         ~AllocationFreeScope();
+
+         uint32_t getAllocationsCount() const;
       };
 
    private:
@@ -1346,28 +2189,122 @@ namespace Cflat
          InvalidArrayIndex,
          DivisionByZero,
          MissingFunctionImplementation,
+         YieldOutsideCoroutine,
 
          Count
       };
 
+      struct ParallelWorker
+      {
+         ExecutionContext mContext;
+         CflatSTLString mErrorMessage;
+         CflatSTLString mFirstErrorMessage;
+         // Pending call indices [begin, end), packed as two 32-bit values so that the
+         // owner and the thieves can update the range with a single compare-and-swap
+         std::atomic<uint64_t> mRange;
+
+         ParallelWorker(Namespace* pGlobalNamespace);
+      };
+
+      struct ParallelJob
+      {
+         Function* mFunction;
+         const void* const* mArgsArray;
+         void* mOutReturnValues;
+         size_t mThreadsCount;
+         std::atomic<size_t> mPendingWorkers;
+         const AccessScope* mAccessScope;
+      };
+
+      // Programs loaded at once, which the load workers prepare in any order
+      struct LoadBatch
+      {
+         const char* const* mProgramNames;
+         const char* const* mCodes;
+         size_t mCount;
+         std::atomic<size_t> mNextProgramIndex;
+         CflatSTLVector(ParsingContext*) mParsingContexts;
+         CflatSTLVector(bool) mPrepared;
+         size_t mPendingWorkers;
+      };
+
+      Memory::StatsCounters mMemoryStats;
+      Memory::Allocator mAllocator;
+      const Memory::Allocator* mAllocatorBeforeConstruction;
+
+      ReadWriteLock mAccessLock;
+      std::mutex mExecutionMutex;
+      // Incremented every time write access gets released
+      uint32_t mWriteAccessGeneration;
+
       uint32_t mSettings;
 
-      CflatSTLVector(Macro) mMacros;
+      // Directory where the parsed programs get cached (empty if disabled)
+      CflatSTLString mProgramCacheDirectory;
+
+      MacrosHolder mMacros;
+      ReadWriteLock mMacrosLock;
+      uint32_t mMacrosGeneration;
+
+      // Bumped whenever types, functions or variables get registered through the environment
+      uint32_t mRegistrationGeneration;
 
       typedef CflatSTLMap(Hash, Program*) ProgramsRegistry;
       ProgramsRegistry mPrograms;
+      // Replaced programs, released once no script code is being executed
+      CflatSTLVector(Program*) mRetiredPrograms;
+      // Bodies of the functions redeclared by the replacing programs, released along with them
+      typedef decltype(Function::execute) FunctionBody;
+      CflatSTLVector(FunctionBody*) mRetiredFunctionBodies;
+
+      // Function calls submitted from any thread, pending to be processed (LIFO)
+      std::atomic<QueuedCall*> mQueuedCalls;
+
+      // Resumable calls and coroutines which have not been released yet
+      CflatSTLVector(ResumableCall*) mResumableCalls;
+      CflatSTLVector(Coroutine*) mCoroutines;
+
+      // Worker pool for parallel invocations; the first worker is used by the invoking thread
+      CflatSTLVector(ParallelWorker*) mParallelWorkers;
+      CflatSTLVector(std::thread*) mParallelThreads;
+      std::mutex mParallelMutex;
+      std::condition_variable mParallelJobCondition;
+      std::condition_variable mParallelDoneCondition;
+      ParallelJob* mParallelJob;
+      uint32_t mParallelJobGeneration;
+      bool mParallelShutdown;
+
+      // Worker pool for batch loads, which prepare the programs while the loading thread
+      // commits them; batches get loaded one at a time
+      CflatSTLVector(std::thread*) mLoadThreads;
+      std::mutex mLoadBatchMutex;
+      std::mutex mLoadMutex;
+      std::condition_variable mLoadBatchCondition;
+      std::condition_variable mLoadPreparedCondition;
+      LoadBatch* mLoadBatch;
+      uint32_t mLoadBatchGeneration;
+      bool mLoadShutdown;
+
+      // Guards the initialization of local statics, which can be reached from several workers
+      std::recursive_mutex mLocalStaticsMutex;
 
       typedef Memory::StringsRegistry<kLiteralStringsPoolSize> LiteralStringsPool;
       typedef Memory::WideStringsRegistry<kLiteralStringsPoolSize> LiteralWideStringsPool;
       LiteralStringsPool mLiteralStringsPool;
       LiteralWideStringsPool mLiteralWideStringsPool;
+      // Programs parsed with shared access register their literal strings as well
+      std::mutex mLiteralStringsMutex;
 
-      typedef CflatSTLMap(uint64_t, Value) StaticValuesRegistry;
-      StaticValuesRegistry mLocalStaticValues;
+      StatementVariableDeclaration* mLocalStatics;
 
       ExecutionContext mExecutionContext;
       CflatSTLString mErrorMessage;
 
+      // Scratch context for parsing type usages, guarded by its own lock so that type usages
+      // can be parsed with read access only
+      mutable ParsingContext mTypeUsageParsingContext;
+      mutable std::mutex mTypeUsageParsingMutex;
+
       Namespace mGlobalNamespace;
 
       Type* mTypeAuto;
@@ -1389,6 +2326,38 @@ namespace Cflat
       typedef void (*ExecutionHook)(Environment* pEnvironment, const CallStack& pCallStack);
       ExecutionHook mExecutionHook;
 
+      // Expressions compiled by evaluateExpression, reused when evaluated again in a scope with
+      // the same visible instances. Released when programs, macros or registrations change.
+      // Expressions which do not compile are not kept, since a later registration might make
+      // them valid.
+      struct CompiledExpression
+      {
+         CflatSTLString mText;
+         uint64_t mScopeFingerprint;
+         Expression* mExpression;
+      };
+
+      static const size_t kMaxCompiledExpressions = 256u;
+
+      typedef CflatSTLMap(uint64_t, CompiledExpression) CompiledExpressionsRegistry;
+      CompiledExpressionsRegistry mCompiledExpressions;
+      uint32_t mCompiledExpressionsMacrosGeneration;
+      uint32_t mCompiledExpressionsRegistrationGeneration;
+
+      // Profiles of the environment's execution context (first) and of the parallel workers,
+      // kept after disabling profiling until reset
+      CflatSTLVector(ExecutionProfile*) mProfiles;
+      uint64_t mProfilingStartTime;
+      bool mProfilingEnabled;
+
+      bool mLineCountingEnabled;
+
+      // Allocations made by script executions while tracking is enabled, grouped by program,
+      // line and reason
+      CflatSTLVector(AllocationReport::Entry) mAllocationEntries;
+      std::mutex mAllocationsMutex;
+      bool mAllocationTrackingEnabled;
+
       void registerBuiltInTypes();
 
       TypeUsage parseTypeUsage(ParsingContext& pContext, size_t pTokenLastIndex) const;
@@ -1400,7 +2369,6 @@ namespace Cflat
       void throwCompileErrorUnexpectedSymbol(ParsingContext& pContext);
 
       void preprocess(ParsingContext& pContext, const char* pCode);
-      void tokenize(ParsingContext& pContext) const;
       void parse(ParsingContext& pContext);
 
       Expression* parseExpression(ParsingContext& pContext, size_t pTokenLastIndex,
@@ -1464,6 +2432,8 @@ namespace Cflat
          CflatSTLVector(TypeUsage)* pTemplateTypes = nullptr);
 
       const TypeUsage& getTypeUsage(Expression* pExpression) const;
+      const TypeUsage& getTypeUsage(const ParsingContext& pContext, Expression* pExpression) const;
+      bool requireWriteAccess(ParsingContext& pContext);
 
       Type* findType(const Context& pContext, const Identifier& pIdentifier,
          const CflatArgsVector(TypeUsage)& pTemplateTypes = TypeUsage::kEmptyList()) const;
@@ -1532,10 +2502,106 @@ namespace Cflat
       static bool doAllExecutionPathsReturn(Statement* pStatement);
 
       void initArgumentsForFunctionCall(Function* pFunction, CflatArgsVector(Value)& pArgs);
-      bool tryCallDefaultConstructor(ExecutionContext& pContext, Instance* pInstance, Type* pType, size_t pOffset = 0);
+      void executeConstructionPlan(ExecutionContext& pContext, const Value& pValue, Struct* pType);
+      void releaseLocalStatics(const Program* pProgram = nullptr);
+      void releaseLocalStatic(StatementVariableDeclaration* pStatement);
+      void releaseRetiredPrograms();
+
+      ExecutionProfile* acquireProfile(uint32_t pThreadIndex);
+      void releaseProfiles();
+      void beginProfiledCall(ExecutionContext& pContext, const Function* pFunction);
+      void beginProfiledCall(ExecutionContext& pContext, const Method* pMethod, const Type* pOwnerType);
+      void allocateLineCounters(Program* pProgram);
+      static void onAllocation(void* pEnvironment, size_t pSize);
+      void recordAllocation(size_t pSize);
+
+      uint64_t getScopeFingerprint(const ExecutionContext& pContext) const;
+      Expression* compileExpression(const char* pExpression);
+      void releaseCompiledExpressions();
+
+      CallFuture submitFunctionCall(Function* pFunction, const void* const* pArgData, size_t pArgsCount);
+      void discardQueuedCalls();
+
+      void copyCallArguments(Function* pFunction, const void* const* pArgData, size_t pArgsCount,
+         CflatArgsVector(Value)& pOutArgs);
+
+      ResumableCall* createResumableCall(Function* pFunction, const void* const* pArgData,
+         size_t pArgsCount);
+      void runResumableCall(ResumableCall* pCall);
+      void consumeExecutionBudget(ExecutionContext& pContext);
+      void releaseResumableCalls();
+
+      Coroutine* createCoroutine(Function* pFunction, const void* const* pArgData,
+         size_t pArgsCount);
+      void runCoroutine(Coroutine* pCoroutine);
+      void yieldCoroutine();
+      void releaseCoroutines();
+
+      bool hasSuspendedCalls() const;
+
+      ExecutionContext& getCurrentExecutionContext();
+      void requestParallelWorkers(size_t pWorkersCount);
+      void releaseParallelWorkers();
+      void runParallelWorkerThread(size_t pWorkerIndex);
+      void runParallelWorker(ParallelJob& pJob, size_t pWorkerIndex);
+      bool takeParallelCall(size_t pWorkerIndex, size_t pWorkersCount, size_t* pOutCallIndex);
+
+      static char* readFile(const char* pFilePath);
+
+      void requestLoadWorkers(size_t pWorkersCount);
+      void releaseLoadWorkers();
+      void runLoadWorkerThread(uint32_t pBatchGeneration);
+      void prepareLoadBatch(LoadBatch& pBatch);
+
+      ParsingContext* prepareProgram(const char* pProgramName, const char* pCode);
+      void parseReload(ParsingContext* pParsingContext);
+      bool commitProgram(ParsingContext* pParsingContext);
+
+      Hash getBindingsFingerprint() const;
+      Hash getMacrosFingerprint(uint32_t* pOutMacrosGeneration);
+      void getProgramCachePath(const Identifier& pProgramIdentifier, CflatSTLString* pOutPath) const;
+
+      bool readProgramCacheHeader(ParsingContext& pContext);
+      bool readProgramCache(ParsingContext& pContext);
+      void writeProgramCache(ParsingContext& pContext, Hash pBindingsFingerprint);
+
+      void indexFunctionBodies(ParsingContext& pContext);
+      void prepareIncrementalReload(ParsingContext& pContext, Program* pPreviousProgram);
+      const ParsingContext::FunctionBody* findFunctionBody(ParsingContext& pContext,
+         size_t pOpeningTokenIndex);
+      void keepUnchangedFunctionDeclarations(ParsingContext& pContext);
+      void executeReloaded(ExecutionContext& pContext, const Program& pProgram);
+      void executeReloaded(ExecutionContext& pContext, Statement* pStatement);
+
+      void retainDeferredTokens(ParsingContext& pContext);
+      bool parseDeferredFunctionBody(StatementFunctionDeclaration* pStatement);
+      bool parseCalledFunctionBody(ExecutionContext& pContext, StatementFunctionDeclaration* pStatement);
+      void parseAllDeferredFunctionBodies();
+
+      uint32_t writeCachedString(ProgramCacheWriter& pWriter, const Identifier& pIdentifier);
+      uint32_t writeCachedType(ProgramCacheWriter& pWriter, Type* pType);
+      void writeCachedTypeUsage(ProgramCacheWriter& pWriter, CflatSTLVector(char)& pBuffer,
+         const TypeUsage& pTypeUsage);
+      uint32_t writeCachedFunction(ProgramCacheWriter& pWriter, Function* pFunction);
+      void writeCachedMethod(ProgramCacheWriter& pWriter, Type* pOwnerType, Method* pMethod,
+         size_t pOffset);
+      void writeCachedExpression(ProgramCacheWriter& pWriter, Expression* pExpression);
+      void writeCachedStatement(ProgramCacheWriter& pWriter, Statement* pStatement);
+
+      Identifier readCachedString(ProgramCacheReader& pReader);
+      TypeUsage readCachedTypeUsage(ProgramCacheReader& pReader);
+      Function* readCachedFunction(ProgramCacheReader& pReader);
+      Method* readCachedMethod(ProgramCacheReader& pReader, size_t* pOutOffset);
+      Expression* readCachedExpression(ProgramCacheReader& pReader);
+      Statement* readCachedStatement(ProgramCacheReader& pReader, ParsingContext& pContext);
+
+      bool loadPrograms(const char* const* pProgramNames, const char* const* pCodes, size_t pCount,
+         CflatSTLVector(CflatSTLString)* pOutErrorMessages);
 
       void execute(ExecutionContext& pContext, const Program& pProgram);
       void execute(ExecutionContext& pContext, Statement* pStatement);
+      void executeStatement(ExecutionContext& pContext, Statement* pStatement);
+      void executeCountingLine(ExecutionContext& pContext, Statement* pStatement);
 
    public:
       static void assignReturnValueFromFunctionCall(const TypeUsage& pReturnTypeUsage,
@@ -1543,11 +2609,21 @@ namespace Cflat
 
    public:
       Environment();
+      Environment(const Memory::Allocator& pAllocator);
       ~Environment();
 
+      const Memory::Allocator* getAllocator() const;
+      void getMemoryStats(MemoryStats* pOutStats) const;
+      // Per-phase breakdown of the loads of the programs currently loaded, slowest first
+      void getLoadStats(LoadStats* pOutStats) const;
+
       void addSetting(Settings pSetting);
       void removeSetting(Settings pSetting);
 
+      // Parsed programs get cached in the given directory, and then read from there instead of
+      // parsed while neither their code nor the registered bindings change (nullptr to disable)
+      void setProgramCacheDirectory(const char* pDirectoryPath);
+
       void defineMacro(const char* pDefinition, const char* pBody);
 
       Namespace* getGlobalNamespace();
@@ -1557,11 +2633,17 @@ namespace Cflat
       template<typename T>
       T* registerType(const Identifier& pIdentifier)
       {
+         AccessScope accessScope(this, AccessType::Write);
+         Memory::AllocatorScope allocatorScope(&mAllocator);
+         mRegistrationGeneration++;
          return mGlobalNamespace.registerType<T>(pIdentifier);
       }
       template<typename T>
       T* registerTemplate(const Identifier& pIdentifier, const CflatArgsVector(TypeUsage)& pTemplateTypes)
       {
+         AccessScope accessScope(this, AccessType::Write);
+         Memory::AllocatorScope allocatorScope(&mAllocator);
+         mRegistrationGeneration++;
          return mGlobalNamespace.registerTemplate<T>(pIdentifier, pTemplateTypes);
       }
       void registerTypeAlias(const Identifier& pIdentifier, const TypeUsage& pTypeUsage);
@@ -1591,6 +2673,9 @@ namespace Cflat
          constexpr size_t argsCount = sizeof...(Args);
          CflatAssert(argsCount == pFunction->mParameters.size());
 
+         AccessScope accessScope(this, AccessType::Execute);
+         Memory::AllocatorScope allocatorScope(&mAllocator);
+
          mErrorMessage.clear();
 
          Cflat::Value returnValue;
@@ -1617,10 +2702,13 @@ namespace Cflat
       {
          CflatAssert(pFunction);
 
+         AccessScope accessScope(this, AccessType::Execute);
+         Memory::AllocatorScope allocatorScope(&mAllocator);
+
          mErrorMessage.clear();
 
          Cflat::Value returnValue;
-         returnValue.initOnStack(pFunction->mReturnTypeUsage, &mExecutionContext.mStack);
+         returnValue.initOnStack(pFunction->mReturnTypeUsage, &getCurrentExecutionContext().mStack);
 
          CflatArgsVector(Value) args;
 
@@ -1636,10 +2724,13 @@ namespace Cflat
          constexpr size_t argsCount = sizeof...(Args);
          CflatAssert(argsCount == pFunction->mParameters.size());
 
+         AccessScope accessScope(this, AccessType::Execute);
+         Memory::AllocatorScope allocatorScope(&mAllocator);
+
          mErrorMessage.clear();
 
          Cflat::Value returnValue;
-         returnValue.initOnStack(pFunction->mReturnTypeUsage, &mExecutionContext.mStack);
+         returnValue.initOnStack(pFunction->mReturnTypeUsage, &getCurrentExecutionContext().mStack);
 
          CflatArgsVector(Value) args;
          initArgumentsForFunctionCall(pFunction, args);
@@ -1661,14 +2752,135 @@ namespace Cflat
          return *(reinterpret_cast<ReturnType*>(returnValue.mValueBuffer));
       }
 
+      // Function calls that can be submitted from any thread without locking, and are then
+      // executed on the thread calling 'processQueuedCalls'. Arguments are passed as pointers,
+      // and get copied except for reference parameters, which must outlive the call
+      template<typename ...Args>
+      CallFuture queueFunctionCall(Function* pFunction, Args... pArgs)
+      {
+         CflatAssert(pFunction);
+
+         constexpr size_t argsCount = sizeof...(Args);
+         CflatAssert(argsCount == pFunction->mParameters.size());
+
+         const void* argData[argsCount + 1u] = { pArgs..., nullptr };
+         return submitFunctionCall(pFunction, argData, argsCount);
+      }
+      size_t processQueuedCalls();
+
+      // Function calls which get suspended once their execution budget runs out, and can be
+      // resumed later from the same point, so that expensive script work can be spread across
+      // frames. Arguments are passed as pointers, and get copied except for reference parameters,
+      // which must outlive the call. Nothing gets executed until the call is resumed.
+      template<typename ...Args>
+      ResumableCall* beginResumableCall(Function* pFunction, Args... pArgs)
+      {
+         CflatAssert(pFunction);
+
+         constexpr size_t argsCount = sizeof...(Args);
+         CflatAssert(argsCount == pFunction->mParameters.size());
+
+         const void* argData[argsCount + 1u] = { pArgs..., nullptr };
+         return createResumableCall(pFunction, argData, argsCount);
+      }
+      // Size in bytes of the native stack of the call, as in 'setCoroutineStackSize'
+      void setResumableCallStackSize(ResumableCall* pCall, size_t pStackSize);
+      // Runs the call until it finishes or the budget runs out; returns whether it has finished
+      bool resumeCall(ResumableCall* pCall, const ExecutionBudget& pBudget = ExecutionBudget());
+      // Calls released before finishing get aborted, unwinding their execution state
+      void releaseResumableCall(ResumableCall* pCall);
+
+      // Script functions run as coroutines can suspend themselves by calling 'yield', which hands
+      // control back to the caller of 'resumeCoroutine'. Resuming them continues from that point
+      // with their locals intact. Each coroutine runs on its own execution context and native
+      // stack on the resuming thread. Arguments are passed as in 'beginResumableCall', and
+      // nothing gets executed until the coroutine is resumed.
+      template<typename ...Args>
+      Coroutine* beginCoroutine(Function* pFunction, Args... pArgs)
+      {
+         CflatAssert(pFunction);
+
+         constexpr size_t argsCount = sizeof...(Args);
+         CflatAssert(argsCount == pFunction->mParameters.size());
+
+         const void* argData[argsCount + 1u] = { pArgs..., nullptr };
+         return createCoroutine(pFunction, argData, argsCount);
+      }
+      // Size in bytes of the native stack of the coroutine, kCoroutineStackSize by default.
+      // It gets allocated when the coroutine is resumed for the first time, so it can only be
+      // set before that. Where coroutines run on threads ('CflatCoroutineThreads'), their stack
+      // size is the default one of the platform instead.
+      void setCoroutineStackSize(Coroutine* pCoroutine, size_t pStackSize);
+      // Runs the coroutine until it yields or finishes; returns whether it has finished
+      bool resumeCoroutine(Coroutine* pCoroutine);
+      // Coroutines released before finishing get aborted, unwinding their execution state
+      void releaseCoroutine(Coroutine* pCoroutine);
+
+      // Calls a script function once per set of arguments, spreading the calls among worker
+      // threads which run them on their own stacks. Arguments are passed as a flat array of
+      // pointers (parameters count per call), and return values are written contiguously
+      bool parallelInvoke(Function* pFunction, const void* const* pArgsArray, size_t pCount,
+         void* pOutReturnValues = nullptr, size_t pThreadsCount = 0u);
+
+      // Preprocesses and tokenizes the program with shared access. With the IncrementalReload
+      // setting, reloads which only change function bodies get parsed with shared access as well;
+      // any other load gets parsed and executed with exclusive access.
       bool load(const char* pProgramName, const char* pCode);
       bool load(const char* pFilePath);
+      // Preprocesses and tokenizes the programs on worker threads, with shared access. Parsing
+      // still takes place on the calling thread, one program at a time and in the given order,
+      // with exclusive access held while each of them gets parsed and executed, so it only
+      // scales with the preprocessing stage.
+      bool loadMany(const char* const* pProgramNames, const char* const* pCodes, size_t pCount,
+         CflatSTLVector(CflatSTLString)* pOutErrorMessages = nullptr);
+      bool loadMany(const char* const* pFilePaths, size_t pCount,
+         CflatSTLVector(CflatSTLString)* pOutErrorMessages = nullptr);
+
+      const Program* getProgram(const Identifier& pProgramIdentifier) const;
+
+      // Parses the function bodies of the program which have not been called yet, when loaded
+      // with the LazyFunctionBodies setting, in the order they appear in the code. Returns false
+      // if any of them does not compile, with the same error that loading would have reported.
+      bool parseDeferredFunctionBodies(const Identifier& pProgramIdentifier);
 
       const char* getErrorMessage();
 
       void setExecutionHook(ExecutionHook pExecutionHook);
       bool evaluateExpression(const char* pExpression, Value* pOutValue);
 
+      // Instrumenting profiler for the function and method calls made from script code, which
+      // costs a single check per call while disabled. It cannot be toggled nor reset from calls
+      // made by script code.
+      void setProfilingEnabled(bool pEnabled);
+      bool isProfilingEnabled() const;
+      void resetProfile();
+      void getProfileStats(ProfileStats* pOutStats) const;
+      // Chrome trace-event JSON, which can be opened in chrome://tracing or Perfetto
+      void exportProfileTrace(CflatSTLString* pOutTrace) const;
+      // One line per call path with its exclusive time ("caller;callee nanoseconds"), as taken
+      // by flame graph tools
+      void exportProfileFoldedStacks(CflatSTLString* pOutStacks) const;
+
+      // Per-line execution counters of the loaded programs, which double as line coverage. Like
+      // profiling, they cannot be toggled nor reset from calls made by script code.
+      void setLineCountingEnabled(bool pEnabled);
+      bool isLineCountingEnabled() const;
+      void resetLineCounters();
+      void getLinesReport(LinesReport* pOutReport, size_t pHottestLinesCount = 10u) const;
+
+      // Accounts the allocations made through the environment by script executions, to drive
+      // them towards zero in steady state (see AllocationFreeScope). It cannot be toggled nor
+      // reset from calls made by script code.
+      void setAllocationTrackingEnabled(bool pEnabled);
+      bool isAllocationTrackingEnabled() const;
+      void resetAllocationReport();
+      void getAllocationReport(AllocationReport* pOutReport) const;
+
+      // Counters of the environment's execution context and the parallel workers, combined.
+      // Resetting them also resets the stack peaks reported by getMemoryStats.
+      void getExecutionCounters(ExecutionCounters* pOutCounters) const;
+      void resetExecutionCounters();
+
       void throwCustomRuntimeError(const char* pErrorMessage);
 
       void resetStatics();
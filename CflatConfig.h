@@ -35,6 +35,15 @@
 # define CflatAssert  assert
 #endif
 
+// The tokenizer scans source code in SSE2/AVX2 blocks when the target supports them;
+// define CflatDisableSIMD to make it use the scalar implementation instead
+//#define CflatDisableSIMD
+
+// Execution contexts count the executed statements, evaluated expressions, calls, etc. (see
+// Environment::getExecutionCounters) at the cost of an increment each; define
+// CflatDisableExecutionCounters to compile the counting out
+//#define CflatDisableExecutionCounters
+
 namespace Cflat
 {
   // Maximum number of arguments in a function call
@@ -49,6 +58,10 @@ namespace Cflat
 
   // Size in bytes for the environment stack
   static const size_t kEnvironmentStackSize = 1024u * 8u;
+  // Default size in bytes for the native stack of each coroutine and resumable call (see
+  // setCoroutineStackSize), which fits around 8 nested script function calls in optimized
+  // builds. Unoptimized and sanitized builds take more stack per call.
+  static const size_t kCoroutineStackSize = 1024u * 64u;
 
   // Size in bytes for local string buffers
   static const size_t kDefaultLocalStringBufferSize = 256u;
@@ -1104,6 +1104,7 @@
       pBaseType* baseTypePtr = static_cast<pBaseType*>(derivedTypePtr); \
       baseType.mOffset = (uint16_t)((char*)baseTypePtr - (char*)derivedTypePtr); \
       type->mBaseTypes.push_back(baseType); \
+      Cflat::Struct::invalidateConstructionPlans(); \
    }
 #define CflatStructAddMember(pEnvironmentPtr, pStructType, pMemberType, pMemberName) \
    { \
@@ -3761,6 +3762,7 @@
    { \
       const size_t methodIndex = type->mMethods.size() - 1u; \
       type->mCachedMethodIndexDefaultConstructor = (int8_t)methodIndex; \
+      Cflat::Struct::invalidateConstructionPlans(); \
       Cflat::Method* method = &type->mMethods.back(); \
       method->execute = [type, methodIndex] \
          (const Cflat::Value& pThis, const CflatArgsVector(Cflat::Value)& pArguments, Cflat::Value* pOutReturnValue) \
@@ -86,7 +86,8 @@ namespace Cflat
       "null pointer access ('%s')",
       "invalid array index (%s)",
       "division by zero",
-      "missing implementation for the '%s' function"
+      "missing implementation for the '%s' function",
+      "'yield' called outside of a coroutine"
    };
    const size_t kRuntimeErrorStringsCount = sizeof(kRuntimeErrorStrings) / sizeof(const char*);
 }
@@ -60,6 +60,10 @@ namespace Cflat
 
       Expression()
       {
+         if(gLoadingProgramStats)
+         {
+            gLoadingProgramStats->mExpressionsCount++;
+         }
       }
 
    public:
@@ -106,10 +110,13 @@ namespace Cflat
    struct ExpressionVariableAccess : Expression
    {
       Identifier mVariableIdentifier;
+      // Storage of the accessed variable when it is a local static, bound when parsing
+      Value* mStaticValue;
 
       ExpressionVariableAccess(const Identifier& pVariableIdentifier,
          const TypeUsage& pVariableTypeUsage)
          : mVariableIdentifier(pVariableIdentifier)
+         , mStaticValue(nullptr)
       {
          mType = ExpressionType::VariableAccess;
          mTypeUsage = pVariableTypeUsage;
@@ -123,15 +130,63 @@ namespace Cflat
       Method
    };
 
+   // Member accesses get a slot each, where the execution contexts other than the
+   // environment's one keep the owner value, since they cannot share the one cached in the
+   // expression. Slots are shared by all environments, and the released ones get reused.
+   typedef CflatSTLVector(uint32_t) MemberOwnerSlotsList;
+
+   static std::mutex gMemberOwnerSlotsMutex;
+   static uint32_t gMemberOwnerSlotsCount = 0u;
+   static MemberOwnerSlotsList* gReleasedMemberOwnerSlots = nullptr;
+
+   static uint32_t acquireMemberOwnerSlot()
+   {
+      std::lock_guard<std::mutex> lock(gMemberOwnerSlotsMutex);
+
+      if(gReleasedMemberOwnerSlots && !gReleasedMemberOwnerSlots->empty())
+      {
+         const uint32_t slot = gReleasedMemberOwnerSlots->back();
+         gReleasedMemberOwnerSlots->pop_back();
+         return slot;
+      }
+
+      return gMemberOwnerSlotsCount++;
+   }
+
+   static void releaseMemberOwnerSlot(uint32_t pSlot)
+   {
+      Memory::AllocatorScope allocatorScope(Memory::getDefaultAllocator());
+      std::lock_guard<std::mutex> lock(gMemberOwnerSlotsMutex);
+
+      if(!gReleasedMemberOwnerSlots)
+      {
+         gReleasedMemberOwnerSlots = (MemberOwnerSlotsList*)CflatMalloc(sizeof(MemberOwnerSlotsList));
+         CflatInvokeCtor(MemberOwnerSlotsList, gReleasedMemberOwnerSlots);
+      }
+
+      gReleasedMemberOwnerSlots->push_back(pSlot);
+
+      // once all of them have been released, the numbering starts over
+      if(gReleasedMemberOwnerSlots->size() == gMemberOwnerSlotsCount)
+      {
+         CflatInvokeDtor(MemberOwnerSlotsList, gReleasedMemberOwnerSlots);
+         CflatFree(gReleasedMemberOwnerSlots);
+         gReleasedMemberOwnerSlots = nullptr;
+         gMemberOwnerSlotsCount = 0u;
+      }
+   }
+
    struct ExpressionMemberAccess : Expression
    {
       Expression* mMemberOwner;
       Value mMemberOwnerValue;
+      uint32_t mMemberOwnerSlot;
       Identifier mMemberIdentifier;
       MemberAccessType mMemberAccessType;
 
       ExpressionMemberAccess(Expression* pMemberOwner, const Identifier& pMemberIdentifier)
          : mMemberOwner(pMemberOwner)
+         , mMemberOwnerSlot(acquireMemberOwnerSlot())
          , mMemberIdentifier(pMemberIdentifier)
          , mMemberAccessType(MemberAccessType::Field)
       {
@@ -145,6 +200,8 @@ namespace Cflat
             CflatInvokeDtor(Expression, mMemberOwner);
             CflatFree(mMemberOwner);
          }
+
+         releaseMemberOwnerSlot(mMemberOwnerSlot);
       }
 
       void assignTypeUsage(const TypeUsage& pTypeUsage)
@@ -398,8 +455,11 @@ namespace Cflat
       {
          for(size_t i = 0u; i < mArguments.size(); i++)
          {
-            CflatInvokeDtor(Expression, mArguments[i]);
-            CflatFree(mArguments[i]);
+            if(mArguments[i])
+            {
+               CflatInvokeDtor(Expression, mArguments[i]);
+               CflatFree(mArguments[i]);
+            }
          }
       }
 
@@ -446,8 +506,11 @@ namespace Cflat
 
          for(size_t i = 0u; i < mArguments.size(); i++)
          {
-            CflatInvokeDtor(Expression, mArguments[i]);
-            CflatFree(mArguments[i]);
+            if(mArguments[i])
+            {
+               CflatInvokeDtor(Expression, mArguments[i]);
+               CflatFree(mArguments[i]);
+            }
          }
       }
 
@@ -485,8 +548,11 @@ namespace Cflat
       {
          for(size_t i = 0u; i < mValues.size(); i++)
          {
-            CflatInvokeDtor(Expression, mValues[i]);
-            CflatFree(mValues[i]);
+            if(mValues[i])
+            {
+               CflatInvokeDtor(Expression, mValues[i]);
+               CflatFree(mValues[i]);
+            }
          }
       }
 
@@ -513,8 +579,11 @@ namespace Cflat
       {
          for(size_t i = 0u; i < mValues.size(); i++)
          {
-            CflatInvokeDtor(Expression, mValues[i]);
-            CflatFree(mValues[i]);
+            if(mValues[i])
+            {
+               CflatInvokeDtor(Expression, mValues[i]);
+               CflatFree(mValues[i]);
+            }
          }
       }
    };
@@ -535,8 +604,11 @@ namespace Cflat
       {
          for(size_t i = 0u; i < mArguments.size(); i++)
          {
-            CflatInvokeDtor(Expression, mArguments[i]);
-            CflatFree(mArguments[i]);
+            if(mArguments[i])
+            {
+               CflatInvokeDtor(Expression, mArguments[i]);
+               CflatFree(mArguments[i]);
+            }
          }
       }
    };
@@ -48,6 +48,22 @@ namespace Cflat
       return hash;
    }
 
+   Hash hash(const char* pString, size_t pLength)
+   {
+      static const Hash kOffsetBasis = 2166136261u;
+      static const Hash kFNVPrime = 16777619u;
+
+      Hash hash = kOffsetBasis;
+
+      for(size_t charIndex = 0u; charIndex < pLength; charIndex++)
+      {
+         hash ^= pString[charIndex];
+         hash *= kFNVPrime;
+      }
+
+      return hash;
+   }
+
    Hash hash(const wchar_t* pString)
    {
       static const Hash kOffsetBasis = 2166136261u;
@@ -61,6 +61,10 @@ namespace Cflat
          : mProgram(nullptr)
          , mLine(0u)
       {
+         if(gLoadingProgramStats)
+         {
+            gLoadingProgramStats->mStatementsCount++;
+         }
       }
 
    public:
@@ -112,8 +116,11 @@ namespace Cflat
       {
          for(size_t i = 0u; i < mStatements.size(); i++)
          {
-            CflatInvokeDtor(Statement, mStatements[i]);
-            CflatFree(mStatements[i]);
+            if(mStatements[i])
+            {
+               CflatInvokeDtor(Statement, mStatements[i]);
+               CflatFree(mStatements[i]);
+            }
          }
       }
    };
@@ -159,24 +166,82 @@ namespace Cflat
       Expression* mInitialValue;
       bool mStatic;
 
+      // Storage for local static variables, linked into the environment's list of
+      // initialized local statics the first time the declaration gets executed
+      Value mStaticValue;
+      StatementVariableDeclaration** mStaticListHead;
+      StatementVariableDeclaration* mPreviousStatic;
+      StatementVariableDeclaration* mNextStatic;
+      // Set once the static has been initialized, so that later executions skip locking
+      std::atomic<bool> mStaticInitialized;
+
       StatementVariableDeclaration(const TypeUsage& pTypeUsage, const Identifier& pVariableIdentifier,
          Expression* pInitialValue, bool pStatic)
          : mTypeUsage(pTypeUsage)
          , mVariableIdentifier(pVariableIdentifier)
          , mInitialValue(pInitialValue)
          , mStatic(pStatic)
+         , mStaticListHead(nullptr)
+         , mPreviousStatic(nullptr)
+         , mNextStatic(nullptr)
+         , mStaticInitialized(false)
       {
          mType = StatementType::VariableDeclaration;
       }
 
       virtual ~StatementVariableDeclaration()
       {
+         unlinkStatic();
+
          if(mInitialValue)
          {
             CflatInvokeDtor(Expression, mInitialValue);
             CflatFree(mInitialValue);
          }
       }
+
+      void linkStatic(StatementVariableDeclaration** pListHead)
+      {
+         CflatAssert(!mStaticListHead);
+
+         mStaticListHead = pListHead;
+         mPreviousStatic = nullptr;
+         mNextStatic = *pListHead;
+
+         if(mNextStatic)
+         {
+            mNextStatic->mPreviousStatic = this;
+         }
+
+         *pListHead = this;
+      }
+
+      void unlinkStatic()
+      {
+         if(!mStaticListHead)
+         {
+            return;
+         }
+
+         if(mPreviousStatic)
+         {
+            mPreviousStatic->mNextStatic = mNextStatic;
+         }
+         else
+         {
+            *mStaticListHead = mNextStatic;
+         }
+
+         if(mNextStatic)
+         {
+            mNextStatic->mPreviousStatic = mPreviousStatic;
+         }
+
+         mStaticListHead = nullptr;
+         mPreviousStatic = nullptr;
+         mNextStatic = nullptr;
+         mStaticInitialized.store(false, std::memory_order_relaxed);
+      }
    };
 
    struct StatementNamespaceDeclaration : Statement
@@ -201,6 +266,17 @@ namespace Cflat
       }
    };
 
+   // Parsing state at the declaration of a function, for bodies which get parsed on the first call
+   struct DeferredFunctionBody
+   {
+      size_t mFunctionTokenIndex;
+      size_t mOpeningTokenIndex;
+      Namespace* mNamespace;
+      CflatSTLVector(UsingDirective) mUsingDirectives;
+      CflatSTLVector(TypeAlias) mTypeAliases;
+      CflatSTLString mErrorMessage;
+   };
+
    struct StatementFunctionDeclaration : Statement
    {
       TypeUsage mReturnType;
@@ -209,12 +285,19 @@ namespace Cflat
       CflatSTLVector(TypeUsage) mParameterTypes;
       StatementBlock* mBody;
       Function* mFunction;
+      uint64_t mBodyFingerprint;
+
+      DeferredFunctionBody* mDeferredBody;
+      bool mBodyDeferred;
 
       StatementFunctionDeclaration(const TypeUsage& pReturnType, const Identifier& pFunctionIdentifier)
          : mReturnType(pReturnType)
          , mFunctionIdentifier(pFunctionIdentifier)
          , mBody(nullptr)
          , mFunction(nullptr)
+         , mBodyFingerprint(0u)
+         , mDeferredBody(nullptr)
+         , mBodyDeferred(false)
       {
          mType = StatementType::FunctionDeclaration;
       }
@@ -227,6 +310,12 @@ namespace Cflat
             CflatFree(mBody);
          }
 
+         if(mDeferredBody)
+         {
+            CflatInvokeDtor(DeferredFunctionBody, mDeferredBody);
+            CflatFree(mDeferredBody);
+         }
+
          if(mFunction && mFunction->mProgram == mProgram)
          {
             mFunction->execute = nullptr;
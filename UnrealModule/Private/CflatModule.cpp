@@ -1697,6 +1697,12 @@ void UnrealModule::LoadScripts(const FString& pScriptsPath, const FString& pFile
    TArray<FString> failedScripts;
    TArray<FString> errorMessages;
 
+   // Read all files up front, so that the environment can prepare them in parallel
+   TArray<FString> loadedScriptPaths;
+   TArray<FString> loadedScriptFilenames;
+   TArray<Cflat::Identifier> programIds;
+   CflatSTLVector(CflatSTLString) scriptCodes;
+
    for(int32 i = 0; i < scriptFilenames.Num(); i++)
    {
       if(pFilterDelegate && !pFilterDelegate(scriptFilenames[i]))
@@ -1705,15 +1711,48 @@ void UnrealModule::LoadScripts(const FString& pScriptsPath, const FString& pFile
       }
 
       const FString scriptPath = FString::Printf(TEXT("%s/%s"), *pScriptsPath, *scriptFilenames[i]);
+      FString scriptCode;
 
-      if(!LoadScript(scriptPath))
+      if(!ReadScriptFile(scriptPath, scriptCode))
       {
-         const FString errorMessage = gEnv.getErrorMessage();
-
          failedScripts.Add(scriptFilenames[i]);
-         errorMessages.Add(errorMessage);
+         errorMessages.Add(FString::Printf(TEXT("The script file ('%s') could not be read"), *scriptPath));
+         continue;
       }
+
+      UE_LOG(LogCflat, Display, TEXT("Loading script '%s'..."), *scriptFilenames[i]);
+
+      const FString programName = FPaths::GetBaseFilename(scriptPath);
+
+      loadedScriptPaths.Add(scriptPath);
+      loadedScriptFilenames.Add(scriptFilenames[i]);
+      programIds.Add(Cflat::Identifier(TCHAR_TO_ANSI(*programName)));
+      scriptCodes.push_back(TCHAR_TO_ANSI(*scriptCode));
    }
+
+   TArray<const char*> programNames;
+   TArray<const char*> codes;
+
+   for(int32 i = 0; i < programIds.Num(); i++)
+   {
+      programNames.Add(programIds[i].mName);
+      codes.Add(scriptCodes[i].c_str());
+   }
+
+   CflatSTLVector(CflatSTLString) loadErrorMessages;
+   gEnv.loadMany(programNames.GetData(), codes.GetData(), (size_t)codes.Num(), &loadErrorMessages);
+
+   for(int32 i = 0; i < programIds.Num(); i++)
+   {
+      const char* loadErrorMessage = loadErrorMessages[i].empty() ? nullptr : loadErrorMessages[i].c_str();
+
+      if(!OnScriptLoaded(loadedScriptPaths[i], programIds[i], loadErrorMessage))
+      {
+         failedScripts.Add(loadedScriptFilenames[i]);
+         errorMessages.Add(FString(loadErrorMessage));
+      }
+   }
+
    if (!failedScripts.IsEmpty())
    {
       for (int32 i = 0; i < smOnScriptReloadFailedCallbacks.Num(); i++)
@@ -2244,6 +2283,24 @@ FString UnrealModule::GetFunctionAsString(const Cflat::Function* pFunction)
 bool UnrealModule::LoadScript(const FString& pFilePath)
 {
    FString scriptCode;
+
+   if(!ReadScriptFile(pFilePath, scriptCode))
+   {
+      return false;
+   }
+
+   const FString fileName = FPaths::GetCleanFilename(pFilePath);
+   const FString programName = FPaths::GetBaseFilename(pFilePath);
+   UE_LOG(LogCflat, Display, TEXT("Loading script '%s'..."), *fileName);
+
+   Cflat::Identifier programId(TCHAR_TO_ANSI(*programName));
+
+   const bool success = gEnv.load(programId.mName, TCHAR_TO_ANSI(*scriptCode));
+   return OnScriptLoaded(pFilePath, programId, success ? nullptr : gEnv.getErrorMessage());
+}
+
+bool UnrealModule::ReadScriptFile(const FString& pFilePath, FString& pOutCode)
+{
    const TCHAR* tcharFilePath = *pFilePath;
    const FFileHelper::EHashOptions verifyFlags = FFileHelper::EHashOptions::None;
    const uint32 readFlags = FILEREAD_AllowWrite;
@@ -2251,27 +2308,27 @@ bool UnrealModule::LoadScript(const FString& pFilePath)
    // There's no need to write anything in the file, but passing 'FILEREAD_AllowWrite' helps
    // preventing ERROR_SHARING_VIOLATION on Windows when calling 'CreateFileW' (error code 32)
  
-   if(!FFileHelper::LoadFileToString(scriptCode, tcharFilePath, verifyFlags, readFlags))
+   if(!FFileHelper::LoadFileToString(pOutCode, tcharFilePath, verifyFlags, readFlags))
    {
       UE_LOG(LogCflat, Error, TEXT("The script file ('%s') could not be read"), tcharFilePath);
 
       return false;
    }
 
-   const FString fileName = FPaths::GetCleanFilename(pFilePath);
-   const FString programName = FPaths::GetBaseFilename(pFilePath);
-   UE_LOG(LogCflat, Display, TEXT("Loading script '%s'..."), *fileName);
-
-   Cflat::Identifier programId(TCHAR_TO_ANSI(*programName));
+   return true;
+}
 
-   if(!gEnv.load(programId.mName, TCHAR_TO_ANSI(*scriptCode)))
+bool UnrealModule::OnScriptLoaded(const FString& pFilePath, const Cflat::Identifier& pProgramId, const char* pErrorMessage)
+{
+   if(pErrorMessage)
    {
-      const FString errorMessage(gEnv.getErrorMessage());
+      const FString errorMessage(pErrorMessage);
       UE_LOG(LogCflat, Error, TEXT("%s"), *errorMessage);
 
       return false;
    }
-   smProgramPaths.Add(programId.mHash, FPaths::GetPath(pFilePath));
+
+   smProgramPaths.Add(pProgramId.mHash, FPaths::GetPath(pFilePath));
 
    return true;
 }
@@ -151,6 +151,9 @@ private:
    };
    static TArray<OnScriptReloadFailedEntry> smOnScriptReloadFailedCallbacks;
    static TMap<uint32_t, FString> smProgramPaths;
+
+   static bool ReadScriptFile(const FString& pFilePath, FString& pOutCode);
+   static bool OnScriptLoaded(const FString& pFilePath, const Cflat::Identifier& pProgramId, const char* pErrorMessage);
 };
 }
 
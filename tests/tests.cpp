@@ -3,6 +3,10 @@
 
 #include "../CflatHelper.h"
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 
 class ConstPointerTestClass
 {
@@ -220,6 +224,122 @@ TEST(Preprocessor, DefinedMacroWithParenthesisParam)
    EXPECT_EQ(var, 42);
 }
 
+TEST(Preprocessor, DefinedMacroInvocationSpanningLines)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "#define ADD(a, b) (a + b)\n"
+      "int var = ADD(40,\n"
+      "  2);\n"
+      "int var2 = undefinedVar;\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 4: undefined variable ('undefinedVar')"), 0);
+}
+
+TEST(Preprocessor, DefinedMacrosAvailableInLaterPrograms)
+{
+   Cflat::Environment env;
+
+   const char* programNames[] = { "macros", "test" };
+   const char* codes[] =
+   {
+      "#define FACTOR 21\n"
+      "#define MULTIPLY(a, b) (a * b)\n",
+      "int var = FACTOR * 2;\n"
+      "int var2 = MULTIPLY(6, 7);\n"
+   };
+
+   EXPECT_TRUE(env.loadMany(programNames, codes, 2u));
+
+   int var = CflatValueAs(env.getVariable("var"), int);
+   EXPECT_EQ(var, 42);
+   int var2 = CflatValueAs(env.getVariable("var2"), int);
+   EXPECT_EQ(var2, 42);
+}
+
+TEST(Preprocessor, DefinedMacrosAvailableInLaterProgramsOfLargeBatches)
+{
+   Cflat::Environment env;
+
+   const size_t kProgramsCount = 64u;
+
+   CflatSTLVector(std::string) programNames;
+   CflatSTLVector(std::string) codes;
+
+   // the programs mentioning the macros, or not, might have been prepared before the ones
+   // defining them get committed
+   for(size_t i = 0u; i < kProgramsCount; i++)
+   {
+      char code[128];
+
+      if(i % 16u == 0u)
+      {
+         snprintf(code, sizeof(code), "#define FACTOR_%d %d\n", (int)(i / 16u), (int)(i / 16u) + 1);
+      }
+      else if(i % 2u == 0u)
+      {
+         snprintf(code, sizeof(code), "int var%d = FACTOR_%d * 2;\n", (int)i, (int)(i / 16u));
+      }
+      else
+      {
+         snprintf(code, sizeof(code), "int var%d = %d;\n", (int)i, (int)i);
+      }
+
+      programNames.push_back("program" + std::to_string(i));
+      codes.push_back(code);
+   }
+
+   CflatSTLVector(const char*) programNamePointers;
+   CflatSTLVector(const char*) codePointers;
+
+   for(size_t i = 0u; i < codes.size(); i++)
+   {
+      programNamePointers.push_back(programNames[i].c_str());
+      codePointers.push_back(codes[i].c_str());
+   }
+
+   EXPECT_TRUE(env.loadMany(programNamePointers.data(), codePointers.data(), codes.size()));
+
+   for(size_t i = 0u; i < kProgramsCount; i++)
+   {
+      if(i % 16u == 0u)
+         continue;
+
+      const std::string variableName = "var" + std::to_string(i);
+      const Cflat::Value* value = env.getVariable(variableName.c_str());
+      ASSERT_TRUE(value);
+
+      const int expectedValue = i % 2u == 0u ? ((int)(i / 16u) + 1) * 2 : (int)i;
+      EXPECT_EQ(CflatValueAs(value, int), expectedValue);
+   }
+}
+
+TEST(Preprocessor, DefinedMacroRedefinition)
+{
+   Cflat::Environment env;
+   env.defineMacro("FACTOR", "2");
+
+   const char* code =
+      "int var1 = FACTOR * 21;\n"
+      "#define FACTOR 3\n"
+      "int var2 = FACTOR * 14;\n"
+      "int var3 = FACTOR * FACTOR;\n";
+
+   EXPECT_TRUE(env.load("test", code));
+
+   EXPECT_EQ(CflatValueAs(env.getVariable("var1"), int), 42);
+   EXPECT_EQ(CflatValueAs(env.getVariable("var2"), int), 42);
+   EXPECT_EQ(CflatValueAs(env.getVariable("var3"), int), 9);
+
+   env.defineMacro("FACTOR", "6");
+
+   EXPECT_TRUE(env.load("test2", "int var4 = FACTOR * 7;\n"));
+   EXPECT_EQ(CflatValueAs(env.getVariable("var4"), int), 42);
+}
+
 TEST(Cflat, VariableDeclaration)
 {
    Cflat::Environment env;
@@ -807,6 +927,110 @@ TEST(Cflat, MemberAccessOnTemporaryInstance)
    EXPECT_FLOAT_EQ(var, 42.0f);
 }
 
+TEST(Cflat, DefaultConstructorsOfMembersAndBaseTypes)
+{
+   static int constructedCount = 0;
+
+   struct TestStruct
+   {
+      int member;
+
+      TestStruct() : member(42) { constructedCount++; }
+   };
+   // no members of its own, so that it remains standard-layout
+   struct TestStructDerived : TestStruct
+   {
+   };
+
+   Cflat::Environment env;
+
+   {
+      CflatRegisterStruct(&env, TestStruct);
+      CflatStructAddConstructor(&env, TestStruct);
+      CflatStructAddMember(&env, TestStruct, int, member);
+   }
+   {
+      CflatRegisterStruct(&env, TestStructDerived);
+      CflatStructAddBaseType(&env, TestStructDerived, TestStruct);
+   }
+
+   const char* code =
+      "struct Inner\n"
+      "{\n"
+      "  TestStructDerived derived;\n"
+      "  int value;\n"
+      "};\n"
+      "struct Outer\n"
+      "{\n"
+      "  Inner inner;\n"
+      "  TestStruct first;\n"
+      "  TestStruct second;\n"
+      "};\n"
+      "int func()\n"
+      "{\n"
+      "  int sum = 0;\n"
+      "  for(int i = 0; i < 2; i++)\n"
+      "  {\n"
+      "    Outer outer;\n"
+      "    sum += outer.inner.derived.member + outer.first.member + outer.second.member;\n"
+      "  }\n"
+      "  return sum;\n"
+      "}\n"
+      "int var = func();\n";
+
+   EXPECT_TRUE(env.load("test", code));
+
+   EXPECT_EQ(CflatValueAs(env.getVariable("var"), int), 42 * 3 * 2);
+   EXPECT_EQ(constructedCount, 3 * 2);
+}
+
+TEST(Cflat, DefaultConstructorsRegisteredAfterFirstUse)
+{
+   static int constructedCount = 0;
+
+   struct TestStruct
+   {
+      int member;
+
+      TestStruct() : member(42) { constructedCount++; }
+   };
+   struct TestStructHolder
+   {
+      TestStruct held;
+   };
+
+   Cflat::Environment env;
+
+   {
+      CflatRegisterStruct(&env, TestStruct);
+      CflatStructAddMember(&env, TestStruct, int, member);
+   }
+   {
+      CflatRegisterStruct(&env, TestStructHolder);
+      CflatStructAddMember(&env, TestStructHolder, TestStruct, held);
+   }
+
+   const char* code =
+      "void func()\n"
+      "{\n"
+      "  TestStructHolder holder;\n"
+      "}\n";
+
+   EXPECT_TRUE(env.load("test", code));
+
+   Cflat::Function* func = env.getFunction("func");
+   env.voidFunctionCall(func);
+   EXPECT_EQ(constructedCount, 0);
+
+   {
+      Cflat::Struct* type = static_cast<Cflat::Struct*>(env.getType("TestStruct"));
+      CflatStructAddConstructor(&env, TestStruct);
+   }
+
+   env.voidFunctionCall(func);
+   EXPECT_EQ(constructedCount, 1);
+}
+
 TEST(Cflat, BitFieldAccess)
 {
    struct TestStruct
@@ -3113,6 +3337,83 @@ TEST(Cflat, StaticVariable)
    EXPECT_EQ(CflatValueAs(env.getVariable("var3"), int), 3);
 }
 
+TEST(Cflat, StaticVariableReset)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "int func()\n"
+      "{\n"
+      "  static int var = 0;\n"
+      "  return ++var;\n"
+      "}\n"
+      "int result = 0;\n"
+      "void run()\n"
+      "{\n"
+      "  result = func() + func();\n"
+      "}\n";
+
+   EXPECT_TRUE(env.load("test", code));
+
+   Cflat::Function* run = env.getFunction("run");
+   env.voidFunctionCall(run);
+   EXPECT_EQ(CflatValueAs(env.getVariable("result"), int), 1 + 2);
+   env.voidFunctionCall(run);
+   EXPECT_EQ(CflatValueAs(env.getVariable("result"), int), 3 + 4);
+
+   env.resetStatics();
+   env.voidFunctionCall(run);
+   EXPECT_EQ(CflatValueAs(env.getVariable("result"), int), 1 + 2);
+
+   // reloading the program releases the storage of its local statics
+   EXPECT_TRUE(env.load("test", code));
+   run = env.getFunction("run");
+   env.voidFunctionCall(run);
+   EXPECT_EQ(CflatValueAs(env.getVariable("result"), int), 1 + 2);
+}
+
+TEST(Cflat, StaticVariableDestroyedOnReload)
+{
+   Cflat::Environment env;
+
+   static int destroyedCount = 0;
+
+   struct TestStruct
+   {
+      int value;
+
+      TestStruct() : value(0) {}
+      ~TestStruct() { destroyedCount++; }
+   };
+
+   {
+      CflatRegisterStruct(&env, TestStruct);
+      CflatStructAddConstructor(&env, TestStruct);
+      CflatStructAddMember(&env, TestStruct, int, value);
+      CflatStructAddDestructor(&env, TestStruct);
+   }
+
+   const char* code =
+      "int func()\n"
+      "{\n"
+      "  static TestStruct instance;\n"
+      "  return ++instance.value;\n"
+      "}\n";
+
+   EXPECT_TRUE(env.load("test", code));
+
+   Cflat::Function* func = env.getFunction("func");
+   EXPECT_EQ(env.returnFunctionCall<int>(func), 1);
+   EXPECT_EQ(env.returnFunctionCall<int>(func), 2);
+   EXPECT_EQ(destroyedCount, 0);
+
+   EXPECT_TRUE(env.load("test", code));
+   EXPECT_EQ(destroyedCount, 1);
+
+   func = env.getFunction("func");
+   EXPECT_EQ(env.returnFunctionCall<int>(func), 1);
+}
+
 TEST(Cflat, Destructor)
 {
    Cflat::Environment env;
@@ -3141,6 +3442,68 @@ TEST(Cflat, Destructor)
    EXPECT_EQ(staticVar, 1);
 }
 
+TEST(Cflat, DestructorInNestedScopes)
+{
+   Cflat::Environment env;
+
+   static int destroyedCount = 0;
+
+   struct TestStruct
+   {
+      ~TestStruct() { destroyedCount++; }
+   };
+
+   {
+      CflatRegisterStruct(&env, TestStruct);
+      CflatStructAddDestructor(&env, TestStruct);
+   }
+
+   const char* code =
+      "void func()\n"
+      "{\n"
+      "  TestStruct outer;\n"
+      "  for(int i = 0; i < 3; i++)\n"
+      "  {\n"
+      "    int value = i;\n"
+      "    TestStruct inner;\n"
+      "    {\n"
+      "      TestStruct innermost;\n"
+      "    }\n"
+      "  }\n"
+      "}\n";
+
+   EXPECT_TRUE(env.load("test", code));
+   env.voidFunctionCall(env.getFunction("func"));
+
+   EXPECT_EQ(destroyedCount, 7);
+}
+
+TEST(Cflat, LocalInstancesInDeepRecursion)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "int sum(int n)\n"
+      "{\n"
+      "  int a = n;\n"
+      "  int b = a;\n"
+      "  int c = b;\n"
+      "  int d = c;\n"
+      "  if(n == 0)\n"
+      "  {\n"
+      "    return 0;\n"
+      "  }\n"
+      "  int result = sum(n - 1);\n"
+      "  return d + result;\n"
+      "}\n"
+      "int var1 = sum(15);\n"
+      "int var2 = sum(15);\n";
+
+   EXPECT_TRUE(env.load("test", code));
+   EXPECT_EQ(CflatValueAs(env.getVariable("var1"), int), 120);
+   EXPECT_EQ(CflatValueAs(env.getVariable("var2"), int), 120);
+}
+
 TEST(Cflat, FunctionPreDeclarationNoParams)
 {
     Cflat::Environment env;
@@ -4579,656 +4942,3164 @@ TEST(Cflat, Logging)
    std::cout.rdbuf(coutBuf);
 }
 
-TEST(Cflat, HotReload)
+TEST(Cflat, QueuedFunctionCallsFromOtherThreads)
 {
    Cflat::Environment env;
 
    const char* code =
-      "static int getInt()\n"
-      "{\n"
-      "  return 42;"
-      "}\n"
-      "static const char* getString()\n"
+      "int callsCount = 0;\n"
+      "int multiply(int pA, int pB)\n"
       "{\n"
-      "  return \"Original string\";\n"
+      "  callsCount++;\n"
+      "  return pA * pB;\n"
       "}\n";
 
    EXPECT_TRUE(env.load("test", code));
 
-   Cflat::Function* intFunctionBeforeReload = env.getFunction("getInt");
-   const int intBeforeReload = env.returnFunctionCall<int>(intFunctionBeforeReload);
-   EXPECT_EQ(intBeforeReload, 42);
+   Cflat::Function* function = env.getFunction("multiply");
+   ASSERT_TRUE(function);
 
-   Cflat::Function* stringFunctionBeforeReload = env.getFunction("getString");
-   const char* stringBeforeReload = env.returnFunctionCall<const char*>(stringFunctionBeforeReload);
-   EXPECT_EQ(strcmp(stringBeforeReload, "Original string"), 0);
+   const int kThreadsCount = 4;
+   const int kCallsPerThread = 100;
 
-   code =
-      "static int getInt()\n"
-      "{\n"
-      "  return 4200;"
-      "}\n"
-      "static const char* getString()\n"
-      "{\n"
-      "  return \"Modified string\";\n"
-      "}\n";
+   std::atomic<int> submittingThreads(kThreadsCount);
+   std::atomic<int> unexpectedResults(0);
 
-   EXPECT_TRUE(env.load("test", code));
+   std::vector<std::thread> threads;
 
-   Cflat::Function* intFunctionAfterReload = env.getFunction("getInt");
-   EXPECT_EQ(intFunctionAfterReload, intFunctionBeforeReload);
-   const int intAfterReload = env.returnFunctionCall<int>(intFunctionAfterReload);
-   EXPECT_EQ(intAfterReload, 4200);
+   for(int i = 0; i < kThreadsCount; i++)
+   {
+      threads.push_back(std::thread([&, i]()
+      {
+         CflatSTLVector(Cflat::CallFuture) futures;
+         CflatSTLVector(int) expectedResults;
+
+         for(int j = 0; j < kCallsPerThread; j++)
+         {
+            const int a = i + 1;
+            const int b = j;
+            futures.push_back(env.queueFunctionCall(function, &a, &b));
+            expectedResults.push_back(a * b);
+         }
+
+         submittingThreads--;
+
+         for(size_t j = 0u; j < futures.size(); j++)
+         {
+            const Cflat::Value& returnValue = futures[j].getReturnValue();
+
+            if(futures[j].getErrorMessage() ||
+               CflatValueAs(&returnValue, int) != expectedResults[j])
+            {
+               unexpectedResults++;
+            }
+         }
+      }));
+   }
 
-   Cflat::Function* stringFunctionAfterReload = env.getFunction("getString");
-   EXPECT_EQ(stringFunctionAfterReload, stringFunctionBeforeReload);
-   const char* stringAfterReload = env.returnFunctionCall<const char*>(stringFunctionAfterReload);
-   EXPECT_EQ(strcmp(stringAfterReload, "Modified string"), 0);
-}
+   size_t processedCallsCount = 0u;
 
-TEST(Cflat, HotReloadDetectsReturnTypeChanges)
+   while(submittingThreads > 0)
+   {
+      processedCallsCount += env.processQueuedCalls();
+   }
+
+   processedCallsCount += env.processQueuedCalls();
+
+   for(size_t i = 0u; i < threads.size(); i++)
+   {
+      threads[i].join();
+   }
+
+   EXPECT_EQ(processedCallsCount, (size_t)(kThreadsCount * kCallsPerThread));
+   EXPECT_EQ(unexpectedResults, 0);
+   EXPECT_EQ(CflatValueAs(env.getVariable("callsCount"), int), kThreadsCount * kCallsPerThread);
+}
+
+TEST(Cflat, QueuedFunctionCallFuturesOutlivingEnvironment)
 {
-   Cflat::Environment env;
+   Cflat::CallFuture processedCallFuture;
+   Cflat::CallFuture discardedCallFuture;
 
-   const char* code =
-      "static int func()\n"
-      "{\n"
-      "  return 42;"
-      "}\n";
+   {
+      Cflat::Environment env;
 
-   EXPECT_TRUE(env.load("test", code));
+      const char* code =
+         "int multiply(int pA, int pB)\n"
+         "{\n"
+         "  return pA * pB;\n"
+         "}\n";
 
-   Cflat::Function* functionBeforeReload = env.getFunction("func");
-   EXPECT_EQ(functionBeforeReload->mReturnTypeUsage.mType->mIdentifier, Cflat::Identifier("int"));
+      EXPECT_TRUE(env.load("test", code));
 
-   code =
-      "static float func()\n"
-      "{\n"
-      "  return 42.0f;"
-      "}\n";
+      Cflat::Function* function = env.getFunction("multiply");
+      ASSERT_TRUE(function);
 
-   EXPECT_TRUE(env.load("test", code));
+      const int a = 6;
+      const int b = 7;
+      processedCallFuture = env.queueFunctionCall(function, &a, &b);
+      EXPECT_EQ(env.processQueuedCalls(), 1u);
 
-   Cflat::Function* functionAfterReload = env.getFunction("func");
-   EXPECT_EQ(functionAfterReload, functionBeforeReload);
-   EXPECT_EQ(functionAfterReload->mReturnTypeUsage.mType->mIdentifier, Cflat::Identifier("float"));
+      discardedCallFuture = env.queueFunctionCall(function, &a, &b);
+   }
+
+   EXPECT_FALSE(processedCallFuture.getErrorMessage());
+   EXPECT_EQ(CflatValueAs(&processedCallFuture.getReturnValue(), int), 42);
+
+   EXPECT_TRUE(discardedCallFuture.isReady());
+   EXPECT_TRUE(discardedCallFuture.getErrorMessage());
 }
 
-TEST(Debugging, ExpressionEvaluation)
+TEST(Cflat, ParallelInvoke)
 {
    Cflat::Environment env;
 
-   struct TestStruct
-   {
-      int var1;
-      int var2;
+   const char* code =
+      "struct Weight\n"
+      "{\n"
+      "  float value;\n"
+      "};\n"
+      "static float weight(int pValue)\n"
+      "{\n"
+      "  Weight result;\n"
+      "  result.value = pValue % 7;\n"
+      "  return result.value * 0.5f;\n"
+      "}\n"
+      "float score(int pCandidate)\n"
+      "{\n"
+      "  float result = 0.0f;\n"
+      "  for(int i = 0; i < 32; i++)\n"
+      "  {\n"
+      "    result += weight(pCandidate + i);\n"
+      "  }\n"
+      "  return result;\n"
+      "}\n";
 
-      int getVar1(int pFactor = 1) { return var1 * pFactor; }
-   };
+   EXPECT_TRUE(env.load("test", code));
 
-   {
-      CflatRegisterStruct(&env, TestStruct);
-      CflatStructAddMember(&env, TestStruct, int, var1);
-      CflatStructAddMember(&env, TestStruct, int, var2);
-      CflatStructAddMethodReturn(&env, TestStruct, int, getVar1);
-      CflatStructAddMethodReturnParams1(&env, TestStruct, int, getVar1, int);
-   }
+   Cflat::Function* function = env.getFunction("score");
+   ASSERT_TRUE(function);
 
-   const char* code =
-      "float testValue = 42.0f;\n"
-      "TestStruct testStruct;\n"
-      "testStruct.var1 = 42;\n"
-      "testStruct.var2 = 100;\n"
-      "int unused = 0;\n";
+   const size_t kCandidatesCount = 1000u;
 
-   env.setExecutionHook([](Cflat::Environment* pEnvironment, const Cflat::CallStack& pCallStack)
+   CflatSTLVector(int) candidates;
+   CflatSTLVector(const void*) args;
+
+   for(size_t i = 0u; i < kCandidatesCount; i++)
    {
-      if(!pCallStack.empty() && pCallStack.back().mLine == 6u)
-      {
-         Cflat::Value testValue;
-         EXPECT_TRUE(pEnvironment->evaluateExpression("testValue", &testValue));
-         EXPECT_FLOAT_EQ(CflatValueAs(&testValue, float), 42.0f);
+      candidates.push_back((int)i);
+   }
 
-         Cflat::Value var1;
-         EXPECT_TRUE(pEnvironment->evaluateExpression("testStruct.var1", &var1));
-         int expressionValue = CflatValueAs(&var1, int);
-         EXPECT_EQ(expressionValue, 42);
+   for(size_t i = 0u; i < kCandidatesCount; i++)
+   {
+      args.push_back(&candidates[i]);
+   }
 
-         Cflat::Value var2;
-         EXPECT_TRUE(pEnvironment->evaluateExpression("testStruct.var2", &var2));
-         expressionValue = CflatValueAs(&var2, int);
-         EXPECT_EQ(expressionValue, 100);
+   CflatSTLVector(float) scores(kCandidatesCount, -1.0f);
+   EXPECT_TRUE(env.parallelInvoke(function, args.data(), kCandidatesCount, scores.data(), 4u));
+   EXPECT_FALSE(env.getErrorMessage());
 
-         Cflat::Value getVar1ReturnValue1;
-         EXPECT_TRUE(pEnvironment->evaluateExpression("testStruct.getVar1()", &getVar1ReturnValue1));
-         expressionValue = CflatValueAs(&getVar1ReturnValue1, int);
-         EXPECT_EQ(expressionValue, 42);
+   size_t unexpectedScoresCount = 0u;
 
-         Cflat::Value getVar1ReturnValue2;
-         EXPECT_TRUE(pEnvironment->evaluateExpression("testStruct.getVar1(2)", &getVar1ReturnValue2));
-         expressionValue = CflatValueAs(&getVar1ReturnValue2, int);
-         EXPECT_EQ(expressionValue, 84);
+   for(size_t i = 0u; i < kCandidatesCount; i++)
+   {
+      if(scores[i] != env.returnFunctionCall<float>(function, &candidates[i]))
+      {
+         unexpectedScoresCount++;
       }
-   });
+   }
 
-   EXPECT_TRUE(env.load("test", code));
+   EXPECT_EQ(unexpectedScoresCount, 0u);
 }
 
-TEST(PreprocessorErrors, InvalidMacroArgumentCount)
+TEST(Cflat, ParallelInvokeRuntimeError)
 {
    Cflat::Environment env;
-   env.defineMacro("ADD(a, b)", "(a + b)");
 
    const char* code =
-      "int var = ADD(42);\n";
+      "int divide(int pValue)\n"
+      "{\n"
+      "  return 100 / (pValue - 7);\n"
+      "}\n";
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Preprocessor Error] 'test' -- Line 1: invalid number of arguments for the 'ADD' macro"), 0);
-}
+   EXPECT_TRUE(env.load("test", code));
 
-TEST(CompileErrors, VoidVariable)
-{
-   Cflat::Environment env;
+   Cflat::Function* function = env.getFunction("divide");
+   ASSERT_TRUE(function);
 
-   const char* code =
-      "void var;\n";
+   int values[16];
+   const void* args[16];
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 1: invalid type ('void')"), 0);
+   for(int i = 0; i < 16; i++)
+   {
+      values[i] = i;
+      args[i] = &values[i];
+   }
+
+   int results[16];
+   EXPECT_FALSE(env.parallelInvoke(function, args, 16u, results, 4u));
+   ASSERT_TRUE(env.getErrorMessage());
+   EXPECT_TRUE(strstr(env.getErrorMessage(), "division by zero"));
+   EXPECT_EQ(results[8], 100);
 }
 
-TEST(CompileErrors, InvalidAssignment)
+TEST(Cflat, ResumableCall)
 {
    Cflat::Environment env;
 
    const char* code =
-      "void func() {}\n"
-      "int var = func();\n";
+      "int generatedCells = 0;\n"
+      "int cell(int pX, int pY)\n"
+      "{\n"
+      "  return (pX * 31 + pY * 17) % 5;\n"
+      "}\n"
+      "int generate(int pSize)\n"
+      "{\n"
+      "  int sum = 0;\n"
+      "  for(int y = 0; y < pSize; y++)\n"
+      "  {\n"
+      "    for(int x = 0; x < pSize; x++)\n"
+      "    {\n"
+      "      sum += cell(x, y);\n"
+      "      generatedCells++;\n"
+      "    }\n"
+      "  }\n"
+      "  return sum;\n"
+      "}\n";
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 2: invalid assignment"), 0);
-}
+   EXPECT_TRUE(env.load("test", code));
 
-TEST(CompileErrors, InvalidNumericValue)
-{
-  Cflat::Environment env;
+   Cflat::Function* function = env.getFunction("generate");
+   ASSERT_TRUE(function);
 
-  const char* code =
-    "const float var = 0f;\n";
+   const int size = 16;
+   const int expectedSum = env.returnFunctionCall<int>(function, &size);
+   CflatValueAs(env.getVariable("generatedCells"), int) = 0;
 
-  EXPECT_FALSE(env.load("test", code));
-  EXPECT_EQ(strcmp(env.getErrorMessage(),
-    "[Compile Error] 'test' -- Line 1: invalid numeric value ('0f')"), 0);
-}
+   Cflat::ResumableCall* call = env.beginResumableCall(function, &size);
+   EXPECT_FALSE(call->isFinished());
+   EXPECT_EQ(CflatValueAs(env.getVariable("generatedCells"), int), 0);
 
-TEST(CompileErrors, ConstModificationAssignment)
-{
-   Cflat::Environment env;
+   const uint64_t kStatementsPerSlice = 50u;
+   int previousGeneratedCells = 0;
+   size_t unexpectedSlicesCount = 0u;
 
-   const char* code =
-      "const int var = 42;\n"
-      "var = 0;\n";
+   while(!env.resumeCall(call, Cflat::ExecutionBudget(kStatementsPerSlice)))
+   {
+      const int generatedCells = CflatValueAs(env.getVariable("generatedCells"), int);
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 2: cannot modify constant expression"), 0);
-}
+      if(generatedCells <= previousGeneratedCells ||
+         call->getStatementsCount() != call->getResumesCount() * kStatementsPerSlice)
+      {
+         unexpectedSlicesCount++;
+      }
 
-TEST(CompileErrors, ConstModificationIncrement)
-{
-   Cflat::Environment env;
+      previousGeneratedCells = generatedCells;
 
-   const char* code =
-      "const int var = 42;\n"
-      "var++;\n";
+      // other calls can be executed while the call is suspended
+      const int x = 3;
+      const int y = 4;
+      EXPECT_EQ(env.returnFunctionCall<int>(env.getFunction("cell"), &x, &y), 1);
+   }
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 2: cannot modify constant expression"), 0);
+   EXPECT_EQ(unexpectedSlicesCount, 0u);
+   EXPECT_GT(call->getResumesCount(), 10u);
+   EXPECT_FALSE(call->getErrorMessage());
+   EXPECT_EQ(CflatValueAs(&call->getReturnValue(), int), expectedSum);
+   EXPECT_EQ(CflatValueAs(env.getVariable("generatedCells"), int), size * size);
+
+   env.releaseResumableCall(call);
 }
 
-TEST(CompileErrors, ConstModificationDecrement)
+TEST(Cflat, ResumableCallRelease)
 {
    Cflat::Environment env;
 
    const char* code =
-      "const int var = 42;\n"
-      "var--;\n";
-
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 2: cannot modify constant expression"), 0);
-}
+      "int ticks = 0;\n"
+      "void spin()\n"
+      "{\n"
+      "  while(true)\n"
+      "  {\n"
+      "    ticks++;\n"
+      "  }\n"
+      "}\n";
 
-TEST(CompileErrors, NonConstMethodCallOnConstInstance)
-{
-   Cflat::Environment env;
+   EXPECT_TRUE(env.load("test", code));
 
-   registerConstPointerTestClass(&env);
+   Cflat::Function* function = env.getFunction("spin");
+   ASSERT_TRUE(function);
 
-   const char* code =
-      "const ConstPointerTestClass testInstance;\n"
-      "testInstance.incrementVal();\n";
+   Cflat::ResumableCall* call = env.beginResumableCall(function);
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 2: cannot call a non-const method on a const instance, reference or pointer"), 0);
-}
+   EXPECT_FALSE(env.resumeCall(call, Cflat::ExecutionBudget(100u)));
+   EXPECT_GT(CflatValueAs(env.getVariable("ticks"), int), 0);
 
-TEST(CompileErrors, NonConstMethodCallOnConstReference)
-{
-   Cflat::Environment env;
+   // 1 ms per slice
+   EXPECT_FALSE(env.resumeCall(call, Cflat::ExecutionBudget(0u, 1000000u)));
+   EXPECT_FALSE(call->isFinished());
 
-   registerConstPointerTestClass(&env);
+   // the program being executed by the call is kept alive until the call gets released
+   EXPECT_TRUE(env.load("test", code));
+   EXPECT_FALSE(env.resumeCall(call, Cflat::ExecutionBudget(100u)));
+   EXPECT_GT(CflatValueAs(env.getVariable("ticks"), int), 0);
 
-   const char* code =
-      "ConstPointerTestClass testInstance;\n"
-      "const ConstPointerTestClass& testInstanceRef = testInstance;\n"
-      "testInstanceRef.incrementVal();\n";
+   // released without finishing, so it gets aborted
+   env.releaseResumableCall(call);
+   EXPECT_FALSE(env.getErrorMessage());
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 3: cannot call a non-const method on a const instance, reference or pointer"), 0);
+   // calls still suspended get released along with the environment
+   Cflat::ResumableCall* otherCall = env.beginResumableCall(function);
+   EXPECT_FALSE(env.resumeCall(otherCall, Cflat::ExecutionBudget(10u)));
 }
 
-TEST(CompileErrors, NonConstMethodCallOnConstPointer)
+TEST(Cflat, ResumableCallStackSize)
 {
    Cflat::Environment env;
 
-   registerConstPointerTestClass(&env);
-
    const char* code =
-      "ConstPointerTestClass testInstance;\n"
-      "const ConstPointerTestClass* testInstancePtr = &testInstance;\n"
-      "testInstancePtr->incrementVal();\n";
+      "int sumTo(int pValue)\n"
+      "{\n"
+      "  return pValue > 0 ? pValue + sumTo(pValue - 1) : 0;\n"
+      "}\n";
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 3: cannot call a non-const method on a const instance, reference or pointer"), 0);
-}
+   EXPECT_TRUE(env.load("test", code));
 
-TEST(CompileErrors, NonConstOverloadedOperatorCallOnConstInstance)
-{
-   Cflat::Environment env;
+   Cflat::Function* function = env.getFunction("sumTo");
+   ASSERT_TRUE(function);
 
-   struct TestStruct
+   const int value = 3;
+   CflatSTLVector(Cflat::ResumableCall*) calls;
+
+   for(size_t i = 0u; i < 64u; i++)
    {
-      int value;
+      calls.push_back(env.beginResumableCall(function, &value));
 
-      TestStruct() : value(0) {}
+      // native stacks of a custom size, plenty for a shallow recursion
+      env.setResumableCallStackSize(calls.back(), 1024u * 128u);
+   }
 
-      bool operator*()
-      {
-         return value > 0;
-      }
-      const TestStruct operator+(int pValue)
-      {
-         TestStruct other = *this;
-         other.value = value + pValue;
-         return other;
-      }
-   };
+   size_t finishedCallsCount = 0u;
 
+   while(finishedCallsCount < calls.size())
    {
-      CflatRegisterStruct(&env, TestStruct);
-      CflatStructAddConstructor(&env, TestStruct);
-      CflatStructAddMember(&env, TestStruct, int, value);
-      CflatStructAddMethodReturn(&env, TestStruct, bool, operator*);
-      CflatStructAddMethodReturnParams1(&env, TestStruct, const TestStruct, operator+, int);
-   }
-
-   const char* code =
-      "const TestStruct testStruct;\n"
-      "const bool isValuePositive = *testStruct;\n";
+      finishedCallsCount = 0u;
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 2: cannot call a non-const method on a const instance, reference or pointer"), 0);
+      for(size_t i = 0u; i < calls.size(); i++)
+      {
+         if(calls[i]->isFinished() || env.resumeCall(calls[i], Cflat::ExecutionBudget(3u)))
+         {
+            finishedCallsCount++;
+         }
+      }
+   }
 
-   code =
-      "const TestStruct testStruct1;\n"
-      "const TestStruct testStruct2 = testStruct1 + 10;\n";
+   for(size_t i = 0u; i < calls.size(); i++)
+   {
+      EXPECT_FALSE(calls[i]->getErrorMessage());
+      EXPECT_GT(calls[i]->getResumesCount(), 1u);
+      EXPECT_EQ(CflatValueAs(&calls[i]->getReturnValue(), int), 6);
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 2: cannot call a non-const method on a const instance, reference or pointer"), 0);
+      env.releaseResumableCall(calls[i]);
+   }
 }
 
-TEST(CompileErrors, MissingDefaultReturnStatementV1)
+TEST(Cflat, Coroutines)
 {
    Cflat::Environment env;
 
    const char* code =
-      "bool func()\n"
+      "int stepsCount = 0;\n"
+      "int countdown(int pFrom)\n"
       "{\n"
+      "  int sum = 0;\n"
+      "  for(int i = pFrom; i > 0; i--)\n"
+      "  {\n"
+      "    sum += i;\n"
+      "    stepsCount++;\n"
+      "    yield();\n"
+      "  }\n"
+      "  return sum;\n"
+      "}\n"
+      "void yieldOutside()\n"
+      "{\n"
+      "  yield();\n"
       "}\n";
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 1: not all code paths return a value in the 'func' function"), 0);
-}
+   EXPECT_TRUE(env.load("test", code));
 
-TEST(CompileErrors, MissingReturnValue)
-{
-   Cflat::Environment env;
+   Cflat::Function* function = env.getFunction("countdown");
+   ASSERT_TRUE(function);
 
-   const char* code =
-      "bool func()\n"
-      "{\n"
-      "  return;\n"
-      "}\n";
+   const size_t kCoroutinesCount = 1000u;
+   const int from = 5;
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 3: missing return expression"), 0);
-}
+   CflatSTLVector(Cflat::Coroutine*) coroutines;
 
-TEST(CompileErrors, IncompatibleReturnExpressionType)
-{
-   Cflat::Environment env;
+   for(size_t i = 0u; i < kCoroutinesCount; i++)
+   {
+      coroutines.push_back(env.beginCoroutine(function, &from));
 
-   const char* code =
-      "void* func()\n"
-      "{\n"
-      "  return 42;\n"
-      "}\n";
+      // half of them on smaller native stacks, which are plenty for such a shallow function
+      if(i % 2u == 0u)
+      {
+         env.setCoroutineStackSize(coroutines.back(), 1024u * 32u);
+      }
+   }
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 3: incompatible return expression type for the 'func' function"), 0);
-}
+   EXPECT_EQ(CflatValueAs(env.getVariable("stepsCount"), int), 0);
 
-TEST(CompileErrors, MissingDefaultReturnStatementV2)
-{
-   Cflat::Environment env;
+   // every resume runs a single step of each coroutine, preserving its locals
+   for(int step = 1; step <= from; step++)
+   {
+      for(size_t i = 0u; i < kCoroutinesCount; i++)
+      {
+         EXPECT_FALSE(env.resumeCoroutine(coroutines[i]));
+      }
 
-   const char* code =
-      "bool func(int arg)\n"
-      "{\n"
-      "  if(arg == 42)\n"
-      "  {\n"
-      "    return true;\n"
-      "  }\n"
-      "}\n";
+      EXPECT_EQ(CflatValueAs(env.getVariable("stepsCount"), int), step * (int)kCoroutinesCount);
+   }
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 1: not all code paths return a value in the 'func' function"), 0);
+   for(size_t i = 0u; i < kCoroutinesCount; i++)
+   {
+      EXPECT_TRUE(env.resumeCoroutine(coroutines[i]));
+      EXPECT_FALSE(coroutines[i]->getErrorMessage());
+      EXPECT_EQ(coroutines[i]->getResumesCount(), (uint32_t)from + 1u);
+      EXPECT_EQ(CflatValueAs(&coroutines[i]->getReturnValue(), int), 15);
+
+      env.releaseCoroutine(coroutines[i]);
+   }
+
+   env.voidFunctionCall(env.getFunction("yieldOutside"));
+   EXPECT_TRUE(env.getErrorMessage());
 }
 
-TEST(CompileErrors, MissingDefaultReturnStatementV3)
+TEST(Cflat, CoroutineRelease)
 {
    Cflat::Environment env;
 
    const char* code =
-      "bool func(int arg)\n"
+      "int ticks = 0;\n"
+      "void tick()\n"
       "{\n"
-      "  if(arg == 42)\n"
-      "  {\n"
-      "  }\n"
-      "  else\n"
+      "  while(true)\n"
       "  {\n"
-      "    return false;\n"
+      "    ticks++;\n"
+      "    yield();\n"
       "  }\n"
       "}\n";
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 1: not all code paths return a value in the 'func' function"), 0);
-}
+   EXPECT_TRUE(env.load("test", code));
 
-TEST(CompileErrors, MissingDefaultReturnStatementV4)
-{
-   Cflat::Environment env;
+   Cflat::Function* function = env.getFunction("tick");
+   ASSERT_TRUE(function);
 
-   const char* code =
-      "bool func(int arg)\n"
-      "{\n"
-      "  switch(arg)\n"
-      "  {\n"
-      "  case 0:\n"
-      "     return true;\n"
-      "  case 1:\n"
-      "     return true;\n"
-      "  case 2:\n"
-      "     return true;\n"
-      "  }\n"
-      "}\n";
+   Cflat::Coroutine* coroutine = env.beginCoroutine(function);
+   EXPECT_FALSE(env.resumeCoroutine(coroutine));
+   EXPECT_FALSE(env.resumeCoroutine(coroutine));
+   EXPECT_EQ(CflatValueAs(env.getVariable("ticks"), int), 2);
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 1: not all code paths return a value in the 'func' function"), 0);
+   // the program being executed by the coroutine is kept alive until it gets released
+   EXPECT_TRUE(env.load("test", code));
+   EXPECT_FALSE(env.resumeCoroutine(coroutine));
+   EXPECT_FALSE(coroutine->isFinished());
+
+   // released without finishing, so it gets aborted
+   env.releaseCoroutine(coroutine);
+   EXPECT_FALSE(env.getErrorMessage());
+
+   // coroutines never resumed and coroutines still suspended get released along with the environment
+   env.beginCoroutine(function);
+   Cflat::Coroutine* otherCoroutine = env.beginCoroutine(function);
+   EXPECT_FALSE(env.resumeCoroutine(otherCoroutine));
 }
 
-TEST(CompileErrors, InvalidEscapeSequence)
+TEST(Cflat, LoadMany)
 {
    Cflat::Environment env;
 
-   const char* code =
-      "const char* str = \"String with the invalid sequence \\a\";\n";
+   const size_t kProgramsCount = 32u;
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 1: invalid escape sequence ('a')"), 0);
-}
+   CflatSTLVector(std::string) programNames;
+   CflatSTLVector(std::string) codes;
 
-TEST(CompileErrors, InvalidVariableIdentifier)
-{
-   Cflat::Environment env;
+   programNames.push_back("base");
+   codes.push_back("int accumulator = 0;\n");
 
-   const char* code = "int 1234 = 0;\n";
+   for(size_t i = 1u; i < kProgramsCount; i++)
+   {
+      char code[128];
+      snprintf(code, sizeof(code), "accumulator = accumulator * 2 + %d;\n", (int)(i % 2u));
 
-   EXPECT_FALSE(env.load("test", code));
-}
+      programNames.push_back("program" + std::to_string(i));
+      codes.push_back(code);
+   }
 
-TEST(CompileErrors, InvalidFunctionIdentifier)
-{
-   Cflat::Environment env;
+   programNames.push_back("invalid");
+   codes.push_back("int var = undefinedVar;\n");
 
-   const char* code = "void 1234(){};\n";
+   CflatSTLVector(const char*) programNamePointers;
+   CflatSTLVector(const char*) codePointers;
 
-   EXPECT_FALSE(env.load("test", code));
+   for(size_t i = 0u; i < codes.size(); i++)
+   {
+      programNamePointers.push_back(programNames[i].c_str());
+      codePointers.push_back(codes[i].c_str());
+   }
+
+   CflatSTLVector(CflatSTLString) errorMessages;
+   EXPECT_FALSE(env.loadMany(programNamePointers.data(), codePointers.data(), codes.size(),
+      &errorMessages));
+
+   ASSERT_EQ(errorMessages.size(), codes.size());
+
+   for(size_t i = 0u; i < kProgramsCount; i++)
+   {
+      EXPECT_TRUE(errorMessages[i].empty());
+   }
+
+   EXPECT_FALSE(errorMessages.back().empty());
+   EXPECT_TRUE(env.getErrorMessage());
+
+   // programs are executed in the given order regardless of which worker prepared them
+   int expectedValue = 0;
+
+   for(size_t i = 1u; i < kProgramsCount; i++)
+   {
+      expectedValue = expectedValue * 2 + (int)(i % 2u);
+   }
+
+   EXPECT_EQ(CflatValueAs(env.getVariable("accumulator"), int), expectedValue);
 }
 
-TEST(CompileErrors, VariableRedefinition)
+TEST(Cflat, HotReload)
 {
    Cflat::Environment env;
 
    const char* code =
-      "void func()\n"
+      "static int getInt()\n"
       "{\n"
-      "  int var = 0;\n"
-      "  float var = 0.0f;\n"
+      "  return 42;"
+      "}\n"
+      "static const char* getString()\n"
+      "{\n"
+      "  return \"Original string\";\n"
       "}\n";
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 4: variable redefinition ('var')"), 0);
-}
+   EXPECT_TRUE(env.load("test", code));
 
-TEST(CompileErrors, ParameterVariableRedefinition)
-{
-   Cflat::Environment env;
+   Cflat::Function* intFunctionBeforeReload = env.getFunction("getInt");
+   const int intBeforeReload = env.returnFunctionCall<int>(intFunctionBeforeReload);
+   EXPECT_EQ(intBeforeReload, 42);
 
-   const char* code =
-      "void func(int var)\n"
+   Cflat::Function* stringFunctionBeforeReload = env.getFunction("getString");
+   const char* stringBeforeReload = env.returnFunctionCall<const char*>(stringFunctionBeforeReload);
+   EXPECT_EQ(strcmp(stringBeforeReload, "Original string"), 0);
+
+   code =
+      "static int getInt()\n"
       "{\n"
-      "  int var = 0;\n"
+      "  return 4200;"
+      "}\n"
+      "static const char* getString()\n"
+      "{\n"
+      "  return \"Modified string\";\n"
       "}\n";
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 3: variable redefinition ('var')"), 0);
+   EXPECT_TRUE(env.load("test", code));
+
+   Cflat::Function* intFunctionAfterReload = env.getFunction("getInt");
+   EXPECT_EQ(intFunctionAfterReload, intFunctionBeforeReload);
+   const int intAfterReload = env.returnFunctionCall<int>(intFunctionAfterReload);
+   EXPECT_EQ(intAfterReload, 4200);
+
+   Cflat::Function* stringFunctionAfterReload = env.getFunction("getString");
+   EXPECT_EQ(stringFunctionAfterReload, stringFunctionBeforeReload);
+   const char* stringAfterReload = env.returnFunctionCall<const char*>(stringFunctionAfterReload);
+   EXPECT_EQ(strcmp(stringAfterReload, "Modified string"), 0);
 }
 
-TEST(CompileErrors, ParameterRedefinition)
+TEST(Cflat, IncrementalHotReload)
 {
    Cflat::Environment env;
+   env.addSetting(Cflat::Environment::Settings::IncrementalReload);
 
    const char* code =
-      "void func(int param, float param)\n"
+      "struct Counter\n"
+      "{\n"
+      "  int value;\n"
+      "};\n"
+      "int counter = 0;\n"
+      "namespace Test\n"
+      "{\n"
+      "  int getStep() { return 1; }\n"
+      "}\n"
+      "int increment()\n"
       "{\n"
+      "  Counter step;\n"
+      "  step.value = Test::getStep();\n"
+      "  counter += step.value;\n"
+      "  return counter;\n"
       "}\n";
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 1: parameter redefinition ('param')"), 0);
-}
+   EXPECT_TRUE(env.load("test", code));
 
-TEST(CompileErrors, VoidFunctionReturningValue)
-{
-   Cflat::Environment env;
+   Cflat::Function* increment = env.getFunction("increment");
+   ASSERT_TRUE(increment);
+   EXPECT_EQ(env.returnFunctionCall<int>(increment), 1);
+   EXPECT_EQ(env.returnFunctionCall<int>(increment), 2);
 
-   const char* code =
-      "void func()\n"
+   const Cflat::Statement* incrementDeclaration = env.getProgram("test")->mStatements.back();
+   EXPECT_EQ(increment->mLine, 10u);
+
+   // only a function body changes: the global variable keeps its value, and the declaration
+   // of the unchanged function is kept, just moved one line down
+   code =
+      "struct Counter\n"
       "{\n"
-      "  return 0;\n"
+      "  int value;\n"
+      "};\n"
+      "int counter = 0;\n"
+      "namespace Test\n"
+      "{\n"
+      "  int getStep()\n"
+      "  { return 10; }\n"
+      "}\n"
+      "int increment()\n"
+      "{\n"
+      "  Counter step;\n"
+      "  step.value = Test::getStep();\n"
+      "  counter += step.value;\n"
+      "  return counter;\n"
       "}\n";
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 3: void function returning a value"), 0);
-}
-
-TEST(CompileErrors, NoImplicitCastFromEnumClassToInteger)
-{
-   Cflat::Environment env;
+   EXPECT_TRUE(env.load("test", code));
 
-   enum class TestEnumClass : uint8_t
-   {
-      kValue
-   };
+   EXPECT_EQ(env.getFunction("increment"), increment);
+   EXPECT_EQ(env.getProgram("test")->mStatements.back(), incrementDeclaration);
+   EXPECT_EQ(increment->mLine, 11u);
+   EXPECT_EQ(env.returnFunctionCall<int>(increment), 12);
 
-   {
-      CflatRegisterEnumClass(&env, TestEnumClass);
-      CflatEnumAddValue(&env, TestEnumClass, kValue);
-   }
+   // the outline changes: the program gets fully reloaded
+   code =
+      "struct Counter\n"
+      "{\n"
+      "  int value;\n"
+      "};\n"
+      "int counter = 0;\n"
+      "int getStep() { return 100; }\n"
+      "int increment()\n"
+      "{\n"
+      "  Counter step;\n"
+      "  step.value = getStep();\n"
+      "  counter += step.value;\n"
+      "  return counter;\n"
+      "}\n";
 
-   const char* code =
-      "int var = TestEnumClass::kValue;";
+   EXPECT_TRUE(env.load("test", code));
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 1: invalid assignment"), 0);
+   increment = env.getFunction("increment");
+   ASSERT_TRUE(increment);
+   EXPECT_EQ(env.returnFunctionCall<int>(increment), 100);
 }
 
-TEST(CompileErrors, NoImplicitCastFromIntegerToEnumClass)
+TEST(Cflat, IncrementalReloadParsedWithSharedAccess)
 {
    Cflat::Environment env;
-
-   enum class TestEnumClass : uint8_t
-   {
-      kValue
-   };
-
-   {
-      CflatRegisterEnumClass(&env, TestEnumClass);
-      CflatEnumAddValue(&env, TestEnumClass, kValue);
-   }
+   env.addSetting(Cflat::Environment::Settings::IncrementalReload);
 
    const char* code =
-      "TestEnumClass var = 0;";
+      "typedef int Score;\n"
+      "static const int kBonus = 5;\n"
+      "namespace Game\n"
+      "{\n"
+      "  Score total = 0;\n"
+      "  Score addPoints(int pPoints)\n"
+      "  {\n"
+      "    total += pPoints;\n"
+      "    return total;\n"
+      "  }\n"
+      "}\n"
+      "const char* getLabel() { return \"before\"; }\n";
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 1: invalid assignment"), 0);
-}
+   EXPECT_TRUE(env.load("test", code));
 
-TEST(Cflat, NoImplicitCastFromConstRefToRefInVariableDeclaration)
-{
-   Cflat::Environment env;
+   Cflat::Function* addPoints = env.getFunction("Game::addPoints");
+   ASSERT_TRUE(addPoints);
+   int points = 1;
+   EXPECT_EQ(env.returnFunctionCall<int>(addPoints, &points), 1);
 
-   const char* code =
-      "struct TestStruct\n"
+   // only function bodies change, so the environment does not get altered while parsing
+   code =
+      "typedef int Score;\n"
+      "static const int kBonus = 5;\n"
+      "namespace Game\n"
       "{\n"
-      "  int member;\n"
-      "};\n"
-      "TestStruct testStruct;\n"
-      "testStruct.member = 42;\n"
-      "const TestStruct& testStructRef = testStruct;\n"
-      "TestStruct& testStructNonConstRef = testStructRef;\n";
+      "  Score total = 0;\n"
+      "  Score addPoints(int pPoints)\n"
+      "  {\n"
+      "    int steps[2];\n"
+      "    steps[0] = pPoints;\n"
+      "    steps[1] = kBonus;\n"
+      "    total += steps[0] + steps[1];\n"
+      "    return total;\n"
+      "  }\n"
+      "}\n"
+      "const char* getLabel() { return \"after\"; }\n";
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 8: invalid assignment"), 0);
+   EXPECT_TRUE(env.load("test", code));
+
+   EXPECT_EQ(env.getFunction("Game::addPoints"), addPoints);
+   EXPECT_EQ(env.returnFunctionCall<int>(addPoints, &points), 7);
+   const char* label = env.returnFunctionCall<const char*>(env.getFunction("getLabel"));
+   EXPECT_EQ(strcmp(label, "after"), 0);
+
+   // the local struct has to be registered, so the program gets parsed with write access
+   code =
+      "typedef int Score;\n"
+      "static const int kBonus = 5;\n"
+      "namespace Game\n"
+      "{\n"
+      "  Score total = 0;\n"
+      "  Score addPoints(int pPoints)\n"
+      "  {\n"
+      "    struct Step { int value; };\n"
+      "    Step step;\n"
+      "    step.value = pPoints * 10;\n"
+      "    total += step.value;\n"
+      "    return total;\n"
+      "  }\n"
+      "}\n"
+      "const char* getLabel() { return \"after\"; }\n";
+
+   EXPECT_TRUE(env.load("test", code));
+
+   EXPECT_EQ(env.getFunction("Game::addPoints"), addPoints);
+   EXPECT_EQ(env.returnFunctionCall<int>(addPoints, &points), 17);
 }
 
-TEST(Cflat, NoImplicitCastFromConstRefToRefInFunctionCall)
+TEST(Cflat, LazyFunctionBodies)
 {
    Cflat::Environment env;
+   env.addSetting(Cflat::Environment::Settings::LazyFunctionBodies);
 
    const char* code =
-      "struct TestStruct\n"
+      "namespace Math\n"
       "{\n"
-      "  int member;\n"
-      "};\n"
-      "void modifyTestStruct(TestStruct& pTestStruct)\n"
+      "  int square(int pValue)\n"
+      "  {\n"
+      "    return pValue * pValue;\n"
+      "  }\n"
+      "}\n"
+      "using namespace Math;\n"
+      "int sumOfSquares(int pA, int pB)\n"
       "{\n"
-      "  pTestStruct.member = 100;\n"
+      "  return square(pA) + square(pB);\n"
       "}\n"
-      "TestStruct testStruct;\n"
-      "testStruct.member = 42;\n"
-      "const TestStruct& testStructRef = testStruct;\n"
-      "modifyTestStruct(testStructRef);\n";
+      "int broken()\n"
+      "{\n"
+      "  return undefinedVariable;\n"
+      "}\n";
+
+   // the bodies are not parsed until the functions get called
+   EXPECT_TRUE(env.load("test", code));
+   EXPECT_EQ(env.getProgram("test")->mDeferredFunctionBodiesCount, 3u);
 
+   Cflat::Function* sumOfSquares = env.getFunction("sumOfSquares");
+   const int a = 3;
+   const int b = 4;
+   EXPECT_EQ(env.returnFunctionCall<int>(sumOfSquares, &a, &b), 25);
+   EXPECT_FALSE(env.getErrorMessage());
+   EXPECT_EQ(env.getProgram("test")->mDeferredFunctionBodiesCount, 1u);
+
+   const char* expectedErrorMessage =
+      "[Compile Error] 'test' -- Line 15: undefined variable ('undefinedVariable')";
+
+   Cflat::Function* broken = env.getFunction("broken");
+   env.returnFunctionCall<int>(broken);
+   ASSERT_TRUE(env.getErrorMessage());
+   EXPECT_EQ(strcmp(env.getErrorMessage(), expectedErrorMessage), 0);
+
+   // the validation reports the same error as loading without the setting
+   EXPECT_FALSE(env.parseDeferredFunctionBodies("test"));
+   ASSERT_TRUE(env.getErrorMessage());
+   EXPECT_EQ(strcmp(env.getErrorMessage(), expectedErrorMessage), 0);
+
+   env.removeSetting(Cflat::Environment::Settings::LazyFunctionBodies);
    EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Compile Error] 'test' -- Line 12: undefined function ('modifyTestStruct') or invalid arguments in call"), 0);
+   ASSERT_TRUE(env.getErrorMessage());
+   EXPECT_EQ(strcmp(env.getErrorMessage(), expectedErrorMessage), 0);
 }
 
-TEST(RuntimeErrors, NullPointerAccess)
+TEST(Cflat, LazyFunctionBodiesWhileReadingFromAnotherThread)
 {
    Cflat::Environment env;
-
-   Cflat::Helper::registerStdString(&env);
+   env.addSetting(Cflat::Environment::Settings::LazyFunctionBodies);
 
    const char* code =
-      "std::string* strPtr = nullptr;\n"
-      "strPtr->assign(\"Hello world!\");\n";
+      "static const int kCellsCount = 4;\n"
+      "int cell(int pIndex)\n"
+      "{\n"
+      "  return pIndex * 2;\n"
+      "}\n"
+      "int sumOfCells()\n"
+      "{\n"
+      "  int sum = 0;\n"
+      "  for(int i = 0; i < kCellsCount; i++)\n"
+      "  {\n"
+      "    sum += cell(i);\n"
+      "  }\n"
+      "  return sum;\n"
+      "}\n"
+      "int sumOfSteps()\n"
+      "{\n"
+      "  struct Step { int value; };\n"
+      "  Step step;\n"
+      "  step.value = 0;\n"
+      "  for(int i = 0; i < kCellsCount; i++)\n"
+      "  {\n"
+      "    step.value += i;\n"
+      "  }\n"
+      "  return step.value;\n"
+      "}\n"
+      "int lastValue()\n"
+      "{\n"
+      "  int values[kCellsCount];\n"
+      "  values[kCellsCount - 1] = 42;\n"
+      "  return values[kCellsCount - 1];\n"
+      "}\n"
+      "int unused()\n"
+      "{\n"
+      "  return 0;\n"
+      "}\n";
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Runtime Error] 'test' -- Line 2: null pointer access ('assign')"), 0);
+   EXPECT_TRUE(env.load("test", code));
+
+   // the bodies with the local struct and with the evaluated array size would register them in
+   // the environment, so they do not get deferred
+   EXPECT_EQ(env.getProgram("test")->mDeferredFunctionBodiesCount, 3u);
+
+   std::atomic<bool> calling(true);
+   std::atomic<int> unexpectedResults(0);
+
+   std::thread reader([&]()
+   {
+      while(calling)
+      {
+         if(!env.getFunction("sumOfCells") || env.getType("Step") || !env.getType("int"))
+         {
+            unexpectedResults++;
+         }
+      }
+   });
+
+   EXPECT_EQ(env.returnFunctionCall<int>(env.getFunction("sumOfCells")), 12);
+   EXPECT_EQ(env.returnFunctionCall<int>(env.getFunction("sumOfSteps")), 6);
+   EXPECT_EQ(env.returnFunctionCall<int>(env.getFunction("lastValue")), 42);
+
+   calling = false;
+   reader.join();
+
+   EXPECT_FALSE(env.getErrorMessage());
+   EXPECT_EQ(unexpectedResults, 0);
+   EXPECT_EQ(env.getProgram("test")->mDeferredFunctionBodiesCount, 1u);
+
+   // calls resumed on native stacks only get the bodies they call parsed
+   EXPECT_TRUE(env.load("test", code));
+   EXPECT_EQ(env.getProgram("test")->mDeferredFunctionBodiesCount, 3u);
+
+   Cflat::ResumableCall* call = env.beginResumableCall(env.getFunction("sumOfCells"));
+
+   while(!env.resumeCall(call, Cflat::ExecutionBudget(5u)))
+   {
+   }
+
+   EXPECT_FALSE(call->getErrorMessage());
+   EXPECT_EQ(CflatValueAs(&call->getReturnValue(), int), 12);
+   EXPECT_EQ(env.getProgram("test")->mDeferredFunctionBodiesCount, 1u);
+
+   env.releaseResumableCall(call);
 }
 
-TEST(RuntimeErrors, InvalidArrayIndexOnAccess)
+TEST(Cflat, HotReloadWhileCallingFromAnotherThread)
+{
+   Cflat::Environment env;
+
+   const char* codeVersions[] =
+   {
+      "int getValue(int pValue)\n"
+      "{\n"
+      "  return pValue;\n"
+      "}\n",
+      "int getValue(int pValue)\n"
+      "{\n"
+      "  int result = pValue * 100;\n"
+      "  return result;\n"
+      "}\n"
+   };
+
+   EXPECT_TRUE(env.load("test", codeVersions[0]));
+
+   Cflat::Function* function = env.getFunction("getValue");
+   ASSERT_TRUE(function);
+
+   std::atomic<bool> reloading(true);
+   std::atomic<int> unexpectedResults(0);
+
+   std::thread caller([&]()
+   {
+      while(reloading)
+      {
+         int arg = 42;
+         const int result = env.returnFunctionCall<int>(function, &arg);
+
+         if(result != 42 && result != 4200)
+         {
+            unexpectedResults++;
+         }
+      }
+   });
+
+   for(int i = 0; i < 100; i++)
+   {
+      EXPECT_TRUE(env.load("test", codeVersions[i % 2]));
+   }
+
+   reloading = false;
+   caller.join();
+
+   EXPECT_EQ(unexpectedResults, 0);
+   EXPECT_EQ(env.getFunction("getValue"), function);
+}
+
+TEST(Cflat, HotReloadDetectsReturnTypeChanges)
 {
    Cflat::Environment env;
 
    const char* code =
-      "int array[] = { 0, 1, 2 };\n"
-      "int arrayIndex = 42;\n"
-      "int var = array[arrayIndex];\n";
+      "static int func()\n"
+      "{\n"
+      "  return 42;"
+      "}\n";
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Runtime Error] 'test' -- Line 3: invalid array index (size 3, index 42)"), 0);
+   EXPECT_TRUE(env.load("test", code));
+
+   Cflat::Function* functionBeforeReload = env.getFunction("func");
+   EXPECT_EQ(functionBeforeReload->mReturnTypeUsage.mType->mIdentifier, Cflat::Identifier("int"));
+
+   code =
+      "static float func()\n"
+      "{\n"
+      "  return 42.0f;"
+      "}\n";
+
+   EXPECT_TRUE(env.load("test", code));
+
+   Cflat::Function* functionAfterReload = env.getFunction("func");
+   EXPECT_EQ(functionAfterReload, functionBeforeReload);
+   EXPECT_EQ(functionAfterReload->mReturnTypeUsage.mType->mIdentifier, Cflat::Identifier("float"));
 }
 
-TEST(RuntimeErrors, InvalidArrayIndexOnAssignment)
+TEST(Debugging, ExpressionEvaluation)
 {
    Cflat::Environment env;
 
+   struct TestStruct
+   {
+      int var1;
+      int var2;
+
+      int getVar1(int pFactor = 1) { return var1 * pFactor; }
+   };
+
+   {
+      CflatRegisterStruct(&env, TestStruct);
+      CflatStructAddMember(&env, TestStruct, int, var1);
+      CflatStructAddMember(&env, TestStruct, int, var2);
+      CflatStructAddMethodReturn(&env, TestStruct, int, getVar1);
+      CflatStructAddMethodReturnParams1(&env, TestStruct, int, getVar1, int);
+   }
+
    const char* code =
-      "int array[] = { 0, 1, 2 };\n"
-      "array[42] = 0;\n";
+      "float testValue = 42.0f;\n"
+      "TestStruct testStruct;\n"
+      "testStruct.var1 = 42;\n"
+      "testStruct.var2 = 100;\n"
+      "int unused = 0;\n";
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Runtime Error] 'test' -- Line 2: invalid array index (size 3, index 42)"), 0);
+   env.setExecutionHook([](Cflat::Environment* pEnvironment, const Cflat::CallStack& pCallStack)
+   {
+      if(!pCallStack.empty() && pCallStack.back().mLine == 6u)
+      {
+         Cflat::Value testValue;
+         EXPECT_TRUE(pEnvironment->evaluateExpression("testValue", &testValue));
+         EXPECT_FLOAT_EQ(CflatValueAs(&testValue, float), 42.0f);
+
+         Cflat::Value var1;
+         EXPECT_TRUE(pEnvironment->evaluateExpression("testStruct.var1", &var1));
+         int expressionValue = CflatValueAs(&var1, int);
+         EXPECT_EQ(expressionValue, 42);
+
+         Cflat::Value var2;
+         EXPECT_TRUE(pEnvironment->evaluateExpression("testStruct.var2", &var2));
+         expressionValue = CflatValueAs(&var2, int);
+         EXPECT_EQ(expressionValue, 100);
+
+         Cflat::Value getVar1ReturnValue1;
+         EXPECT_TRUE(pEnvironment->evaluateExpression("testStruct.getVar1()", &getVar1ReturnValue1));
+         expressionValue = CflatValueAs(&getVar1ReturnValue1, int);
+         EXPECT_EQ(expressionValue, 42);
+
+         Cflat::Value getVar1ReturnValue2;
+         EXPECT_TRUE(pEnvironment->evaluateExpression("testStruct.getVar1(2)", &getVar1ReturnValue2));
+         expressionValue = CflatValueAs(&getVar1ReturnValue2, int);
+         EXPECT_EQ(expressionValue, 84);
+      }
+   });
+
+   EXPECT_TRUE(env.load("test", code));
 }
 
-TEST(RuntimeErrors, DivisionByZero)
+TEST(Debugging, ExpressionEvaluationInDifferentScopes)
 {
    Cflat::Environment env;
 
    const char* code =
-      "int val = 10 / 0;\n";
+      "void intScope(int pValue)\n"
+      "{\n"
+      "  int value = pValue;\n"
+      "  value++;\n"
+      "}\n"
+      "void floatScope()\n"
+      "{\n"
+      "  float value = 1.5f;\n"
+      "  value += 1.0f;\n"
+      "}\n"
+      "intScope(21);\n"
+      "floatScope();\n"
+      "intScope(50);\n";
 
-   EXPECT_FALSE(env.load("test", code));
-   EXPECT_EQ(strcmp(env.getErrorMessage(),
-      "[Runtime Error] 'test' -- Line 1: division by zero"), 0);
+   static int evaluationsCount;
+   evaluationsCount = 0;
+
+   env.setExecutionHook([](Cflat::Environment* pEnvironment, const Cflat::CallStack& pCallStack)
+   {
+      if(pCallStack.empty())
+      {
+         return;
+      }
+
+      // the same expression, evaluated again with other values or other types in scope
+      Cflat::Value value;
+
+      if(pCallStack.back().mLine == 4u)
+      {
+         EXPECT_TRUE(pEnvironment->evaluateExpression("value * 2", &value));
+         EXPECT_EQ(value.mTypeUsage.mType->mIdentifier, Cflat::Identifier("int"));
+         EXPECT_EQ(CflatValueAs(&value, int), evaluationsCount == 0 ? 42 : 100);
+         evaluationsCount++;
+      }
+      else if(pCallStack.back().mLine == 9u)
+      {
+         EXPECT_TRUE(pEnvironment->evaluateExpression("value * 2", &value));
+         EXPECT_EQ(value.mTypeUsage.mType->mIdentifier, Cflat::Identifier("float"));
+         EXPECT_FLOAT_EQ(CflatValueAs(&value, float), 3.0f);
+         evaluationsCount++;
+
+         EXPECT_FALSE(pEnvironment->evaluateExpression("pValue * 2", &value));
+      }
+   });
+
+   EXPECT_TRUE(env.load("test", code));
+   EXPECT_EQ(evaluationsCount, 3);
+}
+
+static int answer()
+{
+   return 42;
+}
+
+TEST(Debugging, ExpressionEvaluationAfterRegistration)
+{
+   Cflat::Environment env;
+   Cflat::Value value;
+
+   // an expression which does not compile yet, because of a function registered later on
+   EXPECT_FALSE(env.evaluateExpression("answer()", &value));
+
+   {
+      CflatRegisterFunctionReturn(&env, int, answer);
+   }
+
+   EXPECT_TRUE(env.evaluateExpression("answer()", &value));
+   EXPECT_EQ(CflatValueAs(&value, int), 42);
+}
+
+TEST(Debugging, Profiling)
+{
+   Cflat::Environment env;
+
+   struct TestStruct
+   {
+      int var;
+
+      int getVar() { return var; }
+   };
+
+   {
+      CflatRegisterStruct(&env, TestStruct);
+      CflatStructAddMember(&env, TestStruct, int, var);
+      CflatStructAddMethodReturn(&env, TestStruct, int, getVar);
+   }
+   {
+      CflatRegisterFunctionReturnParams1(&env, int, abs, int);
+   }
+
+   const char* code =
+      "int square(int pValue)\n"
+      "{\n"
+      "  return abs(pValue) * abs(pValue);\n"
+      "}\n"
+      "int sumOfSquares(int pCount)\n"
+      "{\n"
+      "  int sum = 0;\n"
+      "  for(int i = 0; i < pCount; i++) { sum += square(i); }\n"
+      "  return sum;\n"
+      "}\n"
+      "int factorial(int pValue)\n"
+      "{\n"
+      "  if(pValue <= 1) { return 1; }\n"
+      "  return pValue * factorial(pValue - 1);\n"
+      "}\n"
+      "void run()\n"
+      "{\n"
+      "  TestStruct testStruct;\n"
+      "  testStruct.var = sumOfSquares(10) + factorial(5);\n"
+      "  testStruct.getVar();\n"
+      "}\n";
+
+   EXPECT_TRUE(env.load("test", code));
+   EXPECT_FALSE(env.isProfilingEnabled());
+
+   env.setProfilingEnabled(true);
+   EXPECT_TRUE(env.isProfilingEnabled());
+   env.voidFunctionCall(env.getFunction("run"));
+   env.setProfilingEnabled(false);
+
+   // not recorded
+   env.voidFunctionCall(env.getFunction("run"));
+
+   Cflat::Environment::ProfileStats stats;
+   env.getProfileStats(&stats);
+   EXPECT_EQ(stats.mFunctions.size(), 5u);
+
+   std::map<std::string, const Cflat::Environment::ProfileStats::FunctionEntry*> entries;
+
+   for(size_t i = 0u; i < stats.mFunctions.size(); i++)
+   {
+      entries[stats.mFunctions[i].mName.mName] = &stats.mFunctions[i];
+      EXPECT_LE(stats.mFunctions[i].mExclusiveTime, stats.mFunctions[i].mInclusiveTime);
+   }
+
+   ASSERT_EQ(entries.count("sumOfSquares"), 1u);
+   ASSERT_EQ(entries.count("square"), 1u);
+   ASSERT_EQ(entries.count("abs"), 1u);
+   ASSERT_EQ(entries.count("factorial"), 1u);
+   ASSERT_EQ(entries.count("TestStruct::getVar"), 1u);
+
+   EXPECT_EQ(entries["sumOfSquares"]->mCallsCount, 1u);
+   EXPECT_EQ(entries["square"]->mCallsCount, 10u);
+   EXPECT_EQ(entries["abs"]->mCallsCount, 20u);
+   EXPECT_EQ(entries["factorial"]->mCallsCount, 5u);
+   EXPECT_EQ(entries["TestStruct::getVar"]->mCallsCount, 1u);
+
+   EXPECT_GE(entries["sumOfSquares"]->mInclusiveTime, entries["square"]->mInclusiveTime);
+   EXPECT_GE(entries["square"]->mInclusiveTime, entries["abs"]->mInclusiveTime);
+
+   CflatSTLString foldedStacks;
+   env.exportProfileFoldedStacks(&foldedStacks);
+   EXPECT_NE(foldedStacks.find("sumOfSquares;square;abs "), std::string::npos);
+   EXPECT_NE(foldedStacks.find("factorial;factorial;factorial;factorial;factorial "),
+      std::string::npos);
+
+   CflatSTLString trace;
+   env.exportProfileTrace(&trace);
+   EXPECT_EQ(trace.compare(0u, 15u, "{\"traceEvents\":"), 0);
+
+   size_t squareEventsCount = 0u;
+
+   for(size_t position = trace.find("\"name\":\"square\""); position != std::string::npos;
+      position = trace.find("\"name\":\"square\"", position + 1u))
+   {
+      squareEventsCount++;
+   }
+
+   EXPECT_EQ(squareEventsCount, 10u);
+
+   env.resetProfile();
+   env.getProfileStats(&stats);
+   EXPECT_TRUE(stats.mFunctions.empty());
+}
+
+TEST(Debugging, LineCounters)
+{
+   Cflat::Environment env;
+   env.setLineCountingEnabled(true);
+   EXPECT_TRUE(env.isLineCountingEnabled());
+
+   const char* code =
+      "int square(int pValue)\n"
+      "{\n"
+      "  return pValue * pValue;\n"
+      "}\n"
+      "int unused(int pValue)\n"
+      "{\n"
+      "  return pValue + 1;\n"
+      "}\n"
+      "int sum = 0;\n"
+      "void run()\n"
+      "{\n"
+      "  for(int i = 0; i < 10; i++)\n"
+      "  {\n"
+      "    sum += square(i);\n"
+      "  }\n"
+      "}\n";
+
+   EXPECT_TRUE(env.load("test", code));
+   env.voidFunctionCall(env.getFunction("run"));
+
+   Cflat::Environment::LinesReport report;
+   env.getLinesReport(&report, 100u);
+   ASSERT_EQ(report.mPrograms.size(), 1u);
+
+   const Cflat::Environment::LinesReport::ProgramEntry& programEntry = report.mPrograms[0];
+   EXPECT_EQ(programEntry.mProgram->mIdentifier, Cflat::Identifier("test"));
+   EXPECT_LT(programEntry.mExecutedLinesCount, programEntry.mExecutableLinesCount);
+   EXPECT_EQ(programEntry.mHottestLines.size(), (size_t)programEntry.mExecutedLinesCount);
+
+   ASSERT_EQ(programEntry.mUncoveredLines.size(), 1u);
+   EXPECT_EQ(programEntry.mUncoveredLines[0], 7u);
+
+   std::map<uint32_t, uint32_t> executionsCounts;
+
+   for(size_t i = 0u; i < programEntry.mHottestLines.size(); i++)
+   {
+      executionsCounts[programEntry.mHottestLines[i].mLine] = programEntry.mHottestLines[i].mExecutionsCount;
+
+      if(i > 0u)
+      {
+         EXPECT_GE(programEntry.mHottestLines[i - 1u].mTime, programEntry.mHottestLines[i].mTime);
+      }
+   }
+
+   EXPECT_EQ(executionsCounts[3], 10u);
+   EXPECT_EQ(executionsCounts[9], 1u);
+   // the loop and its initialization
+   EXPECT_EQ(executionsCounts[12], 2u);
+   EXPECT_EQ(executionsCounts[14], 10u);
+   EXPECT_EQ(executionsCounts.count(7), 0u);
+
+   env.getLinesReport(&report, 2u);
+   ASSERT_EQ(report.mPrograms.size(), 1u);
+   EXPECT_EQ(report.mPrograms[0].mHottestLines.size(), 2u);
+
+   env.resetLineCounters();
+   env.setLineCountingEnabled(false);
+   env.voidFunctionCall(env.getFunction("run"));
+
+   env.getLinesReport(&report);
+   ASSERT_EQ(report.mPrograms.size(), 1u);
+   EXPECT_EQ(report.mPrograms[0].mExecutedLinesCount, 0u);
+}
+
+static void allocateThroughCurrentAllocator()
+{
+   CflatFree(CflatMalloc(16u));
+}
+
+TEST(Debugging, AllocationTracking)
+{
+   Cflat::Environment env;
+
+   CflatRegisterFunctionVoid(&env, void, allocateThroughCurrentAllocator);
+
+   const char* code =
+      "int add(int pA, int pB)\n"
+      "{\n"
+      "  return pA + pB;\n"
+      "}\n"
+      "int steady(int pValue)\n"
+      "{\n"
+      "  int local = add(pValue, 2);\n"
+      "  return local + 1;\n"
+      "}\n"
+      "void allocating()\n"
+      "{\n"
+      "  allocateThroughCurrentAllocator();\n"
+      "}\n";
+
+   EXPECT_TRUE(env.load("test", code));
+
+   Cflat::Function* steadyFunction = env.getFunction("steady");
+   Cflat::Function* allocatingFunction = env.getFunction("allocating");
+
+   env.setAllocationTrackingEnabled(true);
+   EXPECT_TRUE(env.isAllocationTrackingEnabled());
+
+   // the first call grows the execution context
+   const int value = 42;
+   EXPECT_EQ(env.returnFunctionCall<int>(steadyFunction, &value), 45);
+
+   Cflat::Environment::AllocationReport report;
+   env.getAllocationReport(&report);
+   EXPECT_GT(report.mAllocationsCount, 0u);
+
+   env.resetAllocationReport();
+
+   {
+      Cflat::Environment::AllocationFreeScope allocationFreeScope(&env);
+
+      for(int i = 0; i < 10; i++)
+      {
+         EXPECT_EQ(env.returnFunctionCall<int>(steadyFunction, &i), i + 3);
+      }
+
+      EXPECT_EQ(allocationFreeScope.getAllocationsCount(), 0u);
+   }
+
+   env.getAllocationReport(&report);
+   EXPECT_EQ(report.mAllocationsCount, 0u);
+   EXPECT_TRUE(report.mEntries.empty());
+
+   {
+      Cflat::Environment::AllocationFreeScope allocationFreeScope(&env, false);
+
+      for(int i = 0; i < 3; i++)
+      {
+         env.voidFunctionCall(allocatingFunction);
+      }
+
+      EXPECT_EQ(allocationFreeScope.getAllocationsCount(), 3u);
+   }
+
+   env.getAllocationReport(&report);
+   EXPECT_EQ(report.mAllocationsCount, 3u);
+   EXPECT_EQ(report.mBytes, 48u);
+   ASSERT_EQ(report.mEntries.size(), 1u);
+   EXPECT_EQ(report.mEntries[0].mProgramIdentifier, Cflat::Identifier("test"));
+   EXPECT_EQ(report.mEntries[0].mLine, 12u);
+   EXPECT_EQ(report.mEntries[0].mReason, Cflat::Environment::AllocationReason::Other);
+
+   // allocations made by the host outside of script executions are not tracked
+   env.resetAllocationReport();
+
+   {
+      Cflat::Memory::AllocatorScope allocatorScope(env.getAllocator());
+      allocateThroughCurrentAllocator();
+   }
+
+   env.getAllocationReport(&report);
+   EXPECT_EQ(report.mAllocationsCount, 0u);
+
+   env.setAllocationTrackingEnabled(false);
+   env.voidFunctionCall(allocatingFunction);
+
+   env.getAllocationReport(&report);
+   EXPECT_EQ(report.mAllocationsCount, 0u);
+}
+
+TEST(Debugging, ExecutionCounters)
+{
+   Cflat::Environment env;
+
+   struct TestStruct
+   {
+      int var;
+
+      const TestStruct operator+(int pValue) const
+      {
+         TestStruct other = *this;
+         other.var = var + pValue;
+         return other;
+      }
+   };
+
+   {
+      CflatRegisterStruct(&env, TestStruct);
+      CflatStructAddMember(&env, TestStruct, int, var);
+      CflatStructAddMethodReturnParams1(&env, TestStruct, const TestStruct, operator+, int) CflatMethodConst;
+   }
+
+   CflatRegisterFunctionReturnParams1(&env, int, abs, int);
+
+   const char* code =
+      "int counter = 0;\n"
+      "int square(int pValue)\n"
+      "{\n"
+      "  return pValue * pValue;\n"
+      "}\n"
+      "int run()\n"
+      "{\n"
+      "  TestStruct value;\n"
+      "  value.var = 1;\n"
+      "  TestStruct other = value + 2;\n"
+      "  counter += abs(-other.var);\n"
+      "  return square(counter);\n"
+      "}\n";
+
+   EXPECT_TRUE(env.load("test", code));
+
+   Cflat::ExecutionCounters counters;
+   env.getExecutionCounters(&counters);
+   EXPECT_GT(counters.mStatementsCount, 0u);
+
+   env.resetExecutionCounters();
+   env.getExecutionCounters(&counters);
+   EXPECT_EQ(counters.mStatementsCount, 0u);
+   EXPECT_EQ(counters.mExpressionsCount, 0u);
+   EXPECT_EQ(counters.mStackPeakBytes, 0u);
+
+   EXPECT_EQ(env.returnFunctionCall<int>(env.getFunction("run")), 9);
+
+   env.getExecutionCounters(&counters);
+   EXPECT_EQ(counters.mStatementsCount, 8u);
+   EXPECT_GT(counters.mExpressionsCount, counters.mStatementsCount);
+   EXPECT_EQ(counters.mScriptCallsCount, 2u);
+   EXPECT_EQ(counters.mNativeCallsCount, 1u);
+   EXPECT_EQ(counters.mOperatorOverloadCallsCount, 1u);
+   EXPECT_EQ(counters.mNameLookupMissesCount, 2u);
+   EXPECT_GT(counters.mStackPeakBytes, 0u);
+}
+
+TEST(PreprocessorErrors, InvalidMacroArgumentCount)
+{
+   Cflat::Environment env;
+   env.defineMacro("ADD(a, b)", "(a + b)");
+
+   const char* code =
+      "int var = ADD(42);\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Preprocessor Error] 'test' -- Line 1: invalid number of arguments for the 'ADD' macro"), 0);
+}
+
+TEST(CompileErrors, VoidVariable)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "void var;\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 1: invalid type ('void')"), 0);
+}
+
+TEST(CompileErrors, InvalidAssignment)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "void func() {}\n"
+      "int var = func();\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 2: invalid assignment"), 0);
+}
+
+TEST(CompileErrors, InvalidNumericValue)
+{
+  Cflat::Environment env;
+
+  const char* code =
+    "const float var = 0f;\n";
+
+  EXPECT_FALSE(env.load("test", code));
+  EXPECT_EQ(strcmp(env.getErrorMessage(),
+    "[Compile Error] 'test' -- Line 1: invalid numeric value ('0f')"), 0);
+}
+
+TEST(CompileErrors, ConstModificationAssignment)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "const int var = 42;\n"
+      "var = 0;\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 2: cannot modify constant expression"), 0);
+}
+
+TEST(CompileErrors, ConstModificationIncrement)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "const int var = 42;\n"
+      "var++;\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 2: cannot modify constant expression"), 0);
+}
+
+TEST(CompileErrors, ConstModificationDecrement)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "const int var = 42;\n"
+      "var--;\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 2: cannot modify constant expression"), 0);
+}
+
+TEST(CompileErrors, NonConstMethodCallOnConstInstance)
+{
+   Cflat::Environment env;
+
+   registerConstPointerTestClass(&env);
+
+   const char* code =
+      "const ConstPointerTestClass testInstance;\n"
+      "testInstance.incrementVal();\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 2: cannot call a non-const method on a const instance, reference or pointer"), 0);
+}
+
+TEST(CompileErrors, NonConstMethodCallOnConstReference)
+{
+   Cflat::Environment env;
+
+   registerConstPointerTestClass(&env);
+
+   const char* code =
+      "ConstPointerTestClass testInstance;\n"
+      "const ConstPointerTestClass& testInstanceRef = testInstance;\n"
+      "testInstanceRef.incrementVal();\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 3: cannot call a non-const method on a const instance, reference or pointer"), 0);
+}
+
+TEST(CompileErrors, NonConstMethodCallOnConstPointer)
+{
+   Cflat::Environment env;
+
+   registerConstPointerTestClass(&env);
+
+   const char* code =
+      "ConstPointerTestClass testInstance;\n"
+      "const ConstPointerTestClass* testInstancePtr = &testInstance;\n"
+      "testInstancePtr->incrementVal();\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 3: cannot call a non-const method on a const instance, reference or pointer"), 0);
+}
+
+TEST(CompileErrors, NonConstOverloadedOperatorCallOnConstInstance)
+{
+   Cflat::Environment env;
+
+   struct TestStruct
+   {
+      int value;
+
+      TestStruct() : value(0) {}
+
+      bool operator*()
+      {
+         return value > 0;
+      }
+      const TestStruct operator+(int pValue)
+      {
+         TestStruct other = *this;
+         other.value = value + pValue;
+         return other;
+      }
+   };
+
+   {
+      CflatRegisterStruct(&env, TestStruct);
+      CflatStructAddConstructor(&env, TestStruct);
+      CflatStructAddMember(&env, TestStruct, int, value);
+      CflatStructAddMethodReturn(&env, TestStruct, bool, operator*);
+      CflatStructAddMethodReturnParams1(&env, TestStruct, const TestStruct, operator+, int);
+   }
+
+   const char* code =
+      "const TestStruct testStruct;\n"
+      "const bool isValuePositive = *testStruct;\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 2: cannot call a non-const method on a const instance, reference or pointer"), 0);
+
+   code =
+      "const TestStruct testStruct1;\n"
+      "const TestStruct testStruct2 = testStruct1 + 10;\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 2: cannot call a non-const method on a const instance, reference or pointer"), 0);
+}
+
+TEST(CompileErrors, MissingDefaultReturnStatementV1)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "bool func()\n"
+      "{\n"
+      "}\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 1: not all code paths return a value in the 'func' function"), 0);
+}
+
+TEST(CompileErrors, MissingReturnValue)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "bool func()\n"
+      "{\n"
+      "  return;\n"
+      "}\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 3: missing return expression"), 0);
+}
+
+TEST(CompileErrors, IncompatibleReturnExpressionType)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "void* func()\n"
+      "{\n"
+      "  return 42;\n"
+      "}\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 3: incompatible return expression type for the 'func' function"), 0);
+}
+
+TEST(CompileErrors, MissingDefaultReturnStatementV2)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "bool func(int arg)\n"
+      "{\n"
+      "  if(arg == 42)\n"
+      "  {\n"
+      "    return true;\n"
+      "  }\n"
+      "}\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 1: not all code paths return a value in the 'func' function"), 0);
+}
+
+TEST(CompileErrors, MissingDefaultReturnStatementV3)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "bool func(int arg)\n"
+      "{\n"
+      "  if(arg == 42)\n"
+      "  {\n"
+      "  }\n"
+      "  else\n"
+      "  {\n"
+      "    return false;\n"
+      "  }\n"
+      "}\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 1: not all code paths return a value in the 'func' function"), 0);
+}
+
+TEST(CompileErrors, MissingDefaultReturnStatementV4)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "bool func(int arg)\n"
+      "{\n"
+      "  switch(arg)\n"
+      "  {\n"
+      "  case 0:\n"
+      "     return true;\n"
+      "  case 1:\n"
+      "     return true;\n"
+      "  case 2:\n"
+      "     return true;\n"
+      "  }\n"
+      "}\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 1: not all code paths return a value in the 'func' function"), 0);
+}
+
+TEST(CompileErrors, InvalidEscapeSequence)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "const char* str = \"String with the invalid sequence \\a\";\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 1: invalid escape sequence ('a')"), 0);
+}
+
+TEST(CompileErrors, InvalidVariableIdentifier)
+{
+   Cflat::Environment env;
+
+   const char* code = "int 1234 = 0;\n";
+
+   EXPECT_FALSE(env.load("test", code));
+}
+
+TEST(CompileErrors, InvalidFunctionIdentifier)
+{
+   Cflat::Environment env;
+
+   const char* code = "void 1234(){};\n";
+
+   EXPECT_FALSE(env.load("test", code));
+}
+
+TEST(CompileErrors, VariableRedefinition)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "void func()\n"
+      "{\n"
+      "  int var = 0;\n"
+      "  float var = 0.0f;\n"
+      "}\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 4: variable redefinition ('var')"), 0);
+}
+
+TEST(CompileErrors, ParameterVariableRedefinition)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "void func(int var)\n"
+      "{\n"
+      "  int var = 0;\n"
+      "}\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 3: variable redefinition ('var')"), 0);
+}
+
+TEST(CompileErrors, ParameterRedefinition)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "void func(int param, float param)\n"
+      "{\n"
+      "}\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 1: parameter redefinition ('param')"), 0);
+}
+
+TEST(CompileErrors, VoidFunctionReturningValue)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "void func()\n"
+      "{\n"
+      "  return 0;\n"
+      "}\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 3: void function returning a value"), 0);
+}
+
+TEST(CompileErrors, NoImplicitCastFromEnumClassToInteger)
+{
+   Cflat::Environment env;
+
+   enum class TestEnumClass : uint8_t
+   {
+      kValue
+   };
+
+   {
+      CflatRegisterEnumClass(&env, TestEnumClass);
+      CflatEnumAddValue(&env, TestEnumClass, kValue);
+   }
+
+   const char* code =
+      "int var = TestEnumClass::kValue;";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 1: invalid assignment"), 0);
+}
+
+TEST(CompileErrors, NoImplicitCastFromIntegerToEnumClass)
+{
+   Cflat::Environment env;
+
+   enum class TestEnumClass : uint8_t
+   {
+      kValue
+   };
+
+   {
+      CflatRegisterEnumClass(&env, TestEnumClass);
+      CflatEnumAddValue(&env, TestEnumClass, kValue);
+   }
+
+   const char* code =
+      "TestEnumClass var = 0;";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 1: invalid assignment"), 0);
+}
+
+TEST(Cflat, NoImplicitCastFromConstRefToRefInVariableDeclaration)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "struct TestStruct\n"
+      "{\n"
+      "  int member;\n"
+      "};\n"
+      "TestStruct testStruct;\n"
+      "testStruct.member = 42;\n"
+      "const TestStruct& testStructRef = testStruct;\n"
+      "TestStruct& testStructNonConstRef = testStructRef;\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 8: invalid assignment"), 0);
+}
+
+TEST(Cflat, NoImplicitCastFromConstRefToRefInFunctionCall)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "struct TestStruct\n"
+      "{\n"
+      "  int member;\n"
+      "};\n"
+      "void modifyTestStruct(TestStruct& pTestStruct)\n"
+      "{\n"
+      "  pTestStruct.member = 100;\n"
+      "}\n"
+      "TestStruct testStruct;\n"
+      "testStruct.member = 42;\n"
+      "const TestStruct& testStructRef = testStruct;\n"
+      "modifyTestStruct(testStructRef);\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Compile Error] 'test' -- Line 12: undefined function ('modifyTestStruct') or invalid arguments in call"), 0);
+}
+
+TEST(RuntimeErrors, NullPointerAccess)
+{
+   Cflat::Environment env;
+
+   Cflat::Helper::registerStdString(&env);
+
+   const char* code =
+      "std::string* strPtr = nullptr;\n"
+      "strPtr->assign(\"Hello world!\");\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Runtime Error] 'test' -- Line 2: null pointer access ('assign')"), 0);
+}
+
+TEST(RuntimeErrors, InvalidArrayIndexOnAccess)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "int array[] = { 0, 1, 2 };\n"
+      "int arrayIndex = 42;\n"
+      "int var = array[arrayIndex];\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Runtime Error] 'test' -- Line 3: invalid array index (size 3, index 42)"), 0);
+}
+
+TEST(RuntimeErrors, InvalidArrayIndexOnAssignment)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "int array[] = { 0, 1, 2 };\n"
+      "array[42] = 0;\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Runtime Error] 'test' -- Line 2: invalid array index (size 3, index 42)"), 0);
+}
+
+TEST(RuntimeErrors, DivisionByZero)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "int val = 10 / 0;\n";
+
+   EXPECT_FALSE(env.load("test", code));
+   EXPECT_EQ(strcmp(env.getErrorMessage(),
+      "[Runtime Error] 'test' -- Line 1: division by zero"), 0);
+}
+
+TEST(Memory, EnvironmentAllocator)
+{
+   struct AllocatorStats
+   {
+      size_t mAllocations;
+      size_t mReleases;
+   };
+
+   AllocatorStats stats = { 0u, 0u };
+
+   Cflat::Memory::Allocator allocator(
+      [](void* pUserData, size_t pSize) -> void*
+      {
+         static_cast<AllocatorStats*>(pUserData)->mAllocations++;
+         return malloc(pSize);
+      },
+      [](void* pUserData, void* pPtr)
+      {
+         static_cast<AllocatorStats*>(pUserData)->mReleases++;
+         free(pPtr);
+      },
+      &stats);
+
+   {
+      Cflat::Environment env(allocator);
+      EXPECT_EQ(env.getAllocator()->mUserData, &stats);
+
+      const size_t allocationsAfterConstruction = stats.mAllocations;
+      EXPECT_GT(allocationsAfterConstruction, 0u);
+
+      const char* code =
+         "int func(int pValue)\n"
+         "{\n"
+         "  return pValue * 2;\n"
+         "}\n"
+         "int var = func(21);\n";
+
+      EXPECT_TRUE(env.load("test", code));
+      EXPECT_EQ(CflatValueAs(env.getVariable("var"), int), 42);
+      EXPECT_GT(stats.mAllocations, allocationsAfterConstruction);
+
+      // allocations outside of the environment must not go through its allocator
+      const size_t allocationsAfterLoad = stats.mAllocations;
+      CflatFree(CflatMalloc(16u));
+      EXPECT_EQ(stats.mAllocations, allocationsAfterLoad);
+   }
+
+   EXPECT_EQ(stats.mAllocations, stats.mReleases);
+}
+
+TEST(Memory, EnvironmentMemoryStats)
+{
+   Cflat::Environment env;
+
+   Cflat::Environment::MemoryStats statsBeforeLoad;
+   env.getMemoryStats(&statsBeforeLoad);
+   EXPECT_GT(statsBeforeLoad.mHeap.mTotal.mBytes, 0u);
+   EXPECT_GT(statsBeforeLoad.mHeap.mCategories[(size_t)Cflat::Memory::Category::Type].mAllocations, 0u);
+   EXPECT_TRUE(statsBeforeLoad.mPrograms.empty());
+
+   const char* code =
+      "struct TestStruct\n"
+      "{\n"
+      "  int mValue;\n"
+      "};\n"
+      "int func(int pValue)\n"
+      "{\n"
+      "  static int staticVar = 0;\n"
+      "  staticVar += pValue;\n"
+      "  return staticVar;\n"
+      "}\n"
+      "const char* str = \"literal\";\n"
+      "int var = func(42);\n";
+
+   EXPECT_TRUE(env.load("test", code));
+
+   Cflat::Environment::MemoryStats stats;
+   env.getMemoryStats(&stats);
+
+   EXPECT_GT(stats.mHeap.mTotal.mBytes, statsBeforeLoad.mHeap.mTotal.mBytes);
+   EXPECT_GE(stats.mHeap.mPeakBytes, stats.mHeap.mTotal.mBytes);
+   EXPECT_EQ(stats.mTypesCount, statsBeforeLoad.mTypesCount + 1u);
+   EXPECT_EQ(stats.mFunctionsCount, statsBeforeLoad.mFunctionsCount + 1u);
+   EXPECT_GT(stats.mLiteralStringsPoolBytes, statsBeforeLoad.mLiteralStringsPoolBytes);
+   EXPECT_GE(stats.mGlobalValues.mAllocations, 2u);
+   EXPECT_EQ(stats.mLocalStaticValues.mAllocations, 1u);
+   EXPECT_EQ(stats.mLocalStaticValues.mBytes, sizeof(int));
+   EXPECT_GT(stats.mStackPeakBytes, 0u);
+
+   ASSERT_EQ(stats.mPrograms.size(), 1u);
+   EXPECT_GT(stats.mPrograms[0].mUsage.mAllocations, 0u);
+   EXPECT_LE(stats.mPrograms[0].mUsage.mBytes,
+      stats.mHeap.mCategories[(size_t)Cflat::Memory::Category::Program].mBytes);
+
+   // reloading the program releases the previous syntax tree
+   EXPECT_TRUE(env.load("test", code));
+
+   Cflat::Environment::MemoryStats statsAfterReload;
+   env.getMemoryStats(&statsAfterReload);
+   EXPECT_EQ(statsAfterReload.mHeap.mCategories[(size_t)Cflat::Memory::Category::Program].mBytes,
+      stats.mHeap.mCategories[(size_t)Cflat::Memory::Category::Program].mBytes);
+}
+
+TEST(Memory, EnvironmentMemoryStatsFromThreads)
+{
+   Cflat::Environment env;
+
+   Cflat::Environment::MemoryStats statsBefore;
+   env.getMemoryStats(&statsBefore);
+
+   const size_t kThreadsCount = 4u;
+   const size_t kAllocationsPerThread = 1000u;
+   const size_t kAllocationSize = 64u;
+
+   CflatSTLVector(void*) blocks;
+   blocks.resize(kThreadsCount * kAllocationsPerThread);
+
+   std::thread threads[kThreadsCount];
+
+   for(size_t i = 0u; i < kThreadsCount; i++)
+   {
+      threads[i] = std::thread([&env, &blocks, i, kAllocationsPerThread, kAllocationSize]()
+      {
+         Cflat::Memory::AllocatorScope allocatorScope(env.getAllocator());
+
+         for(size_t j = 0u; j < kAllocationsPerThread; j++)
+         {
+            blocks[i * kAllocationsPerThread + j] = CflatMalloc(kAllocationSize);
+         }
+      });
+   }
+
+   for(size_t i = 0u; i < kThreadsCount; i++)
+   {
+      threads[i].join();
+   }
+
+   // allocations made from other threads are accounted as well
+   Cflat::Environment::MemoryStats stats;
+   env.getMemoryStats(&stats);
+   EXPECT_EQ(stats.mHeap.mTotal.mAllocations,
+      statsBefore.mHeap.mTotal.mAllocations + kThreadsCount * kAllocationsPerThread);
+   EXPECT_EQ(stats.mHeap.mTotal.mBytes,
+      statsBefore.mHeap.mTotal.mBytes + kThreadsCount * kAllocationsPerThread * kAllocationSize);
+   EXPECT_GE(stats.mHeap.mPeakBytes, stats.mHeap.mTotal.mBytes);
+
+   for(size_t i = 0u; i < blocks.size(); i++)
+   {
+      CflatFree(blocks[i]);
+   }
+
+   env.getMemoryStats(&stats);
+   EXPECT_EQ(stats.mHeap.mTotal.mBytes, statsBefore.mHeap.mTotal.mBytes);
+}
+
+TEST(Memory, ProgramLoadStats)
+{
+   Cflat::Environment env;
+
+   const char* code1 =
+      "namespace Test\n"
+      "{\n"
+      "  struct TestStruct\n"
+      "  {\n"
+      "    int mValue;\n"
+      "  };\n"
+      "  int add(int pA, int pB)\n"
+      "  {\n"
+      "    return pA + pB;\n"
+      "  }\n"
+      "}\n"
+      "int square(int pValue)\n"
+      "{\n"
+      "  return pValue * pValue;\n"
+      "}\n"
+      "int var = Test::add(square(2), 1);\n";
+   const char* code2 =
+      "int var2 = 42;\n";
+
+   EXPECT_TRUE(env.load("test1", code1));
+   EXPECT_TRUE(env.load("test2", code2));
+
+   const Cflat::ProgramLoadStats& stats1 = env.getProgram("test1")->mLoadStats;
+   EXPECT_GT(stats1.mTokensCount, 50u);
+   EXPECT_GT(stats1.mStatementsCount, 5u);
+   EXPECT_GT(stats1.mExpressionsCount, 5u);
+   EXPECT_EQ(stats1.mFunctionsCount, 2u);
+   EXPECT_EQ(stats1.mTypesCount, 1u);
+   EXPECT_GT(stats1.mAllocated.mAllocations, 0u);
+   EXPECT_GT(stats1.mAllocated.mBytes, 0u);
+   EXPECT_GT(stats1.getTotalTime(), 0u);
+
+   const Cflat::ProgramLoadStats& stats2 = env.getProgram("test2")->mLoadStats;
+   EXPECT_EQ(stats2.mTokensCount, 5u);
+   EXPECT_EQ(stats2.mStatementsCount, 1u);
+   EXPECT_EQ(stats2.mExpressionsCount, 1u);
+   EXPECT_EQ(stats2.mFunctionsCount, 0u);
+   EXPECT_EQ(stats2.mTypesCount, 0u);
+
+   Cflat::Environment::LoadStats loadStats;
+   env.getLoadStats(&loadStats);
+
+   ASSERT_EQ(loadStats.mPrograms.size(), 2u);
+   EXPECT_GE(loadStats.mPrograms[0].mStats.getTotalTime(), loadStats.mPrograms[1].mStats.getTotalTime());
+   EXPECT_EQ(loadStats.mTotal.mTokensCount, stats1.mTokensCount + stats2.mTokensCount);
+   EXPECT_EQ(loadStats.mTotal.mStatementsCount, stats1.mStatementsCount + stats2.mStatementsCount);
+   EXPECT_EQ(loadStats.mTotal.mFunctionsCount, 2u);
+   EXPECT_EQ(loadStats.mTotal.mParseTime, stats1.mParseTime + stats2.mParseTime);
+}
+
+TEST(Cflat, TokenizerSpans)
+{
+   // spans long enough to cross several scanning blocks
+   const CflatSTLString longIdentifier(70u, 'x');
+   const CflatSTLString longWhitespace(40u, ' ');
+
+   const CflatSTLString code =
+      "int returnValue = 0x1F + 1.5e-3f;" + longWhitespace + "\n"
+      "\t\n" + longWhitespace + "const char* str = \"a \\\" b\";\n"
+      "char c = '\\'';\n"
+      "while " + longIdentifier + " return_ voidPtr returnx\n"
+      "wchar_t w = L'x'; doStuff(.5f)->member::value;";
+
+   CflatSTLVector(Cflat::Token) tokens;
+   Cflat::Tokenizer::tokenize(code.c_str(), tokens);
+
+   struct ExpectedToken
+   {
+      Cflat::TokenType mType;
+      const char* mText;
+      uint16_t mLine;
+   };
+   const ExpectedToken expectedTokens[] =
+   {
+      { Cflat::TokenType::Identifier, "int", 1u },
+      { Cflat::TokenType::Identifier, "returnValue", 1u },
+      { Cflat::TokenType::Operator, "=", 1u },
+      { Cflat::TokenType::Number, "0x1F", 1u },
+      { Cflat::TokenType::Operator, "+", 1u },
+      { Cflat::TokenType::Number, "1.5e-3f", 1u },
+      { Cflat::TokenType::Punctuation, ";", 1u },
+      { Cflat::TokenType::Keyword, "const", 3u },
+      { Cflat::TokenType::Identifier, "char", 3u },
+      { Cflat::TokenType::Operator, "*", 3u },
+      { Cflat::TokenType::Identifier, "str", 3u },
+      { Cflat::TokenType::Operator, "=", 3u },
+      { Cflat::TokenType::String, "\"a \\\" b\"", 3u },
+      { Cflat::TokenType::Punctuation, ";", 3u },
+      { Cflat::TokenType::Identifier, "char", 4u },
+      { Cflat::TokenType::Identifier, "c", 4u },
+      { Cflat::TokenType::Operator, "=", 4u },
+      { Cflat::TokenType::Character, "'\\''", 4u },
+      { Cflat::TokenType::Punctuation, ";", 4u },
+      { Cflat::TokenType::Keyword, "while", 5u },
+      { Cflat::TokenType::Identifier, longIdentifier.c_str(), 5u },
+      { Cflat::TokenType::Identifier, "return_", 5u },
+      { Cflat::TokenType::Identifier, "voidPtr", 5u },
+      { Cflat::TokenType::Identifier, "returnx", 5u },
+      { Cflat::TokenType::Identifier, "wchar_t", 6u },
+      { Cflat::TokenType::Identifier, "w", 6u },
+      { Cflat::TokenType::Operator, "=", 6u },
+      { Cflat::TokenType::WideCharacter, "L'x'", 6u },
+      { Cflat::TokenType::Punctuation, ";", 6u },
+      { Cflat::TokenType::Identifier, "doStuff", 6u },
+      { Cflat::TokenType::Punctuation, "(", 6u },
+      { Cflat::TokenType::Number, ".5f", 6u },
+      { Cflat::TokenType::Punctuation, ")", 6u },
+      { Cflat::TokenType::Punctuation, "->", 6u },
+      { Cflat::TokenType::Identifier, "member", 6u },
+      { Cflat::TokenType::Punctuation, "::", 6u },
+      { Cflat::TokenType::Identifier, "value", 6u },
+      { Cflat::TokenType::Punctuation, ";", 6u }
+   };
+   const size_t expectedTokensCount = sizeof(expectedTokens) / sizeof(ExpectedToken);
+
+   ASSERT_EQ(tokens.size(), expectedTokensCount);
+
+   for(size_t i = 0u; i < expectedTokensCount; i++)
+   {
+      EXPECT_EQ(tokens[i].mType, expectedTokens[i].mType);
+      EXPECT_EQ((CflatSTLString(tokens[i].mStart, tokens[i].mLength)), expectedTokens[i].mText);
+      EXPECT_EQ(tokens[i].mLine, expectedTokens[i].mLine);
+   }
+}
+
+TEST(Cflat, TokensIndex)
+{
+   // token indices:     0   1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20
+   const char* code = "func ( a , ( b , c ) , {  d  ,  e  }  )  ;  x  =  y  ;";
+
+   CflatSTLVector(Cflat::Token) tokens;
+   Cflat::Tokenizer::tokenize(code, tokens);
+   ASSERT_EQ(tokens.size(), 21u);
+
+   Cflat::TokensIndex tokensIndex;
+   tokensIndex.build(tokens);
+   EXPECT_TRUE(tokensIndex.isBuilt(tokens));
+
+   const size_t lastTokenIndex = tokens.size() - 1u;
+   size_t index = 0u;
+
+   // closures
+   EXPECT_TRUE(tokensIndex.findClosure(1u, '(', ')', lastTokenIndex, &index));
+   EXPECT_EQ(index, 15u);
+   EXPECT_TRUE(tokensIndex.findClosure(5u, '(', ')', lastTokenIndex, &index));
+   EXPECT_EQ(index, 8u);
+   EXPECT_TRUE(tokensIndex.findClosure(11u, '{', '}', lastTokenIndex, &index));
+   EXPECT_EQ(index, 14u);
+   EXPECT_TRUE(tokensIndex.findClosure(1u, '(', ')', 10u, &index));
+   EXPECT_EQ(index, 0u);
+   EXPECT_TRUE(tokensIndex.findClosure(0u, '\0', ';', lastTokenIndex, &index));
+   EXPECT_EQ(index, 16u);
+   EXPECT_TRUE(tokensIndex.findClosure(16u, '\0', ';', lastTokenIndex, &index));
+   EXPECT_EQ(index, 20u);
+
+   // openings
+   EXPECT_TRUE(tokensIndex.findOpening(0u, '(', ')', 15u, &index));
+   EXPECT_EQ(index, 1u);
+   EXPECT_TRUE(tokensIndex.findOpening(0u, '(', ')', 8u, &index));
+   EXPECT_EQ(index, 4u);
+   EXPECT_TRUE(tokensIndex.findOpening(5u, '(', ')', 8u, &index));
+   EXPECT_EQ(index, 8u);
+
+   // separators at the same scope level
+   EXPECT_TRUE(tokensIndex.findSeparation(2u, ',', 15u, &index));
+   EXPECT_EQ(index, 3u);
+   EXPECT_TRUE(tokensIndex.findSeparation(4u, ',', 15u, &index));
+   EXPECT_EQ(index, 9u);
+   EXPECT_TRUE(tokensIndex.findSeparation(9u, ',', 15u, &index));
+   EXPECT_EQ(index, 0u);
+   EXPECT_TRUE(tokensIndex.findSeparation(11u, ',', 14u, &index));
+   EXPECT_EQ(index, 12u);
+
+   // characters which are not indexed
+   EXPECT_FALSE(tokensIndex.findSeparation(0u, '.', lastTokenIndex, &index));
+}
+
+TEST(Cflat, ProgramCache)
+{
+   const char* code =
+      "namespace Test\n"
+      "{\n"
+      "  static const int kFactor = 3;\n"
+      "  int multiply(int pValue) { return pValue * kFactor; }\n"
+      "}\n"
+      "const char* label = \"cached\";\n"
+      "ConstPointerTestClass object;\n"
+      "int computeValue()\n"
+      "{\n"
+      "  int result = 0;\n"
+      "  for(int i = 0; i < 4; i++) { result += Test::multiply(i); }\n"
+      "  object.incrementVal();\n"
+      "  return result + object.getVal();\n"
+      "}\n"
+      "int value = computeValue();\n";
+
+   char cachePath[32];
+   snprintf(cachePath, sizeof(cachePath), "./%08x.cflatc", Cflat::Identifier("cached").mHash);
+   remove(cachePath);
+
+   {
+      Cflat::Environment env;
+      registerConstPointerTestClass(&env);
+      env.setProgramCacheDirectory(".");
+
+      EXPECT_TRUE(env.load("cached", code));
+      EXPECT_FALSE(env.getProgram("cached")->mLoadedFromCache);
+      EXPECT_EQ(CflatValueAs(env.getVariable("value"), int), 19);
+   }
+
+   // same code and bindings: the parsed program gets read from the cache
+   {
+      Cflat::Environment env;
+      registerConstPointerTestClass(&env);
+      env.setProgramCacheDirectory(".");
+
+      EXPECT_TRUE(env.load("cached", code));
+      EXPECT_TRUE(env.getProgram("cached")->mLoadedFromCache);
+      EXPECT_EQ(CflatValueAs(env.getVariable("value"), int), 19);
+      EXPECT_EQ(strcmp(CflatValueAs(env.getVariable("label"), const char*), "cached"), 0);
+
+      Cflat::Function* function = env.getFunction("computeValue");
+      ASSERT_TRUE(function);
+      EXPECT_EQ(env.returnFunctionCall<int>(function), 20);
+   }
+
+   // different bindings: the program gets parsed again
+   {
+      Cflat::Environment env;
+      registerConstPointerTestClass(&env);
+      CflatRegisterFunctionReturnParams1(&env, int, abs, int);
+      env.setProgramCacheDirectory(".");
+
+      EXPECT_TRUE(env.load("cached", code));
+      EXPECT_FALSE(env.getProgram("cached")->mLoadedFromCache);
+      EXPECT_EQ(CflatValueAs(env.getVariable("value"), int), 19);
+   }
+
+   // different code: the program gets parsed again
+   {
+      Cflat::Environment env;
+      registerConstPointerTestClass(&env);
+      env.setProgramCacheDirectory(".");
+
+      std::string modifiedCode(code);
+      modifiedCode.append("int anotherValue = value + 1;\n");
+
+      EXPECT_TRUE(env.load("cached", modifiedCode.c_str()));
+      EXPECT_FALSE(env.getProgram("cached")->mLoadedFromCache);
+      EXPECT_EQ(CflatValueAs(env.getVariable("anotherValue"), int), 20);
+   }
+
+   remove(cachePath);
+}
+
+TEST(Cflat, ProgramCacheWithLocalStatics)
+{
+   const char* code =
+      "int count()\n"
+      "{\n"
+      "  static int calls = 0;\n"
+      "  for(int i = 0; i < 2; i++)\n"
+      "  {\n"
+      "    int calls = 10;\n"
+      "  }\n"
+      "  return ++calls;\n"
+      "}\n"
+      "int value = count() + count();\n";
+
+   char cachePath[32];
+   snprintf(cachePath, sizeof(cachePath), "./%08x.cflatc", Cflat::Identifier("statics").mHash);
+   remove(cachePath);
+
+   for(int i = 0; i < 2; i++)
+   {
+      Cflat::Environment env;
+      env.setProgramCacheDirectory(".");
+
+      EXPECT_TRUE(env.load("statics", code));
+      EXPECT_EQ(env.getProgram("statics")->mLoadedFromCache, i == 1);
+      EXPECT_EQ(CflatValueAs(env.getVariable("value"), int), 1 + 2);
+
+      Cflat::Function* function = env.getFunction("count");
+      ASSERT_TRUE(function);
+      EXPECT_EQ(env.returnFunctionCall<int>(function), 3);
+   }
+
+   remove(cachePath);
+}
+
+TEST(Cflat, ProgramCacheCorrupted)
+{
+   const char* code =
+      "int sum(int pA, int pB) { return pA + pB; }\n"
+      "int values[] = { 1, 2, 3 };\n"
+      "int value = sum(values[0], values[2]);\n";
+
+   char cachePath[32];
+   snprintf(cachePath, sizeof(cachePath), "./%08x.cflatc", Cflat::Identifier("corrupted").mHash);
+   remove(cachePath);
+
+   {
+      Cflat::Environment env;
+      env.setProgramCacheDirectory(".");
+      EXPECT_TRUE(env.load("corrupted", code));
+      EXPECT_FALSE(env.getProgram("corrupted")->mLoadedFromCache);
+   }
+
+   std::vector<char> cache;
+   FILE* file = fopen(cachePath, "rb");
+   ASSERT_TRUE(file);
+   fseek(file, 0, SEEK_END);
+   cache.resize((size_t)ftell(file));
+   rewind(file);
+   ASSERT_EQ(fread(cache.data(), 1u, cache.size(), file), cache.size());
+   fclose(file);
+
+   // truncated file, and a bit flipped in every byte of the payload in turn
+   const size_t corruptionsCount = cache.size() - 16u;
+
+   for(size_t i = 0u; i <= corruptionsCount; i++)
+   {
+      std::vector<char> corruptedCache(cache);
+
+      if(i == corruptionsCount)
+      {
+         corruptedCache.resize(cache.size() / 2u);
+      }
+      else
+      {
+         corruptedCache[16u + i] ^= 0x10;
+      }
+
+      file = fopen(cachePath, "wb");
+      ASSERT_TRUE(file);
+      fwrite(corruptedCache.data(), 1u, corruptedCache.size(), file);
+      fclose(file);
+
+      Cflat::Environment env;
+      env.setProgramCacheDirectory(".");
+      EXPECT_TRUE(env.load("corrupted", code));
+      EXPECT_FALSE(env.getProgram("corrupted")->mLoadedFromCache);
+      EXPECT_EQ(CflatValueAs(env.getVariable("value"), int), 4);
+   }
+
+   remove(cachePath);
+}
+
+TEST(Benchmark, DISABLED_ParallelInvokeScaling)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "struct Weight\n"
+      "{\n"
+      "  float value;\n"
+      "};\n"
+      "static float weight(int pValue)\n"
+      "{\n"
+      "  Weight result;\n"
+      "  result.value = pValue % 7;\n"
+      "  return result.value * 0.5f;\n"
+      "}\n"
+      "float score(int pCandidate)\n"
+      "{\n"
+      "  float result = 0.0f;\n"
+      "  for(int i = 0; i < 32; i++)\n"
+      "  {\n"
+      "    result += weight(pCandidate + i);\n"
+      "  }\n"
+      "  return result;\n"
+      "}\n";
+
+   EXPECT_TRUE(env.load("test", code));
+
+   Cflat::Function* function = env.getFunction("score");
+   ASSERT_TRUE(function);
+
+   const size_t kCandidatesCount = 50000u;
+
+   CflatSTLVector(int) candidates(kCandidatesCount);
+   CflatSTLVector(const void*) args(kCandidatesCount);
+   CflatSTLVector(float) scores(kCandidatesCount);
+
+   for(size_t i = 0u; i < kCandidatesCount; i++)
+   {
+      candidates[i] = (int)i;
+      args[i] = &candidates[i];
+   }
+
+   const size_t threadsCounts[] = { 1u, 2u, 4u, 8u, 16u };
+   double singleThreadSeconds = 0.0;
+
+   for(size_t i = 0u; i < sizeof(threadsCounts) / sizeof(size_t); i++)
+   {
+      const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      EXPECT_TRUE(env.parallelInvoke(function, args.data(), kCandidatesCount, scores.data(),
+         threadsCounts[i]));
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+      if(i == 0u)
+      {
+         singleThreadSeconds = elapsed.count();
+      }
+
+      printf("[ParallelInvoke] %2d thread(s): %8.2f ms (x%.2f)\n", (int)threadsCounts[i],
+         elapsed.count() * 1000.0, singleThreadSeconds / elapsed.count());
+   }
+}
+
+TEST(Benchmark, DISABLED_TokenizerThroughput)
+{
+   const char* chunk =
+      "static float computeWeight(const Vector3& pPosition, int pIterations)\n"
+      "{\n"
+      "   float result = 0.0f;\n"
+      "   for(int i = 0; i < pIterations; i++)\n"
+      "   {\n"
+      "      result += pPosition.x * 0.5f + (float)(i % 7) - 1.25e-2f;\n"
+      "   }\n"
+      "   const char* label = \"weight \\\"computed\\\"\";\n"
+      "   return result;\n"
+      "}\n";
+
+   CflatSTLString code;
+
+   while(code.size() < 4u * 1024u * 1024u)
+   {
+      code.append(chunk);
+   }
+
+   CflatSTLVector(Cflat::Token) tokens;
+   tokens.reserve(code.size() / 2u);
+
+   const int kIterations = 10;
+   const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+   for(int i = 0; i < kIterations; i++)
+   {
+      Cflat::Tokenizer::tokenize(code.c_str(), tokens);
+   }
+
+   const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+   const double tokensPerSecond = (double)tokens.size() * kIterations / elapsed.count();
+   const double megabytesPerSecond =
+      (double)code.size() * kIterations / elapsed.count() / (1024.0 * 1024.0);
+
+   printf("[Tokenizer] %d tokens: %.2f Mtokens/s, %.2f MB/s\n", (int)tokens.size(),
+      tokensPerSecond / 1000000.0, megabytesPerSecond);
+}
+
+TEST(Benchmark, DISABLED_ParseLargeScript)
+{
+   // long initializer lists followed by many nested expressions
+   std::string code;
+
+   for(int i = 0; i < 8; i++)
+   {
+      code.append("int values" + std::to_string(i) + "[] = { 0");
+
+      for(int j = 1; j < 500; j++)
+      {
+         code.append(", " + std::to_string(j));
+      }
+
+      code.append(" };\n");
+   }
+
+   for(int i = 0; i < 4000; i++)
+   {
+      const std::string index = std::to_string(i);
+      code.append("int var" + index + " = ((" + index + " + 1) * (values" + std::to_string(i % 8) +
+         "[" + std::to_string(i % 500) + "] + 2)) - (" + index + " % 3);\n");
+   }
+
+   CflatSTLVector(Cflat::Token) tokens;
+   Cflat::Tokenizer::tokenize(code.c_str(), tokens);
+
+   Cflat::Environment env;
+
+   const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+   EXPECT_TRUE(env.load("test", code.c_str()));
+   const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+   printf("[Parse] %d tokens: %.2f ms\n", (int)tokens.size(), elapsed.count() * 1000.0);
+}
+
+TEST(Benchmark, DISABLED_ProgramCacheLoad)
+{
+   std::string code;
+
+   for(int i = 0; i < 2000; i++)
+   {
+      const std::string index = std::to_string(i);
+      code.append("int function" + index + "(int pValue)\n{\n");
+      code.append("  int result = pValue;\n");
+      code.append("  for(int i = 0; i < " + index + "; i++) { result += (i * 3) % 7; }\n");
+      code.append("  return result > 100 ? result - " + index + " : result + 1;\n}\n");
+   }
+
+   char cachePath[32];
+   snprintf(cachePath, sizeof(cachePath), "./%08x.cflatc", Cflat::Identifier("cached").mHash);
+   remove(cachePath);
+
+   const char* labels[] = { "Parse", "Cached" };
+
+   for(int i = 0; i < 2; i++)
+   {
+      Cflat::Environment env;
+      env.setProgramCacheDirectory(".");
+
+      const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      EXPECT_TRUE(env.load("cached", code.c_str()));
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+      EXPECT_EQ(env.getProgram("cached")->mLoadedFromCache, i == 1);
+      printf("[ProgramCache] %s: %.2f ms\n", labels[i], elapsed.count() * 1000.0);
+   }
+
+   remove(cachePath);
+}
+
+TEST(Benchmark, DISABLED_IncrementalReload)
+{
+   std::string code;
+
+   for(int i = 0; i < 2000; i++)
+   {
+      const std::string index = std::to_string(i);
+      code.append("int function" + index + "(int pValue)\n{\n");
+      code.append("  int result = pValue;\n");
+      code.append("  for(int i = 0; i < " + index + "; i++) { result += (i * 3) % 7; }\n");
+      code.append("  return result > 100 ? result - " + index + " : result + 1;\n}\n");
+   }
+
+   std::string modifiedCode = code;
+   const size_t modifiedBodyIndex = modifiedCode.find("return result > 100 ? result - 1000");
+   modifiedCode.replace(modifiedBodyIndex, 6u, "result += 1; return");
+
+   const char* labels[] = { "Full", "Incremental" };
+
+   for(int i = 0; i < 2; i++)
+   {
+      Cflat::Environment env;
+
+      if(i == 1)
+      {
+         env.addSetting(Cflat::Environment::Settings::IncrementalReload);
+      }
+
+      EXPECT_TRUE(env.load("reloaded", code.c_str()));
+
+      const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      EXPECT_TRUE(env.load("reloaded", modifiedCode.c_str()));
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+      EXPECT_TRUE(env.getFunction("function1000") != nullptr);
+      printf("[IncrementalReload] %s: %.2f ms\n", labels[i], elapsed.count() * 1000.0);
+   }
+}
+
+TEST(Benchmark, DISABLED_LazyFunctionBodies)
+{
+   std::string code;
+
+   for(int i = 0; i < 2000; i++)
+   {
+      const std::string index = std::to_string(i);
+      code.append("int function" + index + "(int pValue)\n{\n");
+      code.append("  int result = pValue;\n");
+      code.append("  for(int i = 0; i < " + index + "; i++) { result += (i * 3) % 7; }\n");
+      code.append("  return result > 100 ? result - " + index + " : result + 1;\n}\n");
+   }
+
+   const char* labels[] = { "Eager", "Lazy" };
+
+   for(int i = 0; i < 2; i++)
+   {
+      Cflat::Environment env;
+
+      if(i == 1)
+      {
+         env.addSetting(Cflat::Environment::Settings::LazyFunctionBodies);
+      }
+
+      const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      EXPECT_TRUE(env.load("lazy", code.c_str()));
+      const std::chrono::duration<double> loadElapsed = std::chrono::steady_clock::now() - start;
+
+      // a session which only runs a small part of the code
+      const int value = 42;
+
+      for(int j = 0; j < 2000; j += 100)
+      {
+         const std::string functionName = "function" + std::to_string(j);
+         env.returnFunctionCall<int>(env.getFunction(functionName.c_str()), &value);
+      }
+
+      const std::chrono::duration<double> totalElapsed = std::chrono::steady_clock::now() - start;
+      EXPECT_FALSE(env.getErrorMessage());
+
+      printf("[LazyFunctionBodies] %s: load %.2f ms, load + 20 calls %.2f ms\n",
+         labels[i], loadElapsed.count() * 1000.0, totalElapsed.count() * 1000.0);
+   }
+}
+
+TEST(Benchmark, DISABLED_ManyMacros)
+{
+   Cflat::Environment env;
+
+   // platform and feature toggles, plus some helpers taking arguments
+   for(int i = 0; i < 1000; i++)
+   {
+      char definition[64];
+      char body[64];
+
+      if(i % 4 == 3)
+      {
+         snprintf(definition, sizeof(definition), "FEATURE_MASK_%d(pValue)", i);
+         snprintf(body, sizeof(body), "((pValue) & %d)", i);
+      }
+      else
+      {
+         snprintf(definition, sizeof(definition), "PLATFORM_TOGGLE_%d", i);
+         snprintf(body, sizeof(body), "%d", i % 2);
+      }
+
+      env.defineMacro(definition, body);
+   }
+
+   std::string code;
+
+   for(int i = 0; i < 1000; i++)
+   {
+      const std::string index = std::to_string(i);
+      code.append("int function" + index + "(int pValue)\n{\n");
+      code.append("  int result = pValue + PLATFORM_TOGGLE_" + std::to_string((i * 4) % 1000) + ";\n");
+      code.append("  int accumulated = result * " + index + ";\n");
+      code.append("  for(int counter = 0; counter < " + index + "; counter++) { accumulated += counter; }\n");
+      code.append("  return FEATURE_MASK_" + std::to_string((i * 4 + 3) % 1000) + "(accumulated) + result;\n}\n");
+   }
+
+   const int kIterations = 10;
+   double totalElapsed = 0.0;
+
+   for(int i = 0; i < kIterations; i++)
+   {
+      const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      EXPECT_TRUE(env.load("macros", code.c_str()));
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      totalElapsed += elapsed.count();
+   }
+
+   Cflat::Function* function = env.getFunction("function5");
+   const int value = 1;
+   EXPECT_EQ(env.returnFunctionCall<int>(function, &value), (15 & 23) + 1);
+
+   printf("[ManyMacros] 1000 macros, %d lines: %.2f ms per load\n",
+      (int)std::count(code.begin(), code.end(), '\n'), totalElapsed * 1000.0 / kIterations);
+}
+
+TEST(Benchmark, DISABLED_ExpressionEvaluation)
+{
+   Cflat::Environment env;
+
+   std::string code = "void watched()\n{\n";
+
+   for(int i = 0; i < 100; i++)
+   {
+      code.append("  int local" + std::to_string(i) + " = " + std::to_string(i) + ";\n");
+   }
+
+   // the hook runs right before this statement
+   const uint16_t watchedLine = 103u;
+   code.append("  float target = 1.5f;\n");
+   code.append("  target += 1.0f;\n}\nwatched();\n");
+
+   static struct
+   {
+      uint16_t mLine;
+      double mCompiledElapsed;
+      double mCachedElapsed;
+   } benchmark;
+   benchmark.mLine = watchedLine + 1u;
+
+   const int kEvaluations = 10000;
+
+   env.setExecutionHook([](Cflat::Environment* pEnvironment, const Cflat::CallStack& pCallStack)
+   {
+      if(pCallStack.empty() || pCallStack.back().mLine != benchmark.mLine)
+      {
+         return;
+      }
+
+      Cflat::Value value;
+      char expression[64];
+
+      // different texts every time, so that all of them have to be compiled
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+      for(int i = 0; i < kEvaluations; i++)
+      {
+         snprintf(expression, sizeof(expression), "target * 2.0f + local42 + %d", i);
+         pEnvironment->evaluateExpression(expression, &value);
+      }
+
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      benchmark.mCompiledElapsed = elapsed.count();
+
+      start = std::chrono::steady_clock::now();
+
+      for(int i = 0; i < kEvaluations; i++)
+      {
+         pEnvironment->evaluateExpression("target * 2.0f + local42", &value);
+      }
+
+      elapsed = std::chrono::steady_clock::now() - start;
+      benchmark.mCachedElapsed = elapsed.count();
+
+      EXPECT_FLOAT_EQ(CflatValueAs(&value, float), 45.0f);
+   });
+
+   EXPECT_TRUE(env.load("watch", code.c_str()));
+
+   printf("[ExpressionEvaluation] 100 locals in scope: compiled %.2f us, cached %.2f us per evaluation\n",
+      benchmark.mCompiledElapsed * 1000000.0 / kEvaluations,
+      benchmark.mCachedElapsed * 1000000.0 / kEvaluations);
+}
+
+TEST(Benchmark, DISABLED_Profiling)
+{
+   Cflat::Environment env;
+
+   const char* code =
+      "int add(int pA, int pB)\n"
+      "{\n"
+      "  return pA + pB;\n"
+      "}\n"
+      "int accumulate(int pCount)\n"
+      "{\n"
+      "  int result = 0;\n"
+      "  for(int i = 0; i < pCount; i++) { result = add(result, i); }\n"
+      "  return result;\n"
+      "}\n";
+
+   EXPECT_TRUE(env.load("test", code));
+
+   Cflat::Function* function = env.getFunction("accumulate");
+   const int kCallsCount = 50000;
+
+   const char* labels[] = { "disabled", "enabled" };
+
+   for(int i = 0; i < 2; i++)
+   {
+      env.setProfilingEnabled(i == 1);
+
+      const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      EXPECT_EQ(env.returnFunctionCall<int>(function, &kCallsCount), (kCallsCount - 1) * (kCallsCount / 2));
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+      printf("[Profiling] %s: %d calls in %.2f ms\n", labels[i], kCallsCount, elapsed.count() * 1000.0);
+   }
+
+   env.setProfilingEnabled(false);
+
+   Cflat::Environment::ProfileStats stats;
+   env.getProfileStats(&stats);
+   ASSERT_EQ(stats.mFunctions.size(), 1u);
+   EXPECT_EQ(stats.mFunctions[0].mCallsCount, (uint32_t)kCallsCount);
+}
+
+
+//
+//  Interpreted vs. native
+//
+struct BenchmarkAccumulator
+{
+   int mValue;
+
+   BenchmarkAccumulator() : mValue(0) {}
+   void add(int pValue) { mValue += pValue; }
+   int get() { return mValue; }
+};
+
+// compiles the given code natively in its own namespace, and keeps it as a string for Cflat
+#define CflatDualScript(pName, ...) \
+   namespace pName##Native { __VA_ARGS__ } \
+   static const char* k##pName##Script = #__VA_ARGS__;
+
+CflatDualScript(Fibonacci,
+   int fib(int pN)
+   {
+      if(pN < 2)
+      {
+         return pN;
+      }
+
+      return fib(pN - 1) + fib(pN - 2);
+   }
+   int run(int pN)
+   {
+      return fib(pN);
+   }
+)
+
+CflatDualScript(NestedLoops,
+   int run(int pN)
+   {
+      int result = 0;
+
+      for(int i = 0; i < pN; i++)
+      {
+         for(int j = 0; j < pN; j++)
+         {
+            result += (i * j) % 7;
+         }
+      }
+
+      return result;
+   }
+)
+
+CflatDualScript(StructMath,
+   struct Particle
+   {
+      float mPositionX;
+      float mPositionY;
+      float mVelocityX;
+      float mVelocityY;
+   };
+   void integrate(Particle& pParticle, float pDeltaTime)
+   {
+      pParticle.mVelocityY -= 9.8f * pDeltaTime;
+      pParticle.mPositionX += pParticle.mVelocityX * pDeltaTime;
+      pParticle.mPositionY += pParticle.mVelocityY * pDeltaTime;
+   }
+   int run(int pN)
+   {
+      Particle particle;
+      particle.mPositionX = 0.0f;
+      particle.mPositionY = 0.0f;
+      particle.mVelocityX = 1.0f;
+      particle.mVelocityY = 10.0f;
+
+      for(int i = 0; i < pN; i++)
+      {
+         integrate(particle, 0.01f);
+      }
+
+      return (int)(particle.mPositionX * 100.0f);
+   }
+)
+
+CflatDualScript(MethodCalls,
+   int run(int pN)
+   {
+      BenchmarkAccumulator accumulator;
+
+      for(int i = 0; i < pN; i++)
+      {
+         accumulator.add(i % 10);
+      }
+
+      return accumulator.get();
+   }
+)
+
+CflatDualScript(VectorIteration,
+   int run(std::vector<int>& pValues)
+   {
+      int result = 0;
+
+      for(auto it = pValues.begin(); it != pValues.end(); it++)
+      {
+         result += *it;
+      }
+
+      for(int i = 0; i < (int)pValues.size(); i++)
+      {
+         result -= pValues[i] / 2;
+      }
+
+      return result;
+   }
+)
+
+CflatDualScript(StringBuilding,
+   int run(int pN)
+   {
+      std::string result;
+
+      for(int i = 0; i < pN; i++)
+      {
+         result.append("ab");
+      }
+
+      return (int)result.size();
+   }
+)
+
+CflatDualScript(StateMachine,
+   int run(int pN)
+   {
+      int state = 0;
+      int counter = 0;
+
+      for(int i = 0; i < pN; i++)
+      {
+         switch(state)
+         {
+         case 0:
+            counter += 1;
+            state = 1;
+            break;
+         case 1:
+            counter += 2;
+            state = 2;
+            break;
+         case 2:
+            counter -= 1;
+            state = (counter % 3) == 0 ? 0 : 3;
+            break;
+         case 3:
+            counter += 3;
+            state = 0;
+            break;
+         default:
+            state = 0;
+            break;
+         }
+      }
+
+      return counter;
+   }
+)
+
+static volatile int gBenchmarkSink = 0;
+
+// runs the operation in batches of doubling size until a batch takes long enough to be measured
+template<typename Operation>
+static double measureNanosecondsPerOperation(Operation pOperation)
+{
+   const double kMinBatchSeconds = 0.05;
+
+   for(uint32_t iterations = 1u; ; iterations *= 2u)
+   {
+      const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+      for(uint32_t i = 0u; i < iterations; i++)
+      {
+         gBenchmarkSink = pOperation();
+      }
+
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+      if(elapsed.count() >= kMinBatchSeconds || iterations >= (1u << 30))
+      {
+         return elapsed.count() * 1000000000.0 / iterations;
+      }
+   }
+}
+
+TEST(Benchmark, DISABLED_InterpretedVsNative)
+{
+   std::vector<int> values;
+
+   for(int i = 0; i < 1000; i++)
+   {
+      values.push_back(i);
+   }
+
+   struct Entry
+   {
+      const char* mName;
+      const char* mScript;
+      int (*mNativeRun)(int);
+      int mArgument;
+   };
+   const Entry entries[] =
+   {
+      { "fib", kFibonacciScript, FibonacciNative::run, 15 },
+      { "nested_loops", kNestedLoopsScript, NestedLoopsNative::run, 100 },
+      { "struct_math", kStructMathScript, StructMathNative::run, 1000 },
+      { "method_calls", kMethodCallsScript, MethodCallsNative::run, 1000 },
+      { "vector_iteration", kVectorIterationScript, nullptr, 0 },
+      { "string_building", kStringBuildingScript, StringBuildingNative::run, 1000 },
+      { "state_machine", kStateMachineScript, StateMachineNative::run, 1000 }
+   };
+   const size_t entriesCount = sizeof(entries) / sizeof(Entry);
+
+   printf("{\"benchmarks\":[");
+
+   for(size_t i = 0u; i < entriesCount; i++)
+   {
+      const Entry& entry = entries[i];
+
+      // every script defines its own 'run' function, so each one gets a clean environment
+      Cflat::Environment env;
+
+      Cflat::Helper::registerStdString(&env);
+      CflatRegisterSTLVector(&env, int);
+
+      {
+         CflatRegisterStruct(&env, BenchmarkAccumulator);
+         CflatStructAddConstructor(&env, BenchmarkAccumulator);
+         CflatStructAddMethodVoidParams1(&env, BenchmarkAccumulator, void, add, int);
+         CflatStructAddMethodReturn(&env, BenchmarkAccumulator, int, get);
+      }
+
+      ASSERT_TRUE(env.load(entry.mName, entry.mScript)) << env.getErrorMessage();
+
+      Cflat::Function* function = env.getFunction("run");
+      ASSERT_TRUE(function);
+
+      double interpretedTime = 0.0;
+      double nativeTime = 0.0;
+
+      if(entry.mNativeRun)
+      {
+         const int argument = entry.mArgument;
+         EXPECT_EQ(env.returnFunctionCall<int>(function, &argument), entry.mNativeRun(argument));
+
+         interpretedTime = measureNanosecondsPerOperation([&]()
+         {
+            return env.returnFunctionCall<int>(function, &argument);
+         });
+         nativeTime = measureNanosecondsPerOperation([&]()
+         {
+            // reading the sink keeps the compiler from hoisting the native call out of the loop
+            return entry.mNativeRun(gBenchmarkSink == -1 ? 0 : argument);
+         });
+      }
+      else
+      {
+         EXPECT_EQ(env.returnFunctionCall<int>(function, &values), VectorIterationNative::run(values));
+
+         interpretedTime = measureNanosecondsPerOperation([&]()
+         {
+            return env.returnFunctionCall<int>(function, &values);
+         });
+         nativeTime = measureNanosecondsPerOperation([&]()
+         {
+            return VectorIterationNative::run(values);
+         });
+      }
+
+      printf("%s\n  {\"name\":\"%s\",\"interpreted_ns_per_op\":%.1f,\"native_ns_per_op\":%.1f,\"slowdown\":%.1f}",
+         i > 0u ? "," : "", entry.mName, interpretedTime, nativeTime,
+         nativeTime > 0.0 ? interpretedTime / nativeTime : 0.0);
+   }
+
+   printf("\n]}\n");
 }